@@ -91,7 +91,7 @@ struct TRITONBACKEND_ModelInstance;
 ///   }
 ///
 #define TRITONBACKEND_API_VERSION_MAJOR 1
-#define TRITONBACKEND_API_VERSION_MINOR 10
+#define TRITONBACKEND_API_VERSION_MINOR 22
 
 /// Get the TRITONBACKEND API version supported by Triton. This value
 /// can be compared against the TRITONBACKEND_API_VERSION_MAJOR and
@@ -173,6 +173,51 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_MemoryManagerFree(
     TRITONBACKEND_MemoryManager* manager, void* buffer,
     const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id);
 
+/// Allocate a contiguous block of memory like
+/// TRITONBACKEND_MemoryManagerAllocate, for use on a CUDA stream. If
+/// Triton uses stream-ordered CUDA memory pools and the memory type is
+/// TRITONSERVER_MEMORY_GPU, the allocation is ordered on 'cuda_stream'
+/// and doesn't synchronize the device: the memory may only be used by
+/// work enqueued on 'cuda_stream' after this call, or by work
+/// synchronized with it. Otherwise it is equivalent to
+/// TRITONBACKEND_MemoryManagerAllocate.
+///
+/// \param manager The memory manager.
+/// \param buffer Returns the allocated memory.
+/// \param memory_type The type of memory to allocate.
+/// \param memory_type_id The ID associated with the memory type to
+/// allocate. For GPU memory this indicates the device ID of the GPU
+/// to allocate from.
+/// \param byte_size The size of memory to allocate, in bytes.
+/// \param cuda_stream The cudaStream_t the memory will be used on.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_MemoryManagerAllocateAsync(
+    TRITONBACKEND_MemoryManager* manager, void** buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const uint64_t byte_size, void* cuda_stream);
+
+/// Free a buffer that was previously allocated with
+/// TRITONBACKEND_MemoryManagerAllocate or
+/// TRITONBACKEND_MemoryManagerAllocateAsync, once the work enqueued on
+/// 'cuda_stream' before the call completes. The memory must not be used
+/// by work on other streams that is not synchronized with 'cuda_stream'.
+/// The call must provide the same values for 'memory_type' and
+/// 'memory_type_id' as were used when the buffer was allocated or else
+/// the behavior is undefined.
+///
+/// \param manager The memory manager.
+/// \param buffer The allocated memory buffer to free.
+/// \param memory_type The type of memory of the buffer.
+/// \param memory_type_id The ID associated with the memory type of
+/// the buffer.
+/// \param cuda_stream The cudaStream_t the memory was last used on.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_MemoryManagerFreeAsync(
+    TRITONBACKEND_MemoryManager* manager, void* buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    void* cuda_stream);
+
 ///
 /// TRITONBACKEND_Input
 ///
@@ -312,6 +357,27 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_InputBufferAttributes(
     TRITONBACKEND_Input* input, const uint32_t index, const void** buffer,
     TRITONSERVER_BufferAttributes** buffer_attributes);
 
+/// Get the offsets of the elements of a TRITONSERVER_TYPE_BYTES input
+/// so that the elements can be accessed without walking the length
+/// prefixes. The offsets are computed on the first call, or provided by
+/// the producer of the input with TRITONBACKEND_OutputSetStringOffsets
+/// if the input is the output of another model of an ensemble. The
+/// offsets are into the input data taken as the concatenation of its
+/// buffers, which must be in CPU memory to compute the offsets.
+/// 'offsets' holds 'element_count' + 1 entries: the offset of the
+/// length prefix of each element followed by the byte size of the
+/// data, so that element 'i' is the 'offsets[i + 1] - offsets[i] - 4'
+/// bytes following its length prefix. The returned 'offsets' is owned
+/// by the input and has the lifetime of the input buffers.
+///
+/// \param input The input tensor.
+/// \param offsets Returns the offsets of the elements.
+/// \param element_count Returns the number of elements.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_InputStringOffsets(
+    TRITONBACKEND_Input* input, const uint64_t** offsets,
+    uint64_t* element_count);
+
 ///
 /// TRITONBACKEND_Output
 ///
@@ -341,6 +407,50 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_OutputBuffer(
     const uint64_t buffer_byte_size, TRITONSERVER_MemoryType* memory_type,
     int64_t* memory_type_id);
 
+/// Get the buffers to use to hold the tensor data of several outputs
+/// in one call. The outputs may belong to different responses. The
+/// outputs whose responses share a response allocator that provides a
+/// batch allocation function are allocated with a single callback,
+/// the others are allocated one by one as with
+/// TRITONBACKEND_OutputBuffer. The ownership and lifetime of each
+/// buffer are the same as for TRITONBACKEND_OutputBuffer.
+///
+/// \param outputs The output tensors.
+/// \param output_count The number of output tensors. All the arrays
+/// below hold 'output_count' elements.
+/// \param buffers Returns the pointers to the buffers where the contents
+/// of the output tensors should be placed.
+/// \param buffer_byte_sizes The sizes, in bytes, of the buffers required
+/// by the caller.
+/// \param memory_types Acts as both input and output. On input gives
+/// the buffer memory types preferred by the caller. Returns the actual
+/// memory types of 'buffers'.
+/// \param memory_type_ids Acts as both input and output. On input gives
+/// the buffer memory type ids preferred by the caller. Returns the
+/// actual memory type ids of 'buffers'.
+/// \return a TRITONSERVER_Error indicating success or failure. On
+/// failure the buffers of some outputs may have been allocated, they
+/// are released with their responses.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_OutputBuffers(
+    TRITONBACKEND_Output** outputs, const uint32_t output_count,
+    void** buffers, const uint64_t* buffer_byte_sizes,
+    TRITONSERVER_MemoryType* memory_types, int64_t* memory_type_ids);
+
+/// Provide the offsets of the elements of a TRITONSERVER_TYPE_BYTES
+/// output, in the layout described by TRITONBACKEND_InputStringOffsets,
+/// so that the consumers of the output don't need to compute them. Must
+/// be called after the buffer of the output is obtained, the offsets
+/// are copied.
+///
+/// \param output The output tensor.
+/// \param offsets The offsets of the elements.
+/// \param offset_count The number of offsets, the element count of the
+/// output + 1.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_OutputSetStringOffsets(
+    TRITONBACKEND_Output* output, const uint64_t* offsets,
+    const uint64_t offset_count);
+
 /// Get the buffer attributes associated with the given output buffer. The
 /// returned 'buffer_attributes' is owned by the output and so should not be
 /// modified or freed by the caller. The lifetime of the 'buffer_attributes'
@@ -404,6 +514,17 @@ TRITONBACKEND_RequestCorrelationIdString(
 TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_RequestFlags(
     TRITONBACKEND_Request* request, uint32_t* flags);
 
+/// Get whether the request has been cancelled by the client, see
+/// TRITONSERVER_InferenceRequestCancel. A backend may poll this during a
+/// long execution and stop early, in which case it should still send a
+/// response with an error for the request and release it as usual.
+///
+/// \param request The inference request.
+/// \param is_cancelled Returns true if the request is cancelled.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_RequestIsCancelled(
+    TRITONBACKEND_Request* request, bool* is_cancelled);
+
 /// Get the number of input tensors specified in the request.
 ///
 /// \param request The inference request.
@@ -459,6 +580,79 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_RequestInputByIndex(
     TRITONBACKEND_Request* request, const uint32_t index,
     TRITONBACKEND_Input** input);
 
+/// Get the buffer holding a named input for the whole batch that the
+/// request is executed in. The buffer is available when Triton gathered
+/// the input of all requests passed to TRITONBACKEND_ModelInstanceExecute,
+/// in which case the data of each request follows the data of the
+/// previous request in the order the requests are passed. Triton only
+/// gathers the input if it has the same datatype and shape, excluding the
+/// batch dimension, in all the requests, except that the shape of an input
+/// that allows ragged batches may differ. The batch inputs of the model
+/// configuration are also available by their target name, with the
+/// content the backend would compute for the batch. Batch inputs of kind
+/// BATCH_MAX_ELEMENT_COUNT_AS_SHAPE are not provided. The FP32 inputs listed
+/// in the 'collate_batch_input_conversions' model configuration parameter
+/// are converted to FP16 or BF16 while they are gathered, in which case the
+/// buffer and the offsets are half the size of the FP32 data. An input that
+/// can't be converted on the host, e.g. because it is in GPU memory, is
+/// gathered without conversion, TRITONBACKEND_RequestCollatedInputDatatype
+/// returns the datatype of the buffer. The input of a single request
+/// already in one buffer is not copied, the buffer is then the one of the
+/// request. The buffer is owned by Triton and remains valid until all the
+/// requests of the batch are released.
+///
+/// \param request The inference request.
+/// \param name The name of the input.
+/// \param buffer Returns a pointer to the contiguous batch buffer.
+/// \param buffer_byte_size Returns the size, in bytes, of 'buffer'.
+/// \param memory_type Returns the memory type of 'buffer'.
+/// \param memory_type_id Returns the memory type ID of 'buffer'.
+/// \return a TRITONSERVER_Error indicating success or failure. A
+/// TRITONSERVER_ERROR_UNAVAILABLE error indicates that the input was not
+/// gathered and the backend must gather it from the requests.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_RequestCollatedInput(
+    TRITONBACKEND_Request* request, const char* name, const void** buffer,
+    uint64_t* buffer_byte_size, TRITONSERVER_MemoryType* memory_type,
+    int64_t* memory_type_id);
+
+/// Get the byte offsets of the data of each request in the buffer
+/// returned by TRITONBACKEND_RequestCollatedInput for a named input, which
+/// locate the data of the requests in a ragged batch. There is one offset
+/// per request, in the order the requests are passed to
+/// TRITONBACKEND_ModelInstanceExecute, followed by the byte size of the
+/// buffer. The offsets are owned by Triton and remain valid as long as the
+/// buffer.
+///
+/// \param request The inference request.
+/// \param name The name of the input.
+/// \param offsets Returns the byte offsets.
+/// \param offset_count Returns the number of offsets, which is the number
+/// of requests in the batch plus one.
+/// \return a TRITONSERVER_Error indicating success or failure. A
+/// TRITONSERVER_ERROR_UNAVAILABLE error indicates that the input was not
+/// gathered from the requests, which includes the batch inputs.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestCollatedInputOffsets(
+    TRITONBACKEND_Request* request, const char* name, const uint64_t** offsets,
+    uint32_t* offset_count);
+
+/// Get the datatype of the buffer returned by
+/// TRITONBACKEND_RequestCollatedInput for a named input. It is the datatype
+/// the input is converted to if the input is listed in the
+/// 'collate_batch_input_conversions' model configuration parameter and
+/// the conversion is applied, and the datatype of the input otherwise.
+///
+/// \param request The inference request.
+/// \param name The name of the input.
+/// \param datatype Returns the datatype of the collated buffer.
+/// \return a TRITONSERVER_Error indicating success or failure. A
+/// TRITONSERVER_ERROR_UNAVAILABLE error indicates that the input was not
+/// gathered and the backend must gather it from the requests.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestCollatedInputDatatype(
+    TRITONBACKEND_Request* request, const char* name,
+    TRITONSERVER_DataType* datatype);
+
 /// Get the number of output tensors requested to be returned in the
 /// request.
 ///
@@ -940,6 +1134,86 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelRepository(
     TRITONBACKEND_Model* model, TRITONBACKEND_ArtifactType* artifact_type,
     const char** location);
 
+/// Map a file of the model into memory for reading. The file contents
+/// are served from the page cache instead of being copied into memory
+/// owned by the backend, so the model instances, and other processes
+/// mapping the same file, share a single copy of the file. Mapping a
+/// file that is already mapped returns the same memory. The memory is
+/// read-only and stays valid until TRITONBACKEND_ModelUnmapFile is
+/// called or the model is finalized. An empty file is returned as a
+/// nullptr 'base' with a zero 'byte_size'. Mapping is not supported on
+/// Windows.
+///
+/// \param model The model.
+/// \param path The path of the file. A relative path is relative to
+/// the location returned by TRITONBACKEND_ModelRepository.
+/// \param base Returns the start of the file contents.
+/// \param byte_size Returns the size of the file, in bytes.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelMapFile(
+    TRITONBACKEND_Model* model, const char* path, const void** base,
+    uint64_t* byte_size);
+
+/// Release a file mapping returned by TRITONBACKEND_ModelMapFile. Each
+/// successful TRITONBACKEND_ModelMapFile call should be matched by one
+/// call, the file is unmapped when no other mapping of it is in use.
+///
+/// \param model The model.
+/// \param base The start of the file contents returned by
+/// TRITONBACKEND_ModelMapFile.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelUnmapFile(
+    TRITONBACKEND_Model* model, const void* base);
+
+/// Acquire a read-only buffer of the model that is shared by all the
+/// instances of the model on the same device, such as the weights of the
+/// model, so that the instances don't each hold a copy. The buffer is on
+/// the GPU of a GPU instance and in CPU memory otherwise. The first
+/// instance to acquire a buffer of a given name on a device gets a newly
+/// allocated buffer with 'initialize' set to true. That instance must
+/// fill the buffer and then call TRITONBACKEND_ModelSharedBufferInitialized.
+/// Meanwhile the other instances acquiring the buffer wait, and once it
+/// is initialized they get the same buffer with 'initialize' set to
+/// false. An instance waits at most 10 minutes, and the acquisition
+/// fails with TRITONSERVER_ERROR_UNAVAILABLE if the buffer isn't
+/// initialized by then or if the model is unloaded meanwhile. The
+/// instance holds a reference to the buffer until the instance
+/// is finalized, and the buffer is released once no instance on the
+/// device holds it. Acquiring a buffer the instance already holds
+/// returns the same buffer and reference.
+///
+/// \param instance The model instance acquiring the buffer.
+/// \param name The name of the buffer, unique within the model.
+/// \param byte_size The size of the buffer, in bytes. It must match the
+/// size of the buffer if the buffer already exists.
+/// \param buffer Returns the buffer.
+/// \param memory_type Returns the memory type of the buffer.
+/// \param memory_type_id Returns the memory type id of the buffer.
+/// \param initialize Returns true if the caller must initialize the
+/// buffer.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelSharedBufferAcquire(
+    TRITONBACKEND_ModelInstance* instance, const char* name,
+    const uint64_t byte_size, void** buffer,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id,
+    bool* initialize);
+
+/// Report that the instance that acquired a shared buffer with
+/// 'initialize' set to true finished initializing it. If 'success' is
+/// false the buffer is released, and the instance waiting for the buffer
+/// next gets a new buffer to initialize. A buffer that isn't reported as
+/// initialized when its instance is finalized is treated as failed.
+///
+/// \param instance The model instance that initialized the buffer.
+/// \param name The name of the buffer.
+/// \param success Whether the buffer was initialized successfully.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelSharedBufferInitialized(
+    TRITONBACKEND_ModelInstance* instance, const char* name,
+    const bool success);
+
 /// Get the model configuration. The caller takes ownership of the
 /// message object and must call TRITONSERVER_MessageDelete to release
 /// the object. The configuration is available via this call even
@@ -1030,6 +1304,19 @@ TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelState(
 TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelSetState(
     TRITONBACKEND_Model* model, void* state);
 
+/// Get the memory manager associated with a model. The memory
+/// manager behaves as the memory manager of the backend and in
+/// addition accounts the allocations to the model. The memory usage
+/// of the model is reported in the model statistics and, when
+/// enabled, in the model memory metrics. A buffer must be freed with
+/// the same memory manager that allocated it to be accounted.
+///
+/// \param model The model.
+/// \param manager Returns the memory manager.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error* TRITONBACKEND_ModelMemoryManager(
+    TRITONBACKEND_Model* model, TRITONBACKEND_MemoryManager** manager);
+
 ///
 /// TRITONBACKEND_ModelInstance
 ///
@@ -1142,6 +1429,61 @@ TRITONBACKEND_ModelInstanceSecondaryDeviceProperties(
     TRITONBACKEND_ModelInstance* instance, uint32_t index, const char** kind,
     int64_t* id);
 
+/// Get the CUDA stream that the core selected to execute a batch of
+/// requests with, as a cudaStream_t. The instance has a stream per range
+/// of priority levels, created with decreasing CUDA stream priority, if
+/// the model sets the 'priority_cuda_streams' parameter and it is a GPU
+/// instance of a model that has more than one priority level. The stream
+/// of the highest priority request in the batch is returned, so that the
+/// kernels of latency-critical requests can preempt the kernels of the
+/// lower priority batches on the device. The stream is owned by the
+/// instance and is valid until the instance is finalized.
+///
+/// \param instance The model instance.
+/// \param requests The requests of the batch.
+/// \param request_count The number of requests in the batch.
+/// \param cuda_stream Returns the CUDA stream, nullptr if the instance
+/// doesn't have priority streams, in which case the backend should use
+/// its own stream.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstancePriorityCudaStream(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count, void** cuda_stream);
+
+/// Report that the backend captured a CUDA graph that it replays for
+/// batches with the signature of the given batch of requests, that is
+/// the total batch size and the shapes of the inputs. The dynamic
+/// batcher favours forming batches of the batch sizes that have a
+/// captured graph. A backend may capture its graphs while the instance is
+/// warmed up, see the 'cuda_graph_warmup' model parameter that warms up
+/// each preferred batch size. The allocations made during capture with
+/// TRITONBACKEND_MemoryManagerAllocateAsync on the capture stream are
+/// stream-ordered, and so can be captured, if the server uses a
+/// stream-ordered CUDA memory pool.
+///
+/// \param instance The model instance.
+/// \param requests The requests of the batch.
+/// \param request_count The number of requests in the batch.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceReportCudaGraph(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count);
+
+/// Get whether a CUDA graph was reported for the signature of the given
+/// batch of requests with TRITONBACKEND_ModelInstanceReportCudaGraph.
+///
+/// \param instance The model instance.
+/// \param requests The requests of the batch.
+/// \param request_count The number of requests in the batch.
+/// \param captured Returns true if a graph was reported.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONBACKEND_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceHasCudaGraph(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count, bool* captured);
+
 /// Get the model associated with a model instance.
 ///
 /// \param instance The model instance.
@@ -83,7 +83,7 @@ struct TRITONREPOAGENT_AgentModel;
 ///   }
 ///
 #define TRITONREPOAGENT_API_VERSION_MAJOR 0
-#define TRITONREPOAGENT_API_VERSION_MINOR 1
+#define TRITONREPOAGENT_API_VERSION_MINOR 2
 
 /// Get the TRITONREPOAGENT API version supported by Triton. This
 /// value can be compared against the
@@ -256,6 +256,26 @@ TRITONREPOAGENT_ModelRepositoryUpdate(
     TRITONREPOAGENT_Agent* agent, TRITONREPOAGENT_AgentModel* model,
     const TRITONREPOAGENT_ArtifactType artifact_type, const char* location);
 
+/// Declare whether the result of the TRITONREPOAGENT_ACTION_LOAD
+/// action currently being handled for a model can be reused. The
+/// result must only depend on the agent parameters, the model
+/// configuration and the model files. When cacheable, later loads of
+/// a model with identical parameters, configuration and file
+/// modification times at the same location use the cached location
+/// without informing the agent of any action on that model. Only a
+/// location left unchanged or acquired with
+/// TRITONREPOAGENT_ModelRepositoryLocationAcquire is cached, Triton
+/// keeps an acquired location alive for as long as it is cached.
+///
+/// \param agent The agent.
+/// \param model The model.
+/// \param cacheable Whether the result is cacheable.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONREPOAGENT_DECLSPEC TRITONSERVER_Error*
+TRITONREPOAGENT_ModelSetResultCacheable(
+    TRITONREPOAGENT_Agent* agent, TRITONREPOAGENT_AgentModel* model,
+    const bool cacheable);
+
 /// Get the number of agent parameters defined for a model.
 ///
 /// \param agent The agent.
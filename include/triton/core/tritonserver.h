@@ -91,7 +91,7 @@ struct TRITONSERVER_MetricFamily;
 ///   }
 ///
 #define TRITONSERVER_API_VERSION_MAJOR 1
-#define TRITONSERVER_API_VERSION_MINOR 15
+#define TRITONSERVER_API_VERSION_MINOR 39
 
 /// Get the TRITONBACKEND API version supported by the Triton shared
 /// library. This value can be compared against the
@@ -423,6 +423,47 @@ typedef TRITONSERVER_Error* (
     TRITONSERVER_BufferAttributes* buffer_attributes, void* userp,
     void* buffer_userp);
 
+/// Type for allocation function that allocates the buffers of several
+/// output tensors in one call. The outputs may belong to one or more
+/// responses, 'userp' provides the allocator user data of each output
+/// since the responses may come from different requests. If set, this
+/// function is called instead of TRITONSERVER_ResponseAllocatorAllocFn_t
+/// and TRITONSERVER_ResponseAllocatorBufferAttributesFn_t whenever Triton
+/// or a backend allocates the buffers of multiple outputs at once. Single
+/// output allocations still use TRITONSERVER_ResponseAllocatorAllocFn_t.
+///
+/// \param allocator The allocator that is provided in the call to
+/// TRITONSERVER_InferenceRequestSetResponseCallback.
+/// \param count The number of output tensors to allocate for. All the
+/// arrays below hold 'count' elements.
+/// \param tensor_names The names of the output tensors.
+/// \param byte_sizes The sizes of the buffers to allocate.
+/// \param memory_types Acts as both input and output. On input gives the
+/// type of memory that the caller prefers for each buffer. Returns the
+/// type of memory where each allocation resides.
+/// \param memory_type_ids Acts as both input and output. On input gives
+/// the ID of the memory that the caller prefers for each buffer. Returns
+/// the ID of the memory where each allocation resides.
+/// \param userp The user data pointers that are provided as
+/// 'response_allocator_userp' in the calls to
+/// TRITONSERVER_InferenceRequestSetResponseCallback.
+/// \param buffers Returns the pointers to the allocated memory.
+/// \param buffer_userps Returns the user-specified values to associate
+/// with the buffers, see TRITONSERVER_ResponseAllocatorAllocFn_t.
+/// \param buffer_attributes The buffer attributes associated with each
+/// buffer, the callback must fill them in as
+/// TRITONSERVER_ResponseAllocatorBufferAttributesFn_t would.
+/// \return a TRITONSERVER_Error object if a failure occurs while
+/// attempting the allocations. If an error is returned all other return
+/// values will be ignored and the callback must have released any
+/// buffer it allocated during the call.
+typedef TRITONSERVER_Error* (*TRITONSERVER_ResponseAllocatorBatchAllocFn_t)(
+    TRITONSERVER_ResponseAllocator* allocator, uint32_t count,
+    const char** tensor_names, const size_t* byte_sizes,
+    TRITONSERVER_MemoryType* memory_types, int64_t* memory_type_ids,
+    void** userp, void** buffers, void** buffer_userps,
+    TRITONSERVER_BufferAttributes** buffer_attributes);
+
 /// Type for function that is called to query the allocator's preferred memory
 /// type and memory type ID. As much as possible, the allocator should attempt
 /// to return the same memory_type and memory_type_id values that will be
@@ -541,6 +582,61 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ResponseAllocatorNew(
     TRITONSERVER_ResponseAllocatorReleaseFn_t release_fn,
     TRITONSERVER_ResponseAllocatorStartFn_t start_fn);
 
+/// Create a new response allocator object that allocates the output
+/// buffers from the memory pools of the server instead of requiring
+/// the caller to implement the allocation callbacks. Host buffers are
+/// served from the size-class caches of the pinned memory pool and GPU
+/// buffers from the CUDA memory pool of the requested device, falling
+/// back to host memory if the device pool is exhausted. The server of
+/// the requests using the allocator must remain alive as long as any
+/// response holding one of its buffers. The callbacks of the allocator
+/// must not be replaced.
+///
+/// \param allocator Returns the new response allocator object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorNewPooled(
+    TRITONSERVER_ResponseAllocator** allocator);
+
+/// Create a new response allocator object that allocates the output
+/// buffers inside the shared memory regions registered with
+/// TRITONSERVER_SharedMemoryRegisterSystem and
+/// TRITONSERVER_SharedMemoryRegisterCuda, so that the process that
+/// created a region reads the outputs without a copy. The
+/// 'response_allocator_userp' given to
+/// TRITONSERVER_InferenceRequestSetResponseCallback is the
+/// null-terminated name of the region to allocate the outputs of the
+/// request in, and must remain valid until the responses are deleted.
+/// Allocating for a region that is not registered fails. The outputs of
+/// a request with a null 'response_allocator_userp', or that don't fit
+/// in its region, are allocated as by
+/// TRITONSERVER_ResponseAllocatorNewPooled. The buffer attributes of an
+/// output in a CUDA region carry the CUDA IPC handle of the region. The
+/// callbacks of the allocator must not be replaced.
+///
+/// \param allocator Returns the new response allocator object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorNewSharedMemory(
+    TRITONSERVER_ResponseAllocator** allocator);
+
+/// Get where an output buffer allocated by a response allocator created
+/// with TRITONSERVER_ResponseAllocatorNewSharedMemory is in its shared
+/// memory region.
+///
+/// \param buffer_userp The user-specified value of the output buffer
+/// returned by TRITONSERVER_InferenceResponseOutput.
+/// \param region_name Returns the name of the region. The returned
+/// string is owned by Triton and is valid until the response holding
+/// the buffer is deleted.
+/// \param offset Returns the offset of the buffer, in bytes, from the
+/// start of the region.
+/// \return a TRITONSERVER_ERROR_NOT_FOUND error if the buffer is not in
+/// a shared memory region.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSharedMemoryLocation(
+    void* buffer_userp, const char** region_name, size_t* offset);
+
 /// Set the buffer attributes function for a response allocator object.
 /// The function will be called after alloc_fn to set the buffer attributes
 /// associated with the output buffer.
@@ -574,6 +670,42 @@ TRITONSERVER_ResponseAllocatorSetQueryFunction(
     TRITONSERVER_ResponseAllocator* allocator,
     TRITONSERVER_ResponseAllocatorQueryFn_t query_fn);
 
+/// Set the batch allocation function for a response allocator object.
+/// The function will be called instead of alloc_fn and
+/// buffer_attributes_fn to allocate the buffers of multiple outputs in a
+/// single call, for example when a backend uses
+/// TRITONBACKEND_OutputBuffers. The buffers are released one by one
+/// with release_fn as usual.
+///
+/// The thread-safy requirement for batch_alloc_fn is the same as other
+/// allocator callbacks.
+///
+/// \param allocator The response allocator object.
+/// \param batch_alloc_fn The function to call to allocate the buffers of
+/// multiple outputs.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSetBatchAllocFunction(
+    TRITONSERVER_ResponseAllocator* allocator,
+    TRITONSERVER_ResponseAllocatorBatchAllocFn_t batch_alloc_fn);
+
+/// Set whether a response allocator accepts output buffers that are
+/// borrowed from Triton instead of allocated by the allocator. When
+/// accepted, Triton may return outputs that reference memory it owns,
+/// for example the response cache returns outputs that reference the
+/// cached data directly instead of copying it. The allocation and
+/// release functions are not called for borrowed buffers. A borrowed
+/// buffer is always in CPU memory, must be treated as read-only and
+/// remains valid until the response that holds it is deleted. By
+/// default borrowed buffers are not accepted.
+///
+/// \param allocator The response allocator object.
+/// \param accepted True if borrowed buffers are accepted, false if not.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSetBorrowedBuffersAccepted(
+    TRITONSERVER_ResponseAllocator* allocator, bool accepted);
+
 /// Delete a response allocator.
 ///
 /// \param allocator The response allocator object.
@@ -581,6 +713,49 @@ TRITONSERVER_ResponseAllocatorSetQueryFunction(
 TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ResponseAllocatorDelete(
     TRITONSERVER_ResponseAllocator* allocator);
 
+/// TRITONSERVER_SharedMemory
+///
+/// Registry of the shared memory regions, created by other processes,
+/// that the response allocator created with
+/// TRITONSERVER_ResponseAllocatorNewSharedMemory allocates output
+/// buffers in. The registry is shared by all the servers of the
+/// process. A region is unmapped once it is unregistered and no
+/// response holds a buffer in it.
+///
+
+/// Register a region of a POSIX shared memory object.
+///
+/// \param name The unique name of the region.
+/// \param shm_key The key of the shared memory object, as given to
+/// shm_open.
+/// \param offset The offset of the region in the object, in bytes.
+/// \param byte_size The byte size of the region.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_SharedMemoryRegisterSystem(
+    const char* name, const char* shm_key, size_t offset, size_t byte_size);
+
+/// Register a region of device memory exported by another process with
+/// cudaIpcGetMemHandle.
+///
+/// \param name The unique name of the region.
+/// \param cuda_ipc_handle The cudaIpcMemHandle_t of the region.
+/// \param byte_size The byte size of the region.
+/// \param device_id The device the region is on.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_SharedMemoryRegisterCuda(
+    const char* name, const void* cuda_ipc_handle, size_t byte_size,
+    int64_t device_id);
+
+/// Unregister a shared memory region. New outputs are no longer
+/// allocated in the region, the outputs already allocated in it remain
+/// valid until their responses are deleted.
+///
+/// \param name The name of the region.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_SharedMemoryUnregister(
+    const char* name);
+
 /// TRITONSERVER_Message
 ///
 /// Object representing a Triton Server message.
@@ -707,7 +882,18 @@ typedef enum tritonserver_traceactivity_enum {
   TRITONSERVER_TRACE_REQUEST_END = 6,
   TRITONSERVER_TRACE_TENSOR_QUEUE_INPUT = 7,
   TRITONSERVER_TRACE_TENSOR_BACKEND_INPUT = 8,
-  TRITONSERVER_TRACE_TENSOR_BACKEND_OUTPUT = 9
+  TRITONSERVER_TRACE_TENSOR_BACKEND_OUTPUT = 9,
+  /// The scheduler formed the batch containing the request. The size
+  /// of the batch is available from TRITONSERVER_InferenceTraceBatchSize.
+  TRITONSERVER_TRACE_BATCH_FORMED = 10,
+  /// The batch containing the request is enqueued to the rate limiter.
+  TRITONSERVER_TRACE_RATE_LIMITER_ENQUEUE = 11,
+  /// A model instance is allocated to execute the batch containing the
+  /// request.
+  TRITONSERVER_TRACE_INSTANCE_ALLOCATED = 12,
+  /// The backend thread of the model instance dequeued the batch
+  /// containing the request.
+  TRITONSERVER_TRACE_BACKEND_DEQUEUE = 13
 } TRITONSERVER_InferenceTraceActivity;
 
 /// Get the string representation of a trace activity. The returned
@@ -810,6 +996,35 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceTraceTensorNew(
     TRITONSERVER_InferenceTraceTensorActivityFn_t tensor_activity_fn,
     TRITONSERVER_InferenceTraceReleaseFn_t release_fn, void* trace_userp);
 
+/// Create a new buffered inference trace object. The caller takes
+/// ownership of the TRITONSERVER_InferenceTrace object and must call
+/// TRITONSERVER_InferenceTraceDelete to release the object.
+///
+/// A buffered trace records its timeline activities into a per-thread
+/// ring buffer instead of calling the activity callback on the
+/// inference path. The activity callback is invoked later, in batches,
+/// from a background thread. If the ring buffer is full the activity is
+/// dropped. The release callback is called for both 'trace' and for any
+/// child traces spawned by 'trace', and only after all the recorded
+/// activities of that trace have been reported.
+///
+/// \param trace Returns the new inference trace object.
+/// \param level The tracing level.
+/// \param parent_id The parent trace id for this trace. A value of 0
+/// indicates that there is not parent trace.
+/// \param activity_fn The callback function where activity for the
+/// trace is reported.
+/// \param release_fn The callback function called when all activity
+/// is complete for the trace.
+/// \param trace_userp User-provided pointer that is delivered to
+/// the activity and release callback functions.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceTraceBufferedNew(
+    TRITONSERVER_InferenceTrace** trace, TRITONSERVER_InferenceTraceLevel level,
+    uint64_t parent_id, TRITONSERVER_InferenceTraceActivityFn_t activity_fn,
+    TRITONSERVER_InferenceTraceReleaseFn_t release_fn, void* trace_userp);
+
 /// Delete a trace object.
 ///
 /// \param trace The trace object.
@@ -857,6 +1072,17 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_InferenceTraceModelVersion(
     TRITONSERVER_InferenceTrace* trace, int64_t* model_version);
 
+/// Get the size of the batch formed by the scheduler for the request
+/// associated with a trace. A value of 0 indicates that the request has
+/// not been batched by a scheduler.
+///
+/// \param trace The trace.
+/// \param batch_size Returns the size of the batch containing the
+/// request associated with the trace.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceTraceBatchSize(
+    TRITONSERVER_InferenceTrace* trace, uint64_t* batch_size);
+
 /// TRITONSERVER_InferenceRequest
 ///
 /// Object representing an inference request. The inference request
@@ -930,6 +1156,26 @@ typedef void (*TRITONSERVER_InferenceResponseCompleteFn_t)(
     TRITONSERVER_InferenceResponse* response, const uint32_t flags,
     void* userp);
 
+/// Type for callback function indicating that a batch of inference
+/// responses has completed, see
+/// TRITONSERVER_InferenceRequestSetResponseCoalescing. The callback
+/// function takes ownership of the TRITONSERVER_InferenceResponse
+/// objects in 'responses', which are in the order they were
+/// produced. The 'responses' array itself is owned by Triton and is
+/// only valid during the callback. The 'userp' data is the data
+/// provided as 'batch_response_userp' in the call to
+/// TRITONSERVER_InferenceRequestSetResponseCoalescing.
+///
+/// The flags are the same as for
+/// TRITONSERVER_InferenceResponseCompleteFn_t and apply to the last
+/// response in the batch. When TRITONSERVER_RESPONSE_COMPLETE_FINAL is
+/// set the batch is the last one for the request, 'response_count' may
+/// be 0 if Triton is only indicating that no more responses will be
+/// produced.
+typedef void (*TRITONSERVER_InferenceResponseBatchCompleteFn_t)(
+    TRITONSERVER_InferenceResponse** responses, const uint32_t response_count,
+    const uint32_t flags, void* userp);
+
 /// Create a new inference request object.
 ///
 /// \param inference_request Returns the new request object.
@@ -951,6 +1197,21 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceRequestNew(
 TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceRequestDelete(
     TRITONSERVER_InferenceRequest* inference_request);
 
+/// Reset an inference request object so that it can be used for
+/// another inference with the same model. The request must have been
+/// released by Triton, see TRITONSERVER_InferenceRequestReleaseFn_t.
+/// The inputs, the requested outputs, the release callback and the
+/// response callback are kept, so that only the input data must be
+/// appended again. The data of every input is removed, and the ID, the
+/// flags, the correlation ID, the priority, the timeout and the
+/// parameters are cleared. The response callback must be set again for
+/// the responses to report a new ID of the request.
+///
+/// \param inference_request The request object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceRequestReset(
+    TRITONSERVER_InferenceRequest* inference_request);
+
 /// Get the ID for a request. The returned ID is owned by
 /// 'inference_request' and must not be modified or freed by the
 /// caller.
@@ -1088,6 +1349,37 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
     TRITONSERVER_InferenceRequest* inference_request, uint64_t timeout_us);
 
+/// Cancel an in-flight request. The function may be called from any
+/// thread at any time after the request is passed to
+/// TRITONSERVER_ServerInferAsync and before its release callback is
+/// invoked. Cancellation is best effort: a request that is still
+/// queued in the scheduler is completed with a
+/// TRITONSERVER_ERROR_UNAVAILABLE error, and a request that is already
+/// executing is flagged so that the backend can observe it with
+/// TRITONBACKEND_RequestIsCancelled and stop early. The request may
+/// still complete normally. The flag is cleared when the request is
+/// reused for another inference.
+///
+/// \param inference_request The request object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request);
+
+/// Set a string parameter of a request. Setting a parameter that is
+/// already set replaces its value. The parameters are hints to the
+/// schedulers of the model, for example the sequence batcher routes new
+/// sequences with the same "sequence_affinity" parameter to the same
+/// model instance when possible.
+///
+/// \param inference_request The request object.
+/// \param key The name of the parameter.
+/// \param value The value of the parameter.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetStringParameter(
+    TRITONSERVER_InferenceRequest* inference_request, const char* key,
+    const char* value);
+
 /// Add an input to a request.
 ///
 /// \param inference_request The request object.
@@ -1272,6 +1564,36 @@ TRITONSERVER_InferenceRequestSetResponseCallback(
     TRITONSERVER_InferenceResponseCompleteFn_t response_fn,
     void* response_userp);
 
+/// Deliver the responses produced for an inference request in batches
+/// instead of calling the response callback once per response. This
+/// is intended for decoupled models producing many small responses
+/// per request. A batch is delivered to 'batch_response_fn' when it
+/// holds 'max_response_count' responses, when the final response is
+/// produced, or 'max_delay_us' microseconds after its first response
+/// was produced, whichever comes first. If 'max_delay_us' is 0 a
+/// batch is only delivered once it is full or final. The batches are
+/// delivered in order and never concurrently for a request. Once set,
+/// the response callback set by
+/// TRITONSERVER_InferenceRequestSetResponseCallback is no longer
+/// called for the request, but the response allocator is still used.
+///
+/// \param inference_request The request object.
+/// \param batch_response_fn The function called to deliver a batch of
+/// inference responses for this request.
+/// \param batch_response_userp User-provided pointer that is delivered
+/// to the 'batch_response_fn' callback.
+/// \param max_response_count The maximum number of responses in a
+/// batch, must be at least 1.
+/// \param max_delay_us The maximum time a response is held before its
+/// batch is delivered.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetResponseCoalescing(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_response_fn,
+    void* batch_response_userp, const uint32_t max_response_count,
+    const uint64_t max_delay_us);
+
 /// TRITONSERVER_InferenceResponse
 ///
 /// Object representing an inference response. The inference response
@@ -1425,6 +1747,38 @@ TRITONSERVER_InferenceResponseOutputClassificationLabel(
     TRITONSERVER_InferenceResponse* inference_response, const uint32_t index,
     const size_t class_index, const char** label);
 
+/// Get the top-k classification of an output. For each batch entry of
+/// the output the 'class_count' classes with the highest values are
+/// returned from the highest value, with their labels. The caller does
+/// not own the returned arrays and must not modify or delete them. The
+/// lifetime of the arrays extends until 'inference_response' is
+/// deleted. Only outputs of type TRITONSERVER_TYPE_FP32 or
+/// TRITONSERVER_TYPE_FP16 in CPU memory are supported, otherwise
+/// TRITONSERVER_ERROR_UNSUPPORTED is returned.
+///
+/// \param inference_response The response object.
+/// \param index The index of the output tensor, must be 0 <= index <
+/// count, where 'count' is the value returned by
+/// TRITONSERVER_InferenceResponseOutputCount.
+/// \param class_count The number of classes to return per batch entry.
+/// \param batch_size Returns the number of batch entries of the output,
+/// 1 if the model doesn't support batching.
+/// \param count Returns the number of classes per batch entry, which is
+/// less than 'class_count' if the output has fewer classes.
+/// \param class_indices Returns 'batch_size' * 'count' class indices,
+/// the classes of each batch entry are contiguous.
+/// \param values Returns the output values of the classes, converted to
+/// single precision.
+/// \param labels Returns the labels of the classes, nullptr for the
+/// classes without label.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceResponseOutputClassification(
+    TRITONSERVER_InferenceResponse* inference_response, const uint32_t index,
+    const uint32_t class_count, uint32_t* batch_size, uint32_t* count,
+    const uint32_t** class_indices, const float** values,
+    const char* const** labels);
+
 /// TRITONSERVER_BufferAttributes
 ///
 /// API to create, modify, or retrieve attributes associated with a buffer.
@@ -1542,9 +1896,17 @@ typedef enum tritonserver_modelcontrolmode_enum {
 /// Rate limit modes
 typedef enum tritonserver_ratelimitmode_enum {
   TRITONSERVER_RATE_LIMIT_OFF,
-  TRITONSERVER_RATE_LIMIT_EXEC_COUNT
+  TRITONSERVER_RATE_LIMIT_EXEC_COUNT,
+  TRITONSERVER_RATE_LIMIT_DEADLINE
 } TRITONSERVER_RateLimitMode;
 
+/// Response cache eviction policies
+typedef enum tritonserver_responsecacheevictionpolicy_enum {
+  TRITONSERVER_RESPONSE_CACHE_EVICTION_LRU,
+  TRITONSERVER_RESPONSE_CACHE_EVICTION_TINY_LFU,
+  TRITONSERVER_RESPONSE_CACHE_EVICTION_SIZE_AWARE
+} TRITONSERVER_ResponseCacheEvictionPolicy;
+
 /// Create a new server options object. The caller takes ownership of
 /// the TRITONSERVER_ServerOptions object and must call
 /// TRITONSERVER_ServerOptionsDelete to release the object.
@@ -1641,6 +2003,10 @@ TRITONSERVER_ServerOptionsSetStrictModelConfig(
 ///   TRITONSERVER_RATE_LIMIT_OFF: The rate limiting is turned off and the
 ///   inference gets executed whenever an instance is available.
 ///
+///   TRITONSERVER_RATE_LIMIT_DEADLINE: Same as EXEC_COUNT except that the
+///   execution with the closest request timeout gets to run first, then the
+///   one with the oldest request. The execution count breaks the ties.
+///
 /// \param options The server options object.
 /// \param mode The mode to use for the rate limiting. By default, execution
 /// count is used to determine the priorities.
@@ -1679,6 +2045,36 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetPinnedMemoryPoolByteSize(
     TRITONSERVER_ServerOptions* options, uint64_t size);
 
+/// Set the byte size that the pinned memory pool can grow to in a
+/// server options. Once the pool set by
+/// TRITONSERVER_ServerOptionsSetPinnedMemoryPoolByteSize is exhausted,
+/// additional host memory is registered as pinned in extents until the
+/// pool reaches this size, instead of falling back to non-pinned memory.
+/// Extents that become unused are released. The pool doesn't grow if
+/// 'size' is not larger than the initial pool byte size, which is the
+/// default.
+///
+/// \param options The server options object.
+/// \param size The maximum pinned memory pool byte size.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetPinnedMemoryPoolMaxByteSize(
+    TRITONSERVER_ServerOptions* options, uint64_t size);
+
+/// Set the byte size from which host memory allocations are backed by
+/// transparent huge pages in a server options. This applies to the CPU
+/// buffers allocated by Triton itself and by the backends that use
+/// TRITONBACKEND_MemoryManager, and to the host memory registered when
+/// the pinned memory pool grows. Such allocations are rounded up to whole
+/// huge pages. The default of 0 disables huge page backed allocations.
+///
+/// \param options The server options object.
+/// \param size The huge page allocation threshold, in bytes.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetHostHugePageThreshold(
+    TRITONSERVER_ServerOptions* options, uint64_t size);
+
 /// Set the total CUDA memory byte size that the server can allocate
 /// on given GPU device in a server options. The pinned memory pool
 /// will be shared across Triton itself and the backends that use
@@ -1692,6 +2088,24 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetCudaMemoryPoolByteSize(
     TRITONSERVER_ServerOptions* options, int gpu_device, uint64_t size);
 
+/// Enable or disable stream-ordered CUDA memory pools in a server
+/// options. When enabled, CUDA memory is allocated from a
+/// stream-ordered memory pool (cudaMallocAsync) of each GPU device
+/// instead of a pool reserved upfront. The pool grows on demand, and
+/// the byte size set by TRITONSERVER_ServerOptionsSetCudaMemoryPoolByteSize
+/// is the release threshold: the memory the pool keeps reserved rather
+/// than returning it to the device. Backends can allocate and free
+/// without synchronizing the device with
+/// TRITONBACKEND_MemoryManagerAllocateAsync. Requires CUDA 11.2 or
+/// later. Default is false.
+///
+/// \param options The server options object.
+/// \param stream_ordered True to use stream-ordered memory pools.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetCudaMemoryPoolStreamOrdered(
+    TRITONSERVER_ServerOptions* options, bool stream_ordered);
+
 /// Set the total response cache byte size that the server can allocate in CPU
 /// memory. The response cache will be shared across all inference requests and
 /// across all models.
@@ -1703,6 +2117,91 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetResponseCacheByteSize(
     TRITONSERVER_ServerOptions* options, uint64_t size);
 
+/// Set the number of shards the response cache is split into. Each
+/// shard is locked independently and owns an equal slice of the
+/// response cache byte size, so a cached response must fit within a
+/// single slice. Default is 1.
+///
+/// \param options The server options object.
+/// \param shard_count The number of response cache shards.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheShardCount(
+    TRITONSERVER_ServerOptions* options, uint32_t shard_count);
+
+/// Enable or disable collision-safe mode of the response cache. In
+/// collision-safe mode a second, independent digest of each request is
+/// stored with the cached response and checked on lookup, so that a
+/// collision of the 64-bit cache key is treated as a cache miss.
+/// Default is disabled.
+///
+/// \param options The server options object.
+/// \param enable True to enable collision-safe mode, false to disable.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheCollisionSafe(
+    TRITONSERVER_ServerOptions* options, bool enable);
+
+/// Set the policy used to select the response to evict when the
+/// response cache needs space. Each shard of the response cache runs
+/// its own instance of the policy.
+///
+///   TRITONSERVER_RESPONSE_CACHE_EVICTION_LRU: Evict the least recently
+///   used response.
+///
+///   TRITONSERVER_RESPONSE_CACHE_EVICTION_TINY_LFU: Window TinyLFU. A new
+///   response is only kept over an existing one if its estimated lookup
+///   frequency is higher, so that one-off responses can't flush out
+///   frequently used ones.
+///
+///   TRITONSERVER_RESPONSE_CACHE_EVICTION_SIZE_AWARE: Greedy-Dual-Size-
+///   Frequency. Evict the response with the lowest hit count per byte,
+///   aged by the time since its last hit, so that large responses must be
+///   hit more often than small ones to stay cached.
+///
+/// \param options The server options object.
+/// \param policy The eviction policy. Default is LRU.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheEvictionPolicy(
+    TRITONSERVER_ServerOptions* options,
+    TRITONSERVER_ResponseCacheEvictionPolicy policy);
+
+/// Set the memory that the response cache stores cached responses
+/// in. By default responses are cached in CPU memory. When
+/// TRITONSERVER_MEMORY_GPU is set, cached responses are allocated from
+/// the CUDA memory pool of the given GPU, so the CUDA memory pool byte
+/// size of that GPU must be large enough to hold the response cache
+/// byte size, and a cache hit for a response allocated in GPU memory
+/// is copied within the device. Inputs in GPU memory can be cached
+/// regardless of this setting.
+///
+/// \param options The server options object.
+/// \param memory_type The memory type, TRITONSERVER_MEMORY_CPU or
+/// TRITONSERVER_MEMORY_GPU.
+/// \param memory_type_id The GPU device to store the cache on, ignored
+/// for CPU memory.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheMemoryType(
+    TRITONSERVER_ServerOptions* options, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id);
+
+/// Set the file that the response cache is snapshotted to when the
+/// server shuts down. When the file exists at startup, the cached
+/// responses and their eviction order are restored from it so that a
+/// restarted server doesn't start with an empty cache. A restored
+/// response is only used for requests to the same model name and
+/// version. An unreadable or malformed snapshot is ignored. By default
+/// no snapshot is written.
+///
+/// \param options The server options object.
+/// \param path The path of the snapshot file, empty to disable.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheSnapshotPath(
+    TRITONSERVER_ServerOptions* options, const char* path);
+
 /// Set the minimum support CUDA compute capability in a server
 /// options.
 ///
@@ -1743,6 +2242,57 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetExitTimeout(
     TRITONSERVER_ServerOptions* options, unsigned int timeout);
 
+/// Enable or disable loading models on demand in a server options. A
+/// request for a model that is not loaded, in the model repository,
+/// loads the model and waits for the load to complete. Requires the
+/// TRITONSERVER_MODEL_CONTROL_EXPLICIT model control mode.
+///
+/// \param options The server options object.
+/// \param enable True to load models on demand, false to disable.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelLoadOnDemand(
+    TRITONSERVER_ServerOptions* options, bool enable);
+
+/// Set the time, in seconds, after its last request that a model loaded
+/// on demand is unloaded. The default of 0 doesn't unload idle models.
+///
+/// \param options The server options object.
+/// \param timeout The idle timeout, in seconds.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelIdleUnloadTimeout(
+    TRITONSERVER_ServerOptions* options, unsigned int timeout);
+
+/// Set the GPU memory, in bytes, that the models loaded on demand may
+/// allocate through the backend memory manager. Once a load exceeds the
+/// budget the least recently used models loaded on demand are unloaded.
+/// The default of 0 doesn't limit the GPU memory.
+///
+/// \param options The server options object.
+/// \param byte_size The GPU memory budget, in bytes.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelGpuMemoryBudget(
+    TRITONSERVER_ServerOptions* options, uint64_t byte_size);
+
+/// Capture the arrival of the inference requests to a file, for the
+/// traffic to be replayed against different scheduling configurations.
+/// The model, the shape, datatype and byte size of the inputs, the
+/// priority, timeout and sequence flags of each request are recorded
+/// along with its arrival time, the data of the inputs is not. The
+/// capture is disabled by default.
+///
+/// \param options The server options object.
+/// \param path The file the capture is written to, which is truncated.
+/// \param max_byte_size The size, in bytes, that the capture stops at.
+/// 0 doesn't limit the size of the capture.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetTrafficCapture(
+    TRITONSERVER_ServerOptions* options, const char* path,
+    uint64_t max_byte_size);
+
 /// Set the number of threads used in buffer manager in a server options.
 ///
 /// \param options The server options object.
@@ -1833,6 +2383,23 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetMetricsInterval(
     TRITONSERVER_ServerOptions* options, uint64_t metrics_interval_ms);
 
+/// Enable or disable the per-model histograms of the inference request,
+/// queue and compute durations in a server options. The histograms are
+/// disabled by default. They are only collected if
+/// TRITONSERVER_ServerOptionsSetMetrics is also true.
+///
+/// \param options The server options object.
+/// \param enable True to enable the latency histograms, false to disable.
+/// \param bucket_bounds_us The upper bounds of the histogram buckets, in
+/// microseconds. An additional bucket always holds the larger durations.
+/// \param bucket_count The number of bounds in 'bucket_bounds_us'. If 0 a
+/// default layout from 100 microseconds to 1 second is used.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetMetricsLatencyHistograms(
+    TRITONSERVER_ServerOptions* options, bool enable,
+    const double* bucket_bounds_us, uint64_t bucket_count);
+
 /// Set the directory containing backend shared libraries. This
 /// directory is searched last after the version and model directory
 /// in the model repository when looking for the backend shared
@@ -1846,6 +2413,22 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetBackendDirectory(
     TRITONSERVER_ServerOptions* options, const char* backend_dir);
 
+/// Set a backend to load and initialize when the server starts instead of
+/// when the first model using it is loaded. The preloaded backends are
+/// loaded from the backend directory concurrently with each other and
+/// with the polling of the model repositories, and a model that needs a
+/// backend being preloaded waits for it. A backend that fails to preload
+/// is loaded again by the models using it. This function can be called
+/// multiple times with different backend names to preload multiple
+/// backends.
+///
+/// \param options The server options object.
+/// \param backend_name The name of the backend to preload.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetBackendPreload(
+    TRITONSERVER_ServerOptions* options, const char* backend_name);
+
 /// Set the directory containing repository agent shared libraries. This
 /// directory is searched when looking for the repository agent shared
 /// library for a model. If the backend is named 'ra' the directory
@@ -2077,7 +2660,12 @@ TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerModelMetadata(
 /// and the server will choose a version based on those models' policies.
 /// \param model_version The version of the model.  If -1 then the
 /// server will choose a version based on the model's policy.
-/// \param model_stats Returns the model statistics message.
+/// \param model_stats Returns the model statistics message. In
+/// addition to the inference and batch statistics, the statistics of
+/// each model include a "memory_usage" array reporting, for each
+/// memory type, the current and peak byte size and the number of
+/// allocations made through the model memory manager (see
+/// TRITONBACKEND_ModelMemoryManager).
 /// \return a TRITONSERVER_Error indicating success or failure.
 TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerModelStatistics(
     TRITONSERVER_Server* server, const char* model_name,
@@ -2188,6 +2776,27 @@ TRITONSERVER_ServerUnloadModelAndDependents(
 TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerMetrics(
     TRITONSERVER_Server* server, TRITONSERVER_Metrics** metrics);
 
+/// Get the current metrics for the server, restricted to a subset of
+/// the metric families and of the models. The caller takes ownership of
+/// the metrics object and must call TRITONSERVER_MetricsDelete to
+/// release the object.
+///
+/// \param server The inference server object.
+/// \param family_names The names of the metric families to include, for
+/// example "nv_inference_count". All the families are included if
+/// 'family_count' is 0.
+/// \param family_count The number of names in 'family_names'.
+/// \param model_names The names of the models whose metrics are
+/// included. Metrics not associated with a model are always included.
+/// The metrics of all the models are included if 'model_count' is 0.
+/// \param model_count The number of names in 'model_names'.
+/// \param metrics Returns the metrics.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_DECLSPEC TRITONSERVER_Error* TRITONSERVER_ServerMetricsFiltered(
+    TRITONSERVER_Server* server, const char* const* family_names,
+    const uint32_t family_count, const char* const* model_names,
+    const uint32_t model_count, TRITONSERVER_Metrics** metrics);
+
 /// Perform inference using the meta-data and inputs supplied by the
 /// 'inference_request'. If the function returns success, then the
 /// caller releases ownership of 'inference_request' and must not
@@ -0,0 +1,110 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "admission_controller.h"
+
+#include <algorithm>
+
+namespace triton { namespace core {
+
+namespace {
+
+// Weight of the latest observation in the smoothed statistics.
+constexpr double kSmoothingFactor = 0.5;
+
+// Fraction of the budget removed for the lowest priority level.
+constexpr double kLowestPriorityShedFraction = 0.5;
+
+uint64_t
+Smooth(const uint64_t previous, const double observed)
+{
+  if (previous == 0) {
+    return static_cast<uint64_t>(observed);
+  }
+  return static_cast<uint64_t>(
+      kSmoothingFactor * observed + (1.0 - kSmoothingFactor) * previous);
+}
+
+}  // namespace
+
+AdmissionController::AdmissionController(
+    const uint64_t latency_slo_ns, const uint32_t priority_levels)
+    : latency_slo_ns_(latency_slo_ns), priority_levels_(priority_levels),
+      request_service_ns_(0), execution_ns_(0)
+{
+}
+
+void
+AdmissionController::RecordExecutions(
+    const uint64_t request_count, const uint64_t execution_count,
+    const uint64_t duration_ns, const size_t parallelism)
+{
+  if ((request_count == 0) || (execution_count == 0)) {
+    return;
+  }
+
+  const double service_ns = static_cast<double>(duration_ns) /
+                            (request_count * std::max<size_t>(parallelism, 1));
+  request_service_ns_.store(Smooth(request_service_ns_.load(), service_ns));
+  execution_ns_.store(Smooth(
+      execution_ns_.load(),
+      static_cast<double>(duration_ns) / execution_count));
+}
+
+uint64_t
+AdmissionController::ExpectedLatencyNs(const size_t queued_count) const
+{
+  const uint64_t execution_ns = execution_ns_.load();
+  if (execution_ns == 0) {
+    return 0;
+  }
+  return queued_count * request_service_ns_.load() + execution_ns;
+}
+
+bool
+AdmissionController::Admit(
+    const uint64_t expected_latency_ns, const uint32_t priority,
+    const uint64_t timeout_ns) const
+{
+  uint64_t budget_ns = latency_slo_ns_;
+  if ((timeout_ns != 0) && ((budget_ns == 0) || (timeout_ns < budget_ns))) {
+    budget_ns = timeout_ns;
+  }
+  if ((budget_ns == 0) || (expected_latency_ns == 0)) {
+    return true;
+  }
+
+  // Priority level 1 is the highest priority.
+  double fraction = 1.0;
+  if ((priority_levels_ > 1) && (priority > 1)) {
+    fraction -= kLowestPriorityShedFraction *
+                (std::min(priority, priority_levels_) - 1) /
+                (priority_levels_ - 1);
+  }
+  return expected_latency_ns <= (fraction * budget_ns);
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,85 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace triton { namespace core {
+
+//
+// Admission control of the requests of a model. The controller is given
+// the executions of the model and estimates the latency of a new
+// request from the number of requests ahead of it, so that the request
+// can be rejected on arrival instead of timing out in the queue. A
+// request is rejected if its expected latency exceeds its budget, the
+// smaller of its timeout and the latency SLO of the model. The budget
+// shrinks with the priority level of the request, down to half of it
+// for the lowest priority, so that lower priority requests are shed
+// first as the load increases.
+//
+// RecordExecutions() must not be called concurrently, the other
+// functions are thread-safe.
+//
+class AdmissionController {
+ public:
+  // 'latency_slo_ns' is the target latency of a request, 0 if only the
+  // request timeouts are enforced. 'priority_levels' is the number of
+  // priority levels of the model, 0 if priorities are not supported.
+  AdmissionController(
+      const uint64_t latency_slo_ns, const uint32_t priority_levels);
+
+  // Record 'request_count' requests executed in 'execution_count'
+  // executions that took 'duration_ns' in total, on 'parallelism'
+  // model instances.
+  void RecordExecutions(
+      const uint64_t request_count, const uint64_t execution_count,
+      const uint64_t duration_ns, const size_t parallelism);
+
+  // Return the expected latency of a request arriving with
+  // 'queued_count' requests ahead of it, 0 if it can't be estimated.
+  uint64_t ExpectedLatencyNs(const size_t queued_count) const;
+
+  // Return true if a request of 'priority' with a timeout of
+  // 'timeout_ns', 0 if none, should be admitted given its
+  // 'expected_latency_ns'.
+  bool Admit(
+      const uint64_t expected_latency_ns, const uint32_t priority,
+      const uint64_t timeout_ns) const;
+
+ private:
+  const uint64_t latency_slo_ns_;
+  const uint32_t priority_levels_;
+
+  // Smoothed time, in nanoseconds, the model takes to serve one more
+  // request with all its instances busy, and smoothed latency of an
+  // execution. 0 until executions are recorded.
+  std::atomic<uint64_t> request_service_ns_;
+  std::atomic<uint64_t> execution_ns_;
+};
+
+}}  // namespace triton::core
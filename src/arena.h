@@ -0,0 +1,233 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+namespace triton { namespace core {
+
+//
+// Monotonic arena handing out memory from a buffer provided by the
+// owner, then from heap blocks of growing size once the buffer is used
+// up. Deallocation is a no-op, memory is reclaimed in one shot by
+// Reset() or when the arena is destroyed. Reset() keeps the largest heap
+// block so that an owner reusing the arena stops allocating once it has
+// seen its largest usage.
+//
+// Not thread-safe.
+//
+class MonotonicArena {
+ public:
+  MonotonicArena(void* buffer, size_t byte_size)
+      : buffer_(reinterpret_cast<char*>(buffer)), buffer_byte_size_(byte_size),
+        current_(buffer_), end_(buffer_ + byte_size), blocks_(nullptr),
+        spare_block_(nullptr), next_block_byte_size_(kMinBlockByteSize)
+  {
+  }
+
+  ~MonotonicArena()
+  {
+    FreeBlocks(blocks_);
+    FreeBlocks(spare_block_);
+  }
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  // Return 'byte_size' bytes aligned to 'alignment', which must be a
+  // power of two. Throw std::bad_alloc if the memory can't be allocated.
+  void* Allocate(size_t byte_size, size_t alignment)
+  {
+    void* ptr = TryAllocate(byte_size, alignment);
+    if (ptr == nullptr) {
+      AddBlock(byte_size + alignment);
+      ptr = TryAllocate(byte_size, alignment);
+    }
+    return ptr;
+  }
+
+  // Release everything allocated from the arena.
+  void Reset()
+  {
+    Block* largest = spare_block_;
+    for (Block* block = blocks_; block != nullptr;) {
+      Block* next = block->next_;
+      if ((largest == nullptr) || (block->byte_size_ > largest->byte_size_)) {
+        free(largest);
+        largest = block;
+      } else {
+        free(block);
+      }
+      block = next;
+    }
+    if (largest != nullptr) {
+      largest->next_ = nullptr;
+    }
+    spare_block_ = largest;
+    blocks_ = nullptr;
+    current_ = buffer_;
+    end_ = buffer_ + buffer_byte_size_;
+  }
+
+  // The number of heap blocks currently in use.
+  size_t BlockCount() const
+  {
+    size_t count = 0;
+    for (Block* block = blocks_; block != nullptr; block = block->next_) {
+      ++count;
+    }
+    return count;
+  }
+
+ private:
+  // Header of a heap block, followed by the usable memory.
+  struct Block {
+    Block* next_;
+    size_t byte_size_;
+  };
+
+  static constexpr size_t kMinBlockByteSize = 1024;
+  static constexpr size_t kMaxBlockByteSize = 64 * 1024;
+
+  void* TryAllocate(size_t byte_size, size_t alignment)
+  {
+    const uintptr_t current = reinterpret_cast<uintptr_t>(current_);
+    const uintptr_t aligned = (current + alignment - 1) & ~(alignment - 1);
+    if ((current_ == nullptr) ||
+        (aligned + byte_size > reinterpret_cast<uintptr_t>(end_))) {
+      return nullptr;
+    }
+    current_ = reinterpret_cast<char*>(aligned + byte_size);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void AddBlock(size_t min_byte_size)
+  {
+    Block* block = nullptr;
+    if ((spare_block_ != nullptr) &&
+        (spare_block_->byte_size_ >= min_byte_size)) {
+      block = spare_block_;
+      spare_block_ = nullptr;
+    } else {
+      const size_t byte_size =
+          (min_byte_size > next_block_byte_size_) ? min_byte_size
+                                                  : next_block_byte_size_;
+      block = reinterpret_cast<Block*>(malloc(sizeof(Block) + byte_size));
+      if (block == nullptr) {
+        throw std::bad_alloc();
+      }
+      block->byte_size_ = byte_size;
+      if (next_block_byte_size_ < kMaxBlockByteSize) {
+        next_block_byte_size_ *= 2;
+      }
+    }
+    block->next_ = blocks_;
+    blocks_ = block;
+    current_ = reinterpret_cast<char*>(block + 1);
+    end_ = current_ + block->byte_size_;
+  }
+
+  static void FreeBlocks(Block* block)
+  {
+    while (block != nullptr) {
+      Block* next = block->next_;
+      free(block);
+      block = next;
+    }
+  }
+
+  char* const buffer_;
+  const size_t buffer_byte_size_;
+  char* current_;
+  char* end_;
+  Block* blocks_;
+  Block* spare_block_;
+  size_t next_block_byte_size_;
+};
+
+//
+// MonotonicArena starting from an inline buffer of 'InlineByteSize' bytes,
+// meant to be a member of the object owning the allocations.
+//
+template <size_t InlineByteSize>
+class InlineMonotonicArena : public MonotonicArena {
+ public:
+  InlineMonotonicArena() : MonotonicArena(buffer_, InlineByteSize) {}
+
+ private:
+  alignas(std::max_align_t) char buffer_[InlineByteSize];
+};
+
+//
+// STL allocator allocating from a MonotonicArena, the arena must outlive
+// the containers using it.
+//
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit ArenaAllocator(MonotonicArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.Arena())
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) {}
+
+  MonotonicArena* Arena() const { return arena_; }
+
+ private:
+  MonotonicArena* arena_;
+};
+
+template <typename T, typename U>
+bool
+operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+  return lhs.Arena() == rhs.Arena();
+}
+
+template <typename T, typename U>
+bool
+operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+}}  // namespace triton::core
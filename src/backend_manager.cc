@@ -80,15 +80,22 @@ TritonBackend::Create(
   // object is this TritonBackend object. We must set set shared
   // library path to point to the backend directory in case the
   // backend library attempts to load additional shared libaries.
+  // The library path is only set on Windows where it is process wide,
+  // elsewhere the backends are initialized without holding the shared
+  // library lock so that they may initialize concurrently.
   if (local_backend->backend_init_fn_ != nullptr) {
+#ifdef _WIN32
     std::unique_ptr<SharedLibrary> slib;
     RETURN_IF_ERROR(SharedLibrary::Acquire(&slib));
     RETURN_IF_ERROR(slib->SetLibraryDirectory(local_backend->dir_));
+#endif  // _WIN32
 
     TRITONSERVER_Error* err = local_backend->backend_init_fn_(
         reinterpret_cast<TRITONBACKEND_Backend*>(local_backend.get()));
 
+#ifdef _WIN32
     RETURN_IF_ERROR(slib->ResetLibraryDirectory());
+#endif  // _WIN32
     RETURN_IF_TRITONSERVER_ERROR(err);
   }
 
@@ -282,6 +289,7 @@ TRITONBACKEND_BackendSetState(TRITONBACKEND_Backend* backend, void* state)
 
 static std::weak_ptr<TritonBackendManager> backend_manager_;
 static std::mutex mu_;
+static std::condition_variable cv_;
 
 Status
 TritonBackendManager::Create(std::shared_ptr<TritonBackendManager>* manager)
@@ -306,19 +314,31 @@ TritonBackendManager::CreateBackend(
     const triton::common::BackendCmdlineConfig& backend_cmdline_config,
     std::shared_ptr<TritonBackend>* backend)
 {
-  std::lock_guard<std::mutex> lock(mu_);
+  std::unique_lock<std::mutex> lock(mu_);
 
+  // Different backends are created concurrently, the creations of the
+  // same backend wait for the first one.
+  cv_.wait(lock, [this, &libpath] {
+    return loading_libpaths_.find(libpath) == loading_libpaths_.end();
+  });
   const auto& itr = backend_map_.find(libpath);
   if (itr != backend_map_.end()) {
     *backend = itr->second;
     return Status::Success;
   }
 
-  RETURN_IF_ERROR(TritonBackend::Create(
-      name, dir, libpath, backend_cmdline_config, backend));
-  backend_map_.insert({libpath, *backend});
+  loading_libpaths_.insert(libpath);
+  lock.unlock();
+  Status status = TritonBackend::Create(
+      name, dir, libpath, backend_cmdline_config, backend);
+  lock.lock();
+  loading_libpaths_.erase(libpath);
+  if (status.IsOk()) {
+    backend_map_.insert({libpath, *backend});
+  }
+  cv_.notify_all();
 
-  return Status::Success;
+  return status;
 }
 
 Status
@@ -25,10 +25,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include "constants.h"
 #include "server_message.h"
 #include "status.h"
@@ -154,6 +156,9 @@ class TritonBackendManager {
   DISALLOW_COPY_AND_ASSIGN(TritonBackendManager);
   TritonBackendManager() = default;
   std::unordered_map<std::string, std::shared_ptr<TritonBackend>> backend_map_;
+
+  // The library paths of the backends being created.
+  std::unordered_set<std::string> loading_libpaths_;
 };
 
 }}  // namespace triton::core
@@ -26,6 +26,8 @@
 
 #include "backend_memory_manager.h"
 
+#include "host_memory.h"
+#include "memory_usage.h"
 #include "pinned_memory_manager.h"
 #include "status.h"
 #include "tritonserver_apis.h"
@@ -49,6 +51,32 @@
 
 namespace triton { namespace core {
 
+namespace {
+
+void
+RecordAllocation(
+    TRITONBACKEND_MemoryManager* manager, void* buffer,
+    const TRITONSERVER_MemoryType memory_type, const uint64_t byte_size)
+{
+  TritonMemoryManager* tm = reinterpret_cast<TritonMemoryManager*>(manager);
+  if ((tm != nullptr) && (tm->usage_ != nullptr)) {
+    tm->usage_->RecordAllocation(buffer, memory_type, byte_size);
+  }
+}
+
+// Must be called before the buffer is freed, after that the address
+// may be returned by an allocation that is recorded concurrently.
+void
+RecordFree(TRITONBACKEND_MemoryManager* manager, void* buffer)
+{
+  TritonMemoryManager* tm = reinterpret_cast<TritonMemoryManager*>(manager);
+  if ((tm != nullptr) && (tm->usage_ != nullptr)) {
+    tm->usage_->RecordFree(buffer);
+  }
+}
+
+}  // namespace
+
 extern "C" {
 
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
@@ -94,7 +122,7 @@ TRITONBACKEND_MemoryManagerAllocate(
 #endif  // TRITON_ENABLE_GPU
 
     case TRITONSERVER_MEMORY_CPU: {
-      *buffer = malloc(byte_size);
+      *buffer = HostAlloc(byte_size);
       if (*buffer == nullptr) {
         return TRITONSERVER_ErrorNew(
             TRITONSERVER_ERROR_UNAVAILABLE, "CPU memory allocation failed");
@@ -103,6 +131,7 @@ TRITONBACKEND_MemoryManagerAllocate(
     }
   }
 
+  RecordAllocation(manager, *buffer, memory_type, byte_size);
   return nullptr;  // success
 }
 
@@ -111,6 +140,7 @@ TRITONBACKEND_MemoryManagerFree(
     TRITONBACKEND_MemoryManager* manager, void* buffer,
     const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id)
 {
+  RecordFree(manager, buffer);
   switch (memory_type) {
     case TRITONSERVER_MEMORY_GPU: {
 #ifdef TRITON_ENABLE_GPU
@@ -144,6 +174,67 @@ TRITONBACKEND_MemoryManagerFree(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_MemoryManagerAllocateAsync(
+    TRITONBACKEND_MemoryManager* manager, void** buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const uint64_t byte_size, void* cuda_stream)
+{
+#ifdef TRITON_ENABLE_GPU
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    auto status = CudaMemoryManager::Alloc(
+        buffer, byte_size, memory_type_id,
+        reinterpret_cast<cudaStream_t>(cuda_stream));
+    if (!status.IsOk()) {
+      return TRITONSERVER_ErrorNew(
+          StatusCodeToTritonCode(status.ErrorCode()), status.Message().c_str());
+    }
+    RecordAllocation(manager, *buffer, memory_type, byte_size);
+    return nullptr;  // success
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return TRITONBACKEND_MemoryManagerAllocate(
+      manager, buffer, memory_type, memory_type_id, byte_size);
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_MemoryManagerFreeAsync(
+    TRITONBACKEND_MemoryManager* manager, void* buffer,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    void* cuda_stream)
+{
+#ifdef TRITON_ENABLE_GPU
+  cudaStream_t stream = reinterpret_cast<cudaStream_t>(cuda_stream);
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    RecordFree(manager, buffer);
+    auto status = CudaMemoryManager::Free(buffer, memory_type_id, stream);
+    if (!status.IsOk()) {
+      return TRITONSERVER_ErrorNew(
+          StatusCodeToTritonCode(status.StatusCode()),
+          status.Message().c_str());
+    }
+    return nullptr;  // success
+  }
+
+  // Other memory types are freed right away, wait for the work using
+  // the memory
+  if (stream != nullptr) {
+    auto cuerr = cudaStreamSynchronize(stream);
+    if (cuerr != cudaSuccess) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INTERNAL,
+          (std::string("failed to synchronize stream before freeing memory: ") +
+           cudaGetErrorString(cuerr))
+              .c_str());
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return TRITONBACKEND_MemoryManagerFree(
+      manager, buffer, memory_type, memory_type_id);
+}
+
 }  // extern C
 
 }}  // namespace triton::core
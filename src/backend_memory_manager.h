@@ -25,12 +25,20 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include "memory_usage.h"
+
 namespace triton { namespace core {
 
-// Currently there is just a global memory manager that is used for
-// all backends and which simply forwards requests on to the core
-// memory manager.
+// The memory managers forward requests on to the core memory
+// managers. There is a global memory manager that is used for all
+// backends, and one memory manager per model that also accounts the
+// allocations to the model.
 struct TritonMemoryManager {
+  TritonMemoryManager() : usage_(nullptr) {}
+  explicit TritonMemoryManager(MemoryUsageTracker* usage) : usage_(usage) {}
+
+  // The accounting of the allocations, nullptr if not accounted.
+  MemoryUsageTracker* usage_;
 };
 
 }}  // namespace triton::core
@@ -29,8 +29,12 @@
 #include <vector>
 #include "backend_config.h"
 #include "backend_model_instance.h"
+#include "collated_batch.h"
+#include "constants.h"
 #include "dynamic_batch_scheduler.h"
 #include "filesystem.h"
+#include "metric_model_reporter.h"
+#include "metrics.h"
 #include "model_config_utils.h"
 #include "numa_utils.h"
 #include "sequence_batch_scheduler.h"
@@ -194,6 +198,50 @@ TritonModel::Create(
   return Status::Success;
 }
 
+Status
+TritonModel::PreloadBackend(
+    InferenceServer* server,
+    const triton::common::BackendCmdlineConfigMap& backend_cmdline_config_map,
+    const std::string& backend_name)
+{
+  std::string backend_dir;
+  RETURN_IF_ERROR(BackendConfigurationGlobalBackendsDirectory(
+      backend_cmdline_config_map, &backend_dir));
+
+  std::string specialized_backend_name;
+  RETURN_IF_ERROR(BackendConfigurationSpecializeBackendName(
+      backend_cmdline_config_map, backend_name, &specialized_backend_name));
+
+  std::string backend_libname;
+  RETURN_IF_ERROR(BackendConfigurationBackendLibraryName(
+      specialized_backend_name, &backend_libname));
+
+  // Only the global backend directory is searched as the model specific
+  // directories are not known yet, a model that provides its own backend
+  // library loads it separately.
+  const std::string backend_libdir =
+      JoinPath({backend_dir, specialized_backend_name});
+  const std::string backend_libpath =
+      JoinPath({backend_libdir, backend_libname});
+  bool exists = false;
+  RETURN_IF_ERROR(FileExists(backend_libpath, &exists));
+  if (!exists) {
+    return Status(
+        Status::Code::NOT_FOUND, "unable to find '" + backend_libname +
+                                     "' for backend '" + backend_name +
+                                     "', searched: " + backend_libdir);
+  }
+
+  triton::common::BackendCmdlineConfig config;
+  RETURN_IF_ERROR(
+      ResolveBackendConfigs(backend_cmdline_config_map, backend_name, config));
+  RETURN_IF_ERROR(SetBackendConfigDefaults(config));
+
+  std::shared_ptr<TritonBackend> backend;
+  return server->BackendManager()->CreateBackend(
+      backend_name, backend_libdir, backend_libpath, config, &backend);
+}
+
 Status
 TritonModel::ResolveBackendConfigs(
     const triton::common::BackendCmdlineConfigMap& backend_cmdline_config_map,
@@ -311,6 +359,81 @@ TritonModel::AddInstance(
   return Status::Success;
 }
 
+Status
+TritonModel::AddScaledInstance()
+{
+  std::lock_guard<std::mutex> lk(scaled_instances_mu_);
+  if (scaling_stopped_ || instances_.empty()) {
+    return Status(
+        Status::Code::UNAVAILABLE,
+        "can not add an instance to model '" + Name() + "'");
+  }
+
+  // The first instance belongs to the first group that is not passive
+  const inference::ModelInstanceGroup* group = nullptr;
+  for (const auto& instance_group : Config().instance_group()) {
+    if (!instance_group.passive()) {
+      group = &instance_group;
+      break;
+    }
+  }
+  if (group == nullptr) {
+    return Status(
+        Status::Code::INTERNAL,
+        "model '" + Name() + "' has no instance group to scale");
+  }
+
+  const size_t index = instances_.size() + scaled_instance_count_;
+  std::unique_ptr<TritonModelInstance> instance;
+  RETURN_IF_ERROR(TritonModelInstance::CreateScaledInstance(
+      *instances_.front(),
+      group->name() + "_scaled_" + std::to_string(scaled_instance_count_),
+      index, group->rate_limiter(), &instance));
+  scaled_instance_count_++;
+  LOG_VERBOSE(1) << "Added instance " << instance->Name() << " to model '"
+                 << Name() << "'";
+  scaled_instances_.emplace_back(std::move(instance));
+
+  return Status::Success;
+}
+
+Status
+TritonModel::RemoveScaledInstance(bool* removed)
+{
+  *removed = false;
+  std::lock_guard<std::mutex> lk(scaled_instances_mu_);
+  if (scaling_stopped_ || scaled_instances_.empty()) {
+    return Status::Success;
+  }
+  RETURN_IF_ERROR(server_->GetRateLimiter()->RemoveModelInstance(
+      scaled_instances_.back().get(), removed));
+  if (!*removed) {
+    return Status::Success;
+  }
+  std::unique_ptr<TritonModelInstance> instance =
+      std::move(scaled_instances_.back());
+  scaled_instances_.pop_back();
+
+  // Destroying the instance stops its backend thread once the payloads
+  // already scheduled for it are executed. It is done under the lock so
+  // the model teardown does not unregister from the rate limiter while
+  // the instance is being released.
+  LOG_VERBOSE(1) << "Removing instance " << instance->Name()
+                 << " from model '" << Name() << "'";
+  const TritonModelInstance* raw_instance = instance.get();
+  instance.reset();
+  server_->GetRateLimiter()->ReleaseModelInstance(raw_instance);
+
+  return Status::Success;
+}
+
+size_t
+TritonModel::ScaledInstanceCount()
+{
+  std::lock_guard<std::mutex> lk(scaled_instances_mu_);
+  return scaled_instances_.size();
+}
+
 Status
 TritonModel::UpdateModelConfig(
     const uint32_t config_version, TRITONSERVER_Message* updated_config_message)
@@ -445,14 +568,45 @@ TritonModel::TritonModel(
       server_(server), min_compute_capability_(min_compute_capability),
       auto_complete_config_(auto_complete_config),
       localized_model_dir_(localized_model_dir), backend_(backend),
-      state_(nullptr)
+      scaled_instance_count_(0), scaling_stopped_(false), state_(nullptr),
+      memory_manager_(MutableMemoryUsage()),
+      shared_buffers_(
+          Name(), MutableMemoryUsage(),
+          SHARED_BUFFER_WAIT_TIMEOUT_MILLISECONDS)
 {
+#ifdef TRITON_ENABLE_METRICS
+  if (Metrics::Enabled()) {
+    // The memory usage and the sequence statistics are reported for the
+    // model, not for a device.
+    std::shared_ptr<MetricModelReporter> reporter;
+    MetricModelReporter::Create(
+        Name(), Version(), METRIC_REPORTER_ID_CPU, Config().metric_tags(),
+        &reporter);
+    MutableMemoryUsage()->SetMetricReporter(reporter);
+    MutableSequenceStats()->SetMetricReporter(reporter);
+  }
+#endif  // TRITON_ENABLE_METRICS
 }
 
 TritonModel::~TritonModel()
 {
+  // Stop the scheduler first, it may run threads that call back into the
+  // model, e.g. to scale the instances.
+  if (scheduler_ != nullptr) {
+    scheduler_->Stop();
+  }
+
+  // Instances being scaled up must not wait for shared buffers that are
+  // never initialized
+  shared_buffers_.Stop();
+
   // Explicitly delete/finalize all model instances before finalizing
   // the model itself.
+  {
+    std::lock_guard<std::mutex> lk(scaled_instances_mu_);
+    scaling_stopped_ = true;
+    scaled_instances_.clear();
+  }
   instances_.clear();
   passive_instances_.clear();
 
@@ -461,6 +615,7 @@ TritonModel::~TritonModel()
   // there are no instance threads waiting on rate limiter for
   // receiving their payloads.
   server_->GetRateLimiter()->UnregisterModel(this);
+  TritonModelInstance::ReleaseBackendThreadPool(this);
 
   // Model finalization is optional... The TRITONBACKEND_Model
   // object is this TritonModel object.
@@ -471,6 +626,79 @@ TritonModel::~TritonModel()
   }
 }
 
+Status
+TritonModel::MapFile(
+    const std::string& path, const void** base, uint64_t* byte_size)
+{
+  const std::string full_path =
+      IsAbsolutePath(path) ? path : JoinPath({LocalizedModelPath(), path});
+
+  std::shared_ptr<const MappedFile> file;
+  RETURN_IF_ERROR(triton::core::MapFile(full_path, &file));
+
+  *base = file->Base();
+  *byte_size = file->ByteSize();
+
+  std::lock_guard<std::mutex> lk(mapped_files_mu_);
+  mapped_files_.emplace(file->Base(), std::move(file));
+  return Status::Success;
+}
+
+Status
+TritonModel::UnmapFile(const void* base)
+{
+  std::lock_guard<std::mutex> lk(mapped_files_mu_);
+  auto it = mapped_files_.find(base);
+  if (it == mapped_files_.end()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model '" + Name() + "' has no file mapped at the given address");
+  }
+  mapped_files_.erase(it);
+  return Status::Success;
+}
+
+Status
+TritonModel::AcquireSharedBuffer(
+    const TritonModelInstance* instance, const std::string& name,
+    const uint64_t byte_size, void** buffer,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id,
+    bool* initialize)
+{
+  // GPU instances share the buffers on their GPU, the other instances
+  // share the buffers in CPU memory
+  if (instance->Kind() == TRITONSERVER_INSTANCEGROUPKIND_GPU) {
+    *memory_type = TRITONSERVER_MEMORY_GPU;
+    *memory_type_id = instance->DeviceId();
+  } else {
+    *memory_type = TRITONSERVER_MEMORY_CPU;
+    *memory_type_id = 0;
+  }
+  return shared_buffers_.Acquire(
+      instance, name, *memory_type, *memory_type_id, byte_size, buffer,
+      initialize);
+}
+
+Status
+TritonModel::SetSharedBufferInitialized(
+    const TritonModelInstance* instance, const std::string& name,
+    const bool success)
+{
+  if (instance->Kind() == TRITONSERVER_INSTANCEGROUPKIND_GPU) {
+    return shared_buffers_.SetInitialized(
+        instance, instance->Name(), name, TRITONSERVER_MEMORY_GPU,
+        instance->DeviceId(), success);
+  }
+  return shared_buffers_.SetInitialized(
+      instance, instance->Name(), name, TRITONSERVER_MEMORY_CPU, 0, success);
+}
+
+void
+TritonModel::ReleaseSharedBuffers(const TritonModelInstance* instance)
+{
+  shared_buffers_.Release(instance, instance->Name());
+}
+
 extern "C" {
 
 //
@@ -503,6 +731,48 @@ TRITONBACKEND_ModelRepository(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelMapFile(
+    TRITONBACKEND_Model* model, const char* path, const void** base,
+    uint64_t* byte_size)
+{
+  TritonModel* tm = reinterpret_cast<TritonModel*>(model);
+  RETURN_TRITONSERVER_ERROR_IF_ERROR(tm->MapFile(path, base, byte_size));
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelUnmapFile(TRITONBACKEND_Model* model, const void* base)
+{
+  TritonModel* tm = reinterpret_cast<TritonModel*>(model);
+  RETURN_TRITONSERVER_ERROR_IF_ERROR(tm->UnmapFile(base));
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelSharedBufferAcquire(
+    TRITONBACKEND_ModelInstance* instance, const char* name,
+    const uint64_t byte_size, void** buffer,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id,
+    bool* initialize)
+{
+  TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+  RETURN_TRITONSERVER_ERROR_IF_ERROR(ti->Model()->AcquireSharedBuffer(
+      ti, name, byte_size, buffer, memory_type, memory_type_id, initialize));
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelSharedBufferInitialized(
+    TRITONBACKEND_ModelInstance* instance, const char* name,
+    const bool success)
+{
+  TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+  RETURN_TRITONSERVER_ERROR_IF_ERROR(
+      ti->Model()->SetSharedBufferInitialized(ti, name, success));
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONBACKEND_ModelConfig(
     TRITONBACKEND_Model* model, const uint32_t config_version,
@@ -581,6 +851,16 @@ TRITONBACKEND_ModelSetState(TRITONBACKEND_Model* model, void* state)
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelMemoryManager(
+    TRITONBACKEND_Model* model, TRITONBACKEND_MemoryManager** manager)
+{
+  TritonModel* tm = reinterpret_cast<TritonModel*>(model);
+  *manager =
+      reinterpret_cast<TRITONBACKEND_MemoryManager*>(tm->MemoryManager());
+  return nullptr;  // success
+}
+
 ///
 /// TRITONBACKEND_Request
 ///
@@ -615,6 +895,15 @@ TRITONBACKEND_RequestFlags(TRITONBACKEND_Request* request, uint32_t* flags)
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestIsCancelled(
+    TRITONBACKEND_Request* request, bool* is_cancelled)
+{
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
+  *is_cancelled = tr->IsCancelled();
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONBACKEND_RequestCorrelationIdString(
     TRITONBACKEND_Request* request, const char** id)
@@ -657,19 +946,9 @@ TRITONBACKEND_RequestInputName(
   }
 
   // The request inputs are not allowed to change once the request
-  // makes it to the backend, so it is ok to just iterate through the
-  // map. This linear search is the best we can do given the need for
-  // the inputs to be in a map and given the typical small number of
-  // inputs is better than having every request maintain the inputs as
-  // both map and vector.
-  uint32_t cnt = 0;
-  for (const auto& pr : inputs) {
-    if (cnt++ == index) {
-      InferenceRequest::Input* in = pr.second;
-      *input_name = in->Name().c_str();
-      break;
-    }
-  }
+  // makes it to the backend, and they are stored contiguously so they
+  // can be accessed by index directly.
+  *input_name = inputs[index].input_->Name().c_str();
 
   return nullptr;  // success
 }
@@ -689,7 +968,7 @@ TRITONBACKEND_RequestInput(
         (tr->LogRequest() + "unknown request input name " + name).c_str());
   }
 
-  InferenceRequest::Input* in = itr->second;
+  InferenceRequest::Input* in = itr->input_;
   *input = reinterpret_cast<TRITONBACKEND_Input*>(in);
 
   return nullptr;  // success
@@ -711,20 +990,72 @@ TRITONBACKEND_RequestInputByIndex(
   }
 
   // The request inputs are not allowed to change once the request
-  // makes it to the backend, so it is ok to just iterate through the
-  // map. This linear search is the best we can do given the need for
-  // the inputs to be in a map and given the typical small number of
-  // inputs is better than having every request maintain the inputs as
-  // both map and vector.
-  uint32_t cnt = 0;
-  for (const auto& pr : inputs) {
-    if (cnt++ == index) {
-      InferenceRequest::Input* in = pr.second;
-      *input = reinterpret_cast<TRITONBACKEND_Input*>(in);
-      break;
-    }
+  // makes it to the backend, and they are stored contiguously so they
+  // can be accessed by index directly.
+  *input = reinterpret_cast<TRITONBACKEND_Input*>(inputs[index].input_);
+
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestCollatedInput(
+    TRITONBACKEND_Request* request, const char* name, const void** buffer,
+    uint64_t* buffer_byte_size, TRITONSERVER_MemoryType* memory_type,
+    int64_t* memory_type_id)
+{
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
+  size_t byte_size;
+  const auto& collated_batch = tr->GetCollatedBatch();
+  if ((collated_batch == nullptr) ||
+      !collated_batch->Input(
+          name, buffer, &byte_size, memory_type, memory_type_id)) {
+    *buffer = nullptr;
+    *buffer_byte_size = 0;
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE,
+        (tr->LogRequest() + "input '" + name + "' is not collated").c_str());
   }
+  *buffer_byte_size = byte_size;
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestCollatedInputOffsets(
+    TRITONBACKEND_Request* request, const char* name, const uint64_t** offsets,
+    uint32_t* offset_count)
+{
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
+  const std::vector<uint64_t>* collated_offsets;
+  const auto& collated_batch = tr->GetCollatedBatch();
+  if ((collated_batch == nullptr) ||
+      !collated_batch->InputOffsets(name, &collated_offsets)) {
+    *offsets = nullptr;
+    *offset_count = 0;
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE,
+        (tr->LogRequest() + "input '" + name + "' is not collated").c_str());
+  }
+  *offsets = collated_offsets->data();
+  *offset_count = collated_offsets->size();
+  return nullptr;  // success
+}
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_RequestCollatedInputDatatype(
+    TRITONBACKEND_Request* request, const char* name,
+    TRITONSERVER_DataType* datatype)
+{
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(request);
+  inference::DataType collated_datatype;
+  const auto& collated_batch = tr->GetCollatedBatch();
+  if ((collated_batch == nullptr) ||
+      !collated_batch->InputDatatype(name, &collated_datatype)) {
+    *datatype = TRITONSERVER_TYPE_INVALID;
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE,
+        (tr->LogRequest() + "input '" + name + "' is not collated").c_str());
+  }
+  *datatype = DataTypeToTriton(collated_datatype);
   return nullptr;  // success
 }
 
@@ -1187,6 +1518,27 @@ TRITONBACKEND_InputBufferAttributes(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_InputStringOffsets(
+    TRITONBACKEND_Input* input, const uint64_t** offsets,
+    uint64_t* element_count)
+{
+  InferenceRequest::Input* ti =
+      reinterpret_cast<InferenceRequest::Input*>(input);
+  std::shared_ptr<const std::vector<uint64_t>> loffsets;
+  Status status = ti->StringOffsets(&loffsets);
+  if (!status.IsOk()) {
+    *offsets = nullptr;
+    *element_count = 0;
+    return TRITONSERVER_ErrorNew(
+        StatusCodeToTritonCode(status.StatusCode()), status.Message().c_str());
+  }
+  // The input holds the offsets until its data changes.
+  *offsets = loffsets->data();
+  *element_count = loffsets->size() - 1;
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONBACKEND_InputBufferForHostPolicy(
     TRITONBACKEND_Input* input, const char* host_policy_name,
@@ -1233,6 +1585,44 @@ TRITONBACKEND_OutputBuffer(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_OutputBuffers(
+    TRITONBACKEND_Output** outputs, const uint32_t output_count,
+    void** buffers, const uint64_t* buffer_byte_sizes,
+    TRITONSERVER_MemoryType* memory_types, int64_t* memory_type_ids)
+{
+  std::vector<InferenceResponse::Output*> tos(output_count);
+  std::vector<size_t> byte_sizes(output_count);
+  for (uint32_t idx = 0; idx < output_count; ++idx) {
+    tos[idx] = reinterpret_cast<InferenceResponse::Output*>(outputs[idx]);
+    byte_sizes[idx] = buffer_byte_sizes[idx];
+    buffers[idx] = nullptr;
+  }
+
+  Status status = InferenceResponse::Output::AllocateDataBuffers(
+      tos, buffers, byte_sizes.data(), memory_types, memory_type_ids);
+  if (!status.IsOk()) {
+    return TRITONSERVER_ErrorNew(
+        StatusCodeToTritonCode(status.StatusCode()), status.Message().c_str());
+  }
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_OutputSetStringOffsets(
+    TRITONBACKEND_Output* output, const uint64_t* offsets,
+    const uint64_t offset_count)
+{
+  InferenceResponse::Output* to =
+      reinterpret_cast<InferenceResponse::Output*>(output);
+  Status status = to->SetStringOffsets(offsets, offset_count);
+  if (!status.IsOk()) {
+    return TRITONSERVER_ErrorNew(
+        StatusCodeToTritonCode(status.StatusCode()), status.Message().c_str());
+  }
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONBACKEND_OutputBufferAttributes(
     TRITONBACKEND_Output* output,
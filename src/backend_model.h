@@ -25,13 +25,17 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include "backend_manager.h"
+#include "backend_memory_manager.h"
 #include "filesystem.h"
 #include "infer_request.h"
 #include "model.h"
 #include "model_config.pb.h"
+#include "shared_buffer_registry.h"
 #include "status.h"
 
 namespace triton { namespace core {
@@ -55,6 +59,13 @@ class TritonModel : public Model {
       std::unique_ptr<TritonModel>* model);
   ~TritonModel();
 
+  // Load and initialize backend 'backend_name' from the global backend
+  // directory ahead of the models using it.
+  static Status PreloadBackend(
+      InferenceServer* server,
+      const triton::common::BackendCmdlineConfigMap& backend_cmdline_config_map,
+      const std::string& backend_name);
+
   const std::string& LocalizedModelPath() const
   {
     return localized_model_dir_->Path();
@@ -71,9 +82,44 @@ class TritonModel : public Model {
   }
   void* State() { return state_; }
   void SetState(void* state) { state_ = state; }
+  TritonMemoryManager* MemoryManager() { return &memory_manager_; }
   Status AddInstance(
       std::unique_ptr<TritonModelInstance>&& instance, const bool passive);
 
+  // Add an instance, a copy of the first instance of the model, while the
+  // model is serving. The instances added this way are kept apart from
+  // Instances() and are the only ones that RemoveScaledInstance() retires.
+  Status AddScaledInstance();
+  // Retire the most recently added scaled instance if it is idle,
+  // 'removed' returns false if there is none or it is busy.
+  Status RemoveScaledInstance(bool* removed);
+  size_t ScaledInstanceCount();
+
+  // Map a file of the model into memory for reading. A relative 'path' is
+  // relative to the localized model directory. The mapping is held by the
+  // model until UnmapFile() is called with the returned 'base' or the
+  // model is destroyed.
+  Status MapFile(
+      const std::string& path, const void** base, uint64_t* byte_size);
+  Status UnmapFile(const void* base);
+
+  // Acquire the shared buffer 'name' on the device of 'instance', see
+  // TRITONBACKEND_ModelSharedBufferAcquire. Wait while the buffer is
+  // being initialized by another instance.
+  Status AcquireSharedBuffer(
+      const TritonModelInstance* instance, const std::string& name,
+      const uint64_t byte_size, void** buffer,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id,
+      bool* initialize);
+  // Complete the initialization of the shared buffer 'name' that
+  // 'instance' acquired first.
+  Status SetSharedBufferInitialized(
+      const TritonModelInstance* instance, const std::string& name,
+      const bool success);
+  // Drop the references of 'instance' to the shared buffers, the
+  // instance must be finalized.
+  void ReleaseSharedBuffers(const TritonModelInstance* instance);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TritonModel);
 
@@ -126,8 +172,27 @@ class TritonModel : public Model {
   std::vector<std::unique_ptr<TritonModelInstance>> instances_;
   std::vector<std::unique_ptr<TritonModelInstance>> passive_instances_;
 
+  // The instances added while the model is serving, and the number of
+  // instances ever added so that each gets its own index in the rate
+  // limiter.
+  std::mutex scaled_instances_mu_;
+  std::vector<std::unique_ptr<TritonModelInstance>> scaled_instances_;
+  size_t scaled_instance_count_;
+  bool scaling_stopped_;
+
   // Opaque state associated with this model.
   void* state_;
+
+  // The memory manager accounting allocations to this model.
+  TritonMemoryManager memory_manager_;
+
+  // The file mappings held for the backend, keyed by the mapping base. A
+  // file mapped more than once has one entry per MapFile() call.
+  std::mutex mapped_files_mu_;
+  std::multimap<const void*, std::shared_ptr<const MappedFile>> mapped_files_;
+
+  // The buffers shared by the instances on a device.
+  SharedBufferRegistry shared_buffers_;
 };
 
 }}  // namespace triton::core
@@ -31,15 +31,24 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <limits>
 #include "backend_model.h"
+#include "collated_batch.h"
+#include "constants.h"
 #include "metrics.h"
 #include "model_config.pb.h"
+#include "model_config_utils.h"
 #include "numa_utils.h"
+#ifdef TRITON_ENABLE_GPU
+#include "model_config_cuda.h"
+#endif  // TRITON_ENABLE_GPU
 #include "server.h"
 #include "shared_library.h"
 #include "triton/common/logging.h"
 #include "triton/common/nvtx.h"
 #include "tritonserver_apis.h"
+#include "work_stealing_pool.h"
 
 // For unknown reason, windows will not export the TRITONBACKEND_*
 // functions declared with dllexport in tritonbackend.h. To get those
@@ -132,6 +141,127 @@ WarmupRequestComplete(
   }
 }
 
+// Model config parameters that control how many ready payloads a backend
+// thread takes per wakeup, and how long it polls for a payload before
+// blocking. A single payload is taken by default, taking more is opt-in
+// as the payloads queued behind a long one wait on its thread even if
+// another instance becomes idle.
+constexpr char kMaxPayloadsParameter[] = "backend_thread_max_payloads";
+constexpr char kSpinParameter[] = "backend_thread_spin_microseconds";
+constexpr uint64_t kDefaultMaxPayloads = 1;
+
+// Model config parameter that enables gathering the inputs of a batch.
+constexpr char kCollateInputsParameter[] = "collate_batch_inputs";
+
+// Model config parameter that gathers the inputs of the next payload of
+// the GPU instances while the current payload executes, implies
+// 'collate_batch_inputs'.
+constexpr char kPrefetchInputsParameter[] = "prefetch_batch_inputs";
+
+// Model config parameter that lists the FP32 inputs converted to FP16 or
+// BF16 while they are gathered, as 'input:FP16,input2:BF16', implies
+// 'collate_batch_inputs'.
+constexpr char kInputConversionsParameter[] =
+    "collate_batch_input_conversions";
+
+// Model config parameter that creates CUDA streams of decreasing priority
+// for the priority levels of the requests on the GPU instances.
+constexpr char kPriorityCudaStreamsParameter[] = "priority_cuda_streams";
+
+// Model config parameter that warms up the instances with a batch of
+// zeros for each preferred batch size, for the backend to capture the
+// CUDA graphs of these batch sizes.
+constexpr char kCudaGraphWarmupParameter[] = "cuda_graph_warmup";
+
+// Model config parameter that runs the CPU instances of the model on the
+// backend thread pool shared by all models.
+constexpr char kSharedBackendThreadsParameter[] = "shared_backend_threads";
+
+// Model config parameter that creates the instances of the model
+// concurrently. The backend must support initializing instances of the
+// same model from multiple threads.
+constexpr char kParallelInstanceCreationParameter[] =
+    "parallel_instance_creation";
+
+// Returns the pool shared by the pooled backend threads, sized to the
+// number of cores.
+WorkStealingThreadPool&
+SharedBackendThreadPool()
+{
+  static WorkStealingThreadPool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+// Return in 'batch_size' and 'shape_key' the CUDA graph signature of a
+// batch of requests, the shapes are the ones of the first request as the
+// requests of a batch have equal shapes unless the inputs are ragged. The
+// inputs are ordered by name as the requests may add them in any order.
+void
+GetCudaGraphSignature(
+    TRITONBACKEND_Request** requests, const uint32_t request_count,
+    size_t* batch_size, std::string* shape_key)
+{
+  *batch_size = 0;
+  shape_key->clear();
+  for (uint32_t idx = 0; idx < request_count; ++idx) {
+    InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(requests[idx]);
+    *batch_size += std::max(1U, tr->BatchSize());
+  }
+  if (request_count == 0) {
+    return;
+  }
+  InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(requests[0]);
+  std::map<std::string, const std::vector<int64_t>*> shapes;
+  for (const auto& entry : tr->ImmutableInputs()) {
+    shapes.emplace(entry.input_->Name(), &entry.input_->Shape());
+  }
+  for (const auto& shape : shapes) {
+    *shape_key += shape.first + ":";
+    for (const auto dim : *shape.second) {
+      *shape_key += std::to_string(dim) + ",";
+    }
+    *shape_key += ";";
+  }
+}
+
+Status
+GetInputConversions(
+    const inference::ModelConfig& config, InputConversions* conversions)
+{
+  conversions->clear();
+  const auto it = config.parameters().find(kInputConversionsParameter);
+  if (it == config.parameters().end()) {
+    return Status::Success;
+  }
+  const std::string& value = it->second.string_value();
+  size_t begin = 0;
+  while (begin < value.size()) {
+    size_t end = value.find(',', begin);
+    if (end == std::string::npos) {
+      end = value.size();
+    }
+    const std::string entry = value.substr(begin, end - begin);
+    begin = end + 1;
+    // The input is everything before the last ':'
+    const size_t sep = entry.rfind(':');
+    inference::DataType dtype = inference::DataType::TYPE_INVALID;
+    if ((sep != std::string::npos) && (sep != 0)) {
+      dtype = triton::common::ProtocolStringToDataType(entry.substr(sep + 1));
+    }
+    if ((dtype != inference::DataType::TYPE_FP16) &&
+        (dtype != inference::DataType::TYPE_BF16)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kInputConversionsParameter +
+              "' must be a list of 'input:FP16' or 'input:BF16', got '" +
+              value + "'");
+    }
+    (*conversions)[entry.substr(0, sep)] = dtype;
+  }
+  return Status::Success;
+}
+
 }  // namespace
 
 TritonModelInstance::TritonModelInstance(
@@ -144,7 +274,9 @@ TritonModelInstance::TritonModelInstance(
     : model_(model), name_(name), index_(index), kind_(kind),
       device_id_(device_id), host_policy_(host_policy),
       host_policy_message_(host_policy_message), profile_names_(profile_names),
-      passive_(passive), secondary_devices_(secondary_devices), state_(nullptr)
+      passive_(passive), secondary_devices_(secondary_devices),
+      warming_up_(false), collate_inputs_(false), prefetch_inputs_(false),
+      copy_stream_(nullptr), state_(nullptr)
 {
 #ifdef TRITON_ENABLE_METRICS
   if (Metrics::Enabled()) {
@@ -174,6 +306,25 @@ TritonModelInstance::~TritonModelInstance()
             reinterpret_cast<TRITONBACKEND_ModelInstance*>(this)),
         "failed finalizing model instance");
   }
+
+  // The backend may use the shared buffers until the instance is finalized
+  model_->ReleaseSharedBuffers(this);
+
+#ifdef TRITON_ENABLE_GPU
+  // The backend may use the streams until the instance is finalized
+  for (const auto stream : priority_streams_) {
+    cudaError_t err = cudaStreamDestroy(stream);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
+    }
+  }
+  if (copy_stream_ != nullptr) {
+    cudaError_t err = cudaStreamDestroy(copy_stream_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
 }
 
 Status
@@ -186,7 +337,52 @@ TritonModelInstance::CreateInstances(
 
   // This structure is used to allocate TritonBackendThread to instances on same
   // device for device blocking execution policy.
-  std::map<uint32_t, std::shared_ptr<TritonBackendThread>> device_to_thread_map;
+  using DeviceThreadMap =
+      std::map<uint32_t, std::shared_ptr<TritonBackendThread>>;
+
+  bool parallel_creation = false;
+  const auto parallel_it =
+      model_config.parameters().find(kParallelInstanceCreationParameter);
+  if (parallel_it != model_config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kParallelInstanceCreationParameter, parallel_it->second.string_value(),
+        &parallel_creation));
+  }
+
+  // Each worker creates its instances in order, starting the warmup of an
+  // instance before creating the next one. Without parallel creation a
+  // single worker creates all instances, otherwise each instance has its
+  // own worker except the instances that share a device blocking backend
+  // thread, which are created by the worker of the device.
+  std::map<std::string, std::vector<std::function<Status(DeviceThreadMap*)>>>
+      workers;
+  std::vector<std::unique_ptr<TritonModelInstance>> instances;
+  size_t instance_count = 0;
+  for (const auto& group : model_config.instance_group()) {
+    const size_t setting_count =
+        (group.kind() == inference::ModelInstanceGroup::KIND_GPU)
+            ? group.gpus_size()
+            : 1;
+    instance_count += group.count() * setting_count;
+  }
+  // Reserved so that the workers can fill their slots concurrently.
+  instances.resize(instance_count);
+  size_t next_instance = 0;
+
+  // The warmup inputs are the same for all instances
+  WarmupInputsList warmup_inputs;
+  RETURN_IF_ERROR(GenerateWarmupInputs(model, &warmup_inputs));
+
+  // Place the GPU instances that don't have NUMA settings in their host
+  // policy on the NUMA node closest to the GPU.
+  bool numa_aware_placement = false;
+  const auto numa_it =
+      model_config.parameters().find(kNumaAwarePlacementParameter);
+  if (numa_it != model_config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kNumaAwarePlacementParameter, numa_it->second.string_value(),
+        &numa_aware_placement));
+  }
 
   for (const auto& group : model_config.instance_group()) {
     std::vector<std::string> profile_names;
@@ -235,7 +431,7 @@ TritonModelInstance::CreateInstances(
                 ModelInstanceGroup_Kind_Name(group.kind()) + " not supported");
       }
       for (const auto is : instance_setting) {
-        const std::string& policy_name = std::get<0>(is);
+        const std::string policy_name = std::get<0>(is);
         const triton::common::HostPolicyCmdlineConfig* host_policy;
         const auto policy_it = host_policy_map.find(policy_name);
         if (policy_it != host_policy_map.end()) {
@@ -243,18 +439,108 @@ TritonModelInstance::CreateInstances(
         } else {
           host_policy = &empty_host_policy;
         }
-        RETURN_IF_ERROR(SetNumaConfigOnThread(*host_policy));
-        auto err = CreateInstance(
-            model, instance_name, c, std::get<1>(is), std::get<2>(is),
-            profile_names, passive, policy_name, *host_policy,
-            *(std::get<3>(is)), device_blocking, &device_to_thread_map,
-            secondary_devices);
-        RETURN_IF_ERROR(ResetNumaMemoryPolicy());
-        RETURN_IF_ERROR(err);
+        triton::common::HostPolicyCmdlineConfig numa_host_policy;
+        if (numa_aware_placement &&
+            (std::get<1>(is) == TRITONSERVER_INSTANCEGROUPKIND_GPU) &&
+            (host_policy->find("numa-node") == host_policy->end()) &&
+            (host_policy->find("cpu-cores") == host_policy->end())) {
+          numa_host_policy = *host_policy;
+          RETURN_IF_ERROR(
+              AddGpuNumaHostPolicy(std::get<2>(is), &numa_host_policy));
+          host_policy = &numa_host_policy;
+        }
+
+        const TRITONSERVER_InstanceGroupKind kind = std::get<1>(is);
+        const int32_t device_id = std::get<2>(is);
+        const inference::ModelRateLimiter* rate_limiter = std::get<3>(is);
+        const triton::common::HostPolicyCmdlineConfig policy = *host_policy;
+        const size_t instance_idx = next_instance++;
+        std::string worker_key;
+        if (parallel_creation) {
+          worker_key =
+              (device_blocking && (kind == TRITONSERVER_INSTANCEGROUPKIND_GPU))
+                  ? ("device_" + std::to_string(device_id))
+                  : std::to_string(workers.size());
+        }
+        workers[worker_key].emplace_back(
+            [model, instance_name, c, kind, device_id, profile_names, passive,
+             policy_name, policy, rate_limiter, device_blocking,
+             parallel_creation, secondary_devices, instance_idx, &instances,
+             &warmup_inputs](DeviceThreadMap* device_to_thread_map) -> Status {
+              RETURN_IF_ERROR(SetNumaConfigOnThread(policy));
+              auto err = CreateInstance(
+                  model, instance_name, c, kind, device_id, profile_names,
+                  passive, policy_name, policy, *rate_limiter,
+                  device_blocking, parallel_creation, device_to_thread_map,
+                  secondary_devices, warmup_inputs, &instances[instance_idx]);
+              RETURN_IF_ERROR(ResetNumaMemoryPolicy());
+              return err;
+            });
       }
     }
   }
 
+  std::vector<Status> worker_status(workers.size());
+  auto run_worker = [](const std::vector<std::function<Status(
+                           DeviceThreadMap*)>>& tasks,
+                       Status* status) {
+    DeviceThreadMap device_to_thread_map;
+    for (const auto& task : tasks) {
+      *status = task(&device_to_thread_map);
+      if (!status->IsOk()) {
+        break;
+      }
+    }
+  };
+  if (workers.size() == 1) {
+    run_worker(workers.begin()->second, &worker_status[0]);
+  } else {
+    std::vector<std::thread> threads;
+    size_t worker_idx = 0;
+    for (const auto& worker : workers) {
+      threads.emplace_back(
+          run_worker, std::cref(worker.second), &worker_status[worker_idx++]);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  for (const auto& status : worker_status) {
+    RETURN_IF_ERROR(status);
+  }
+
+  // Without parallel creation the instances are warmed up once all are
+  // initialized, concurrently on their backend threads.
+  if (!parallel_creation) {
+    auto rate_limiter = model->Server()->GetRateLimiter();
+    std::vector<std::shared_ptr<Payload>> warmup_payloads;
+    for (const auto& instance : instances) {
+      if ((instance != nullptr) && !instance->IsPassive()) {
+        warmup_payloads.emplace_back(rate_limiter->GetPayload(
+            Payload::Operation::WARM_UP, instance.get()));
+        RETURN_IF_ERROR(
+            rate_limiter->EnqueuePayload(model, warmup_payloads.back()));
+      }
+    }
+    Status warmup_status;
+    for (const auto& payload : warmup_payloads) {
+      Status status = payload->Wait();
+      if (warmup_status.IsOk()) {
+        warmup_status = status;
+      }
+    }
+    RETURN_IF_ERROR(warmup_status);
+  }
+
+  // Add the instances in the order of the model configuration regardless
+  // of the order they are created in.
+  for (auto& instance : instances) {
+    if (instance != nullptr) {
+      const bool passive = instance->IsPassive();
+      RETURN_IF_ERROR(model->AddInstance(std::move(instance), passive));
+    }
+  }
+
   return Status::Success;
 }
 
@@ -266,10 +552,12 @@ TritonModelInstance::CreateInstance(
     const std::string& host_policy_name,
     const triton::common::HostPolicyCmdlineConfig& host_policy,
     const inference::ModelRateLimiter& rate_limiter_config,
-    const bool device_blocking,
+    const bool device_blocking, const bool parallel_creation,
     std::map<uint32_t, std::shared_ptr<TritonBackendThread>>*
         device_to_thread_map,
-    const std::vector<SecondaryDevice>& secondary_devices)
+    const std::vector<SecondaryDevice>& secondary_devices,
+    const WarmupInputsList& warmup_inputs,
+    std::unique_ptr<TritonModelInstance>* instance)
 {
   // Create the JSON representation of the backend configuration.
   triton::common::TritonJson::Value host_policy_json(
@@ -291,30 +579,144 @@ TritonModelInstance::CreateInstance(
   TRITONBACKEND_ModelInstance* triton_instance =
       reinterpret_cast<TRITONBACKEND_ModelInstance*>(local_instance.get());
 
+  const auto& parameters = model->Config().parameters();
+  const auto collate_it = parameters.find(kCollateInputsParameter);
+  if (collate_it != parameters.end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kCollateInputsParameter, collate_it->second.string_value(),
+        &local_instance->collate_inputs_));
+  }
+  RETURN_IF_ERROR(GetInputConversions(
+      model->Config(), &local_instance->input_conversions_));
+  if (!local_instance->input_conversions_.empty()) {
+    local_instance->collate_inputs_ = true;
+  }
+  const auto prefetch_it = parameters.find(kPrefetchInputsParameter);
+  if (prefetch_it != parameters.end()) {
+    bool prefetch_inputs;
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kPrefetchInputsParameter, prefetch_it->second.string_value(),
+        &prefetch_inputs));
+    if (prefetch_inputs && (kind == TRITONSERVER_INSTANCEGROUPKIND_GPU)) {
+      local_instance->prefetch_inputs_ = true;
+      local_instance->collate_inputs_ = true;
+    } else if (prefetch_inputs) {
+      LOG_WARNING << "Prefetching the inputs of " << name
+                  << " requires a GPU instance, it is disabled";
+    }
+  }
+  // The inputs of a GPU instance are gathered on its own stream rather
+  // than on the default stream, which would synchronize with the other
+  // instances on the device.
+  if (local_instance->collate_inputs_ &&
+      (kind == TRITONSERVER_INSTANCEGROUPKIND_GPU)) {
+    RETURN_IF_ERROR(local_instance->CreateCopyCudaStream());
+  }
+  const auto streams_it = parameters.find(kPriorityCudaStreamsParameter);
+  if (streams_it != parameters.end()) {
+    bool priority_streams;
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kPriorityCudaStreamsParameter, streams_it->second.string_value(),
+        &priority_streams));
+    if (priority_streams && (kind == TRITONSERVER_INSTANCEGROUPKIND_GPU) &&
+        (model->MaxPriorityLevel() > 1)) {
+      RETURN_IF_ERROR(local_instance->CreatePriorityCudaStreams());
+    } else if (priority_streams) {
+      LOG_WARNING << "Priority CUDA streams of " << name
+                  << " require a GPU instance and more than one priority"
+                  << " level, they are disabled";
+    }
+  }
+
   // Instance initialization is optional... We must set set shared
   // library path to point to the backend directory in case the
-  // backend library attempts to load additional shared libaries.
+  // backend library attempts to load additional shared libaries. The
+  // library directory is only set on Windows so the instances created
+  // concurrently are initialized without holding the library lock.
   if (model->Backend()->ModelInstanceInitFn() != nullptr) {
     std::unique_ptr<SharedLibrary> slib;
-    RETURN_IF_ERROR(SharedLibrary::Acquire(&slib));
-    RETURN_IF_ERROR(slib->SetLibraryDirectory(model->Backend()->Directory()));
+#ifdef _WIN32
+    const bool acquire_library = true;
+#else
+    const bool acquire_library = !parallel_creation;
+#endif  // _WIN32
+    if (acquire_library) {
+      RETURN_IF_ERROR(SharedLibrary::Acquire(&slib));
+      RETURN_IF_ERROR(
+          slib->SetLibraryDirectory(model->Backend()->Directory()));
+    }
 
     TRITONSERVER_Error* err =
         model->Backend()->ModelInstanceInitFn()(triton_instance);
 
-    RETURN_IF_ERROR(slib->ResetLibraryDirectory());
+    if (slib != nullptr) {
+      RETURN_IF_ERROR(slib->ResetLibraryDirectory());
+    }
     RETURN_IF_TRITONSERVER_ERROR(err);
   }
 
   if (!passive) {
-    RETURN_IF_ERROR(local_instance->GenerateWarmupData());
+    RETURN_IF_ERROR(local_instance->GenerateWarmupData(warmup_inputs));
     RETURN_IF_ERROR(model->Server()->GetRateLimiter()->RegisterModelInstance(
         local_instance.get(), rate_limiter_config));
     RETURN_IF_ERROR(local_instance->SetBackendThread(
-        kind, device_id, device_blocking, device_to_thread_map));
+        kind, device_id, device_blocking, parallel_creation /* warmup */,
+        device_to_thread_map));
   }
 
-  RETURN_IF_ERROR(model->AddInstance(std::move(local_instance), passive));
+  *instance = std::move(local_instance);
+
+  return Status::Success;
+}
+
+Status
+TritonModelInstance::CreateScaledInstance(
+    const TritonModelInstance& prototype, const std::string& name,
+    const size_t index, const inference::ModelRateLimiter& rate_limiter_config,
+    std::unique_ptr<TritonModelInstance>* instance)
+{
+  TritonModel* model = prototype.Model();
+
+  // The host policy message holds the policy under its name
+  const char* base;
+  size_t byte_size;
+  prototype.HostPolicyMessage().Serialize(&base, &byte_size);
+  triton::common::TritonJson::Value host_policy_json;
+  RETURN_IF_ERROR(host_policy_json.Parse(base, byte_size));
+  std::vector<std::string> policy_names;
+  RETURN_IF_ERROR(host_policy_json.Members(&policy_names));
+  if (policy_names.size() != 1) {
+    return Status(
+        Status::Code::INTERNAL,
+        "unexpected host policy of model instance " + prototype.Name());
+  }
+
+  WarmupInputsList warmup_inputs;
+  RETURN_IF_ERROR(GenerateWarmupInputs(model, &warmup_inputs));
+
+  // The instance has its own backend thread so that it can be stopped
+  // independently of the other instances.
+  std::map<uint32_t, std::shared_ptr<TritonBackendThread>>
+      device_to_thread_map;
+  std::unique_ptr<TritonModelInstance> local_instance;
+  RETURN_IF_ERROR(SetNumaConfigOnThread(prototype.HostPolicy()));
+  Status status = CreateInstance(
+      model, name, index, prototype.Kind(), prototype.DeviceId(),
+      prototype.Profiles(), false /* passive */, policy_names[0],
+      prototype.HostPolicy(), rate_limiter_config,
+      false /* device_blocking */, false /* parallel_creation */,
+      &device_to_thread_map, prototype.SecondaryDevices(), warmup_inputs,
+      &local_instance);
+  RETURN_IF_ERROR(ResetNumaMemoryPolicy());
+  RETURN_IF_ERROR(status);
+
+  auto rate_limiter = model->Server()->GetRateLimiter();
+  auto warmup_payload = rate_limiter->GetPayload(
+      Payload::Operation::WARM_UP, local_instance.get());
+  RETURN_IF_ERROR(rate_limiter->EnqueuePayload(model, warmup_payload));
+  RETURN_IF_ERROR(warmup_payload->Wait());
+
+  *instance = std::move(local_instance);
 
   return Status::Success;
 }
@@ -322,7 +724,7 @@ TritonModelInstance::CreateInstance(
 Status
 TritonModelInstance::SetBackendThread(
     const TRITONSERVER_InstanceGroupKind kind, const int32_t device_id,
-    const bool device_blocking,
+    const bool device_blocking, const bool warmup,
     std::map<uint32_t, std::shared_ptr<TritonBackendThread>>*
         device_to_thread_map)
 {
@@ -335,35 +737,172 @@ TritonModelInstance::SetBackendThread(
     }
   }
   if (triton_backend_thread_.get() == nullptr) {
+    // Pooled backend threads don't own a thread so a host policy that
+    // binds the thread to specific cores requires a dedicated thread.
+    bool pooled = false;
+    const auto& parameters = model_->Config().parameters();
+    const auto pooled_it = parameters.find(kSharedBackendThreadsParameter);
+    if ((kind == TRITONSERVER_INSTANCEGROUPKIND_CPU) &&
+        (pooled_it != parameters.end())) {
+      RETURN_IF_ERROR(ParseBoolParameter(
+          kSharedBackendThreadsParameter, pooled_it->second.string_value(),
+          &pooled));
+      if (pooled && ((host_policy_.find("numa-node") != host_policy_.end()) ||
+                     (host_policy_.find("cpu-cores") != host_policy_.end()))) {
+        LOG_VERBOSE(1) << "Using dedicated backend thread for " << Name()
+                       << " as its host policy sets NUMA configuration";
+        pooled = false;
+      }
+    }
     std::unique_ptr<TritonBackendThread> local_backend_thread;
     RETURN_IF_ERROR(TritonBackendThread::CreateBackendThread(
-        Name(), this, 0 /* nice */, device_id, &local_backend_thread));
+        Name(), this, 0 /* nice */, device_id, pooled, &local_backend_thread));
     triton_backend_thread_ = std::move(local_backend_thread);
     device_to_thread_map->insert({device_id, triton_backend_thread_});
   } else {
     triton_backend_thread_->AddModelInstance(this);
   }
-  RETURN_IF_ERROR(triton_backend_thread_->InitAndWarmUpModelInstance(this));
+  RETURN_IF_ERROR(
+      triton_backend_thread_->InitAndWarmUpModelInstance(this, warmup));
 
   return Status::Success;
 }
 
 Status
-TritonModelInstance::GenerateWarmupData()
+TritonModelInstance::CreatePriorityCudaStreams()
 {
-  warmup_samples_.clear();
-  for (const auto& warmup_setting : model_->Config().model_warmup()) {
+#ifdef TRITON_ENABLE_GPU
+  int current_device;
+  RETURN_IF_CUDA_ERR(
+      cudaGetDevice(&current_device), std::string("Failed to get device"));
+  RETURN_IF_CUDA_ERR(
+      cudaSetDevice(device_id_), std::string("Failed to set device"));
+
+  // Defer returning error to make sure the device is recovered
+  Status status;
+  for (const int priority :
+       GetCudaStreamPriorities(model_->MaxPriorityLevel())) {
+    cudaStream_t stream;
+    cudaError_t cuerr = cudaStreamCreateWithPriority(
+        &stream, cudaStreamNonBlocking, priority);
+    if (cuerr != cudaSuccess) {
+      status = Status(
+          Status::Code::INTERNAL,
+          "unable to create priority stream for " + Name() + ": " +
+              cudaGetErrorString(cuerr));
+      break;
+    }
+    priority_streams_.push_back(stream);
+  }
+  cudaSetDevice(current_device);
+  RETURN_IF_ERROR(status);
+
+  LOG_VERBOSE(1) << "Created " << priority_streams_.size()
+                 << " priority CUDA streams for " << Name();
+#endif  // TRITON_ENABLE_GPU
+  return Status::Success;
+}
+
+Status
+TritonModelInstance::CreateCopyCudaStream()
+{
+#ifdef TRITON_ENABLE_GPU
+  int current_device;
+  RETURN_IF_CUDA_ERR(
+      cudaGetDevice(&current_device), std::string("Failed to get device"));
+  RETURN_IF_CUDA_ERR(
+      cudaSetDevice(device_id_), std::string("Failed to set device"));
+  cudaError_t cuerr =
+      cudaStreamCreateWithFlags(&copy_stream_, cudaStreamNonBlocking);
+  cudaSetDevice(current_device);
+  if (cuerr != cudaSuccess) {
+    copy_stream_ = nullptr;
+    return Status(
+        Status::Code::INTERNAL, "unable to create copy stream for " + Name() +
+                                    ": " + cudaGetErrorString(cuerr));
+  }
+  LOG_VERBOSE(1) << "Created copy CUDA stream for " << Name();
+#endif  // TRITON_ENABLE_GPU
+  return Status::Success;
+}
+
+cudaStream_t
+TritonModelInstance::PriorityCudaStream(const uint32_t priority_level) const
+{
+  if (priority_streams_.empty()) {
+    return nullptr;
+  }
+  // Level 1 is the highest priority
+  const size_t level_count = model_->MaxPriorityLevel();
+  const size_t level =
+      std::min(std::max((size_t)priority_level, (size_t)1), level_count);
+  return priority_streams_
+      [(level - 1) * priority_streams_.size() / level_count];
+}
+
+Status
+TritonModelInstance::GetWarmupSettings(
+    const TritonModel* model,
+    std::vector<inference::ModelWarmup>* warmup_settings)
+{
+  const auto& config = model->Config();
+  warmup_settings->assign(
+      config.model_warmup().begin(), config.model_warmup().end());
+
+  const auto it = config.parameters().find(kCudaGraphWarmupParameter);
+  bool graph_warmup = false;
+  if (it != config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kCudaGraphWarmupParameter, it->second.string_value(), &graph_warmup));
+  }
+  if (!graph_warmup || (config.max_batch_size() == 0)) {
+    return Status::Success;
+  }
+  inference::ModelWarmup graph_setting;
+  for (const auto& input : config.input()) {
+    if (input.optional()) {
+      continue;
+    }
+    if (input.is_shape_tensor() ||
+        (triton::common::GetElementCount(input.dims()) == -1)) {
+      LOG_VERBOSE(1) << "Skipping CUDA graph warmup of '" << config.name()
+                     << "' as input '" << input.name()
+                     << "' doesn't have a fixed shape";
+      return Status::Success;
+    }
+    auto& warmup_input = (*graph_setting.mutable_inputs())[input.name()];
+    warmup_input.set_data_type(input.data_type());
+    *warmup_input.mutable_dims() = input.dims();
+    warmup_input.set_zero_data(true);
+  }
+  for (const auto batch_size :
+       config.dynamic_batching().preferred_batch_size()) {
+    graph_setting.set_name("cuda_graph_batch_" + std::to_string(batch_size));
+    graph_setting.set_batch_size(batch_size);
+    graph_setting.set_count(1);
+    warmup_settings->push_back(graph_setting);
+  }
+  return Status::Success;
+}
+
+Status
+TritonModelInstance::GenerateWarmupInputs(
+    TritonModel* model, WarmupInputsList* warmup_inputs)
+{
+  warmup_inputs->clear();
+  std::vector<inference::ModelWarmup> warmup_settings;
+  RETURN_IF_ERROR(GetWarmupSettings(model, &warmup_settings));
+  for (const auto& warmup_setting : warmup_settings) {
     if (warmup_setting.batch_size() == 0) {
-      LOG_VERBOSE(1) << "Skipping batch 0 warmup sample '"
-                     << warmup_setting.name() << "'";
+      warmup_inputs->emplace_back(nullptr);
       continue;
     }
     LOG_VERBOSE(1) << "Generating warmup sample data for '"
                    << warmup_setting.name() << "'";
 
-    // Two passes. First pass to get max byte size for synthetic
-    // data. Second pass to add original inputs and override inputs
-    // for control inputs.
+    // First pass to get max byte size for synthetic data and to read the
+    // data provided from file.
+    std::shared_ptr<WarmupInputs> inputs(new WarmupInputs());
     int64_t max_zero_byte_size = 0;
     int64_t max_random_byte_size = 0;
     for (const auto& input_meta : warmup_setting.inputs()) {
@@ -401,31 +940,68 @@ TritonModelInstance::GenerateWarmupData()
           }
           break;
         }
+        case inference::ModelWarmup_Input::InputDataTypeCase::kInputDataFile: {
+          RETURN_IF_ERROR(ReadTextFile(
+              JoinPath({model->LocalizedModelPath(), kWarmupDataFolder,
+                        input_meta.second.input_data_file()}),
+              &inputs->provided_data_[input_meta.first]));
+          break;
+        }
         default:
           break;
       }
     }
 
-    warmup_samples_.emplace_back(warmup_setting.name(), warmup_setting.count());
-    auto& warmup_data = warmup_samples_.back();
     // Create buffers for synthetic data
     TRITONSERVER_MemoryType type;
     int64_t type_id;
-    warmup_data.zero_data_.reset(new AllocatedMemory(
+    inputs->zero_data_.reset(new AllocatedMemory(
         max_zero_byte_size, TRITONSERVER_MEMORY_CPU_PINNED /* memory_type */,
         0 /* memory_type_id */));
-    char* zero_buffer = warmup_data.zero_data_->MutableBuffer(&type, &type_id);
+    char* zero_buffer = inputs->zero_data_->MutableBuffer(&type, &type_id);
     memset(zero_buffer, 0, max_zero_byte_size);
 
-    warmup_data.random_data_.reset(new AllocatedMemory(
+    inputs->random_data_.reset(new AllocatedMemory(
         max_random_byte_size, TRITONSERVER_MEMORY_CPU_PINNED /* memory_type */,
         0 /* memory_type_id */));
-    char* random_buffer =
-        warmup_data.random_data_->MutableBuffer(&type, &type_id);
+    char* random_buffer = inputs->random_data_->MutableBuffer(&type, &type_id);
     for (int64_t offset = 0; offset < max_random_byte_size; offset++) {
       random_buffer[offset] = rand();
     }
 
+    warmup_inputs->emplace_back(std::move(inputs));
+  }
+
+  return Status::Success;
+}
+
+Status
+TritonModelInstance::GenerateWarmupData(const WarmupInputsList& warmup_inputs)
+{
+  warmup_samples_.clear();
+  std::vector<inference::ModelWarmup> warmup_settings;
+  RETURN_IF_ERROR(GetWarmupSettings(model_, &warmup_settings));
+  for (size_t setting_idx = 0; setting_idx < warmup_settings.size();
+       ++setting_idx) {
+    const auto& warmup_setting = warmup_settings[setting_idx];
+    if (warmup_setting.batch_size() == 0) {
+      LOG_VERBOSE(1) << "Skipping batch 0 warmup sample '"
+                     << warmup_setting.name() << "'";
+      continue;
+    }
+
+    warmup_samples_.emplace_back(
+        warmup_setting.name(), warmup_setting.count(),
+        warmup_inputs[setting_idx]);
+    auto& warmup_data = warmup_samples_.back();
+    size_t byte_size;
+    TRITONSERVER_MemoryType type;
+    int64_t type_id;
+    const char* zero_buffer = warmup_data.inputs_->zero_data_->BufferAt(
+        0, &byte_size, &type, &type_id);
+    const char* random_buffer = warmup_data.inputs_->random_data_->BufferAt(
+        0, &byte_size, &type, &type_id);
+
     // Prepare the inference request for the specified sample, not using
     // in-process C API because the request doesn't go through the same pipeline
     // (i.e. no normalization / scheduler) so we need to prepare the request to
@@ -463,17 +1039,13 @@ TritonModelInstance::GenerateWarmupData()
           }
           case inference::ModelWarmup_Input::InputDataTypeCase::
               kInputDataFile: {
-            // For data provided from file, we can set buffer in first pass
-            warmup_data.provided_data_.emplace_back(new std::string());
-            auto input_data = warmup_data.provided_data_.back().get();
-            RETURN_IF_ERROR(ReadTextFile(
-                JoinPath({model_->LocalizedModelPath(), kWarmupDataFolder,
-                          input_meta.second.input_data_file()}),
-                input_data));
+            // The data provided from file is read in the first pass
+            const auto& input_data =
+                warmup_data.inputs_->provided_data_.at(input_meta.first);
             if (input_meta.second.data_type() ==
                 inference::DataType::TYPE_STRING) {
-              batch_byte_size = input_data->size();
-            } else if (((size_t)batch_byte_size) > input_data->size()) {
+              batch_byte_size = input_data.size();
+            } else if (((size_t)batch_byte_size) > input_data.size()) {
               return Status(
                   Status::Code::INVALID_ARG,
                   lrequest->LogRequest() + "warmup setting expects " +
@@ -481,9 +1053,9 @@ TritonModelInstance::GenerateWarmupData()
                       " bytes, but the data "
                       "provided from " +
                       input_meta.second.input_data_file() + "only has " +
-                      std::to_string(input_data->size()) + " bytes");
+                      std::to_string(input_data.size()) + " bytes");
             }
-            allocated_ptr = input_data->data();
+            allocated_ptr = input_data.data();
             break;
           }
           default:
@@ -546,6 +1118,36 @@ TritonModelInstance::Schedule(
   for (auto& r : requests) {
     // Load the input states for the inference request.
     r->LoadInputStates();
+  }
+
+  // Gather the inputs of the batch so that the backend doesn't need to,
+  // the backend falls back to the request inputs on failure. The inputs
+  // may already be in flight if they were prefetched.
+  if (ShouldCollate(requests)) {
+    std::shared_ptr<CollatedBatch> collated_batch =
+        requests.front()->GetCollatedBatch();
+    Status status;
+    if (collated_batch != nullptr) {
+      status = collated_batch->Wait();
+    } else {
+      status = CollatedBatch::Create(
+          requests, model_->Config(), input_conversions_,
+          (kind_ == TRITONSERVER_INSTANCEGROUPKIND_GPU)
+              ? TRITONSERVER_MEMORY_GPU
+              : TRITONSERVER_MEMORY_CPU,
+          device_id_, copy_stream_, &collated_batch);
+    }
+    if (!status.IsOk()) {
+      LOG_VERBOSE(1) << "failed to collate inputs for " << Name() << ": "
+                     << status.Message();
+      collated_batch.reset();
+    }
+    for (auto& r : requests) {
+      r->SetCollatedBatch(collated_batch);
+    }
+  }
+
+  for (auto& r : requests) {
     triton_requests.push_back(
         reinterpret_cast<TRITONBACKEND_Request*>(r.release()));
   }
@@ -555,6 +1157,39 @@ TritonModelInstance::Schedule(
   OnCompletion();
 }
 
+void
+TritonModelInstance::PrefetchInputs(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  if (!prefetch_inputs_ || !ShouldCollate(requests)) {
+    return;
+  }
+  // The input states are not loaded yet so they are left to the backend.
+  std::shared_ptr<CollatedBatch> collated_batch;
+  Status status = CollatedBatch::CreateAsync(
+      requests, model_->Config(), input_conversions_, TRITONSERVER_MEMORY_GPU,
+      device_id_, copy_stream_, &collated_batch);
+  if (!status.IsOk()) {
+    // Schedule() collates the inputs again
+    LOG_VERBOSE(1) << "failed to prefetch inputs for " << Name() << ": "
+                   << status.Message();
+    return;
+  }
+  for (auto& r : requests) {
+    r->SetCollatedBatch(collated_batch);
+  }
+}
+
+bool
+TritonModelInstance::ShouldCollate(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests) const
+{
+  // A single request is only collated for the batch inputs of the model.
+  return collate_inputs_ && !requests.empty() &&
+         ((requests.size() > 1) ||
+          (model_->ConfigSnapshot().batch_input_count_ != 0));
+}
+
 Status
 TritonModelInstance::Initialize()
 {
@@ -569,7 +1204,14 @@ TritonModelInstance::WarmUp()
   std::vector<triton::core::TritonModelInstance::WarmupData> lwarmup_samples;
   lwarmup_samples.swap(warmup_samples_);
 
+  warming_up_ = true;
+
   for (auto& sample : lwarmup_samples) {
+    size_t batch_size = 0;
+    for (const auto& request : sample.requests_) {
+      batch_size += std::max(1U, request->BatchSize());
+    }
+
     for (size_t iteration = 1; iteration <= sample.count_; ++iteration) {
       LOG_VERBOSE(1) << "model '" << sample.requests_.back()->ModelName()
                      << "' instance " << Name() << " is running warmup sample '"
@@ -601,6 +1243,7 @@ TritonModelInstance::WarmUp()
             reinterpret_cast<TRITONBACKEND_Request*>(request.get()));
       }
 
+      const auto start = std::chrono::steady_clock::now();
       Execute(triton_requests);
 
       // Wait for warmup sample to complete and check error
@@ -619,10 +1262,21 @@ TritonModelInstance::WarmUp()
                        << "' instance " << Name()
                        << " failed to run warmup sample '"
                        << sample.sample_name_ << "'";
+        warming_up_ = false;
         return Status(Status::Code::INVALID_ARG, err_str);
       }
+
+      // Seed the latency profile, skipping the first iteration if there
+      // are more as it includes one-time initialization.
+      if ((iteration > 1) || (sample.count_ == 1)) {
+        latency_profile_.Record(
+            batch_size, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+      }
     }
   }
+  warming_up_ = false;
 
   return Status::Success;
 }
@@ -631,6 +1285,7 @@ void
 TritonModelInstance::Execute(
     std::vector<TRITONBACKEND_Request*>& triton_requests)
 {
+  CPU_STAGE_SCOPE(cpu_stage_, model_->MutableStatsAggregator(), EXECUTE);
   TRITONBACKEND_ModelInstance* triton_model_instance =
       reinterpret_cast<TRITONBACKEND_ModelInstance*>(this);
   TritonBackend::TritonModelInstanceExecFn_t inst_exec_fn =
@@ -657,18 +1312,56 @@ TritonModelInstance::Execute(
 Status
 TritonModelInstance::TritonBackendThread::CreateBackendThread(
     const std::string name, TritonModelInstance* model_instance, const int nice,
-    const int32_t device_id,
+    const int32_t device_id, const bool pooled,
     std::unique_ptr<TritonBackendThread>* triton_backend_thread)
 {
   TritonBackendThread* raw_triton_backend_thread =
       new TritonBackendThread(name, model_instance->Model());
   std::unique_ptr<TritonBackendThread> runner(raw_triton_backend_thread);
 
+  const auto& config = model_instance->Model()->Config();
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kMaxPayloadsParameter, kDefaultMaxPayloads,
+      &runner->max_payload_count_));
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kSpinParameter, 0 /* default_value */, &runner->spin_ns_));
+  runner->max_payload_count_ =
+      std::max(runner->max_payload_count_, uint64_t{1});
+  runner->spin_ns_ *= 1000;
+
   runner->AddModelInstance(model_instance);
-  runner->backend_thread_ =
-      std::thread([raw_triton_backend_thread, nice, device_id]() {
-        raw_triton_backend_thread->BackendThread(nice, device_id);
-      });
+  if (pooled) {
+    LOG_VERBOSE(1) << "Using shared backend thread pool for " << name;
+    auto registry = GetPoolRegistry(runner->model_);
+    {
+      std::lock_guard<std::mutex> lk(registry->mu_);
+      registry->threads_.push_back(raw_triton_backend_thread);
+    }
+    runner->pool_registry_ = registry;
+    // Wake up a pooled backend thread that can execute the scheduled
+    // payload. The rate limiter has already ordered the payloads so a
+    // payload for any instance goes to the first idle backend thread, the
+    // busy ones will pick it up otherwise.
+    runner->model_->Server()->GetRateLimiter()->SetPayloadScheduledCallback(
+        runner->model_, [registry](TritonModelInstance* instance) {
+          std::lock_guard<std::mutex> lk(registry->mu_);
+          for (auto thread : registry->threads_) {
+            if (instance == nullptr) {
+              if (thread->SchedulePoolTask()) {
+                break;
+              }
+            } else if (thread->FirstModelInstance() == instance) {
+              thread->SchedulePoolTask();
+              break;
+            }
+          }
+        });
+  } else {
+    runner->backend_thread_ =
+        std::thread([raw_triton_backend_thread, nice, device_id]() {
+          raw_triton_backend_thread->BackendThread(nice, device_id);
+        });
+  }
 
   triton_backend_thread->reset(runner.release());
 
@@ -679,12 +1372,27 @@ void
 TritonModelInstance::TritonBackendThread::AddModelInstance(
     TritonModelInstance* model_instance)
 {
+  std::lock_guard<std::mutex> lk(model_instances_mu_);
   model_instances_.push_back(model_instance);
 }
 
+TritonModelInstance*
+TritonModelInstance::TritonBackendThread::FirstModelInstance()
+{
+  std::lock_guard<std::mutex> lk(model_instances_mu_);
+  return model_instances_.front();
+}
+
+TritonModelInstance*
+TritonModelInstance::TritonBackendThread::LastModelInstance()
+{
+  std::lock_guard<std::mutex> lk(model_instances_mu_);
+  return model_instances_.back();
+}
+
 Status
 TritonModelInstance::TritonBackendThread::InitAndWarmUpModelInstance(
-    TritonModelInstance* model_instance)
+    TritonModelInstance* model_instance, const bool warmup)
 {
   // Initialize the instance on the backend thread
   auto init_payload = model_->Server()->GetRateLimiter()->GetPayload(
@@ -692,6 +1400,9 @@ TritonModelInstance::TritonBackendThread::InitAndWarmUpModelInstance(
   RETURN_IF_ERROR(
       model_->Server()->GetRateLimiter()->EnqueuePayload(model_, init_payload));
   RETURN_IF_ERROR(init_payload->Wait());
+  if (!warmup) {
+    return Status::Success;
+  }
 
   // Warm-up the instance on the backend thread
   auto warmup_payload = model_->Server()->GetRateLimiter()->GetPayload(
@@ -705,7 +1416,8 @@ TritonModelInstance::TritonBackendThread::InitAndWarmUpModelInstance(
 
 TritonModelInstance::TritonBackendThread::TritonBackendThread(
     const std::string& name, TritonModel* model)
-    : name_(name), model_(model)
+    : name_(name), model_(model), max_payload_count_(1), spin_ns_(0),
+      pool_task_scheduled_(false), pool_exited_(false)
 {
 }
 
@@ -720,9 +1432,113 @@ TritonModelInstance::TritonBackendThread::StopBackendThread()
   if (backend_thread_.joinable()) {
     // Signal the backend thread to exit and then wait for it...
     auto exit_payload = model_->Server()->GetRateLimiter()->GetPayload(
-        Payload::Operation::EXIT, model_instances_.back());
+        Payload::Operation::EXIT, LastModelInstance());
     model_->Server()->GetRateLimiter()->EnqueuePayload(model_, exit_payload);
     backend_thread_.join();
+  } else if (pool_registry_ != nullptr) {
+    auto exit_payload = model_->Server()->GetRateLimiter()->GetPayload(
+        Payload::Operation::EXIT, LastModelInstance());
+    model_->Server()->GetRateLimiter()->EnqueuePayload(model_, exit_payload);
+    {
+      std::unique_lock<std::mutex> lk(pool_exit_mu_);
+      pool_exit_cv_.wait(lk, [this]() { return pool_exited_; });
+    }
+    {
+      std::lock_guard<std::mutex> lk(pool_registry_->mu_);
+      auto& threads = pool_registry_->threads_;
+      threads.erase(std::find(threads.begin(), threads.end(), this));
+    }
+    pool_registry_.reset();
+  }
+}
+
+TritonModelInstance::TritonBackendThread::PoolRegistries&
+TritonModelInstance::TritonBackendThread::GetPoolRegistries()
+{
+  static PoolRegistries registries;
+  return registries;
+}
+
+std::shared_ptr<TritonModelInstance::TritonBackendThread::PoolRegistry>
+TritonModelInstance::TritonBackendThread::GetPoolRegistry(
+    const TritonModel* model)
+{
+  // The registry of a model is kept until the model is destroyed as the
+  // rate limiter callback referring to it can't be replaced.
+  auto& registries = GetPoolRegistries();
+  std::lock_guard<std::mutex> lk(registries.mu_);
+  auto& registry = registries.registries_[model];
+  if (registry == nullptr) {
+    registry.reset(new PoolRegistry());
+  }
+  return registry;
+}
+
+void
+TritonModelInstance::TritonBackendThread::ReleasePoolRegistry(
+    const TritonModel* model)
+{
+  auto& registries = GetPoolRegistries();
+  std::lock_guard<std::mutex> lk(registries.mu_);
+  registries.registries_.erase(model);
+}
+
+void
+TritonModelInstance::ReleaseBackendThreadPool(const TritonModel* model)
+{
+  TritonBackendThread::ReleasePoolRegistry(model);
+}
+
+bool
+TritonModelInstance::TritonBackendThread::SchedulePoolTask()
+{
+  if (pool_task_scheduled_.exchange(true)) {
+    return false;
+  }
+  SharedBackendThreadPool().Enqueue([this]() { RunPoolTask(); });
+  return true;
+}
+
+void
+TritonModelInstance::TritonBackendThread::RunPoolTask()
+{
+  auto rate_limiter = model_->Server()->GetRateLimiter();
+  // More instances may be added to the backend thread while the task runs.
+  std::deque<TritonModelInstance*> model_instances;
+  {
+    std::lock_guard<std::mutex> lk(model_instances_mu_);
+    model_instances = model_instances_;
+  }
+  std::vector<std::shared_ptr<Payload>> payloads;
+  if (rate_limiter->TryDequeuePayloads(
+          model_instances, max_payload_count_, &payloads)) {
+    NVTX_RANGE(nvtx_, "BackendThread " + name_);
+    bool should_exit = false;
+    for (auto& payload : payloads) {
+      payload->Execute(&should_exit);
+      rate_limiter->PayloadRelease(payload);
+    }
+    if (should_exit) {
+      // The task is never scheduled again.
+      LOG_VERBOSE(1) << "Stopping pooled backend thread for " << name_
+                     << "...";
+      std::lock_guard<std::mutex> lk(pool_exit_mu_);
+      pool_exited_ = true;
+      pool_exit_cv_.notify_all();
+      return;
+    }
+    // Go back of the pool queue to give the other backend threads a
+    // chance to run.
+    SharedBackendThreadPool().Enqueue([this]() { RunPoolTask(); });
+    return;
+  }
+
+  // A payload scheduled before clearing the flag didn't enqueue a task
+  // for this backend thread so check again.
+  pool_task_scheduled_.store(false);
+  if (rate_limiter->HasPayloads(model_instances) &&
+      !pool_task_scheduled_.exchange(true)) {
+    SharedBackendThreadPool().Enqueue([this]() { RunPoolTask(); });
   }
 }
 
@@ -744,16 +1560,46 @@ TritonModelInstance::TritonBackendThread::BackendThread(
                  << " at default nice on device " << device_id << "...";
 #endif
 
+  auto rate_limiter = model_->Server()->GetRateLimiter();
   bool should_exit = false;
+  std::vector<std::shared_ptr<Payload>> payloads;
+  // The payloads taken ahead of time to prefetch their inputs
+  std::vector<std::shared_ptr<Payload>> next_payloads;
   while (!should_exit) {
-    std::shared_ptr<Payload> payload;
-    model_->Server()->GetRateLimiter()->DequeuePayload(
-        model_instances_, &payload);
+    if (next_payloads.empty()) {
+      rate_limiter->DequeuePayloads(
+          model_instances_, max_payload_count_, spin_ns_, &payloads);
+    } else {
+      payloads.swap(next_payloads);
+      next_payloads.clear();
+    }
     NVTX_RANGE(nvtx_, "BackendThread " + name_);
-    payload->Execute(&should_exit);
-    model_instances_.push_back(payload->GetInstance());
-    // Release the payload to the RateLimiter
-    model_->Server()->GetRateLimiter()->PayloadRelease(payload);
+    // Run the payloads back to back, an exit payload is always the last one
+    for (size_t idx = 0; idx < payloads.size(); ++idx) {
+      auto& payload = payloads[idx];
+      if ((payload->GetOpType() == Payload::Operation::INFER_RUN) &&
+          payload->GetInstance()->PrefetchesInputs()) {
+        // Look one payload ahead, taking it from the queue without waiting
+        // if the current payload is the last one taken.
+        Payload* next_payload = nullptr;
+        if ((idx + 1) < payloads.size()) {
+          next_payload = payloads[idx + 1].get();
+        } else if (
+            rate_limiter->TryDequeuePayloads(
+                model_instances_, max_payload_count_, &next_payloads) &&
+            !next_payloads.empty()) {
+          next_payload = next_payloads.front().get();
+        }
+        if ((next_payload != nullptr) &&
+            (next_payload->GetOpType() == Payload::Operation::INFER_RUN)) {
+          next_payload->GetInstance()->PrefetchInputs(
+              next_payload->Requests());
+        }
+      }
+      payload->Execute(&should_exit);
+      // Release the payload to the RateLimiter
+      rate_limiter->PayloadRelease(payload);
+    }
   }
   LOG_VERBOSE(1) << "Stopping backend thread for " << name_ << "...";
 }
@@ -862,6 +1708,51 @@ TRITONBACKEND_ModelInstanceSecondaryDeviceProperties(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstancePriorityCudaStream(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count, void** cuda_stream)
+{
+  TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+  uint32_t priority_level = std::numeric_limits<uint32_t>::max();
+  for (uint32_t idx = 0; idx < request_count; ++idx) {
+    InferenceRequest* tr = reinterpret_cast<InferenceRequest*>(requests[idx]);
+    priority_level = std::min(priority_level, tr->Priority());
+  }
+  *cuda_stream =
+      (request_count == 0) ? nullptr : ti->PriorityCudaStream(priority_level);
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceReportCudaGraph(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count)
+{
+  TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+  size_t batch_size;
+  std::string shape_key;
+  GetCudaGraphSignature(requests, request_count, &batch_size, &shape_key);
+  if (ti->MutableCudaGraphs()->Add(batch_size, shape_key)) {
+    LOG_VERBOSE(1) << "CUDA graph captured by " << ti->Name()
+                   << " for batch size " << batch_size;
+  }
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceHasCudaGraph(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count, bool* captured)
+{
+  TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+  size_t batch_size;
+  std::string shape_key;
+  GetCudaGraphSignature(requests, request_count, &batch_size, &shape_key);
+  *captured = ti->CudaGraphs().Contains(batch_size, shape_key);
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONBACKEND_ModelInstanceIsPassive(
     TRITONBACKEND_ModelInstance* instance, bool* is_passive)
@@ -922,13 +1813,18 @@ TRITONBACKEND_ModelInstanceReportBatchStatistics(
     const uint64_t exec_start_ns, const uint64_t compute_start_ns,
     const uint64_t compute_end_ns, const uint64_t exec_end_ns)
 {
-#ifdef TRITON_ENABLE_STATS
   TritonModelInstance* ti = reinterpret_cast<TritonModelInstance*>(instance);
+#ifdef TRITON_ENABLE_STATS
   ti->Model()->MutableStatsAggregator()->UpdateInferBatchStats(
       ti->MetricReporter(), batch_size, exec_start_ns, compute_start_ns,
       compute_end_ns, exec_end_ns);
 #endif  // TRITON_ENABLE_STATS
 
+  if (!ti->IsWarmingUp() && (exec_end_ns >= exec_start_ns)) {
+    ti->MutableLatencyProfile()->Record(
+        batch_size, exec_end_ns - exec_start_ns);
+  }
+
   return nullptr;  // success
 }
 
@@ -25,12 +25,22 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+#include "batch_latency_profile.h"
+#include "collated_batch.h"
 #include "constants.h"
+#include "cuda_graph_registry.h"
+#include "cuda_utils.h"
 #include "memory.h"
 #include "metric_model_reporter.h"
 #include "model_config.pb.h"
@@ -52,6 +62,17 @@ class TritonModelInstance {
       TritonModel* model,
       const triton::common::HostPolicyCmdlineConfigMap& host_policy_map,
       const inference::ModelConfig& model_config, const bool device_blocking);
+  // Create an instance of the model of 'prototype' with the same placement
+  // while the model is serving, the instance is warmed up and registered
+  // with the rate limiter before it is returned.
+  static Status CreateScaledInstance(
+      const TritonModelInstance& prototype, const std::string& name,
+      const size_t index,
+      const inference::ModelRateLimiter& rate_limiter_config,
+      std::unique_ptr<TritonModelInstance>* instance);
+  // Release the pooled backend thread state kept for 'model', called once
+  // all instances of the model are destroyed.
+  static void ReleaseBackendThreadPool(const TritonModel* model);
   ~TritonModelInstance();
 
   const std::string& Name() const { return name_; }
@@ -87,6 +108,13 @@ class TritonModelInstance {
   void Schedule(
       std::vector<std::unique_ptr<InferenceRequest>>&& requests,
       const std::function<void()>& OnCompletion);
+  // Start gathering the inputs of 'requests' on the copy stream of the
+  // instance so that the copies overlap with the execution of the payload
+  // before them, Schedule() waits for the copies. Does nothing unless the
+  // instance prefetches its inputs.
+  void PrefetchInputs(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests);
+  bool PrefetchesInputs() const { return prefetch_inputs_; }
 
   TritonModel* Model() const { return model_; }
   void* State() { return state_; }
@@ -94,9 +122,29 @@ class TritonModelInstance {
 
   MetricModelReporter* MetricReporter() const { return reporter_.get(); }
 
+  // Latency of the instance for the executed batch sizes.
+  BatchLatencyProfile* MutableLatencyProfile() { return &latency_profile_; }
+  const BatchLatencyProfile& LatencyProfile() const
+  {
+    return latency_profile_;
+  }
+  // Whether the instance is running warmup, in which case the profile is
+  // seeded by WarmUp() instead of the reported batch statistics.
+  bool IsWarmingUp() const { return warming_up_; }
+
+  // The CUDA stream for the requests of 'priority_level', nullptr if the
+  // instance has no priority streams.
+  cudaStream_t PriorityCudaStream(const uint32_t priority_level) const;
+
+  // The batch signatures the backend captured a CUDA graph for.
+  const CudaGraphRegistry& CudaGraphs() const { return cuda_graphs_; }
+  CudaGraphRegistry* MutableCudaGraphs() { return &cuda_graphs_; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TritonModelInstance);
   class TritonBackendThread;
+  struct WarmupInputs;
+  using WarmupInputsList = std::vector<std::shared_ptr<const WarmupInputs>>;
   TritonModelInstance(
       TritonModel* model, const std::string& name, const size_t index,
       const TRITONSERVER_InstanceGroupKind kind, const int32_t device_id,
@@ -111,47 +159,121 @@ class TritonModelInstance {
       const std::string& host_policy_name,
       const triton::common::HostPolicyCmdlineConfig& host_policy,
       const inference::ModelRateLimiter& rate_limiter_config,
-      const bool device_blocking,
+      const bool device_blocking, const bool parallel_creation,
       std::map<uint32_t, std::shared_ptr<TritonBackendThread>>*
           device_to_thread_map,
-      const std::vector<SecondaryDevice>& secondary_devices);
+      const std::vector<SecondaryDevice>& secondary_devices,
+      const WarmupInputsList& warmup_inputs,
+      std::unique_ptr<TritonModelInstance>* instance);
   Status SetBackendThread(
       const TRITONSERVER_InstanceGroupKind kind, const int32_t device_id,
-      const bool device_blocking,
+      const bool device_blocking, const bool warmup,
       std::map<uint32_t, std::shared_ptr<TritonBackendThread>>*
           device_to_thread_map);
-  Status GenerateWarmupData();
+  // Generate the input data of the warmup samples of 'model', once for
+  // all its instances. The list has an entry for each warmup setting,
+  // nullptr for the settings that are skipped.
+  static Status GenerateWarmupInputs(
+      TritonModel* model, WarmupInputsList* warmup_inputs);
+  // The warmup settings of the model configuration followed by a setting
+  // per preferred batch size if the model warms up its CUDA graphs.
+  static Status GetWarmupSettings(
+      const TritonModel* model,
+      std::vector<inference::ModelWarmup>* warmup_settings);
+  Status GenerateWarmupData(const WarmupInputsList& warmup_inputs);
 
   void Execute(std::vector<TRITONBACKEND_Request*>& triton_requests);
+  // Create a CUDA stream per range of the priority levels of the model.
+  Status CreatePriorityCudaStreams();
+  // Create the stream the inputs are gathered and prefetched on.
+  Status CreateCopyCudaStream();
+  // Whether 'requests' are collated before they are executed.
+  bool ShouldCollate(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests) const;
 
   class TritonBackendThread {
    public:
+    // If 'pooled' is true, the payloads are executed on the worker threads
+    // shared by the pooled backend threads of all models instead of on a
+    // dedicated thread.
     static Status CreateBackendThread(
         const std::string name, TritonModelInstance* model, const int nice,
-        const int32_t device_id,
+        const int32_t device_id, const bool pooled,
         std::unique_ptr<TritonBackendThread>* triton_backend_thread);
     void AddModelInstance(TritonModelInstance* model_instance);
-    Status InitAndWarmUpModelInstance(TritonModelInstance* model_instance);
+    TritonModelInstance* FirstModelInstance();
+    TritonModelInstance* LastModelInstance();
+    // Initialize the instance, and warm it up unless 'warmup' is false.
+    Status InitAndWarmUpModelInstance(
+        TritonModelInstance* model_instance, const bool warmup);
     void StopBackendThread();
+    static void ReleasePoolRegistry(const TritonModel* model);
     ~TritonBackendThread();
 
    private:
+    // The pooled backend threads of a model.
+    struct PoolRegistry {
+      std::mutex mu_;
+      std::vector<TritonBackendThread*> threads_;
+    };
+
+    // The pool registries by model.
+    struct PoolRegistries {
+      std::mutex mu_;
+      std::map<const TritonModel*, std::shared_ptr<PoolRegistry>>
+          registries_;
+    };
+
     TritonBackendThread(const std::string& name, TritonModel* model);
     void BackendThread(const int nice, const int32_t device_id);
+    static PoolRegistries& GetPoolRegistries();
+    static std::shared_ptr<PoolRegistry> GetPoolRegistry(
+        const TritonModel* model);
+    bool SchedulePoolTask();
+    void RunPoolTask();
 
     std::string name_;
 
     TritonModel* model_;
+    // Instances may be added while the thread runs, 'model_instances_mu_'
+    // guards the accesses from other threads.
+    std::mutex model_instances_mu_;
     std::deque<TritonModelInstance*> model_instances_;
 
+    // The maximum number of payloads taken per wakeup and the time to poll
+    // for a payload before blocking.
+    uint64_t max_payload_count_;
+    uint64_t spin_ns_;
+
     std::thread backend_thread_;
     std::atomic<bool> backend_thread_exit_;
+
+    // Set for a pooled backend thread. At most one pool task runs the
+    // payloads of the thread at any time, 'pool_task_scheduled_' is true
+    // while the task is enqueued or running.
+    std::shared_ptr<PoolRegistry> pool_registry_;
+    std::atomic<bool> pool_task_scheduled_;
+    std::mutex pool_exit_mu_;
+    std::condition_variable pool_exit_cv_;
+    bool pool_exited_;
   };
   std::shared_ptr<TritonBackendThread> triton_backend_thread_;
 
+  // The input data of a warmup sample, read-only once generated so it is
+  // shared by the instances of the model.
+  struct WarmupInputs {
+    std::unique_ptr<AllocatedMemory> zero_data_;
+    std::unique_ptr<AllocatedMemory> random_data_;
+    // The data provided from file, by input name.
+    std::unordered_map<std::string, std::string> provided_data_;
+  };
+
   struct WarmupData {
-    WarmupData(const std::string& sample_name, const size_t count)
-        : sample_name_(sample_name), count_(std::max(count, size_t{1}))
+    WarmupData(
+        const std::string& sample_name, const size_t count,
+        const std::shared_ptr<const WarmupInputs>& inputs)
+        : sample_name_(sample_name), count_(std::max(count, size_t{1})),
+          inputs_(inputs)
     {
     }
 
@@ -163,9 +285,7 @@ class TritonModelInstance {
     std::vector<std::unique_ptr<InferenceRequest>> requests_;
 
     // Placeholder for input data
-    std::unique_ptr<AllocatedMemory> zero_data_;
-    std::unique_ptr<AllocatedMemory> random_data_;
-    std::vector<std::unique_ptr<std::string>> provided_data_;
+    std::shared_ptr<const WarmupInputs> inputs_;
   };
   std::vector<WarmupData> warmup_samples_;
 
@@ -192,6 +312,30 @@ class TritonModelInstance {
   // Reporter for metrics, or nullptr if no metrics should be reported
   std::shared_ptr<MetricModelReporter> reporter_;
 
+  BatchLatencyProfile latency_profile_;
+  std::atomic<bool> warming_up_;
+
+  // Whether to gather the inputs of a batch of requests before executing
+  // it, see TRITONBACKEND_RequestCollatedInput.
+  bool collate_inputs_;
+
+  // The inputs converted to a lower precision while they are gathered.
+  InputConversions input_conversions_;
+
+  // The CUDA streams from the highest priority to the lowest, the
+  // priority levels of the model are spread evenly over them.
+  std::vector<cudaStream_t> priority_streams_;
+
+  // Whether the inputs of the next payload are collated while the current
+  // payload executes.
+  bool prefetch_inputs_;
+
+  // The stream the inputs of a GPU instance are collated on, nullptr if
+  // the instance doesn't collate its inputs.
+  cudaStream_t copy_stream_;
+
+  CudaGraphRegistry cuda_graphs_;
+
   // Opaque state associated with this model instance.
   void* state_;
 };
@@ -0,0 +1,56 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "batch_fill_policy.h"
+
+#include <cmath>
+
+namespace triton { namespace core {
+
+BatchFillPolicy::BatchFillPolicy(
+    const float minimum_slot_utilization, const uint64_t max_delay_ns,
+    const size_t max_batch_size)
+    : enabled_((minimum_slot_utilization > 0.0) && (max_delay_ns > 0)),
+      max_delay_ns_(max_delay_ns),
+      ready_threshold_(
+          std::ceil(minimum_slot_utilization * max_batch_size - 1e-6))
+{
+}
+
+uint64_t
+BatchFillPolicy::WaitNs(
+    const size_t ready_count, const uint64_t earliest_enqueue_ns,
+    const uint64_t now_ns) const
+{
+  if (!enabled_ || (ready_count >= ready_threshold_)) {
+    return 0;
+  }
+
+  const uint64_t delay_ns =
+      (now_ns > earliest_enqueue_ns) ? (now_ns - earliest_enqueue_ns) : 0;
+  return (delay_ns >= max_delay_ns_) ? 0 : (max_delay_ns_ - delay_ns);
+}
+
+}}  // namespace triton::core
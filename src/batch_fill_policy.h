@@ -0,0 +1,65 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace triton { namespace core {
+
+//
+// Policy deciding when a sequence batcher executes a batch that is only
+// partially filled. A batch executes once the ready sequence slots reach
+// the minimum slot utilization of the batch size, or once its oldest
+// request has waited for the maximum delay, so that a burst of sequences
+// is executed together at the cost of a bounded latency. The policy
+// doesn't wait if either the utilization or the delay is 0.
+//
+class BatchFillPolicy {
+ public:
+  BatchFillPolicy(
+      const float minimum_slot_utilization, const uint64_t max_delay_ns,
+      const size_t max_batch_size);
+
+  // Whether a partially filled batch may wait at all.
+  bool Enabled() const { return enabled_; }
+
+  // Return 0 if the batch of 'ready_count' ready slots, whose oldest
+  // request was enqueued at 'earliest_enqueue_ns', should execute at
+  // 'now_ns', otherwise the nanoseconds until it must execute.
+  uint64_t WaitNs(
+      const size_t ready_count, const uint64_t earliest_enqueue_ns,
+      const uint64_t now_ns) const;
+
+ private:
+  const bool enabled_;
+  const uint64_t max_delay_ns_;
+
+  // The number of ready slots that fills the batch enough.
+  const size_t ready_threshold_;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,114 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "batch_latency_profile.h"
+
+#include <algorithm>
+
+namespace triton { namespace core {
+
+namespace {
+
+// Weight of a new observation in the smoothed latency.
+constexpr double kSmoothingFactor = 0.2;
+
+// Relative throughput drop, when growing the batch by one request, that
+// is considered a latency cliff.
+constexpr double kCliffThreshold = 0.05;
+
+}  // namespace
+
+void
+BatchLatencyProfile::Record(const size_t batch_size, const uint64_t duration_ns)
+{
+  if (batch_size == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = latency_ns_.find(batch_size);
+  if (it == latency_ns_.end()) {
+    latency_ns_.emplace(batch_size, duration_ns);
+  } else {
+    it->second = (kSmoothingFactor * duration_ns) +
+                 ((1 - kSmoothingFactor) * it->second);
+  }
+}
+
+void
+BatchLatencyProfile::Snapshot(std::map<size_t, double>* latency_ns) const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  *latency_ns = latency_ns_;
+}
+
+bool
+BatchLatencyProfile::EfficientBatchSizes(
+    const std::map<size_t, double>& latency_ns, const size_t max_batch_size,
+    std::set<int32_t>* batch_sizes)
+{
+  batch_sizes->clear();
+  if (latency_ns.size() < 2) {
+    return false;
+  }
+
+  // Only look for cliffs within the observed batch sizes, the latency in
+  // between is interpolated linearly.
+  auto upper = latency_ns.begin();
+  auto lower = upper;
+  auto latency_at = [&latency_ns, &lower, &upper](const size_t batch_size) {
+    while ((upper != latency_ns.end()) && (upper->first < batch_size)) {
+      lower = upper++;
+    }
+    if (upper->first == batch_size) {
+      return upper->second;
+    }
+    const double fraction =
+        (double)(batch_size - lower->first) / (upper->first - lower->first);
+    return lower->second + (fraction * (upper->second - lower->second));
+  };
+
+  // Only local maxima of the throughput are considered, so that batch
+  // sizes past a cliff aren't reported while the latency is recovering.
+  const size_t largest = std::min(max_batch_size, latency_ns.rbegin()->first);
+  double prev_throughput = 0;
+  double throughput = latency_ns.begin()->first / latency_ns.begin()->second;
+  for (size_t batch_size = latency_ns.begin()->first; batch_size < largest;
+       ++batch_size) {
+    const double next_throughput =
+        (batch_size + 1) / latency_at(batch_size + 1);
+    if ((throughput >= prev_throughput) &&
+        (next_throughput < (throughput * (1 - kCliffThreshold)))) {
+      batch_sizes->insert(batch_size);
+    }
+    prev_throughput = throughput;
+    throughput = next_throughput;
+  }
+  batch_sizes->insert(max_batch_size);
+
+  return true;
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,67 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace triton { namespace core {
+
+//
+// Execution latency of a model instance as a function of the batch
+// size. The profile is seeded by the warmup of the instance and refined
+// from the batch statistics reported by the backend. The methods are
+// thread-safe.
+//
+class BatchLatencyProfile {
+ public:
+  // Record an execution of 'batch_size' that took 'duration_ns'.
+  void Record(const size_t batch_size, const uint64_t duration_ns);
+
+  // Copy the smoothed latency, in nanoseconds, of each observed batch
+  // size into 'latency_ns'.
+  void Snapshot(std::map<size_t, double>* latency_ns) const;
+
+  // Return in 'batch_sizes' the batch sizes, up to 'max_batch_size', that
+  // are worth waiting for given the latency of each batch size in
+  // 'latency_ns'. A batch size is efficient if its throughput is a local
+  // maximum and adding one more request to the batch reduces it, that is,
+  // the latency has a cliff right after it. 'max_batch_size' is always
+  // included. Return false if too few batch sizes have been observed to
+  // tell.
+  static bool EfficientBatchSizes(
+      const std::map<size_t, double>& latency_ns, const size_t max_batch_size,
+      std::set<int32_t>* batch_sizes);
+
+ private:
+  mutable std::mutex mu_;
+  std::map<size_t, double> latency_ns_;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,429 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cache_eviction_policy.h"
+
+#include <algorithm>
+
+namespace triton { namespace core {
+
+namespace {
+
+// Expected average byte size of a cached response, only used to size the
+// TinyLFU frequency sketch relative to the cache capacity
+constexpr uint64_t kExpectedEntryByteSize = 256;
+// Bounds on the number of counters per row of the frequency sketch
+constexpr size_t kMinSketchWidth = 16;
+constexpr size_t kMaxSketchWidth = 1 << 20;
+
+}  // namespace
+
+Status
+CacheEvictionPolicy::Create(
+    const Kind kind, const uint64_t capacity,
+    std::unique_ptr<CacheEvictionPolicy>* policy)
+{
+  switch (kind) {
+    case Kind::LRU:
+      policy->reset(new LRUEvictionPolicy());
+      break;
+    case Kind::TINY_LFU:
+      policy->reset(new TinyLFUEvictionPolicy(capacity));
+      break;
+    case Kind::SIZE_AWARE:
+      policy->reset(new SizeAwareEvictionPolicy());
+      break;
+    default:
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unknown response cache eviction policy '" +
+              std::to_string(static_cast<int>(kind)) + "'");
+  }
+
+  return Status::Success;
+}
+
+const char*
+CacheEvictionPolicyKindString(const CacheEvictionPolicy::Kind kind)
+{
+  switch (kind) {
+    case CacheEvictionPolicy::Kind::LRU:
+      return "LRU";
+    case CacheEvictionPolicy::Kind::TINY_LFU:
+      return "TINY_LFU";
+    case CacheEvictionPolicy::Kind::SIZE_AWARE:
+      return "SIZE_AWARE";
+  }
+
+  return "<unknown>";
+}
+
+//
+// LRUEvictionPolicy
+//
+void
+LRUEvictionPolicy::OnHit(const uint64_t key)
+{
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+  }
+}
+
+void
+LRUEvictionPolicy::OnInsert(const uint64_t key, const uint64_t byte_size)
+{
+  lru_.push_front(key);
+  index_[key] = lru_.begin();
+}
+
+bool
+LRUEvictionPolicy::Evict(uint64_t* key)
+{
+  if (lru_.empty()) {
+    return false;
+  }
+
+  *key = lru_.back();
+  index_.erase(*key);
+  lru_.pop_back();
+  return true;
+}
+
+void
+LRUEvictionPolicy::OnErase(const uint64_t key)
+{
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+}
+
+void
+LRUEvictionPolicy::EvictionOrder(std::vector<uint64_t>* keys) const
+{
+  keys->insert(keys->end(), lru_.rbegin(), lru_.rend());
+}
+
+//
+// FrequencySketch
+//
+FrequencySketch::FrequencySketch(const size_t min_width) : additions_(0)
+{
+  size_t width = kMinSketchWidth;
+  while ((width < min_width) && (width < kMaxSketchWidth)) {
+    width <<= 1;
+  }
+  width_mask_ = width - 1;
+  sample_size_ = 10 * width;
+  table_.resize(kDepth * width, 0);
+}
+
+size_t
+FrequencySketch::Index(const uint64_t key, const size_t row) const
+{
+  static constexpr uint64_t kSeeds[kDepth] = {
+      0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+      0xcbf29ce484222325ULL};
+  uint64_t h = (key + kSeeds[row]) * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 32;
+  return (row * (width_mask_ + 1)) + (h & width_mask_);
+}
+
+void
+FrequencySketch::Increment(const uint64_t key)
+{
+  for (size_t row = 0; row < kDepth; ++row) {
+    uint8_t& count = table_[Index(key, row)];
+    if (count < kMaxCount) {
+      ++count;
+    }
+  }
+
+  if (++additions_ >= sample_size_) {
+    Reset();
+  }
+}
+
+uint32_t
+FrequencySketch::Frequency(const uint64_t key) const
+{
+  uint32_t frequency = kMaxCount;
+  for (size_t row = 0; row < kDepth; ++row) {
+    frequency = std::min<uint32_t>(frequency, table_[Index(key, row)]);
+  }
+  return frequency;
+}
+
+void
+FrequencySketch::Reset()
+{
+  for (auto& count : table_) {
+    count >>= 1;
+  }
+  additions_ /= 2;
+}
+
+//
+// TinyLFUEvictionPolicy
+//
+TinyLFUEvictionPolicy::TinyLFUEvictionPolicy(const uint64_t capacity)
+    : window_capacity_(capacity / 100),
+      protected_capacity_((capacity - (capacity / 100)) * 4 / 5),
+      sketch_(static_cast<size_t>(std::min<uint64_t>(
+          capacity / kExpectedEntryByteSize, kMaxSketchWidth))),
+      window_bytes_(0), probation_bytes_(0), protected_bytes_(0)
+{
+}
+
+std::list<uint64_t>&
+TinyLFUEvictionPolicy::SegmentList(const Segment segment)
+{
+  switch (segment) {
+    case Segment::WINDOW:
+      return window_;
+    case Segment::PROBATION:
+      return probation_;
+    case Segment::PROTECTED:
+    default:
+      return protected_;
+  }
+}
+
+uint64_t&
+TinyLFUEvictionPolicy::SegmentBytes(const Segment segment)
+{
+  switch (segment) {
+    case Segment::WINDOW:
+      return window_bytes_;
+    case Segment::PROBATION:
+      return probation_bytes_;
+    case Segment::PROTECTED:
+    default:
+      return protected_bytes_;
+  }
+}
+
+void
+TinyLFUEvictionPolicy::MoveTo(
+    const uint64_t key, Node* node, const Segment segment)
+{
+  auto& to = SegmentList(segment);
+  if (node->segment_ == segment) {
+    to.splice(to.begin(), to, node->iter_);
+    return;
+  }
+
+  SegmentList(node->segment_).erase(node->iter_);
+  SegmentBytes(node->segment_) -= node->byte_size_;
+  to.push_front(key);
+  SegmentBytes(segment) += node->byte_size_;
+  node->iter_ = to.begin();
+  node->segment_ = segment;
+}
+
+void
+TinyLFUEvictionPolicy::Remove(const uint64_t key)
+{
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    SegmentList(it->second.segment_).erase(it->second.iter_);
+    SegmentBytes(it->second.segment_) -= it->second.byte_size_;
+    index_.erase(it);
+  }
+}
+
+void
+TinyLFUEvictionPolicy::OnHit(const uint64_t key)
+{
+  sketch_.Increment(key);
+
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+
+  Node& node = it->second;
+  switch (node.segment_) {
+    case Segment::WINDOW:
+    case Segment::PROTECTED:
+      MoveTo(key, &node, node.segment_);
+      break;
+    case Segment::PROBATION:
+      // A hit in probation promotes the entry, demoting the least recently
+      // used protected entries if the protected segment overflows
+      node.candidate_ = false;
+      MoveTo(key, &node, Segment::PROTECTED);
+      while ((protected_bytes_ > protected_capacity_) &&
+             (protected_.size() > 1)) {
+        const uint64_t demoted = protected_.back();
+        MoveTo(demoted, &index_[demoted], Segment::PROBATION);
+      }
+      break;
+  }
+}
+
+void
+TinyLFUEvictionPolicy::OnMiss(const uint64_t key)
+{
+  sketch_.Increment(key);
+}
+
+void
+TinyLFUEvictionPolicy::OnInsert(const uint64_t key, const uint64_t byte_size)
+{
+  Remove(key);
+
+  window_.push_front(key);
+  window_bytes_ += byte_size;
+  index_[key] = Node{Segment::WINDOW, window_.begin(), byte_size, false};
+
+  // Entries that overflow the window become candidates for admission to
+  // the main segments, the window always keeps the newest entry
+  while ((window_bytes_ > window_capacity_) && (window_.size() > 1)) {
+    const uint64_t overflow = window_.back();
+    Node& node = index_[overflow];
+    MoveTo(overflow, &node, Segment::PROBATION);
+    node.candidate_ = true;
+  }
+}
+
+bool
+TinyLFUEvictionPolicy::Evict(uint64_t* key)
+{
+  if (index_.empty()) {
+    return false;
+  }
+
+  if (!probation_.empty()) {
+    // The newest candidate in probation competes against the probation
+    // victim and is evicted instead unless it is used more frequently
+    *key = probation_.back();
+    const uint64_t candidate = probation_.front();
+    Node& node = index_[candidate];
+    if ((candidate != *key) && node.candidate_) {
+      node.candidate_ = false;
+      if (sketch_.Frequency(candidate) <= sketch_.Frequency(*key)) {
+        *key = candidate;
+      }
+    }
+  } else if (!protected_.empty()) {
+    *key = protected_.back();
+  } else {
+    *key = window_.back();
+  }
+
+  Remove(*key);
+  return true;
+}
+
+void
+TinyLFUEvictionPolicy::OnErase(const uint64_t key)
+{
+  Remove(key);
+}
+
+void
+TinyLFUEvictionPolicy::EvictionOrder(std::vector<uint64_t>* keys) const
+{
+  // Probation is evicted from first, then the protected segment and the
+  // window last
+  keys->insert(keys->end(), probation_.rbegin(), probation_.rend());
+  keys->insert(keys->end(), protected_.rbegin(), protected_.rend());
+  keys->insert(keys->end(), window_.rbegin(), window_.rend());
+}
+
+//
+// SizeAwareEvictionPolicy
+//
+void
+SizeAwareEvictionPolicy::Prioritize(const uint64_t key, Node* node)
+{
+  if (node->iter_ != priorities_.end()) {
+    priorities_.erase(node->iter_);
+  }
+  const double priority =
+      clock_ + (static_cast<double>(node->frequency_) / node->byte_size_);
+  node->iter_ = priorities_.emplace(priority, key).first;
+}
+
+void
+SizeAwareEvictionPolicy::OnHit(const uint64_t key)
+{
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second.frequency_++;
+    Prioritize(key, &it->second);
+  }
+}
+
+void
+SizeAwareEvictionPolicy::OnInsert(const uint64_t key, const uint64_t byte_size)
+{
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    it = index_.emplace(key, Node{0, 0, priorities_.end()}).first;
+  }
+  it->second.frequency_ = 1;
+  it->second.byte_size_ = std::max<uint64_t>(byte_size, 1);
+  Prioritize(key, &it->second);
+}
+
+bool
+SizeAwareEvictionPolicy::Evict(uint64_t* key)
+{
+  if (priorities_.empty()) {
+    return false;
+  }
+
+  auto victim = priorities_.begin();
+  clock_ = victim->first;
+  *key = victim->second;
+  priorities_.erase(victim);
+  index_.erase(*key);
+  return true;
+}
+
+void
+SizeAwareEvictionPolicy::OnErase(const uint64_t key)
+{
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    priorities_.erase(it->second.iter_);
+    index_.erase(it);
+  }
+}
+
+void
+SizeAwareEvictionPolicy::EvictionOrder(std::vector<uint64_t>* keys) const
+{
+  for (const auto& priority : priorities_) {
+    keys->push_back(priority.second);
+  }
+}
+
+}}  // namespace triton::core
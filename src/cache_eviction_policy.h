@@ -0,0 +1,210 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "status.h"
+
+namespace triton { namespace core {
+
+//
+// Interface of the policy that decides which entry of a response cache
+// shard is evicted when space is needed. The policy only tracks keys
+// and entry sizes, the cache owns the entries themselves. A policy is
+// not thread-safe, the caller must serialize all calls (the response
+// cache calls it with the shard lock held).
+//
+class CacheEvictionPolicy {
+ public:
+  enum class Kind { LRU, TINY_LFU, SIZE_AWARE };
+
+  // Create a policy of 'kind' for a cache of 'capacity' bytes.
+  static Status Create(
+      const Kind kind, const uint64_t capacity,
+      std::unique_ptr<CacheEvictionPolicy>* policy);
+
+  virtual ~CacheEvictionPolicy() = default;
+
+  // Record a lookup of 'key' that hit an entry tracked by the policy.
+  virtual void OnHit(const uint64_t key) = 0;
+  // Record a lookup of 'key' that missed.
+  virtual void OnMiss(const uint64_t key) {}
+  // Start tracking a new entry 'key' of 'byte_size' bytes.
+  virtual void OnInsert(const uint64_t key, const uint64_t byte_size) = 0;
+  // Select the entry to evict and stop tracking it. Return false if no
+  // entry is tracked.
+  virtual bool Evict(uint64_t* key) = 0;
+  // Stop tracking 'key', removed by the cache without being selected by
+  // Evict().
+  virtual void OnErase(const uint64_t key) = 0;
+  // Returns the number of entries tracked by the policy.
+  virtual size_t Size() const = 0;
+  // Append the tracked keys to 'keys', ordered from the next entry to be
+  // evicted to the entry that would be evicted last. Inserting the keys
+  // in this order into an empty policy approximates the current state.
+  virtual void EvictionOrder(std::vector<uint64_t>* keys) const = 0;
+};
+
+// Returns the name of the eviction policy 'kind'.
+const char* CacheEvictionPolicyKindString(
+    const CacheEvictionPolicy::Kind kind);
+
+//
+// Evict the least recently used entry.
+//
+class LRUEvictionPolicy : public CacheEvictionPolicy {
+ public:
+  void OnHit(const uint64_t key) override;
+  void OnInsert(const uint64_t key, const uint64_t byte_size) override;
+  bool Evict(uint64_t* key) override;
+  void OnErase(const uint64_t key) override;
+  size_t Size() const override { return lru_.size(); }
+  void EvictionOrder(std::vector<uint64_t>* keys) const override;
+
+ private:
+  // List of keys sorted from most to least recently used
+  std::list<uint64_t> lru_;
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> index_;
+};
+
+//
+// Approximate access frequency of keys as a count-min sketch of
+// saturating 4-bit counters. All counters are halved once the number
+// of recorded accesses reaches ten times the sketch width so that the
+// estimate follows changes in popularity.
+//
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(const size_t min_width);
+
+  void Increment(const uint64_t key);
+  uint32_t Frequency(const uint64_t key) const;
+
+ private:
+  static constexpr size_t kDepth = 4;
+  static constexpr uint8_t kMaxCount = 15;
+
+  size_t Index(const uint64_t key, const size_t row) const;
+  void Reset();
+
+  size_t width_mask_;
+  size_t sample_size_;
+  size_t additions_;
+  std::vector<uint8_t> table_;
+};
+
+//
+// Window TinyLFU. New entries enter a small LRU window, entries that
+// overflow the window move to the probation segment of a segmented LRU
+// and are promoted to the protected segment when hit again. On eviction
+// the most recent arrival in probation is only kept if its estimated
+// frequency beats the probation victim's, so one-off entries can't
+// flush out frequently used ones.
+//
+class TinyLFUEvictionPolicy : public CacheEvictionPolicy {
+ public:
+  explicit TinyLFUEvictionPolicy(const uint64_t capacity);
+
+  void OnHit(const uint64_t key) override;
+  void OnMiss(const uint64_t key) override;
+  void OnInsert(const uint64_t key, const uint64_t byte_size) override;
+  bool Evict(uint64_t* key) override;
+  void OnErase(const uint64_t key) override;
+  size_t Size() const override { return index_.size(); }
+  void EvictionOrder(std::vector<uint64_t>* keys) const override;
+
+ private:
+  enum class Segment { WINDOW, PROBATION, PROTECTED };
+  struct Node {
+    Segment segment_;
+    std::list<uint64_t>::iterator iter_;
+    uint64_t byte_size_;
+    // Whether the entry has moved from the window to probation but has
+    // not been compared against a victim yet
+    bool candidate_;
+  };
+
+  std::list<uint64_t>& SegmentList(const Segment segment);
+  uint64_t& SegmentBytes(const Segment segment);
+  // Move 'key' to the front of 'segment'
+  void MoveTo(const uint64_t key, Node* node, const Segment segment);
+  void Remove(const uint64_t key);
+
+  const uint64_t window_capacity_;
+  const uint64_t protected_capacity_;
+  FrequencySketch sketch_;
+  // Lists of keys sorted from most to least recently used per segment
+  std::list<uint64_t> window_;
+  std::list<uint64_t> probation_;
+  std::list<uint64_t> protected_;
+  uint64_t window_bytes_;
+  uint64_t probation_bytes_;
+  uint64_t protected_bytes_;
+  std::unordered_map<uint64_t, Node> index_;
+};
+
+//
+// Greedy-Dual-Size-Frequency. Each entry has priority
+// 'clock + frequency / byte_size' and the lowest priority entry is
+// evicted, advancing 'clock' to its priority so that entries that have
+// not been hit in a while age out. Large entries must be hit much more
+// often than small ones to stay in the cache.
+//
+class SizeAwareEvictionPolicy : public CacheEvictionPolicy {
+ public:
+  SizeAwareEvictionPolicy() : clock_(0) {}
+
+  void OnHit(const uint64_t key) override;
+  void OnInsert(const uint64_t key, const uint64_t byte_size) override;
+  bool Evict(uint64_t* key) override;
+  void OnErase(const uint64_t key) override;
+  size_t Size() const override { return index_.size(); }
+  void EvictionOrder(std::vector<uint64_t>* keys) const override;
+
+ private:
+  using Priority = std::pair<double, uint64_t>;
+  struct Node {
+    uint64_t frequency_;
+    uint64_t byte_size_;
+    std::set<Priority>::iterator iter_;
+  };
+
+  void Prioritize(const uint64_t key, Node* node);
+
+  double clock_;
+  std::set<Priority> priorities_;
+  std::unordered_map<uint64_t, Node> index_;
+};
+
+}}  // namespace triton::core
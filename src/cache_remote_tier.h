@@ -0,0 +1,62 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "status.h"
+
+namespace triton { namespace core {
+
+//
+// Interface of a remote tier shared by the response caches of several
+// servers, for example an adapter over a Redis or memcached client. The
+// local response cache is checked first and the remote tier is only
+// consulted on a local miss. Values are opaque byte strings serialized by
+// the response cache. An implementation must be thread-safe.
+//
+class CacheRemoteTier {
+ public:
+  // Called exactly once with the result of a Get(). 'found' is false if
+  // the key is not stored in the remote tier.
+  using GetCallback = std::function<void(
+      const Status& status, bool found, std::string&& value)>;
+
+  virtual ~CacheRemoteTier() = default;
+
+  // Start fetching the value of 'key' and return without waiting for it.
+  // 'callback' may be invoked from any thread, including after the cache
+  // stopped waiting for the result because its deadline expired.
+  virtual void Get(const std::string& key, GetCallback callback) = 0;
+
+  // Store 'value' under 'key'. Called from the write-back thread of the
+  // response cache, so the call may block until the value is stored.
+  virtual Status Put(const std::string& key, const std::string& value) = 0;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,534 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "collated_batch.h"
+
+#include "copy_batch.h"
+#include "cuda_utils.h"
+#include "infer_request.h"
+#include "precision_convert.h"
+#include "triton/common/logging.h"
+#include "triton/common/model_config.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+// Append 'values' converted to 'T' to 'bytes'.
+template <typename T>
+void
+AppendValues(const std::vector<int64_t>& values, std::vector<char>* bytes)
+{
+  for (const auto value : values) {
+    const T converted = static_cast<T>(value);
+    const char* begin = reinterpret_cast<const char*>(&converted);
+    bytes->insert(bytes->end(), begin, begin + sizeof(T));
+  }
+}
+
+// Convert the 'count' FP32 values at 'src' to 'dtype' at 'dst'.
+void
+ConvertValues(
+    const char* src, const size_t count, const inference::DataType dtype,
+    char* dst)
+{
+  const float* values = reinterpret_cast<const float*>(src);
+  uint16_t* converted = reinterpret_cast<uint16_t*>(dst);
+  if (dtype == inference::DataType::TYPE_FP16) {
+    FloatToHalf(values, count, converted);
+  } else {
+    FloatToBFloat16(values, count, converted);
+  }
+}
+
+}  // namespace
+
+CollatedBatch::CollatedBatch()
+    : cuda_stream_(0),
+#ifdef TRITON_ENABLE_GPU
+      copy_event_(nullptr),
+#endif  // TRITON_ENABLE_GPU
+      pending_(false)
+{
+}
+
+CollatedBatch::~CollatedBatch()
+{
+  // The buffers must not be released while the copies are in flight
+  Status status = Wait();
+  if (!status.IsOk()) {
+    LOG_ERROR << status.Message();
+  }
+#ifdef TRITON_ENABLE_GPU
+  if (copy_event_ != nullptr) {
+    cudaEventDestroy(copy_event_);
+  }
+#endif  // TRITON_ENABLE_GPU
+}
+
+Status
+CollatedBatch::Create(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const inference::ModelConfig& config, const InputConversions& conversions,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    cudaStream_t cuda_stream, std::shared_ptr<CollatedBatch>* batch)
+{
+  return Collate(
+      requests, config, conversions, memory_type, memory_type_id, cuda_stream,
+      true /* synchronous */, batch);
+}
+
+Status
+CollatedBatch::CreateAsync(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const inference::ModelConfig& config, const InputConversions& conversions,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    cudaStream_t cuda_stream, std::shared_ptr<CollatedBatch>* batch)
+{
+  return Collate(
+      requests, config, conversions, memory_type, memory_type_id, cuda_stream,
+      false /* synchronous */, batch);
+}
+
+Status
+CollatedBatch::Wait()
+{
+#ifdef TRITON_ENABLE_GPU
+  if (pending_) {
+    pending_ = false;
+    if (copy_event_ != nullptr) {
+      RETURN_IF_CUDA_ERR(
+          cudaEventSynchronize(copy_event_),
+          std::string("failed to collate inputs"));
+    } else {
+      RETURN_IF_CUDA_ERR(
+          cudaStreamSynchronize(cuda_stream_),
+          std::string("failed to collate inputs"));
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+  copies_.reset();
+  batch_input_values_.clear();
+  converted_inputs_.clear();
+  return Status::Success;
+}
+
+Status
+CollatedBatch::Collate(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const inference::ModelConfig& config, const InputConversions& conversions,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    cudaStream_t cuda_stream, const bool synchronous,
+    std::shared_ptr<CollatedBatch>* batch)
+{
+  batch->reset();
+  if (requests.empty()) {
+    return Status::Success;
+  }
+
+  std::shared_ptr<CollatedBatch> local_batch(new CollatedBatch());
+  local_batch->cuda_stream_ = cuda_stream;
+  std::unordered_set<std::string> ragged_inputs;
+  for (const auto& input : config.input()) {
+    if (input.allow_ragged_batch()) {
+      ragged_inputs.insert(input.name());
+    }
+  }
+
+  // The copies of all the inputs are issued together so that the small
+  // buffers of the requests are gathered into as few CUDA copies as possible.
+  local_batch->copies_.reset(new CopyBatch("collate inputs", cuda_stream));
+  CopyBatch& copies = *local_batch->copies_;
+  for (const auto& pr : requests.front()->ImmutableInputs()) {
+    const std::string& name = pr.input_->Name();
+    const bool ragged = (ragged_inputs.find(name) != ragged_inputs.end());
+    if (!IsCollatable(requests, name, ragged)) {
+      continue;
+    }
+
+    size_t total_byte_size = 0;
+    for (const auto& request : requests) {
+      const auto& data = request->ImmutableInputs().find(name)->input_->Data();
+      total_byte_size += data->TotalByteSize();
+    }
+    if (total_byte_size == 0) {
+      continue;
+    }
+
+    // A converted input is halved in size, FP16 and BF16 both taking two
+    // bytes per FP32 element.
+    const auto convert_it = conversions.find(name);
+    bool convert = (convert_it != conversions.end());
+    if (convert && !IsConvertible(requests, name)) {
+      LOG_VERBOSE(1) << "input '" << name << "' can't be converted on the "
+                     << "host, gathering it without conversion";
+      convert = false;
+    }
+    if (convert) {
+      total_byte_size /= 2;
+    } else if (PassThrough(
+                   requests, name, memory_type, memory_type_id,
+                   local_batch.get())) {
+      continue;
+    }
+    std::unique_ptr<AllocatedMemory> memory(
+        new AllocatedMemory(total_byte_size, memory_type, memory_type_id));
+    TRITONSERVER_MemoryType dst_memory_type;
+    int64_t dst_memory_type_id;
+    char* dst = memory->MutableBuffer(&dst_memory_type, &dst_memory_type_id);
+    if (dst == nullptr) {
+      LOG_VERBOSE(1) << "failed to allocate collated buffer for input '"
+                     << name << "', backend will gather the input";
+      continue;
+    }
+
+    // The conversion writes into the buffer directly if it is in host
+    // memory, otherwise into a pinned buffer copied along with the inputs.
+    char* converted = dst;
+    std::unique_ptr<AllocatedMemory> staging;
+    if (convert && (dst_memory_type == TRITONSERVER_MEMORY_GPU)) {
+      staging.reset(new AllocatedMemory(
+          total_byte_size, TRITONSERVER_MEMORY_CPU_PINNED,
+          0 /* memory_type_id */));
+      TRITONSERVER_MemoryType staging_memory_type;
+      int64_t staging_memory_type_id;
+      converted = staging->MutableBuffer(
+          &staging_memory_type, &staging_memory_type_id);
+      if (converted == nullptr) {
+        LOG_VERBOSE(1) << "failed to allocate conversion buffer for input '"
+                       << name << "', backend will gather the input";
+        continue;
+      }
+    }
+
+    // One pass over the buffers of the requests in order
+    Tensor tensor;
+    tensor.datatype_ = convert ? convert_it->second : pr.input_->DType();
+    tensor.offsets_.reserve(requests.size() + 1);
+    size_t offset = 0;
+    for (const auto& request : requests) {
+      tensor.offsets_.push_back(offset);
+      const auto& data = request->ImmutableInputs().find(name)->input_->Data();
+      for (size_t idx = 0; idx < data->BufferCount(); ++idx) {
+        size_t src_byte_size;
+        TRITONSERVER_MemoryType src_memory_type;
+        int64_t src_memory_type_id;
+        const char* src = data->BufferAt(
+            idx, &src_byte_size, &src_memory_type, &src_memory_type_id);
+        if (convert) {
+          ConvertValues(
+              src, src_byte_size / sizeof(float), convert_it->second,
+              converted + offset);
+          offset += src_byte_size / 2;
+        } else {
+          copies.Add(
+              src_memory_type, src_memory_type_id, dst_memory_type,
+              dst_memory_type_id, src_byte_size, src, dst + offset);
+          offset += src_byte_size;
+        }
+      }
+    }
+    tensor.offsets_.push_back(offset);
+    if (staging != nullptr) {
+      copies.Add(
+          TRITONSERVER_MEMORY_CPU_PINNED, 0 /* memory_type_id */,
+          dst_memory_type, dst_memory_type_id, total_byte_size, converted,
+          dst);
+      local_batch->converted_inputs_.emplace_back(std::move(staging));
+    }
+    tensor.memory_ = std::move(memory);
+    local_batch->inputs_.emplace(name, std::move(tensor));
+  }
+
+  // The batch inputs are computed on the host and copied along with the
+  // inputs, 'batch_input_values' holds the host values until then.
+  auto& batch_input_values = local_batch->batch_input_values_;
+  batch_input_values.reserve(config.batch_input_size());
+  for (const auto& batch_input : config.batch_input()) {
+    std::vector<char> values;
+    if (!BatchInputValues(requests, batch_input, &values) || values.empty()) {
+      continue;
+    }
+    batch_input_values.emplace_back(std::move(values));
+    const auto& host_values = batch_input_values.back();
+    for (const auto& target_name : batch_input.target_name()) {
+      std::unique_ptr<AllocatedMemory> memory(new AllocatedMemory(
+          host_values.size(), memory_type, memory_type_id));
+      TRITONSERVER_MemoryType dst_memory_type;
+      int64_t dst_memory_type_id;
+      char* dst = memory->MutableBuffer(&dst_memory_type, &dst_memory_type_id);
+      if (dst == nullptr) {
+        continue;
+      }
+      copies.Add(
+          TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */, dst_memory_type,
+          dst_memory_type_id, host_values.size(), host_values.data(), dst);
+      auto& tensor = local_batch->inputs_[target_name];
+      tensor.memory_ = std::move(memory);
+      tensor.datatype_ = batch_input.data_type();
+    }
+  }
+
+  // On failure some copies may still be in flight, the batch waits for
+  // them before releasing the buffers.
+  bool cuda_used = false;
+  Status status = copies.Flush(&cuda_used);
+  local_batch->pending_ = cuda_used || !status.IsOk();
+  RETURN_IF_ERROR(status);
+#ifdef TRITON_ENABLE_GPU
+  // The stream of an asynchronous batch may be shared with the copies of
+  // other batches so the completion of the batch is tracked by an event.
+  if (cuda_used && !synchronous) {
+    cudaError_t err = cudaEventCreateWithFlags(
+        &local_batch->copy_event_, cudaEventDisableTiming);
+    if (err == cudaSuccess) {
+      err = cudaEventRecord(local_batch->copy_event_, cuda_stream);
+    }
+    if (err != cudaSuccess) {
+      LOG_VERBOSE(1) << "failed to record collate event, waiting for the "
+                     << "copies: " << cudaGetErrorString(err);
+      if (local_batch->copy_event_ != nullptr) {
+        cudaEventDestroy(local_batch->copy_event_);
+        local_batch->copy_event_ = nullptr;
+      }
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+  if (synchronous || !cuda_used) {
+    RETURN_IF_ERROR(local_batch->Wait());
+  }
+
+  if (!local_batch->inputs_.empty()) {
+    *batch = std::move(local_batch);
+  }
+  return Status::Success;
+}
+
+bool
+CollatedBatch::IsCollatable(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const std::string& name, const bool ragged)
+{
+  const InferenceRequest::Input* first_input = nullptr;
+  for (const auto& request : requests) {
+    const auto& inputs = request->ImmutableInputs();
+    const auto it = inputs.find(name);
+    if (it == inputs.end()) {
+      return false;
+    }
+    const InferenceRequest::Input* input = it->input_;
+    // Shape tensors and host policy specific data are handled by the
+    // backend, and the byte size of string elements may differ.
+    if (input->IsShapeTensor() || input->HasHostPolicySpecificData() ||
+        (input->DType() == inference::DataType::TYPE_STRING)) {
+      return false;
+    }
+    if (first_input == nullptr) {
+      first_input = input;
+    } else if (
+        (input->DType() != first_input->DType()) ||
+        (!ragged && (input->Shape() != first_input->Shape()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+CollatedBatch::IsConvertible(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const std::string& name)
+{
+  // IsCollatable() checked that the datatype is the same in all requests
+  const auto& first_input = requests.front()->ImmutableInputs().find(name);
+  if (first_input->input_->DType() != inference::DataType::TYPE_FP32) {
+    return false;
+  }
+  for (const auto& request : requests) {
+    const auto& data = request->ImmutableInputs().find(name)->input_->Data();
+    for (size_t idx = 0; idx < data->BufferCount(); ++idx) {
+      size_t byte_size;
+      TRITONSERVER_MemoryType memory_type;
+      int64_t memory_type_id;
+      data->BufferAt(idx, &byte_size, &memory_type, &memory_type_id);
+      if ((memory_type == TRITONSERVER_MEMORY_GPU) ||
+          ((byte_size % sizeof(float)) != 0)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool
+CollatedBatch::PassThrough(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const std::string& name, const TRITONSERVER_MemoryType memory_type,
+    const int64_t memory_type_id, CollatedBatch* batch)
+{
+  if (requests.size() != 1) {
+    return false;
+  }
+  const InferenceRequest::Input* input =
+      requests.front()->ImmutableInputs().find(name)->input_;
+  const auto& data = input->Data();
+  if (data->BufferCount() != 1) {
+    return false;
+  }
+  size_t byte_size;
+  TRITONSERVER_MemoryType src_memory_type;
+  int64_t src_memory_type_id;
+  const char* src =
+      data->BufferAt(0, &byte_size, &src_memory_type, &src_memory_type_id);
+  // Host buffers are used as is, a GPU buffer only on the preferred GPU
+  const bool src_on_gpu = (src_memory_type == TRITONSERVER_MEMORY_GPU);
+  const bool dst_on_gpu = (memory_type == TRITONSERVER_MEMORY_GPU);
+  if ((src_on_gpu != dst_on_gpu) ||
+      (src_on_gpu && (src_memory_type_id != memory_type_id))) {
+    return false;
+  }
+
+  // The buffer is owned by the request, which outlives the batch
+  std::unique_ptr<MemoryReference> memory(new MemoryReference());
+  memory->AddBuffer(src, byte_size, src_memory_type, src_memory_type_id);
+  Tensor tensor;
+  tensor.memory_ = std::move(memory);
+  tensor.offsets_ = {0, byte_size};
+  tensor.datatype_ = input->DType();
+  batch->inputs_.emplace(name, std::move(tensor));
+  return true;
+}
+
+bool
+CollatedBatch::BatchInputValues(
+    const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+    const inference::BatchInput& batch_input, std::vector<char>* values)
+{
+  if (batch_input.source_input_size() != 1) {
+    return false;
+  }
+  const std::string& source_input = batch_input.source_input(0);
+
+  std::vector<int64_t> result;
+  if (batch_input.kind() ==
+      inference::BatchInput::BATCH_ACCUMULATED_ELEMENT_COUNT_WITH_ZERO) {
+    result.push_back(0);
+  }
+  int64_t accumulated_count = 0;
+  size_t item_rank = 0;
+  for (size_t idx = 0; idx < requests.size(); ++idx) {
+    const auto& inputs = requests[idx]->ImmutableInputs();
+    const auto it = inputs.find(source_input);
+    if (it == inputs.end()) {
+      return false;
+    }
+    const auto& shape = it->input_->Shape();
+    const auto& batch_shape = it->input_->ShapeWithBatchDim();
+    const int64_t element_count = triton::common::GetElementCount(batch_shape);
+    switch (batch_input.kind()) {
+      case inference::BatchInput::BATCH_ELEMENT_COUNT:
+        result.push_back(element_count);
+        break;
+      case inference::BatchInput::BATCH_ACCUMULATED_ELEMENT_COUNT:
+      case inference::BatchInput::BATCH_ACCUMULATED_ELEMENT_COUNT_WITH_ZERO:
+        accumulated_count += element_count;
+        result.push_back(accumulated_count);
+        break;
+      case inference::BatchInput::BATCH_ITEM_SHAPE:
+      case inference::BatchInput::BATCH_ITEM_SHAPE_FLATTEN: {
+        // The shape of every batch item, which must have the same rank
+        if ((idx != 0) && (shape.size() != item_rank)) {
+          return false;
+        }
+        item_rank = shape.size();
+        const int64_t item_count =
+            (batch_shape.size() > shape.size()) ? batch_shape[0] : 1;
+        for (int64_t item = 0; item < item_count; ++item) {
+          result.insert(result.end(), shape.begin(), shape.end());
+        }
+        break;
+      }
+      default:
+        // The shape of BATCH_MAX_ELEMENT_COUNT_AS_SHAPE is its content.
+        return false;
+    }
+  }
+
+  switch (batch_input.data_type()) {
+    case inference::DataType::TYPE_INT32:
+      AppendValues<int32_t>(result, values);
+      break;
+    case inference::DataType::TYPE_INT64:
+      AppendValues<int64_t>(result, values);
+      break;
+    case inference::DataType::TYPE_FP32:
+      AppendValues<float>(result, values);
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+bool
+CollatedBatch::Input(
+    const std::string& name, const void** buffer, size_t* byte_size,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id) const
+{
+  const auto it = inputs_.find(name);
+  if (it == inputs_.end()) {
+    return false;
+  }
+  *buffer =
+      it->second.memory_->BufferAt(0, byte_size, memory_type, memory_type_id);
+  return true;
+}
+
+bool
+CollatedBatch::InputOffsets(
+    const std::string& name, const std::vector<uint64_t>** offsets) const
+{
+  const auto it = inputs_.find(name);
+  if ((it == inputs_.end()) || it->second.offsets_.empty()) {
+    return false;
+  }
+  *offsets = &it->second.offsets_;
+  return true;
+}
+
+bool
+CollatedBatch::InputDatatype(
+    const std::string& name, inference::DataType* datatype) const
+{
+  const auto it = inputs_.find(name);
+  if (it == inputs_.end()) {
+    return false;
+  }
+  *datatype = it->second.datatype_;
+  return true;
+}
+
+}}  // namespace triton::core
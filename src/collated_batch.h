@@ -0,0 +1,172 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "cuda_utils.h"
+#include "memory.h"
+#include "model_config.pb.h"
+#include "status.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+class CopyBatch;
+class InferenceRequest;
+
+// The datatype, TYPE_FP16 or TYPE_BF16, that the FP32 inputs of a batch
+// are converted to while they are gathered, keyed by input name.
+using InputConversions = std::unordered_map<std::string, inference::DataType>;
+
+//
+// The inputs of a batch of requests gathered into one contiguous buffer
+// per input, with the data of each request following the data of the
+// previous request in the batch. The input of a batch with a single
+// request is used as is if it is already in one buffer. The inputs that
+// allow ragged batches are gathered even if their shape differs between
+// the requests, along with the batch inputs of the model configuration
+// computed from them.
+// The batch is shared by the requests so that the buffers live as long
+// as any of the requests.
+//
+class CollatedBatch {
+ public:
+  // Gather the inputs that have the same datatype and shape, excluding the
+  // batch dimension, in all 'requests' into buffers preferably allocated
+  // on 'memory_type' and 'memory_type_id'. The shape of the inputs that
+  // 'config' allows in ragged batches may differ, and the batch inputs
+  // of 'config' are computed as well. The inputs in 'conversions' are
+  // converted to the given datatype, which requires their data to be in
+  // host memory. The copies are issued on 'cuda_stream' and completed
+  // before returning. Inputs that can't be gathered are skipped, 'batch'
+  // returns nullptr if no input is gathered.
+  static Status Create(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const inference::ModelConfig& config,
+      const InputConversions& conversions,
+      const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+      cudaStream_t cuda_stream, std::shared_ptr<CollatedBatch>* batch);
+
+  // Same as Create() but the copies are issued on 'cuda_stream' without
+  // waiting for them to complete, Wait() must be called before any buffer
+  // of 'batch' is used.
+  static Status CreateAsync(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const inference::ModelConfig& config,
+      const InputConversions& conversions,
+      const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+      cudaStream_t cuda_stream, std::shared_ptr<CollatedBatch>* batch);
+
+  ~CollatedBatch();
+
+  // Wait for the copies of the batch to complete, does nothing if they
+  // are already completed.
+  Status Wait();
+
+  // Return the buffer holding input 'name' for the whole batch, 'name'
+  // may also be the target name of a batch input. Return false if the
+  // input is not gathered.
+  bool Input(
+      const std::string& name, const void** buffer, size_t* byte_size,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id) const;
+
+  // Return the byte offset of the data of each request in the buffer of
+  // input 'name', followed by the byte size of the buffer. Return false
+  // if the input is not gathered from the requests.
+  bool InputOffsets(
+      const std::string& name, const std::vector<uint64_t>** offsets) const;
+
+  // Return the datatype of the buffer of input 'name', which is the
+  // datatype the input is converted to if it is converted. Return false
+  // if the input is not gathered.
+  bool InputDatatype(
+      const std::string& name, inference::DataType* datatype) const;
+
+ private:
+  CollatedBatch();
+
+  struct Tensor {
+    std::unique_ptr<Memory> memory_;
+    std::vector<uint64_t> offsets_;
+    inference::DataType datatype_ = inference::DataType::TYPE_INVALID;
+  };
+
+  static Status Collate(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const inference::ModelConfig& config,
+      const InputConversions& conversions,
+      const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+      cudaStream_t cuda_stream, const bool synchronous,
+      std::shared_ptr<CollatedBatch>* batch);
+
+  // Whether input 'name' can be gathered for all 'requests', the shape
+  // may differ if 'ragged' is true.
+  static bool IsCollatable(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const std::string& name, const bool ragged);
+
+  // Whether the collatable input 'name' of 'requests' can be converted
+  // on the host, which requires FP32 data in host memory.
+  static bool IsConvertible(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const std::string& name);
+
+  // Add input 'name' to 'batch' as the buffer of the request if 'requests'
+  // holds a single request whose input is in one buffer on the same kind
+  // of memory as 'memory_type' and 'memory_type_id', which then doesn't
+  // need to be copied. Return false if the input must be gathered.
+  static bool PassThrough(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const std::string& name, const TRITONSERVER_MemoryType memory_type,
+      const int64_t memory_type_id, CollatedBatch* batch);
+
+  // Return in 'values' the content of 'batch_input' for 'requests'.
+  // Return false if the batch input can't be computed.
+  static bool BatchInputValues(
+      const std::vector<std::unique_ptr<InferenceRequest>>& requests,
+      const inference::BatchInput& batch_input, std::vector<char>* values);
+
+  std::unordered_map<std::string, Tensor> inputs_;
+
+  // The copies in flight and the host values of the batch inputs and
+  // converted inputs they read from, released once the copies are
+  // completed. The copies are waited for on 'copy_event_' if set,
+  // otherwise on 'cuda_stream_'.
+  std::unique_ptr<CopyBatch> copies_;
+  std::vector<std::vector<char>> batch_input_values_;
+  std::vector<std::unique_ptr<AllocatedMemory>> converted_inputs_;
+  cudaStream_t cuda_stream_;
+#ifdef TRITON_ENABLE_GPU
+  cudaEvent_t copy_event_;
+#endif  // TRITON_ENABLE_GPU
+  bool pending_;
+};
+
+}}  // namespace triton::core
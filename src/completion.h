@@ -0,0 +1,99 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace triton { namespace core {
+
+//
+// One-shot completion carrying a value, a lighter replacement for a
+// std::promise / std::future pair when waiting is rare. Completing only
+// stores the value and a flag unless a waiter has registered, and nothing
+// is allocated so the object can be reused after Reset().
+//
+// Complete() and Wait() may be called concurrently from different threads,
+// Reset() must not be called concurrently with either.
+//
+template <typename T>
+class Completion {
+ public:
+  Completion() : value_(), completed_(false), waiting_(false) {}
+
+  // Make the completion pending again.
+  void Reset()
+  {
+    value_ = T();
+    completed_.store(false, std::memory_order_relaxed);
+    waiting_.store(false, std::memory_order_relaxed);
+  }
+
+  // Complete with 'value' and wake up the waiters if any.
+  void Complete(const T& value)
+  {
+    value_ = value;
+    completed_.store(true);
+    // Either the waiter sees the completion or the completion sees the
+    // waiter, in which case the lock ensures the notification isn't lost.
+    if (waiting_.load()) {
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+      }
+      cv_.notify_all();
+    }
+  }
+
+  // Block until completed and return the completion value.
+  const T& Wait()
+  {
+    if (!completed_.load(std::memory_order_acquire)) {
+      waiting_.store(true);
+      if (!completed_.load()) {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [this]() { return completed_.load(); });
+      }
+    }
+    return value_;
+  }
+
+  // Return true if completed.
+  bool IsCompleted() const
+  {
+    return completed_.load(std::memory_order_acquire);
+  }
+
+ private:
+  T value_;
+  std::atomic<bool> completed_;
+  std::atomic<bool> waiting_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
+}}  // namespace triton::core
@@ -72,14 +72,77 @@ constexpr char kModelConfigPbTxt[] = "config.pbtxt";
 constexpr char kMetricsLabelModelName[] = "model";
 constexpr char kMetricsLabelModelVersion[] = "version";
 constexpr char kMetricsLabelGpuUuid[] = "gpu_uuid";
+constexpr char kMetricsLabelMemoryType[] = "memory_type";
+constexpr char kMetricsLabelSequenceBatcher[] = "batcher";
+constexpr char kMetricsLabelPriorityLevel[] = "priority_level";
+constexpr char kMetricsLabelEnsembleStep[] = "step";
+constexpr char kMetricsLabelEnsembleStepModel[] = "step_model";
+constexpr char kMetricsLabelFileSystem[] = "filesystem";
 
 constexpr char kWarmupDataFolder[] = "warmup";
 constexpr char kInitialStateFolder[] = "initial_state";
 
+// Model config parameter that places the threads of the GPU instances, and
+// of the scheduler, on the NUMA node closest to the GPU.
+constexpr char kNumaAwarePlacementParameter[] = "numa_aware_placement";
+
+// Model config parameter that moves the implicit state of the sequences
+// idle for the given number of microseconds from GPU to system memory.
+constexpr char kSequenceStateOffloadParameter[] =
+    "sequence_state_offload_idle_microseconds";
+
+// Model config parameter that makes the oldest sequence batching strategy
+// form a batch for every execution from all the sequences with a ready
+// request, without waiting for preferred batch sizes or a queue delay.
+constexpr char kContinuousBatchingParameter[] =
+    "sequence_batching_continuous";
+
+// Model config parameter that places new sequences on the instances of the
+// GPU, and then of the instance, with the fewest sequences, preferring the
+// instance of the previous sequence with the same affinity request
+// parameter.
+constexpr char kLoadAwarePlacementParameter[] =
+    "sequence_batching_load_aware_placement";
+constexpr char kSequenceAffinityParameter[] = "sequence_affinity";
+
+// Model config parameter that limits the number of sequences waiting in the
+// backlog of the sequence batcher, new sequences are rejected beyond it.
+constexpr char kMaxBacklogSequencesParameter[] =
+    "sequence_batching_max_backlog_sequences";
+
+// Ensemble config parameter that holds the step requests for up to the
+// given number of microseconds so that the requests of concurrent ensemble
+// requests for the same composing model are executed together.
+constexpr char kEnsembleStepBatchingParameter[] =
+    "ensemble_step_batching_delay_microseconds";
+
+// Ensemble config parameter that limits the number of requests in flight
+// for each step of a decoupled ensemble. The responses produced beyond it
+// by the upstream steps wait until the step completes a previous request.
+constexpr char kEnsembleMaxInflightStepRequestsParameter[] =
+    "ensemble_max_inflight_step_requests";
+
+// Ensemble config parameter that sends each requested output in its own
+// response as soon as it is produced, which makes the ensemble decoupled.
+constexpr char kEnsembleEarlyOutputsParameter[] = "ensemble_early_outputs";
+
+// Ensemble config parameter that gates steps on a boolean ensemble tensor,
+// as a comma-separated list of '<step index>:<tensor>'. A step whose tensor
+// has no true element is skipped and produces zero-filled outputs, or empty
+// outputs for the dimensions of variable size.
+constexpr char kEnsembleStepConditionsParameter[] = "ensemble_step_conditions";
+
+// Model config parameter that shifts the requests for the latest version
+// from the previous versions to the newly loaded versions over the given
+// duration, instead of unloading the previous versions once the load
+// completes.
+constexpr char kVersionCutoverParameter[] = "version_cutover_milliseconds";
+
 constexpr uint64_t NANOS_PER_SECOND = 1000000000;
 constexpr uint64_t NANOS_PER_MILLIS = 1000000;
 constexpr int MAX_GRPC_MESSAGE_SIZE = INT32_MAX;
 constexpr uint64_t SEQUENCE_IDLE_DEFAULT_MICROSECONDS = 1000 * 1000;
+constexpr uint64_t SHARED_BUFFER_WAIT_TIMEOUT_MILLISECONDS = 10 * 60 * 1000;
 constexpr size_t STRING_CORRELATION_ID_MAX_LENGTH_BYTES = 128;
 constexpr size_t CUDA_IPC_STRUCT_SIZE = 64;
 
@@ -0,0 +1,217 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "copy_batch.h"
+
+#include <cstring>
+#include "pinned_memory_manager.h"
+#include "triton/common/logging.h"
+#include "triton/common/nvtx.h"
+
+namespace triton { namespace core {
+
+CopyBatch::CopyBatch(const std::string& msg, cudaStream_t cuda_stream)
+    : msg_(msg), cuda_stream_(cuda_stream), cuda_copy_count_(0)
+{
+}
+
+CopyBatch::~CopyBatch()
+{
+  if (staging_buffers_.empty()) {
+    return;
+  }
+#ifdef TRITON_ENABLE_GPU
+  cudaError_t err = cudaStreamSynchronize(cuda_stream_);
+  if (err != cudaSuccess) {
+    LOG_ERROR << msg_ << ": failed to synchronize before releasing staging "
+              << "buffers: " << cudaGetErrorString(err);
+  }
+#endif  // TRITON_ENABLE_GPU
+  for (void* buffer : staging_buffers_) {
+    LOG_STATUS_ERROR(
+        PinnedMemoryManager::Free(buffer),
+        msg_ + ": failed to release staging buffer");
+  }
+}
+
+void
+CopyBatch::Add(
+    const TRITONSERVER_MemoryType src_memory_type,
+    const int64_t src_memory_type_id,
+    const TRITONSERVER_MemoryType dst_memory_type,
+    const int64_t dst_memory_type_id, const size_t byte_size, const void* src,
+    void* dst)
+{
+  if (byte_size == 0) {
+    return;
+  }
+
+  const char* src_ptr = reinterpret_cast<const char*>(src);
+  char* dst_ptr = reinterpret_cast<char*>(dst);
+
+  // Extend the last region if the new one directly follows it in both the
+  // source and the destination.
+  if (!regions_.empty()) {
+    Region& last = regions_.back();
+    if ((last.src_memory_type_ == src_memory_type) &&
+        (last.src_memory_type_id_ == src_memory_type_id) &&
+        (last.dst_memory_type_ == dst_memory_type) &&
+        (last.dst_memory_type_id_ == dst_memory_type_id) &&
+        (last.src_ + last.byte_size_ == src_ptr) &&
+        (last.dst_ + last.byte_size_ == dst_ptr)) {
+      last.byte_size_ += byte_size;
+      return;
+    }
+  }
+
+  regions_.push_back(Region{src_memory_type, src_memory_type_id,
+                            dst_memory_type, dst_memory_type_id, byte_size,
+                            src_ptr, dst_ptr});
+}
+
+Status
+CopyBatch::Flush(bool* cuda_used)
+{
+  NVTX_RANGE(nvtx_, "CopyBatch::Flush");
+
+  *cuda_used = false;
+
+  Status status;
+  size_t idx = 0;
+  while (status.IsOk() && (idx < regions_.size())) {
+    // Find the run of gatherable regions with contiguous destinations that
+    // starts at 'idx'.
+    size_t end = idx + 1;
+    if (IsGatherable(regions_[idx])) {
+      while ((end < regions_.size()) && IsGatherable(regions_[end]) &&
+             (regions_[end].dst_memory_type_id_ ==
+              regions_[idx].dst_memory_type_id_) &&
+             (regions_[end].dst_ ==
+              regions_[end - 1].dst_ + regions_[end - 1].byte_size_)) {
+        ++end;
+      }
+    }
+
+    bool staged = false;
+    if ((end - idx) > 1) {
+      status = GatherCopy(idx, end, &staged);
+      *cuda_used |= staged;
+    }
+    for (; status.IsOk() && !staged && (idx < end); ++idx) {
+      bool cuda_copy = false;
+      status = DirectCopy(regions_[idx], &cuda_copy);
+      *cuda_used |= cuda_copy;
+    }
+    idx = end;
+  }
+
+  regions_.clear();
+  return status;
+}
+
+bool
+CopyBatch::IsGatherable(const Region& region)
+{
+#ifdef TRITON_ENABLE_GPU
+  return (region.src_memory_type_ == TRITONSERVER_MEMORY_CPU) &&
+         (region.dst_memory_type_ == TRITONSERVER_MEMORY_GPU) &&
+         (region.byte_size_ <= kGatherThreshold);
+#else
+  return false;
+#endif  // TRITON_ENABLE_GPU
+}
+
+Status
+CopyBatch::GatherCopy(size_t begin, size_t end, bool* staged)
+{
+  *staged = false;
+#ifdef TRITON_ENABLE_GPU
+  size_t total_byte_size = 0;
+  for (size_t idx = begin; idx < end; ++idx) {
+    total_byte_size += regions_[idx].byte_size_;
+  }
+
+  // Fall back to copying the regions one by one if there is no staging
+  // memory available.
+  void* buffer = nullptr;
+  TRITONSERVER_MemoryType buffer_memory_type;
+  Status status = PinnedMemoryManager::Alloc(
+      &buffer, total_byte_size, &buffer_memory_type,
+      true /* allow_nonpinned_fallback */);
+  if (!status.IsOk()) {
+    LOG_VERBOSE(1) << msg_ << ": no staging buffer for " << (end - begin)
+                   << " regions, copying them separately: "
+                   << status.Message();
+    return Status::Success;
+  }
+  staging_buffers_.push_back(buffer);
+
+  char* staging = reinterpret_cast<char*>(buffer);
+  for (size_t idx = begin; idx < end; ++idx) {
+    memcpy(staging, regions_[idx].src_, regions_[idx].byte_size_);
+    staging += regions_[idx].byte_size_;
+  }
+
+  RETURN_IF_CUDA_ERR(
+      cudaMemcpyAsync(
+          regions_[begin].dst_, buffer, total_byte_size,
+          cudaMemcpyHostToDevice, cuda_stream_),
+      msg_ + ": failed to perform CUDA copy");
+  ++cuda_copy_count_;
+  *staged = true;
+  return Status::Success;
+#else
+  return Status(
+      Status::Code::INTERNAL,
+      msg_ + ": try to use CUDA copy while GPU is not supported");
+#endif  // TRITON_ENABLE_GPU
+}
+
+Status
+CopyBatch::DirectCopy(const Region& region, bool* cuda_used)
+{
+  RETURN_IF_ERROR(CopyBuffer(
+      msg_, region.src_memory_type_, region.src_memory_type_id_,
+      region.dst_memory_type_, region.dst_memory_type_id_, region.byte_size_,
+      region.src_, region.dst_, cuda_stream_, cuda_used));
+  if (*cuda_used) {
+    ++cuda_copy_count_;
+  }
+  return Status::Success;
+}
+
+void
+CopyBatchHandler(
+    CopyBatch* batch, void* response_ptr,
+    triton::common::SyncQueue<std::tuple<Status, bool, void*>>*
+        completion_queue)
+{
+  bool cuda_used = false;
+  Status status = batch->Flush(&cuda_used);
+  completion_queue->Put(std::make_tuple(status, cuda_used, response_ptr));
+}
+
+}}  // namespace triton::core
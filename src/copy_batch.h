@@ -0,0 +1,120 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+#include "constants.h"
+#include "cuda_utils.h"
+#include "status.h"
+#include "triton/common/sync_queue.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+//
+// A batch of buffer copies that are issued together. Regions that are
+// contiguous in both the source and the destination are merged as they are
+// added, and on flush runs of small pageable host regions bound for the
+// same contiguous GPU destination are gathered into a single pinned staging
+// buffer so that they are transferred with one CUDA copy instead of one
+// copy per region.
+//
+class CopyBatch {
+ public:
+  // Regions at most this size are candidates for gathering into pinned
+  // staging memory.
+  static constexpr size_t kGatherThreshold = 64 * 1024;
+
+  // 'msg' is prepended to error messages, 'cuda_stream' is the stream all
+  // the CUDA copies of the batch are issued on.
+  CopyBatch(const std::string& msg, cudaStream_t cuda_stream);
+  ~CopyBatch();
+
+  // Add a copy of 'byte_size' bytes from 'src' to 'dst' to the batch. The
+  // buffers must remain valid until the copies of the batch are completed.
+  void Add(
+      const TRITONSERVER_MemoryType src_memory_type,
+      const int64_t src_memory_type_id,
+      const TRITONSERVER_MemoryType dst_memory_type,
+      const int64_t dst_memory_type_id, const size_t byte_size,
+      const void* src, void* dst);
+
+  // Issue all the copies added since the last flush. 'cuda_used' returns
+  // whether a CUDA copy is initiated, in which case the caller must
+  // synchronize on the stream before using the destination buffers.
+  Status Flush(bool* cuda_used);
+
+  // The number of regions pending after merging.
+  size_t RegionCount() const { return regions_.size(); }
+
+  // The number of CUDA copies issued by the batch so far.
+  size_t CudaCopyCount() const { return cuda_copy_count_; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CopyBatch);
+
+  struct Region {
+    TRITONSERVER_MemoryType src_memory_type_;
+    int64_t src_memory_type_id_;
+    TRITONSERVER_MemoryType dst_memory_type_;
+    int64_t dst_memory_type_id_;
+    size_t byte_size_;
+    const char* src_;
+    char* dst_;
+  };
+
+  // Whether 'region' is a small pageable host to GPU copy that may be
+  // gathered with its neighbours.
+  static bool IsGatherable(const Region& region);
+
+  // Copy the regions [begin, end), that have contiguous destinations,
+  // through a single pinned staging buffer. 'staged' returns false if no
+  // staging buffer is available, in which case nothing is copied.
+  Status GatherCopy(size_t begin, size_t end, bool* staged);
+
+  Status DirectCopy(const Region& region, bool* cuda_used);
+
+  const std::string msg_;
+  cudaStream_t cuda_stream_;
+  std::vector<Region> regions_;
+
+  // Staging buffers can only be released once the copies out of them are
+  // completed.
+  std::vector<void*> staging_buffers_;
+  size_t cuda_copy_count_;
+};
+
+// Helper around CopyBatch::Flush that updates the completion queue once for
+// the whole batch with the returned status and cuda_used flag.
+void CopyBatchHandler(
+    CopyBatch* batch, void* response_ptr,
+    triton::common::SyncQueue<std::tuple<Status, bool, void*>>*
+        completion_queue);
+
+}}  // namespace triton::core
@@ -0,0 +1,59 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "cuda_graph_registry.h"
+
+namespace triton { namespace core {
+
+bool
+CudaGraphRegistry::Add(const size_t batch_size, const std::string& shape_key)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!signatures_.emplace(batch_size, shape_key).second) {
+    return false;
+  }
+  generation_++;
+  return true;
+}
+
+bool
+CudaGraphRegistry::Contains(
+    const size_t batch_size, const std::string& shape_key) const
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  return signatures_.find(std::make_pair(batch_size, shape_key)) !=
+         signatures_.end();
+}
+
+void
+CudaGraphRegistry::BatchSizes(std::set<int32_t>* batch_sizes) const
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  for (const auto& signature : signatures_) {
+    batch_sizes->insert(signature.first);
+  }
+}
+
+}}  // namespace triton::core
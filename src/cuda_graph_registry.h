@@ -0,0 +1,70 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace triton { namespace core {
+
+//
+// The batch signatures, a batch size and a key of the input shapes, that
+// a backend has captured a CUDA graph for on a model instance. The
+// backend reports its captures so that the dynamic batcher can favour
+// the batch sizes that replay a graph.
+//
+// The registry is thread-safe.
+//
+class CudaGraphRegistry {
+ public:
+  CudaGraphRegistry() : generation_(0) {}
+
+  // Record a graph captured for 'batch_size' and 'shape_key'. Return
+  // false if the signature was already recorded.
+  bool Add(const size_t batch_size, const std::string& shape_key);
+
+  // Return true if a graph is recorded for 'batch_size' and 'shape_key'.
+  bool Contains(const size_t batch_size, const std::string& shape_key) const;
+
+  // Add to 'batch_sizes' the batch sizes that have a graph for any shape.
+  void BatchSizes(std::set<int32_t>* batch_sizes) const;
+
+  // The number of recorded signatures, which can be polled without
+  // locking to detect new captures.
+  uint64_t Generation() const { return generation_; }
+
+ private:
+  mutable std::mutex mu_;
+  std::set<std::pair<size_t, std::string>> signatures_;
+  std::atomic<uint64_t> generation_;
+};
+
+}}  // namespace triton::core
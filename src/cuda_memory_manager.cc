@@ -61,6 +61,18 @@ std::mutex CudaMemoryManager::instance_mu_;
 
 CudaMemoryManager::~CudaMemoryManager()
 {
+#if CUDART_VERSION >= 11020
+  if (!mem_pools_.empty()) {
+    for (const auto& mem_pool : mem_pools_) {
+      auto err = cudaMemPoolDestroy(mem_pool.second);
+      if (err != cudaSuccess) {
+        LOG_ERROR << "Failed to destroy CUDA memory pool on GPU "
+                  << mem_pool.first << ": " << cudaGetErrorString(err);
+      }
+    }
+    return;
+  }
+#endif  // CUDART_VERSION >= 11020
   if (has_allocation_) {
     auto status = cnmemFinalize();
     if (status != CNMEM_STATUS_SUCCESS) {
@@ -91,7 +103,9 @@ CudaMemoryManager::Create(const CudaMemoryManager::Options& options)
   std::set<int> supported_gpus;
   auto status = GetSupportedGPUs(
       &supported_gpus, options.min_supported_compute_capability_);
-  if (status.IsOk()) {
+  if (status.IsOk() && options.stream_ordered_) {
+    return CreateStreamOrdered(options, supported_gpus);
+  } else if (status.IsOk()) {
     std::vector<cnmemDevice_t> devices;
     for (auto gpu : supported_gpus) {
       const auto it = options.memory_pool_byte_size_.find(gpu);
@@ -127,7 +141,135 @@ CudaMemoryManager::Create(const CudaMemoryManager::Options& options)
 }
 
 Status
-CudaMemoryManager::Alloc(void** ptr, uint64_t size, int64_t device_id)
+CudaMemoryManager::CreateStreamOrdered(
+    const Options& options, const std::set<int>& supported_gpus)
+{
+#if CUDART_VERSION >= 11020
+  std::unique_ptr<CudaMemoryManager> manager(new CudaMemoryManager(false));
+  for (auto gpu : supported_gpus) {
+    const auto it = options.memory_pool_byte_size_.find(gpu);
+    if ((it == options.memory_pool_byte_size_.end()) || (it->second == 0)) {
+      continue;
+    }
+
+    int supported = 0;
+    RETURN_IF_CUDA_ERR(
+        cudaDeviceGetAttribute(
+            &supported, cudaDevAttrMemoryPoolsSupported, gpu),
+        std::string("Failed to query memory pool support on GPU ") +
+            std::to_string(gpu));
+    if (supported == 0) {
+      return Status(
+          Status::Code::UNSUPPORTED,
+          "Failed to initialize CUDA memory manager: stream-ordered memory "
+          "pool is not supported on GPU " +
+              std::to_string(gpu));
+    }
+
+    cudaMemPoolProps props;
+    memset(&props, 0, sizeof(props));
+    props.allocType = cudaMemAllocationTypePinned;
+    props.location.type = cudaMemLocationTypeDevice;
+    props.location.id = gpu;
+    cudaMemPool_t mem_pool;
+    RETURN_IF_CUDA_ERR(
+        cudaMemPoolCreate(&mem_pool, &props),
+        std::string("Failed to create CUDA memory pool on GPU ") +
+            std::to_string(gpu));
+    // Owned by 'manager' so that it is destroyed if a later step fails
+    manager->mem_pools_.emplace(gpu, mem_pool);
+    manager->has_allocation_ = true;
+
+    uint64_t release_threshold = it->second;
+    RETURN_IF_CUDA_ERR(
+        cudaMemPoolSetAttribute(
+            mem_pool, cudaMemPoolAttrReleaseThreshold, &release_threshold),
+        std::string("Failed to set CUDA memory pool release threshold on "
+                    "GPU ") +
+            std::to_string(gpu));
+
+    LOG_INFO << "Stream-ordered CUDA memory pool is created on device " << gpu
+             << " with release threshold " << release_threshold;
+  }
+
+  if (!manager->has_allocation_) {
+    LOG_INFO << "CUDA memory pool disabled";
+  }
+  instance_ = std::move(manager);
+  return Status::Success;
+#else
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "Failed to initialize CUDA memory manager: stream-ordered memory pool "
+      "requires CUDA 11.2 or later");
+#endif  // CUDART_VERSION >= 11020
+}
+
+Status
+CudaMemoryManager::StreamOrderedAlloc(
+    void** ptr, uint64_t size, int64_t device_id, cudaStream_t stream)
+{
+#if CUDART_VERSION >= 11020
+  auto it = mem_pools_.find(device_id);
+  if (it == mem_pools_.end()) {
+    return Status(
+        Status::Code::UNAVAILABLE,
+        "CudaMemoryManager has no CUDA memory pool on GPU " +
+            std::to_string(device_id));
+  }
+
+  // Without a stream, allocate on the per-thread default stream and wait
+  // for it so the memory can be used on any stream, this doesn't wait for
+  // the work on the other streams.
+  cudaStream_t alloc_stream =
+      (stream == nullptr) ? cudaStreamPerThread : stream;
+  auto err = cudaMallocFromPoolAsync(ptr, size, it->second, alloc_stream);
+  if ((err == cudaSuccess) && (stream == nullptr)) {
+    err = cudaStreamSynchronize(alloc_stream);
+    if (err != cudaSuccess) {
+      cudaFreeAsync(*ptr, alloc_stream);
+    }
+  }
+  if (err != cudaSuccess) {
+    // Clear the error so that it isn't reported by an unrelated call
+    cudaGetLastError();
+    return Status(
+        Status::Code::INTERNAL,
+        std::string("Failed to allocate CUDA memory with byte size ") +
+            std::to_string(size) + " on GPU " + std::to_string(device_id) +
+            ": " + cudaGetErrorString(err));
+  }
+  return Status::Success;
+#else
+  return Status(
+      Status::Code::UNSUPPORTED, "stream-ordered memory pool not supported");
+#endif  // CUDART_VERSION >= 11020
+}
+
+Status
+CudaMemoryManager::StreamOrderedFree(
+    void* ptr, int64_t device_id, cudaStream_t stream)
+{
+#if CUDART_VERSION >= 11020
+  auto err =
+      cudaFreeAsync(ptr, (stream == nullptr) ? cudaStreamPerThread : stream);
+  if (err != cudaSuccess) {
+    return Status(
+        Status::Code::INTERNAL,
+        std::string("Failed to deallocate CUDA memory at address ") +
+            PointerToString(ptr) + " on GPU " + std::to_string(device_id) +
+            ": " + cudaGetErrorString(err));
+  }
+  return Status::Success;
+#else
+  return Status(
+      Status::Code::UNSUPPORTED, "stream-ordered memory pool not supported");
+#endif  // CUDART_VERSION >= 11020
+}
+
+Status
+CudaMemoryManager::Alloc(
+    void** ptr, uint64_t size, int64_t device_id, cudaStream_t stream)
 {
   if (instance_ == nullptr) {
     return Status(
@@ -148,6 +290,13 @@ CudaMemoryManager::Alloc(void** ptr, uint64_t size, int64_t device_id)
   }
 
   // Defer returning error to make sure the device is recovered
+  if (instance_->StreamOrdered()) {
+    auto status = instance_->StreamOrderedAlloc(ptr, size, device_id, stream);
+    if (overridden) {
+      cudaSetDevice(current_device);
+    }
+    return status;
+  }
   auto err = cnmemMalloc(ptr, size, nullptr);
 
   if (overridden) {
@@ -161,7 +310,7 @@ CudaMemoryManager::Alloc(void** ptr, uint64_t size, int64_t device_id)
 }
 
 Status
-CudaMemoryManager::Free(void* ptr, int64_t device_id)
+CudaMemoryManager::Free(void* ptr, int64_t device_id, cudaStream_t stream)
 {
   if (instance_ == nullptr) {
     return Status(
@@ -182,12 +331,30 @@ CudaMemoryManager::Free(void* ptr, int64_t device_id)
   }
 
   // Defer returning error to make sure the device is recovered
-  auto err = cnmemFree(ptr, nullptr);
+  if (instance_->StreamOrdered()) {
+    auto status = instance_->StreamOrderedFree(ptr, device_id, stream);
+    if (overridden) {
+      cudaSetDevice(current_device);
+    }
+    return status;
+  }
+  // CNMeM frees right away, wait for the work using the memory
+  cudaError_t cuerr = cudaSuccess;
+  if (stream != nullptr) {
+    cuerr = cudaStreamSynchronize(stream);
+  }
+  auto err = (cuerr == cudaSuccess) ? cnmemFree(ptr, nullptr)
+                                    : CNMEM_STATUS_SUCCESS;
 
   if (overridden) {
     cudaSetDevice(current_device);
   }
 
+  RETURN_IF_CUDA_ERR(
+      cuerr, std::string("Failed to synchronize stream before deallocating "
+                         "CUDA memory at address ") +
+                 PointerToString(ptr) + " on GPU " +
+                 std::to_string(device_id));
   RETURN_IF_CNMEM_ERROR(
       err, std::string("Failed to deallocate CUDA memory at address ") +
                PointerToString(ptr) + " on GPU " + std::to_string(device_id));
@@ -26,9 +26,11 @@
 //
 #pragma once
 
+#include <cuda_runtime_api.h>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include "status.h"
 
 namespace triton { namespace core {
@@ -40,8 +42,11 @@ class CudaMemoryManager {
  public:
   // Options to configure CUDA memory manager.
   struct Options {
-    Options(double cc = 6.0, const std::map<int, uint64_t>& s = {})
-        : min_supported_compute_capability_(cc), memory_pool_byte_size_(s)
+    Options(
+        double cc = 6.0, const std::map<int, uint64_t>& s = {},
+        bool stream_ordered = false)
+        : min_supported_compute_capability_(cc), memory_pool_byte_size_(s),
+          stream_ordered_(stream_ordered)
     {
     }
 
@@ -53,6 +58,13 @@ class CudaMemoryManager {
     // the default granularity (512 bytes).
     // No memory will be reserved for devices that is not listed.
     std::map<int, uint64_t> memory_pool_byte_size_;
+
+    // Whether to allocate from the stream-ordered memory pool of the
+    // devices (cudaMallocAsync) instead of a fixed CNMeM pool. In that
+    // mode the pool grows on demand and 'memory_pool_byte_size_' is the
+    // release threshold: the memory the pool keeps reserved when it is
+    // synchronized rather than returning it to the device.
+    bool stream_ordered_;
   };
 
   ~CudaMemoryManager();
@@ -62,13 +74,22 @@ class CudaMemoryManager {
   static Status Create(const Options& options);
 
   // Allocate CUDA memory on GPU 'device_id' with
-  // the requested 'size' and return the pointer in 'ptr'.
+  // the requested 'size' and return the pointer in 'ptr'. In the
+  // stream-ordered mode, if 'stream' is given the memory is only
+  // available to work enqueued on 'stream' after this call, or
+  // synchronized with it. Otherwise the memory can be used right away.
   // Return Status object indicating success or failure.
-  static Status Alloc(void** ptr, uint64_t size, int64_t device_id);
+  static Status Alloc(
+      void** ptr, uint64_t size, int64_t device_id,
+      cudaStream_t stream = nullptr);
 
-  // Free the memory allocated by the memory manager on 'device_id'.
+  // Free the memory allocated by the memory manager on 'device_id'. In
+  // the stream-ordered mode, if 'stream' is given the memory is reused
+  // once the work enqueued on 'stream' before this call completes.
+  // Otherwise the memory must not be in use anymore.
   // Return Status object indicating success or failure.
-  static Status Free(void* ptr, int64_t device_id);
+  static Status Free(
+      void* ptr, int64_t device_id, cudaStream_t stream = nullptr);
 
  protected:
   // Provide explicit control on the lifecycle of the CUDA memory manager,
@@ -77,7 +98,26 @@ class CudaMemoryManager {
 
  private:
   CudaMemoryManager(bool has_allocation) : has_allocation_(has_allocation) {}
+
+  static Status CreateStreamOrdered(
+      const Options& options, const std::set<int>& supported_gpus);
+  bool StreamOrdered() const
+  {
+#if CUDART_VERSION >= 11020
+    return !mem_pools_.empty();
+#else
+    return false;
+#endif  // CUDART_VERSION >= 11020
+  }
+  Status StreamOrderedAlloc(
+      void** ptr, uint64_t size, int64_t device_id, cudaStream_t stream);
+  Status StreamOrderedFree(void* ptr, int64_t device_id, cudaStream_t stream);
+
   bool has_allocation_;
+#if CUDART_VERSION >= 11020
+  // The stream-ordered memory pool of each device, empty if CNMeM is used.
+  std::map<int64_t, cudaMemPool_t> mem_pools_;
+#endif  // CUDART_VERSION >= 11020
   static std::unique_ptr<CudaMemoryManager> instance_;
   static std::mutex instance_mu_;
 };
@@ -26,6 +26,7 @@
 
 #include "cuda_utils.h"
 
+#include <mutex>
 #include "model_config_utils.h"
 #include "triton/common/nvtx.h"
 
@@ -39,6 +40,10 @@ MemcpyHost(void* args)
   memcpy(copy_params->dst_, copy_params->src_, copy_params->byte_size_);
   delete copy_params;
 }
+
+// The device pairs with peer access enabled, as <device, peer device>.
+static std::mutex peer_access_mtx_;
+static std::set<std::pair<int64_t, int64_t>> peer_access_pairs_;
 #endif  // TRITON_ENABLE_GPU
 
 Status
@@ -64,6 +69,10 @@ EnablePeerAccess(const double min_compute_capability)
           cuerr = cudaDeviceCanAccessPeer(&can_access_peer, host, peer);
           if ((cuerr == cudaSuccess) && (can_access_peer == 1)) {
             cuerr = cudaDeviceEnablePeerAccess(peer, 0);
+            if (cuerr == cudaSuccess) {
+              std::lock_guard<std::mutex> lk(peer_access_mtx_);
+              peer_access_pairs_.emplace(host, peer);
+            }
           }
 
           all_enabled &= ((cuerr == cudaSuccess) && (can_access_peer == 1));
@@ -80,6 +89,22 @@ EnablePeerAccess(const double min_compute_capability)
   return Status::Success;
 }
 
+bool
+IsPeerAccessEnabled(const int64_t device, const int64_t peer_device)
+{
+  if (device == peer_device) {
+    return true;
+  }
+#ifdef TRITON_ENABLE_GPU
+  std::lock_guard<std::mutex> lk(peer_access_mtx_);
+  return (
+      peer_access_pairs_.find(std::make_pair(device, peer_device)) !=
+      peer_access_pairs_.end());
+#else
+  return false;
+#endif  // TRITON_ENABLE_GPU
+}
+
 Status
 CopyBuffer(
     const std::string& msg, const TRITONSERVER_MemoryType src_memory_type,
@@ -56,6 +56,14 @@ using cudaStream_t = void*;
 /// \return The error status. A non-OK status means not all pairs are enabled
 Status EnablePeerAccess(const double min_compute_capability);
 
+/// Whether 'device' can directly access the memory of 'peer_device', either
+/// because they are the same device or because peer access between them was
+/// enabled by EnablePeerAccess().
+/// \param device The device id accessing the memory.
+/// \param peer_device The device id that owns the memory.
+/// \return True if the access doesn't need to be staged through the host.
+bool IsPeerAccessEnabled(const int64_t device, const int64_t peer_device);
+
 /// Copy buffer from 'src' to 'dst' for given 'byte_size'. The buffer location
 /// is identified by the memory type and id, and the corresponding copy will be
 /// initiated.
@@ -32,13 +32,253 @@
 #include <unistd.h>
 #endif
 #include "constants.h"
+#include "metrics.h"
+#include "model_config_utils.h"
+#include "numa_utils.h"
 #include "server.h"
+#include "shape_bucket_key.h"
 #include "triton/common/logging.h"
 #include "triton/common/model_config.h"
 #include "triton/common/nvtx.h"
 
 namespace triton { namespace core {
 
+namespace {
+
+// Number of requests that can be waiting in the ingress ring before the
+// batcher thread drains them into the scheduler queue.
+constexpr size_t kIngressCapacity = 4096;
+
+// Number of times a producer yields when the ingress ring is full before
+// it starts sleeping, and the maximum time it then sleeps between two
+// attempts, in microseconds. The sleep doubles after every attempt.
+constexpr size_t kIngressFullYieldCount = 8;
+constexpr uint64_t kIngressFullMaxBackoffUs = 1000;
+
+// Model configuration parameter that enables the adaptive queue delay
+// with the given latency SLO, in microseconds.
+constexpr char kLatencySloParameter[] =
+    "dynamic_batching_latency_slo_microseconds";
+
+// Model configuration parameter that sets the number of batcher threads.
+constexpr char kBatcherThreadsParameter[] = "dynamic_batching_batcher_threads";
+
+// Model configuration parameter that enables learning the preferred
+// batch sizes from the latency profile of the model instances.
+constexpr char kLearnPreferredBatchSizesParameter[] =
+    "dynamic_batching_learn_preferred_batch_sizes";
+
+// Model configuration parameter that enables the admission control of
+// the requests against their timeout.
+constexpr char kAdmissionControlParameter[] =
+    "dynamic_batching_admission_control";
+
+// Model configuration parameter that enables the admission control of
+// the requests against the given latency SLO, in microseconds.
+constexpr char kAdmissionLatencySloParameter[] =
+    "dynamic_batching_admission_latency_slo_microseconds";
+
+// Model configuration parameter that enables batching the requests by
+// the shape of the inputs that must have equal shapes in a batch.
+constexpr char kShapeBucketsParameter[] = "dynamic_batching_shape_buckets";
+
+// Model configuration parameter that enables shape buckets and pads the
+// variable dimensions of those inputs to a multiple of the given size.
+constexpr char kShapeBucketGranularityParameter[] =
+    "dynamic_batching_shape_bucket_granularity";
+
+// Model configuration parameters of the admission and quota policy of the
+// model's entries in the response cache, see
+// RequestResponseCache::ModelPolicy. The minimum hit rate is in percent.
+constexpr char kCacheByteQuotaParameter[] = "response_cache_byte_quota";
+constexpr char kCacheMaxEntryByteSizeParameter[] =
+    "response_cache_max_entry_byte_size";
+constexpr char kCacheMinHitRateParameter[] =
+    "response_cache_min_hit_rate_percent";
+constexpr char kCacheMinLookupsParameter[] = "response_cache_min_lookups";
+
+// Model configuration parameter that lets the cache misses identical to
+// an executing request wait for its response instead of executing.
+constexpr char kCacheSingleFlightParameter[] = "response_cache_single_flight";
+
+// Model configuration parameter that shares each priority level fairly
+// between the tenants given by the value of the named request parameter.
+constexpr char kFairQueuingTenantParameter[] =
+    "dynamic_batching_fair_queuing_tenant_parameter";
+
+// Model configuration parameter that sets the weights of the tenants in
+// the fair queue as a comma-separated list of 'tenant:weight', the other
+// tenants have weight 1.
+constexpr char kFairQueuingWeightsParameter[] =
+    "dynamic_batching_fair_queuing_weights";
+
+// Model configuration parameter that adds the batch sizes that the model
+// instances captured a CUDA graph for to the preferred batch sizes.
+constexpr char kPreferCudaGraphBatchSizesParameter[] =
+    "dynamic_batching_prefer_cuda_graph_batch_sizes";
+
+// Model configuration parameter that enables adding instances to the
+// model while its queue is under pressure, up to the given total count of
+// instances.
+constexpr char kAutoscaleMaxInstancesParameter[] =
+    "dynamic_batching_autoscale_max_instances";
+
+// Model configuration parameters that set the queue delay, in
+// microseconds, and the queue depth at which an instance is added.
+constexpr char kAutoscaleQueueDelayParameter[] =
+    "dynamic_batching_autoscale_queue_delay_microseconds";
+constexpr char kAutoscaleQueueDepthParameter[] =
+    "dynamic_batching_autoscale_queue_depth";
+
+// Model configuration parameters that set how long, in microseconds, the
+// queue must stay under pressure before an instance is added and stay
+// empty before an added instance is retired.
+constexpr char kAutoscaleSustainParameter[] =
+    "dynamic_batching_autoscale_sustain_microseconds";
+constexpr char kAutoscaleCooldownParameter[] =
+    "dynamic_batching_autoscale_cooldown_microseconds";
+constexpr uint64_t kDefaultAutoscaleSustainUs = 1000 * 1000;
+constexpr uint64_t kDefaultAutoscaleCooldownUs = 30 * 1000 * 1000;
+
+// Interval between the autoscaling decisions.
+constexpr uint64_t kAutoscaleIntervalNs = 100 * 1000 * 1000;
+
+// Minimum interval between updates of the admission control statistics.
+constexpr uint64_t kAdmissionUpdateIntervalNs = 100 * 1000 * 1000;
+
+// Minimum interval between queue delay adjustments.
+constexpr uint64_t kQueueDelayUpdateIntervalNs = 100 * 1000 * 1000;
+
+// Minimum interval between updates of the learned preferred batch sizes.
+constexpr uint64_t kProfileUpdateIntervalNs = 1000 * 1000 * 1000;
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Status
+GetLearnPreferredBatchSizes(
+    const inference::ModelConfig& config, bool* learn_preferred_batch_sizes)
+{
+  *learn_preferred_batch_sizes = false;
+  const auto it = config.parameters().find(kLearnPreferredBatchSizesParameter);
+  if (it == config.parameters().end()) {
+    return Status::Success;
+  }
+  RETURN_IF_ERROR(ParseBoolParameter(
+      kLearnPreferredBatchSizesParameter, it->second.string_value(),
+      learn_preferred_batch_sizes));
+  if (*learn_preferred_batch_sizes &&
+      (config.dynamic_batching().preferred_batch_size_size() != 0)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model '" + config.name() + "' parameter '" +
+            kLearnPreferredBatchSizesParameter +
+            "' can't be set together with 'preferred_batch_size'");
+  }
+  return Status::Success;
+}
+
+Status
+GetFairQueuingWeights(
+    const inference::ModelConfig& config,
+    std::unordered_map<std::string, uint32_t>* weights)
+{
+  weights->clear();
+  const auto it = config.parameters().find(kFairQueuingWeightsParameter);
+  if (it == config.parameters().end()) {
+    return Status::Success;
+  }
+  const std::string& value = it->second.string_value();
+  size_t begin = 0;
+  while (begin < value.size()) {
+    size_t end = value.find(',', begin);
+    if (end == std::string::npos) {
+      end = value.size();
+    }
+    const std::string entry = value.substr(begin, end - begin);
+    begin = end + 1;
+    // The tenant is everything before the last ':'
+    const size_t sep = entry.rfind(':');
+    uint64_t weight = 0;
+    if ((sep != std::string::npos) && (sep != 0)) {
+      const std::string weight_str = entry.substr(sep + 1);
+      try {
+        size_t pos = 0;
+        weight = std::stoull(weight_str, &pos);
+        if ((pos != weight_str.size()) || (weight_str[0] == '-') ||
+            (weight > UINT32_MAX)) {
+          weight = 0;
+        }
+      }
+      catch (const std::exception&) {
+        weight = 0;
+      }
+    }
+    if (weight == 0) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kFairQueuingWeightsParameter +
+              "' must be a list of 'tenant:weight' with positive weights, "
+              "got '" +
+              value + "'");
+    }
+    (*weights)[entry.substr(0, sep)] = weight;
+  }
+  return Status::Success;
+}
+
+bool
+HasMaxQueueSize(
+    const inference::ModelQueuePolicy& default_queue_policy,
+    const ModelQueuePolicyMap& queue_policy_map)
+{
+  if (default_queue_policy.max_queue_size() != 0) {
+    return true;
+  }
+  for (const auto& policy : queue_policy_map) {
+    if (policy.second.max_queue_size() != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Return in 'host_policy' the NUMA placement shared by all instances of
+// 'model', empty if the instances are not placed on the same NUMA node.
+void
+GetCommonNumaHostPolicy(
+    const TritonModel* model,
+    triton::common::HostPolicyCmdlineConfig* host_policy)
+{
+  host_policy->clear();
+  for (const auto& instance : model->Instances()) {
+    const auto& instance_policy = instance->HostPolicy();
+    const auto node_it = instance_policy.find("numa-node");
+    if (node_it == instance_policy.end()) {
+      host_policy->clear();
+      return;
+    }
+    if (host_policy->empty()) {
+      (*host_policy)["numa-node"] = node_it->second;
+      const auto cpu_it = instance_policy.find("cpu-cores");
+      if (cpu_it != instance_policy.end()) {
+        (*host_policy)["cpu-cores"] = cpu_it->second;
+      }
+    } else if ((*host_policy)["numa-node"] != node_it->second) {
+      host_policy->clear();
+      return;
+    }
+  }
+}
+
+}  // namespace
+
 bool
 IsStaleState(Payload::State payload_state)
 {
@@ -55,29 +295,65 @@ DynamicBatchScheduler::DynamicBatchScheduler(
     const std::set<int32_t>& preferred_batch_sizes,
     const uint64_t max_queue_delay_microseconds,
     const inference::ModelQueuePolicy& default_queue_policy,
-    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map)
+    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map,
+    const uint64_t latency_slo_microseconds,
+    const bool learn_preferred_batch_sizes)
     : model_(model), model_instance_(model_instance),
       dynamic_batching_enabled_(dynamic_batching_enabled),
       queue_(default_queue_policy, priority_levels, queue_policy_map),
-      stop_(false), max_batch_size_((size_t)std::max(1, max_batch_size)),
+      stop_(false), owner_(this), ingress_(kIngressCapacity),
+      ingress_enabled_(
+          !HasMaxQueueSize(default_queue_policy, queue_policy_map)),
+      batcher_parked_(false), batcher_wake_any_(true),
+      ingress_request_count_(0), queued_request_count_(0),
+      payload_request_count_(0), oldest_enqueue_ns_(0),
+      max_batch_size_((size_t)std::max(1, max_batch_size)),
       preferred_batch_sizes_(preferred_batch_sizes),
+      learn_preferred_batch_sizes_(learn_preferred_batch_sizes),
+      last_profile_update_ns_(0), prefer_cuda_graph_batch_sizes_(false),
+      cuda_graph_generation_(0),
       pending_batch_delay_ns_(max_queue_delay_microseconds * 1000),
-      pending_batch_size_(0), queued_batch_size_(0),
-      next_preferred_batch_size_(0),
+      arrival_count_(0), last_arrival_count_(0), last_delay_update_ns_(0),
+      last_admission_update_ns_(0), autoscale_exit_(false),
+      pending_batch_size_(0),
+      queued_batch_size_(0), next_preferred_batch_size_(0),
       enforce_equal_shape_tensors_(enforce_equal_shape_tensors),
-      has_optional_input_(false), preserve_ordering_(preserve_ordering)
+      has_optional_input_(false), shape_buckets_(false),
+      shape_bucket_granularity_(0), shape_copy_stream_(nullptr),
+      preserve_ordering_(preserve_ordering),
+      cache_single_flight_(false), coalesced_request_count_(0)
 {
   rate_limiter_ = model_->Server()->GetRateLimiter();
   // Both the server and model config should specify
   // caching enabled for model to utilize response cache.
   response_cache_enabled_ =
       (model_->Server()->ResponseCacheEnabled() && response_cache_enable);
+  if (latency_slo_microseconds != 0) {
+    const uint64_t latency_slo_ns = latency_slo_microseconds * 1000;
+    delay_controller_.reset(new QueueDelayController(
+        latency_slo_ns, latency_slo_ns, pending_batch_delay_ns_,
+        max_batch_size_));
+    LOG_VERBOSE(1) << "Adaptive queue delay enabled for " << model_->Name()
+                   << " with latency SLO " << latency_slo_microseconds
+                   << " us";
+  }
 #ifdef TRITON_ENABLE_METRICS
-  // Initialize metric reporter for cache statistics if cache enabled
-  if (response_cache_enabled_) {
+  // Initialize metric reporter for cache statistics if cache enabled, for
+  // the queue delay if it is adaptive, and for the queue and the batches
+  // if metrics are enabled
+  if (response_cache_enabled_ || (delay_controller_ != nullptr) ||
+      Metrics::Enabled()) {
     MetricModelReporter::Create(
         model_->Name(), model_->Version(), METRIC_REPORTER_ID_RESPONSE_CACHE,
         model_->Config().metric_tags(), &reporter_);
+    if (dynamic_batching_enabled_ && Metrics::Enabled()) {
+      std::vector<uint32_t> priority_levels;
+      queue_.PriorityLevels(&priority_levels);
+      reporter_->CreateBatcherMetrics(priority_levels);
+    }
+    if (response_cache_enabled_) {
+      reporter_->CreateCacheUsageMetrics();
+    }
   }
 #endif  // TRITON_ENABLE_METRICS
   max_preferred_batch_size_ = 0;
@@ -130,19 +406,240 @@ DynamicBatchScheduler::Create(
     preferred_batch_sizes.insert(size);
   }
 
-  DynamicBatchScheduler* dyna_sched = new DynamicBatchScheduler(
-      model, model_instance, dynamic_batching_enabled, max_batch_size,
-      enforce_equal_shape_tensors, batcher_config.preserve_ordering(),
-      response_cache_enable, preferred_batch_sizes,
-      batcher_config.max_queue_delay_microseconds(),
-      batcher_config.default_queue_policy(), batcher_config.priority_levels(),
-      batcher_config.priority_queue_policy());
+  uint64_t latency_slo_microseconds = 0;
+  bool learn_preferred_batch_sizes = false;
+  uint64_t batcher_threads = 0;
+  bool admission_control = false;
+  uint64_t admission_latency_slo_microseconds = 0;
+  bool shape_buckets = false;
+  uint64_t shape_bucket_granularity = 0;
+  bool prefer_cuda_graph_batch_sizes = false;
+  bool cache_single_flight = false;
+  std::string fair_tenant_parameter;
+  std::unordered_map<std::string, uint32_t> fair_weights;
+  uint64_t autoscale_max_instances = 0;
+  if (dynamic_batching_enabled && (model_instance == nullptr)) {
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAutoscaleMaxInstancesParameter,
+        0 /* default_value */, &autoscale_max_instances));
+  }
+  if (dynamic_batching_enabled) {
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kLatencySloParameter, 0 /* default_value */,
+        &latency_slo_microseconds));
+    RETURN_IF_ERROR(GetLearnPreferredBatchSizes(
+        model->Config(), &learn_preferred_batch_sizes));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kBatcherThreadsParameter, 0 /* default_value */,
+        &batcher_threads));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAdmissionLatencySloParameter, 0 /* default_value */,
+        &admission_latency_slo_microseconds));
+    const auto it = model->Config().parameters().find(
+        kAdmissionControlParameter);
+    if (it != model->Config().parameters().end()) {
+      RETURN_IF_ERROR(ParseBoolParameter(
+          kAdmissionControlParameter, it->second.string_value(),
+          &admission_control));
+    }
+    admission_control |= (admission_latency_slo_microseconds != 0);
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kShapeBucketGranularityParameter,
+        0 /* default_value */, &shape_bucket_granularity));
+    const auto bucket_it =
+        model->Config().parameters().find(kShapeBucketsParameter);
+    if (bucket_it != model->Config().parameters().end()) {
+      RETURN_IF_ERROR(ParseBoolParameter(
+          kShapeBucketsParameter, bucket_it->second.string_value(),
+          &shape_buckets));
+    }
+    shape_buckets |= (shape_bucket_granularity != 0);
+    const auto fair_it =
+        model->Config().parameters().find(kFairQueuingTenantParameter);
+    if (fair_it != model->Config().parameters().end()) {
+      fair_tenant_parameter = fair_it->second.string_value();
+      RETURN_IF_ERROR(GetFairQueuingWeights(model->Config(), &fair_weights));
+    }
+    const auto graph_it = model->Config().parameters().find(
+        kPreferCudaGraphBatchSizesParameter);
+    if (graph_it != model->Config().parameters().end()) {
+      RETURN_IF_ERROR(ParseBoolParameter(
+          kPreferCudaGraphBatchSizesParameter, graph_it->second.string_value(),
+          &prefer_cuda_graph_batch_sizes));
+    }
+    if (shape_buckets && enforce_equal_shape_tensors.empty()) {
+      LOG_WARNING << "Shape buckets of " << model->Name()
+                  << " have no effect as any input shapes can be batched"
+                  << " together, they are disabled";
+      shape_buckets = false;
+    }
+  }
+
+  // The cache policy is shared by the batchers of the model, which insert
+  // their responses with the usage and policy resolved here
+  std::shared_ptr<CacheModelUsage> cache_usage;
+  RequestResponseCache::ModelPolicy cache_policy;
+  auto cache = model->Server()->GetResponseCache();
+  if (response_cache_enable && (cache != nullptr)) {
+    uint64_t min_hit_rate_percent = 0;
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kCacheByteQuotaParameter, 0 /* default_value */,
+        &cache_policy.byte_quota_));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kCacheMaxEntryByteSizeParameter, 0 /* default_value */,
+        &cache_policy.max_entry_byte_size_));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kCacheMinHitRateParameter, 0 /* default_value */,
+        &min_hit_rate_percent));
+    if (min_hit_rate_percent > 100) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + model->Name() + "' parameter '" +
+              kCacheMinHitRateParameter + "' must be at most 100");
+    }
+    cache_policy.min_hit_rate_ = min_hit_rate_percent / 100.0;
+    if (model->Config().parameters().count(kCacheMinLookupsParameter) != 0) {
+      RETURN_IF_ERROR(GetUnsignedParameter(
+          model->Config(), kCacheMinLookupsParameter, 0 /* default_value */,
+          &cache_policy.min_lookups_));
+    }
+    cache->SetModelPolicy(model->Name(), cache_policy);
+    cache_usage = cache->ModelUsage(model->Name());
+
+    const auto single_flight_it =
+        model->Config().parameters().find(kCacheSingleFlightParameter);
+    if (single_flight_it != model->Config().parameters().end()) {
+      RETURN_IF_ERROR(ParseBoolParameter(
+          kCacheSingleFlightParameter, single_flight_it->second.string_value(),
+          &cache_single_flight));
+    }
+    if (cache_single_flight && batcher_config.preserve_ordering()) {
+      LOG_WARNING << "Response cache single flight of " << model->Name()
+                  << " can't preserve the response ordering, it is disabled";
+      cache_single_flight = false;
+    }
+  }
+
+  // Run the batcher threads on the NUMA node of the instances
+  triton::common::HostPolicyCmdlineConfig numa_host_policy;
+  const auto& parameters = model->Config().parameters();
+  const auto numa_it = parameters.find(kNumaAwarePlacementParameter);
+  if (numa_it != parameters.end()) {
+    bool numa_aware_placement;
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kNumaAwarePlacementParameter, numa_it->second.string_value(),
+        &numa_aware_placement));
+    if (numa_aware_placement) {
+      GetCommonNumaHostPolicy(model, &numa_host_policy);
+    }
+  }
+
+  auto new_scheduler = [&]() {
+    DynamicBatchScheduler* batcher = new DynamicBatchScheduler(
+        model, model_instance, dynamic_batching_enabled, max_batch_size,
+        enforce_equal_shape_tensors, batcher_config.preserve_ordering(),
+        response_cache_enable, preferred_batch_sizes,
+        batcher_config.max_queue_delay_microseconds(),
+        batcher_config.default_queue_policy(),
+        batcher_config.priority_levels(),
+        batcher_config.priority_queue_policy(), latency_slo_microseconds,
+        learn_preferred_batch_sizes);
+    if (shape_buckets) {
+      batcher->EnableShapeBuckets(shape_bucket_granularity);
+    }
+    if (!fair_tenant_parameter.empty()) {
+      batcher->queue_.EnableFairQueuing(fair_tenant_parameter, fair_weights);
+    }
+    batcher->prefer_cuda_graph_batch_sizes_ = prefer_cuda_graph_batch_sizes;
+    batcher->cache_single_flight_ =
+        cache_single_flight && batcher->response_cache_enabled_;
+    batcher->cache_usage_ = cache_usage;
+    batcher->cache_policy_ = cache_policy;
+    return batcher;
+  };
+  DynamicBatchScheduler* dyna_sched = new_scheduler();
   std::unique_ptr<DynamicBatchScheduler> sched(dyna_sched);
 
+  if (admission_control) {
+#ifdef TRITON_ENABLE_STATS
+    sched->admission_controller_.reset(new AdmissionController(
+        admission_latency_slo_microseconds * 1000,
+        batcher_config.priority_levels()));
+    LOG_VERBOSE(1) << "Admission control enabled for " << model->Name()
+                   << " with latency SLO "
+                   << admission_latency_slo_microseconds << " us";
+#else
+    LOG_WARNING << "Admission control of " << model->Name()
+                << " requires statistics, it is disabled";
+#endif  // TRITON_ENABLE_STATS
+  }
+
+  if (autoscale_max_instances > model->Instances().size()) {
+    uint64_t delay_us, depth, sustain_us, cooldown_us;
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAutoscaleQueueDelayParameter, 0 /* default_value */,
+        &delay_us));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAutoscaleQueueDepthParameter, 0 /* default_value */,
+        &depth));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAutoscaleSustainParameter, 0 /* default_value */,
+        &sustain_us));
+    RETURN_IF_ERROR(GetUnsignedParameter(
+        model->Config(), kAutoscaleCooldownParameter, 0 /* default_value */,
+        &cooldown_us));
+    if ((delay_us == 0) && (depth == 0)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + model->Name() + "' parameter '" +
+              kAutoscaleMaxInstancesParameter + "' requires '" +
+              kAutoscaleQueueDelayParameter + "' or '" +
+              kAutoscaleQueueDepthParameter + "'");
+    }
+    if (sustain_us == 0) {
+      sustain_us = kDefaultAutoscaleSustainUs;
+    }
+    if (cooldown_us == 0) {
+      cooldown_us = kDefaultAutoscaleCooldownUs;
+    }
+    sched->autoscaler_.reset(new InstanceAutoscaler(
+        autoscale_max_instances - model->Instances().size(), delay_us * 1000,
+        depth, sustain_us * 1000, cooldown_us * 1000));
+    LOG_VERBOSE(1) << "Autoscaling enabled for " << model->Name()
+                   << " up to " << autoscale_max_instances << " instances";
+  } else if (autoscale_max_instances != 0) {
+    LOG_WARNING << "Autoscaling of " << model->Name()
+                << " has no effect as the model already has "
+                << model->Instances().size() << " instances, it is disabled";
+  }
+
   sched->scheduler_thread_exit_.store(false);
-  if (dynamic_batching_enabled) {
+  if (batcher_threads > 1) {
+    LOG_VERBOSE(1) << "Using " << batcher_threads
+                   << " dynamic-batcher threads for " << model->Name();
+    for (uint64_t idx = 0; idx < batcher_threads; ++idx) {
+      DynamicBatchScheduler* lane = new_scheduler();
+      sched->lanes_.emplace_back(lane);
+      lane->owner_ = dyna_sched;
+#ifdef TRITON_ENABLE_METRICS
+      // The lanes report the metrics of the model through the reporter
+      // of the scheduler.
+      lane->reporter_ = sched->reporter_;
+#endif  // TRITON_ENABLE_METRICS
+      lane->scheduler_thread_exit_.store(false);
+      lane->scheduler_thread_ = std::thread([lane, nice, numa_host_policy]() {
+        lane->BatcherThread(nice, numa_host_policy);
+      });
+    }
+  } else if (dynamic_batching_enabled) {
     sched->scheduler_thread_ =
-        std::thread([dyna_sched, nice]() { dyna_sched->BatcherThread(nice); });
+        std::thread([dyna_sched, nice, numa_host_policy]() {
+          dyna_sched->BatcherThread(nice, numa_host_policy);
+        });
+  }
+  if (sched->autoscaler_ != nullptr) {
+    sched->autoscale_thread_ =
+        std::thread([dyna_sched]() { dyna_sched->AutoscaleThread(); });
   }
 
   scheduler->reset(sched.release());
@@ -152,17 +649,71 @@ DynamicBatchScheduler::Create(
 
 DynamicBatchScheduler::~DynamicBatchScheduler()
 {
+  // Stop the autoscaling before the lanes it observes
+  StopAutoscale();
+
+  // Stop the lanes first as they deliver responses through this scheduler
+  lanes_.clear();
+
   // Signal the scheduler thread to exit and then wait for it..
   scheduler_thread_exit_.store(true);
   cv_.notify_one();
   if (scheduler_thread_.joinable()) {
     scheduler_thread_.join();
   }
+
+#ifdef TRITON_ENABLE_METRICS
+  // The queue size gauges may be shared with other lanes, withdraw the
+  // requests this scheduler published.
+  if (reporter_ != nullptr) {
+    for (size_t idx = 0; idx < reported_queue_sizes_.size(); ++idx) {
+      reporter_->ReportBatcherQueueSizeChange(
+          idx, -static_cast<double>(reported_queue_sizes_[idx]));
+    }
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+#ifdef TRITON_ENABLE_GPU
+  if (shape_copy_stream_ != nullptr) {
+    cudaError_t err = cudaStreamDestroy(shape_copy_stream_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+}
+
+void
+DynamicBatchScheduler::Stop()
+{
+  stop_ = true;
+  for (const auto& lane : lanes_) {
+    lane->Stop();
+  }
+  // The autoscaling thread calls into the model, stop it before the model
+  // goes away.
+  StopAutoscale();
+}
+
+void
+DynamicBatchScheduler::StopAutoscale()
+{
+  std::thread autoscale_thread;
+  {
+    std::lock_guard<std::mutex> lk(autoscale_mu_);
+    autoscale_exit_ = true;
+    autoscale_thread.swap(autoscale_thread_);
+  }
+  autoscale_cv_.notify_one();
+  if (autoscale_thread.joinable()) {
+    autoscale_thread.join();
+  }
 }
 
 Status
 DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
 {
+  CPU_STAGE_SCOPE(cpu_stage_, model_->MutableStatsAggregator(), ENQUEUE);
   if (stop_) {
     return Status(
         Status::Code::UNAVAILABLE,
@@ -216,6 +767,24 @@ DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
     return Status::Success;
   }
 
+  if (cache_single_flight_ && request->CacheKeyIsSet()) {
+    if (CoalesceCacheMiss(request)) {
+      return Status::Success;
+    }
+    return ScheduleCoalesceLeader(request);
+  }
+
+  return ScheduleRequest(request);
+}
+
+Status
+DynamicBatchScheduler::ScheduleRequest(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  if (admission_controller_ != nullptr) {
+    RETURN_IF_ERROR(AdmitRequest(*request));
+  }
+
   if (!dynamic_batching_enabled_) {
     if (preserve_ordering_ || response_cache_enabled_) {
       DelegateResponse(request);
@@ -225,56 +794,585 @@ DynamicBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
     auto payload = model_->Server()->GetRateLimiter()->GetPayload(
         Payload::Operation::INFER_RUN, nullptr /* TritonModelInstance*/);
     payload->AddRequest(std::move(request));
+    CPU_STAGE_SCOPE(
+        rate_limiter_stage_, model_->MutableStatsAggregator(), RATE_LIMITER);
     RETURN_IF_ERROR(
         model_->Server()->GetRateLimiter()->EnqueuePayload(model_, payload));
 
+  } else if (!lanes_.empty()) {
+    RETURN_IF_ERROR(SelectLane()->EnqueueToBatcher(request));
   } else {
-    bool wake_batcher = true;
-    {
-      std::lock_guard<std::mutex> lock(mu_);
+    RETURN_IF_ERROR(EnqueueToBatcher(request));
+  }
+
+  return Status::Success;
+}
+
+Status
+DynamicBatchScheduler::EnqueueBatch(
+    std::vector<std::unique_ptr<InferenceRequest>>& requests)
+{
+  // The dynamic batcher forms its own batches, and the delegated
+  // responses and the cache lookups are handled request by request.
+  if (dynamic_batching_enabled_ || preserve_ordering_ ||
+      response_cache_enabled_ || requests.empty()) {
+    return Scheduler::EnqueueBatch(requests);
+  }
 
-      queued_batch_size_ += std::max(1U, request->BatchSize());
+  if (stop_) {
+    return Status(
+        Status::Code::UNAVAILABLE,
+        requests.front()->LogRequest() +
+            "Server is stopping, scheduler for model has stopped accepting new "
+            "inference requests");
+  }
 
-      // Assuming no error is returned, this call takes ownership of
-      // 'request' and so we can't use it after this point.
-      RETURN_IF_ERROR(queue_.Enqueue(request->Priority(), request));
+  // Directly enqueue the requests to the model to be executed together.
+  auto payload = model_->Server()->GetRateLimiter()->GetPayload(
+      Payload::Operation::INFER_RUN, nullptr /* TritonModelInstance*/);
+  payload->ReserveRequests(requests.size());
+  for (auto& request : requests) {
+    if (request->QueueStartNs() == 0) {
+      request->CaptureQueueStartNs();
+      INFER_TRACE_ACTIVITY(
+          request->Trace(), TRITONSERVER_TRACE_QUEUE_START,
+          request->QueueStartNs());
+#ifdef TRITON_ENABLE_TRACING
+      request->TraceInputTensors(
+          TRITONSERVER_TRACE_TENSOR_QUEUE_INPUT,
+          "DynamicBatchScheduler EnqueueBatch");
+#endif  // TRITON_ENABLE_TRACING
+    }
+    request->CaptureBatcherStartNs();
+    payload->AddRequest(std::move(request));
+  }
+  payload->ReportTraceActivity(TRITONSERVER_TRACE_BATCH_FORMED);
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportBatcherBatch(payload->BatchSize(), max_batch_size_);
+  }
+#endif  // TRITON_ENABLE_METRICS
 
-      // If there are any idle runners and the queued batch size is greater or
-      // equal to next preferred batch size, then wake batcher up to service
-      // this request. We do the actual wake outside of the lock to avoid
-      // having the woken thread immediately block on the lock
-      wake_batcher =
-          model_->Server()->GetRateLimiter()->PayloadSlotAvailable(model_);
+  CPU_STAGE_SCOPE(cpu_stage_, model_->MutableStatsAggregator(), RATE_LIMITER);
+  Status status =
+      model_->Server()->GetRateLimiter()->EnqueuePayload(model_, payload);
+  if (!status.IsOk()) {
+    // The payload is not scheduled, give the requests back to the caller.
+    requests = std::move(payload->Requests());
+  }
+  return status;
+}
 
-      // We may wake up runner less often if we don't enforce equal shape
-      // within a batch, otherwise must always wake up runner to check it
-      if (enforce_equal_shape_tensors_.empty()) {
-        std::lock_guard<std::mutex> exec_lock(*(curr_payload_->GetExecMutex()));
-        auto payload_state = curr_payload_->GetState();
-        wake_batcher &=
-            (payload_saturated_ || IsStaleState(payload_state) ||
-             (queued_batch_size_ >= next_preferred_batch_size_));
+Status
+DynamicBatchScheduler::EnqueueToBatcher(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  if (shape_bucket_granularity_ != 0) {
+    PadToShapeBucket(request);
+  }
+  if (shape_buckets_) {
+    // The bucket is only computed once, the batcher looks it up by key.
+    request->SetShapeBucketKey(ShapeBucketKey(
+        *request, enforce_equal_shape_tensors_, has_optional_input_,
+        shape_copy_stream_));
+  }
+  if (ingress_enabled_) {
+    if (delay_controller_ != nullptr) {
+      arrival_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Hand the request to the batcher thread through the ingress ring.
+    // The counters are updated before the push so that the batcher never
+    // observes a drained request that is not accounted for.
+    queued_batch_size_ += std::max(1U, request->BatchSize());
+    ingress_request_count_++;
+    size_t attempt = 0;
+    uint64_t backoff_us = 1;
+    while (!ingress_.Push(request)) {
+      // The ring is full, make sure the batcher is draining it and back
+      // off so that the waiting producers leave it the CPU.
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+      }
+      cv_.notify_one();
+      if (attempt++ < kIngressFullYieldCount) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(backoff_us));
+        backoff_us = std::min(backoff_us * 2, kIngressFullMaxBackoffUs);
       }
     }
 
-    if (wake_batcher) {
+    // Order the push before reading 'batcher_parked_', the batcher does
+    // the reverse before it parks so at least one side observes the other.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ShouldWakeBatcher()) {
+      // Acquire 'mu_' so the notification can't be delivered between the
+      // batcher checking the ring and starting to wait.
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+      }
       cv_.notify_one();
     }
+    return Status::Success;
+  }
+
+  bool wake_batcher = true;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (delay_controller_ != nullptr) {
+      arrival_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const size_t batch_size = std::max(1U, request->BatchSize());
+    queued_batch_size_ += batch_size;
+
+    // Assuming no error is returned, this call takes ownership of
+    // 'request' and so we can't use it after this point.
+    Status status = EnqueueToQueue(request);
+    if (!status.IsOk()) {
+      queued_batch_size_ -= batch_size;
+      return status;
+    }
+    queued_request_count_ = queue_.Size();
+
+    // If there are any idle runners and the queued batch size is greater or
+    // equal to next preferred batch size, then wake batcher up to service
+    // this request. We do the actual wake outside of the lock to avoid
+    // having the woken thread immediately block on the lock
+    wake_batcher =
+        model_->Server()->GetRateLimiter()->PayloadSlotAvailable(model_);
+
+    // We may wake up runner less often if we don't enforce equal shape
+    // within a batch, otherwise must always wake up runner to check it
+    if (enforce_equal_shape_tensors_.empty()) {
+      std::lock_guard<std::mutex> exec_lock(*(curr_payload_->GetExecMutex()));
+      auto payload_state = curr_payload_->GetState();
+      wake_batcher &=
+          (payload_saturated_ || IsStaleState(payload_state) ||
+           (queued_batch_size_ >= next_preferred_batch_size_));
+    }
+  }
+
+  if (wake_batcher) {
+    cv_.notify_one();
   }
 
   return Status::Success;
 }
 
+DynamicBatchScheduler*
+DynamicBatchScheduler::SelectLane()
+{
+  // Route the request to the least loaded lane, the first one of the
+  // equally loaded lanes.
+  DynamicBatchScheduler* selected = nullptr;
+  size_t selected_batch_size = 0;
+  for (const auto& lane : lanes_) {
+    const size_t queued_batch_size = lane->queued_batch_size_;
+    if ((selected == nullptr) || (queued_batch_size < selected_batch_size)) {
+      selected = lane.get();
+      selected_batch_size = queued_batch_size;
+    }
+  }
+  return selected;
+}
+
+void
+DynamicBatchScheduler::StealRequests()
+{
+  // 'mu_' mutex must be held when this function is called. Lock of other
+  // lanes are only tried to avoid deadlocking with a lane stealing from
+  // this one.
+  DynamicBatchScheduler* victim = nullptr;
+  size_t victim_batch_size = max_batch_size_;
+  for (const auto& lane : owner_->lanes_) {
+    const size_t queued_batch_size = lane->queued_batch_size_;
+    if ((lane.get() != this) && (queued_batch_size > victim_batch_size)) {
+      victim = lane.get();
+      victim_batch_size = queued_batch_size;
+    }
+  }
+  if (victim == nullptr) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> victim_lock(victim->mu_, std::try_to_lock);
+  if (!victim_lock.owns_lock()) {
+    return;
+  }
+
+  // Take about one batch from the front of the victim queue, leaving the
+  // victim at least one batch to work on.
+  size_t stolen_batch_size = 0;
+  while ((stolen_batch_size < max_batch_size_) &&
+         (victim->queued_batch_size_ > max_batch_size_)) {
+    std::unique_ptr<InferenceRequest> request;
+    if (!victim->queue_.Dequeue(&request).IsOk()) {
+      break;
+    }
+    victim->RemoveFromShapeBucket(*request);
+    const size_t batch_size = std::max(1U, request->BatchSize());
+    victim->queued_batch_size_ -= batch_size;
+    queued_batch_size_ += batch_size;
+    stolen_batch_size += batch_size;
+    Status status = EnqueueToQueue(request);
+    if (!status.IsOk()) {
+      queued_batch_size_ -= batch_size;
+      InferenceRequest::RespondIfError(request, status, true);
+    }
+  }
+  // The requests of the pending batch of the victim may have been taken,
+  // it is formed again from the remaining requests.
+  if (stolen_batch_size != 0) {
+    victim->queue_.ResetCursor();
+    victim->pending_batch_size_ = 0;
+  }
+  victim->queued_request_count_ = victim->queue_.Size();
+  queued_request_count_ = queue_.Size();
+}
+
+bool
+DynamicBatchScheduler::ShouldWakeBatcher()
+{
+  // Only signal if the batcher is actually waiting and there is an idle
+  // runner. If equal shape is not enforced within a batch, the batcher is
+  // only needed once the queued batch size reaches the next preferred
+  // batch size, otherwise it must always check the new request.
+  if (!batcher_parked_.load()) {
+    return false;
+  }
+  if (!model_->Server()->GetRateLimiter()->PayloadSlotAvailable(model_)) {
+    return false;
+  }
+  return !enforce_equal_shape_tensors_.empty() || batcher_wake_any_.load() ||
+         (queued_batch_size_.load() >= next_preferred_batch_size_.load());
+}
+
+void
+DynamicBatchScheduler::DrainIngress()
+{
+  // 'mu_' mutex must be held when this function is called.
+  std::unique_ptr<InferenceRequest> request;
+  while (ingress_.Pop(&request)) {
+    ingress_request_count_--;
+    const size_t batch_size = std::max(1U, request->BatchSize());
+    Status status = EnqueueToQueue(request);
+    if (!status.IsOk()) {
+      queued_batch_size_ -= batch_size;
+      InferenceRequest::RespondIfError(request, status, true);
+    }
+  }
+  queued_request_count_ = queue_.Size();
+}
+
+Status
+DynamicBatchScheduler::EnqueueToQueue(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  // 'mu_' mutex must be held when this function is called.
+  if (!shape_buckets_) {
+    return queue_.Enqueue(request->Priority(), request);
+  }
+
+  // The responses are delegated as the requests are queued when the
+  // order must be preserved, as the buckets are dispatched out of order.
+  if ((preserve_ordering_ || response_cache_enabled_) &&
+      !request->HasResponseDelegator()) {
+    owner_->DelegateResponse(request);
+  }
+  const uint64_t key = request->ShapeBucketKey();
+  const size_t batch_size = std::max(1U, request->BatchSize());
+  const uint64_t enqueue_ns = request->BatcherStartNs();
+  RETURN_IF_ERROR(queue_.Enqueue(request->Priority(), request));
+  shape_bucket_index_.Add(key, batch_size, enqueue_ns);
+  return Status::Success;
+}
+
+Status
+DynamicBatchScheduler::AdmitRequest(const InferenceRequest& request)
+{
+  UpdateAdmission();
+
+  // The requests being executed are counted as ahead of the request.
+  const uint64_t expected_latency_ns =
+      admission_controller_->ExpectedLatencyNs(InflightInferenceCount());
+  if (admission_controller_->Admit(
+          expected_latency_ns, request.Priority(),
+          request.TimeoutMicroseconds() * 1000)) {
+    return Status::Success;
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportBatcherRejected(1);
+  }
+#endif  // TRITON_ENABLE_METRICS
+  return Status(
+      Status::Code::UNAVAILABLE,
+      request.LogRequest() + "Request for model '" + model_->Name() +
+          "' rejected by admission control, its expected latency of " +
+          std::to_string(expected_latency_ns / 1000) +
+          " us exceeds its latency budget");
+}
+
+void
+DynamicBatchScheduler::UpdateAdmission()
+{
+#ifdef TRITON_ENABLE_STATS
+  // Only one caller records the executions, the others use the
+  // statistics as they are.
+  std::unique_lock<std::mutex> lk(admission_mu_, std::try_to_lock);
+  if (!lk.owns_lock()) {
+    return;
+  }
+  const uint64_t now_ns = NowNs();
+  if ((now_ns - last_admission_update_ns_) < kAdmissionUpdateIntervalNs) {
+    return;
+  }
+  last_admission_update_ns_ = now_ns;
+
+  std::map<size_t, InferenceStatsAggregator::InferBatchStats> batch_stats;
+  model_->MutableStatsAggregator()->InferBatchStatsSnapshot(&batch_stats);
+  uint64_t request_count = 0;
+  uint64_t execution_count = 0;
+  uint64_t duration_ns = 0;
+  for (const auto& stats : batch_stats) {
+    InferenceStatsAggregator::InferBatchStats last;
+    const auto it = admission_batch_stats_.find(stats.first);
+    if (it != admission_batch_stats_.end()) {
+      last = it->second;
+    }
+    const uint64_t count = stats.second.count_ - last.count_;
+    request_count += count * stats.first;
+    execution_count += count;
+    duration_ns +=
+        (stats.second.compute_input_duration_ns_ +
+         stats.second.compute_infer_duration_ns_ +
+         stats.second.compute_output_duration_ns_) -
+        (last.compute_input_duration_ns_ + last.compute_infer_duration_ns_ +
+         last.compute_output_duration_ns_);
+  }
+  admission_batch_stats_.swap(batch_stats);
+
+  admission_controller_->RecordExecutions(
+      request_count, execution_count, duration_ns, model_->Instances().size());
+#endif  // TRITON_ENABLE_STATS
+}
+
+void
+DynamicBatchScheduler::UpdateQueueDelay()
+{
+  // 'mu_' mutex must be held when this function is called.
+  const uint64_t now_ns = NowNs();
+  if (last_delay_update_ns_ == 0) {
+    last_delay_update_ns_ = now_ns;
+    return;
+  }
+  if ((now_ns - last_delay_update_ns_) < kQueueDelayUpdateIntervalNs) {
+    return;
+  }
+
+  const uint64_t arrival_count = arrival_count_.load();
+  delay_controller_->RecordArrivals(
+      arrival_count - last_arrival_count_, now_ns - last_delay_update_ns_);
+  last_arrival_count_ = arrival_count;
+  last_delay_update_ns_ = now_ns;
+
+#ifdef TRITON_ENABLE_STATS
+  // Only the executions since the last adjustment are recorded
+  std::map<size_t, InferenceStatsAggregator::InferBatchStats> batch_stats;
+  model_->MutableStatsAggregator()->InferBatchStatsSnapshot(&batch_stats);
+  for (const auto& stats : batch_stats) {
+    InferenceStatsAggregator::InferBatchStats last;
+    const auto it = last_batch_stats_.find(stats.first);
+    if (it != last_batch_stats_.end()) {
+      last = it->second;
+    }
+    const uint64_t duration_ns =
+        (stats.second.compute_input_duration_ns_ +
+         stats.second.compute_infer_duration_ns_ +
+         stats.second.compute_output_duration_ns_) -
+        (last.compute_input_duration_ns_ + last.compute_infer_duration_ns_ +
+         last.compute_output_duration_ns_);
+    delay_controller_->RecordExecutions(
+        stats.first, stats.second.count_ - last.count_, duration_ns);
+  }
+  last_batch_stats_.swap(batch_stats);
+#endif  // TRITON_ENABLE_STATS
+
+  const uint64_t delay_ns = delay_controller_->Update();
+  if (delay_ns != pending_batch_delay_ns_) {
+    LOG_VERBOSE(2) << "Queue delay for " << model_->Name() << " adjusted to "
+                   << (delay_ns / 1000) << " us";
+  }
+  pending_batch_delay_ns_ = delay_ns;
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->MetricInferenceQueueDelayTarget().Set(delay_ns / 1000);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+DynamicBatchScheduler::UpdatePreferredBatchSizes()
+{
+  // 'mu_' mutex must be held when this function is called.
+  const uint64_t now_ns = NowNs();
+  if ((now_ns - last_profile_update_ns_) < kProfileUpdateIntervalNs) {
+    return;
+  }
+  last_profile_update_ns_ = now_ns;
+
+  // Average the profiles of the instances that execute the batches
+  std::map<size_t, std::pair<double, size_t>> latency_sums;
+  auto add_profile = [&latency_sums](const BatchLatencyProfile& profile) {
+    std::map<size_t, double> latency_ns;
+    profile.Snapshot(&latency_ns);
+    for (const auto& latency : latency_ns) {
+      auto& sum = latency_sums[latency.first];
+      sum.first += latency.second;
+      sum.second++;
+    }
+  };
+  if (model_instance_ != nullptr) {
+    add_profile(model_instance_->LatencyProfile());
+  } else {
+    for (const auto& instance : model_->Instances()) {
+      add_profile(instance->LatencyProfile());
+    }
+  }
+  std::map<size_t, double> latency_ns;
+  for (const auto& sum : latency_sums) {
+    latency_ns.emplace(sum.first, sum.second.first / sum.second.second);
+  }
+
+  std::set<int32_t> batch_sizes;
+  if (!BatchLatencyProfile::EfficientBatchSizes(
+          latency_ns, max_batch_size_, &batch_sizes)) {
+    return;
+  }
+  batch_sizes.insert(
+      cuda_graph_batch_sizes_.begin(), cuda_graph_batch_sizes_.end());
+  if (batch_sizes == preferred_batch_sizes_) {
+    return;
+  }
+
+  if (LOG_VERBOSE_IS_ON(2)) {
+    std::string sizes;
+    for (const auto size : batch_sizes) {
+      sizes += (sizes.empty() ? "" : ", ") + std::to_string(size);
+    }
+    LOG_VERBOSE(2) << "Preferred batch sizes for " << model_->Name()
+                   << " updated to [" << sizes << "]";
+  }
+  preferred_batch_sizes_.swap(batch_sizes);
+  max_preferred_batch_size_ = *preferred_batch_sizes_.rbegin();
+}
+
+void
+DynamicBatchScheduler::UpdateCudaGraphBatchSizes()
+{
+  // 'mu_' mutex must be held when this function is called.
+  uint64_t generation = 0;
+  if (model_instance_ != nullptr) {
+    generation = model_instance_->CudaGraphs().Generation();
+  } else {
+    for (const auto& instance : model_->Instances()) {
+      generation += instance->CudaGraphs().Generation();
+    }
+  }
+  if (generation == cuda_graph_generation_) {
+    return;
+  }
+  cuda_graph_generation_ = generation;
+
+  // The batch sizes captured by any instance are preferred
+  std::set<int32_t> batch_sizes;
+  if (model_instance_ != nullptr) {
+    model_instance_->CudaGraphs().BatchSizes(&batch_sizes);
+  } else {
+    for (const auto& instance : model_->Instances()) {
+      instance->CudaGraphs().BatchSizes(&batch_sizes);
+    }
+  }
+  for (const auto size : batch_sizes) {
+    if ((size_t)size <= max_batch_size_) {
+      cuda_graph_batch_sizes_.insert(size);
+    }
+  }
+  const size_t preferred_count = preferred_batch_sizes_.size();
+  preferred_batch_sizes_.insert(
+      cuda_graph_batch_sizes_.begin(), cuda_graph_batch_sizes_.end());
+  if (preferred_batch_sizes_.size() != preferred_count) {
+    max_preferred_batch_size_ = *preferred_batch_sizes_.rbegin();
+    LOG_VERBOSE(2) << "Preferred batch sizes for " << model_->Name()
+                   << " extended to " << preferred_batch_sizes_.size()
+                   << " batch sizes with captured CUDA graphs";
+  }
+}
+
+void
+DynamicBatchScheduler::AutoscaleThread()
+{
+  std::vector<DynamicBatchScheduler*> batchers;
+  if (lanes_.empty()) {
+    batchers.push_back(this);
+  } else {
+    for (const auto& lane : lanes_) {
+      batchers.push_back(lane.get());
+    }
+  }
+
+  std::unique_lock<std::mutex> lk(autoscale_mu_);
+  while (!autoscale_cv_.wait_for(
+      lk, std::chrono::nanoseconds(kAutoscaleIntervalNs),
+      [this]() { return autoscale_exit_; })) {
+    // The instances are added and retired without holding the lock, the
+    // scheduler only waits for the current decision when destroyed.
+    lk.unlock();
+    const uint64_t now_ns = NowNs();
+    uint64_t queue_delay_ns = 0;
+    size_t queue_depth = 0;
+    for (const auto batcher : batchers) {
+      queue_depth +=
+          batcher->ingress_request_count_ + batcher->queued_request_count_;
+      const uint64_t oldest_ns = batcher->oldest_enqueue_ns_;
+      if ((oldest_ns != 0) && (now_ns > oldest_ns)) {
+        queue_delay_ns = std::max(queue_delay_ns, now_ns - oldest_ns);
+      }
+    }
+
+    const auto decision = autoscaler_->Update(
+        now_ns, queue_delay_ns, queue_depth, model_->ScaledInstanceCount());
+    if (decision == InstanceAutoscaler::Decision::SCALE_UP) {
+      LOG_VERBOSE(1) << "Adding instance to " << model_->Name()
+                     << " with queue delay " << (queue_delay_ns / 1000)
+                     << " us and queue depth " << queue_depth;
+      LOG_STATUS_ERROR(
+          model_->AddScaledInstance(), "failed adding model instance");
+    } else if (decision == InstanceAutoscaler::Decision::SCALE_DOWN) {
+      // A busy instance is retired after another cooldown
+      bool removed;
+      LOG_STATUS_ERROR(
+          model_->RemoveScaledInstance(&removed),
+          "failed removing model instance");
+    }
+    lk.lock();
+  }
+}
+
 void
 DynamicBatchScheduler::NewPayload()
 {
   curr_payload_ = model_->Server()->GetRateLimiter()->GetPayload(
       Payload::Operation::INFER_RUN, model_instance_);
   payload_saturated_ = false;
+  payload_request_count_ = 0;
 }
 
 void
-DynamicBatchScheduler::BatcherThread(const int nice)
+DynamicBatchScheduler::BatcherThread(
+    const int nice, const triton::common::HostPolicyCmdlineConfig& host_policy)
 {
 #ifndef _WIN32
   if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) == 0) {
@@ -289,6 +1387,13 @@ DynamicBatchScheduler::BatcherThread(const int nice)
   LOG_VERBOSE(1) << "Starting dynamic-batcher thread for " << model_->Name()
                  << " at default nice...";
 #endif
+  if (!host_policy.empty()) {
+    Status status = SetNumaConfigOnThread(host_policy);
+    if (!status.IsOk()) {
+      LOG_ERROR << "failed to set NUMA placement of dynamic-batcher thread for "
+                << model_->Name() << ": " << status.Message();
+    }
+  }
   // For debugging/testing, delay start of threads until the queue
   // contains the specified number of entries.
   size_t delay_cnt = 0;
@@ -327,6 +1432,20 @@ DynamicBatchScheduler::BatcherThread(const int nice)
         }
       }
 
+      DrainIngress();
+      if ((owner_ != this) && ingress_enabled_ && queue_.Empty()) {
+        StealRequests();
+      }
+      if (delay_controller_ != nullptr) {
+        UpdateQueueDelay();
+      }
+      if (learn_preferred_batch_sizes_) {
+        UpdatePreferredBatchSizes();
+      }
+      if (prefer_cuda_graph_batch_sizes_) {
+        UpdateCudaGraphBatchSizes();
+      }
+
       if (delay_cnt > 0) {
         // Debugging/testing... wait until queue contains 'delay_cnt'
         // items...
@@ -353,24 +1472,35 @@ DynamicBatchScheduler::BatcherThread(const int nice)
             continue;
           }
 
-          // Use dynamic batching to get request(s) to execute.
-          wait_microseconds = GetDynamicBatch();
+          CPU_STAGE_SCOPE(
+              cpu_stage_, model_->MutableStatsAggregator(), BATCH_FORMATION);
 
-          // Get requests that are rejected from searching dynamic batch.
-          queue_.ReleaseRejectedRequests(&rejected_requests);
+          // Use dynamic batching to get request(s) to execute, and get
+          // requests that are rejected from searching dynamic batch.
+          if (shape_buckets_) {
+            wait_microseconds = GetBucketedBatch(&rejected_requests);
+          } else {
+            wait_microseconds = GetDynamicBatch();
+            queue_.ReleaseRejectedRequests(&rejected_requests);
+          }
 
           // Extract batch only if there is pending batch
           auto pending_batch_queue_cnt = queue_.PendingBatchCount();
           if ((wait_microseconds == 0) && (pending_batch_queue_cnt != 0)) {
+            // Pass the pending batch deadline up to the rate limiter for
+            // earliest deadline first allocation.
+            curr_payload_->UpdateDeadline(
+                queue_.OldestEnqueueTime(), queue_.ClosestTimeout());
             curr_payload_->ReserveRequests(pending_batch_queue_cnt);
             for (size_t idx = 0; idx < pending_batch_queue_cnt; ++idx) {
               std::unique_ptr<InferenceRequest> request;
               auto status = queue_.Dequeue(&request);
               if (status.IsOk()) {
                 if (preserve_ordering_ || response_cache_enabled_) {
-                  DelegateResponse(request);
+                  owner_->DelegateResponse(request);
                 }
                 curr_payload_->AddRequest(std::move(request));
+                payload_request_count_++;
               } else {
                 // The queue is empty which conflicts with pending batch
                 // count. Send the current batch if any and reset related
@@ -394,16 +1524,42 @@ DynamicBatchScheduler::BatcherThread(const int nice)
           }
         }
       }
+      queued_request_count_ = queue_.Size();
+      oldest_enqueue_ns_ =
+          (queue_.PendingBatchCount() != 0) ? queue_.OldestEnqueueTime() : 0;
+      ReportQueueSizes();
 
       // If no requests are to be handled, wait for notification or
       // for the specified timeout before checking the queue again.
       if (wait_microseconds > 0) {
-        std::chrono::microseconds wait_timeout(wait_microseconds);
-        cv_.wait_for(lock, wait_timeout);
+        {
+          std::lock_guard<std::mutex> exec_lock(
+              *(curr_payload_->GetExecMutex()));
+          batcher_wake_any_ =
+              payload_saturated_ || IsStaleState(curr_payload_->GetState());
+        }
+        // Publish that the batcher is parking before checking the ring,
+        // see the matching fence in Enqueue().
+        batcher_parked_ = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ingress_enabled_ || ingress_.Empty()) {
+          std::chrono::microseconds wait_timeout(wait_microseconds);
+          cv_.wait_for(lock, wait_timeout);
+        }
+        batcher_parked_ = false;
       }
     }
 
     if (curr_payload_->GetState() == Payload::State::READY) {
+      curr_payload_->ReportTraceActivity(TRITONSERVER_TRACE_BATCH_FORMED);
+#ifdef TRITON_ENABLE_METRICS
+      if (reporter_ != nullptr) {
+        reporter_->ReportBatcherBatch(
+            curr_payload_->BatchSize(), max_batch_size_);
+      }
+#endif  // TRITON_ENABLE_METRICS
+      CPU_STAGE_SCOPE(
+          cpu_stage_, model_->MutableStatsAggregator(), RATE_LIMITER);
       auto callback = [this]() { cv_.notify_one(); };
       curr_payload_->SetCallback(callback);
       model_->Server()->GetRateLimiter()->EnqueuePayload(model_, curr_payload_);
@@ -413,12 +1569,24 @@ DynamicBatchScheduler::BatcherThread(const int nice)
     if (rejected_requests != nullptr) {
       static Status rejected_status =
           Status(Status::Code::UNAVAILABLE, "Request timeout expired");
+      static Status cancelled_status =
+          Status(Status::Code::UNAVAILABLE, "Request cancelled");
+      size_t rejected_count = 0;
       for (auto& rejected_queue : *rejected_requests) {
+        rejected_count += rejected_queue.size();
         for (auto& rejected_request : rejected_queue) {
           InferenceRequest::RespondIfError(
-              rejected_request, rejected_status, true);
+              rejected_request,
+              rejected_request->IsCancelled() ? cancelled_status
+                                              : rejected_status,
+              true);
         }
       }
+#ifdef TRITON_ENABLE_METRICS
+      if ((reporter_ != nullptr) && (rejected_count != 0)) {
+        reporter_->ReportBatcherRejected(rejected_count);
+      }
+#endif  // TRITON_ENABLE_METRICS
     }
   }  // end runner loop
 
@@ -426,6 +1594,28 @@ DynamicBatchScheduler::BatcherThread(const int nice)
                  << "...";
 }
 
+void
+DynamicBatchScheduler::ReportQueueSizes()
+{
+  // 'mu_' mutex must be held when this function is called.
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ == nullptr) {
+    return;
+  }
+
+  queue_.SizePerPriorityLevel(&queue_sizes_);
+  reported_queue_sizes_.resize(queue_sizes_.size(), 0);
+  for (size_t idx = 0; idx < queue_sizes_.size(); ++idx) {
+    if (queue_sizes_[idx] != reported_queue_sizes_[idx]) {
+      reporter_->ReportBatcherQueueSizeChange(
+          idx, static_cast<double>(queue_sizes_[idx]) -
+                   static_cast<double>(reported_queue_sizes_[idx]));
+      reported_queue_sizes_[idx] = queue_sizes_[idx];
+    }
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
 uint64_t
 DynamicBatchScheduler::GetDynamicBatch()
 {
@@ -594,8 +1784,196 @@ DynamicBatchScheduler::GetDynamicBatch()
 }
 
 void
-DynamicBatchScheduler::DelegateResponse(
+DynamicBatchScheduler::EnableShapeBuckets(const uint64_t granularity)
+{
+  shape_buckets_ = true;
+  shape_bucket_granularity_ = granularity;
+#ifdef TRITON_ENABLE_GPU
+  // Shape tensors in GPU memory are copied to the host to compute their
+  // bucket, on a stream that doesn't synchronize with other work.
+  for (const auto& pr : enforce_equal_shape_tensors_) {
+    if (pr.second) {
+      auto cuerr =
+          cudaStreamCreateWithFlags(&shape_copy_stream_, cudaStreamNonBlocking);
+      if (cuerr != cudaSuccess) {
+        shape_copy_stream_ = nullptr;
+        LOG_ERROR << "unable to create stream for shape tensors of "
+                  << model_->Name() << ": " << cudaGetErrorString(cuerr);
+      }
+      break;
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+  if (granularity == 0) {
+    return;
+  }
+
+  // Only the non-shape tensors with variable dimensions can be padded,
+  // the padding must also apply to the dimensions seen by the backend.
+  for (const auto& input : model_->Config().input()) {
+    const auto itr = enforce_equal_shape_tensors_.find(input.name());
+    if ((itr == enforce_equal_shape_tensors_.end()) || itr->second ||
+        input.has_reshape() ||
+        (input.data_type() == inference::DataType::TYPE_STRING)) {
+      continue;
+    }
+    shape_bucket_dims_.emplace(
+        input.name(),
+        std::vector<int64_t>(input.dims().begin(), input.dims().end()));
+  }
+  LOG_VERBOSE(1) << "Shape buckets enabled for " << model_->Name()
+                 << " with padding granularity " << granularity;
+}
+
+uint64_t
+DynamicBatchScheduler::GetBucketedBatch(
+    std::shared_ptr<std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>*
+        rejected_requests)
+{
+  // 'mu_' mutex must be held when this function is called. Apply the
+  // queue policy to all queued requests and take the rejected ones out of
+  // their buckets before looking for a ready bucket.
+  queue_.ResetCursor();
+  pending_batch_size_ = 0;
+  queued_batch_size_ -= queue_.ApplyPolicyAtCursor();
+  queue_.ReleaseRejectedRequests(rejected_requests);
+  for (const auto& rejected_queue : **rejected_requests) {
+    for (const auto& request : rejected_queue) {
+      RemoveFromShapeBucket(*request);
+    }
+  }
+  if (shape_bucket_index_.Empty()) {
+    return 0;
+  }
+
+  const size_t full_batch_size = (max_preferred_batch_size_ != 0)
+                                     ? max_preferred_batch_size_
+                                     : max_batch_size_;
+  const uint64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  uint64_t key;
+  const uint64_t wait_ns = shape_bucket_index_.NextReady(
+      now_ns, full_batch_size, pending_batch_delay_ns_, &key);
+  if (wait_ns != 0) {
+    return std::max<uint64_t>(1, wait_ns / 1000);
+  }
+
+  std::vector<std::unique_ptr<InferenceRequest>> requests;
+  const size_t batch_size = queue_.DequeueIf(
+      [key](const InferenceRequest& request) {
+        return request.ShapeBucketKey() == key;
+      },
+      full_batch_size, shape_bucket_index_.Count(key), &requests);
+  uint64_t oldest_enqueue_ns = 0;
+  for (const auto& request : requests) {
+    RemoveFromShapeBucket(*request);
+    if ((oldest_enqueue_ns == 0) ||
+        (request->BatcherStartNs() < oldest_enqueue_ns)) {
+      oldest_enqueue_ns = request->BatcherStartNs();
+    }
+  }
+  curr_payload_->UpdateDeadline(oldest_enqueue_ns, 0 /* closest_timeout */);
+  curr_payload_->ReserveRequests(requests.size());
+  for (auto& request : requests) {
+    curr_payload_->AddRequest(std::move(request));
+    payload_request_count_++;
+  }
+  if (curr_payload_->GetState() == Payload::State::UNINITIALIZED) {
+    curr_payload_->SetState(Payload::State::READY);
+  }
+  queued_batch_size_ -= batch_size;
+
+  // The payload only holds the requests of one bucket.
+  payload_saturated_ = true;
+  return 0;
+}
+
+void
+DynamicBatchScheduler::RemoveFromShapeBucket(const InferenceRequest& request)
+{
+  // 'mu_' mutex must be held when this function is called.
+  if (shape_buckets_) {
+    shape_bucket_index_.Remove(
+        request.ShapeBucketKey(), std::max(1U, request.BatchSize()),
+        request.BatcherStartNs());
+  }
+}
+
+void
+DynamicBatchScheduler::PadToShapeBucket(
     std::unique_ptr<InferenceRequest>& request)
+{
+  // Collect the inputs to pad first, adding an override input replaces
+  // the entry of the input.
+  std::vector<std::pair<InferenceRequest::Input*, std::vector<int64_t>>>
+      padded_inputs;
+  for (const auto& pr : request->ImmutableInputs()) {
+    const auto itr = shape_bucket_dims_.find(pr.input_->Name());
+    if (itr == shape_bucket_dims_.end()) {
+      continue;
+    }
+    const auto& shape = pr.input_->Shape();
+    if (shape.size() != itr->second.size()) {
+      continue;
+    }
+    std::vector<int64_t> padded_shape(shape);
+    for (size_t idx = 0; idx < shape.size(); ++idx) {
+      if (itr->second[idx] == -1) {
+        padded_shape[idx] = BucketDim(shape[idx], shape_bucket_granularity_);
+      }
+    }
+    if (padded_shape != shape) {
+      padded_inputs.emplace_back(pr.input_, std::move(padded_shape));
+    }
+  }
+
+  for (auto& pr : padded_inputs) {
+    // Only a single buffer in CPU memory is padded, otherwise the input
+    // keeps its shape and so its own bucket.
+    const std::shared_ptr<Memory> data = pr.first->Data();
+    if (data->BufferCount() != 1) {
+      continue;
+    }
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    const char* buffer =
+        data->BufferAt(0, &byte_size, &memory_type, &memory_type_id);
+    if ((buffer == nullptr) || (memory_type == TRITONSERVER_MEMORY_GPU)) {
+      continue;
+    }
+    const std::string name = pr.first->Name();
+    const auto datatype = pr.first->DType();
+    const std::vector<int64_t> shape = pr.first->ShapeWithBatchDim();
+    const size_t element_size = triton::common::GetDataTypeByteSize(datatype);
+    if (triton::common::GetByteSize(datatype, shape) !=
+        static_cast<int64_t>(byte_size)) {
+      continue;
+    }
+
+    std::shared_ptr<InferenceRequest::Input> padded;
+    if (!request
+             ->AddOverrideInput(
+                 name, datatype, request->BatchSize(), pr.second, &padded)
+             .IsOk()) {
+      continue;
+    }
+    const int64_t padded_byte_size =
+        triton::common::GetByteSize(datatype, padded->ShapeWithBatchDim());
+    auto memory = std::make_shared<AllocatedMemory>(
+        padded_byte_size, TRITONSERVER_MEMORY_CPU_PINNED, 0 /* id */);
+    PadTensor(
+        buffer, shape, padded->ShapeWithBatchDim(), element_size,
+        memory->MutableBuffer());
+    padded->SetData(memory);
+  }
+}
+
+void
+DynamicBatchScheduler::DelegateResponse(
+    const std::unique_ptr<InferenceRequest>& request)
 {
   std::lock_guard<std::mutex> lock(completion_queue_mtx_);
   completion_queue_.emplace_back();
@@ -607,11 +1985,18 @@ DynamicBatchScheduler::DelegateResponse(
   request->SetResponseDelegator(
       [this, queue_slot, raw_request_ptr](
           std::unique_ptr<InferenceResponse>&& response, const uint32_t flags) {
+        // The requests waiting for this one are released once its
+        // response is cached
+        const bool release_coalesced =
+            cache_single_flight_ && raw_request_ptr->CacheKeyIsSet() &&
+            ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0);
+        const uint64_t cache_key = raw_request_ptr->CacheKey();
         if (response_cache_enabled_ && raw_request_ptr->CacheKeyIsSet()) {
           // Cache insertion happens here because we need the backend to have
           // computed the inference response first in the case of cache miss
           auto cache = model_->Server()->GetResponseCache();
-          auto status = cache->Insert(*response, raw_request_ptr);
+          auto status = cache->Insert(
+              *response, raw_request_ptr, cache_usage_, cache_policy_);
           bool cache_miss =
               (status.StatusCode() != Status::Code::ALREADY_EXISTS);
           if (cache_miss) {
@@ -620,8 +2005,18 @@ DynamicBatchScheduler::DelegateResponse(
             // as we still spend time on lookup and attempting to insert
             raw_request_ptr->ReportStatisticsCacheMiss(reporter_.get());
 #endif  // TRITON_ENABLE_STATS
+#ifdef TRITON_ENABLE_METRICS
+            if (reporter_ != nullptr) {
+              reporter_->ReportCacheUsage(
+                  cache_usage_->allocated_bytes_,
+                  (status.StatusCode() == Status::Code::UNAVAILABLE));
+            }
+#endif  // TRITON_ENABLE_METRICS
 
-            if (!status.IsOk()) {
+            if (status.StatusCode() == Status::Code::UNAVAILABLE) {
+              LOG_VERBOSE(1) << raw_request_ptr->LogRequest()
+                             << status.Message();
+            } else if (!status.IsOk()) {
               LOG_ERROR << raw_request_ptr->LogRequest()
                         << "Failed to insert request_hash ["
                         << raw_request_ptr->CacheKey()
@@ -639,6 +2034,9 @@ DynamicBatchScheduler::DelegateResponse(
         } else {
           InferenceResponse::Send(std::move(response), flags);
         }
+        if (release_coalesced) {
+          ReleaseCoalescedRequests(cache_key, raw_request_ptr);
+        }
       });
 }
 
@@ -647,6 +2045,7 @@ DynamicBatchScheduler::CacheLookUp(
     std::unique_ptr<InferenceRequest>& request,
     std::unique_ptr<InferenceResponse>& cached_response)
 {
+  CPU_STAGE_SCOPE(cpu_stage_, model_->MutableStatsAggregator(), CACHE_LOOKUP);
   auto cache = model_->Server()->GetResponseCache();
   // Lookup request in cache
   std::unique_ptr<InferenceResponse> local_response;
@@ -662,6 +2061,71 @@ DynamicBatchScheduler::CacheLookUp(
   }
 }
 
+bool
+DynamicBatchScheduler::CoalesceCacheMiss(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  const uint64_t cache_key = request->CacheKey();
+  // Count the request before it is visible to the leader, which may
+  // release it right away
+  coalesced_request_count_++;
+  if (!coalesced_requests_.Join(cache_key, request)) {
+    return true;
+  }
+  coalesced_request_count_--;
+
+  // The waiting requests are released at the latest with this request,
+  // in case its response is never delegated, e.g. it times out in the
+  // queue.
+  const InferenceRequest* leader = request.get();
+  request->AddInternalReleaseCallback([this, cache_key, leader]() {
+    ReleaseCoalescedRequests(cache_key, leader);
+  });
+  return false;
+}
+
+Status
+DynamicBatchScheduler::ScheduleCoalesceLeader(
+    std::unique_ptr<InferenceRequest>& request)
+{
+  // The requests waiting for this one elect a new leader if it can't be
+  // scheduled
+  const uint64_t cache_key = request->CacheKey();
+  const InferenceRequest* leader = request.get();
+  auto status = ScheduleRequest(request);
+  if (!status.IsOk()) {
+    ReleaseCoalescedRequests(cache_key, leader);
+  }
+  return status;
+}
+
+void
+DynamicBatchScheduler::ReleaseCoalescedRequests(
+    const uint64_t cache_key, const InferenceRequest* leader)
+{
+  auto requests = coalesced_requests_.Release(cache_key, leader);
+  for (auto& request : requests) {
+    std::unique_ptr<InferenceResponse> cached_response;
+    CacheLookUp(request, cached_response);
+    if (cached_response != nullptr) {
+      InferenceResponse::Send(
+          std::move(cached_response), TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+      InferenceRequest::Release(
+          std::move(request), TRITONSERVER_REQUEST_RELEASE_ALL);
+    } else if (!CoalesceCacheMiss(request)) {
+      // The response wasn't cached, e.g. it is an error or it isn't
+      // admitted, so the first of the requests becomes the new leader
+      // and the others wait for it
+      auto status = ScheduleCoalesceLeader(request);
+      if (!status.IsOk()) {
+        InferenceRequest::RespondIfError(
+            request, status, true /* release_request */);
+      }
+    }
+    coalesced_request_count_--;
+  }
+}
+
 void
 DynamicBatchScheduler::FinalizeResponses()
 {
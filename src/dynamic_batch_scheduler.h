@@ -34,12 +34,19 @@
 #include <queue>
 #include <set>
 #include <thread>
+#include "admission_controller.h"
 #include "backend_model.h"
 #include "backend_model_instance.h"
+#include "instance_autoscaler.h"
 #include "model_config.pb.h"
+#include "mpsc_queue.h"
+#include "queue_delay_controller.h"
 #include "rate_limiter.h"
+#include "response_cache.h"
 #include "scheduler.h"
 #include "scheduler_utils.h"
+#include "shape_bucket_queue.h"
+#include "single_flight_groups.h"
 #include "status.h"
 #include "triton/common/model_config.h"
 
@@ -74,18 +81,23 @@ class DynamicBatchScheduler : public Scheduler {
   // \see Scheduler::Enqueue()
   Status Enqueue(std::unique_ptr<InferenceRequest>& request) override;
 
+  // \see Scheduler::EnqueueBatch()
+  Status EnqueueBatch(
+      std::vector<std::unique_ptr<InferenceRequest>>& requests) override;
+
   // \see Scheduler::InflightInferenceCount()
   size_t InflightInferenceCount() override
   {
-    std::unique_lock<std::mutex> lock(mu_);
-    if (curr_payload_ != nullptr) {
-      return queue_.Size() + curr_payload_->RequestCount();
+    size_t count = ingress_request_count_ + queued_request_count_ +
+                   payload_request_count_ + coalesced_request_count_;
+    for (const auto& lane : lanes_) {
+      count += lane->InflightInferenceCount();
     }
-    return queue_.Size();
+    return count;
   }
 
   // \see Scheduler::Stop()
-  void Stop() override { stop_ = true; }
+  void Stop() override;
 
   MetricModelReporter* MetricReporter() const { return reporter_.get(); }
 
@@ -99,16 +111,46 @@ class DynamicBatchScheduler : public Scheduler {
       const uint64_t max_queue_delay_microseconds,
       const inference::ModelQueuePolicy& default_queue_policy,
       const uint32_t priority_levels,
-      const ModelQueuePolicyMap& queue_policy_map);
+      const ModelQueuePolicyMap& queue_policy_map,
+      const uint64_t latency_slo_microseconds,
+      const bool learn_preferred_batch_sizes);
 
-  void BatcherThread(const int nice);
+  void BatcherThread(
+      const int nice,
+      const triton::common::HostPolicyCmdlineConfig& host_policy);
+  Status EnqueueToBatcher(std::unique_ptr<InferenceRequest>& request);
+  Status EnqueueToQueue(std::unique_ptr<InferenceRequest>& request);
+  Status AdmitRequest(const InferenceRequest& request);
+  void UpdateAdmission();
+  DynamicBatchScheduler* SelectLane();
+  void StealRequests();
   void NewPayload();
+  void DrainIngress();
+  void UpdateQueueDelay();
+  void UpdatePreferredBatchSizes();
+  void UpdateCudaGraphBatchSizes();
+  void AutoscaleThread();
+  void StopAutoscale();
+  void ReportQueueSizes();
+  bool ShouldWakeBatcher();
   uint64_t GetDynamicBatch();
-  void DelegateResponse(std::unique_ptr<InferenceRequest>& request);
+  void EnableShapeBuckets(const uint64_t granularity);
+  uint64_t GetBucketedBatch(
+      std::shared_ptr<
+          std::vector<std::deque<std::unique_ptr<InferenceRequest>>>>*
+          rejected_requests);
+  void PadToShapeBucket(std::unique_ptr<InferenceRequest>& request);
+  void RemoveFromShapeBucket(const InferenceRequest& request);
+  void DelegateResponse(const std::unique_ptr<InferenceRequest>& request);
   void CacheLookUp(
       std::unique_ptr<InferenceRequest>& request,
       std::unique_ptr<InferenceResponse>& cached_response);
   void FinalizeResponses();
+  Status ScheduleRequest(std::unique_ptr<InferenceRequest>& request);
+  bool CoalesceCacheMiss(std::unique_ptr<InferenceRequest>& request);
+  Status ScheduleCoalesceLeader(std::unique_ptr<InferenceRequest>& request);
+  void ReleaseCoalescedRequests(
+      const uint64_t cache_key, const InferenceRequest* leader);
 
   TritonModel* model_;
   TritonModelInstance* model_instance_;
@@ -125,10 +167,45 @@ class DynamicBatchScheduler : public Scheduler {
   std::thread scheduler_thread_;
   std::atomic<bool> scheduler_thread_exit_;
 
+  // If the model is configured with more than one batcher thread, each
+  // thread runs in a lane, a scheduler owned by this one that batches
+  // the requests assigned to it. This scheduler then only does the cache
+  // lookup, assigns requests to the lanes and sequences the responses
+  // through 'completion_queue_'. An idle lane steals requests queued in
+  // the other lanes. 'owner_' is the scheduler that owns this lane, or
+  // this scheduler if it is not a lane.
+  std::vector<std::unique_ptr<DynamicBatchScheduler>> lanes_;
+  DynamicBatchScheduler* owner_;
+
   // Mutex and condvar for signaling scheduler thread
   std::mutex mu_;
   std::condition_variable cv_;
 
+  // Requests enqueued by the callers that have not been moved into
+  // 'queue_' yet. Producers push without holding 'mu_' and the batcher
+  // thread drains the ring at the start of every iteration. Not used if
+  // any queue policy has a maximum queue size, as rejecting a request
+  // must then be done synchronously in Enqueue().
+  MPSCQueue<std::unique_ptr<InferenceRequest>> ingress_;
+  bool ingress_enabled_;
+
+  // Whether the batcher thread is waiting for new requests, producers
+  // only signal 'cv_' when it is set.
+  std::atomic<bool> batcher_parked_;
+  // Whether the batcher thread must be woken by any new request
+  // regardless of the queued batch size, that is, the current payload
+  // is saturated or stale.
+  std::atomic<bool> batcher_wake_any_;
+
+  // Request counts for InflightInferenceCount(), 'queued_request_count_'
+  // and 'payload_request_count_' are only updated with 'mu_' held.
+  std::atomic<size_t> ingress_request_count_;
+  std::atomic<size_t> queued_request_count_;
+  std::atomic<size_t> payload_request_count_;
+  // The enqueue time of the oldest request in the pending batch, 0 if
+  // there is none, updated with 'mu_' held.
+  std::atomic<uint64_t> oldest_enqueue_ns_;
+
   std::shared_ptr<RateLimiter> rate_limiter_;
 
   std::shared_ptr<Payload> curr_payload_;
@@ -137,12 +214,62 @@ class DynamicBatchScheduler : public Scheduler {
   size_t max_batch_size_;
   size_t max_preferred_batch_size_;
   std::set<int32_t> preferred_batch_sizes_;
+
+  // If true, 'preferred_batch_sizes_' is learned from the latency profile
+  // of the model instances.
+  const bool learn_preferred_batch_sizes_;
+  uint64_t last_profile_update_ns_;
+
+  // If true, the batch sizes that the instances captured a CUDA graph for
+  // are added to 'preferred_batch_sizes_', and kept when the preferred
+  // batch sizes are learned. 'cuda_graph_generation_' is the sum of the
+  // registry generations of the instances when last added.
+  bool prefer_cuda_graph_batch_sizes_;
+  uint64_t cuda_graph_generation_;
+  std::set<int32_t> cuda_graph_batch_sizes_;
   uint64_t pending_batch_delay_ns_;
+
+  // If set, 'pending_batch_delay_ns_' is adjusted by the controller to
+  // meet the latency SLO of the model. 'arrival_count_' counts the
+  // requests enqueued, the remaining members are the values observed at
+  // the last adjustment.
+  std::unique_ptr<QueueDelayController> delay_controller_;
+  std::atomic<uint64_t> arrival_count_;
+  uint64_t last_arrival_count_;
+  uint64_t last_delay_update_ns_;
+#ifdef TRITON_ENABLE_STATS
+  std::map<size_t, InferenceStatsAggregator::InferBatchStats>
+      last_batch_stats_;
+#endif  // TRITON_ENABLE_STATS
+
+  // If set, requests whose latency budget can't be met are rejected on
+  // arrival. Only set on the scheduler that owns the lanes. The
+  // executions are recorded by the thread that locks 'admission_mu_'
+  // once the update interval has passed since 'last_admission_update_ns_',
+  // from the batch statistics observed at the last update.
+  std::unique_ptr<AdmissionController> admission_controller_;
+  std::mutex admission_mu_;
+  uint64_t last_admission_update_ns_;
+#ifdef TRITON_ENABLE_STATS
+  std::map<size_t, InferenceStatsAggregator::InferBatchStats>
+      admission_batch_stats_;
+#endif  // TRITON_ENABLE_STATS
+
+  // If set, instances are added to the model while the queues of this
+  // scheduler and its lanes are under pressure and retired once they are
+  // idle, decided periodically on 'autoscale_thread_'. Only set on the
+  // scheduler that owns the lanes.
+  std::unique_ptr<InstanceAutoscaler> autoscaler_;
+  std::thread autoscale_thread_;
+  std::mutex autoscale_mu_;
+  std::condition_variable autoscale_cv_;
+  bool autoscale_exit_;
+
   size_t pending_batch_size_;
   RequiredEqualInputs required_equal_inputs_;
 
-  size_t queued_batch_size_;
-  size_t next_preferred_batch_size_;
+  std::atomic<size_t> queued_batch_size_;
+  std::atomic<size_t> next_preferred_batch_size_;
 
   // The input tensors that require shape checking before being
   // allowed in a batch. As a map from the tensor name to a bool. If
@@ -156,6 +283,23 @@ class DynamicBatchScheduler : public Scheduler {
   // Store information on whether the model contains optional inputs.
   bool has_optional_input_;
 
+  // If set, the batcher buckets the queued requests by the shape of
+  // 'enforce_equal_shape_tensors_' and dispatches each bucket by its own
+  // batch size and delay, instead of closing the pending batch whenever
+  // the shape changes. The requests stay in 'queue_' until their bucket
+  // is dispatched so the queue policies still apply, 'shape_bucket_index_'
+  // tracks the buckets of the requests in 'queue_'. If the granularity
+  // is not 0, the variable dimensions of the inputs in
+  // 'shape_bucket_dims_' are padded with zeros to a multiple of the
+  // granularity, as a map from the input name to its dimensions in the
+  // model configuration. Shape tensors in GPU memory are copied to the
+  // host on 'shape_copy_stream_' to compute their bucket.
+  bool shape_buckets_;
+  ShapeBucketIndex shape_bucket_index_;
+  uint64_t shape_bucket_granularity_;
+  std::unordered_map<std::string, std::vector<int64_t>> shape_bucket_dims_;
+  cudaStream_t shape_copy_stream_;
+
   // If true the ordering of responses matches the order of requests
   // even when there are multiple scheduler threads.
   const bool preserve_ordering_;
@@ -163,6 +307,17 @@ class DynamicBatchScheduler : public Scheduler {
   // If true, the scheduler will try to retrieve responses from cache.
   bool response_cache_enabled_;
 
+  // If true, the cache misses identical to an executing request, the
+  // leader, wait for its response to be cached instead of executing. The
+  // waiting requests are grouped by the cache key of the leader.
+  bool cache_single_flight_;
+  SingleFlightGroups<InferenceRequest> coalesced_requests_;
+  // Usage and policy of the model in the response cache, resolved once
+  // so that insertions don't look the model up in the cache
+  std::shared_ptr<CacheModelUsage> cache_usage_;
+  RequestResponseCache::ModelPolicy cache_policy_;
+  std::atomic<size_t> coalesced_request_count_;
+
   // Per completion-id queues to store the ready responses
   std::deque<
       std::vector<std::pair<std::unique_ptr<InferenceResponse>, uint32_t>>>
@@ -172,6 +327,14 @@ class DynamicBatchScheduler : public Scheduler {
 
   // Reporter for metrics, or nullptr if no metrics should be reported
   std::shared_ptr<MetricModelReporter> reporter_;
+
+#ifdef TRITON_ENABLE_METRICS
+  // The sizes of 'queue_' per priority level last published to
+  // 'reporter_', and the buffer used to sample them. Only accessed
+  // with 'mu_' held.
+  std::vector<size_t> reported_queue_sizes_;
+  std::vector<size_t> queue_sizes_;
+#endif  // TRITON_ENABLE_METRICS
 };
 
 }}  // namespace triton::core
@@ -28,8 +28,14 @@
 
 #include "ensemble_scheduler.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <mutex>
+#include "constants.h"
+#include "copy_batch.h"
 #include "cuda_utils.h"
+#include "ensemble_utils.h"
 #include "metrics.h"
 #include "model.h"
 #include "model_config_utils.h"
@@ -38,12 +44,234 @@
 
 namespace triton { namespace core {
 
+EnsembleStepBatcher::EnsembleStepBatcher(const uint64_t delay_us)
+    : delay_(delay_us), exit_(false)
+{
+  thread_ = std::thread([this]() { BatcherThread(); });
+}
+
+EnsembleStepBatcher::~EnsembleStepBatcher()
+{
+  // The batcher thread enqueues the requests that are still held before
+  // exiting.
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    exit_ = true;
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool
+EnsembleStepBatcher::Batchable(const inference::ModelConfig& config)
+{
+  // Only the models that get the default scheduler execute the requests
+  // as they arrive. A response cache lookup is done request by request,
+  // and the shape tensors of the requests must match to be batched.
+  if ((config.max_batch_size() <= 1) || config.has_dynamic_batching() ||
+      config.has_sequence_batching() || config.has_ensemble_scheduling() ||
+      config.response_cache().enable()) {
+    return false;
+  }
+  for (const auto& input : config.input()) {
+    if (input.is_shape_tensor()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+EnsembleStepBatcher::Enqueue(std::unique_ptr<InferenceRequest>&& request)
+{
+  // The request is queued from the time it is held, the composing model
+  // keeps the queue start timestamp that is already set.
+  request->CaptureQueueStartNs();
+  INFER_TRACE_ACTIVITY(
+      request->Trace(), TRITONSERVER_TRACE_QUEUE_START,
+      request->QueueStartNs());
+
+  std::vector<Batch> ready;
+  bool new_batch = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    Model* model = request->ModelRaw();
+    const size_t max_batch_size = model->Config().max_batch_size();
+    const size_t batch_size = std::max(1U, request->BatchSize());
+
+    auto& pending = pending_[model];
+    if (!pending.requests_.empty() &&
+        (((pending.batch_size_ + batch_size) > max_batch_size) ||
+         !SameShapes(*pending.requests_.front(), *request))) {
+      ready.emplace_back(std::move(pending.requests_));
+      pending.requests_.clear();
+    }
+    if (pending.requests_.empty()) {
+      pending.batch_size_ = 0;
+      pending.deadline_ = std::chrono::steady_clock::now() + delay_;
+      new_batch = true;
+    }
+    pending.batch_size_ += batch_size;
+    pending.requests_.emplace_back(std::move(request));
+    if (pending.batch_size_ >= max_batch_size) {
+      ready.emplace_back(std::move(pending.requests_));
+      pending_.erase(model);
+      new_batch = false;
+    }
+  }
+
+  if (new_batch) {
+    cv_.notify_one();
+  }
+  Dispatch(&ready);
+}
+
+void
+EnsembleStepBatcher::BatcherThread()
+{
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    std::vector<Batch> ready;
+    const auto now = std::chrono::steady_clock::now();
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      if (exit_ || (it->second.deadline_ <= now)) {
+        ready.emplace_back(std::move(it->second.requests_));
+        it = pending_.erase(it);
+      } else {
+        next_deadline = std::min(next_deadline, it->second.deadline_);
+        ++it;
+      }
+    }
+
+    if (!ready.empty()) {
+      lock.unlock();
+      Dispatch(&ready);
+      lock.lock();
+    } else if (exit_) {
+      break;
+    } else if (next_deadline == std::chrono::steady_clock::time_point::max()) {
+      cv_.wait(lock);
+    } else {
+      cv_.wait_until(lock, next_deadline);
+    }
+  }
+}
+
+void
+EnsembleStepBatcher::Dispatch(std::vector<Batch>* batches)
+{
+  for (auto& requests : *batches) {
+    Model* model = requests.front()->ModelRaw();
+    Status status = model->EnqueueBatch(requests);
+    if (!status.IsOk()) {
+      for (auto& request : requests) {
+        if (request != nullptr) {
+          InferenceRequest::RespondIfError(
+              request, status, true /* release_request */);
+        }
+      }
+    }
+  }
+}
+
+bool
+EnsembleStepBatcher::SameShapes(
+    const InferenceRequest& lhs, const InferenceRequest& rhs)
+{
+  const auto& lhs_inputs = lhs.OriginalInputs();
+  const auto& rhs_inputs = rhs.OriginalInputs();
+  if (lhs_inputs.size() != rhs_inputs.size()) {
+    return false;
+  }
+  const auto& config = lhs.ModelRaw()->Config();
+  for (const auto& pr : lhs_inputs) {
+    const auto it = rhs_inputs.find(pr.first);
+    if (it == rhs_inputs.end()) {
+      return false;
+    }
+    if (!config.input(pr.second.ConfigIndex()).allow_ragged_batch() &&
+        (pr.second.Shape() != it->second.Shape())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 namespace {
 
 class EnsembleContext;
 
 using IterationCount = size_t;
 
+// An ensemble tensor ID and the iteration of the tensor
+using TensorIteration = std::pair<size_t, IterationCount>;
+
+// Return in 'tensor_id' the ensemble tensor that 'name' is mapped to in
+// 'mapping', or false if 'name' is not mapped.
+bool
+MappedTensor(
+    const std::vector<std::pair<std::string, size_t>>& mapping,
+    const char* name, size_t* tensor_id)
+{
+  for (const auto& pair : mapping) {
+    if (pair.first == name) {
+      *tensor_id = pair.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+// A buffer of an intermediate tensor at its planned offset in the slab
+// of an ensemble request. The slab stays allocated as long as any of its
+// buffers is used.
+class SlabMemory : public MutableMemory {
+ public:
+  SlabMemory(
+      const std::shared_ptr<AllocatedMemory>& slab, char* buffer,
+      size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id)
+      : MutableMemory(buffer, byte_size, memory_type, memory_type_id),
+        slab_(slab)
+  {
+  }
+
+ private:
+  std::shared_ptr<AllocatedMemory> slab_;
+};
+
+#ifdef TRITON_ENABLE_METRICS
+uint64_t
+StepTimestampNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif  // TRITON_ENABLE_METRICS
+
+#ifdef TRITON_ENABLE_GPU
+// Collect in 'devices' the GPUs that the instances of the model with
+// 'config' are placed on. Return false if the model has instances that are
+// not on GPU or are placed by the model itself.
+bool
+InstanceDevices(
+    const inference::ModelConfig& config, std::set<int64_t>* devices)
+{
+  devices->clear();
+  for (const auto& group : config.instance_group()) {
+    if (group.kind() != inference::ModelInstanceGroup::KIND_GPU) {
+      return false;
+    }
+    devices->insert(group.gpus().begin(), group.gpus().end());
+  }
+  return !devices->empty();
+}
+#endif  // TRITON_ENABLE_GPU
+
 // Request tracker is passed as 'userp' in RequestRelease function and used
 // to manage the lifecycle of the ensemble request
 class RequestTracker {
@@ -77,7 +305,7 @@ class RequestTracker {
     inflight_request_counter_--;
     if (inflight_request_counter_ == 0) {
 #ifdef TRITON_ENABLE_STATS
-      const auto& infer_stats = context_stats_aggregator_.ImmutableInferStats();
+      const auto infer_stats = context_stats_aggregator_.InferStatsSnapshot();
       request_->ReportStatisticsWithDuration(
           metric_reporter_, status_.IsOk(), compute_start_ns_,
           infer_stats.compute_input_duration_ns_,
@@ -134,16 +362,26 @@ struct Step {
 
   std::mutex output_mtx_;
   // Different output map to avoid address conflict from different memory types
-  std::unordered_map<uintptr_t, std::shared_ptr<AllocatedMemory>>
+  std::unordered_map<uintptr_t, std::shared_ptr<MutableMemory>>
       cpu_output_map_;
   std::unordered_map<
-      int64_t, std::unordered_map<uintptr_t, std::shared_ptr<AllocatedMemory>>>
+      int64_t, std::unordered_map<uintptr_t, std::shared_ptr<MutableMemory>>>
       gpu_output_map_;
-  std::set<std::pair<std::string, IterationCount>> updated_tensors_;
+  std::vector<TensorIteration> updated_tensors_;
   uint32_t response_flags_;
   TRITONSERVER_Error* infer_status_;
 
   size_t step_idx_;
+
+#ifdef TRITON_ENABLE_METRICS
+  // When the step became ready and its request was enqueued, the time
+  // spent handling its responses, and the step whose completion made it
+  // ready.
+  uint64_t ready_ns_ = 0;
+  uint64_t dispatch_ns_ = 0;
+  uint64_t update_ns_ = 0;
+  size_t trigger_step_idx_ = EnsembleInfo::kNoStep;
+#endif  // TRITON_ENABLE_METRICS
 };
 
 struct TensorData {
@@ -163,8 +401,21 @@ struct TensorData {
           flags_(flags)
     {
     }
+    Metadata(Metadata&& other)
+        : data_(std::move(other.data_)),
+          device_data_(std::move(other.device_data_)),
+          remaining_reference_count_(other.remaining_reference_count_.load()),
+          parameter_override_(other.parameter_override_),
+          correlation_id_(other.correlation_id_), flags_(other.flags_)
+    {
+    }
     std::unique_ptr<InferenceRequest::Input> data_;
-    size_t remaining_reference_count_;
+    // Copies of the data materialized on the GPUs of the consuming steps,
+    // keyed by device id, so that a tensor fed to several steps is copied
+    // at most once to each device. Released with the tensor.
+    std::map<int64_t, std::shared_ptr<Memory>> device_data_;
+    // Decremented by each consuming step, which may run concurrently.
+    std::atomic<size_t> remaining_reference_count_;
     bool parameter_override_;
     InferenceRequest::SequenceId correlation_id_;
     uint32_t flags_;
@@ -223,8 +474,9 @@ class EnsembleContext {
   EnsembleContext(
       MetricModelReporter* metric_reporter,
       InferenceStatsAggregator* stats_aggregator, InferenceServer* is,
-      EnsembleInfo* info, std::unique_ptr<InferenceRequest>& request,
-      cudaStream_t stream);
+      EnsembleInfo* info, EnsembleStepBatcher* step_batcher,
+      std::unique_ptr<InferenceRequest>& request, cudaStream_t stream);
+  ~EnsembleContext();
 
   // Perform transition on 'context' state given the information of
   // 'completed_step'
@@ -255,7 +507,6 @@ class EnsembleContext {
       void* userp);
 
   using StepList = std::vector<std::unique_ptr<Step>>;
-  using VersionMap = std::unordered_map<int64_t, std::shared_ptr<Model>>;
 
   // Helper function to reshape the given tensor according to the
   // config shape and batching info and its actual shape and batching info.
@@ -271,8 +522,8 @@ class EnsembleContext {
   Status PrepareSteps(
       const std::unique_ptr<Step>& completed_step, StepList* steps);
 
-  // Prepare infer stats and call the inference server's function to process
-  // the infer requests specified in 'steps'
+  // Prepare infer stats and enqueue the infer requests specified in 'steps'
+  // to their models
   static void ScheduleSteps(
       const std::shared_ptr<EnsembleContext>& context, StepList&& steps);
 
@@ -280,14 +531,47 @@ class EnsembleContext {
   // returns the list of updated tensors in 'updated_tensors'
   Status UpdateEnsembleState(
       const std::unique_ptr<Step>& completed_step,
-      std::set<std::pair<std::string, IterationCount>>* updated_tensors);
+      std::vector<TensorIteration>* updated_tensors);
 
   // Helper function that returns a list of 'steps' that should be run under
   // current ensemble state. 'updated_tensors' is used so that we don't need to
-  // iterate all the tensors to determine which step can be run.
+  // iterate all the tensors to determine which step can be run. The outputs
+  // of the ready steps that are skipped are appended to 'updated_tensors'.
   Status GetNextSteps(
-      const std::set<std::pair<std::string, IterationCount>>& updated_tensors,
-      StepList* steps);
+      std::vector<TensorIteration>* updated_tensors, StepList* steps);
+
+  // Helper function that returns in 'run_step' whether the condition
+  // 'tensor_id' of a gated step has a true element at 'iteration_count'.
+  Status EvaluateCondition(
+      const size_t tensor_id, const IterationCount iteration_count,
+      bool* run_step);
+
+  // Helper function that skips the step at 'step_idx' for
+  // 'iteration_count', setting its outputs to zero-filled tensors of the
+  // output shapes in the model config, with no elements along the
+  // dimensions of variable size. The outputs are appended to
+  // 'updated_tensors'.
+  Status SkipStep(
+      const size_t step_idx, const IterationCount iteration_count,
+      std::vector<TensorIteration>* updated_tensors);
+
+  // Helper function that releases the input tensors of the step at
+  // 'step_idx' for 'iteration_count' once the last step using them has
+  // taken them.
+  void ReleaseStepInputs(
+      const size_t step_idx, const IterationCount iteration_count);
+
+  // Helper function that appends to 'steps' the next iteration held back
+  // for the step of 'completed_step' if it is the last response of the
+  // step. Otherwise the in-flight request of the step is released.
+  Status ResumeHeldStep(
+      const std::unique_ptr<Step>& completed_step, StepList* steps);
+
+#ifdef TRITON_ENABLE_METRICS
+  // Helper function that publishes the steps on the critical path of the
+  // ensemble request once all steps are completed.
+  void ReportCriticalPath();
+#endif  // TRITON_ENABLE_METRICS
 
   // Helper function that completes the response of the ensemble request
   Status FinishEnsemble(
@@ -299,35 +583,124 @@ class EnsembleContext {
       const size_t step_idx, const IterationCount iteration_count,
       std::unique_ptr<Step>* step);
 
+  // Helper function that returns in 'consumer_device' the GPU that the
+  // output 'tensor_name' of the step at 'step_idx' should be allocated on so
+  // that all the steps consuming it can use it without an extra copy.
+  // Return false if the output should stay on 'preferred_device', i.e. it is
+  // already there, the consumers don't share a GPU, or the GPU isn't
+  // directly accessible from 'preferred_device'.
+  bool ConsumerDevice(
+      const size_t step_idx, const std::string& tensor_name,
+      const int64_t preferred_device, int64_t* consumer_device) const;
+
+  // Helper function that returns in 'buffer' the planned buffer in the
+  // slab on the preferred device for the output 'tensor_name' of the step
+  // at 'step_idx'. Return false if the output is not planned with
+  // 'byte_size' and must be allocated on its own.
+  bool SlabBuffer(
+      const size_t step_idx, const char* tensor_name, const size_t byte_size,
+      const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+      std::shared_ptr<MutableMemory>* buffer);
+
+  // Helper function that returns in 'data' the data to be used by 'model'
+  // for the ensemble tensor 'tensor' that feeds 'outgoing_steps_count'
+  // steps. If the tensor is shared by several steps and 'model' runs on a
+  // single GPU the data is materialized once on that GPU and reused by the
+  // other steps running there.
+  Status StepInputData(
+      const std::shared_ptr<Model>& model, const size_t outgoing_steps_count,
+      TensorData::Metadata* tensor, std::shared_ptr<Memory>* data);
+
   // Helper function that set the output of the ensemble request if it is ready
   // and valid.
   Status CheckAndSetEnsembleOutput(
-      const std::set<std::pair<std::string, IterationCount>>& updated_tensors,
+      const std::vector<TensorIteration>& updated_tensors,
       std::unique_ptr<InferenceResponse>* response);
 
   InferenceServer* is_;
 
   EnsembleInfo* info_;
 
-  // All EnsembleContext will use the same CUDA stream managed by
-  // the ensemble scheduler
-  cudaStream_t stream_;
+  EnsembleStepBatcher* step_batcher_;
 
-  // Mutex to avoid concurrent call on 'PrepareSteps' where ensemble state
-  // are being modified
-  std::mutex mutex_;
+#ifdef TRITON_ENABLE_METRICS
+  MetricModelReporter* metric_reporter_;
 
-  size_t inflight_step_counter_;
+  // The timing of the request of each step, used to find the critical
+  // path of a non-decoupled ensemble. Each step sets its own timing when
+  // it completes. Empty if the step metrics are not published.
+  struct StepTiming {
+    bool completed_ = false;
+    uint64_t ready_ns_ = 0;
+    uint64_t end_ns_ = 0;
+    size_t trigger_step_idx_ = EnsembleInfo::kNoStep;
+  };
+  std::vector<StepTiming> step_timings_;
+#endif  // TRITON_ENABLE_METRICS
 
-  // pointer that either points to 'pruned_tensor_to_step_' or to
-  // 'info_->tensor_to_step_' if all ensemble outputs are requested
-  std::unordered_map<std::string, std::set<size_t>>* tensor_to_step_;
+  // The CUDA stream of the context, one of the streams managed by the
+  // ensemble scheduler
+  cudaStream_t stream_;
 
-  std::unordered_map<std::string, std::set<size_t>> pruned_tensor_to_step_;
-  std::unordered_map<std::string, TensorData> tensor_data_;
+  // Mutex to avoid concurrent call on 'PrepareSteps' where ensemble state
+  // are being modified. A non-decoupled ensemble only takes it to complete
+  // the ensemble, see PrepareSteps().
+  std::mutex mutex_;
 
-  // Handle to all models that may be used in the ensemble
-  std::unordered_map<std::string, VersionMap> handles_;
+  std::atomic<size_t> inflight_step_counter_;
+
+  // Whether the ensemble response has been completed, no more step is
+  // scheduled once it is set.
+  std::atomic<bool> finished_;
+
+  // Protect the copies of the tensors materialized on the GPUs of the
+  // consuming steps, which may run concurrently.
+  std::mutex device_data_mtx_;
+
+  // The steps that are not needed because none of their outputs
+  // contributes to the requested outputs, indexed by step.
+  std::vector<bool> pruned_steps_;
+
+  // The data of the ensemble tensors, indexed by tensor ID.
+  std::vector<TensorData> tensor_data_;
+
+  // Whether each ensemble tensor is a requested output, indexed by
+  // tensor ID, and the requested outputs.
+  std::vector<bool> requested_tensors_;
+  std::vector<size_t> requested_outputs_;
+
+  // The number of input tensors that each step still waits for, indexed
+  // by step, and also by iteration for a decoupled ensemble. A step is
+  // ready for an iteration when the count reaches 0. The steps of a
+  // non-decoupled ensemble only run for iteration 0 and their counts are
+  // updated atomically by the completing steps.
+  std::unique_ptr<std::atomic<size_t>[]> ready_countdowns_;
+  std::vector<std::vector<size_t>> pending_input_cnts_;
+
+  // The number of requests in flight for each step, and the iterations
+  // of each step held back because the step has the maximum number of
+  // requests in flight. Only used if the in-flight step requests of a
+  // decoupled ensemble are limited.
+  std::vector<size_t> step_inflight_cnts_;
+  std::vector<std::deque<IterationCount>> held_iterations_;
+
+  // Handle to the model of each step, held so that the models are not
+  // unloaded while the ensemble is executing.
+  std::vector<std::shared_ptr<Model>> step_models_;
+
+  // The template of each step for the models in 'step_models_'.
+  std::vector<std::shared_ptr<const EnsembleInfo::StepTemplate>>
+      step_templates_;
+
+  // The placement of the intermediate tensors of the request, nullptr if
+  // none is planned, and the slab allocated for them on each device on
+  // the first allocation there.
+  std::shared_ptr<const EnsembleInfo::MemoryPlan> memory_plan_;
+  std::mutex slab_mtx_;
+  std::map<
+      std::pair<TRITONSERVER_MemoryType, int64_t>,
+      std::shared_ptr<AllocatedMemory>>
+      slabs_;
 
   // Request specific information that obtained from ensemble request and
   // should be applied to all internal requests
@@ -337,7 +710,9 @@ class EnsembleContext {
   uint32_t priority_;
   uint64_t timeout_;
 
-  // Objects related to the ensemble infer request
+  // Objects related to the ensemble infer request. The context holds a
+  // reference on 'request_tracker_' until it is destroyed, so that the
+  // ensemble request stays valid while any step is being prepared.
   Status ensemble_status_;
   RequestTracker* request_tracker_;
 
@@ -352,11 +727,19 @@ class EnsembleContext {
 EnsembleContext::EnsembleContext(
     MetricModelReporter* metric_reporter,
     InferenceStatsAggregator* stats_aggregator, InferenceServer* is,
-    EnsembleInfo* info, std::unique_ptr<InferenceRequest>& request,
-    cudaStream_t stream)
-    : is_(is), info_(info), stream_(stream), inflight_step_counter_(0),
+    EnsembleInfo* info, EnsembleStepBatcher* step_batcher,
+    std::unique_ptr<InferenceRequest>& request, cudaStream_t stream)
+    : is_(is), info_(info), step_batcher_(step_batcher), stream_(stream),
+      inflight_step_counter_(0), finished_(false),
       allocator_(nullptr, TRITONSERVER_ResponseAllocatorDelete)
 {
+#ifdef TRITON_ENABLE_METRICS
+  metric_reporter_ = metric_reporter;
+  if ((metric_reporter_ != nullptr) && !info_->is_decoupled_) {
+    step_timings_.resize(info_->steps_.size());
+  }
+#endif  // TRITON_ENABLE_METRICS
+
   uint64_t compute_start_ns = 0;
   INFER_STATS_SET_TIMESTAMP(compute_start_ns);
   request_tracker_ = new RequestTracker(
@@ -367,61 +750,79 @@ EnsembleContext::EnsembleContext(
   // Obtain model handles of all models in ensemble request such that
   // they have the same lifetime as the ensemble request to avoid unloading
   // while the ensemble is executing.
+  step_models_.reserve(info_->steps_.size());
   for (const auto& step_info : info_->steps_) {
-    auto it = handles_.find(step_info.model_name_);
-    if (it == handles_.end()) {
-      it = handles_.emplace(std::make_pair(step_info.model_name_, VersionMap()))
-               .first;
-    }
-    auto ver_it = it->second.find(step_info.model_version_);
-    if (ver_it == it->second.end()) {
-      std::shared_ptr<Model> model = nullptr;
+    std::shared_ptr<Model> model = nullptr;
+    for (size_t idx = 0; idx < step_models_.size(); ++idx) {
+      const auto& prev_step_info = info_->steps_[idx];
+      if ((prev_step_info.model_name_ == step_info.model_name_) &&
+          (prev_step_info.model_version_ == step_info.model_version_)) {
+        model = step_models_[idx];
+        break;
+      }
+    }
+    if (model == nullptr) {
       ensemble_status_ = is_->GetModel(
           step_info.model_name_, step_info.model_version_, &model);
       if (!ensemble_status_.IsOk()) {
         break;
       }
-
-      it->second.emplace(std::make_pair(step_info.model_version_, model));
     }
+    step_models_.emplace_back(std::move(model));
   }
 
-  // Prune ensemble first if not all outputs are requested
-  std::set<std::string> ignored_tensor;
-  for (const auto& ensemble_output : info_->ensemble_output_shape_) {
-    ignored_tensor.insert(ensemble_output.first);
+  if (ensemble_status_.IsOk()) {
+    info_->StepTemplates(step_models_, &step_templates_);
+    memory_plan_ = info_->GetMemoryPlan(step_templates_, lrequest->BatchSize());
   }
+
+  const size_t tensor_cnt = info_->tensor_names_.size();
+  requested_tensors_.assign(tensor_cnt, false);
   for (const auto& requested_output : lrequest->ImmutableRequestedOutputs()) {
-    ignored_tensor.erase(requested_output);
+    const auto it = info_->tensor_ids_.find(requested_output);
+    if (it != info_->tensor_ids_.end()) {
+      requested_tensors_[it->second] = true;
+      requested_outputs_.push_back(it->second);
+    }
   }
-  if (ignored_tensor.empty()) {
-    tensor_to_step_ = &(info_->tensor_to_step_);
-  } else {
-    pruned_tensor_to_step_ = info_->tensor_to_step_;
-    tensor_to_step_ = &pruned_tensor_to_step_;
+
+  // The number of steps consuming each tensor
+  std::vector<size_t> consumer_cnts(tensor_cnt);
+  for (size_t tensor_id = 0; tensor_id < tensor_cnt; ++tensor_id) {
+    consumer_cnts[tensor_id] = info_->tensor_to_step_[tensor_id].size();
+  }
+
+  // Prune ensemble first if not all outputs are requested
+  pruned_steps_.assign(info_->steps_.size(), false);
+  std::vector<size_t> ignored_tensor;
+  for (const auto& ensemble_output : info_->ensemble_outputs_) {
+    if (!requested_tensors_[ensemble_output.first]) {
+      ignored_tensor.push_back(ensemble_output.first);
+    }
+  }
+  if (!ignored_tensor.empty()) {
     // Backward traversal
-    std::unordered_map<size_t, size_t> step_requested_output_count;
+    std::vector<size_t> step_requested_output_count(info_->steps_.size());
+    for (size_t idx = 0; idx < info_->steps_.size(); ++idx) {
+      step_requested_output_count[idx] =
+          info_->steps_[idx].output_to_tensor_.size();
+    }
     while (!ignored_tensor.empty()) {
-      std::set<std::string> new_ignored_tensor;
-      for (const auto& output : ignored_tensor) {
-        auto step_idx = info_->tensor_to_prev_step_[output];
-        auto& step = info_->steps_[step_idx];
-        auto it = step_requested_output_count.find(step_idx);
-        if (it == step_requested_output_count.end()) {
-          auto output_count = step.output_to_tensor_.size();
-          it =
-              step_requested_output_count.emplace(step_idx, output_count).first;
+      std::vector<size_t> new_ignored_tensor;
+      for (const auto output : ignored_tensor) {
+        const size_t step_idx = info_->tensor_to_prev_step_[output];
+        if (step_idx == EnsembleInfo::kNoStep) {
+          continue;
         }
         // If none of the outputs of the step is requested,
         // then the step can be pruned
-        if (--it->second == 0) {
-          for (const auto& input : step.input_to_tensor_) {
-            auto& step_set = pruned_tensor_to_step_[input.second];
-            step_set.erase(step_idx);
+        if (--step_requested_output_count[step_idx] == 0) {
+          pruned_steps_[step_idx] = true;
+          for (const auto input : info_->steps_[step_idx].input_tensors_) {
             // If all steps depend on a tensor are pruned,
             // then the tensor can be ignored.
-            if (step_set.empty()) {
-              new_ignored_tensor.insert(input.second);
+            if (--consumer_cnts[input] == 0) {
+              new_ignored_tensor.push_back(input);
             }
           }
         }
@@ -430,14 +831,23 @@ EnsembleContext::EnsembleContext(
     }
   }
 
-  for (const auto& pair : *tensor_to_step_) {
-    const auto& requested_outputs = lrequest->ImmutableRequestedOutputs();
-    // For requested outputs, add 1 to outgoing count as the ensemble itself
-    // isn't counted as step.
-    if (requested_outputs.find(pair.first) != requested_outputs.end()) {
-      tensor_data_.emplace(pair.first, TensorData(pair.second.size() + 1));
-    } else {
-      tensor_data_.emplace(pair.first, TensorData(pair.second.size()));
+  // For requested outputs, add 1 to outgoing count as the ensemble itself
+  // isn't counted as step.
+  tensor_data_.reserve(tensor_cnt);
+  for (size_t tensor_id = 0; tensor_id < tensor_cnt; ++tensor_id) {
+    tensor_data_.emplace_back(
+        consumer_cnts[tensor_id] + (requested_tensors_[tensor_id] ? 1 : 0));
+  }
+  if (info_->is_decoupled_) {
+    pending_input_cnts_.resize(info_->steps_.size());
+    if (info_->max_inflight_step_requests_ > 0) {
+      step_inflight_cnts_.assign(info_->steps_.size(), 0);
+      held_iterations_.resize(info_->steps_.size());
+    }
+  } else {
+    ready_countdowns_.reset(new std::atomic<size_t>[info_->steps_.size()]);
+    for (size_t idx = 0; idx < info_->steps_.size(); ++idx) {
+      ready_countdowns_[idx].store(info_->steps_[idx].input_tensors_.size());
     }
   }
 
@@ -449,10 +859,10 @@ EnsembleContext::EnsembleContext(
     timeout_ = lrequest->TimeoutMicroseconds();
 
     for (const auto& pr : lrequest->ImmutableInputs()) {
-      const InferenceRequest::Input* input = pr.second;
-      auto it = tensor_data_.find(input->Name());
-      if (it != tensor_data_.end()) {
-        auto& tensor_data = it->second;
+      const InferenceRequest::Input* input = pr.input_;
+      auto it = info_->tensor_ids_.find(input->Name());
+      if (it != info_->tensor_ids_.end()) {
+        auto& tensor_data = tensor_data_[it->second];
         // Shape() represents reshaped value without batch dimension,
         // thus need to fill it if necessary.
         std::unique_ptr<InferenceRequest::Input> tensor;
@@ -467,6 +877,7 @@ EnsembleContext::EnsembleContext(
               input->Name(), input->DType(), input->Shape()));
         }
         tensor->SetData(input->Data());
+        tensor->SetStringOffsets(input->CachedStringOffsets());
         for (const auto& host_policy_data : input->HostPolicyData()) {
           tensor->SetData(host_policy_data.first, host_policy_data.second);
         }
@@ -482,11 +893,11 @@ EnsembleContext::EnsembleContext(
 
     // Iterate the ensemble optional inputs and add empty tensor data entry
     // if the input is not provided
-    for (const auto& name : info_->optional_inputs_) {
-      auto it = tensor_data_.find(name);
-      if ((it != tensor_data_.end()) && it->second.tensor_.empty()) {
-        it->second.AddTensor(nullptr);
-        it->second.batch_size_ = lrequest->BatchSize();
+    for (const auto tensor_id : info_->optional_inputs_) {
+      auto& tensor_data = tensor_data_[tensor_id];
+      if (tensor_data.tensor_.empty()) {
+        tensor_data.AddTensor(nullptr);
+        tensor_data.batch_size_ = lrequest->BatchSize();
       }
     }
   }
@@ -508,6 +919,13 @@ EnsembleContext::EnsembleContext(
   }
 }
 
+EnsembleContext::~EnsembleContext()
+{
+  if (request_tracker_->DecrementCounter()) {
+    delete request_tracker_;
+  }
+}
+
 TRITONSERVER_Error*
 EnsembleContext::ResponseAlloc(
     TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
@@ -519,15 +937,34 @@ EnsembleContext::ResponseAlloc(
   *buffer = nullptr;
   *buffer_userp = nullptr;
 
-  auto allocated_buffer = std::make_shared<AllocatedMemory>(
-      byte_size, preferred_memory_type, preferred_memory_type_id);
+  // Place the intermediate output on the GPU of the downstream steps
+  // instead of bouncing it between devices.
+  auto step = reinterpret_cast<Step*>(userp);
+  if (preferred_memory_type == TRITONSERVER_MEMORY_GPU) {
+    int64_t consumer_device;
+    if (step->ctx_->ConsumerDevice(
+            step->step_idx_, tensor_name, preferred_memory_type_id,
+            &consumer_device)) {
+      LOG_VERBOSE(2) << "Internal response allocation: " << tensor_name
+                     << ", placed on consuming GPU " << consumer_device
+                     << " instead of GPU " << preferred_memory_type_id;
+      preferred_memory_type_id = consumer_device;
+    }
+  }
+
+  std::shared_ptr<MutableMemory> allocated_buffer;
+  if (!step->ctx_->SlabBuffer(
+          step->step_idx_, tensor_name, byte_size, preferred_memory_type,
+          preferred_memory_type_id, &allocated_buffer)) {
+    allocated_buffer = std::make_shared<AllocatedMemory>(
+        byte_size, preferred_memory_type, preferred_memory_type_id);
+  }
 
   auto mutable_buffer = allocated_buffer->MutableBuffer(
       allocated_memory_type, allocated_memory_type_id);
   if ((mutable_buffer != nullptr) || (byte_size == 0)) {
     if (byte_size != 0) {
       *buffer = static_cast<void*>(mutable_buffer);
-      auto step = reinterpret_cast<Step*>(userp);
       std::lock_guard<std::mutex> lk(step->output_mtx_);
       if (*allocated_memory_type == TRITONSERVER_MEMORY_GPU) {
         step->gpu_output_map_[*allocated_memory_type_id].emplace(
@@ -566,10 +1003,121 @@ EnsembleContext::OutputBufferQuery(
     const char* tensor_name, size_t* byte_size,
     TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
 {
-  // Ensemble will always attempt to satisfy any output buffer request
+  // Ensemble will always attempt to satisfy any output buffer request, but
+  // a GPU output is reported on the device that ResponseAlloc will place it.
+  if (*memory_type == TRITONSERVER_MEMORY_GPU) {
+    auto step = reinterpret_cast<Step*>(userp);
+    int64_t consumer_device;
+    if (step->ctx_->ConsumerDevice(
+            step->step_idx_, tensor_name, *memory_type_id, &consumer_device)) {
+      *memory_type_id = consumer_device;
+    }
+  }
   return nullptr;  // Success
 }
 
+bool
+EnsembleContext::SlabBuffer(
+    const size_t step_idx, const char* tensor_name, const size_t byte_size,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    std::shared_ptr<MutableMemory>* buffer)
+{
+  size_t tensor_id;
+  if ((memory_plan_ == nullptr) || (byte_size == 0) ||
+      !MappedTensor(
+          info_->steps_[step_idx].output_to_tensor_, tensor_name,
+          &tensor_id) ||
+      (memory_plan_->byte_sizes_[tensor_id] != byte_size)) {
+    return false;
+  }
+
+  std::shared_ptr<AllocatedMemory> slab;
+  {
+    std::lock_guard<std::mutex> lk(slab_mtx_);
+    auto& device_slab = slabs_[std::make_pair(memory_type, memory_type_id)];
+    if (device_slab == nullptr) {
+      device_slab = std::make_shared<AllocatedMemory>(
+          memory_plan_->slab_byte_size_, memory_type, memory_type_id);
+    }
+    slab = device_slab;
+  }
+
+  TRITONSERVER_MemoryType slab_memory_type;
+  int64_t slab_memory_type_id;
+  char* base = slab->MutableBuffer(&slab_memory_type, &slab_memory_type_id);
+  if (base == nullptr) {
+    return false;
+  }
+  buffer->reset(new SlabMemory(
+      slab, base + memory_plan_->offsets_[tensor_id], byte_size,
+      slab_memory_type, slab_memory_type_id));
+  return true;
+}
+
+bool
+EnsembleContext::ConsumerDevice(
+    const size_t step_idx, const std::string& tensor_name,
+    const int64_t preferred_device, int64_t* consumer_device) const
+{
+#ifdef TRITON_ENABLE_GPU
+  size_t tensor_id;
+  if (!MappedTensor(
+          info_->steps_[step_idx].output_to_tensor_, tensor_name.c_str(),
+          &tensor_id)) {
+    return false;
+  }
+
+  // The GPUs that all the consuming steps have instances on. A consumer
+  // with instances that are not on GPU, or that are placed by the model
+  // itself, gives no usable hint.
+  std::set<int64_t> devices;
+  bool first_consumer = true;
+  for (const auto consumer_idx : info_->tensor_to_step_[tensor_id]) {
+    if (pruned_steps_[consumer_idx]) {
+      continue;
+    }
+    if (consumer_idx >= step_models_.size()) {
+      return false;
+    }
+    std::set<int64_t> model_devices;
+    if (!InstanceDevices(
+            step_models_[consumer_idx]->Config(), &model_devices)) {
+      return false;
+    }
+
+    if (first_consumer) {
+      devices.swap(model_devices);
+      first_consumer = false;
+    } else {
+      for (auto it = devices.begin(); it != devices.end();) {
+        if (model_devices.find(*it) == model_devices.end()) {
+          it = devices.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    if (devices.empty()) {
+      return false;
+    }
+  }
+  if (first_consumer) {
+    return false;
+  }
+
+  if (devices.find(preferred_device) != devices.end()) {
+    return false;
+  }
+  for (const auto device : devices) {
+    if (IsPeerAccessEnabled(preferred_device, device)) {
+      *consumer_device = device;
+      return true;
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+  return false;
+}
+
 void
 EnsembleContext::RequestComplete(
     TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
@@ -591,6 +1139,20 @@ EnsembleContext::ResponseComplete(
 {
   auto step_ptr = std::unique_ptr<Step>(reinterpret_cast<Step*>(userp));
   step_ptr->response_flags_ = flags;
+#ifdef TRITON_ENABLE_METRICS
+  auto& context = step_ptr->ctx_;
+  const uint64_t response_ns =
+      (context->metric_reporter_ != nullptr) ? StepTimestampNs() : 0;
+  const bool final_response =
+      ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0);
+  if (final_response && !context->step_timings_.empty()) {
+    auto& timing = context->step_timings_[step_ptr->step_idx_];
+    timing.ready_ns_ = step_ptr->ready_ns_;
+    timing.end_ns_ = response_ns;
+    timing.trigger_step_idx_ = step_ptr->trigger_step_idx_;
+    timing.completed_ = true;
+  }
+#endif  // TRITON_ENABLE_METRICS
 
   if (response != nullptr) {
     auto err = TRITONSERVER_InferenceResponseError(response);
@@ -659,7 +1221,13 @@ EnsembleContext::ResponseComplete(
     if (err == nullptr) {
       err = TRITONSERVER_InferenceResponseOutputCount(response, &count);
       if (err == nullptr) {
-        std::lock_guard<std::mutex> lock(step_ptr->ctx_->mutex_);
+        // The outputs of a step are only set by that step, unless the
+        // ensemble is decoupled. See PrepareSteps().
+        std::unique_lock<std::mutex> lock(
+            step_ptr->ctx_->mutex_, std::defer_lock);
+        if (step_ptr->ctx_->info_->is_decoupled_) {
+          lock.lock();
+        }
         auto& output_to_tensor =
             step_ptr->ctx_->info_->steps_[step_ptr->step_idx_]
                 .output_to_tensor_;
@@ -677,12 +1245,12 @@ EnsembleContext::ResponseComplete(
               response, idx, &name, &datatype, &shape, &dim_count, &base,
               &byte_size, &memory_type, &memory_type_id, &userp);
           if (err == nullptr) {
-            auto it = output_to_tensor.find(name);
-            if (it != output_to_tensor.end()) {
+            size_t tensor_id;
+            if (MappedTensor(output_to_tensor, name, &tensor_id)) {
               std::unique_ptr<InferenceRequest::Input> tensor(
                   new InferenceRequest::Input(
-                      it->second, TritonToDataType(datatype), shape,
-                      dim_count));
+                      step_ptr->ctx_->info_->tensor_names_[tensor_id],
+                      TritonToDataType(datatype), shape, dim_count));
 
               if (byte_size != 0) {
                 std::lock_guard<std::mutex> output_lk(step_ptr->output_mtx_);
@@ -699,19 +1267,24 @@ EnsembleContext::ResponseComplete(
                   tensor->SetData(std::move(it->second));
                   step_ptr->cpu_output_map_.erase(it);
                 }
+                // Pass the string offsets provided by the step on to
+                // the steps consuming the output.
+                tensor->SetStringOffsets(
+                    reinterpret_cast<InferenceResponse*>(response)
+                        ->Outputs()[idx]
+                        .StringOffsets());
               }
 
-              auto& tensor_data = step_ptr->ctx_->tensor_data_[it->second];
+              auto& tensor_data = step_ptr->ctx_->tensor_data_[tensor_id];
               if (parameter_override) {
-                step_ptr->updated_tensors_.emplace(
-                    it->second, tensor_data.AddTensor(
-                                    std::move(tensor), correlation_id, flags));
+                step_ptr->updated_tensors_.emplace_back(
+                    tensor_id, tensor_data.AddTensor(
+                                   std::move(tensor), correlation_id, flags));
               } else {
-                step_ptr->updated_tensors_.emplace(
-                    it->second,
-                    tensor_data.AddTensor(
-                        std::move(tensor), step_ptr->correlation_id_,
-                        step_ptr->flags_));
+                step_ptr->updated_tensors_.emplace_back(
+                    tensor_id, tensor_data.AddTensor(
+                                   std::move(tensor), step_ptr->correlation_id_,
+                                   step_ptr->flags_));
               }
             } else {
               LOG_VERBOSE(1)
@@ -736,6 +1309,17 @@ EnsembleContext::ResponseComplete(
   }
 
   EnsembleContext::Proceed(step_ptr->ctx_, step_ptr);
+#ifdef TRITON_ENABLE_METRICS
+  if (context->metric_reporter_ != nullptr) {
+    step_ptr->update_ns_ += StepTimestampNs() - response_ns;
+    if (final_response) {
+      context->metric_reporter_->ReportEnsembleStep(
+          context->info_->StepMetrics(step_ptr->step_idx_),
+          step_ptr->dispatch_ns_ - step_ptr->ready_ns_,
+          response_ns - step_ptr->dispatch_ns_, step_ptr->update_ns_);
+    }
+  }
+#endif  // TRITON_ENABLE_METRICS
   // Expecting more responses
   if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
     step_ptr.release();
@@ -758,54 +1342,95 @@ Status
 EnsembleContext::PrepareSteps(
     const std::unique_ptr<Step>& completed_step, StepList* ready_steps)
 {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
+  // The state of a decoupled ensemble is updated with 'mutex_' held, as
+  // its steps may set a tensor several times. Otherwise each tensor is
+  // set once, by the step producing it, and a step is made ready by the
+  // completion of its last input with an atomic countdown. Then only the
+  // completion of the ensemble requires 'mutex_'.
+  std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+  if (info_->is_decoupled_) {
+    lock.lock();
+  }
+
+  // Initialization error, ensemble status will be not ok since the
+  // beginning. No step is running yet.
+  if ((completed_step == nullptr) && !ensemble_status_.IsOk()) {
+    ensemble_status_ = FinishEnsemble();
+    return ensemble_status_;
+  }
 
-    // Initialization error, ensemble status will be not ok since the beginning
-    if (completed_step == nullptr && !ensemble_status_.IsOk()) {
-      ensemble_status_ = FinishEnsemble();
+  std::vector<TensorIteration> updated_tensors;
+  Status status = UpdateEnsembleState(completed_step, &updated_tensors);
+  if (status.IsOk() && !finished_) {
+#ifdef TRITON_ENABLE_METRICS
+    const uint64_t ready_ns =
+        (metric_reporter_ != nullptr) ? StepTimestampNs() : 0;
+#endif  // TRITON_ENABLE_METRICS
+    status = GetNextSteps(&updated_tensors, ready_steps);
+    if (status.IsOk()) {
+      status = ResumeHeldStep(completed_step, ready_steps);
+    }
+#ifdef TRITON_ENABLE_METRICS
+    for (auto& step : *ready_steps) {
+      if (step != nullptr) {
+        step->ready_ns_ = ready_ns;
+        if (completed_step != nullptr) {
+          step->trigger_step_idx_ = completed_step->step_idx_;
+        }
+      }
     }
+#endif  // TRITON_ENABLE_METRICS
+  }
 
+  // The steps made ready are counted before the completed step so that
+  // the count only reaches 0 once all steps are completed.
+  bool all_completed = false;
+  if (completed_step == nullptr) {
+    all_completed = (inflight_step_counter_ == 0);
+  } else if (
+      (completed_step->response_flags_ &
+       TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    all_completed = (inflight_step_counter_.fetch_sub(1) == 1);
+  }
+
+  // Check and send ensemble response
+  if ((!status.IsOk()) || all_completed || info_->is_decoupled_) {
+    if (!lock.owns_lock()) {
+      lock.lock();
+    }
     if (ensemble_status_.IsOk()) {
-      StepList res;
-      std::set<std::pair<std::string, IterationCount>> updated_tensors;
-      ensemble_status_ = UpdateEnsembleState(completed_step, &updated_tensors);
-      if (ensemble_status_.IsOk()) {
-        ensemble_status_ = GetNextSteps(updated_tensors, ready_steps);
+      ensemble_status_ = status;
+#ifdef TRITON_ENABLE_METRICS
+      if (all_completed && ensemble_status_.IsOk() &&
+          !step_timings_.empty()) {
+        ReportCriticalPath();
       }
-
-      // Check and send ensemble response
-      if ((!ensemble_status_.IsOk()) || (inflight_step_counter_ == 0) ||
-          info_->is_decoupled_) {
-        std::unique_ptr<InferenceResponse> response;
-        if (ensemble_status_.IsOk()) {
-          ensemble_status_ =
-              CheckAndSetEnsembleOutput(updated_tensors, &response);
-        }
-        ensemble_status_ = FinishEnsemble(std::move(response));
+#endif  // TRITON_ENABLE_METRICS
+      std::unique_ptr<InferenceResponse> response;
+      if (ensemble_status_.IsOk()) {
+        ensemble_status_ =
+            CheckAndSetEnsembleOutput(updated_tensors, &response);
       }
+      ensemble_status_ = FinishEnsemble(std::move(response));
     }
     return ensemble_status_;
   }
+  return status;
 }
 
 Status
 EnsembleContext::UpdateEnsembleState(
     const std::unique_ptr<Step>& completed_step,
-    std::set<std::pair<std::string, IterationCount>>* updated_tensors)
+    std::vector<TensorIteration>* updated_tensors)
 {
   updated_tensors->clear();
   if (completed_step == nullptr) {
-    for (const auto& tensor_data : tensor_data_) {
-      if (!tensor_data.second.tensor_.empty()) {
-        updated_tensors->emplace(tensor_data.first, 0);
+    for (size_t tensor_id = 0; tensor_id < tensor_data_.size(); ++tensor_id) {
+      if (!tensor_data_[tensor_id].tensor_.empty()) {
+        updated_tensors->emplace_back(tensor_id, 0);
       }
     }
   } else {
-    if (completed_step->response_flags_ &
-        TRITONSERVER_RESPONSE_COMPLETE_FINAL) {
-      inflight_step_counter_--;
-    }
     RETURN_IF_TRITONSERVER_ERROR(completed_step->infer_status_);
     updated_tensors->swap(completed_step->updated_tensors_);
   }
@@ -814,73 +1439,341 @@ EnsembleContext::UpdateEnsembleState(
 
 Status
 EnsembleContext::GetNextSteps(
-    const std::set<std::pair<std::string, IterationCount>>& updated_tensors,
-    StepList* steps)
+    std::vector<TensorIteration>* updated_tensors, StepList* steps)
 {
   steps->clear();
 
-  std::set<std::pair<size_t, IterationCount>> next_step_idx;
-  // Get steps whose tensors used for input are set
-  for (const auto updated_tensor : updated_tensors) {
-    const auto& step_idx = (*tensor_to_step_)[updated_tensor.first];
-    for (const auto& idx : step_idx) {
-      bool ready = true;
-      for (const auto& input_pair : info_->steps_[idx].input_to_tensor_) {
-        auto& tensor = tensor_data_[input_pair.second].tensor_;
-        if (tensor.empty()) {
-          ready = false;
-          break;
-        } else {
-          // Check if other inputs have tensor with corresponding iteration
-          // count
-          if (tensor.find(updated_tensor.second) == tensor.end()) {
-            ready = false;
-            break;
-          }
+  // Get steps whose tensors used for input are set. Each tensor is
+  // set once for an iteration, so a step is ready when the last of its
+  // input tensors for the iteration is set. A gated step whose condition
+  // is false sets its outputs right away, which may make other steps
+  // ready.
+  std::vector<std::pair<size_t, IterationCount>> next_step_idx;
+  for (size_t tensor_idx = 0; tensor_idx < updated_tensors->size();
+       ++tensor_idx) {
+    const TensorIteration updated_tensor = (*updated_tensors)[tensor_idx];
+    const IterationCount iteration_count = updated_tensor.second;
+    for (const auto idx : info_->tensor_to_step_[updated_tensor.first]) {
+      if (pruned_steps_[idx]) {
+        continue;
+      }
+      bool ready;
+      if (ready_countdowns_ != nullptr) {
+        ready = (ready_countdowns_[idx].fetch_sub(1) == 1);
+      } else {
+        auto& pending_cnts = pending_input_cnts_[idx];
+        if (pending_cnts.size() <= iteration_count) {
+          pending_cnts.resize(
+              iteration_count + 1, info_->steps_[idx].input_tensors_.size());
+        }
+        ready = (--pending_cnts[iteration_count] == 0);
+      }
+      if (!ready) {
+        continue;
+      }
+      const size_t condition_tensor = info_->steps_[idx].condition_tensor_;
+      if (condition_tensor != EnsembleInfo::kNoTensor) {
+        bool run_step;
+        RETURN_IF_ERROR(
+            EvaluateCondition(condition_tensor, iteration_count, &run_step));
+        if (!run_step) {
+          RETURN_IF_ERROR(SkipStep(idx, iteration_count, updated_tensors));
+          continue;
         }
       }
-      if (ready) {
-        next_step_idx.emplace(idx, updated_tensor.second);
+      next_step_idx.emplace_back(idx, iteration_count);
+    }
+  }
+  std::sort(next_step_idx.begin(), next_step_idx.end());
+
+  // Hold back the iterations of a step that already has the maximum
+  // number of requests in flight, they are resumed in order as the step
+  // completes its requests.
+  if (!step_inflight_cnts_.empty()) {
+    size_t scheduled_cnt = 0;
+    for (const auto& idx : next_step_idx) {
+      if (step_inflight_cnts_[idx.first] <
+          info_->max_inflight_step_requests_) {
+        ++step_inflight_cnts_[idx.first];
+        next_step_idx[scheduled_cnt++] = idx;
+      } else {
+        held_iterations_[idx.first].push_back(idx.second);
       }
     }
+    next_step_idx.resize(scheduled_cnt);
   }
 
+  // Count the steps before they are initialized, an error completes the
+  // ensemble anyway.
+  inflight_step_counter_ += next_step_idx.size();
   for (const auto& idx : next_step_idx) {
     steps->emplace_back();
     RETURN_IF_ERROR(InitStep(idx.first, idx.second, &(steps->back())));
   }
-  inflight_step_counter_ += steps->size();
 
   return Status::Success;
 }
 
+Status
+EnsembleContext::ResumeHeldStep(
+    const std::unique_ptr<Step>& completed_step, StepList* steps)
+{
+  if (step_inflight_cnts_.empty() || (completed_step == nullptr) ||
+      ((completed_step->response_flags_ &
+        TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0)) {
+    return Status::Success;
+  }
+
+  // The request of the completed step is handed to the held iteration.
+  const size_t step_idx = completed_step->step_idx_;
+  auto& held_iterations = held_iterations_[step_idx];
+  if (held_iterations.empty()) {
+    --step_inflight_cnts_[step_idx];
+    return Status::Success;
+  }
+  const IterationCount iteration_count = held_iterations.front();
+  held_iterations.pop_front();
+
+  ++inflight_step_counter_;
+  steps->emplace_back();
+  return InitStep(step_idx, iteration_count, &(steps->back()));
+}
+
+Status
+EnsembleContext::StepInputData(
+    const std::shared_ptr<Model>& model, const size_t outgoing_steps_count,
+    TensorData::Metadata* tensor, std::shared_ptr<Memory>* data)
+{
+  *data = tensor->data_->Data();
+#ifdef TRITON_ENABLE_GPU
+  // Only a tensor shared by several steps benefits from a shared copy,
+  // otherwise the model can copy the data itself. Host policy specific
+  // data is left to the model as well.
+  std::set<int64_t> devices;
+  if ((outgoing_steps_count < 2) || ((*data)->TotalByteSize() == 0) ||
+      tensor->data_->HasHostPolicySpecificData() ||
+      !InstanceDevices(model->Config(), &devices) || (devices.size() != 1)) {
+    return Status::Success;
+  }
+  const int64_t device = *devices.begin();
+
+  // The steps sharing the tensor may be prepared concurrently, the first
+  // one to run on the device makes the copy.
+  std::lock_guard<std::mutex> lk(device_data_mtx_);
+  auto it = tensor->device_data_.find(device);
+  if (it != tensor->device_data_.end()) {
+    *data = it->second;
+    return Status::Success;
+  }
+
+  // Nothing to do if the data is already on the device
+  bool on_device = true;
+  size_t buffer_byte_size;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  for (size_t idx = 0; on_device && (idx < (*data)->BufferCount()); ++idx) {
+    (*data)->BufferAt(idx, &buffer_byte_size, &memory_type, &memory_type_id);
+    on_device =
+        (memory_type == TRITONSERVER_MEMORY_GPU) && (memory_type_id == device);
+  }
+  if (on_device) {
+    return Status::Success;
+  }
+
+  auto device_data = std::make_shared<AllocatedMemory>(
+      (*data)->TotalByteSize(), TRITONSERVER_MEMORY_GPU, device);
+  char* buffer = device_data->MutableBuffer(&memory_type, &memory_type_id);
+  if ((buffer == nullptr) || (memory_type != TRITONSERVER_MEMORY_GPU)) {
+    return Status::Success;
+  }
+
+  CopyBatch copies(
+      "materialize ensemble tensor '" + tensor->data_->Name() + "'", stream_);
+  size_t offset = 0;
+  for (size_t idx = 0; idx < (*data)->BufferCount(); ++idx) {
+    TRITONSERVER_MemoryType src_memory_type;
+    int64_t src_memory_type_id;
+    const char* src = (*data)->BufferAt(
+        idx, &buffer_byte_size, &src_memory_type, &src_memory_type_id);
+    copies.Add(
+        src_memory_type, src_memory_type_id, memory_type, memory_type_id,
+        buffer_byte_size, src, buffer + offset);
+    offset += buffer_byte_size;
+  }
+  bool cuda_used = false;
+  RETURN_IF_ERROR(copies.Flush(&cuda_used));
+  if (cuda_used) {
+    RETURN_IF_CUDA_ERR(
+        cudaStreamSynchronize(stream_),
+        "failed to materialize ensemble tensor '" + tensor->data_->Name() +
+            "'");
+  }
+
+  tensor->device_data_.emplace(device, device_data);
+  *data = std::move(device_data);
+#endif  // TRITON_ENABLE_GPU
+  return Status::Success;
+}
+
+Status
+EnsembleContext::EvaluateCondition(
+    const size_t tensor_id, const IterationCount iteration_count,
+    bool* run_step)
+{
+  *run_step = false;
+  const auto& tensor =
+      tensor_data_[tensor_id].tensor_.find(iteration_count)->second;
+  // An optional ensemble input that is not provided is false.
+  if (tensor.data_ == nullptr) {
+    return Status::Success;
+  }
+
+  const auto& data = tensor.data_->Data();
+  for (size_t idx = 0; (idx < data->BufferCount()) && !*run_step; ++idx) {
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    const char* buffer =
+        data->BufferAt(idx, &byte_size, &memory_type, &memory_type_id);
+    std::vector<char> host_buffer;
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      host_buffer.resize(byte_size);
+      bool cuda_used = false;
+      RETURN_IF_ERROR(CopyBuffer(
+          tensor.data_->Name(), memory_type, memory_type_id,
+          TRITONSERVER_MEMORY_CPU, 0, byte_size, buffer, host_buffer.data(),
+          stream_, &cuda_used));
+      if (cuda_used) {
+#ifdef TRITON_ENABLE_GPU
+        RETURN_IF_CUDA_ERR(
+            cudaStreamSynchronize(stream_),
+            "failed to read step condition '" + tensor.data_->Name() + "'");
+#endif  // TRITON_ENABLE_GPU
+      }
+      buffer = host_buffer.data();
+    }
+    *run_step = std::any_of(buffer, buffer + byte_size, [](const char value) {
+      return value != 0;
+    });
+  }
+
+  return Status::Success;
+}
+
+Status
+EnsembleContext::SkipStep(
+    const size_t step_idx, const IterationCount iteration_count,
+    std::vector<TensorIteration>* updated_tensors)
+{
+  const auto& istep = info_->steps_[step_idx];
+  const auto& model = step_models_[step_idx];
+  const bool allow_batching = (model->ConfigSnapshot().max_batch_size_ > 0);
+
+  // The outputs have the batch size that the step would have run with,
+  // i.e. the batch dimension of its inputs.
+  int64_t batch_size = 1;
+  if (allow_batching) {
+    for (const auto& pair : istep.input_to_tensor_) {
+      const auto& tensor =
+          tensor_data_[pair.second].tensor_.find(iteration_count)->second;
+      if ((tensor.data_ != nullptr) &&
+          !tensor.data_->OriginalShape().empty()) {
+        batch_size = tensor.data_->OriginalShape()[0];
+        break;
+      }
+    }
+  }
+  ReleaseStepInputs(step_idx, iteration_count);
+
+  LOG_VERBOSE(1) << "Ensemble " << info_->ensemble_name_ << " skips step "
+                 << step_idx << " for iteration " << iteration_count
+                 << ", condition '"
+                 << info_->tensor_names_[istep.condition_tensor_]
+                 << "' is false";
+
+  for (const auto& pair : istep.output_to_tensor_) {
+    const inference::ModelOutput* output_config;
+    RETURN_IF_ERROR(model->GetOutput(pair.first, &output_config));
+    std::vector<int64_t> shape;
+    if (allow_batching) {
+      shape.push_back(batch_size);
+    }
+    size_t element_cnt = allow_batching ? batch_size : 1;
+    for (const auto dim : output_config->dims()) {
+      shape.push_back(std::max<int64_t>(dim, 0));
+      element_cnt *= shape.back();
+    }
+    // A string element of the default output is an empty string, i.e. its
+    // length prefix only.
+    const size_t byte_size =
+        element_cnt *
+        ((output_config->data_type() == inference::DataType::TYPE_STRING)
+             ? sizeof(uint32_t)
+             : triton::common::GetDataTypeByteSize(
+                   output_config->data_type()));
+
+    auto data = std::make_shared<AllocatedMemory>(
+        byte_size, TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */);
+    if (byte_size != 0) {
+      char* buffer = data->MutableBuffer();
+      if (buffer == nullptr) {
+        return Status(
+            Status::Code::INTERNAL,
+            "failed to allocate the default output '" + pair.first +
+                "' of skipped step " + std::to_string(step_idx));
+      }
+      memset(buffer, 0, byte_size);
+    }
+
+    std::unique_ptr<InferenceRequest::Input> tensor(new InferenceRequest::Input(
+        info_->tensor_names_[pair.second], output_config->data_type(), shape));
+    RETURN_IF_ERROR(tensor->SetData(data));
+    auto& tensor_data = tensor_data_[pair.second];
+    tensor_data.batch_size_ = allow_batching ? batch_size : 0;
+    updated_tensors->emplace_back(
+        pair.second, tensor_data.AddTensor(std::move(tensor)));
+  }
+
+  return Status::Success;
+}
+
+void
+EnsembleContext::ReleaseStepInputs(
+    const size_t step_idx, const IterationCount iteration_count)
+{
+  for (const auto tensor_id : info_->steps_[step_idx].input_tensors_) {
+    auto& tensor = tensor_data_[tensor_id].tensor_;
+    auto it = tensor.find(iteration_count);
+    if (it->second.remaining_reference_count_.fetch_sub(1) == 1) {
+      tensor.erase(it);
+    }
+  }
+}
+
 Status
 EnsembleContext::InitStep(
     const size_t step_idx, const IterationCount iteration_count,
     std::unique_ptr<Step>* step)
 {
   const auto& istep = info_->steps_[step_idx];
-  auto& version_map = handles_[istep.model_name_];
-  auto& model = version_map[istep.model_version_];
+  auto& model = step_models_[step_idx];
+  const auto& step_template = step_templates_[step_idx];
 
-  const bool allow_batching = (model->Config().max_batch_size() > 0);
+  const bool allow_batching = (model->ConfigSnapshot().max_batch_size_ > 0);
 
   auto irequest = std::unique_ptr<InferenceRequest>(
       new InferenceRequest(model, istep.model_version_));
 
-  // Store the pointers to tensors used so that we can prune them afterward.
-  // Can't prune the tensor in the input loop below as it may be used by
-  // multiple inputs in the same step.
-  std::map<TensorData*, size_t*> releasing_tensors;
-
   // Set inputs in request, prepare input map,
   // and set overridden parameter if any.
   auto correlation_id = correlation_id_;
   auto flags = flags_;
   bool parameter_set = false;
-  for (const auto& pair : istep.input_to_tensor_) {
+  for (size_t input_idx = 0; input_idx < istep.input_to_tensor_.size();
+       ++input_idx) {
+    const auto& pair = istep.input_to_tensor_[input_idx];
     auto& tensor_data = tensor_data_[pair.second];
-    auto& tensor = tensor_data.tensor_[iteration_count];
+    auto& tensor = tensor_data.tensor_.find(iteration_count)->second;
 
     // nullptr if and only if the tensor is optional ensemble input and
     // not provided in the ensemble request. In such case, we don't add
@@ -890,7 +1783,11 @@ EnsembleContext::InitStep(
       // If the actual shape and config shape agree with each other without
       // considering batch size, non-batch / batch conversion are not required.
       const inference::ModelInput* input_config;
-      model->GetInput(pair.first, &input_config);
+      if (step_template->matched_) {
+        input_config = step_template->input_configs_[input_idx];
+      } else {
+        RETURN_IF_ERROR(model->GetInput(pair.first, &input_config));
+      }
       auto shape = ReshapeTensorDims(
           input_config->dims(), allow_batching, tensor_data.batch_size_,
           tensor.data_->OriginalShape());
@@ -898,15 +1795,22 @@ EnsembleContext::InitStep(
       InferenceRequest::Input* input;
       RETURN_IF_ERROR(irequest->AddOriginalInput(
           pair.first, tensor.data_->DType(), shape, &input));
-      RETURN_IF_ERROR(input->SetData(tensor.data_->Data()));
+      if (step_template->matched_) {
+        input->SetConfigIndex(step_template->input_config_indices_[input_idx]);
+      }
+      std::shared_ptr<Memory> data;
+      RETURN_IF_ERROR(StepInputData(
+          model, tensor_data.outgoing_steps_count_, &tensor, &data));
+      RETURN_IF_ERROR(input->SetData(data));
       for (const auto& host_policy_data : tensor.data_->HostPolicyData()) {
         RETURN_IF_ERROR(
             input->SetData(host_policy_data.first, host_policy_data.second));
       }
+      // Setting the data resets the string offsets, reuse the ones of the
+      // producer.
+      input->SetStringOffsets(tensor.data_->CachedStringOffsets());
     }
 
-    releasing_tensors.emplace(&tensor_data, &tensor.remaining_reference_count_);
-
     if (tensor.parameter_override_) {
       if (parameter_set && ((correlation_id != tensor.correlation_id_) ||
                             (flags != tensor.flags_))) {
@@ -922,17 +1826,18 @@ EnsembleContext::InitStep(
     }
   }
 
-  // Prune the tensor if it is not needed by other steps
-  for (auto& releasing_pair : releasing_tensors) {
-    if ((--(*releasing_pair.second)) == 0) {
-      releasing_pair.first->tensor_.erase(iteration_count);
-    }
-  }
+  // Prune the tensor if it is not needed by other steps. Can't prune the
+  // tensor in the input loop above as it may be used by multiple inputs
+  // in the same step.
+  ReleaseStepInputs(step_idx, iteration_count);
 
   // Set requested outputs in request header
   for (const auto& pair : istep.output_to_tensor_) {
     irequest->AddOriginalRequestedOutput(pair.first);
   }
+  if (step_template->matched_) {
+    irequest->SetConfigMatched();
+  }
 
   step->reset(new Step(step_idx, correlation_id, flags));
 
@@ -1015,11 +1920,45 @@ EnsembleContext::ReshapeTensorDims(
   return res;
 }
 
+#ifdef TRITON_ENABLE_METRICS
+void
+EnsembleContext::ReportCriticalPath()
+{
+  // The critical path ends with the step completed last and goes back
+  // through the step whose completion made each step ready.
+  size_t step_idx = EnsembleInfo::kNoStep;
+  uint64_t end_ns = 0;
+  for (size_t idx = 0; idx < step_timings_.size(); ++idx) {
+    const auto& timing = step_timings_[idx];
+    if (timing.completed_ && (timing.end_ns_ >= end_ns)) {
+      step_idx = idx;
+      end_ns = timing.end_ns_;
+    }
+  }
+
+  // A trigger step completed strictly before the steps it made ready, the
+  // path length is bounded anyway in case the timestamps are equal.
+  for (size_t length = 0;
+       (step_idx != EnsembleInfo::kNoStep) && (length < step_timings_.size());
+       ++length) {
+    const auto& timing = step_timings_[step_idx];
+    const size_t trigger_idx = timing.trigger_step_idx_;
+    const bool has_trigger = (trigger_idx != EnsembleInfo::kNoStep) &&
+                             step_timings_[trigger_idx].completed_;
+    const uint64_t start_ns =
+        has_trigger ? step_timings_[trigger_idx].end_ns_ : timing.ready_ns_;
+    metric_reporter_->ReportEnsembleCriticalPath(
+        info_->StepMetrics(step_idx), timing.end_ns_ - start_ns);
+    step_idx = has_trigger ? trigger_idx : EnsembleInfo::kNoStep;
+  }
+}
+#endif  // TRITON_ENABLE_METRICS
+
 Status
 EnsembleContext::FinishEnsemble(std::unique_ptr<InferenceResponse>&& response)
 {
   // Do nothing if the ensemble is finished
-  if (request_tracker_ == nullptr) {
+  if (finished_) {
     return ensemble_status_;
   }
 
@@ -1058,65 +1997,91 @@ EnsembleContext::FinishEnsemble(std::unique_ptr<InferenceResponse>&& response)
   // Reach here when the ensemble execution comes to the end, 'ensemble_status_'
   // at this point is representative.
   request_tracker_->SetStatus(ensemble_status_);
-  if (request_tracker_->DecrementCounter()) {
-    delete request_tracker_;
-  }
-  request_tracker_ = nullptr;
+  finished_ = true;
   return ensemble_status_;
 }
 
 Status
 EnsembleContext::CheckAndSetEnsembleOutput(
-    const std::set<std::pair<std::string, IterationCount>>& updated_tensors,
+    const std::vector<TensorIteration>& updated_tensors,
     std::unique_ptr<InferenceResponse>* response)
 {
-  IterationCount iteration_count = 0;
-  // Check if updated tensor is one of the ensemble output and if all outputs
-  // have tensor of the same iteration count
-  bool ready = false;
   auto& lrequest = request_tracker_->Request();
-  const auto& requested_outputs = lrequest->ImmutableRequestedOutputs();
-  for (const auto updated_tensor : updated_tensors) {
-    if (requested_outputs.find(updated_tensor.first) ==
-        requested_outputs.end()) {
-      continue;
+
+  // The ensemble outputs to be sent, by index in 'ensemble_outputs_', with
+  // the iteration of the tensor to be sent.
+  std::vector<std::pair<size_t, IterationCount>> outputs;
+  if (info_->early_outputs_) {
+    // Each requested output is sent as soon as it is set.
+    for (const auto& updated_tensor : updated_tensors) {
+      if (!requested_tensors_[updated_tensor.first]) {
+        continue;
+      }
+      for (size_t idx = 0; idx < info_->ensemble_outputs_.size(); ++idx) {
+        if (info_->ensemble_outputs_[idx].first == updated_tensor.first) {
+          outputs.emplace_back(idx, updated_tensor.second);
+          break;
+        }
+      }
     }
+    if (outputs.empty()) {
+      return Status::Success;
+    }
+  } else {
+    IterationCount iteration_count = 0;
+    // Check if updated tensor is one of the ensemble output and if all
+    // outputs have tensor of the same iteration count
+    bool ready = false;
+    for (const auto& updated_tensor : updated_tensors) {
+      if (!requested_tensors_[updated_tensor.first]) {
+        continue;
+      }
 
-    ready = true;
-    iteration_count = updated_tensor.second;
-    for (const auto& output : requested_outputs) {
-      auto& tensor = tensor_data_[output].tensor_;
-      if (tensor.empty()) {
-        ready = false;
-        break;
-      } else {
-        // Check if other outputs have tensor with corresponding iteration count
-        if (tensor.find(iteration_count) == tensor.end()) {
+      ready = true;
+      iteration_count = updated_tensor.second;
+      for (const auto output : requested_outputs_) {
+        auto& tensor = tensor_data_[output].tensor_;
+        if (tensor.empty()) {
           ready = false;
           break;
+        } else {
+          // Check if other outputs have tensor with corresponding
+          // iteration count
+          if (tensor.find(iteration_count) == tensor.end()) {
+            ready = false;
+            break;
+          }
         }
       }
     }
-  }
-  if (!ready) {
-    if (info_->is_decoupled_) {
-      return Status::Success;
+    if (!ready) {
+      if (info_->is_decoupled_) {
+        return Status::Success;
+      }
+      return Status(
+          Status::Code::INVALID_ARG,
+          lrequest->LogRequest() +
+              "unexpected deadlock, at least one output is not set while no "
+              "more ensemble steps can be made");
+    }
+    for (size_t idx = 0; idx < info_->ensemble_outputs_.size(); ++idx) {
+      if (requested_tensors_[info_->ensemble_outputs_[idx].first]) {
+        outputs.emplace_back(idx, iteration_count);
+      }
     }
-    return Status(
-        Status::Code::INVALID_ARG,
-        lrequest->LogRequest() +
-            "unexpected deadlock, at least one output is not set while no more "
-            "ensemble steps can be made");
   }
 
   RETURN_IF_ERROR(lrequest->ResponseFactory().CreateResponse(response));
 
-  bool cuda_async_copy = false;
-  std::map<TensorData*, size_t*> releasing_tensors;
-  for (const auto& output_pair : info_->ensemble_output_shape_) {
-    if (requested_outputs.find(output_pair.first) == requested_outputs.end()) {
-      continue;
-    }
+  // The copies of all the outputs are issued together once the output
+  // buffers are allocated, so that the CUDA copies overlap and are
+  // completed with a single synchronization.
+  CopyBatch copies("ensemble outputs", stream_);
+  std::vector<TensorIteration> releasing_tensors;
+  for (const auto& output_iteration : outputs) {
+    const auto& output_pair = info_->ensemble_outputs_[output_iteration.first];
+    const IterationCount iteration_count = output_iteration.second;
+    const std::string& output_name = info_->tensor_names_[output_pair.first];
     // Check if output is ready
     auto& tensor_data = tensor_data_[output_pair.first];
     auto& tensor = tensor_data.tensor_[iteration_count];
@@ -1127,7 +2092,7 @@ EnsembleContext::CheckAndSetEnsembleOutput(
 
     InferenceResponse::Output* output;
     RETURN_IF_ERROR((*response)->AddOutput(
-        output_pair.first, tensor.data_->DType(), shape, &output));
+        output_name, tensor.data_->DType(), shape, &output));
 
     // Use the memory type of the memory block as preferred memory type
     TRITONSERVER_MemoryType dst_memory_type;
@@ -1146,7 +2111,7 @@ EnsembleContext::CheckAndSetEnsembleOutput(
     } else if (buffer == nullptr) {
       return Status(
           Status::Code::INTERNAL,
-          "failed to allocate buffer for output '" + output_pair.first + "'");
+          "failed to allocate buffer for output '" + output_name + "'");
     }
 
     size_t content_offset = 0;
@@ -1156,13 +2121,11 @@ EnsembleContext::CheckAndSetEnsembleOutput(
 
     const char* content = tensor.data_->Data()->BufferAt(
         content_idx, &content_size, &src_memory_type, &src_memory_type_id);
-    bool cuda_used = false;
     while (content != nullptr) {
-      RETURN_IF_ERROR(CopyBuffer(
-          output_pair.first, src_memory_type, src_memory_type_id,
-          dst_memory_type, dst_memory_type_id, content_size, content,
-          ((char*)buffer) + content_offset, stream_, &cuda_used));
-      cuda_async_copy |= cuda_used;
+      copies.Add(
+          src_memory_type, src_memory_type_id, dst_memory_type,
+          dst_memory_type_id, content_size, content,
+          ((char*)buffer) + content_offset);
 
       content_offset += content_size;
       content_idx++;
@@ -1170,7 +2133,7 @@ EnsembleContext::CheckAndSetEnsembleOutput(
           content_idx, &content_size, &src_memory_type, &src_memory_type_id);
     }
 
-    releasing_tensors.emplace(&tensor_data, &tensor.remaining_reference_count_);
+    releasing_tensors.emplace_back(output_pair.first, iteration_count);
 
     if (tensor.parameter_override_) {
       switch (lrequest->CorrelationId().Type()) {
@@ -1198,9 +2161,13 @@ EnsembleContext::CheckAndSetEnsembleOutput(
     }
   }
 
+  bool cuda_async_copy = false;
+  RETURN_IF_ERROR(copies.Flush(&cuda_async_copy));
   if (cuda_async_copy) {
 #ifdef TRITON_ENABLE_GPU
-    cudaStreamSynchronize(stream_);
+    RETURN_IF_CUDA_ERR(
+        cudaStreamSynchronize(stream_),
+        std::string("failed to copy ensemble outputs"));
 #else
     return Status(
         Status::Code::INTERNAL,
@@ -1209,9 +2176,11 @@ EnsembleContext::CheckAndSetEnsembleOutput(
   }
 
   // Prune the tensor if it is not needed by other steps
-  for (auto& releasing_pair : releasing_tensors) {
-    if ((--(*releasing_pair.second)) == 0) {
-      releasing_pair.first->tensor_.erase(iteration_count);
+  for (const auto& releasing_tensor : releasing_tensors) {
+    auto& tensor = tensor_data_[releasing_tensor.first].tensor_;
+    auto it = tensor.find(releasing_tensor.second);
+    if (it->second.remaining_reference_count_.fetch_sub(1) == 1) {
+      tensor.erase(it);
     }
   }
 
@@ -1224,29 +2193,37 @@ EnsembleContext::ScheduleSteps(
 {
   for (auto& step : steps) {
     step->ctx_ = context;
-    bool should_schedule = false;
-    // Must release lock before InferAsync to avoid deadlock, as the same thread
-    // will be calling request/response callbacks on cache hits, which will
-    // attempt to acquire the lock already held
-    {
-      std::lock_guard<std::mutex> lock(context->mutex_);
-
-      // Need to check the ensemble_status_ to ensure the FinishEnsemble()
-      // is called only once.
-      if (context->ensemble_status_.IsOk()) {
-        context->request_tracker_->IncrementCounter();
-        should_schedule = true;
-      }
-    }
-    if (should_schedule) {
-      // On a successful call to InferAsync(), the step will be released by
+    // No lock can be held during Run to avoid deadlock, as the same
+    // thread will be calling request/response callbacks on cache hits,
+    // which may acquire the lock. A step that is not scheduled because the
+    // ensemble has completed is released here.
+    if (!context->finished_) {
+      context->request_tracker_->IncrementCounter();
+      // On a successful call to Run(), the step will be released by
       // the response callback. When the response callback is invoked, the
       // step must not own (and release) the request as the request should be
       // transferred and managed by Triton core. In the case of cache hit, the
       // request hasn't been transferred and can cause double-free, so moving
       // the request ownership out of step here to avoid that
       std::unique_ptr<InferenceRequest> request = std::move(step->request_);
-      auto step_status = context->is_->InferAsync(request);
+#ifdef TRITON_ENABLE_METRICS
+      if (context->metric_reporter_ != nullptr) {
+        step->dispatch_ns_ = StepTimestampNs();
+      }
+#endif  // TRITON_ENABLE_METRICS
+      // The step request is admitted by the server like any other request,
+      // so the steps stop once the server is no longer ready and the steps
+      // admitted while exiting are accounted for by the drain. Only the
+      // ensemble request itself is recorded by the traffic capture.
+      Status step_status = context->is_->AdmitRequest(request);
+      if (step_status.IsOk()) {
+        if ((context->step_batcher_ != nullptr) &&
+            context->step_templates_[step->step_idx_]->batchable_) {
+          context->step_batcher_->Enqueue(std::move(request));
+        } else {
+          step_status = InferenceRequest::Run(request);
+        }
+      }
       if (!step_status.IsOk()) {
         std::lock_guard<std::mutex> lock(context->mutex_);
         context->ensemble_status_ = step_status;
@@ -1256,20 +2233,267 @@ EnsembleContext::ScheduleSteps(
         context->ensemble_status_ = context->FinishEnsemble();
         break;
       }
+      step.release();
     }
-    step.release();
   }
 }
 
 }  // namespace
 
+constexpr size_t EnsembleInfo::kNoStep;
+
+size_t
+EnsembleInfo::TensorId(const std::string& name)
+{
+  auto res = tensor_ids_.emplace(name, tensor_names_.size());
+  if (res.second) {
+    tensor_names_.push_back(name);
+    tensor_to_step_.emplace_back();
+    tensor_to_prev_step_.push_back(kNoStep);
+  }
+  return res.first->second;
+}
+
+void
+EnsembleInfo::StepTemplates(
+    const std::vector<std::shared_ptr<Model>>& step_models,
+    std::vector<std::shared_ptr<const StepTemplate>>* step_templates)
+{
+  step_templates->clear();
+  step_templates->reserve(steps_.size());
+
+  std::lock_guard<std::mutex> lock(step_templates_mtx_);
+  for (size_t step_idx = 0; step_idx < steps_.size(); ++step_idx) {
+    const auto& model = step_models[step_idx];
+    auto& cached = step_templates_[step_idx];
+    if ((cached == nullptr) || (cached->model_.lock() != model)) {
+      std::shared_ptr<StepTemplate> step_template(new StepTemplate());
+      step_template->model_ = model;
+      step_template->matched_ = true;
+      step_template->batchable_ =
+          EnsembleStepBatcher::Batchable(model->Config());
+      const auto& step = steps_[step_idx];
+      for (const auto& pair : step.input_to_tensor_) {
+        int32_t config_index;
+        if (!model->GetInputIndex(pair.first, &config_index).IsOk()) {
+          step_template->matched_ = false;
+          break;
+        }
+        step_template->input_configs_.push_back(
+            &model->Config().input(config_index));
+        step_template->input_config_indices_.push_back(config_index);
+      }
+      step_template->output_batching_ = (model->Config().max_batch_size() > 0);
+      for (const auto& pair : step.output_to_tensor_) {
+        const inference::ModelOutput* output_config;
+        if (!model->GetOutput(pair.first, &output_config).IsOk()) {
+          step_template->matched_ = false;
+          break;
+        }
+        step_template->output_byte_sizes_.push_back(triton::common::GetByteSize(
+            output_config->data_type(), output_config->dims()));
+      }
+      cached = std::move(step_template);
+    }
+    step_templates->push_back(cached);
+  }
+}
+
+void
+EnsembleInfo::AnalyzeLifetimes()
+{
+  // 'reachable[a][b]' is set if step 'b' consumes data derived from the
+  // outputs of step 'a', so that it only runs once step 'a' completed.
+  const size_t step_cnt = steps_.size();
+  std::vector<std::vector<bool>> reachable(
+      step_cnt, std::vector<bool>(step_cnt, false));
+  for (size_t step_idx = 0; step_idx < step_cnt; ++step_idx) {
+    for (const auto tensor_id : steps_[step_idx].input_tensors_) {
+      const size_t prev_step_idx = tensor_to_prev_step_[tensor_id];
+      if (prev_step_idx != kNoStep) {
+        reachable[prev_step_idx][step_idx] = true;
+      }
+    }
+  }
+  for (size_t mid = 0; mid < step_cnt; ++mid) {
+    for (size_t from = 0; from < step_cnt; ++from) {
+      if (reachable[from][mid]) {
+        for (size_t to = 0; to < step_cnt; ++to) {
+          if (reachable[mid][to]) {
+            reachable[from][to] = true;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<bool> is_output(tensor_names_.size(), false);
+  for (const auto& ensemble_output : ensemble_outputs_) {
+    is_output[ensemble_output.first] = true;
+  }
+  for (size_t tensor_id = 0; tensor_id < tensor_names_.size(); ++tensor_id) {
+    if ((tensor_to_prev_step_[tensor_id] != kNoStep) &&
+        !tensor_to_step_[tensor_id].empty() && !is_output[tensor_id]) {
+      planned_tensors_.push_back(tensor_id);
+    }
+  }
+
+  // Whether the memory of tensor 'from' can be reused for tensor 'to'
+  auto follows = [this, &reachable](const size_t from, const size_t to) {
+    const size_t producer = tensor_to_prev_step_[to];
+    for (const auto consumer : tensor_to_step_[from]) {
+      if (!reachable[consumer][producer]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  const size_t planned_cnt = planned_tensors_.size();
+  planned_overlaps_.assign(planned_cnt, std::vector<bool>(planned_cnt, true));
+  for (size_t i = 0; i < planned_cnt; ++i) {
+    for (size_t j = i + 1; j < planned_cnt; ++j) {
+      const size_t ti = planned_tensors_[i];
+      const size_t tj = planned_tensors_[j];
+      const bool overlap = !follows(ti, tj) && !follows(tj, ti);
+      planned_overlaps_[i][j] = overlap;
+      planned_overlaps_[j][i] = overlap;
+    }
+  }
+}
+
+std::shared_ptr<const EnsembleInfo::MemoryPlan>
+EnsembleInfo::GetMemoryPlan(
+    const std::vector<std::shared_ptr<const StepTemplate>>& step_templates,
+    const size_t batch_size)
+{
+  if (planned_tensors_.empty()) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(memory_plan_mtx_);
+  if (!memory_plan_templates_.empty() &&
+      (memory_plan_batch_size_ == batch_size) &&
+      (memory_plan_templates_ == step_templates)) {
+    return memory_plan_;
+  }
+
+  // The byte size of the planned tensors for 'batch_size', 0 if the byte
+  // size isn't known ahead of the request.
+  std::vector<size_t> byte_sizes(planned_tensors_.size(), 0);
+  for (size_t idx = 0; idx < planned_tensors_.size(); ++idx) {
+    const size_t tensor_id = planned_tensors_[idx];
+    const size_t step_idx = tensor_to_prev_step_[tensor_id];
+    const auto& step_template = step_templates[step_idx];
+    if (!step_template->matched_ ||
+        (step_template->output_batching_ && (batch_size == 0))) {
+      continue;
+    }
+    const auto& output_to_tensor = steps_[step_idx].output_to_tensor_;
+    for (size_t output_idx = 0; output_idx < output_to_tensor.size();
+         ++output_idx) {
+      const int64_t byte_size = step_template->output_byte_sizes_[output_idx];
+      if ((output_to_tensor[output_idx].second == tensor_id) &&
+          (byte_size > 0)) {
+        byte_sizes[idx] = step_template->output_batching_
+                              ? byte_size * batch_size
+                              : byte_size;
+        break;
+      }
+    }
+  }
+
+  // Place the tensors from the largest one at the lowest offset that
+  // doesn't overlap any placed tensor that is alive at the same time.
+  // The offsets are aligned as the allocations of the devices.
+  constexpr size_t kAlignment = 256;
+  std::vector<size_t> order;
+  for (size_t idx = 0; idx < planned_tensors_.size(); ++idx) {
+    if (byte_sizes[idx] != 0) {
+      order.push_back(idx);
+    }
+  }
+  if (order.empty()) {
+    memory_plan_.reset();
+  } else {
+    std::stable_sort(
+        order.begin(), order.end(), [&byte_sizes](size_t lhs, size_t rhs) {
+          return byte_sizes[lhs] > byte_sizes[rhs];
+        });
+    std::shared_ptr<MemoryPlan> plan(new MemoryPlan());
+    plan->slab_byte_size_ = 0;
+    plan->offsets_.assign(tensor_names_.size(), 0);
+    plan->byte_sizes_.assign(tensor_names_.size(), 0);
+    std::vector<size_t> placed;
+    for (const auto idx : order) {
+      std::vector<std::pair<size_t, size_t>> taken;
+      for (const auto placed_idx : placed) {
+        if (planned_overlaps_[idx][placed_idx]) {
+          const size_t offset = plan->offsets_[planned_tensors_[placed_idx]];
+          taken.emplace_back(offset, offset + byte_sizes[placed_idx]);
+        }
+      }
+      std::sort(taken.begin(), taken.end());
+      size_t offset = 0;
+      for (const auto& range : taken) {
+        if (offset + byte_sizes[idx] <= range.first) {
+          break;
+        }
+        offset = std::max(
+            offset, (range.second + kAlignment - 1) / kAlignment * kAlignment);
+      }
+      const size_t tensor_id = planned_tensors_[idx];
+      plan->offsets_[tensor_id] = offset;
+      plan->byte_sizes_[tensor_id] = byte_sizes[idx];
+      plan->slab_byte_size_ =
+          std::max(plan->slab_byte_size_, offset + byte_sizes[idx]);
+      placed.push_back(idx);
+    }
+    LOG_VERBOSE(1) << "Ensemble " << ensemble_name_ << " memory plan for batch "
+                   << batch_size << ": " << placed.size()
+                   << " intermediate tensors in " << plan->slab_byte_size_
+                   << " bytes";
+    memory_plan_ = std::move(plan);
+  }
+  memory_plan_batch_size_ = batch_size;
+  memory_plan_templates_ = step_templates;
+  return memory_plan_;
+}
+
 Status
 EnsembleScheduler::Create(
     InferenceStatsAggregator* const stats_aggregator,
     InferenceServer* const server, const inference::ModelConfig& config,
     std::unique_ptr<Scheduler>* scheduler)
 {
-  scheduler->reset(new EnsembleScheduler(stats_aggregator, server, config));
+  // Step batching delay...
+  uint64_t step_batching_delay_us = 0;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kEnsembleStepBatchingParameter, 0 /* default_value */,
+      &step_batching_delay_us));
+
+  // In-flight step requests...
+  uint64_t max_inflight_step_requests = 0;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kEnsembleMaxInflightStepRequestsParameter, 0 /* default_value */,
+      &max_inflight_step_requests));
+
+  // Early outputs...
+  bool early_outputs = false;
+  const auto early_it =
+      config.parameters().find(kEnsembleEarlyOutputsParameter);
+  if (early_it != config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kEnsembleEarlyOutputsParameter, early_it->second.string_value(),
+        &early_outputs));
+  }
+
+  // Step conditions, validated with the ensemble config.
+  std::vector<std::pair<size_t, std::string>> step_conditions;
+  RETURN_IF_ERROR(ParseEnsembleStepConditions(config, &step_conditions));
+
+  scheduler->reset(new EnsembleScheduler(
+      stats_aggregator, server, config, step_batching_delay_us,
+      max_inflight_step_requests, early_outputs, step_conditions));
   return Status::Success;
 }
 
@@ -1290,26 +2514,40 @@ EnsembleScheduler::Enqueue(std::unique_ptr<InferenceRequest>& request)
   // Add additional callback to keep track of in-flight count
   ++inflight_count_;
   request->AddInternalReleaseCallback([this]() { --inflight_count_; });
+  cudaStream_t stream =
+      streams_.empty() ? nullptr
+                       : streams_[next_stream_++ % streams_.size()];
   std::shared_ptr<EnsembleContext> context(new EnsembleContext(
-      metric_reporter_.get(), stats_aggregator_, is_, info_.get(), request,
-      stream_));
+      metric_reporter_.get(), stats_aggregator_, is_, info_.get(),
+      step_batcher_.get(), request, stream));
   EnsembleContext::Proceed(context);
   return Status::Success;
 }
 
 EnsembleScheduler::EnsembleScheduler(
     InferenceStatsAggregator* const stats_aggregator,
-    InferenceServer* const server, const inference::ModelConfig& config)
-    : stats_aggregator_(stats_aggregator), is_(server), stream_(nullptr),
+    InferenceServer* const server, const inference::ModelConfig& config,
+    const uint64_t step_batching_delay_us,
+    const size_t max_inflight_step_requests, const bool early_outputs,
+    const std::vector<std::pair<size_t, std::string>>& step_conditions)
+    : stats_aggregator_(stats_aggregator), is_(server), next_stream_(0),
       inflight_count_(0)
 {
+  if (step_batching_delay_us > 0) {
+    step_batcher_.reset(new EnsembleStepBatcher(step_batching_delay_us));
+  }
+
 #ifdef TRITON_ENABLE_GPU
-  // create CUDA stream
-  auto cuerr = cudaStreamCreate(&stream_);
-  if (cuerr != cudaSuccess) {
-    stream_ = nullptr;
-    LOG_ERROR << "unable to create stream for " << config.name() << ": "
-              << cudaGetErrorString(cuerr);
+  // create CUDA streams
+  for (size_t idx = 0; idx < kStreamCount; ++idx) {
+    cudaStream_t stream;
+    auto cuerr = cudaStreamCreate(&stream);
+    if (cuerr != cudaSuccess) {
+      LOG_ERROR << "unable to create stream for " << config.name() << ": "
+                << cudaGetErrorString(cuerr);
+      break;
+    }
+    streams_.push_back(stream);
   }
 #endif  // TRITON_ENABLE_GPU
 
@@ -1328,56 +2566,92 @@ EnsembleScheduler::EnsembleScheduler(
 
   // This config field is filled internally for ensemble models
   info_->is_decoupled_ = config.model_transaction_policy().decoupled();
+  info_->max_inflight_step_requests_ =
+      info_->is_decoupled_ ? max_inflight_step_requests : 0;
+  info_->early_outputs_ = info_->is_decoupled_ && early_outputs;
 
   for (const auto& input : config.input()) {
-    info_->tensor_to_step_.emplace(input.name(), std::set<size_t>());
+    const size_t tensor_id = info_->TensorId(input.name());
     if (input.optional()) {
-      info_->optional_inputs_.emplace(input.name());
+      info_->optional_inputs_.push_back(tensor_id);
     }
   }
   for (const auto& output : config.output()) {
-    info_->tensor_to_step_.emplace(output.name(), std::set<size_t>());
-
+    const size_t tensor_id = info_->TensorId(output.name());
     if (output.has_reshape()) {
-      info_->ensemble_output_shape_[output.name()] = output.reshape().shape();
+      info_->ensemble_outputs_.emplace_back(
+          tensor_id, output.reshape().shape());
     } else {
-      info_->ensemble_output_shape_[output.name()] = output.dims();
+      info_->ensemble_outputs_.emplace_back(tensor_id, output.dims());
     }
   }
 
   for (const auto& element : config.ensemble_scheduling().step()) {
     size_t step_idx = info_->steps_.size();
     info_->steps_.emplace_back(element.model_name(), element.model_version());
+    auto& step = info_->steps_.back();
     for (const auto& pair : element.input_map()) {
-      auto it = info_->tensor_to_step_.find(pair.second);
-      if (it == info_->tensor_to_step_.end()) {
-        it = info_->tensor_to_step_.emplace(pair.second, std::set<size_t>())
-                 .first;
+      const size_t tensor_id = info_->TensorId(pair.second);
+      step.input_to_tensor_.emplace_back(pair.first, tensor_id);
+      auto& consumers = info_->tensor_to_step_[tensor_id];
+      if (consumers.empty() || (consumers.back() != step_idx)) {
+        consumers.push_back(step_idx);
+        step.input_tensors_.push_back(tensor_id);
       }
-      it->second.insert(step_idx);
-      info_->steps_[step_idx].input_to_tensor_.emplace(
-          std::make_pair(pair.first, pair.second));
     }
 
     for (const auto& pair : element.output_map()) {
-      auto it = info_->tensor_to_step_.find(pair.second);
-      if (it == info_->tensor_to_step_.end()) {
-        it = info_->tensor_to_step_.emplace(pair.second, std::set<size_t>())
-                 .first;
+      const size_t tensor_id = info_->TensorId(pair.second);
+      step.output_to_tensor_.emplace_back(pair.first, tensor_id);
+      if (info_->tensor_to_prev_step_[tensor_id] == EnsembleInfo::kNoStep) {
+        info_->tensor_to_prev_step_[tensor_id] = step_idx;
       }
-      info_->steps_[step_idx].output_to_tensor_.emplace(
-          std::make_pair(pair.first, pair.second));
+    }
+  }
+  // A gated step waits for its condition as for its inputs.
+  for (const auto& condition : step_conditions) {
+    const size_t step_idx = condition.first;
+    const size_t tensor_id = info_->TensorId(condition.second);
+    auto& step = info_->steps_[step_idx];
+    step.condition_tensor_ = tensor_id;
+    if (std::find(
+            step.input_tensors_.begin(), step.input_tensors_.end(),
+            tensor_id) == step.input_tensors_.end()) {
+      step.input_tensors_.push_back(tensor_id);
+      auto& consumers = info_->tensor_to_step_[tensor_id];
+      consumers.insert(
+          std::upper_bound(consumers.begin(), consumers.end(), step_idx),
+          step_idx);
+    }
+  }
+  info_->step_templates_.resize(info_->steps_.size());
+  if (!info_->is_decoupled_) {
+    info_->AnalyzeLifetimes();
+  }
 
-      info_->tensor_to_prev_step_.emplace(pair.second, step_idx);
+#ifdef TRITON_ENABLE_METRICS
+  if (metric_reporter_ != nullptr) {
+    std::vector<std::string> step_models;
+    for (const auto& step : info_->steps_) {
+      step_models.push_back(step.model_name_);
     }
+    metric_reporter_->AcquireEnsembleStepMetrics(
+        step_models, &info_->step_metrics_);
   }
+#endif  // TRITON_ENABLE_METRICS
 }
 
 EnsembleScheduler::~EnsembleScheduler()
 {
+#ifdef TRITON_ENABLE_METRICS
+  // A reloaded ensemble keeps the metrics of the steps that are unchanged
+  if (metric_reporter_ != nullptr) {
+    metric_reporter_->ReleaseEnsembleStepMetrics(info_->step_metrics_);
+  }
+#endif  // TRITON_ENABLE_METRICS
 #ifdef TRITON_ENABLE_GPU
-  if (stream_ != nullptr) {
-    cudaError_t err = cudaStreamDestroy(stream_);
+  for (const auto stream : streams_) {
+    cudaError_t err = cudaStreamDestroy(stream);
     if (err != cudaSuccess) {
       LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
     }
@@ -27,7 +27,15 @@
 
 #ifdef TRITON_ENABLE_ENSEMBLE
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "metric_model_reporter.h"
 #include "model_config.pb.h"
 #include "model_config_utils.h"
@@ -45,8 +53,67 @@ using cudaStream_t = void*;
 #endif  // TRITON_ENABLE_GPU
 
 class InferenceServer;
+class Model;
 
+// Coalesce the step requests for the same composing model from the
+// concurrent ensemble requests. The requests are held for up to the
+// batching delay and then enqueued together so that a model that
+// supports batching, but doesn't batch requests by itself, executes
+// them as one batch. Each request still gets its own response.
+class EnsembleStepBatcher {
+ public:
+  explicit EnsembleStepBatcher(const uint64_t delay_us);
+  ~EnsembleStepBatcher();
+
+  // Return true if the step requests for the model with 'config' are
+  // coalesced.
+  static bool Batchable(const inference::ModelConfig& config);
+
+  // Hold 'request' until it is enqueued with the other requests for the
+  // same model. A request that fails to be enqueued is responded with
+  // the error and released.
+  void Enqueue(std::unique_ptr<InferenceRequest>&& request);
+
+ private:
+  using Batch = std::vector<std::unique_ptr<InferenceRequest>>;
+
+  struct PendingBatch {
+    Batch requests_;
+    size_t batch_size_;
+    std::chrono::steady_clock::time_point deadline_;
+  };
+
+  void BatcherThread();
+
+  // Enqueue each batch of 'batches' to its model.
+  static void Dispatch(std::vector<Batch>* batches);
+
+  // Return true if 'lhs' and 'rhs' can be executed in the same batch.
+  static bool SameShapes(
+      const InferenceRequest& lhs, const InferenceRequest& rhs);
+
+  const std::chrono::microseconds delay_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exit_;
+  // The requests being held, by model. A model has an entry only while
+  // requests are held for it, and the requests keep the model alive.
+  std::unordered_map<Model*, PendingBatch> pending_;
+  std::thread thread_;
+};
+
+// The execution plan of an ensemble, compiled from the model config when
+// the ensemble is loaded. The ensemble tensors are identified by their
+// index in 'tensor_names_' so that a request is executed without looking
+// up the tensors by name.
 struct EnsembleInfo {
+  // The step of the tensors that are not produced by a step, i.e. the
+  // ensemble inputs.
+  static constexpr size_t kNoStep = std::numeric_limits<size_t>::max();
+  // The condition of the steps that are not gated.
+  static constexpr size_t kNoTensor = std::numeric_limits<size_t>::max();
+
   struct StepInfo {
     StepInfo(const std::string& model_name, const int64_t model_version)
         : model_name_(model_name), model_version_(model_version)
@@ -55,28 +122,133 @@ struct EnsembleInfo {
 
     std::string model_name_;
     int64_t model_version_;
-    std::unordered_map<std::string, std::string> input_to_tensor_;
-    std::unordered_map<std::string, std::string> output_to_tensor_;
+    // The model inputs and outputs of the step, paired with the ID of the
+    // ensemble tensor they are mapped to.
+    std::vector<std::pair<std::string, size_t>> input_to_tensor_;
+    std::vector<std::pair<std::string, size_t>> output_to_tensor_;
+    // The distinct ensemble tensors used as input, including the
+    // condition of the step. The step is ready for an iteration once all
+    // of them are available for that iteration.
+    std::vector<size_t> input_tensors_;
+    // The boolean ensemble tensor the step is gated on, the step is
+    // skipped if none of its elements is true. 'kNoTensor' if the step
+    // always runs.
+    size_t condition_tensor_ = kNoTensor;
+  };
+
+  // The lookups in the model config done for the request of a step,
+  // resolved once for the model serving the step and reused by the step
+  // requests until the step is served by another model.
+  struct StepTemplate {
+    std::weak_ptr<Model> model_;
+    // Whether all inputs and outputs of the step are found in the model
+    // config. Otherwise the step request is validated as any other
+    // request and reports the mismatch.
+    bool matched_;
+    // Whether the step requests are coalesced by the step batcher.
+    bool batchable_;
+    // The config of each input in 'input_to_tensor_' and its index in
+    // the model config.
+    std::vector<const inference::ModelInput*> input_configs_;
+    std::vector<int32_t> input_config_indices_;
+    // Whether the model batches, and the byte size of each output in
+    // 'output_to_tensor_', for a single batch if the model batches, or -1
+    // if the output may have any size.
+    bool output_batching_;
+    std::vector<int64_t> output_byte_sizes_;
   };
 
+  // The placement of the intermediate tensors in the slab of an ensemble
+  // request, indexed by tensor ID. A tensor with byte size 0 is not in
+  // the slab.
+  struct MemoryPlan {
+    size_t slab_byte_size_;
+    std::vector<size_t> offsets_;
+    std::vector<size_t> byte_sizes_;
+  };
+
+  // Return the ID of the ensemble tensor 'name', adding the tensor if
+  // it is not known yet.
+  size_t TensorId(const std::string& name);
+
+  // Return in 'step_templates' the template of each step given the
+  // models serving the steps in 'step_models'.
+  void StepTemplates(
+      const std::vector<std::shared_ptr<Model>>& step_models,
+      std::vector<std::shared_ptr<const StepTemplate>>* step_templates);
+
+  // Find the steps that always complete before another and the
+  // intermediate tensors that may share memory in the slab of an
+  // ensemble request.
+  void AnalyzeLifetimes();
+
+  // Return the memory plan for a request of 'batch_size' served by the
+  // steps with 'step_templates', or nullptr if no tensor is planned.
+  std::shared_ptr<const MemoryPlan> GetMemoryPlan(
+      const std::vector<std::shared_ptr<const StepTemplate>>& step_templates,
+      const size_t batch_size);
+
   std::string ensemble_name_;
 
   bool is_decoupled_;
 
-  // the ensemble output (re)shape expected by the ensemble
-  std::unordered_map<std::string, triton::common::DimsList>
-      ensemble_output_shape_;
+  // Whether each requested output is sent in its own response as soon as
+  // it is set, only for a decoupled ensemble.
+  bool early_outputs_;
+
+  // The maximum number of requests in flight for each step of a
+  // decoupled ensemble, 0 if not limited.
+  size_t max_inflight_step_requests_;
+
+  // The names of the ensemble tensors, indexed by tensor ID, and the
+  // reverse mapping used at the boundary of the ensemble.
+  std::vector<std::string> tensor_names_;
+  std::unordered_map<std::string, size_t> tensor_ids_;
+
+  // the ensemble outputs and the (re)shape expected by the ensemble
+  std::vector<std::pair<size_t, triton::common::DimsList>> ensemble_outputs_;
 
   // Inputs that is marked optional for the ensemble
-  std::set<std::string> optional_inputs_;
+  std::vector<size_t> optional_inputs_;
 
   std::vector<StepInfo> steps_;
 
-  // Only include a step if the ensemble tensor is used as input in that step
-  std::unordered_map<std::string, std::set<size_t>> tensor_to_step_;
+  // The steps that use each ensemble tensor as input, in increasing order
+  std::vector<std::vector<size_t>> tensor_to_step_;
 
   // backward path, ensemble tensor to the step that provides its data
-  std::unordered_map<std::string, size_t> tensor_to_prev_step_;
+  std::vector<size_t> tensor_to_prev_step_;
+
+#ifdef TRITON_ENABLE_METRICS
+  // The metrics of each step, empty if the ensemble doesn't publish them.
+  std::vector<MetricModelReporter::EnsembleStepMetrics*> step_metrics_;
+
+  // Return the metrics of the step at 'step_idx', nullptr if none.
+  MetricModelReporter::EnsembleStepMetrics* StepMetrics(
+      const size_t step_idx) const
+  {
+    return (step_idx < step_metrics_.size()) ? step_metrics_[step_idx]
+                                             : nullptr;
+  }
+#endif  // TRITON_ENABLE_METRICS
+
+  // The latest template of each step, indexed by step.
+  std::mutex step_templates_mtx_;
+  std::vector<std::shared_ptr<const StepTemplate>> step_templates_;
+
+  // The intermediate tensors that may be placed in the slab of a request
+  // of a non-decoupled ensemble, i.e. the tensors produced and consumed
+  // by steps that are not ensemble outputs. Two of them overlap, indexed
+  // by the position in 'planned_tensors_', unless the producer of one
+  // only runs after all consumers of the other completed.
+  std::vector<size_t> planned_tensors_;
+  std::vector<std::vector<bool>> planned_overlaps_;
+
+  // The latest memory plan and the batch size and templates it is for.
+  std::mutex memory_plan_mtx_;
+  std::shared_ptr<const MemoryPlan> memory_plan_;
+  size_t memory_plan_batch_size_;
+  std::vector<std::shared_ptr<const StepTemplate>> memory_plan_templates_;
 };
 
 // Scheduler that implements ensemble scheduling.
@@ -103,7 +275,10 @@ class EnsembleScheduler : public Scheduler {
  private:
   EnsembleScheduler(
       InferenceStatsAggregator* const stats_aggregator,
-      InferenceServer* const server, const inference::ModelConfig& config);
+      InferenceServer* const server, const inference::ModelConfig& config,
+      const uint64_t step_batching_delay_us,
+      const size_t max_inflight_step_requests, const bool early_outputs,
+      const std::vector<std::pair<size_t, std::string>>& step_conditions);
 
   std::shared_ptr<MetricModelReporter> metric_reporter_;
   InferenceStatsAggregator* const stats_aggregator_;
@@ -112,8 +287,16 @@ class EnsembleScheduler : public Scheduler {
   // Ensemble information that is built from model config
   std::unique_ptr<EnsembleInfo> info_;
 
-  // The stream used for data transfer.
-  cudaStream_t stream_;
+  // The streams used for data transfer, assigned to the ensemble
+  // requests in turn so that a request only waits for the copies of the
+  // few requests sharing its stream.
+  static constexpr size_t kStreamCount = 4;
+  std::vector<cudaStream_t> streams_;
+  std::atomic<size_t> next_stream_;
+
+  // Coalesce the step requests of the concurrent ensemble requests,
+  // nullptr if step batching is not enabled.
+  std::unique_ptr<EnsembleStepBatcher> step_batcher_;
 
   std::atomic<size_t> inflight_count_;
 };
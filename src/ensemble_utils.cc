@@ -238,8 +238,92 @@ ValidateTensorMapping(
   return Status::Success;
 }
 
+// Return true if 'target' is reachable from 'node' by following the
+// data flow.
+bool
+Reachable(const TensorNode* node, const TensorNode* target)
+{
+  std::set<const TensorNode*> visited;
+  std::deque<const TensorNode*> pending{node};
+  while (!pending.empty()) {
+    const TensorNode* current = pending.front();
+    pending.pop_front();
+    if (current == target) {
+      return true;
+    }
+    for (const auto next_node : current->next_nodes_) {
+      if (visited.insert(next_node).second) {
+        pending.push_back(next_node);
+      }
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
+Status
+ParseEnsembleStepConditions(
+    const inference::ModelConfig& config,
+    std::vector<std::pair<size_t, std::string>>* conditions)
+{
+  conditions->clear();
+  const auto it = config.parameters().find(kEnsembleStepConditionsParameter);
+  if (it == config.parameters().end()) {
+    return Status::Success;
+  }
+
+  const std::string& value = it->second.string_value();
+  const int step_cnt = config.ensemble_scheduling().step_size();
+  std::set<size_t> gated_steps;
+  size_t begin = 0;
+  while (begin <= value.size()) {
+    size_t end = value.find(',', begin);
+    if (end == std::string::npos) {
+      end = value.size();
+    }
+    const std::string entry = value.substr(begin, end - begin);
+    begin = end + 1;
+    const size_t first = entry.find_first_not_of(' ');
+    if (first == std::string::npos) {
+      continue;
+    }
+    const size_t last = entry.find_last_not_of(' ');
+    const size_t colon = entry.find(':', first);
+    if ((colon == std::string::npos) || (colon == last)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kEnsembleStepConditionsParameter +
+              "' expects '<step index>:<tensor>' entries, got '" +
+              entry.substr(first, last - first + 1) + "'");
+    }
+    int64_t step_idx;
+    RETURN_IF_ERROR(ParseLongLongParameter(
+        kEnsembleStepConditionsParameter,
+        entry.substr(first, colon - first), &step_idx));
+    if ((step_idx < 0) || (step_idx >= step_cnt)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kEnsembleStepConditionsParameter + "' refers to step " +
+              std::to_string(step_idx) + ", the ensemble has " +
+              std::to_string(step_cnt) + " steps");
+    }
+    if (!gated_steps.insert(step_idx).second) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kEnsembleStepConditionsParameter + "' gates step " +
+              std::to_string(step_idx) + " more than once");
+    }
+    conditions->emplace_back(
+        step_idx, entry.substr(colon + 1, last - colon));
+  }
+
+  return Status::Success;
+}
+
 Status
 ValidateEnsembleConfig(
     ModelRepositoryManager* model_repository_manager,
@@ -303,6 +387,50 @@ ValidateEnsembleConfig(
         ensemble_name, step, model_config, &ensemble_tensors));
   }
 
+  // A gated step depends on its condition tensor as on its inputs, so the
+  // tensor must not be derived from the outputs of the step.
+  std::vector<std::pair<size_t, std::string>> conditions;
+  RETURN_IF_ERROR(ParseEnsembleStepConditions(ensemble_config, &conditions));
+  for (const auto& condition : conditions) {
+    auto it = ensemble_tensors.find(condition.second);
+    if (it == ensemble_tensors.end()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "in ensemble " + ensemble_name + ", step " +
+              std::to_string(condition.first) +
+              " is gated on unknown ensemble tensor " + condition.second);
+    }
+    auto& condition_node = it->second;
+    if (condition_node.type_ != inference::DataType::TYPE_BOOL) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "in ensemble " + ensemble_name + ", step " +
+              std::to_string(condition.first) +
+              " is gated on ensemble tensor " + condition.second +
+              " of data type " +
+              inference::DataType_Name(condition_node.type_) +
+              ", expected TYPE_BOOL");
+    }
+    const auto& step =
+        ensemble_config.ensemble_scheduling().step(condition.first);
+    for (const auto& output_map : step.output_map()) {
+      auto& node = ensemble_tensors.find(output_map.second)->second;
+      if (Reachable(&node, &condition_node)) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "in ensemble " + ensemble_name + ", step " +
+                std::to_string(condition.first) +
+                " is gated on ensemble tensor " + condition.second +
+                " which depends on the outputs of the step");
+      }
+    }
+    for (const auto& output_map : step.output_map()) {
+      auto& node = ensemble_tensors.find(output_map.second)->second;
+      node.prev_nodes_.push_back(&condition_node);
+      condition_node.next_nodes_.push_back(&node);
+    }
+  }
+
   // Visit nodes and validate decoupled workflow if any
   // check data flow
   size_t decouple_label = 0;
@@ -359,8 +487,18 @@ ValidateEnsembleConfig(
     }
     current_iterators.pop_front();
   }
+  // An ensemble sending its outputs early responds several times even if
+  // none of its models is decoupled.
+  bool early_outputs = false;
+  const auto early_it =
+      ensemble_config.parameters().find(kEnsembleEarlyOutputsParameter);
+  if (early_it != ensemble_config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kEnsembleEarlyOutputsParameter, early_it->second.string_value(),
+        &early_outputs));
+  }
   ensemble->model_config_.mutable_model_transaction_policy()->set_decoupled(
-      decouple_label != 0);
+      (decouple_label != 0) || early_outputs);
 
   return Status::Success;
 }
@@ -45,6 +45,16 @@ Status ValidateEnsembleConfig(
     ModelRepositoryManager* model_repository_manager,
     ModelRepositoryManager::DependencyNode* ensemble);
 
+/// Parse the steps of the ensemble that are gated on a boolean ensemble
+/// tensor, given as a comma-separated list of '<step index>:<tensor>'.
+/// \param config The ensemble config.
+/// \param conditions Returns the index of each gated step and the name of
+/// the tensor it is gated on.
+/// \return The error status.
+Status ParseEnsembleStepConditions(
+    const inference::ModelConfig& config,
+    std::vector<std::pair<size_t, std::string>>* conditions);
+
 }}  // namespace triton::core
 
 #endif  // TRITON_ENABLE_ENSEMBLE
@@ -0,0 +1,86 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "fair_share_clock.h"
+
+#include <algorithm>
+
+namespace triton { namespace core {
+
+constexpr uint64_t FairShareClock::kCostScale;
+constexpr size_t FairShareClock::kMinPruneSize;
+
+FairShareClock::FairShareClock() : virtual_time_(0), prune_size_(kMinPruneSize)
+{
+}
+
+void
+FairShareClock::SetWeight(const std::string& tenant, const uint32_t weight)
+{
+  weights_[tenant] = std::max(weight, 1U);
+}
+
+uint64_t
+FairShareClock::Tag(const std::string& tenant, const uint64_t cost)
+{
+  uint32_t weight = 1;
+  const auto weight_it = weights_.find(tenant);
+  if (weight_it != weights_.end()) {
+    weight = weight_it->second;
+  }
+
+  auto& finish_tag = finish_tags_[tenant];
+  finish_tag = std::max(finish_tag, virtual_time_) +
+               std::max(cost * kCostScale / weight, (uint64_t)1);
+  const uint64_t tag = finish_tag;
+
+  if (finish_tags_.size() > prune_size_) {
+    Prune();
+  }
+  return tag;
+}
+
+void
+FairShareClock::Serve(const uint64_t tag)
+{
+  virtual_time_ = std::max(virtual_time_, tag);
+}
+
+void
+FairShareClock::Prune()
+{
+  for (auto it = finish_tags_.begin(); it != finish_tags_.end();) {
+    if (it->second <= virtual_time_) {
+      it = finish_tags_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // Pruning again only once the tracked tenants doubled keeps the cost
+  // amortized constant per tag.
+  prune_size_ = std::max(kMinPruneSize, 2 * finish_tags_.size());
+}
+
+}}  // namespace triton::core
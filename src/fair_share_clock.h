@@ -0,0 +1,84 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace triton { namespace core {
+
+//
+// Virtual clock for self-clocked fair queuing of the items of several
+// tenants. Each item is tagged with its virtual finish time, which is the
+// cost of the item over the weight of its tenant past the later of the
+// virtual time and the tag of the previous item of the tenant. Serving
+// the items in the order of their tags shares the queue between the
+// backlogged tenants in proportion to their weights, while the items of
+// a tenant keep their arrival order. The virtual time is the tag of the
+// last served item so an idle tenant accumulates no credit.
+//
+// The clock is not thread-safe.
+//
+class FairShareClock {
+ public:
+  FairShareClock();
+
+  // Set the weight of 'tenant', the tenants without a weight have weight
+  // 1. A weight of 0 is treated as 1.
+  void SetWeight(const std::string& tenant, const uint32_t weight);
+
+  // Return the tag of an item of 'tenant' that costs 'cost'.
+  uint64_t Tag(const std::string& tenant, const uint64_t cost);
+
+  // Advance the virtual time to the 'tag' of the item served, the virtual
+  // time never moves backwards.
+  void Serve(const uint64_t tag);
+
+  uint64_t VirtualTime() const { return virtual_time_; }
+
+  // Return the number of tenants whose finish time is tracked.
+  size_t TenantCount() const { return finish_tags_.size(); }
+
+ private:
+  // The virtual time of a unit of cost for a tenant of weight 1.
+  static constexpr uint64_t kCostScale = 1024;
+  // The number of tracked tenants above which the idle ones are dropped.
+  static constexpr size_t kMinPruneSize = 64;
+
+  void Prune();
+
+  std::unordered_map<std::string, uint32_t> weights_;
+  // The tag of the last item of each tenant, a tenant whose tag isn't
+  // after the virtual time has no item queued and is tagged the same as
+  // an unknown tenant.
+  std::unordered_map<std::string, uint64_t> finish_tags_;
+  uint64_t virtual_time_;
+  size_t prune_size_;
+};
+
+}}  // namespace triton::core
@@ -38,7 +38,11 @@
 #include <io.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <utime.h>
 #endif
 
 #ifdef TRITON_ENABLE_GCS
@@ -70,12 +74,24 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include "constants.h"
+#include "hash_utils.h"
 #include "status.h"
 #include "triton/common/logging.h"
 
+#ifdef TRITON_ENABLE_METRICS
+#include "metrics.h"
+#endif  // TRITON_ENABLE_METRICS
+
 #ifdef _WIN32
 // <sys/stat.h> in Windows doesn't define S_ISDIR macro
 #if !defined(S_ISDIR) && defined(S_IFMT) && defined(S_IFDIR)
@@ -116,6 +132,17 @@ LocalizedDirectory::~LocalizedDirectory()
   }
 }
 
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if ((base_ != nullptr) &&
+      (munmap(const_cast<void*>(base_), byte_size_) != 0)) {
+    LOG_ERROR << "failed to unmap file " << path_
+              << ", errno:" << strerror(errno);
+  }
+#endif  // !_WIN32
+}
+
 namespace {
 
 class FileSystem {
@@ -124,6 +151,15 @@ class FileSystem {
   virtual Status IsDirectory(const std::string& path, bool* is_dir) = 0;
   virtual Status FileModificationTime(
       const std::string& path, int64_t* mtime_ns) = 0;
+  // Only overridden by the file systems that can list a directory tree
+  // at once.
+  virtual Status GetSubtreeModificationTimes(
+      const std::string& path, std::map<std::string, int64_t>* mtimes)
+  {
+    return Status(
+        Status::Code::UNSUPPORTED,
+        "listing the directory tree at once is not supported for " + path);
+  }
   virtual Status GetDirectoryContents(
       const std::string& path, std::set<std::string>* contents) = 0;
   virtual Status GetDirectorySubdirs(
@@ -462,6 +498,447 @@ AppendSlash(const std::string& name)
 
   return (name + "/");
 }
+
+// An object of a cloud file system and the local file it is downloaded to.
+// 'version_' identifies the content of the object, i.e. the ETag or the
+// generation, empty if unknown.
+struct CloudObject {
+  std::string bucket_;
+  std::string object_;
+  std::string local_path_;
+  uint64_t byte_size_;
+  std::string version_;
+};
+
+// Write to 'out' the 'byte_size' bytes of 'object' starting at 'offset'.
+using ReadRangeFn = std::function<Status(
+    const CloudObject& object, const uint64_t offset, const uint64_t byte_size,
+    std::ostream* out)>;
+
+// Return the value of the environment variable 'name', or 'default_value'
+// if it is not set or is not an integer of at least 'min_value'.
+uint64_t
+DownloadOption(
+    const char* name, const uint64_t default_value, const uint64_t min_value)
+{
+  const char* value = std::getenv(name);
+  if (value == nullptr) {
+    return default_value;
+  }
+  char* end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = std::strtoull(value, &end, 10);
+  if ((errno != 0) || (end == value) || (*end != '\0') ||
+      (value[0] == '-') || (parsed < min_value)) {
+    LOG_WARNING << "ignoring " << name << "='" << value
+                << "', expected an integer of at least " << min_value;
+    return default_value;
+  }
+  return parsed;
+}
+
+#ifndef _WIN32
+// The downloaded cloud objects kept in the directory TRITON_MODEL_CACHE_DIR,
+// keyed by the location, version and size of the objects, so that an
+// unchanged object is linked to its local path instead of being downloaded
+// again, also by the other processes on the node. The least recently used
+// objects are evicted once the cache holds more than
+// TRITON_MODEL_CACHE_SIZE_BYTES bytes, if set. The processes synchronize
+// through a lock on a file in the directory, and track the size of the
+// cache in another file so that the directory is only scanned to evict.
+//
+// The cached files are read-only as they share their content with the
+// localized directories they are linked to.
+class LocalObjectCache {
+ public:
+  // Return the cache, nullptr if TRITON_MODEL_CACHE_DIR is not set or the
+  // directory can't be used.
+  static LocalObjectCache* Get()
+  {
+    static std::unique_ptr<LocalObjectCache> cache = []() {
+      std::unique_ptr<LocalObjectCache> cache;
+      const char* dir = std::getenv("TRITON_MODEL_CACHE_DIR");
+      if ((dir != nullptr) && (dir[0] != '\0')) {
+        if ((mkdir(dir, S_IRWXU) != 0) && (errno != EEXIST)) {
+          LOG_WARNING << "model cache disabled, failed to create " << dir
+                      << ", errno:" << strerror(errno);
+        } else {
+          cache.reset(new LocalObjectCache(
+              dir, DownloadOption("TRITON_MODEL_CACHE_SIZE_BYTES", 0, 0)));
+        }
+      }
+      return cache;
+    }();
+    return cache.get();
+  }
+
+  // Link the cached copy of the 'object' of 'file_system' to the local path
+  // of the object. Return false if the object is not cached.
+  bool Fetch(const std::string& file_system, const CloudObject& object)
+  {
+    if (object.version_.empty()) {
+      return false;
+    }
+    const std::string entry = EntryPath(file_system, object);
+    Lock lock(lock_path_, false /* exclusive */);
+    struct stat st;
+    if ((stat(entry.c_str(), &st) != 0) ||
+        (static_cast<uint64_t>(st.st_size) != object.byte_size_) ||
+        !LinkOrCopy(entry, object.local_path_)) {
+      return false;
+    }
+    // The modification time orders the entries for eviction
+    utime(entry.c_str(), nullptr);
+    return true;
+  }
+
+  // Add the downloaded 'object' of 'file_system' to the cache and evict the
+  // least recently used objects beyond the size budget.
+  void Insert(const std::string& file_system, const CloudObject& object)
+  {
+    if (object.version_.empty()) {
+      return;
+    }
+    const std::string entry = EntryPath(file_system, object);
+    const std::string staged = entry + ".tmp";
+    Lock lock(lock_path_, true /* exclusive */);
+    if (access(entry.c_str(), F_OK) == 0) {
+      return;
+    }
+    unlink(staged.c_str());
+    if (!LinkOrCopy(object.local_path_, staged) ||
+        (chmod(staged.c_str(), S_IRUSR | S_IRGRP | S_IROTH) != 0) ||
+        (rename(staged.c_str(), entry.c_str()) != 0)) {
+      LOG_VERBOSE(1) << "failed to add " << object.local_path_
+                     << " to the model cache, errno:" << strerror(errno);
+      unlink(staged.c_str());
+      return;
+    }
+    if (byte_size_budget_ == 0) {
+      return;
+    }
+    uint64_t byte_size;
+    if (ReadByteSize(&byte_size)) {
+      byte_size += object.byte_size_;
+    } else {
+      byte_size = Evict(std::numeric_limits<uint64_t>::max());
+    }
+    if (byte_size > byte_size_budget_) {
+      // Evict below the budget so that the next insertions don't scan
+      byte_size = Evict(byte_size_budget_ - byte_size_budget_ / 10);
+    }
+    WriteByteSize(byte_size);
+  }
+
+ private:
+  // A lock on the file at 'path', held until destruction.
+  class Lock {
+   public:
+    Lock(const std::string& path, const bool exclusive)
+        : fd_(open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR))
+    {
+      if (fd_ != -1) {
+        flock(fd_, exclusive ? LOCK_EX : LOCK_SH);
+      }
+    }
+    ~Lock()
+    {
+      if (fd_ != -1) {
+        flock(fd_, LOCK_UN);
+        close(fd_);
+      }
+    }
+
+   private:
+    int fd_;
+  };
+
+  LocalObjectCache(const std::string& dir, const uint64_t byte_size_budget)
+      : dir_(dir), lock_path_(JoinPath({dir, ".lock"})),
+        size_path_(JoinPath({dir, ".size"})),
+        byte_size_budget_(byte_size_budget)
+  {
+  }
+
+  std::string EntryPath(
+      const std::string& file_system, const CloudObject& object) const
+  {
+    StreamingHash64 hash;
+    hash.Update(file_system);
+    hash.Update(object.bucket_);
+    hash.Update(object.object_);
+    hash.Update(object.version_);
+    hash.UpdateValue(object.byte_size_);
+    char name[17];
+    snprintf(
+        name, sizeof(name), "%016llx",
+        static_cast<unsigned long long>(hash.Digest()));
+    return JoinPath({dir_, name});
+  }
+
+  // Hard link 'dst' to 'src', or copy 'src' if they are on different
+  // devices.
+  static bool LinkOrCopy(const std::string& src, const std::string& dst)
+  {
+    if (link(src.c_str(), dst.c_str()) == 0) {
+      return true;
+    }
+    if (errno != EXDEV) {
+      return false;
+    }
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+    out.close();
+    if (!in || !out) {
+      unlink(dst.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // Read the tracked byte size of the cache into 'byte_size'. Return false
+  // if it is not tracked yet. Must be called with the lock.
+  bool ReadByteSize(uint64_t* byte_size) const
+  {
+    std::ifstream in(size_path_);
+    return static_cast<bool>(in >> *byte_size);
+  }
+
+  // Must be called with the exclusive lock.
+  void WriteByteSize(const uint64_t byte_size) const
+  {
+    std::ofstream out(size_path_, std::ios::trunc);
+    out << byte_size;
+  }
+
+  // Remove the least recently used entries until the cache holds at most
+  // 'target_byte_size' bytes, and return the byte size the cache holds
+  // then. Must be called with the exclusive lock.
+  uint64_t Evict(const uint64_t target_byte_size)
+  {
+    std::set<std::string> names;
+    if (!GetDirectoryContents(dir_, &names).IsOk()) {
+      return 0;
+    }
+    std::vector<std::pair<time_t, std::pair<uint64_t, std::string>>> entries;
+    uint64_t total_byte_size = 0;
+    for (const auto& name : names) {
+      if (name[0] == '.') {
+        continue;
+      }
+      std::string path = JoinPath({dir_, name});
+      struct stat st;
+      if (stat(path.c_str(), &st) == 0) {
+        entries.emplace_back(
+            st.st_mtime, std::make_pair(st.st_size, std::move(path)));
+        total_byte_size += st.st_size;
+      }
+    }
+    std::sort(entries.begin(), entries.end());
+    for (const auto& entry : entries) {
+      if (total_byte_size <= target_byte_size) {
+        break;
+      }
+      if (unlink(entry.second.second.c_str()) == 0) {
+        total_byte_size -= entry.second.first;
+        LOG_VERBOSE(1) << "evicted " << entry.second.second
+                       << " from the model cache";
+      }
+    }
+    return total_byte_size;
+  }
+
+  const std::string dir_;
+  const std::string lock_path_;
+  const std::string size_path_;
+  const uint64_t byte_size_budget_;
+};
+#endif  // !_WIN32
+
+// Download 'objects' from 'source' of 'file_system' with ranged reads of
+// at most TRITON_CLOUD_DOWNLOAD_PART_SIZE bytes, and up to
+// TRITON_CLOUD_DOWNLOAD_CONCURRENCY reads in flight across the objects.
+// Each read is written at its offset in the local file and retried up to
+// TRITON_CLOUD_DOWNLOAD_RETRIES times. The objects found in the local
+// object cache are linked from the cache instead.
+Status
+DownloadObjects(
+    const std::string& file_system, const std::string& source,
+    const std::vector<CloudObject>& objects, const ReadRangeFn& read_range)
+{
+  static const uint64_t concurrency =
+      DownloadOption("TRITON_CLOUD_DOWNLOAD_CONCURRENCY", 8, 1);
+  static const uint64_t part_byte_size = DownloadOption(
+      "TRITON_CLOUD_DOWNLOAD_PART_SIZE", 64 * 1024 * 1024, 1);
+  static const uint64_t max_retries =
+      DownloadOption("TRITON_CLOUD_DOWNLOAD_RETRIES", 3, 0);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  // Create the local files with their final size so that the parts can
+  // be written in any order.
+  struct Part {
+    size_t object_idx_;
+    uint64_t offset_;
+    uint64_t byte_size_;
+  };
+  std::vector<Part> parts;
+  uint64_t total_byte_size = 0;
+  size_t cached_cnt = 0;
+  uint64_t cached_byte_size = 0;
+  std::vector<bool> downloaded(objects.size(), false);
+#ifndef _WIN32
+  LocalObjectCache* cache = LocalObjectCache::Get();
+#endif  // !_WIN32
+  for (size_t idx = 0; idx < objects.size(); ++idx) {
+    const auto& object = objects[idx];
+#ifndef _WIN32
+    if ((cache != nullptr) && cache->Fetch(file_system, object)) {
+      ++cached_cnt;
+      cached_byte_size += object.byte_size_;
+      continue;
+    }
+#endif  // !_WIN32
+    downloaded[idx] = true;
+    // Don't write through a link to a cached copy
+    remove(object.local_path_.c_str());
+    std::ofstream local_file(
+        object.local_path_, std::ios::binary | std::ios::trunc);
+    if (object.byte_size_ != 0) {
+      local_file.seekp(object.byte_size_ - 1);
+      local_file.put('\0');
+    }
+    local_file.close();
+    if (!local_file) {
+      return Status(
+          Status::Code::INTERNAL,
+          "Failed to create local file: " + object.local_path_ +
+              ", errno:" + strerror(errno));
+    }
+    for (uint64_t offset = 0; offset < object.byte_size_;
+         offset += part_byte_size) {
+      parts.push_back(Part{
+          idx, offset, std::min(part_byte_size, object.byte_size_ - offset)});
+    }
+    total_byte_size += object.byte_size_;
+  }
+
+  std::atomic<size_t> next_part(0);
+  std::atomic<uint64_t> downloaded_byte_size(0);
+  std::atomic<uint64_t> retry_cnt(0);
+  std::atomic<bool> failed(false);
+  std::mutex mu;
+  Status status;
+  uint64_t logged_tenths = 0;
+  auto download_parts = [&]() {
+    while (!failed) {
+      const size_t part_idx = next_part++;
+      if (part_idx >= parts.size()) {
+        break;
+      }
+      const auto& part = parts[part_idx];
+      const auto& object = objects[part.object_idx_];
+      std::fstream local_file(
+          object.local_path_, std::ios::in | std::ios::out | std::ios::binary);
+      Status part_status;
+      for (uint64_t attempt = 0;; ++attempt) {
+        local_file.clear();
+        local_file.seekp(part.offset_);
+        if (!local_file) {
+          part_status = Status(
+              Status::Code::INTERNAL,
+              "Failed to open local file: " + object.local_path_);
+          break;
+        }
+        part_status =
+            read_range(object, part.offset_, part.byte_size_, &local_file);
+        if (part_status.IsOk()) {
+          local_file.flush();
+          if (!local_file || (static_cast<uint64_t>(local_file.tellp()) !=
+                              part.offset_ + part.byte_size_)) {
+            part_status = Status(
+                Status::Code::INTERNAL,
+                "Incomplete read of bytes " + std::to_string(part.offset_) +
+                    " to " + std::to_string(part.offset_ + part.byte_size_) +
+                    " of " + object.bucket_ + "/" + object.object_);
+          }
+        }
+        if (part_status.IsOk() || (attempt >= max_retries)) {
+          break;
+        }
+        ++retry_cnt;
+        LOG_VERBOSE(1) << "retrying the download of " << object.bucket_ << "/"
+                       << object.object_ << " at offset " << part.offset_
+                       << ": " << part_status.Message();
+      }
+      if (!part_status.IsOk()) {
+        std::lock_guard<std::mutex> lk(mu);
+        if (status.IsOk()) {
+          status = part_status;
+        }
+        failed = true;
+        break;
+      }
+
+      const uint64_t done = (downloaded_byte_size += part.byte_size_);
+      const uint64_t tenths = done * 10 / total_byte_size;
+      std::lock_guard<std::mutex> lk(mu);
+      if (tenths > logged_tenths) {
+        logged_tenths = tenths;
+        LOG_VERBOSE(1) << "downloaded " << done << " of " << total_byte_size
+                       << " bytes from " << source;
+      }
+    }
+  };
+
+  const size_t thread_cnt =
+      std::min<uint64_t>(concurrency, std::max<size_t>(parts.size(), 1));
+  std::vector<std::thread> threads;
+  for (size_t idx = 1; idx < thread_cnt; ++idx) {
+    threads.emplace_back(download_parts);
+  }
+  download_parts();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const uint64_t duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+#ifdef TRITON_ENABLE_METRICS
+  if (Metrics::Enabled()) {
+    const std::map<std::string, std::string> labels{
+        {kMetricsLabelFileSystem, file_system}};
+    Metrics::FamilyModelDownloadBytes().Add(labels).Increment(
+        downloaded_byte_size);
+    Metrics::FamilyModelDownloadDuration().Add(labels).Increment(duration_us);
+    Metrics::FamilyModelDownloadRetries().Add(labels).Increment(retry_cnt);
+    Metrics::FamilyModelDownloadCachedBytes().Add(labels).Increment(
+        cached_byte_size);
+  }
+#endif  // TRITON_ENABLE_METRICS
+  RETURN_IF_ERROR(status);
+
+#ifndef _WIN32
+  if (cache != nullptr) {
+    for (size_t idx = 0; idx < objects.size(); ++idx) {
+      if (downloaded[idx]) {
+        cache->Insert(file_system, objects[idx]);
+      }
+    }
+  }
+#endif  // !_WIN32
+
+  LOG_INFO << "downloaded " << (objects.size() - cached_cnt) << " files, "
+           << total_byte_size << " bytes, from " << source << " in "
+           << (duration_us / 1000) << " ms ("
+           << ((duration_us == 0) ? 0 : (total_byte_size / duration_us))
+           << " MB/s), " << cached_cnt << " files, " << cached_byte_size
+           << " bytes, reused from the model cache";
+  return Status::Success;
+}
 #endif  // TRITON_ENABLE_GCS || TRITON_ENABLE_S3 || TRITON_ENABLE_AZURE_STORAGE
 
 #ifdef TRITON_ENABLE_GCS
@@ -476,6 +953,9 @@ class GCSFileSystem : public FileSystem {
   Status IsDirectory(const std::string& path, bool* is_dir) override;
   Status FileModificationTime(
       const std::string& path, int64_t* mtime_ns) override;
+  Status GetSubtreeModificationTimes(
+      const std::string& path,
+      std::map<std::string, int64_t>* mtimes) override;
   Status GetDirectoryContents(
       const std::string& path, std::set<std::string>* contents) override;
   Status GetDirectorySubdirs(
@@ -642,6 +1122,41 @@ GCSFileSystem::FileModificationTime(const std::string& path, int64_t* mtime_ns)
   return Status::Success;
 }
 
+Status
+GCSFileSystem::GetSubtreeModificationTimes(
+    const std::string& path, std::map<std::string, int64_t>* mtimes)
+{
+  std::string bucket, dir_path;
+  RETURN_IF_ERROR(ParsePath(path, &bucket, &dir_path));
+  std::string full_dir = AppendSlash(dir_path);
+
+  // The objects with the directory as prefix are all the files of the tree
+  for (auto&& object_metadata :
+       client_->ListObjects(bucket, gcs::Prefix(full_dir))) {
+    if (!object_metadata) {
+      return Status(
+          Status::Code::INTERNAL, "Could not list contents of directory at " +
+                                      path + " : " +
+                                      object_metadata.status().message());
+    }
+
+    const std::string& name = object_metadata->name();
+    const std::string entry = name.substr(
+        full_dir.size(), name.find('/', full_dir.size()) - full_dir.size());
+    if (entry.empty()) {
+      continue;
+    }
+    const int64_t update_time =
+        std::chrono::time_point_cast<std::chrono::nanoseconds>(
+            object_metadata->updated())
+            .time_since_epoch()
+            .count();
+    auto& mtime = (*mtimes)[entry];
+    mtime = std::max(mtime, update_time);
+  }
+  return Status::Success;
+}
+
 Status
 GCSFileSystem::GetDirectoryContents(
     const std::string& path, std::set<std::string>* contents)
@@ -780,6 +1295,10 @@ GCSFileSystem::LocalizeDirectory(
     contents.insert(JoinPath({path, *itr}));
   }
 
+  // Mirror the directories first and download the files together once
+  // they are all known.
+  std::vector<CloudObject> objects;
+
   while (contents.size() != 0) {
     std::set<std::string> tmp_contents = contents;
     contents.clear();
@@ -815,30 +1334,48 @@ GCSFileSystem::LocalizeDirectory(
         }
       } else {
         // Create local copy of file
-        std::string file_bucket, file_object;
-        RETURN_IF_ERROR(ParsePath(gcs_fpath, &file_bucket, &file_object));
-
-        // Send a request to read the object
-        gcs::ObjectReadStream filestream =
-            client_->ReadObject(file_bucket, file_object);
-        if (!filestream) {
+        CloudObject object;
+        RETURN_IF_ERROR(
+            ParsePath(gcs_fpath, &object.bucket_, &object.object_));
+        google::cloud::StatusOr<gcs::ObjectMetadata> metadata =
+            client_->GetObjectMetadata(object.bucket_, object.object_);
+        if (!metadata) {
           return Status(
               Status::Code::INTERNAL, "Failed to get object at " + *iter +
-                                          " : " +
-                                          filestream.status().message());
+                                          " : " + metadata.status().message());
         }
-
-        std::string gcs_removed_path = (*iter).substr(path.size());
-        std::string local_file_path =
-            JoinPath({(*localized)->Path(), gcs_removed_path});
-        std::ofstream output_file(local_file_path.c_str(), std::ios::binary);
-        output_file << filestream.rdbuf();
-        output_file.close();
+        object.local_path_ = local_fpath;
+        object.byte_size_ = metadata->size();
+        object.version_ = std::to_string(metadata->generation());
+        objects.emplace_back(std::move(object));
       }
     }
   }
 
-  return Status::Success;
+  return DownloadObjects(
+      "gcs", path, objects,
+      [this](
+          const CloudObject& object, const uint64_t offset,
+          const uint64_t byte_size, std::ostream* out) {
+        // Send a request to read the range of the object
+        gcs::ObjectReadStream filestream = client_->ReadObject(
+            object.bucket_, object.object_,
+            gcs::ReadRange(offset, offset + byte_size));
+        if (!filestream) {
+          return Status(
+              Status::Code::INTERNAL,
+              "Failed to get object at gs://" + object.bucket_ + "/" +
+                  object.object_ + " : " + filestream.status().message());
+        }
+        *out << filestream.rdbuf();
+        if (!filestream.status().ok()) {
+          return Status(
+              Status::Code::INTERNAL,
+              "Failed to read object at gs://" + object.bucket_ + "/" +
+                  object.object_ + " : " + filestream.status().message());
+        }
+        return Status::Success;
+      });
 }
 
 Status
@@ -930,9 +1467,11 @@ class ASFileSystem : public FileSystem {
           Status(const as::list_blobs_segmented_item&, const std::string&)>
           func);
 
-  Status DownloadFolder(
+  // Mirror the directories under 'path' in 'dest' and append the files
+  // to download to 'objects'.
+  Status ListFolder(
       const std::string& container, const std::string& path,
-      const std::string& dest);
+      const std::string& dest, std::vector<CloudObject>* objects);
   re2::RE2 as_regex_;
 };
 
@@ -1157,11 +1696,10 @@ ASFileSystem::FileExists(const std::string& path, bool* exists)
 }
 
 Status
-ASFileSystem::DownloadFolder(
+ASFileSystem::ListFolder(
     const std::string& container, const std::string& path,
-    const std::string& dest)
+    const std::string& dest, std::vector<CloudObject>* objects)
 {
-  as::blob_client_wrapper bc(client_);
   auto func = [&](const as::list_blobs_segmented_item& item,
                   const std::string& dir) {
     auto local_path = JoinPath({dest, dir});
@@ -1175,18 +1713,13 @@ ASFileSystem::DownloadFolder(
             "Failed to create local folder: " + local_path +
                 ", errno:" + strerror(errno));
       }
-      auto ret = DownloadFolder(container, blob_path, local_path);
+      auto ret = ListFolder(container, blob_path, local_path, objects);
       if (!ret.IsOk()) {
         return ret;
       }
     } else {
-      time_t last_modified;
-      bc.download_blob_to_file(container, blob_path, local_path, last_modified);
-      if (errno != 0) {
-        return Status(
-            Status::Code::INTERNAL, "Failed to download file at " + blob_path +
-                                        ", errno:" + strerror(errno));
-      }
+      objects->emplace_back(CloudObject{
+          container, blob_path, local_path, item.content_length, item.etag});
     }
     return Status::Success;
   };
@@ -1221,11 +1754,27 @@ ASFileSystem::LocalizeDirectory(
 
   std::string dest(folder_template);
 
-  as::blob_client_wrapper bc(client_);
-
   std::string container, object;
   RETURN_IF_ERROR(ParsePath(path, &container, &object));
-  return DownloadFolder(container, object, dest);
+  std::vector<CloudObject> objects;
+  RETURN_IF_ERROR(ListFolder(container, object, dest, &objects));
+  return DownloadObjects(
+      "azure", path, objects,
+      [this](
+          const CloudObject& object, const uint64_t offset,
+          const uint64_t byte_size, std::ostream* out) {
+        as::blob_client_wrapper bc(client_);
+        errno = 0;
+        bc.download_blob_to_stream(
+            object.bucket_, object.object_, offset, byte_size, *out);
+        if (errno != 0) {
+          return Status(
+              Status::Code::INTERNAL,
+              "Failed to download file at " + object.object_ +
+                  ", errno:" + strerror(errno));
+        }
+        return Status::Success;
+      });
 }
 
 Status
@@ -1299,6 +1848,9 @@ class S3FileSystem : public FileSystem {
   Status IsDirectory(const std::string& path, bool* is_dir) override;
   Status FileModificationTime(
       const std::string& path, int64_t* mtime_ns) override;
+  Status GetSubtreeModificationTimes(
+      const std::string& path,
+      std::map<std::string, int64_t>* mtimes) override;
   Status GetDirectoryContents(
       const std::string& path, std::set<std::string>* contents) override;
   Status GetDirectorySubdirs(
@@ -1611,6 +2163,52 @@ S3FileSystem::FileModificationTime(const std::string& path, int64_t* mtime_ns)
   return Status::Success;
 }
 
+Status
+S3FileSystem::GetSubtreeModificationTimes(
+    const std::string& path, std::map<std::string, int64_t>* mtimes)
+{
+  std::string bucket, dir_path;
+  RETURN_IF_ERROR(ParsePath(path, &bucket, &dir_path));
+  const std::string full_dir = AppendSlash(dir_path);
+
+  // The objects with the directory as prefix are all the files of the
+  // tree, listed a page at a time.
+  s3::Model::ListObjectsRequest objects_request;
+  objects_request.SetBucket(bucket.c_str());
+  objects_request.SetPrefix(full_dir.c_str());
+  while (true) {
+    auto list_objects_outcome = client_.ListObjects(objects_request);
+    if (!list_objects_outcome.IsSuccess()) {
+      return Status(
+          Status::Code::INTERNAL,
+          "Could not list contents of directory at " + path +
+              " due to exception: " +
+              list_objects_outcome.GetError().GetExceptionName() +
+              ", error message: " +
+              list_objects_outcome.GetError().GetMessage());
+    }
+    const auto& result = list_objects_outcome.GetResult();
+    for (const auto& s3_object : result.GetContents()) {
+      const std::string name(s3_object.GetKey().c_str());
+      const std::string entry = name.substr(
+          full_dir.size(),
+          name.find('/', full_dir.size()) - full_dir.size());
+      if (entry.empty()) {
+        continue;
+      }
+      auto& mtime = (*mtimes)[entry];
+      mtime = std::max(
+          mtime, static_cast<int64_t>(
+                     s3_object.GetLastModified().Millis() * NANOS_PER_MILLIS));
+    }
+    if (!result.GetIsTruncated() || result.GetContents().empty()) {
+      break;
+    }
+    objects_request.SetMarker(result.GetContents().back().GetKey());
+  }
+  return Status::Success;
+}
+
 Status
 S3FileSystem::GetDirectoryContents(
     const std::string& path, std::set<std::string>* contents)
@@ -1789,6 +2387,10 @@ S3FileSystem::LocalizeDirectory(
     contents.insert(JoinPath({effective_path, *itr}));
   }
 
+  // Mirror the directories first and download the files together once
+  // they are all known.
+  std::vector<CloudObject> objects;
+
   while (contents.size() != 0) {
     std::set<std::string> tmp_contents = contents;
     contents.clear();
@@ -1824,33 +2426,62 @@ S3FileSystem::LocalizeDirectory(
         }
       } else {
         // Create local copy of file
-        std::string file_bucket, file_object;
-        RETURN_IF_ERROR(ParsePath(s3_fpath, &file_bucket, &file_object));
+        CloudObject object;
+        RETURN_IF_ERROR(ParsePath(s3_fpath, &object.bucket_, &object.object_));
 
-        s3::Model::GetObjectRequest object_request;
-        object_request.SetBucket(file_bucket.c_str());
-        object_request.SetKey(file_object.c_str());
+        s3::Model::HeadObjectRequest head_request;
+        head_request.SetBucket(object.bucket_.c_str());
+        head_request.SetKey(object.object_.c_str());
 
-        auto get_object_outcome = client_.GetObject(object_request);
-        if (get_object_outcome.IsSuccess()) {
-          auto& retrieved_file =
-              get_object_outcome.GetResultWithOwnership().GetBody();
-          std::ofstream output_file(local_fpath.c_str(), std::ios::binary);
-          output_file << retrieved_file.rdbuf();
-          output_file.close();
-        } else {
+        auto head_object_outcome = client_.HeadObject(head_request);
+        if (!head_object_outcome.IsSuccess()) {
           return Status(
               Status::Code::INTERNAL,
               "Failed to get object at " + s3_fpath + " due to exception: " +
-                  get_object_outcome.GetError().GetExceptionName() +
+                  head_object_outcome.GetError().GetExceptionName() +
                   ", error message: " +
-                  get_object_outcome.GetError().GetMessage());
+                  head_object_outcome.GetError().GetMessage());
         }
+        object.local_path_ = local_fpath;
+        object.byte_size_ = head_object_outcome.GetResult().GetContentLength();
+        object.version_ = head_object_outcome.GetResult().GetETag();
+        objects.emplace_back(std::move(object));
       }
     }
   }
 
-  return Status::Success;
+  return DownloadObjects(
+      "s3", effective_path, objects,
+      [this](
+          const CloudObject& object, const uint64_t offset,
+          const uint64_t byte_size, std::ostream* out) {
+        s3::Model::GetObjectRequest object_request;
+        object_request.SetBucket(object.bucket_.c_str());
+        object_request.SetKey(object.object_.c_str());
+        object_request.SetRange(
+            ("bytes=" + std::to_string(offset) + "-" +
+             std::to_string(offset + byte_size - 1))
+                .c_str());
+        // Write the body straight into the local file at its offset
+        // rather than buffering the whole range in memory. The stream
+        // shares the buffer of 'out' and is deleted by the SDK.
+        std::streambuf* out_buf = out->rdbuf();
+        object_request.SetResponseStreamFactory([out_buf]() {
+          return Aws::New<Aws::IOStream>("S3FileSystem", out_buf);
+        });
+
+        auto get_object_outcome = client_.GetObject(object_request);
+        if (!get_object_outcome.IsSuccess()) {
+          return Status(
+              Status::Code::INTERNAL,
+              "Failed to get object at s3://" + object.bucket_ + "/" +
+                  object.object_ + " due to exception: " +
+                  get_object_outcome.GetError().GetExceptionName() +
+                  ", error message: " +
+                  get_object_outcome.GetError().GetMessage());
+        }
+        return Status::Success;
+      });
 }
 
 Status
@@ -2083,6 +2714,15 @@ FileModificationTime(const std::string& path, int64_t* mtime_ns)
   return fs->FileModificationTime(path, mtime_ns);
 }
 
+Status
+GetSubtreeModificationTimes(
+    const std::string& path, std::map<std::string, int64_t>* mtimes)
+{
+  FileSystem* fs;
+  RETURN_IF_ERROR(GetFileSystem(path, &fs));
+  return fs->GetSubtreeModificationTimes(path, mtimes);
+}
+
 Status
 GetDirectoryContents(const std::string& path, std::set<std::string>* contents)
 {
@@ -2125,6 +2765,108 @@ ReadTextFile(const std::string& path, std::string* contents)
   return fs->ReadTextFile(path, contents);
 }
 
+Status
+MapFile(const std::string& path, std::shared_ptr<const MappedFile>* file)
+{
+  FileSystemType type;
+  RETURN_IF_ERROR(GetFileSystemType(path, &type));
+  if (type != FileSystemType::LOCAL) {
+    return Status(
+        Status::Code::UNSUPPORTED,
+        "failed to map file " + path +
+            ", only files on the local filesystem can be mapped, localize "
+            "the directory holding the file first");
+  }
+
+#ifdef _WIN32
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "failed to map file " + path + ", mapping is not supported on Windows");
+#else
+  // The mappings currently in use, keyed by path. An entry is reused
+  // only if it still refers to the same, unmodified, file so that a
+  // replaced file is never served from a stale mapping.
+  struct MappingEntry {
+    dev_t dev_;
+    ino_t ino_;
+    off_t size_;
+    int64_t mtime_ns_;
+    std::weak_ptr<const MappedFile> file_;
+  };
+  static std::mutex mu;
+  static std::map<std::string, MappingEntry> mappings;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to open file for mapping " + path + ", errno:" +
+            strerror(errno));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to stat file " + path + ", errno:" + strerror(errno));
+  }
+  if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to map file " + path + ", not a regular file");
+  }
+  const int64_t mtime_ns = TIMESPEC_TO_NANOS(st.st_mtim);
+
+  std::lock_guard<std::mutex> lk(mu);
+  auto it = mappings.find(path);
+  if (it != mappings.end()) {
+    const auto& entry = it->second;
+    if ((entry.dev_ == st.st_dev) && (entry.ino_ == st.st_ino) &&
+        (entry.size_ == st.st_size) && (entry.mtime_ns_ == mtime_ns)) {
+      *file = entry.file_.lock();
+      if (*file != nullptr) {
+        close(fd);
+        return Status::Success;
+      }
+    }
+  }
+
+  // An empty file can not be mapped, represent it with a null base.
+  void* base = nullptr;
+  if (st.st_size > 0) {
+    base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      close(fd);
+      return Status(
+          Status::Code::INTERNAL,
+          "failed to map file " + path + ", errno:" + strerror(errno));
+    }
+  }
+  // The mapping keeps the file contents reachable after the descriptor
+  // is closed.
+  close(fd);
+
+  std::shared_ptr<const MappedFile> mapped(
+      new MappedFile(path, base, st.st_size));
+  mappings[path] =
+      MappingEntry{st.st_dev, st.st_ino, st.st_size, mtime_ns, mapped};
+  *file = std::move(mapped);
+
+  // Drop the entries of the files that are no longer mapped.
+  for (auto mit = mappings.begin(); mit != mappings.end();) {
+    if (mit->second.file_.expired()) {
+      mit = mappings.erase(mit);
+    } else {
+      ++mit;
+    }
+  }
+
+  return Status::Success;
+#endif  // _WIN32
+}
+
 Status
 ReadTextProto(const std::string& path, google::protobuf::Message* msg)
 {
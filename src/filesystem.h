@@ -25,6 +25,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <map>
+#include <memory>
 #include <string>
 #include "google/protobuf/message.h"
 #include "status.h"
@@ -66,6 +68,30 @@ class LocalizedDirectory {
   std::string local_path_;
 };
 
+// This class holds a read-only memory mapping of a local file. The file
+// contents are served from the page cache, so all the users of the same
+// file, in this process or in other processes, share the same physical
+// memory. The mapping is released when the object is destroyed.
+class MappedFile {
+ public:
+  MappedFile(const std::string& path, const void* base, const size_t byte_size)
+      : path_(path), base_(base), byte_size_(byte_size)
+  {
+  }
+
+  // Destructor. Unmap the file.
+  ~MappedFile();
+
+  const std::string& Path() const { return path_; }
+  const void* Base() const { return base_; }
+  size_t ByteSize() const { return byte_size_; }
+
+ private:
+  const std::string path_;
+  const void* base_;
+  const size_t byte_size_;
+};
+
 /// Is a path an absolute path?
 /// \param path The path.
 /// \return true if absolute path, false if relative path.
@@ -105,6 +131,17 @@ Status IsDirectory(const std::string& path, bool* is_dir);
 /// \return Error status
 Status FileModificationTime(const std::string& path, int64_t* mtime_ns);
 
+/// Get the most recent modification time of the files under each entry of
+/// a directory with a single listing of the directory tree, for the file
+/// systems that can list a tree at once.
+/// \param path The directory path.
+/// \param mtimes Returns the most recent modification time in nanoseconds
+/// of the files under each entry, keyed by entry name.
+/// \return UNSUPPORTED if the file system can only be walked directory by
+/// directory, otherwise the error status.
+Status GetSubtreeModificationTimes(
+    const std::string& path, std::map<std::string, int64_t>* mtimes);
+
 /// Get the contents of a directory.
 /// \param path The directory path.
 /// \param subdirs Returns the directory contents.
@@ -134,6 +171,17 @@ Status GetDirectoryFiles(
 /// \return Error status
 Status ReadTextFile(const std::string& path, std::string* contents);
 
+/// Map a local file into memory for reading. Mapping a file that is
+/// already mapped, and has not been modified since, returns the existing
+/// mapping. Files of a cloud repository must be localized first, see
+/// LocalizeDirectory().
+/// \param path The path of the file.
+/// \param file Returns the mapping of the file.
+/// \return UNSUPPORTED if the file is not on the local filesystem or
+/// mapping is not supported on this platform, otherwise the error status.
+Status MapFile(
+    const std::string& path, std::shared_ptr<const MappedFile>* file);
+
 /// Create an object representing a local copy of a directory.
 /// \param path The path of the directory.
 /// \param localized Returns the LocalizedDirectory object
@@ -0,0 +1,204 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "hash_utils.h"
+
+#include <cstring>
+
+namespace triton { namespace core {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline uint64_t
+RotateLeft(const uint64_t x, const int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t
+Read64(const unsigned char* p)
+{
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t
+Read32(const unsigned char* p)
+{
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t
+Round(uint64_t acc, const uint64_t input)
+{
+  acc += input * kPrime2;
+  acc = RotateLeft(acc, 31);
+  return acc * kPrime1;
+}
+
+inline uint64_t
+MergeRound(uint64_t acc, const uint64_t val)
+{
+  acc ^= Round(0, val);
+  return acc * kPrime1 + kPrime4;
+}
+
+// Consume as many full 32-byte stripes from 'p' as possible, return
+// the pointer to the first unconsumed byte.
+inline const unsigned char*
+ConsumeStripes(uint64_t* acc, const unsigned char* p, const unsigned char* end)
+{
+  uint64_t v0 = acc[0], v1 = acc[1], v2 = acc[2], v3 = acc[3];
+  while (p + 32 <= end) {
+    v0 = Round(v0, Read64(p));
+    v1 = Round(v1, Read64(p + 8));
+    v2 = Round(v2, Read64(p + 16));
+    v3 = Round(v3, Read64(p + 24));
+    p += 32;
+  }
+  acc[0] = v0;
+  acc[1] = v1;
+  acc[2] = v2;
+  acc[3] = v3;
+  return p;
+}
+
+}  // namespace
+
+StreamingHash64::StreamingHash64(const uint64_t seed)
+{
+  Reset(seed);
+}
+
+void
+StreamingHash64::Reset(const uint64_t seed)
+{
+  seed_ = seed;
+  total_byte_size_ = 0;
+  acc_[0] = seed + kPrime1 + kPrime2;
+  acc_[1] = seed + kPrime2;
+  acc_[2] = seed;
+  acc_[3] = seed - kPrime1;
+  pending_byte_size_ = 0;
+}
+
+void
+StreamingHash64::Update(const void* data, const size_t byte_size)
+{
+  if (byte_size == 0) {
+    return;
+  }
+
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* const end = p + byte_size;
+  total_byte_size_ += byte_size;
+
+  // Not enough data for a full stripe, just buffer it
+  if (pending_byte_size_ + byte_size < 32) {
+    std::memcpy(pending_ + pending_byte_size_, p, byte_size);
+    pending_byte_size_ += byte_size;
+    return;
+  }
+
+  // Complete the pending stripe first
+  if (pending_byte_size_ > 0) {
+    const size_t fill = 32 - pending_byte_size_;
+    std::memcpy(pending_ + pending_byte_size_, p, fill);
+    ConsumeStripes(acc_, pending_, pending_ + 32);
+    p += fill;
+    pending_byte_size_ = 0;
+  }
+
+  // Consume the bulk of the data directly from the caller's buffer
+  p = ConsumeStripes(acc_, p, end);
+
+  // Keep the tail for the next update or the digest
+  if (p < end) {
+    pending_byte_size_ = end - p;
+    std::memcpy(pending_, p, pending_byte_size_);
+  }
+}
+
+void
+StreamingHash64::Update(const std::string& str)
+{
+  UpdateValue<uint64_t>(str.size());
+  Update(str.data(), str.size());
+}
+
+uint64_t
+StreamingHash64::Digest() const
+{
+  uint64_t h;
+  if (total_byte_size_ >= 32) {
+    h = RotateLeft(acc_[0], 1) + RotateLeft(acc_[1], 7) +
+        RotateLeft(acc_[2], 12) + RotateLeft(acc_[3], 18);
+    for (size_t idx = 0; idx < 4; ++idx) {
+      h = MergeRound(h, acc_[idx]);
+    }
+  } else {
+    h = seed_ + kPrime5;
+  }
+  h += total_byte_size_;
+
+  // Fold in the bytes that didn't form a full stripe
+  const unsigned char* p = pending_;
+  const unsigned char* const end = pending_ + pending_byte_size_;
+  while (p + 8 <= end) {
+    h ^= Round(0, Read64(p));
+    h = RotateLeft(h, 27) * kPrime1 + kPrime4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+    h = RotateLeft(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= static_cast<uint64_t>(*p) * kPrime5;
+    h = RotateLeft(h, 11) * kPrime1;
+    ++p;
+  }
+
+  // Final avalanche
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+}}  // namespace triton::core
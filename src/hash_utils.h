@@ -0,0 +1,76 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace triton { namespace core {
+
+//
+// Streaming 64-bit hash (xxHash64 algorithm). Input can be fed in
+// chunks of any size and the resulting digest only depends on the
+// concatenation of the chunks. Bulk data is consumed in 32-byte stripes
+// split across four independent accumulators so that the inner loop
+// pipelines well.
+//
+class StreamingHash64 {
+ public:
+  explicit StreamingHash64(const uint64_t seed = 0);
+
+  // Reset the hash state to start a new digest with 'seed'.
+  void Reset(const uint64_t seed = 0);
+
+  // Add 'byte_size' bytes starting at 'data' to the hash.
+  void Update(const void* data, const size_t byte_size);
+
+  // Add the length followed by the content of 'str' to the hash, so
+  // that consecutive strings can't alias each other.
+  void Update(const std::string& str);
+
+  // Add the bytes of a trivially copyable 'value' to the hash.
+  template <typename T>
+  void UpdateValue(const T& value)
+  {
+    Update(&value, sizeof(T));
+  }
+
+  // Return the digest of all data added so far. The hash state is not
+  // modified so more data can still be added afterwards.
+  uint64_t Digest() const;
+
+ private:
+  uint64_t seed_;
+  uint64_t total_byte_size_;
+  uint64_t acc_[4];
+  // Bytes that have not been consumed as a full stripe yet
+  unsigned char pending_[32];
+  size_t pending_byte_size_;
+};
+
+}}  // namespace triton::core
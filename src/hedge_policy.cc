@@ -0,0 +1,91 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "hedge_policy.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace triton { namespace core {
+
+namespace {
+
+// Number of the most recent waits the threshold is computed from.
+constexpr size_t kWindowSize = 256;
+
+// Number of waits that must be observed before any payload is considered
+// stalled.
+constexpr size_t kMinWaitCount = 32;
+
+// Number of waits recorded between threshold updates.
+constexpr size_t kUpdateInterval = 16;
+
+}  // namespace
+
+HedgePolicy::HedgePolicy(const uint32_t percentile, const uint64_t min_delay_ns)
+    : percentile_(std::min(std::max(percentile, uint32_t{1}), uint32_t{100})),
+      min_delay_ns_(min_delay_ns),
+      threshold_ns_(std::numeric_limits<uint64_t>::max()),
+      waits_(kWindowSize, 0), next_(0), count_(0), since_update_(0)
+{
+}
+
+void
+HedgePolicy::RecordWait(const uint64_t wait_ns)
+{
+  waits_[next_] = wait_ns;
+  next_ = (next_ + 1) % waits_.size();
+  count_ = std::min(count_ + 1, waits_.size());
+  if ((count_ >= kMinWaitCount) && (++since_update_ >= kUpdateInterval)) {
+    since_update_ = 0;
+    UpdateThreshold();
+  }
+}
+
+uint64_t
+HedgePolicy::StallDelayNs(
+    const uint64_t scheduled_ns, const uint64_t now_ns) const
+{
+  if (threshold_ns_ == std::numeric_limits<uint64_t>::max()) {
+    return min_delay_ns_;
+  }
+  const uint64_t wait_ns =
+      (now_ns > scheduled_ns) ? (now_ns - scheduled_ns) : 0;
+  return IsStalled(wait_ns) ? 0 : (threshold_ns_ - wait_ns + 1);
+}
+
+void
+HedgePolicy::UpdateThreshold()
+{
+  scratch_.assign(waits_.begin(), waits_.begin() + count_);
+  // The nearest-rank percentile, at least the first wait.
+  const size_t rank =
+      std::min(count_, ((count_ * percentile_) + 99) / 100) - 1;
+  std::nth_element(scratch_.begin(), scratch_.begin() + rank, scratch_.end());
+  threshold_ns_ = std::max(scratch_[rank], min_delay_ns_);
+}
+
+}}  // namespace triton::core
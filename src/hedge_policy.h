@@ -0,0 +1,85 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// Policy that decides when a payload scheduled for a model instance has
+// waited long enough to be taken over by another idle instance of the
+// model. The threshold is the given percentile of the recent times the
+// payloads of the model waited between being scheduled and being taken
+// by a backend thread, but no less than the minimum delay. No payload is
+// considered stalled until enough waits are observed.
+//
+// The policy is not thread-safe.
+//
+class HedgePolicy {
+ public:
+  // 'percentile' is in (0, 100], 'min_delay_ns' is the lower bound of the
+  // threshold.
+  HedgePolicy(const uint32_t percentile, const uint64_t min_delay_ns);
+
+  // Record that a payload waited 'wait_ns' before it was taken.
+  void RecordWait(const uint64_t wait_ns);
+
+  // Whether a payload that has waited 'wait_ns' is stalled.
+  bool IsStalled(const uint64_t wait_ns) const
+  {
+    return wait_ns > threshold_ns_;
+  }
+
+  // Return the time from 'now_ns' until a payload scheduled at
+  // 'scheduled_ns' is stalled, 0 if it is stalled. While the threshold is
+  // unknown the minimum delay is returned, after which the payload needs
+  // to be checked again.
+  uint64_t StallDelayNs(
+      const uint64_t scheduled_ns, const uint64_t now_ns) const;
+
+  uint64_t ThresholdNs() const { return threshold_ns_; }
+  uint64_t MinDelayNs() const { return min_delay_ns_; }
+
+ private:
+  void UpdateThreshold();
+
+  const uint32_t percentile_;
+  const uint64_t min_delay_ns_;
+  uint64_t threshold_ns_;
+
+  // Ring of the most recent waits.
+  std::vector<uint64_t> waits_;
+  size_t next_;
+  size_t count_;
+  size_t since_update_;
+  std::vector<uint64_t> scratch_;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,83 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "host_memory.h"
+
+#include <atomic>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif  // !_WIN32
+
+namespace triton { namespace core {
+
+namespace {
+
+// The transparent huge page size on x86-64 and on aarch64 with 4K base
+// pages.
+constexpr size_t kHugePageByteSize = 2 * 1024 * 1024;
+
+std::atomic<uint64_t> huge_page_threshold_{0};
+
+}  // namespace
+
+void
+SetHugePageThreshold(const uint64_t byte_size)
+{
+  huge_page_threshold_.store(byte_size, std::memory_order_relaxed);
+}
+
+uint64_t
+HugePageThreshold()
+{
+  return huge_page_threshold_.load(std::memory_order_relaxed);
+}
+
+void*
+HostAlloc(const size_t byte_size)
+{
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+  const uint64_t threshold =
+      huge_page_threshold_.load(std::memory_order_relaxed);
+  if ((threshold != 0) && (byte_size >= threshold)) {
+    // Huge pages can only back whole, aligned huge page ranges
+    const size_t aligned_byte_size =
+        ((byte_size + kHugePageByteSize - 1) / kHugePageByteSize) *
+        kHugePageByteSize;
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, kHugePageByteSize, aligned_byte_size) == 0) {
+      // The advice is only a hint, the memory is still usable with regular
+      // pages if huge pages are not available.
+      madvise(ptr, aligned_byte_size, MADV_HUGEPAGE);
+      return ptr;
+    }
+  }
+#endif  // !_WIN32 && MADV_HUGEPAGE
+  return malloc(byte_size);
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,179 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// D-ary heap of unique items that also tracks the position of each item,
+// so that the key of an item can be updated, or the item removed, in
+// O(log n). The key of each item is stored with it and only changes
+// through Update(), so the heap stays valid even if the value the key
+// was computed from changes. 'Compare(a, b)' returns true if key 'a'
+// should be closer to the top than key 'b'.
+//
+template <typename T, typename Key, typename Compare = std::less<Key>>
+class IndexedHeap {
+ public:
+  bool Empty() const { return heap_.empty(); }
+  size_t Size() const { return heap_.size(); }
+  bool Contains(const T& item) const
+  {
+    return (position_.find(item) != position_.end());
+  }
+
+  // Return the item at the top of the heap, the heap must not be empty.
+  const T& Top() const { return heap_.front().first; }
+  const Key& TopKey() const { return heap_.front().second; }
+
+  // Return the item at 'idx' in heap order, which is not sorted. Useful to
+  // visit all items without popping them.
+  const T& At(const size_t idx) const { return heap_[idx].first; }
+
+  // Insert 'item' with 'key', or update the key if 'item' is already in the
+  // heap.
+  void Push(const T& item, const Key& key)
+  {
+    if (Update(item, key)) {
+      return;
+    }
+    heap_.emplace_back(item, key);
+    position_[item] = heap_.size() - 1;
+    SiftUp(heap_.size() - 1);
+  }
+
+  // Remove the item at the top of the heap, the heap must not be empty.
+  void Pop() { RemoveAt(0); }
+
+  // Remove 'item' from the heap. Return false if 'item' is not in the heap.
+  bool Remove(const T& item)
+  {
+    const auto it = position_.find(item);
+    if (it == position_.end()) {
+      return false;
+    }
+    RemoveAt(it->second);
+    return true;
+  }
+
+  // Change the key of 'item' to 'key'. Return false if 'item' is not in
+  // the heap.
+  bool Update(const T& item, const Key& key)
+  {
+    const auto it = position_.find(item);
+    if (it == position_.end()) {
+      return false;
+    }
+    const size_t idx = it->second;
+    heap_[idx].second = key;
+    if (!SiftUp(idx)) {
+      SiftDown(idx);
+    }
+    return true;
+  }
+
+  void Swap(IndexedHeap& other)
+  {
+    heap_.swap(other.heap_);
+    position_.swap(other.position_);
+  }
+
+ private:
+  static constexpr size_t kArity = 4;
+
+  void RemoveAt(const size_t idx)
+  {
+    position_.erase(heap_[idx].first);
+    if (idx + 1 != heap_.size()) {
+      heap_[idx] = std::move(heap_.back());
+      position_[heap_[idx].first] = idx;
+      heap_.pop_back();
+      if (!SiftUp(idx)) {
+        SiftDown(idx);
+      }
+    } else {
+      heap_.pop_back();
+    }
+  }
+
+  // Move the item at 'idx' up while it should be above its parent, return
+  // true if it moved.
+  bool SiftUp(size_t idx)
+  {
+    const size_t start_idx = idx;
+    while (idx > 0) {
+      const size_t parent = (idx - 1) / kArity;
+      if (!compare_(heap_[idx].second, heap_[parent].second)) {
+        break;
+      }
+      SwapAt(idx, parent);
+      idx = parent;
+    }
+    return (idx != start_idx);
+  }
+
+  void SiftDown(size_t idx)
+  {
+    while (true) {
+      const size_t first_child = (idx * kArity) + 1;
+      if (first_child >= heap_.size()) {
+        break;
+      }
+      size_t best = first_child;
+      const size_t last_child = std::min(first_child + kArity, heap_.size());
+      for (size_t child = first_child + 1; child < last_child; ++child) {
+        if (compare_(heap_[child].second, heap_[best].second)) {
+          best = child;
+        }
+      }
+      if (!compare_(heap_[best].second, heap_[idx].second)) {
+        break;
+      }
+      SwapAt(idx, best);
+      idx = best;
+    }
+  }
+
+  void SwapAt(const size_t lhs, const size_t rhs)
+  {
+    std::swap(heap_[lhs], heap_[rhs]);
+    position_[heap_[lhs].first] = lhs;
+    position_[heap_[rhs].first] = rhs;
+  }
+
+  std::vector<std::pair<T, Key>> heap_;
+  std::unordered_map<T, size_t> position_;
+  Compare compare_;
+};
+
+}}  // namespace triton::core
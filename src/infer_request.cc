@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <deque>
+#include "hash_utils.h"
 #include "model.h"
 #include "model_config_utils.h"
 #include "server.h"
@@ -114,6 +115,31 @@ InferenceRequest::SetPriority(uint32_t p)
   }
 }
 
+void
+InferenceRequest::SetStringParameter(
+    const std::string& name, const std::string& value)
+{
+  for (auto itr = parameters_.begin(); itr != parameters_.end(); ++itr) {
+    if (itr->Name() == name) {
+      parameters_.erase(itr);
+      break;
+    }
+  }
+  parameters_.emplace_back(name.c_str(), value.c_str());
+}
+
+const std::string*
+InferenceRequest::StringParameter(const std::string& name) const
+{
+  for (const auto& parameter : parameters_) {
+    if ((parameter.Name() == name) &&
+        (parameter.Type() == TRITONSERVER_PARAMETER_STRING)) {
+      return &parameter.ValueString();
+    }
+  }
+  return nullptr;
+}
+
 #ifdef TRITON_ENABLE_TRACING
 Status
 InferenceRequest::TraceInputTensors(
@@ -124,7 +150,7 @@ InferenceRequest::TraceInputTensors(
   int64_t dst_memory_type_id = 0;
 
   for (const auto& pr : inputs) {
-    InferenceRequest::Input* ti = pr.second;
+    InferenceRequest::Input* ti = pr.input_;
 
     // input data
     const std::string& name = ti->Name();
@@ -313,6 +339,11 @@ InferenceRequest::Release(
   }
 #endif  // TRITON_ENABLE_TRACING
 
+  request->ClearInferenceInputs();
+  // Free the buffers of the batch now rather than when the request is
+  // reused.
+  request->collated_batch_.reset();
+
   void* userp = request->release_userp_;
   auto& release_fn = request->release_fn_;
   release_fn(
@@ -320,6 +351,100 @@ InferenceRequest::Release(
       release_flags, userp);
 }
 
+InferenceRequest*
+InferenceRequest::Create(
+    const std::shared_ptr<Model>& model, const int64_t requested_model_version)
+{
+  std::unique_ptr<InferenceRequest> request;
+  if (!model->RequestPool().Pop(&request)) {
+    return new InferenceRequest(model, requested_model_version);
+  }
+
+  request->model_shared_ = model;
+  request->requested_model_version_ = requested_model_version;
+  return request.release();
+}
+
+void
+InferenceRequest::Delete(InferenceRequest* request)
+{
+  std::unique_ptr<InferenceRequest> lrequest(request);
+
+  // Only the requests holding a reference to the model are pooled, the
+  // model must outlive its pool so the reference is dropped last.
+  std::shared_ptr<Model> model = std::move(lrequest->model_shared_);
+  if (model != nullptr) {
+    lrequest->Clear();
+    model->RequestPool().Push(lrequest);
+  }
+  lrequest.reset();
+}
+
+std::atomic<uint64_t> InferenceRequest::cancel_count_(0);
+
+void
+InferenceRequest::Cancel()
+{
+  if (!cancelled_.exchange(true)) {
+    cancel_count_++;
+  }
+}
+
+Status
+InferenceRequest::Reset()
+{
+  for (auto& pr : original_inputs_) {
+    RETURN_IF_ERROR(pr.second.RemoveAllData());
+  }
+  ClearInferenceInputs();
+
+  id_.clear();
+  flags_ = 0;
+  correlation_id_ = SequenceId();
+  SetPriority(0);
+  timeout_us_ = 0;
+  cancelled_ = false;
+  parameters_.clear();
+  cache_key_ = 0;
+  cache_digest_ = 0;
+  cache_key_is_set_ = false;
+
+  release_callbacks_.clear();
+  response_delegator_ = nullptr;
+  response_factory_.SetResponseDelegator(nullptr);
+#ifdef TRITON_ENABLE_TRACING
+  ReleaseTrace();
+#endif  // TRITON_ENABLE_TRACING
+  sequence_states_.reset();
+  collated_batch_.reset();
+
+  return Status::Success;
+}
+
+void
+InferenceRequest::Clear()
+{
+  Reset();
+  RemoveAllOriginalInputs();
+  RemoveAllOriginalRequestedOutputs();
+  raw_input_name_.clear();
+  raw_input_size_ = 0;
+  requested_outputs_.clear();
+  needs_normalization_ = true;
+  config_matched_ = false;
+  batch_size_ = 0;
+
+  // The response factory holds a reference to the model.
+  release_fn_ = nullptr;
+  release_userp_ = nullptr;
+  response_factory_ = InferenceResponseFactory();
+
+  collect_stats_ = true;
+#ifdef TRITON_ENABLE_STATS
+  secondary_stats_aggregator_ = nullptr;
+#endif  // TRITON_ENABLE_STATS
+}
+
 InferenceRequest*
 InferenceRequest::CopyAsNull(const InferenceRequest& from)
 {
@@ -376,6 +501,7 @@ InferenceRequest::CopyAsNull(const InferenceRequest& from)
     // Must normalize shape here...
     *new_input->MutableShape() = input.second.Shape();
     *new_input->MutableShapeWithBatchDim() = input.second.ShapeWithBatchDim();
+    new_input->SetConfigIndex(input.second.ConfigIndex());
 
     new_input->SetData(data);
   }
@@ -435,6 +561,7 @@ InferenceRequest::CopyAsNull(const InferenceRequest& from)
     // Must normalize shape here...
     *new_input->MutableShape() = input.second.Shape();
     *new_input->MutableShapeWithBatchDim() = input.second.ShapeWithBatchDim();
+    new_input->SetConfigIndex(input.second.ConfigIndex());
 
     // Note that the input that have max byte size will be responsible for
     // holding the artifical data, while other inputs will hold a reference to
@@ -461,8 +588,8 @@ InferenceRequest::CopyAsNull(const InferenceRequest& from)
 
   // Must normalize inputs here...
   for (auto& pr : lrequest->original_inputs_) {
-    lrequest->inputs_.emplace(
-        std::make_pair(pr.second.Name(), std::addressof(pr.second)));
+    lrequest->inputs_.Emplace(
+        std::addressof(pr.second), pr.second.ConfigIndex());
   }
 
   return lrequest.release();
@@ -495,7 +622,7 @@ InferenceRequest::ImmutableInput(
         LogRequest() + "input '" + name + "' does not exist in request");
   }
 
-  *input = itr->second;
+  *input = itr->input_;
   return Status::Success;
 }
 
@@ -622,10 +749,7 @@ InferenceRequest::AddOverrideInput(
   }
 
   // Add or replace this override in the inputs...
-  const auto res = inputs_.emplace(std::make_pair(input->Name(), input.get()));
-  if (!res.second) {
-    res.first->second = input.get();
-  }
+  inputs_.Emplace(input.get(), input->ConfigIndex());
 
   LOG_VERBOSE(1) << LogRequest() << "added input override for " << input->Name()
                  << ": " << *this;
@@ -685,8 +809,8 @@ InferenceRequest::PrepareForInference()
 {
   // Remove override inputs as those are added during any previous
   // inference execution.
-  inputs_.clear();
-  override_inputs_.clear();
+  ClearInferenceInputs();
+  collated_batch_.reset();
 
   // Renormalize if anything has changed in the inference request in a
   // way that could impact renormalization.
@@ -698,9 +822,9 @@ InferenceRequest::PrepareForInference()
   // Initially show the actual inputs to be only the original
   // inputs. If overrides are added later they will be added to
   // 'inputs_'.
+  inputs_.Reserve(original_inputs_.size());
   for (auto& pr : original_inputs_) {
-    inputs_.emplace(
-        std::make_pair(pr.second.Name(), std::addressof(pr.second)));
+    inputs_.Emplace(std::addressof(pr.second), pr.second.ConfigIndex());
   }
 
   // Clear the timestamps
@@ -715,22 +839,184 @@ InferenceRequest::PrepareForInference()
   return Status::Success;
 }
 
+void
+InferenceRequest::ClearInferenceInputs()
+{
+  // Replace the maps so that they don't reference the arena memory
+  // anymore before resetting it.
+  inputs_ = InputMap(InputMap::allocator_type(&arena_));
+  override_inputs_ =
+      OverrideInputMap(OverrideInputMap::allocator_type(&arena_));
+  arena_.Reset();
+}
+
 Status
 InferenceRequest::Normalize()
 {
-  const inference::ModelConfig& model_config = model_raw_->Config();
+  CPU_STAGE_SCOPE(cpu_stage_, model_raw_->MutableStatsAggregator(), NORMALIZE);
+
+  // The shape of a raw input is deduced from its data so it can't be
+  // cached.
+  if (!raw_input_name_.empty()) {
+    return NormalizeWithModelConfig();
+  }
+
+  NormalizeCache* cache = model_raw_->MutableNormalizeCache();
+  const uint64_t signature = NormalizeSignature();
+  if (ApplyNormalizeCache(cache, signature)) {
+    return Status::Success;
+  }
+
+  RETURN_IF_ERROR(NormalizeWithModelConfig());
+  UpdateNormalizeCache(cache, signature);
+  return Status::Success;
+}
+
+uint64_t
+InferenceRequest::NormalizeSignature() const
+{
+  // The inputs are combined in an order-independent way as the
+  // iteration order of 'original_inputs_' depends on its history.
+  uint64_t signature = 0;
+  StreamingHash64 hash;
+  for (const auto& pr : original_inputs_) {
+    const auto& input = pr.second;
+    hash.Reset();
+    hash.Update(input.Name());
+    hash.UpdateValue(input.DType());
+    hash.Update(
+        input.OriginalShape().data(),
+        input.OriginalShape().size() * sizeof(int64_t));
+    signature += hash.Digest();
+  }
+
+  hash.Reset(signature);
+  for (const auto& output_name : original_requested_outputs_) {
+    hash.Update(output_name);
+  }
+  return hash.Digest();
+}
+
+bool
+InferenceRequest::ApplyNormalizeCache(
+    NormalizeCache* cache, const uint64_t signature)
+{
+  const auto entry = cache->Find(signature);
+  if ((entry == nullptr) ||
+      (entry->inputs_.size() != original_inputs_.size()) ||
+      (entry->original_requested_outputs_ != original_requested_outputs_)) {
+    return false;
+  }
+
+  // Verify the whole signature before modifying the request so that a
+  // hash collision falls back to the normalization.
+  std::vector<Input*> inputs;
+  inputs.reserve(entry->inputs_.size());
+  for (const auto& cached_input : entry->inputs_) {
+    auto it = original_inputs_.find(cached_input.name_);
+    if ((it == original_inputs_.end()) ||
+        (it->second.DType() != cached_input.datatype_) ||
+        (it->second.OriginalShape() != cached_input.original_shape_)) {
+      return false;
+    }
+    inputs.push_back(&it->second);
+  }
+
+  for (size_t idx = 0; idx < inputs.size(); ++idx) {
+    const auto& cached_input = entry->inputs_[idx];
+    auto& input = *inputs[idx];
+    input.SetConfigIndex(cached_input.config_index_);
+    if (cached_input.is_shape_tensor_) {
+      input.SetIsShapeTensor(true);
+    }
+    *input.MutableShape() = cached_input.shape_;
+    *input.MutableShapeWithBatchDim() = cached_input.shape_with_batch_dim_;
+  }
+  requested_outputs_ = entry->requested_outputs_;
+  batch_size_ = entry->batch_size_;
+
+  return true;
+}
+
+void
+InferenceRequest::UpdateNormalizeCache(
+    NormalizeCache* cache, const uint64_t signature)
+{
+  std::shared_ptr<NormalizeCache::Entry> entry =
+      std::make_shared<NormalizeCache::Entry>();
+  entry->inputs_.reserve(original_inputs_.size());
+  for (const auto& pr : original_inputs_) {
+    const auto& input = pr.second;
+    NormalizeCache::Input cached_input;
+    cached_input.name_ = input.Name();
+    cached_input.datatype_ = input.DType();
+    cached_input.original_shape_ = input.OriginalShape();
+    cached_input.config_index_ = input.ConfigIndex();
+    cached_input.is_shape_tensor_ = input.IsShapeTensor();
+    cached_input.shape_ = input.Shape();
+    cached_input.shape_with_batch_dim_ = input.ShapeWithBatchDim();
+    entry->inputs_.emplace_back(std::move(cached_input));
+  }
+  entry->original_requested_outputs_ = original_requested_outputs_;
+  entry->requested_outputs_ = requested_outputs_;
+  entry->batch_size_ = batch_size_;
+
+  cache->Insert(signature, entry);
+}
+
+NormalizeCache::NormalizeCache()
+    : full_(false), entries_(std::unique_ptr<EntryMap>(new EntryMap()))
+{
+}
+
+const NormalizeCache::Entry*
+NormalizeCache::Find(const uint64_t signature) const
+{
+  const auto entries = entries_.Read();
+  const auto it = entries->find(signature);
+  return (it == entries->end()) ? nullptr : it->second.get();
+}
+
+void
+NormalizeCache::Insert(
+    const uint64_t signature, const std::shared_ptr<const Entry>& entry)
+{
+  if (full_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(insert_mu_);
+  std::unique_ptr<EntryMap> updated;
+  {
+    const auto entries = entries_.Read();
+    if (entries->find(signature) != entries->end()) {
+      return;
+    }
+    updated.reset(new EntryMap(*entries));
+  }
+  updated->emplace(signature, entry);
+  if (updated->size() >= kCapacity) {
+    full_.store(true, std::memory_order_relaxed);
+  }
+  entries_.Publish(std::move(updated));
+}
+
+Status
+InferenceRequest::NormalizeWithModelConfig()
+{
+  const ModelConfigSnapshot& model_config = model_raw_->ConfigSnapshot();
+  const size_t config_input_count = model_config.inputs_.size();
 
   // Fill metadata for raw input
   if (!raw_input_name_.empty()) {
     const bool has_multiple_inputs =
-        (original_inputs_.size() != 1) || (model_config.input_size() != 1);
+        (original_inputs_.size() != 1) || (config_input_count != 1);
     if (has_multiple_inputs) {
       return Status(
           Status::Code::INVALID_ARG,
           LogRequest() + "Raw request must only have 1 input (found " +
               std::to_string(original_inputs_.size()) +
               ") to be deduced but got " +
-              std::to_string(model_config.input_size()) + " inputs in '" +
+              std::to_string(config_input_count) + " inputs in '" +
               ModelName() + "' model configuration");
     }
     auto it = original_inputs_.begin();
@@ -740,21 +1026,21 @@ InferenceRequest::Normalize()
           LogRequest() + "Unexpected reference name for raw input '" +
               raw_input_name_ + "' got '" + it->first + "'");
     }
-    const auto& config_input = model_config.input(0);
+    const auto& config_input = model_config.inputs_[0];
     auto& raw_input = it->second;
     std::vector<int64_t> shape;
-    if (model_config.max_batch_size() != 0) {
+    if (model_config.max_batch_size_ != 0) {
       shape.emplace_back(1);
     }
     int64_t dynamic_axis = -1;
     size_t element_cnt = 1;
-    for (const auto& dim : config_input.dims()) {
+    for (const auto& dim : config_input.dims_) {
       if (dim == triton::common::WILDCARD_DIM) {
         if (dynamic_axis != -1) {
           return Status(
               Status::Code::INVALID_ARG,
               LogRequest() + "The shape of the raw input '" +
-                  config_input.name() +
+                  config_input.name_ +
                   "' can not be deduced because there are more than one "
                   "variable-sized dimension");
         }
@@ -764,7 +1050,7 @@ InferenceRequest::Normalize()
       }
       shape.emplace_back(dim);
     }
-    if ((config_input.data_type() == inference::DataType::TYPE_STRING)) {
+    if ((config_input.datatype_ == inference::DataType::TYPE_STRING)) {
       const bool has_one_element = (dynamic_axis == -1) && (element_cnt == 1);
       if (!has_one_element) {
         return Status(
@@ -790,9 +1076,9 @@ InferenceRequest::Normalize()
     } else if (dynamic_axis != -1) {
       shape[dynamic_axis] =
           raw_input.Data()->TotalByteSize() / element_cnt /
-          triton::common::GetDataTypeByteSize(config_input.data_type());
+          triton::common::GetDataTypeByteSize(config_input.datatype_);
     }
-    raw_input.SetMetadata(config_input.name(), config_input.data_type(), shape);
+    raw_input.SetMetadata(config_input.name_, config_input.datatype_, shape);
   }
 
   // Initialize the requested outputs to be used during inference. If
@@ -800,10 +1086,10 @@ InferenceRequest::Normalize()
   // in model config are being requested.
   requested_outputs_.clear();
   if (original_requested_outputs_.size() == 0) {
-    for (const auto& output : model_config.output()) {
-      requested_outputs_.insert(output.name());
+    for (const auto& output : model_config.outputs_) {
+      requested_outputs_.insert(output.name_);
     }
-  } else {
+  } else if (!config_matched_) {
     // Validate if the original requested output name exists in the
     // model configuration.
     for (const auto& output_name : original_requested_outputs_) {
@@ -813,30 +1099,40 @@ InferenceRequest::Normalize()
   }
   // Make sure that the request is providing the number of inputs
   // as is expected by the model.
-  if ((original_inputs_.size() > (size_t)model_config.input_size()) ||
+  if ((original_inputs_.size() > config_input_count) ||
       (original_inputs_.size() < model_raw_->RequiredInputCount())) {
     // If no input is marked as optional, then use exact match error message
     // for consistency / backward compatibility
-    if ((size_t)model_config.input_size() == model_raw_->RequiredInputCount()) {
+    if (config_input_count == model_raw_->RequiredInputCount()) {
       return Status(
           Status::Code::INVALID_ARG,
-          LogRequest() + "expected " +
-              std::to_string(model_config.input_size()) + " inputs but got " +
-              std::to_string(original_inputs_.size()) + " inputs for model '" +
-              ModelName() + "'");
+          LogRequest() + "expected " + std::to_string(config_input_count) +
+              " inputs but got " + std::to_string(original_inputs_.size()) +
+              " inputs for model '" + ModelName() + "'");
     } else {
       return Status(
           Status::Code::INVALID_ARG,
           LogRequest() + "expected number of inputs between " +
               std::to_string(model_raw_->RequiredInputCount()) + " and " +
-              std::to_string(model_config.input_size()) + " but got " +
+              std::to_string(config_input_count) + " but got " +
               std::to_string(original_inputs_.size()) + " inputs for model '" +
               ModelName() + "'");
     }
   }
 
+  // Match each input with the model configuration once, the passes
+  // below and the inference execution access it by index.
+  if (!config_matched_) {
+    for (auto& pr : original_inputs_) {
+      int32_t config_index;
+      RETURN_IF_ERROR(
+          model_raw_->GetInputIndex(pr.second.Name(), &config_index));
+      pr.second.SetConfigIndex(config_index);
+    }
+  }
+
   // Determine the batch size and shape of each input.
-  if (model_config.max_batch_size() == 0) {
+  if (model_config.max_batch_size_ == 0) {
     // Model does not support Triton-style batching so set as
     // batch-size 0 and leave the tensor shapes as they are.
     batch_size_ = 0;
@@ -855,9 +1151,9 @@ InferenceRequest::Normalize()
 
       // For a shape tensor, keep the tensor's shape as it is and mark
       // that the input is a shape tensor.
-      const inference::ModelInput* input_config;
-      RETURN_IF_ERROR(model_raw_->GetInput(input.Name(), &input_config));
-      if (input_config->is_shape_tensor()) {
+      const ModelConfigSnapshot::Tensor& input_config =
+          model_config.inputs_[input.ConfigIndex()];
+      if (input_config.is_shape_tensor_) {
         *input.MutableShape() = input.OriginalShape();
         input.SetIsShapeTensor(true);
         continue;
@@ -888,24 +1184,23 @@ InferenceRequest::Normalize()
 
   // Make sure request batch-size doesn't exceed what is supported by
   // the model.
-  if ((int)batch_size_ > model_config.max_batch_size()) {
+  if ((int)batch_size_ > model_config.max_batch_size_) {
     return Status(
         Status::Code::INVALID_ARG,
         LogRequest() + "inference request batch-size must be <= " +
-            std::to_string(model_config.max_batch_size()) + " for '" +
+            std::to_string(model_config.max_batch_size_) + " for '" +
             ModelName() + "'");
   }
 
   // Verify that each input shape is valid for the model, make
   // adjustments for reshapes and find the total tensor size.
   for (auto& pr : original_inputs_) {
-    const inference::ModelInput* input_config;
-    RETURN_IF_ERROR(model_raw_->GetInput(pr.second.Name(), &input_config));
-
     auto& input = pr.second;
+    const ModelConfigSnapshot::Tensor* input_config =
+        &model_config.inputs_[input.ConfigIndex()];
     auto shape = input.MutableShape();
 
-    if (input.DType() != input_config->data_type()) {
+    if (input.DType() != input_config->datatype_) {
       return Status(
           Status::Code::INVALID_ARG,
           LogRequest() + "inference input data-type is '" +
@@ -913,19 +1208,19 @@ InferenceRequest::Normalize()
                   triton::common::DataTypeToProtocolString(input.DType())) +
               "', model expects '" +
               std::string(triton::common::DataTypeToProtocolString(
-                  input_config->data_type())) +
+                  input_config->datatype_)) +
               "' for '" + ModelName() + "'");
     }
 
     // Validate input shape
     {
       bool match_config = true;
-      const auto& config_dims = input_config->dims();
+      const auto& config_dims = input_config->dims_;
       const auto& input_dims = *shape;
-      if (config_dims.size() != (int64_t)input_dims.size()) {
+      if (config_dims.size() != input_dims.size()) {
         match_config = false;
       } else {
-        for (int i = 0; i < config_dims.size(); ++i) {
+        for (size_t i = 0; i < config_dims.size(); ++i) {
           if (input_dims[i] == triton::common::WILDCARD_DIM) {
             return Status(
                 Status::Code::INVALID_ARG,
@@ -943,13 +1238,12 @@ InferenceRequest::Normalize()
       }
 
       if (!match_config) {
-        triton::common::DimsList full_dims;
-        if (model_config.max_batch_size() > 0) {
-          full_dims.Add(triton::common::WILDCARD_DIM);
-        }
-        for (int i = 0; i < input_config->dims_size(); ++i) {
-          full_dims.Add(input_config->dims(i));
+        std::vector<int64_t> full_dims;
+        if (model_config.max_batch_size_ > 0) {
+          full_dims.push_back(triton::common::WILDCARD_DIM);
         }
+        full_dims.insert(
+            full_dims.end(), config_dims.begin(), config_dims.end());
         return Status(
             Status::Code::INVALID_ARG,
             LogRequest() + "unexpected shape for input '" + pr.first +
@@ -963,16 +1257,16 @@ InferenceRequest::Normalize()
     // match the reshape. As reshape may have variable-size
     // dimensions, we need to record corresponding value so that we
     // can set the value correctly for reshape.
-    if (input_config->has_reshape()) {
+    if (input_config->has_reshape_) {
       std::deque<int64_t> variable_size_values;
-      for (int64_t idx = 0; idx < input_config->dims_size(); idx++) {
-        if (input_config->dims(idx) == -1) {
+      for (size_t idx = 0; idx < input_config->dims_.size(); idx++) {
+        if (input_config->dims_[idx] == -1) {
           variable_size_values.push_back((*shape)[idx]);
         }
       }
 
       shape->clear();
-      for (const auto& dim : input_config->reshape().shape()) {
+      for (const auto& dim : input_config->reshape_) {
         if (dim == -1) {
           shape->push_back(variable_size_values.front());
           variable_size_values.pop_front();
@@ -1141,7 +1435,7 @@ InferenceRequest::ReportStatisticsCacheMiss(
 // Input
 //
 InferenceRequest::Input::Input()
-    : is_shape_tensor_(false), data_(new MemoryReference),
+    : is_shape_tensor_(false), config_index_(-1), data_(new MemoryReference),
       has_host_policy_specific_data_(false)
 {
 }
@@ -1151,7 +1445,8 @@ InferenceRequest::Input::Input(
     const int64_t* shape, const uint64_t dim_count)
     : name_(name), datatype_(datatype),
       original_shape_(shape, shape + dim_count), is_shape_tensor_(false),
-      data_(new MemoryReference), has_host_policy_specific_data_(false)
+      config_index_(-1), data_(new MemoryReference),
+      has_host_policy_specific_data_(false)
 {
 }
 
@@ -1159,7 +1454,7 @@ InferenceRequest::Input::Input(
     const std::string& name, const inference::DataType datatype,
     const std::vector<int64_t>& shape)
     : name_(name), datatype_(datatype), original_shape_(shape),
-      is_shape_tensor_(false), data_(new MemoryReference),
+      is_shape_tensor_(false), config_index_(-1), data_(new MemoryReference),
       has_host_policy_specific_data_(false)
 {
 }
@@ -1172,6 +1467,7 @@ InferenceRequest::Input::SetMetadata(
   name_ = name;
   datatype_ = dt;
   original_shape_ = shape;
+  string_offsets_.reset();
 }
 
 Status
@@ -1201,6 +1497,7 @@ InferenceRequest::Input::AppendData(
   if (byte_size > 0) {
     std::static_pointer_cast<MemoryReference>(data_)->AddBuffer(
         static_cast<const char*>(base), byte_size, memory_type, memory_type_id);
+    string_offsets_.reset();
   }
 
   return Status::Success;
@@ -1213,6 +1510,7 @@ InferenceRequest::Input::AppendDataWithBufferAttributes(
   if (buffer_attributes->ByteSize() > 0) {
     std::static_pointer_cast<MemoryReference>(data_)->AddBuffer(
         static_cast<const char*>(base), buffer_attributes);
+    string_offsets_.reset();
   }
   return Status::Success;
 }
@@ -1247,6 +1545,7 @@ InferenceRequest::Input::PrependData(
   if (byte_size > 0) {
     std::static_pointer_cast<MemoryReference>(data_)->AddBufferFront(
         static_cast<const char*>(base), byte_size, memory_type, memory_type_id);
+    string_offsets_.reset();
   }
 
   return Status::Success;
@@ -1262,6 +1561,7 @@ InferenceRequest::Input::SetData(const std::shared_ptr<Memory>& data)
   }
 
   data_ = data;
+  string_offsets_.reset();
 
   return Status::Success;
 }
@@ -1286,9 +1586,118 @@ InferenceRequest::Input::SetData(
 Status
 InferenceRequest::Input::RemoveAllData()
 {
-  data_ = std::make_shared<MemoryReference>();
+  // Keep the buffer list of the data for the next buffers if nothing
+  // else references it.
+  MemoryReference* data = dynamic_cast<MemoryReference*>(data_.get());
+  if ((data != nullptr) && (data_.use_count() == 1)) {
+    data->Clear();
+  } else {
+    data_ = std::make_shared<MemoryReference>();
+  }
   host_policy_data_map_.clear();
   has_host_policy_specific_data_ = false;
+  string_offsets_.reset();
+  return Status::Success;
+}
+
+Status
+InferenceRequest::Input::StringOffsets(
+    std::shared_ptr<const std::vector<uint64_t>>* offsets)
+{
+  if (datatype_ != inference::DataType::TYPE_STRING) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "input '" + name_ + "' is not a string tensor, its data type is " +
+            triton::common::DataTypeToProtocolString(datatype_));
+  }
+
+  if (string_offsets_ == nullptr) {
+    std::shared_ptr<std::vector<uint64_t>> loffsets =
+        std::make_shared<std::vector<uint64_t>>();
+    RETURN_IF_ERROR(ParseStringOffsets(loffsets.get()));
+    string_offsets_ = std::move(loffsets);
+  }
+
+  *offsets = string_offsets_;
+  return Status::Success;
+}
+
+Status
+InferenceRequest::Input::ParseStringOffsets(
+    std::vector<uint64_t>* offsets) const
+{
+  const int64_t element_count =
+      triton::common::GetElementCount(original_shape_);
+  if (element_count < 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "input '" + name_ + "' has an unknown element count");
+  }
+  offsets->reserve(element_count + 1);
+
+  // A length prefix may be split across buffers, so the prefix is
+  // gathered in 'length' before the element is skipped.
+  uint64_t buffer_offset = 0;
+  uint32_t length = 0;
+  size_t length_byte_size = 0;
+  uint64_t remaining_byte_size = 0;
+  for (size_t idx = 0; idx < data_->BufferCount(); ++idx) {
+    size_t byte_size;
+    TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+    int64_t memory_type_id = 0;
+    const char* base =
+        data_->BufferAt(idx, &byte_size, &memory_type, &memory_type_id);
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      return Status(
+          Status::Code::UNSUPPORTED,
+          "string offsets of input '" + name_ +
+              "' are only available for data in CPU memory");
+    }
+
+    size_t pos = 0;
+    while (pos < byte_size) {
+      if (remaining_byte_size > 0) {
+        const size_t skip_byte_size =
+            std::min<uint64_t>(remaining_byte_size, byte_size - pos);
+        pos += skip_byte_size;
+        remaining_byte_size -= skip_byte_size;
+        continue;
+      }
+
+      if (length_byte_size == 0) {
+        if (offsets->size() == (size_t)element_count) {
+          return Status(
+              Status::Code::INVALID_ARG,
+              "input '" + name_ + "' has more data than its " +
+                  std::to_string(element_count) + " string elements");
+        }
+        offsets->push_back(buffer_offset + pos);
+      }
+      const size_t copy_byte_size =
+          std::min(sizeof(uint32_t) - length_byte_size, byte_size - pos);
+      memcpy(
+          reinterpret_cast<char*>(&length) + length_byte_size, base + pos,
+          copy_byte_size);
+      length_byte_size += copy_byte_size;
+      pos += copy_byte_size;
+      if (length_byte_size == sizeof(uint32_t)) {
+        remaining_byte_size = length;
+        length = 0;
+        length_byte_size = 0;
+      }
+    }
+    buffer_offset += byte_size;
+  }
+
+  if ((length_byte_size != 0) || (remaining_byte_size != 0) ||
+      (offsets->size() != (size_t)element_count)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "input '" + name_ + "' has incomplete data for its " +
+            std::to_string(element_count) + " string elements");
+  }
+  offsets->push_back(buffer_offset);
+
   return Status::Success;
 }
 
@@ -1403,7 +1812,7 @@ operator<<(std::ostream& out, const InferenceRequest& request)
 
   out << "inputs:" << std::endl;
   for (const auto& itr : request.ImmutableInputs()) {
-    out << "[0x" << itr.second << "] " << *itr.second << std::endl;
+    out << "[0x" << itr.input_ << "] " << *itr.input_ << std::endl;
   }
 
   out << "original requested outputs:" << std::endl;
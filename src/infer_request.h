@@ -25,15 +25,22 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "arena.h"
 #include "buffer_attributes.h"
+#include "infer_parameter.h"
 #include "infer_response.h"
 #include "infer_stats.h"
 #include "infer_trace.h"
 #include "memory.h"
+#include "rcu_snapshot.h"
 #include "response_allocator.h"
 #include "sequence_state.h"
 #include "status.h"
@@ -42,7 +49,9 @@
 
 namespace triton { namespace core {
 
+class CollatedBatch;
 class Model;
+class NormalizeCache;
 class InferenceServer;
 class MetricModelReporter;
 
@@ -116,6 +125,14 @@ class InferenceRequest {
     // Set the input to be treated as a shape tensor.
     Status SetIsShapeTensor(const bool is_shape_tensor);
 
+    // The index of the input in the model configuration, -1 if the
+    // input has not been matched against the model configuration.
+    int32_t ConfigIndex() const { return config_index_; }
+    void SetConfigIndex(const int32_t config_index)
+    {
+      config_index_ = config_index;
+    }
+
     // The data for this input.
     const std::shared_ptr<Memory>& Data() const { return data_; }
 
@@ -159,6 +176,35 @@ class InferenceRequest {
     // Remove all existing data for the input.
     Status RemoveAllData();
 
+    // Return in 'offsets' the offsets of the elements of a TYPE_STRING
+    // input, computed from the length prefixes on the first call. The
+    // offsets are into the data of the input taken as the concatenation
+    // of its buffers, which must be in CPU memory. There is one offset
+    // per element, the offset of its length prefix, followed by the
+    // byte size of the data, so that element 'i' is the
+    // 'offsets[i + 1] - offsets[i] - 4' bytes following its prefix.
+    // Return error if the data doesn't match the element count of the
+    // input.
+    Status StringOffsets(
+        std::shared_ptr<const std::vector<uint64_t>>* offsets);
+
+    // The string offsets computed for the input, nullptr if they
+    // haven't been computed yet.
+    const std::shared_ptr<const std::vector<uint64_t>>& CachedStringOffsets()
+        const
+    {
+      return string_offsets_;
+    }
+
+    // Set the string offsets of the input to offsets computed for the
+    // same data, for example by the producer of the data, so that they
+    // don't need to be computed from the length prefixes.
+    void SetStringOffsets(
+        const std::shared_ptr<const std::vector<uint64_t>>& offsets)
+    {
+      string_offsets_ = offsets;
+    }
+
     // Get the number of buffers containing the input tensor data.
     size_t DataBufferCount() const { return data_->BufferCount(); }
 
@@ -212,14 +258,22 @@ class InferenceRequest {
     friend std::ostream& operator<<(
         std::ostream& out, const InferenceRequest::Input& input);
 
+    // Compute the string offsets of the data of the input.
+    Status ParseStringOffsets(std::vector<uint64_t>* offsets) const;
+
     std::string name_;
     inference::DataType datatype_;
     std::vector<int64_t> original_shape_;
     std::vector<int64_t> shape_;
     std::vector<int64_t> shape_with_batch_dim_;
     bool is_shape_tensor_;
+    int32_t config_index_;
     std::shared_ptr<Memory> data_;
 
+    // The offsets of the string elements of 'data_', reset whenever the
+    // data changes.
+    std::shared_ptr<const std::vector<uint64_t>> string_offsets_;
+
     bool has_host_policy_specific_data_;
     // A map of host policy to input data memory
     std::map<std::string, std::shared_ptr<Memory>> host_policy_data_map_;
@@ -278,13 +332,33 @@ class InferenceRequest {
   }
 
   InferenceRequest(Model* model, const int64_t requested_model_version)
-      : needs_normalization_(true), model_raw_(model),
+      : needs_normalization_(true), config_matched_(false),
+        model_raw_(model),
         requested_model_version_(requested_model_version), flags_(0),
-        correlation_id_(0), batch_size_(0), timeout_us_(0), collect_stats_(true)
+        correlation_id_(0), batch_size_(0), timeout_us_(0),
+        override_inputs_(OverrideInputMap::allocator_type(&arena_)),
+        inputs_(InputMap::allocator_type(&arena_)), collect_stats_(true)
   {
     SetPriority(0);
   }
 
+  // Return a request for 'model', reusing a request object pooled by
+  // the model if any. The request must be deleted with Delete().
+  static InferenceRequest* Create(
+      const std::shared_ptr<Model>& model,
+      const int64_t requested_model_version);
+
+  // Delete a request returned by Create(), the request object is
+  // returned to the pool of its model unless the pool is full.
+  static void Delete(InferenceRequest* request);
+
+  // Reset a released request for another inference. The inputs, the
+  // requested outputs and the callbacks are kept but the data of the
+  // inputs is removed, and the ID, the flags, the correlation ID, the
+  // priority, the timeout and the parameters are cleared.
+  Status Reset();
+
+  Model* ModelRaw() const { return model_raw_; }
   const std::string& ModelName() const;
   int64_t RequestedModelVersion() const { return requested_model_version_; }
   int64_t ActualModelVersion() const;
@@ -321,16 +395,49 @@ class InferenceRequest {
   uint64_t TimeoutMicroseconds() const { return timeout_us_; }
   void SetTimeoutMicroseconds(uint64_t t) { timeout_us_ = t; }
 
+  // Cancel the request. Cancellation is only a hint, the schedulers
+  // drop a cancelled request that is still queued and the backends may
+  // poll IsCancelled() to stop an execution early. May be called from
+  // any thread while the request is in flight.
+  void Cancel();
+  bool IsCancelled() const { return cancelled_.load(); }
+
+  // The number of requests ever cancelled. Schedulers compare it with
+  // the count seen at their last sweep to skip looking for cancelled
+  // requests when none was cancelled since.
+  static uint64_t CancelCount() { return cancel_count_.load(); }
+
+  // The parameters given to the request. Setting a parameter that is
+  // already set replaces its value.
+  const std::vector<InferenceParameter>& Parameters() const
+  {
+    return parameters_;
+  }
+  void SetStringParameter(const std::string& name, const std::string& value);
+
+  // Return the value of the string parameter 'name', or nullptr if the
+  // request doesn't have it.
+  const std::string* StringParameter(const std::string& name) const;
+
   uint64_t CacheKey() const { return cache_key_; }
+  // Secondary digest of the hashable fields, used by the response cache
+  // to detect collisions of 'cache_key_' in collision-safe mode.
+  uint64_t CacheDigest() const { return cache_digest_; }
   // It is up to the user to update the cache_key_ if modifying any hashable
   // fields of the request after cache_key_is_set_ has been set to true.
-  void SetCacheKey(uint64_t key)
+  void SetCacheKey(uint64_t key, uint64_t digest = 0)
   {
     cache_key_ = key;
+    cache_digest_ = digest;
     cache_key_is_set_ = true;
   }
   bool CacheKeyIsSet() const { return cache_key_is_set_; }
 
+  // Hash of the shape bucket of the request, set by the dynamic batcher
+  // when the request is enqueued.
+  uint64_t ShapeBucketKey() const { return shape_bucket_key_; }
+  void SetShapeBucketKey(const uint64_t key) { shape_bucket_key_ = key; }
+
 #ifdef TRITON_ENABLE_TRACING
   const std::shared_ptr<InferenceTraceProxy>& Trace() const { return trace_; }
   std::shared_ptr<InferenceTraceProxy>* MutableTrace() { return &trace_; }
@@ -349,6 +456,80 @@ class InferenceRequest {
       TRITONSERVER_InferenceTraceActivity activity, const std::string& msg);
 #endif  // TRITON_ENABLE_TRACING
 
+  // The maps of the inputs used by one inference execution. Their
+  // memory comes from an arena of the request that is released in one
+  // shot when the request is released or prepared for the next
+  // inference.
+  using OverrideInputMap = std::unordered_map<
+      std::string, std::shared_ptr<Input>, std::hash<std::string>,
+      std::equal_to<std::string>,
+      ArenaAllocator<std::pair<const std::string, std::shared_ptr<Input>>>>;
+
+  // Flat map of the inputs used by one inference execution, keyed by
+  // the input name. Requests have few inputs so a linear search over
+  // contiguous entries is cheaper than hashing the name, and an input
+  // can be accessed by index in constant time. Each entry records the
+  // index of the input in the model configuration, or -1 if the input
+  // is not part of the model configuration (e.g. a sequence state).
+  class InputMap {
+   public:
+    struct Entry {
+      Entry(Input* input, const int32_t config_index)
+          : input_(input), config_index_(config_index)
+      {
+      }
+      Input* input_;
+      int32_t config_index_;
+    };
+
+    using allocator_type = ArenaAllocator<Entry>;
+    using const_iterator =
+        typename std::vector<Entry, allocator_type>::const_iterator;
+
+    explicit InputMap(const allocator_type& allocator) : entries_(allocator)
+    {
+    }
+
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+    const Entry& operator[](const size_t idx) const { return entries_[idx]; }
+
+    // Return the entry of the input named 'name', or end() if there is
+    // no such input. 'name' can be any type comparable with
+    // std::string so that looking up a C string doesn't construct a
+    // temporary.
+    template <typename NameType>
+    const_iterator find(const NameType& name) const
+    {
+      for (auto itr = entries_.begin(); itr != entries_.end(); ++itr) {
+        if (itr->input_->Name() == name) {
+          return itr;
+        }
+      }
+      return entries_.end();
+    }
+
+    // Add 'input', replacing the input of the same name if any. A
+    // replacement keeps the configuration index of the replaced input.
+    void Emplace(Input* input, const int32_t config_index)
+    {
+      for (auto& entry : entries_) {
+        if (entry.input_->Name() == input->Name()) {
+          entry.input_ = input;
+          return;
+        }
+      }
+      entries_.emplace_back(input, config_index);
+    }
+
+    void Reserve(const size_t count) { entries_.reserve(count); }
+
+   private:
+    std::vector<Entry, allocator_type> entries_;
+  };
+
   // The original inputs are the inputs added to the request before
   // the inference execution (that is before
   // TRITONSERVER_ServerInferAsync is called). Once execution has
@@ -378,26 +559,15 @@ class InferenceRequest {
   // change to be reflected in all requests that hold that override
   // input. Override inputs within a specific request are not
   // persisted across inference calls.
-  std::unordered_map<std::string, std::shared_ptr<Input>>*
-  MutableOverrideInputs()
-  {
-    return &override_inputs_;
-  }
-  const std::unordered_map<std::string, std::shared_ptr<Input>>&
-  OverrideInputs() const
-  {
-    return override_inputs_;
-  }
+  OverrideInputMap* MutableOverrideInputs() { return &override_inputs_; }
+  const OverrideInputMap& OverrideInputs() const { return override_inputs_; }
 
   // Get an input taking into account both original inputs and
   // overrides. If an override input is available use it, otherwise
   // use the original input. Accessing inputs via this method is not
   // valid until after PrepareForInference is called.
   Status ImmutableInput(const std::string& name, const Input** input) const;
-  const std::unordered_map<std::string, Input*>& ImmutableInputs() const
-  {
-    return inputs_;
-  }
+  const InputMap& ImmutableInputs() const { return inputs_; }
 
   // The original requested outputs are the requested outputs added to
   // the request before the inference execution (that is before
@@ -480,9 +650,24 @@ class InferenceRequest {
       TRITONSERVER_InferenceResponseCompleteFn_t response_fn,
       void* response_userp)
   {
+    auto coalescer = response_factory_.Coalescer();
     response_factory_ = InferenceResponseFactory(
         model_shared_, id_, allocator, alloc_userp, response_fn, response_userp,
         response_delegator_);
+    response_factory_.SetCoalescer(coalescer);
+    return Status::Success;
+  }
+
+  // Deliver the responses of the request in batches through 'batch_fn'
+  // instead of the response callback, see ResponseCoalescer.
+  Status SetResponseCoalescing(
+      TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn, void* userp,
+      const uint32_t max_response_count, const uint64_t max_delay_us)
+  {
+    std::shared_ptr<ResponseCoalescer> coalescer;
+    RETURN_IF_ERROR(ResponseCoalescer::Create(
+        batch_fn, userp, max_response_count, max_delay_us, &coalescer));
+    response_factory_.SetCoalescer(coalescer);
     return Status::Success;
   }
 
@@ -517,6 +702,9 @@ class InferenceRequest {
     return response_factory_.SetResponseDelegator(response_delegator_);
   }
 
+  // Whether a delegator is set for the responses of this request.
+  bool HasResponseDelegator() const { return response_delegator_ != nullptr; }
+
   Status SetSequenceStates(
       const std::shared_ptr<SequenceStates>& sequence_states)
   {
@@ -531,6 +719,24 @@ class InferenceRequest {
     return sequence_states_;
   }
 
+  // The inputs gathered with the other requests of the batch the request
+  // is executed in, nullptr if the inputs are not gathered.
+  void SetCollatedBatch(const std::shared_ptr<CollatedBatch>& collated_batch)
+  {
+    collated_batch_ = collated_batch;
+  }
+  const std::shared_ptr<CollatedBatch>& GetCollatedBatch() const
+  {
+    return collated_batch_;
+  }
+
+  // Mark that the config index of every original input is already
+  // set and that every original requested output is known to the
+  // model, so that normalization doesn't look them up in the model
+  // configuration again. Used by requests that are generated
+  // internally from a signature that has been validated once.
+  void SetConfigMatched() { config_matched_ = true; }
+
   // Prepare this request for inference.
   Status PrepareForInference();
 
@@ -688,12 +894,36 @@ class InferenceRequest {
       std::ostream& out, const InferenceRequest& request);
 
   Status Normalize();
+  Status NormalizeWithModelConfig();
+
+  // The signature of the inputs and the requested outputs of the
+  // request, the key of the normalization cache of the model.
+  uint64_t NormalizeSignature() const;
+
+  // Apply the normalization cached for 'signature' if any, return
+  // false if the request has to be normalized.
+  bool ApplyNormalizeCache(NormalizeCache* cache, const uint64_t signature);
+
+  // Add the normalization of the request to 'cache'.
+  void UpdateNormalizeCache(NormalizeCache* cache, const uint64_t signature);
+
+  // Reset the request to the state of a newly created request before
+  // it is pooled.
+  void Clear();
+
+  // Drop the inputs of the last inference execution and release their
+  // memory.
+  void ClearInferenceInputs();
 
   // Has anything in the request potentially changed in a way that
   // causes normalization to be required when preparing the request
   // for inference.
   bool needs_normalization_;
 
+  // Whether the inputs and the requested outputs are already matched
+  // with the model configuration by the creator of the request.
+  bool config_matched_;
+
   // The model associated with this request. For most requests
   // model_shared_ will be non-null and will act to keep the model
   // alive as long as this request is live. In this case model_raw_
@@ -717,14 +947,22 @@ class InferenceRequest {
   uint32_t batch_size_;
   uint32_t priority_;
   uint64_t timeout_us_;
+  std::atomic<bool> cancelled_{false};
+  static std::atomic<uint64_t> cancel_count_;
+  std::vector<InferenceParameter> parameters_;
   uint64_t cache_key_ = 0;
+  uint64_t cache_digest_ = 0;
   // Helper to determine if request was successfully hashed
   // and cache_key_ field is valid
   bool cache_key_is_set_ = false;
+  uint64_t shape_bucket_key_ = 0;
 
   std::unordered_map<std::string, Input> original_inputs_;
-  std::unordered_map<std::string, std::shared_ptr<Input>> override_inputs_;
-  std::unordered_map<std::string, Input*> inputs_;
+  // Must be declared before the containers allocating from it. The
+  // inline buffer fits the maps of requests with a few inputs.
+  InlineMonotonicArena<512> arena_;
+  OverrideInputMap override_inputs_;
+  InputMap inputs_;
   std::set<std::string> original_requested_outputs_;
   std::string raw_input_name_;
   uint32_t raw_input_size_;
@@ -782,6 +1020,62 @@ class InferenceRequest {
 
   // Sequence I/O states used for implicit state.
   std::shared_ptr<SequenceStates> sequence_states_;
+
+  // Inputs gathered for the batch the request is executed in.
+  std::shared_ptr<CollatedBatch> collated_batch_;
+};
+
+//
+// NormalizeCache
+//
+// The normalization of the requests of a model, keyed by the signature
+// of the requests. For models with fixed-shape inputs the requests
+// share a few signatures, so a request is normalized by copying the
+// cached metadata instead of validating it against the model
+// configuration again. The entries are looked up without locking, an
+// insertion publishes a new copy of the cache.
+//
+class NormalizeCache {
+ public:
+  struct Input {
+    std::string name_;
+    inference::DataType datatype_;
+    std::vector<int64_t> original_shape_;
+    int32_t config_index_;
+    bool is_shape_tensor_;
+    std::vector<int64_t> shape_;
+    std::vector<int64_t> shape_with_batch_dim_;
+  };
+
+  struct Entry {
+    std::vector<Input> inputs_;
+    std::set<std::string> original_requested_outputs_;
+    std::set<std::string> requested_outputs_;
+    uint32_t batch_size_;
+  };
+
+  NormalizeCache();
+
+  // Return the entry of 'signature', nullptr if there is none. The entries
+  // are never removed so the entry is valid as long as the cache.
+  const Entry* Find(const uint64_t signature) const;
+
+  // Add 'entry' for 'signature', no-op if the cache is full.
+  void Insert(
+      const uint64_t signature, const std::shared_ptr<const Entry>& entry);
+
+ private:
+  // The number of signatures kept, large enough for the few shapes of a
+  // model without letting variable-shape inputs grow the cache.
+  static constexpr size_t kCapacity = 64;
+
+  using EntryMap = std::unordered_map<uint64_t, std::shared_ptr<const Entry>>;
+
+  // Serializes the insertions, which are rare once the signatures of the
+  // model are known or the cache is full.
+  std::mutex insert_mu_;
+  std::atomic<bool> full_;
+  RcuSnapshot<EntryMap> entries_;
 };
 
 std::ostream& operator<<(std::ostream& out, const InferenceRequest& request);
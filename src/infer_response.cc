@@ -29,6 +29,7 @@
 #include "model.h"
 #include "model_config_utils.h"
 #include "server.h"
+#include "top_k.h"
 #include "triton/common/logging.h"
 
 namespace triton { namespace core {
@@ -43,6 +44,7 @@ InferenceResponseFactory::CreateResponse(
   response->reset(new InferenceResponse(
       model_, id_, allocator_, alloc_userp_, response_fn_, response_userp_,
       response_delegator_));
+  (*response)->SetCoalescer(coalescer_);
 #ifdef TRITON_ENABLE_TRACING
   (*response)->SetTrace(trace_);
 #endif  // TRITON_ENABLE_TRACING
@@ -56,6 +58,8 @@ InferenceResponseFactory::SendFlags(const uint32_t flags) const
     std::unique_ptr<InferenceResponse> response(
         new InferenceResponse(response_fn_, response_userp_));
     response_delegator_(std::move(response), flags);
+  } else if (coalescer_ != nullptr) {
+    coalescer_->Enqueue(nullptr /* response */, flags);
   } else {
     void* userp = response_userp_;
     response_fn_(nullptr /* response */, flags, userp);
@@ -73,9 +77,12 @@ InferenceResponse::InferenceResponse(
     void* response_userp,
     const std::function<
         void(std::unique_ptr<InferenceResponse>&&, const uint32_t)>& delegator)
-    : model_(model), id_(id), allocator_(allocator), alloc_userp_(alloc_userp),
-      response_fn_(response_fn), response_userp_(response_userp),
-      response_delegator_(delegator), null_response_(false)
+    : model_(model), id_(id),
+      parameters_(ParameterDeque::allocator_type(&arena_)),
+      outputs_(OutputDeque::allocator_type(&arena_)), allocator_(allocator),
+      alloc_userp_(alloc_userp), response_fn_(response_fn),
+      response_userp_(response_userp), response_delegator_(delegator),
+      null_response_(false)
 {
   // If the allocator has a start_fn then invoke it.
   TRITONSERVER_ResponseAllocatorStartFn_t start_fn = allocator_->StartFn();
@@ -92,7 +99,9 @@ InferenceResponse::InferenceResponse(
 InferenceResponse::InferenceResponse(
     TRITONSERVER_InferenceResponseCompleteFn_t response_fn,
     void* response_userp)
-    : response_fn_(response_fn), response_userp_(response_userp),
+    : parameters_(ParameterDeque::allocator_type(&arena_)),
+      outputs_(OutputDeque::allocator_type(&arena_)),
+      response_fn_(response_fn), response_userp_(response_userp),
       null_response_(true)
 {
 }
@@ -141,12 +150,7 @@ InferenceResponse::AddOutput(
   LOG_VERBOSE(1) << "add response output: " << outputs_.back();
 
   if (model_ != nullptr) {
-    const inference::ModelOutput* output_config;
-    RETURN_IF_ERROR(model_->GetOutput(name, &output_config));
-    if (output_config->has_reshape()) {
-      const bool has_batch_dim = (model_->Config().max_batch_size() > 0);
-      outputs_.back().Reshape(has_batch_dim, output_config);
-    }
+    RETURN_IF_ERROR(ReshapeOutput(name));
   }
 
   if (output != nullptr) {
@@ -167,12 +171,7 @@ InferenceResponse::AddOutput(
   LOG_VERBOSE(1) << "add response output: " << outputs_.back();
 
   if (model_ != nullptr) {
-    const inference::ModelOutput* output_config;
-    RETURN_IF_ERROR(model_->GetOutput(name, &output_config));
-    if (output_config->has_reshape()) {
-      const bool has_batch_dim = (model_->Config().max_batch_size() > 0);
-      outputs_.back().Reshape(has_batch_dim, output_config);
-    }
+    RETURN_IF_ERROR(ReshapeOutput(name));
   }
 
   if (output != nullptr) {
@@ -182,6 +181,24 @@ InferenceResponse::AddOutput(
   return Status::Success;
 }
 
+Status
+InferenceResponse::ReshapeOutput(const std::string& name)
+{
+  const ModelConfigSnapshot& config = model_->ConfigSnapshot();
+  const int32_t index = config.OutputIndex(name);
+  if (index < 0) {
+    return Status(
+        Status::Code::INVALID_ARG, "unexpected inference output '" + name +
+                                       "' for model '" + model_->Name() + "'");
+  }
+  const ModelConfigSnapshot::Tensor& output_config = config.outputs_[index];
+  if (output_config.has_reshape_) {
+    const bool has_batch_dim = (config.max_batch_size_ > 0);
+    outputs_.back().Reshape(has_batch_dim, output_config);
+  }
+  return Status::Success;
+}
+
 Status
 InferenceResponse::ClassificationLabel(
     const InferenceResponse::Output& output, const uint32_t class_index,
@@ -198,10 +215,117 @@ InferenceResponse::ClassificationLabel(
   return Status::Success;
 }
 
+Status
+InferenceResponse::Classify(
+    const uint32_t index, const uint32_t k,
+    const Classification** classification)
+{
+  if (index >= outputs_.size()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "out of bounds index " + std::to_string(index) +
+            std::string(": response has ") + std::to_string(outputs_.size()) +
+            " outputs");
+  }
+  for (const auto& lclassification : classifications_) {
+    if ((lclassification->index_ == index) && (lclassification->k_ == k)) {
+      *classification = lclassification.get();
+      return Status::Success;
+    }
+  }
+
+  const Output& output = outputs_[index];
+  const inference::DataType datatype = output.DType();
+  if ((datatype != inference::DataType::TYPE_FP32) &&
+      (datatype != inference::DataType::TYPE_FP16)) {
+    return Status(
+        Status::Code::UNSUPPORTED,
+        "classification is not supported for output '" + output.Name() +
+            "' of type " + inference::DataType_Name(datatype));
+  }
+  const void* base;
+  size_t byte_size;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  void* userp;
+  RETURN_IF_ERROR(output.DataBuffer(
+      &base, &byte_size, &memory_type, &memory_type_id, &userp));
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    return Status(
+        Status::Code::UNSUPPORTED,
+        "classification of output '" + output.Name() +
+            "' requires the output in CPU memory");
+  }
+
+  // The classes of each batch entry are contiguous
+  const size_t element_count =
+      byte_size / triton::common::GetDataTypeByteSize(datatype);
+  size_t batch_size = 1;
+  if ((model_ != nullptr) && (model_->ConfigSnapshot().max_batch_size_ > 0) &&
+      !output.Shape().empty() && (output.Shape()[0] > 0)) {
+    batch_size = output.Shape()[0];
+  }
+  const size_t class_count = element_count / batch_size;
+
+  std::unique_ptr<Classification> lclassification(new Classification());
+  lclassification->index_ = index;
+  lclassification->k_ = k;
+  lclassification->batch_size_ = batch_size;
+  lclassification->count_ = std::min<size_t>(k, class_count);
+  const size_t count = lclassification->count_;
+  lclassification->class_indices_.resize(batch_size * count);
+  lclassification->values_.resize(batch_size * count);
+
+  std::vector<float> converted;
+  if (datatype == inference::DataType::TYPE_FP16) {
+    converted.resize(class_count);
+  }
+  for (size_t b = 0; b < batch_size; ++b) {
+    const float* values;
+    if (datatype == inference::DataType::TYPE_FP16) {
+      HalfToFloat(
+          reinterpret_cast<const uint16_t*>(base) + (b * class_count),
+          class_count, converted.data());
+      values = converted.data();
+    } else {
+      values = reinterpret_cast<const float*>(base) + (b * class_count);
+    }
+    TopK(
+        values, class_count, count,
+        lclassification->class_indices_.data() + (b * count),
+        lclassification->values_.data() + (b * count));
+  }
+
+  // Resolve the labels once, they live as long as the model
+  lclassification->labels_.resize(batch_size * count, nullptr);
+  if (model_ != nullptr) {
+    const auto& labels = model_->GetLabelProvider()->GetLabels(output.Name());
+    for (size_t i = 0; i < lclassification->labels_.size(); ++i) {
+      const uint32_t class_index = lclassification->class_indices_[i];
+      if ((class_index < labels.size()) && !labels[class_index].empty()) {
+        lclassification->labels_[i] = labels[class_index].c_str();
+      }
+    }
+  }
+
+  *classification = lclassification.get();
+  classifications_.emplace_back(std::move(lclassification));
+  return Status::Success;
+}
+
 Status
 InferenceResponse::Send(
     std::unique_ptr<InferenceResponse>&& response, const uint32_t flags)
 {
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+  // The response may hold the last reference to the model.
+  const std::shared_ptr<Model> stage_model = response->model_;
+  CPU_STAGE_SCOPE(
+      cpu_stage_,
+      (stage_model != nullptr) ? stage_model->MutableStatsAggregator()
+                               : nullptr,
+      RESPONSE_SEND);
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
 #ifdef TRITON_ENABLE_TRACING
   response->TraceOutputTensors(
       TRITONSERVER_TRACE_TENSOR_BACKEND_OUTPUT, "InferenceResponse Send");
@@ -212,6 +336,11 @@ InferenceResponse::Send(
     ldelegator(std::move(response), flags);
     return Status::Success;
   }
+  if (response->coalescer_ != nullptr) {
+    auto lcoalescer = std::move(response->coalescer_);
+    lcoalescer->Enqueue(std::move(response), flags);
+    return Status::Success;
+  }
   void* userp = response->response_userp_;
   if (response->null_response_) {
     response->response_fn_(nullptr /* response */, flags, userp);
@@ -289,7 +418,7 @@ InferenceResponse::Output::~Output()
 
 void
 InferenceResponse::Output::Reshape(
-    const bool has_batch_dim, const inference::ModelOutput* output_config)
+    const bool has_batch_dim, const ModelConfigSnapshot::Tensor& output_config)
 {
   std::deque<int64_t> variable_size_values;
 
@@ -297,9 +426,9 @@ InferenceResponse::Output::Reshape(
       (has_batch_dim && (shape_.size() > 0)) ? shape_[0] : -1;
   const size_t batch_dim_offset = (has_batch_dim) ? 1 : 0;
 
-  const auto& from_shape = output_config->reshape().shape();
-  const auto& to_shape = output_config->dims();
-  for (int64_t idx = 0; idx < from_shape.size(); idx++) {
+  const auto& from_shape = output_config.reshape_;
+  const auto& to_shape = output_config.dims_;
+  for (size_t idx = 0; idx < from_shape.size(); idx++) {
     if (from_shape[idx] == -1) {
       variable_size_values.push_back(shape_[idx + batch_dim_offset]);
     }
@@ -378,12 +507,171 @@ InferenceResponse::Output::AllocateDataBuffer(
   return Status::Success;
 }
 
+Status
+InferenceResponse::Output::AllocateDataBuffers(
+    const std::vector<Output*>& outputs, void** buffers,
+    const size_t* buffer_byte_sizes, TRITONSERVER_MemoryType* memory_types,
+    int64_t* memory_type_ids)
+{
+  size_t begin = 0;
+  while (begin < outputs.size()) {
+    const ResponseAllocator* allocator = outputs[begin]->allocator_;
+    size_t end = begin + 1;
+    while ((end < outputs.size()) && (outputs[end]->allocator_ == allocator)) {
+      ++end;
+    }
+
+    if ((allocator->BatchAllocFn() == nullptr) || ((end - begin) == 1)) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        RETURN_IF_ERROR(outputs[idx]->AllocateDataBuffer(
+            &buffers[idx], buffer_byte_sizes[idx], &memory_types[idx],
+            &memory_type_ids[idx]));
+      }
+    } else {
+      RETURN_IF_ERROR(BatchAllocateDataBuffers(
+          allocator, outputs, begin, end, buffers, buffer_byte_sizes,
+          memory_types, memory_type_ids));
+    }
+
+    begin = end;
+  }
+
+  return Status::Success;
+}
+
+Status
+InferenceResponse::Output::BatchAllocateDataBuffers(
+    const ResponseAllocator* allocator, const std::vector<Output*>& outputs,
+    const size_t begin, const size_t end, void** buffers,
+    const size_t* buffer_byte_sizes, TRITONSERVER_MemoryType* memory_types,
+    int64_t* memory_type_ids)
+{
+  const size_t count = end - begin;
+  std::vector<const char*> names(count);
+  std::vector<void*> userps(count);
+  std::vector<void*> buffer_userps(count, nullptr);
+  std::vector<TRITONSERVER_BufferAttributes*> buffer_attributes(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    Output* output = outputs[begin + idx];
+    if (output->allocated_buffer_ != nullptr) {
+      return Status(
+          Status::Code::ALREADY_EXISTS,
+          "allocated buffer for output '" + output->name_ +
+              "' already exists");
+    }
+    names[idx] = output->name_.c_str();
+    userps[idx] = output->alloc_userp_;
+    buffer_attributes[idx] = reinterpret_cast<TRITONSERVER_BufferAttributes*>(
+        &output->buffer_attributes_);
+  }
+
+  RETURN_IF_TRITONSERVER_ERROR(allocator->BatchAllocFn()(
+      reinterpret_cast<TRITONSERVER_ResponseAllocator*>(
+          const_cast<ResponseAllocator*>(allocator)),
+      count, names.data(), &buffer_byte_sizes[begin], &memory_types[begin],
+      &memory_type_ids[begin], userps.data(), &buffers[begin],
+      buffer_userps.data(), buffer_attributes.data()));
+
+  for (size_t idx = 0; idx < count; ++idx) {
+    Output* output = outputs[begin + idx];
+    output->allocated_buffer_ = buffers[begin + idx];
+    output->buffer_attributes_.SetByteSize(buffer_byte_sizes[begin + idx]);
+    output->buffer_attributes_.SetMemoryType(memory_types[begin + idx]);
+    output->buffer_attributes_.SetMemoryTypeId(memory_type_ids[begin + idx]);
+    output->allocated_userp_ = buffer_userps[idx];
+  }
+
+  return Status::Success;
+}
+
+Status
+InferenceResponse::Output::SetBorrowedDataBuffer(
+    const void* buffer, const size_t buffer_byte_size,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const std::shared_ptr<void>& owner)
+{
+  if (allocated_buffer_ != nullptr) {
+    return Status(
+        Status::Code::ALREADY_EXISTS,
+        "allocated buffer for output '" + name_ + "' already exists");
+  }
+  if ((buffer == nullptr) || (owner == nullptr)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "borrowed buffer for output '" + name_ + "' must have an owner");
+  }
+
+  // The buffer is never written through the output so dropping const is
+  // safe, 'allocated_buffer_' is only exposed as a const buffer.
+  allocated_buffer_ = const_cast<void*>(buffer);
+  buffer_attributes_.SetByteSize(buffer_byte_size);
+  buffer_attributes_.SetMemoryType(memory_type);
+  buffer_attributes_.SetMemoryTypeId(memory_type_id);
+  allocated_userp_ = nullptr;
+  borrowed_buffer_owner_ = owner;
+
+  return Status::Success;
+}
+
+Status
+InferenceResponse::Output::SetStringOffsets(
+    const uint64_t* offsets, const size_t offset_count)
+{
+  if (datatype_ != inference::DataType::TYPE_STRING) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "output '" + name_ + "' is not a string tensor, its data type is " +
+            triton::common::DataTypeToProtocolString(datatype_));
+  }
+  if (allocated_buffer_ == nullptr) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "string offsets of output '" + name_ +
+            "' can only be set once its buffer is allocated");
+  }
+
+  // Only the structure of the offsets is checked, the length prefixes
+  // may not be accessible from the CPU.
+  const int64_t element_count = triton::common::GetElementCount(shape_);
+  if ((element_count < 0) || (offset_count != (size_t)element_count + 1)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "expected " + std::to_string(element_count + 1) +
+            " string offsets for output '" + name_ + "', got " +
+            std::to_string(offset_count));
+  }
+  for (size_t idx = 0; idx < (size_t)element_count; ++idx) {
+    if ((offsets[idx + 1] < offsets[idx] + sizeof(uint32_t)) ||
+        ((idx == 0) && (offsets[0] != 0))) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "invalid string offset " + std::to_string(idx) + " for output '" +
+              name_ + "'");
+    }
+  }
+  if (offsets[element_count] != buffer_attributes_.ByteSize()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "the string offsets of output '" + name_ + "' cover " +
+            std::to_string(offsets[element_count]) + " bytes, expected " +
+            std::to_string(buffer_attributes_.ByteSize()));
+  }
+
+  string_offsets_ = std::make_shared<const std::vector<uint64_t>>(
+      offsets, offsets + offset_count);
+  return Status::Success;
+}
+
 Status
 InferenceResponse::Output::ReleaseDataBuffer()
 {
   TRITONSERVER_Error* err = nullptr;
 
-  if (allocated_buffer_ != nullptr) {
+  if (borrowed_buffer_owner_ != nullptr) {
+    // Borrowed buffers are not owned by the allocator, just drop the
+    // reference on the owner
+    borrowed_buffer_owner_.reset();
+  } else if (allocated_buffer_ != nullptr) {
     err = allocator_->ReleaseFn()(
         reinterpret_cast<TRITONSERVER_ResponseAllocator*>(
             const_cast<ResponseAllocator*>(allocator_)),
@@ -396,6 +684,7 @@ InferenceResponse::Output::ReleaseDataBuffer()
   buffer_attributes_.SetMemoryType(TRITONSERVER_MEMORY_CPU);
   buffer_attributes_.SetMemoryTypeId(0);
   allocated_userp_ = nullptr;
+  string_offsets_.reset();
 
   RETURN_IF_TRITONSERVER_ERROR(err);
 
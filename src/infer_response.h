@@ -27,13 +27,17 @@
 
 #include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
+#include "arena.h"
 #include "buffer_attributes.h"
 #include "constants.h"
 #include "infer_parameter.h"
 #include "infer_trace.h"
+#include "model_config_snapshot.h"
 #include "response_allocator.h"
+#include "response_coalescer.h"
 #include "status.h"
 #include "triton/common/model_config.h"
 #include "tritonserver_apis.h"
@@ -74,6 +78,17 @@ class InferenceResponseFactory {
     return Status::Success;
   }
 
+  // The coalescer the responses are sent through, nullptr if they are
+  // sent to the response callback one by one.
+  const std::shared_ptr<ResponseCoalescer>& Coalescer() const
+  {
+    return coalescer_;
+  }
+  void SetCoalescer(const std::shared_ptr<ResponseCoalescer>& coalescer)
+  {
+    coalescer_ = coalescer;
+  }
+
   // Create a new response.
   Status CreateResponse(std::unique_ptr<InferenceResponse>* response) const;
 
@@ -107,17 +122,21 @@ class InferenceResponseFactory {
   // responsible for ensuring that the lifetime of the allocator
   // extends longer that any request or response that depend on the
   // allocator.
-  const ResponseAllocator* allocator_;
-  void* alloc_userp_;
+  const ResponseAllocator* allocator_ = nullptr;
+  void* alloc_userp_ = nullptr;
 
   // The response callback function and user pointer.
-  TRITONSERVER_InferenceResponseCompleteFn_t response_fn_;
-  void* response_userp_;
+  TRITONSERVER_InferenceResponseCompleteFn_t response_fn_ = nullptr;
+  void* response_userp_ = nullptr;
 
   // Delegator to be invoked on sending responses.
   std::function<void(std::unique_ptr<InferenceResponse>&&, const uint32_t)>
       response_delegator_;
 
+  // Coalescer of the responses, shared by all the responses created
+  // by the factory.
+  std::shared_ptr<ResponseCoalescer> coalescer_;
+
 #ifdef TRITON_ENABLE_TRACING
   // Inference trace associated with this response.
   std::shared_ptr<InferenceTraceProxy> trace_;
@@ -168,7 +187,8 @@ class InferenceResponse {
     // for outputs that have respace specified in the model
     // configuration.
     void Reshape(
-        const bool has_batch_dim, const inference::ModelOutput* output_config);
+        const bool has_batch_dim,
+        const ModelConfigSnapshot::Tensor& output_config);
 
     // Get information about the buffer allocated for this output
     // tensor's data. If no buffer is allocated 'buffer' will return
@@ -193,16 +213,57 @@ class InferenceResponse {
         void** buffer, const size_t buffer_byte_size,
         TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id);
 
+    // Allocate the buffers of 'outputs' as AllocateDataBuffer() does
+    // for each of them, the arrays hold an element per output. The
+    // consecutive outputs that share a response allocator with a batch
+    // allocation function are allocated with a single callback.
+    static Status AllocateDataBuffers(
+        const std::vector<Output*>& outputs, void** buffers,
+        const size_t* buffer_byte_sizes, TRITONSERVER_MemoryType* memory_types,
+        int64_t* memory_type_ids);
+
+    // Use a buffer that is owned by Triton as this output tensor's
+    // data instead of allocating one through the response
+    // allocator. The buffer stays valid as long as 'owner' is alive,
+    // the output holds a reference on 'owner' until the buffer is
+    // released. Must only be used if the response allocator accepts
+    // borrowed buffers.
+    Status SetBorrowedDataBuffer(
+        const void* buffer, const size_t buffer_byte_size,
+        const TRITONSERVER_MemoryType memory_type,
+        const int64_t memory_type_id, const std::shared_ptr<void>& owner);
+
     // Release the buffer that was previously allocated by
-    // AllocateDataBuffer(). Do nothing if AllocateDataBuffer() has
-    // not been called.
+    // AllocateDataBuffer() or set by SetBorrowedDataBuffer(). Do
+    // nothing if neither has been called.
     Status ReleaseDataBuffer();
 
+    // The offsets of the elements of a TYPE_STRING output in its
+    // buffer, as described by InferenceRequest::Input::StringOffsets().
+    // nullptr unless they were provided by the producer of the data.
+    const std::shared_ptr<const std::vector<uint64_t>>& StringOffsets() const
+    {
+      return string_offsets_;
+    }
+
+    // Set the 'offset_count' string offsets of the data in the buffer,
+    // the buffer must be allocated.
+    Status SetStringOffsets(
+        const uint64_t* offsets, const size_t offset_count);
+
    private:
     DISALLOW_COPY_AND_ASSIGN(Output);
     friend std::ostream& operator<<(
         std::ostream& out, const InferenceResponse::Output& output);
 
+    // Allocate the buffers of 'outputs' in [begin, end), which share
+    // 'allocator', with its batch allocation function.
+    static Status BatchAllocateDataBuffers(
+        const ResponseAllocator* allocator, const std::vector<Output*>& outputs,
+        const size_t begin, const size_t end, void** buffers,
+        const size_t* buffer_byte_sizes, TRITONSERVER_MemoryType* memory_types,
+        int64_t* memory_type_ids);
+
     std::string name_;
     inference::DataType datatype_;
     std::vector<int64_t> shape_;
@@ -217,6 +278,13 @@ class InferenceResponse {
     void* allocated_buffer_;
     BufferAttributes buffer_attributes_;
     void* allocated_userp_;
+
+    // Owner of 'allocated_buffer_' if the buffer is borrowed, nullptr
+    // if the buffer was allocated through the response allocator.
+    std::shared_ptr<void> borrowed_buffer_owner_;
+
+    // The offsets of the string elements in the buffer.
+    std::shared_ptr<const std::vector<uint64_t>> string_offsets_;
   };
 
   // InferenceResponse
@@ -237,15 +305,19 @@ class InferenceResponse {
       void* response_userp);
 
   const std::string& Id() const { return id_; }
+  const ResponseAllocator* Allocator() const { return allocator_; }
   const std::string& ModelName() const;
   int64_t ActualModelVersion() const;
   const Status& ResponseStatus() const { return status_; }
 
+  // The parameters and outputs are allocated from an arena of the
+  // response, released in one shot with the response.
+  using ParameterDeque =
+      std::deque<InferenceParameter, ArenaAllocator<InferenceParameter>>;
+  using OutputDeque = std::deque<Output, ArenaAllocator<Output>>;
+
   // The response parameters.
-  const std::deque<InferenceParameter>& Parameters() const
-  {
-    return parameters_;
-  }
+  const ParameterDeque& Parameters() const { return parameters_; }
 
   // Add an parameter to the response.
   Status AddParameter(const char* name, const char* value);
@@ -253,7 +325,7 @@ class InferenceResponse {
   Status AddParameter(const char* name, const bool value);
 
   // The response outputs.
-  const std::deque<Output>& Outputs() const { return outputs_; }
+  const OutputDeque& Outputs() const { return outputs_; }
 
   // Add an output to the response. If 'output' is non-null
   // return a pointer to the newly added output.
@@ -270,6 +342,27 @@ class InferenceResponse {
       const Output& output, const uint32_t class_index,
       const char** label) const;
 
+  // The top-k classification of each batch entry of an output. The
+  // arrays hold 'count_' classes per batch entry, from the highest
+  // value, and 'labels_' holds nullptr for the classes without label.
+  struct Classification {
+    uint32_t index_;
+    uint32_t k_;
+    uint32_t batch_size_;
+    uint32_t count_;
+    std::vector<uint32_t> class_indices_;
+    std::vector<float> values_;
+    std::vector<const char*> labels_;
+  };
+
+  // Get the top-k classification of the output at 'index'. It is
+  // computed on the first call for a given 'k' and valid until the
+  // response is deleted. Only FP32 and FP16 outputs in CPU memory are
+  // supported.
+  Status Classify(
+      const uint32_t index, const uint32_t k,
+      const Classification** classification);
+
   // Send the response with success status. Calling this function
   // releases ownership of the response object and gives it to the
   // callback function.
@@ -283,6 +376,13 @@ class InferenceResponse {
       std::unique_ptr<InferenceResponse>&& response, const uint32_t flags,
       const Status& status);
 
+  // Send the response through 'coalescer' instead of the response
+  // callback.
+  void SetCoalescer(const std::shared_ptr<ResponseCoalescer>& coalescer)
+  {
+    coalescer_ = coalescer;
+  }
+
 #ifdef TRITON_ENABLE_TRACING
   const std::shared_ptr<InferenceTraceProxy>& Trace() const { return trace_; }
   void SetTrace(const std::shared_ptr<InferenceTraceProxy>& trace)
@@ -297,6 +397,10 @@ class InferenceResponse {
   friend std::ostream& operator<<(
       std::ostream& out, const InferenceResponse& response);
 
+  // Apply the reshape of the model configuration to the last added
+  // output, named 'name'.
+  Status ReshapeOutput(const std::string& name);
+
 #ifdef TRITON_ENABLE_TRACING
   Status TraceOutputTensors(
       TRITONSERVER_InferenceTraceActivity activity, const std::string& msg);
@@ -317,12 +421,20 @@ class InferenceResponse {
   // Error status for the response.
   Status status_;
 
+  // Must be declared before the containers allocating from it. The
+  // inline buffer fits the deques of responses with a few outputs and
+  // parameters.
+  InlineMonotonicArena<1152> arena_;
+
   // The parameters of the response. Use a deque so that there is no
   // reallocation.
-  std::deque<InferenceParameter> parameters_;
+  ParameterDeque parameters_;
 
   // The result tensors. Use a deque so that there is no reallocation.
-  std::deque<Output> outputs_;
+  OutputDeque outputs_;
+
+  // The classifications computed by Classify().
+  std::vector<std::unique_ptr<Classification>> classifications_;
 
   // The response allocator and user pointer.
   const ResponseAllocator* allocator_;
@@ -336,6 +448,10 @@ class InferenceResponse {
   std::function<void(std::unique_ptr<InferenceResponse>&&, const uint32_t)>
       response_delegator_;
 
+  // The coalescer of the responses of the request, nullptr if the
+  // responses are sent to the callback one by one.
+  std::shared_ptr<ResponseCoalescer> coalescer_;
+
   bool null_response_;
 
 #ifdef TRITON_ENABLE_TRACING
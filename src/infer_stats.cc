@@ -27,23 +27,358 @@
 #include "infer_stats.h"
 
 #include <time.h>
+#include <algorithm>
+#include <initializer_list>
 #include "metric_model_reporter.h"
 #include "metrics.h"
 #include "triton/common/logging.h"
 
 namespace triton { namespace core {
 
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+const char*
+CpuStageString(const CpuStage stage)
+{
+  switch (stage) {
+    case CpuStage::NORMALIZE:
+      return "normalize";
+    case CpuStage::ENQUEUE:
+      return "enqueue";
+    case CpuStage::BATCH_FORMATION:
+      return "batch_formation";
+    case CpuStage::RATE_LIMITER:
+      return "rate_limiter";
+    case CpuStage::EXECUTE:
+      return "execute";
+    case CpuStage::RESPONSE_SEND:
+      return "response_send";
+    case CpuStage::CACHE_LOOKUP:
+      return "cache_lookup";
+    default:
+      break;
+  }
+
+  return "<unknown>";
+}
+
+uint64_t
+ThreadCpuNs()
+{
+#ifdef _WIN32
+  // The thread CPU clock is not supported.
+  return 0;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif  // _WIN32
+}
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+
 #ifdef TRITON_ENABLE_STATS
 
+InferenceStatsAggregator::Stripe::Stripe()
+{
+  for (auto& chunk : batch_chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+  Reset();
+}
+
+InferenceStatsAggregator::Stripe::~Stripe()
+{
+  for (auto& chunk : batch_chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+void
+InferenceStatsAggregator::Stripe::Reset()
+{
+  for (auto* counter :
+       {&last_inference_ms_, &inference_count_, &execution_count_,
+        &failure_count_, &failure_duration_ns_, &success_count_,
+        &request_duration_ns_, &queue_duration_ns_,
+        &compute_input_duration_ns_, &compute_infer_duration_ns_,
+        &compute_output_duration_ns_, &cache_hit_count_,
+        &cache_hit_lookup_duration_ns_, &cache_miss_count_,
+        &cache_miss_lookup_duration_ns_, &cache_miss_insertion_duration_ns_}) {
+    counter->store(0, std::memory_order_relaxed);
+  }
+  // The batch chunks are kept allocated for the next user of the stripe
+  for (auto& c : batch_chunks_) {
+    BatchCounters* chunk = c.load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      continue;
+    }
+    for (size_t idx = 0; idx < kBatchChunkSize; ++idx) {
+      chunk[idx].count_.store(0, std::memory_order_relaxed);
+      chunk[idx].compute_input_duration_ns_.store(
+          0, std::memory_order_relaxed);
+      chunk[idx].compute_infer_duration_ns_.store(
+          0, std::memory_order_relaxed);
+      chunk[idx].compute_output_duration_ns_.store(
+          0, std::memory_order_relaxed);
+    }
+  }
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+  for (size_t idx = 0; idx < kCpuStageCount; ++idx) {
+    cpu_stage_count_[idx].store(0, std::memory_order_relaxed);
+    cpu_stage_ns_[idx].store(0, std::memory_order_relaxed);
+  }
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+}
+
+InferenceStatsAggregator::InferenceStatsAggregator()
+{
+  for (auto& stripe : stripes_) {
+    stripe.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+InferenceStatsAggregator::~InferenceStatsAggregator()
+{
+  for (auto& stripe : stripes_) {
+    Stripe* s = stripe.load(std::memory_order_relaxed);
+    if (s != nullptr) {
+      ReleaseStripe(s);
+    }
+  }
+}
+
+std::mutex&
+InferenceStatsAggregator::StripePoolMutex()
+{
+  static std::mutex mu;
+  return mu;
+}
+
+std::vector<InferenceStatsAggregator::Stripe*>&
+InferenceStatsAggregator::StripePool()
+{
+  // Never destroyed so that aggregators destroyed at exit can still
+  // release their stripes.
+  static std::vector<Stripe*>* pool = new std::vector<Stripe*>();
+  return *pool;
+}
+
+InferenceStatsAggregator::Stripe*
+InferenceStatsAggregator::AcquireStripe()
+{
+  {
+    std::lock_guard<std::mutex> lk(StripePoolMutex());
+    auto& pool = StripePool();
+    if (!pool.empty()) {
+      Stripe* stripe = pool.back();
+      pool.pop_back();
+      return stripe;
+    }
+  }
+  return new Stripe();
+}
+
+void
+InferenceStatsAggregator::ReleaseStripe(Stripe* stripe)
+{
+  stripe->Reset();
+  {
+    std::lock_guard<std::mutex> lk(StripePoolMutex());
+    auto& pool = StripePool();
+    if (pool.size() < kMaxPooledStripes) {
+      pool.push_back(stripe);
+      return;
+    }
+  }
+  delete stripe;
+}
+
+InferenceStatsAggregator::Stripe*
+InferenceStatsAggregator::ThreadStripe()
+{
+  // Each thread is assigned a stripe index on first use, shared by all
+  // the aggregators.
+  static std::atomic<size_t> next_stripe(0);
+  thread_local const size_t stripe_idx = next_stripe++ % kStripeCount;
+
+  Stripe* stripe = stripes_[stripe_idx].load(std::memory_order_acquire);
+  if (stripe == nullptr) {
+    Stripe* new_stripe = AcquireStripe();
+    if (stripes_[stripe_idx].compare_exchange_strong(
+            stripe, new_stripe, std::memory_order_acq_rel)) {
+      stripe = new_stripe;
+    } else {
+      ReleaseStripe(new_stripe);
+    }
+  }
+  return stripe;
+}
+
+uint64_t
+InferenceStatsAggregator::LastInferenceMs() const
+{
+  uint64_t last_inference_ms = 0;
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe != nullptr) {
+      last_inference_ms = std::max(
+          last_inference_ms,
+          stripe->last_inference_ms_.load(std::memory_order_relaxed));
+    }
+  }
+  return last_inference_ms;
+}
+
+uint64_t
+InferenceStatsAggregator::InferenceCount() const
+{
+  uint64_t inference_count = 0;
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe != nullptr) {
+      inference_count +=
+          stripe->inference_count_.load(std::memory_order_relaxed);
+    }
+  }
+  return inference_count;
+}
+
+uint64_t
+InferenceStatsAggregator::ExecutionCount() const
+{
+  uint64_t execution_count = 0;
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe != nullptr) {
+      execution_count +=
+          stripe->execution_count_.load(std::memory_order_relaxed);
+    }
+  }
+  return execution_count;
+}
+
+InferenceStatsAggregator::InferStats
+InferenceStatsAggregator::InferStatsSnapshot() const
+{
+  InferStats stats;
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe == nullptr) {
+      continue;
+    }
+    stats.failure_count_ +=
+        stripe->failure_count_.load(std::memory_order_relaxed);
+    stats.failure_duration_ns_ +=
+        stripe->failure_duration_ns_.load(std::memory_order_relaxed);
+    stats.success_count_ +=
+        stripe->success_count_.load(std::memory_order_relaxed);
+    stats.request_duration_ns_ +=
+        stripe->request_duration_ns_.load(std::memory_order_relaxed);
+    stats.queue_duration_ns_ +=
+        stripe->queue_duration_ns_.load(std::memory_order_relaxed);
+    stats.compute_input_duration_ns_ +=
+        stripe->compute_input_duration_ns_.load(std::memory_order_relaxed);
+    stats.compute_infer_duration_ns_ +=
+        stripe->compute_infer_duration_ns_.load(std::memory_order_relaxed);
+    stats.compute_output_duration_ns_ +=
+        stripe->compute_output_duration_ns_.load(std::memory_order_relaxed);
+    stats.cache_hit_count_ +=
+        stripe->cache_hit_count_.load(std::memory_order_relaxed);
+    stats.cache_hit_lookup_duration_ns_ +=
+        stripe->cache_hit_lookup_duration_ns_.load(std::memory_order_relaxed);
+    stats.cache_miss_count_ +=
+        stripe->cache_miss_count_.load(std::memory_order_relaxed);
+    stats.cache_miss_lookup_duration_ns_ +=
+        stripe->cache_miss_lookup_duration_ns_.load(std::memory_order_relaxed);
+    stats.cache_miss_insertion_duration_ns_ +=
+        stripe->cache_miss_insertion_duration_ns_.load(
+            std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void
+InferenceStatsAggregator::InferBatchStatsSnapshot(
+    std::map<size_t, InferBatchStats>* stats) const
+{
+  {
+    std::lock_guard<std::mutex> lock(overflow_mu_);
+    *stats = overflow_batch_stats_;
+  }
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe == nullptr) {
+      continue;
+    }
+    for (size_t c = 0; c < kBatchChunkCount; ++c) {
+      const BatchCounters* chunk =
+          stripe->batch_chunks_[c].load(std::memory_order_acquire);
+      if (chunk == nullptr) {
+        continue;
+      }
+      for (size_t idx = 0; idx < kBatchChunkSize; ++idx) {
+        const uint64_t count =
+            chunk[idx].count_.load(std::memory_order_relaxed);
+        if (count == 0) {
+          continue;
+        }
+        auto& batch_stats = (*stats)[c * kBatchChunkSize + idx];
+        batch_stats.count_ += count;
+        batch_stats.compute_input_duration_ns_ +=
+            chunk[idx].compute_input_duration_ns_.load(
+                std::memory_order_relaxed);
+        batch_stats.compute_infer_duration_ns_ +=
+            chunk[idx].compute_infer_duration_ns_.load(
+                std::memory_order_relaxed);
+        batch_stats.compute_output_duration_ns_ +=
+            chunk[idx].compute_output_duration_ns_.load(
+                std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+void
+InferenceStatsAggregator::CpuStageStatsSnapshot(
+    CpuStageStats stats[kCpuStageCount]) const
+{
+  for (size_t idx = 0; idx < kCpuStageCount; ++idx) {
+    stats[idx] = CpuStageStats();
+  }
+  for (const auto& s : stripes_) {
+    const Stripe* stripe = s.load(std::memory_order_acquire);
+    if (stripe == nullptr) {
+      continue;
+    }
+    for (size_t idx = 0; idx < kCpuStageCount; ++idx) {
+      stats[idx].count_ +=
+          stripe->cpu_stage_count_[idx].load(std::memory_order_relaxed);
+      stats[idx].cpu_ns_ +=
+          stripe->cpu_stage_ns_[idx].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void
+InferenceStatsAggregator::UpdateCpuStage(
+    const CpuStage stage, const uint64_t cpu_ns)
+{
+  Stripe* stripe = ThreadStripe();
+  const size_t idx = static_cast<size_t>(stage);
+  stripe->cpu_stage_count_[idx].fetch_add(1, std::memory_order_relaxed);
+  stripe->cpu_stage_ns_[idx].fetch_add(cpu_ns, std::memory_order_relaxed);
+}
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+
 void
 InferenceStatsAggregator::UpdateFailure(
     MetricModelReporter* metric_reporter, const uint64_t request_start_ns,
     const uint64_t request_end_ns)
 {
-  std::lock_guard<std::mutex> lock(mu_);
-
-  infer_stats_.failure_count_++;
-  infer_stats_.failure_duration_ns_ += (request_end_ns - request_start_ns);
+  Stripe* stripe = ThreadStripe();
+  stripe->failure_count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->failure_duration_ns_.fetch_add(
+      request_end_ns - request_start_ns, std::memory_order_relaxed);
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -84,16 +419,19 @@ InferenceStatsAggregator::UpdateSuccessWithDuration(
   const uint64_t request_duration_ns = request_end_ns - request_start_ns;
   const uint64_t queue_duration_ns = compute_start_ns - queue_start_ns;
 
-  std::lock_guard<std::mutex> lock(mu_);
-
-  inference_count_ += batch_size;
-
-  infer_stats_.success_count_++;
-  infer_stats_.request_duration_ns_ += request_duration_ns;
-  infer_stats_.queue_duration_ns_ += queue_duration_ns;
-  infer_stats_.compute_input_duration_ns_ += compute_input_duration_ns;
-  infer_stats_.compute_infer_duration_ns_ += compute_infer_duration_ns;
-  infer_stats_.compute_output_duration_ns_ += compute_output_duration_ns;
+  Stripe* stripe = ThreadStripe();
+  stripe->inference_count_.fetch_add(batch_size, std::memory_order_relaxed);
+  stripe->success_count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->request_duration_ns_.fetch_add(
+      request_duration_ns, std::memory_order_relaxed);
+  stripe->queue_duration_ns_.fetch_add(
+      queue_duration_ns, std::memory_order_relaxed);
+  stripe->compute_input_duration_ns_.fetch_add(
+      compute_input_duration_ns, std::memory_order_relaxed);
+  stripe->compute_infer_duration_ns_.fetch_add(
+      compute_infer_duration_ns, std::memory_order_relaxed);
+  stripe->compute_output_duration_ns_.fetch_add(
+      compute_output_duration_ns, std::memory_order_relaxed);
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -109,6 +447,8 @@ InferenceStatsAggregator::UpdateSuccessWithDuration(
         compute_infer_duration_ns / 1000);
     metric_reporter->MetricInferenceComputeOutputDuration().Increment(
         compute_output_duration_ns / 1000);
+    metric_reporter->ReportRequestLatency(
+        request_duration_ns, queue_duration_ns);
   }
 #endif  // TRITON_ENABLE_METRICS
 }
@@ -126,13 +466,15 @@ InferenceStatsAggregator::UpdateSuccessCacheHit(
   const uint64_t request_duration_ns = request_end_ns - request_start_ns;
   const uint64_t queue_duration_ns = cache_lookup_start_ns - queue_start_ns;
 
-  std::lock_guard<std::mutex> lock(mu_);
-
-  infer_stats_.success_count_++;
-  infer_stats_.request_duration_ns_ += request_duration_ns;
-  infer_stats_.queue_duration_ns_ += queue_duration_ns;
-  infer_stats_.cache_hit_count_++;
-  infer_stats_.cache_hit_lookup_duration_ns_ += cache_hit_lookup_duration_ns;
+  Stripe* stripe = ThreadStripe();
+  stripe->success_count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->request_duration_ns_.fetch_add(
+      request_duration_ns, std::memory_order_relaxed);
+  stripe->queue_duration_ns_.fetch_add(
+      queue_duration_ns, std::memory_order_relaxed);
+  stripe->cache_hit_count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->cache_hit_lookup_duration_ns_.fetch_add(
+      cache_hit_lookup_duration_ns, std::memory_order_relaxed);
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -144,6 +486,8 @@ InferenceStatsAggregator::UpdateSuccessCacheHit(
     metric_reporter->MetricCacheHitCount().Increment(1);
     metric_reporter->MetricCacheHitLookupDuration().Increment(
         cache_hit_lookup_duration_ns / 1000);
+    metric_reporter->ReportRequestLatency(
+        request_duration_ns, queue_duration_ns);
   }
 #endif  // TRITON_ENABLE_METRICS
 }
@@ -158,15 +502,16 @@ InferenceStatsAggregator::UpdateSuccessCacheMiss(
     const uint64_t cache_miss_lookup_duration_ns,
     const uint64_t cache_miss_insertion_duration_ns)
 {
-  std::lock_guard<std::mutex> lock(mu_);
-
   const uint64_t cache_miss_duration_ns =
       cache_miss_lookup_duration_ns + cache_miss_insertion_duration_ns;
-  infer_stats_.request_duration_ns_ += cache_miss_duration_ns;
-  infer_stats_.cache_miss_count_++;
-  infer_stats_.cache_miss_lookup_duration_ns_ += cache_miss_lookup_duration_ns;
-  infer_stats_.cache_miss_insertion_duration_ns_ +=
-      cache_miss_insertion_duration_ns;
+  Stripe* stripe = ThreadStripe();
+  stripe->request_duration_ns_.fetch_add(
+      cache_miss_duration_ns, std::memory_order_relaxed);
+  stripe->cache_miss_count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->cache_miss_lookup_duration_ns_.fetch_add(
+      cache_miss_lookup_duration_ns, std::memory_order_relaxed);
+  stripe->cache_miss_insertion_duration_ns_.fetch_add(
+      cache_miss_insertion_duration_ns, std::memory_order_relaxed);
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
@@ -212,26 +557,62 @@ InferenceStatsAggregator::UpdateInferBatchStatsWithDuration(
           std::chrono::system_clock::now().time_since_epoch())
           .count();
 
-  std::lock_guard<std::mutex> lock(mu_);
-
-  if (inference_ms > last_inference_ms_) {
-    last_inference_ms_ = inference_ms;
+  Stripe* stripe = ThreadStripe();
+  uint64_t last_inference_ms =
+      stripe->last_inference_ms_.load(std::memory_order_relaxed);
+  while ((inference_ms > last_inference_ms) &&
+         !stripe->last_inference_ms_.compare_exchange_weak(
+             last_inference_ms, inference_ms, std::memory_order_relaxed)) {
   }
+  stripe->execution_count_.fetch_add(1, std::memory_order_relaxed);
 
-  execution_count_++;
-
-  auto it = batch_stats_.find(batch_size);
-  if (it == batch_stats_.end()) {
-    it = batch_stats_.emplace(batch_size, InferBatchStats()).first;
+  if (batch_size < (kBatchChunkCount * kBatchChunkSize)) {
+    const size_t chunk_idx = batch_size / kBatchChunkSize;
+    BatchCounters* chunk =
+        stripe->batch_chunks_[chunk_idx].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+      BatchCounters* new_chunk = new BatchCounters[kBatchChunkSize];
+      for (size_t idx = 0; idx < kBatchChunkSize; ++idx) {
+        new_chunk[idx].count_.store(0, std::memory_order_relaxed);
+        new_chunk[idx].compute_input_duration_ns_.store(
+            0, std::memory_order_relaxed);
+        new_chunk[idx].compute_infer_duration_ns_.store(
+            0, std::memory_order_relaxed);
+        new_chunk[idx].compute_output_duration_ns_.store(
+            0, std::memory_order_relaxed);
+      }
+      if (stripe->batch_chunks_[chunk_idx].compare_exchange_strong(
+              chunk, new_chunk, std::memory_order_acq_rel)) {
+        chunk = new_chunk;
+      } else {
+        delete[] new_chunk;
+      }
+    }
+    BatchCounters& counters = chunk[batch_size % kBatchChunkSize];
+    counters.compute_input_duration_ns_.fetch_add(
+        compute_input_duration_ns, std::memory_order_relaxed);
+    counters.compute_infer_duration_ns_.fetch_add(
+        compute_infer_duration_ns, std::memory_order_relaxed);
+    counters.compute_output_duration_ns_.fetch_add(
+        compute_output_duration_ns, std::memory_order_relaxed);
+    counters.count_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    std::lock_guard<std::mutex> lock(overflow_mu_);
+    auto& batch_stats = overflow_batch_stats_[batch_size];
+    batch_stats.count_++;
+    batch_stats.compute_input_duration_ns_ += compute_input_duration_ns;
+    batch_stats.compute_infer_duration_ns_ += compute_infer_duration_ns;
+    batch_stats.compute_output_duration_ns_ += compute_output_duration_ns;
   }
-  it->second.count_++;
-  it->second.compute_input_duration_ns_ += compute_input_duration_ns;
-  it->second.compute_infer_duration_ns_ += compute_infer_duration_ns;
-  it->second.compute_output_duration_ns_ += compute_output_duration_ns;
 
 #ifdef TRITON_ENABLE_METRICS
   if (metric_reporter != nullptr) {
     metric_reporter->MetricInferenceExecutionCount().Increment(1);
+    const uint64_t compute_duration_ns = compute_input_duration_ns +
+                                         compute_infer_duration_ns +
+                                         compute_output_duration_ns;
+    metric_reporter->ReportComputeLatency(compute_duration_ns);
+    metric_reporter->ReportDeviceBusy(compute_duration_ns);
   }
 #endif  // TRITON_ENABLE_METRICS
 }
@@ -26,9 +26,11 @@
 #pragma once
 
 #include <time.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 #include "constants.h"
 #include "status.h"
 #include "tritonserver_apis.h"
@@ -37,11 +39,36 @@ namespace triton { namespace core {
 
 class MetricModelReporter;
 
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+// The stages of the request path whose CPU time is accounted per model.
+// The CPU time of a stage includes the CPU time of the stages it invokes,
+// for example the cache lookup done while enqueuing a request.
+enum class CpuStage {
+  NORMALIZE,
+  ENQUEUE,
+  BATCH_FORMATION,
+  RATE_LIMITER,
+  EXECUTE,
+  RESPONSE_SEND,
+  CACHE_LOOKUP,
+  COUNT
+};
+constexpr size_t kCpuStageCount = static_cast<size_t>(CpuStage::COUNT);
+
+// Return the name of the stage in the statistics.
+const char* CpuStageString(const CpuStage stage);
+
+// Return the CPU time consumed by the calling thread, in nanoseconds.
+uint64_t ThreadCpuNs();
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
 
 //
 // InferenceStatsAggregator
 //
-// A statistics aggregator.
+// A statistics aggregator. The statistics are recorded without locks
+// into per-thread stripes of counters so that the threads completing
+// requests of the same model don't contend on shared cache lines, the
+// stripes are only merged when the statistics are read.
 //
 class InferenceStatsAggregator {
 #ifdef TRITON_ENABLE_STATS
@@ -76,6 +103,12 @@ class InferenceStatsAggregator {
     uint64_t cache_miss_insertion_duration_ns_;
   };
 
+  struct CpuStageStats {
+    CpuStageStats() : count_(0), cpu_ns_(0) {}
+    uint64_t count_;
+    uint64_t cpu_ns_;
+  };
+
   struct InferBatchStats {
     InferBatchStats()
         : count_(0), compute_input_duration_ns_(0),
@@ -89,19 +122,27 @@ class InferenceStatsAggregator {
   };
 
   // Create an aggregator for model statistics
-  InferenceStatsAggregator()
-      : last_inference_ms_(0), inference_count_(0), execution_count_(0)
-  {
-  }
+  InferenceStatsAggregator();
+  ~InferenceStatsAggregator();
 
-  uint64_t LastInferenceMs() const { return last_inference_ms_; }
-  uint64_t InferenceCount() const { return inference_count_; }
-  uint64_t ExecutionCount() const { return execution_count_; }
-  const InferStats& ImmutableInferStats() const { return infer_stats_; }
-  const std::map<size_t, InferBatchStats>& ImmutableInferBatchStats() const
-  {
-    return batch_stats_;
-  }
+  // The statistics below are merged from the stripes on each call, they
+  // are safe to call while the statistics are being updated.
+  uint64_t LastInferenceMs() const;
+  uint64_t InferenceCount() const;
+  uint64_t ExecutionCount() const;
+  InferStats InferStatsSnapshot() const;
+
+  // Copy the batch statistics, keyed by batch size, into 'stats'.
+  void InferBatchStatsSnapshot(std::map<size_t, InferBatchStats>* stats) const;
+
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+  // Copy the CPU time statistics of the stages, indexed by stage, into
+  // 'stats'.
+  void CpuStageStatsSnapshot(CpuStageStats stats[kCpuStageCount]) const;
+
+  // Add 'cpu_ns' of CPU time to the statistics of 'stage'.
+  void UpdateCpuStage(const CpuStage stage, const uint64_t cpu_ns);
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
 
   // Add durations to Infer stats for a failed inference request.
   void UpdateFailure(
@@ -157,12 +198,73 @@ class InferenceStatsAggregator {
       const uint64_t compute_output_duration_ns);
 
  private:
-  std::mutex mu_;
-  uint64_t last_inference_ms_;
-  uint64_t inference_count_;
-  uint64_t execution_count_;
-  InferStats infer_stats_;
-  std::map<size_t, InferBatchStats> batch_stats_;
+  DISALLOW_COPY_AND_ASSIGN(InferenceStatsAggregator);
+
+  // The batch statistics are kept in a dense array indexed by batch
+  // size, allocated in chunks on first use. The statistics of the batch
+  // sizes beyond the array are kept in 'overflow_batch_stats_'.
+  static constexpr size_t kBatchChunkSize = 32;
+  static constexpr size_t kBatchChunkCount = 32;
+  static constexpr size_t kStripeCount = 16;
+  static constexpr size_t kMaxPooledStripes = 1024;
+
+  struct BatchCounters {
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> compute_input_duration_ns_;
+    std::atomic<uint64_t> compute_infer_duration_ns_;
+    std::atomic<uint64_t> compute_output_duration_ns_;
+  };
+
+  // The counters updated by the threads assigned to the stripe. The
+  // stripes are taken from a process-wide pool on first use, since an
+  // aggregator may live for a single ensemble request, and padded so that
+  // two stripes never share a cache line.
+  struct Stripe {
+    Stripe();
+    ~Stripe();
+
+    // Zero the counters before the stripe is returned to the pool.
+    void Reset();
+
+    char head_pad_[64];
+    std::atomic<uint64_t> last_inference_ms_;
+    std::atomic<uint64_t> inference_count_;
+    std::atomic<uint64_t> execution_count_;
+    std::atomic<uint64_t> failure_count_;
+    std::atomic<uint64_t> failure_duration_ns_;
+    std::atomic<uint64_t> success_count_;
+    std::atomic<uint64_t> request_duration_ns_;
+    std::atomic<uint64_t> queue_duration_ns_;
+    std::atomic<uint64_t> compute_input_duration_ns_;
+    std::atomic<uint64_t> compute_infer_duration_ns_;
+    std::atomic<uint64_t> compute_output_duration_ns_;
+    std::atomic<uint64_t> cache_hit_count_;
+    std::atomic<uint64_t> cache_hit_lookup_duration_ns_;
+    std::atomic<uint64_t> cache_miss_count_;
+    std::atomic<uint64_t> cache_miss_lookup_duration_ns_;
+    std::atomic<uint64_t> cache_miss_insertion_duration_ns_;
+    std::atomic<BatchCounters*> batch_chunks_[kBatchChunkCount];
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+    std::atomic<uint64_t> cpu_stage_count_[kCpuStageCount];
+    std::atomic<uint64_t> cpu_stage_ns_[kCpuStageCount];
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+    char tail_pad_[64];
+  };
+
+  // Return the stripe of the calling thread, acquiring it if needed.
+  Stripe* ThreadStripe();
+
+  // Take a zeroed stripe from the pool, or allocate one if the pool is
+  // empty. Return 'stripe' to the pool, or free it if the pool is full.
+  static Stripe* AcquireStripe();
+  static void ReleaseStripe(Stripe* stripe);
+  static std::mutex& StripePoolMutex();
+  static std::vector<Stripe*>& StripePool();
+
+  std::atomic<Stripe*> stripes_[kStripeCount];
+
+  mutable std::mutex overflow_mu_;
+  std::map<size_t, InferBatchStats> overflow_batch_stats_;
 #endif  // TRITON_ENABLE_STATS
 };
 
@@ -185,4 +287,39 @@ class InferenceStatsAggregator {
 #define INFER_STATS_SET_TIMESTAMP(TS_NS)
 #endif  // TRITON_ENABLE_STATS
 
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+//
+// CpuStageTimer
+//
+// Add the CPU time the calling thread spends in the scope of the timer
+// to the statistics of 'stage'. No-op if 'aggregator' is nullptr.
+//
+class CpuStageTimer {
+ public:
+  CpuStageTimer(InferenceStatsAggregator* aggregator, const CpuStage stage)
+      : aggregator_(aggregator), stage_(stage),
+        start_ns_((aggregator != nullptr) ? ThreadCpuNs() : 0)
+  {
+  }
+  ~CpuStageTimer()
+  {
+    if (aggregator_ != nullptr) {
+      aggregator_->UpdateCpuStage(stage_, ThreadCpuNs() - start_ns_);
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CpuStageTimer);
+
+  InferenceStatsAggregator* aggregator_;
+  const CpuStage stage_;
+  const uint64_t start_ns_;
+};
+
+#define CPU_STAGE_SCOPE(V, AGGREGATOR, STAGE) \
+  triton::core::CpuStageTimer V(AGGREGATOR, triton::core::CpuStage::STAGE)
+#else
+#define CPU_STAGE_SCOPE(V, AGGREGATOR, STAGE)
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+
 }}  // namespace triton::core
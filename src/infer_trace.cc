@@ -26,10 +26,193 @@
 
 #include "infer_trace.h"
 
+#ifdef TRITON_ENABLE_TRACING
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "triton/common/logging.h"
+#endif  // TRITON_ENABLE_TRACING
+
 namespace triton { namespace core {
 
 #ifdef TRITON_ENABLE_TRACING
 
+//
+// InferenceTraceBuffer
+//
+// The ring buffers of the buffered traces. Each recording thread owns a
+// single-producer single-consumer ring of compact activity records, and
+// a background thread drains all the rings periodically, reporting the
+// activities in batches. Recording never blocks, an activity is dropped
+// if the ring of the thread is full.
+//
+class InferenceTraceBuffer {
+ public:
+  static InferenceTraceBuffer* Get()
+  {
+    static InferenceTraceBuffer buffer;
+    return &buffer;
+  }
+
+  void Record(
+      InferenceTrace* trace, const TRITONSERVER_InferenceTraceActivity activity,
+      const uint64_t timestamp_ns)
+  {
+    thread_local std::shared_ptr<Ring> ring = RegisterRing();
+    // Count the activity before it is visible to the drainer so that
+    // the trace is not released while it is pending.
+    trace->pending_activity_cnt_++;
+    if (!ring->Push(ActivityRecord{trace, activity, timestamp_ns})) {
+      trace->pending_activity_cnt_--;
+      dropped_cnt_++;
+    }
+  }
+
+  // Release 'trace' once all its recorded activities are reported.
+  void Release(InferenceTrace* trace)
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    releases_.push_back(trace);
+  }
+
+ private:
+  static constexpr size_t kRingCapacity = 4096;
+  static constexpr uint64_t kDrainIntervalMs = 10;
+
+  struct ActivityRecord {
+    InferenceTrace* trace_;
+    TRITONSERVER_InferenceTraceActivity activity_;
+    uint64_t timestamp_ns_;
+  };
+
+  struct Ring {
+    Ring() : head_(0), tail_(0) {}
+
+    bool Push(const ActivityRecord& record)
+    {
+      const size_t head = head_.load(std::memory_order_relaxed);
+      if ((head - tail_.load(std::memory_order_acquire)) == kRingCapacity) {
+        return false;
+      }
+      records_[head % kRingCapacity] = record;
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    template <typename F>
+    void Drain(F fn)
+    {
+      size_t tail = tail_.load(std::memory_order_relaxed);
+      const size_t head = head_.load(std::memory_order_acquire);
+      for (; tail != head; ++tail) {
+        fn(records_[tail % kRingCapacity]);
+      }
+      tail_.store(tail, std::memory_order_release);
+    }
+
+    // The producer and consumer positions are kept on separate cache
+    // lines.
+    std::atomic<size_t> head_;
+    char pad_[64];
+    std::atomic<size_t> tail_;
+    ActivityRecord records_[kRingCapacity];
+  };
+
+  InferenceTraceBuffer() : exit_(false), dropped_cnt_(0)
+  {
+    drainer_ = std::thread([this] { Drainer(); });
+  }
+
+  ~InferenceTraceBuffer()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      exit_ = true;
+    }
+    cv_.notify_all();
+    drainer_.join();
+  }
+
+  std::shared_ptr<Ring> RegisterRing()
+  {
+    std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+    std::lock_guard<std::mutex> lk(mu_);
+    rings_.push_back(ring);
+    return ring;
+  }
+
+  void Drainer()
+  {
+    uint64_t reported_dropped_cnt = 0;
+    std::vector<InferenceTrace*> pending_releases;
+    bool exit = false;
+    while (!exit) {
+      std::vector<std::shared_ptr<Ring>> rings;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait_for(
+            lk, std::chrono::milliseconds(kDrainIntervalMs),
+            [this] { return exit_; });
+        exit = exit_;
+        // Take the releases before draining, the activities they wait
+        // for are already in the rings.
+        pending_releases.insert(
+            pending_releases.end(), releases_.begin(), releases_.end());
+        releases_.clear();
+        // Forget the rings of the exited threads once they are drained.
+        for (auto it = rings_.begin(); it != rings_.end();) {
+          if (it->use_count() == 1 &&
+              ((*it)->head_.load(std::memory_order_acquire) ==
+               (*it)->tail_.load(std::memory_order_relaxed))) {
+            it = rings_.erase(it);
+          } else {
+            rings.push_back(*it);
+            ++it;
+          }
+        }
+      }
+
+      for (auto& ring : rings) {
+        ring->Drain([](const ActivityRecord& record) {
+          InferenceTrace* trace = record.trace_;
+          trace->activity_fn_(
+              reinterpret_cast<TRITONSERVER_InferenceTrace*>(trace),
+              record.activity_, record.timestamp_ns_, trace->userp_);
+          trace->pending_activity_cnt_--;
+        });
+      }
+
+      for (auto it = pending_releases.begin(); it != pending_releases.end();) {
+        InferenceTrace* trace = *it;
+        if (trace->pending_activity_cnt_ == 0) {
+          trace->release_fn_(
+              reinterpret_cast<TRITONSERVER_InferenceTrace*>(trace),
+              trace->userp_);
+          it = pending_releases.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      const uint64_t dropped_cnt = dropped_cnt_;
+      if (dropped_cnt != reported_dropped_cnt) {
+        LOG_VERBOSE(1) << "dropped " << (dropped_cnt - reported_dropped_cnt)
+                       << " trace activities, trace ring buffer is full";
+        reported_dropped_cnt = dropped_cnt;
+      }
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool exit_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::vector<InferenceTrace*> releases_;
+  std::atomic<uint64_t> dropped_cnt_;
+  std::thread drainer_;
+};
+
 // Start the trace id at 1, because id 0 is reserved to indicate no
 // parent.
 std::atomic<uint64_t> InferenceTrace::next_id_(1);
@@ -38,14 +221,27 @@ InferenceTrace*
 InferenceTrace::SpawnChildTrace()
 {
   InferenceTrace* trace = new InferenceTrace(
-      level_, id_, activity_fn_, tensor_activity_fn_, release_fn_, userp_);
+      level_, id_, activity_fn_, tensor_activity_fn_, release_fn_, userp_,
+      buffered_);
   return trace;
 }
 
 void
 InferenceTrace::Release()
 {
-  release_fn_(reinterpret_cast<TRITONSERVER_InferenceTrace*>(this), userp_);
+  if (buffered_) {
+    InferenceTraceBuffer::Get()->Release(this);
+  } else {
+    release_fn_(reinterpret_cast<TRITONSERVER_InferenceTrace*>(this), userp_);
+  }
+}
+
+void
+InferenceTrace::RecordBuffered(
+    const TRITONSERVER_InferenceTraceActivity activity,
+    const uint64_t timestamp_ns)
+{
+  InferenceTraceBuffer::Get()->Record(this, activity, timestamp_ns);
 }
 
 std::shared_ptr<InferenceTraceProxy>
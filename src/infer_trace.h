@@ -36,21 +36,30 @@ namespace triton { namespace core {
 
 #ifdef TRITON_ENABLE_TRACING
 
+class InferenceTraceBuffer;
+
 //
 // InferenceTrace
 //
 // Interface to TRITONSERVER_InferenceTrace to report trace events.
 //
+// The timestamp activities of a buffered trace are recorded into a
+// per-thread ring buffer instead of being reported synchronously, and
+// are reported in batches by a background thread. The release callback
+// is called once all the recorded activities of the trace are reported.
+//
 class InferenceTrace {
  public:
   InferenceTrace(
       const TRITONSERVER_InferenceTraceLevel level, const uint64_t parent_id,
       TRITONSERVER_InferenceTraceActivityFn_t activity_fn,
       TRITONSERVER_InferenceTraceTensorActivityFn_t tensor_activity_fn,
-      TRITONSERVER_InferenceTraceReleaseFn_t release_fn, void* userp)
+      TRITONSERVER_InferenceTraceReleaseFn_t release_fn, void* userp,
+      const bool buffered = false)
       : level_(level), id_(next_id_++), parent_id_(parent_id),
         activity_fn_(activity_fn), tensor_activity_fn_(tensor_activity_fn),
-        release_fn_(release_fn), userp_(userp)
+        release_fn_(release_fn), userp_(userp), buffered_(buffered),
+        pending_activity_cnt_(0), batch_size_(0)
   {
   }
 
@@ -65,14 +74,22 @@ class InferenceTrace {
   void SetModelName(const std::string& n) { model_name_ = n; }
   void SetModelVersion(int64_t v) { model_version_ = v; }
 
+  // The size of the batch formed by the scheduler for the request.
+  uint64_t BatchSize() const { return batch_size_; }
+  void SetBatchSize(uint64_t b) { batch_size_ = b; }
+
   // Report trace activity.
   void Report(
       const TRITONSERVER_InferenceTraceActivity activity, uint64_t timestamp_ns)
   {
     if ((level_ & TRITONSERVER_TRACE_LEVEL_TIMESTAMPS) > 0) {
-      activity_fn_(
-          reinterpret_cast<TRITONSERVER_InferenceTrace*>(this), activity,
-          timestamp_ns, userp_);
+      if (buffered_) {
+        RecordBuffered(activity, timestamp_ns);
+      } else {
+        activity_fn_(
+            reinterpret_cast<TRITONSERVER_InferenceTrace*>(this), activity,
+            timestamp_ns, userp_);
+      }
     }
   }
 
@@ -106,6 +123,14 @@ class InferenceTrace {
   void Release();
 
  private:
+  friend class InferenceTraceBuffer;
+
+  // Record a timestamp activity into the ring buffer of the calling
+  // thread. The activity is dropped if the ring buffer is full.
+  void RecordBuffered(
+      const TRITONSERVER_InferenceTraceActivity activity,
+      const uint64_t timestamp_ns);
+
   const TRITONSERVER_InferenceTraceLevel level_;
   const uint64_t id_;
   const uint64_t parent_id_;
@@ -115,8 +140,13 @@ class InferenceTrace {
   TRITONSERVER_InferenceTraceReleaseFn_t release_fn_;
   void* userp_;
 
+  const bool buffered_;
+  // Number of recorded activities not reported yet.
+  std::atomic<uint64_t> pending_activity_cnt_;
+
   std::string model_name_;
   int64_t model_version_;
+  std::atomic<uint64_t> batch_size_;
 
   // Maintain next id statically so that trace id is unique even
   // across traces
@@ -140,6 +170,7 @@ class InferenceTraceProxy {
   int64_t ModelVersion() const { return trace_->ModelVersion(); }
   void SetModelName(const std::string& n) { trace_->SetModelName(n); }
   void SetModelVersion(int64_t v) { trace_->SetModelVersion(v); }
+  void SetBatchSize(uint64_t b) { trace_->SetBatchSize(b); }
 
   void Report(
       const TRITONSERVER_InferenceTraceActivity activity, uint64_t timestamp_ns)
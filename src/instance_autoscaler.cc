@@ -0,0 +1,77 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "instance_autoscaler.h"
+
+namespace triton { namespace core {
+
+InstanceAutoscaler::InstanceAutoscaler(
+    const size_t max_extra_instances, const uint64_t delay_threshold_ns,
+    const size_t depth_threshold, const uint64_t sustain_ns,
+    const uint64_t cooldown_ns)
+    : max_extra_instances_(max_extra_instances),
+      delay_threshold_ns_(delay_threshold_ns),
+      depth_threshold_(depth_threshold), sustain_ns_(sustain_ns),
+      cooldown_ns_(cooldown_ns), pressure_since_ns_(0), idle_since_ns_(0)
+{
+}
+
+InstanceAutoscaler::Decision
+InstanceAutoscaler::Update(
+    const uint64_t now_ns, const uint64_t queue_delay_ns,
+    const size_t queue_depth, const size_t extra_instances)
+{
+  const bool pressure =
+      ((delay_threshold_ns_ != 0) && (queue_delay_ns >= delay_threshold_ns_)) ||
+      ((depth_threshold_ != 0) && (queue_depth >= depth_threshold_));
+  if (pressure) {
+    idle_since_ns_ = 0;
+    if (pressure_since_ns_ == 0) {
+      pressure_since_ns_ = now_ns;
+    }
+    if (((now_ns - pressure_since_ns_) >= sustain_ns_) &&
+        (extra_instances < max_extra_instances_)) {
+      pressure_since_ns_ = now_ns;
+      return Decision::SCALE_UP;
+    }
+    return Decision::NONE;
+  }
+
+  pressure_since_ns_ = 0;
+  if (queue_depth != 0) {
+    idle_since_ns_ = 0;
+    return Decision::NONE;
+  }
+  if (idle_since_ns_ == 0) {
+    idle_since_ns_ = now_ns;
+  }
+  if (((now_ns - idle_since_ns_) >= cooldown_ns_) && (extra_instances > 0)) {
+    idle_since_ns_ = now_ns;
+    return Decision::SCALE_DOWN;
+  }
+  return Decision::NONE;
+}
+
+}}  // namespace triton::core
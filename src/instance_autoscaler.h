@@ -0,0 +1,76 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace triton { namespace core {
+
+//
+// Policy that decides when the instances of a model are scaled with the
+// pressure on its queue. An instance is added when the queue delay of the
+// oldest request or the queue depth stays at or above its threshold for
+// the sustain duration, up to the maximum extra instance count. An extra
+// instance is retired once the queue has stayed empty for the cooldown
+// duration. A threshold of 0 disables the corresponding signal.
+//
+// The autoscaler is not thread-safe.
+//
+class InstanceAutoscaler {
+ public:
+  enum class Decision { NONE, SCALE_UP, SCALE_DOWN };
+
+  InstanceAutoscaler(
+      const size_t max_extra_instances, const uint64_t delay_threshold_ns,
+      const size_t depth_threshold, const uint64_t sustain_ns,
+      const uint64_t cooldown_ns);
+
+  // Return the scaling decision given the queue delay and depth observed
+  // at 'now_ns' and the number of extra instances the model currently
+  // has. The decision is assumed to be applied, the next scale up or down
+  // requires the condition to hold for another sustain or cooldown
+  // duration.
+  Decision Update(
+      const uint64_t now_ns, const uint64_t queue_delay_ns,
+      const size_t queue_depth, const size_t extra_instances);
+
+  size_t MaxExtraInstances() const { return max_extra_instances_; }
+
+ private:
+  const size_t max_extra_instances_;
+  const uint64_t delay_threshold_ns_;
+  const size_t depth_threshold_;
+  const uint64_t sustain_ns_;
+  const uint64_t cooldown_ns_;
+
+  // The time since when the queue has been under pressure, or empty, 0
+  // if it is not.
+  uint64_t pressure_since_ns_;
+  uint64_t idle_since_ns_;
+};
+
+}}  // namespace triton::core
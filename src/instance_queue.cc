@@ -47,6 +47,12 @@ InstanceQueue::Empty()
   return payload_queue_.empty();
 }
 
+const std::shared_ptr<Payload>&
+InstanceQueue::Front()
+{
+  return payload_queue_.front();
+}
+
 void
 InstanceQueue::Enqueue(const std::shared_ptr<Payload>& payload)
 {
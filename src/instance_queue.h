@@ -40,6 +40,8 @@ class InstanceQueue {
 
   size_t Size();
   bool Empty();
+  // The next payload to be dequeued, the queue must not be empty.
+  const std::shared_ptr<Payload>& Front();
   void Enqueue(const std::shared_ptr<Payload>& payload);
   void Dequeue(
       std::shared_ptr<Payload>* payload,
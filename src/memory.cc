@@ -103,6 +103,14 @@ MemoryReference::AddBufferFront(
   return buffer_.size() - 1;
 }
 
+void
+MemoryReference::Clear()
+{
+  total_byte_size_ = 0;
+  buffer_count_ = 0;
+  buffer_.clear();
+}
+
 //
 // MutableMemory
 //
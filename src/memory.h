@@ -96,6 +96,9 @@ class MemoryReference : public Memory {
       const char* buffer, size_t byte_size, TRITONSERVER_MemoryType memory_type,
       int64_t memory_type_id);
 
+  // Remove all the buffers, keeping the capacity of the buffer list.
+  void Clear();
+
  private:
   struct Block {
     Block(
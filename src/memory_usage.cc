@@ -0,0 +1,104 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "memory_usage.h"
+
+#ifdef TRITON_ENABLE_METRICS
+#include "metric_model_reporter.h"
+#endif  // TRITON_ENABLE_METRICS
+
+namespace triton { namespace core {
+
+void
+MemoryUsageTracker::SetMetricReporter(
+    const std::shared_ptr<MetricModelReporter>& reporter)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  reporter_ = reporter;
+}
+
+void
+MemoryUsageTracker::RecordAllocation(
+    void* buffer, const TRITONSERVER_MemoryType memory_type,
+    const size_t byte_size)
+{
+  if ((buffer == nullptr) || (memory_type >= kMemoryTypeCount)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(mu_);
+  allocations_[buffer] = Allocation{memory_type, byte_size};
+  auto& stats = stats_[memory_type];
+  stats.byte_size_ += byte_size;
+  if (stats.byte_size_ > stats.peak_byte_size_) {
+    stats.peak_byte_size_ = stats.byte_size_;
+  }
+  ++stats.allocation_count_;
+  Report(memory_type, true /* allocated */);
+}
+
+void
+MemoryUsageTracker::RecordFree(void* buffer)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  const auto itr = allocations_.find(buffer);
+  if (itr == allocations_.end()) {
+    return;
+  }
+
+  const TRITONSERVER_MemoryType memory_type = itr->second.memory_type_;
+  stats_[memory_type].byte_size_ -= itr->second.byte_size_;
+  allocations_.erase(itr);
+  Report(memory_type, false /* allocated */);
+}
+
+MemoryUsageTracker::Stats
+MemoryUsageTracker::GetStats(const TRITONSERVER_MemoryType memory_type) const
+{
+  if (memory_type >= kMemoryTypeCount) {
+    return Stats();
+  }
+
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_[memory_type];
+}
+
+void
+MemoryUsageTracker::Report(
+    const TRITONSERVER_MemoryType memory_type, const bool allocated)
+{
+#ifdef TRITON_ENABLE_METRICS
+  // Reported while holding the lock so that the gauges are updated in
+  // the same order as the usage.
+  if (reporter_ != nullptr) {
+    const auto& stats = stats_[memory_type];
+    reporter_->ReportMemoryUsage(
+        memory_type, stats.byte_size_, stats.peak_byte_size_, allocated);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+}}  // namespace triton::core
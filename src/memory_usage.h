@@ -0,0 +1,87 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+class MetricModelReporter;
+
+//
+// Accounting of the memory allocated on behalf of a model, by memory
+// type. The allocations are recorded by buffer address so that a free
+// can be accounted without the caller providing the byte size.
+//
+class MemoryUsageTracker {
+ public:
+  struct Stats {
+    Stats() : byte_size_(0), peak_byte_size_(0), allocation_count_(0) {}
+    // The byte size currently allocated.
+    uint64_t byte_size_;
+    // The largest byte size allocated at any time.
+    uint64_t peak_byte_size_;
+    // The number of allocations made.
+    uint64_t allocation_count_;
+  };
+
+  // Set the reporter to publish the usage to, if metrics are enabled.
+  void SetMetricReporter(const std::shared_ptr<MetricModelReporter>& reporter);
+
+  // Record the allocation of 'byte_size' bytes of 'memory_type' at
+  // 'buffer'.
+  void RecordAllocation(
+      void* buffer, const TRITONSERVER_MemoryType memory_type,
+      const size_t byte_size);
+
+  // Record the release of 'buffer'. A buffer that was not recorded
+  // as allocated is ignored.
+  void RecordFree(void* buffer);
+
+  // Return the usage of 'memory_type'.
+  Stats GetStats(const TRITONSERVER_MemoryType memory_type) const;
+
+ private:
+  static constexpr size_t kMemoryTypeCount = 3;
+
+  struct Allocation {
+    TRITONSERVER_MemoryType memory_type_;
+    size_t byte_size_;
+  };
+
+  void Report(const TRITONSERVER_MemoryType memory_type, const bool allocated);
+
+  mutable std::mutex mu_;
+  Stats stats_[kMemoryTypeCount];
+  std::unordered_map<void*, Allocation> allocations_;
+  std::shared_ptr<MetricModelReporter> reporter_;
+};
+
+}}  // namespace triton::core
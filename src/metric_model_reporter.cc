@@ -28,6 +28,7 @@
 
 #ifdef TRITON_ENABLE_METRICS
 
+#include <algorithm>
 #include "constants.h"
 #include "metrics.h"
 
@@ -94,6 +95,8 @@ MetricModelReporter::MetricModelReporter(
       Metrics::FamilyInferenceComputeInferDuration(), labels);
   metric_inf_compute_output_duration_us_ = CreateCounterMetric(
       Metrics::FamilyInferenceComputeOutputDuration(), labels);
+  metric_inf_queue_delay_target_us_ =
+      CreateGaugeMetric(Metrics::FamilyInferenceQueueDelayTarget(), labels);
   metric_cache_hit_count_ =
       CreateCounterMetric(Metrics::FamilyCacheHitCount(), labels);
   metric_cache_hit_lookup_duration_us_ =
@@ -104,6 +107,61 @@ MetricModelReporter::MetricModelReporter(
       CreateCounterMetric(Metrics::FamilyCacheMissLookupDuration(), labels);
   metric_cache_miss_insertion_duration_us_ =
       CreateCounterMetric(Metrics::FamilyCacheMissInsertionDuration(), labels);
+
+  const auto& latency_buckets_us = Metrics::LatencyHistogramBuckets();
+  if (!latency_buckets_us.empty()) {
+    metric_inf_request_latency_us_.reset(new LatencyHistogram(
+        Metrics::FamilyInferenceRequestLatency(), labels, latency_buckets_us));
+    metric_inf_queue_latency_us_.reset(new LatencyHistogram(
+        Metrics::FamilyInferenceQueueLatency(), labels, latency_buckets_us));
+    metric_inf_compute_latency_us_.reset(new LatencyHistogram(
+        Metrics::FamilyInferenceComputeLatency(), labels, latency_buckets_us));
+  }
+
+#ifdef TRITON_ENABLE_METRICS_GPU
+  if (device >= 0) {
+    metric_gpu_busy_fraction_.reset(
+        new DeviceBusyGauge(Metrics::FamilyModelGpuBusyFraction(), labels));
+  }
+#endif  // TRITON_ENABLE_METRICS_GPU
+
+  // The memory usage is accounted per model, so it is only published by
+  // the reporter that is not specific to a GPU.
+  const TRITONSERVER_MemoryType memory_types[kMemoryTypeCount] = {
+      TRITONSERVER_MEMORY_CPU, TRITONSERVER_MEMORY_CPU_PINNED,
+      TRITONSERVER_MEMORY_GPU};
+  for (const auto memory_type : memory_types) {
+    metric_memory_bytes_[memory_type] = nullptr;
+    metric_memory_peak_bytes_[memory_type] = nullptr;
+    metric_memory_allocation_count_[memory_type] = nullptr;
+    if (device == METRIC_REPORTER_ID_CPU) {
+      std::map<std::string, std::string> memory_labels(labels);
+      memory_labels.emplace(
+          kMetricsLabelMemoryType, TRITONSERVER_MemoryTypeString(memory_type));
+      metric_memory_bytes_[memory_type] =
+          CreateGaugeMetric(Metrics::FamilyModelMemoryBytes(), memory_labels);
+      metric_memory_peak_bytes_[memory_type] = CreateGaugeMetric(
+          Metrics::FamilyModelMemoryPeakBytes(), memory_labels);
+      metric_memory_allocation_count_[memory_type] = CreateCounterMetric(
+          Metrics::FamilyModelMemoryAllocationCount(), memory_labels);
+    }
+  }
+
+  metric_sequence_active_ = nullptr;
+  metric_sequence_backlog_ = nullptr;
+  metric_sequence_slot_count_ = nullptr;
+  metric_sequence_slot_wait_us_ = nullptr;
+  metric_sequence_evicted_count_ = nullptr;
+  metric_sequence_rejected_count_ = nullptr;
+  metric_batcher_batch_count_ = nullptr;
+  metric_batcher_batch_fill_ = nullptr;
+  metric_batcher_rejected_count_ = nullptr;
+  metric_cache_bytes_ = nullptr;
+  metric_cache_rejected_count_ = nullptr;
+  if ((device == METRIC_REPORTER_ID_CPU) ||
+      (device == METRIC_REPORTER_ID_RESPONSE_CACHE)) {
+    model_labels_ = labels;
+  }
 }
 
 MetricModelReporter::~MetricModelReporter()
@@ -121,12 +179,365 @@ MetricModelReporter::~MetricModelReporter()
       metric_inf_compute_infer_duration_us_);
   Metrics::FamilyInferenceComputeOutputDuration().Remove(
       metric_inf_compute_output_duration_us_);
+  Metrics::FamilyInferenceQueueDelayTarget().Remove(
+      metric_inf_queue_delay_target_us_);
   Metrics::FamilyCacheHitCount().Remove(metric_cache_hit_count_);
   Metrics::FamilyCacheHitLookupDuration().Remove(
       metric_cache_hit_lookup_duration_us_);
   Metrics::FamilyCacheMissCount().Remove(metric_cache_miss_count_);
   Metrics::FamilyCacheMissInsertionDuration().Remove(
       metric_cache_miss_insertion_duration_us_);
+  if (metric_cache_bytes_ != nullptr) {
+    Metrics::FamilyCacheModelBytes().Remove(metric_cache_bytes_);
+    Metrics::FamilyCacheRejectedCount().Remove(metric_cache_rejected_count_);
+  }
+  for (size_t idx = 0; idx < kMemoryTypeCount; ++idx) {
+    if (metric_memory_bytes_[idx] != nullptr) {
+      Metrics::FamilyModelMemoryBytes().Remove(metric_memory_bytes_[idx]);
+      Metrics::FamilyModelMemoryPeakBytes().Remove(
+          metric_memory_peak_bytes_[idx]);
+      Metrics::FamilyModelMemoryAllocationCount().Remove(
+          metric_memory_allocation_count_[idx]);
+    }
+  }
+  if (metric_sequence_active_ != nullptr) {
+    Metrics::FamilySequenceActive().Remove(metric_sequence_active_);
+    Metrics::FamilySequenceBacklog().Remove(metric_sequence_backlog_);
+    Metrics::FamilySequenceSlotCount().Remove(metric_sequence_slot_count_);
+    Metrics::FamilySequenceSlotWait().Remove(metric_sequence_slot_wait_us_);
+    Metrics::FamilySequenceEvictedCount().Remove(
+        metric_sequence_evicted_count_);
+    Metrics::FamilySequenceRejectedCount().Remove(
+        metric_sequence_rejected_count_);
+  }
+  for (auto metric : metric_sequence_slots_occupied_) {
+    Metrics::FamilySequenceSlotsOccupied().Remove(metric);
+  }
+  if (metric_batcher_batch_count_ != nullptr) {
+    Metrics::FamilyBatcherBatchCount().Remove(metric_batcher_batch_count_);
+    Metrics::FamilyBatcherBatchFill().Remove(metric_batcher_batch_fill_);
+    Metrics::FamilyBatcherRejectedCount().Remove(
+        metric_batcher_rejected_count_);
+  }
+  for (auto metric : metric_batcher_queue_size_) {
+    Metrics::FamilyBatcherQueueSize().Remove(metric);
+  }
+  for (const auto& pr : metric_ensemble_steps_) {
+    RemoveEnsembleStepMetrics(pr.second);
+  }
+}
+
+void
+MetricModelReporter::ReportRequestLatency(
+    const uint64_t request_duration_ns, const uint64_t queue_duration_ns)
+{
+  if (metric_inf_request_latency_us_ == nullptr) {
+    return;
+  }
+
+  metric_inf_request_latency_us_->Observe(request_duration_ns / 1000);
+  metric_inf_queue_latency_us_->Observe(queue_duration_ns / 1000);
+}
+
+void
+MetricModelReporter::ReportComputeLatency(const uint64_t compute_duration_ns)
+{
+  if (metric_inf_compute_latency_us_ == nullptr) {
+    return;
+  }
+
+  metric_inf_compute_latency_us_->Observe(compute_duration_ns / 1000);
+}
+
+void
+MetricModelReporter::ReportDeviceBusy(const uint64_t compute_duration_ns)
+{
+#ifdef TRITON_ENABLE_METRICS_GPU
+  if (metric_gpu_busy_fraction_ != nullptr) {
+    metric_gpu_busy_fraction_->AddBusy(compute_duration_ns);
+  }
+#endif  // TRITON_ENABLE_METRICS_GPU
+}
+
+void
+MetricModelReporter::ReportMemoryUsage(
+    const TRITONSERVER_MemoryType memory_type, const uint64_t byte_size,
+    const uint64_t peak_byte_size, const bool allocated)
+{
+  if ((memory_type >= kMemoryTypeCount) ||
+      (metric_memory_bytes_[memory_type] == nullptr)) {
+    return;
+  }
+
+  metric_memory_bytes_[memory_type]->Set(byte_size);
+  metric_memory_peak_bytes_[memory_type]->Set(peak_byte_size);
+  if (allocated) {
+    metric_memory_allocation_count_[memory_type]->Increment();
+  }
+}
+
+void
+MetricModelReporter::CreateSequenceSlotMetrics(const size_t batcher_cnt)
+{
+  if (model_labels_.empty() || (metric_sequence_active_ != nullptr)) {
+    return;
+  }
+
+  metric_sequence_active_ =
+      CreateGaugeMetric(Metrics::FamilySequenceActive(), model_labels_);
+  metric_sequence_backlog_ =
+      CreateGaugeMetric(Metrics::FamilySequenceBacklog(), model_labels_);
+  metric_sequence_slot_count_ =
+      CreateCounterMetric(Metrics::FamilySequenceSlotCount(), model_labels_);
+  metric_sequence_slot_wait_us_ =
+      CreateCounterMetric(Metrics::FamilySequenceSlotWait(), model_labels_);
+  metric_sequence_evicted_count_ = CreateCounterMetric(
+      Metrics::FamilySequenceEvictedCount(), model_labels_);
+  metric_sequence_rejected_count_ = CreateCounterMetric(
+      Metrics::FamilySequenceRejectedCount(), model_labels_);
+  for (size_t b = 0; b < batcher_cnt; ++b) {
+    std::map<std::string, std::string> batcher_labels(model_labels_);
+    batcher_labels.emplace(kMetricsLabelSequenceBatcher, std::to_string(b));
+    metric_sequence_slots_occupied_.push_back(CreateGaugeMetric(
+        Metrics::FamilySequenceSlotsOccupied(), batcher_labels));
+  }
+}
+
+void
+MetricModelReporter::ReportSequenceSlotAssigned(
+    const size_t batcher_idx, const uint64_t wait_ns)
+{
+  if (metric_sequence_active_ == nullptr) {
+    return;
+  }
+
+  metric_sequence_active_->Increment();
+  metric_sequence_slot_count_->Increment();
+  metric_sequence_slot_wait_us_->Increment(wait_ns / 1000);
+  if (batcher_idx < metric_sequence_slots_occupied_.size()) {
+    metric_sequence_slots_occupied_[batcher_idx]->Increment();
+  }
+}
+
+void
+MetricModelReporter::ReportSequenceSlotReleased(const size_t batcher_idx)
+{
+  if (metric_sequence_active_ == nullptr) {
+    return;
+  }
+
+  metric_sequence_active_->Decrement();
+  if (batcher_idx < metric_sequence_slots_occupied_.size()) {
+    metric_sequence_slots_occupied_[batcher_idx]->Decrement();
+  }
+}
+
+void
+MetricModelReporter::ReportSequenceBacklog(const bool added)
+{
+  if (metric_sequence_backlog_ == nullptr) {
+    return;
+  }
+
+  if (added) {
+    metric_sequence_backlog_->Increment();
+  } else {
+    metric_sequence_backlog_->Decrement();
+  }
+}
+
+void
+MetricModelReporter::ReportSequenceEvicted()
+{
+  if (metric_sequence_evicted_count_ != nullptr) {
+    metric_sequence_evicted_count_->Increment();
+  }
+}
+
+void
+MetricModelReporter::ReportSequenceRejected()
+{
+  if (metric_sequence_rejected_count_ != nullptr) {
+    metric_sequence_rejected_count_->Increment();
+  }
+}
+
+void
+MetricModelReporter::CreateCacheUsageMetrics()
+{
+  if (model_labels_.empty() || (metric_cache_bytes_ != nullptr)) {
+    return;
+  }
+
+  metric_cache_bytes_ =
+      CreateGaugeMetric(Metrics::FamilyCacheModelBytes(), model_labels_);
+  metric_cache_rejected_count_ =
+      CreateCounterMetric(Metrics::FamilyCacheRejectedCount(), model_labels_);
+}
+
+void
+MetricModelReporter::ReportCacheUsage(
+    const uint64_t byte_size, const bool rejected)
+{
+  if (metric_cache_bytes_ == nullptr) {
+    return;
+  }
+
+  metric_cache_bytes_->Set(byte_size);
+  if (rejected) {
+    metric_cache_rejected_count_->Increment();
+  }
+}
+
+void
+MetricModelReporter::CreateBatcherMetrics(
+    const std::vector<uint32_t>& priority_levels)
+{
+  if (model_labels_.empty() || (metric_batcher_batch_count_ != nullptr)) {
+    return;
+  }
+
+  metric_batcher_batch_count_ =
+      CreateCounterMetric(Metrics::FamilyBatcherBatchCount(), model_labels_);
+  metric_batcher_batch_fill_ =
+      CreateCounterMetric(Metrics::FamilyBatcherBatchFill(), model_labels_);
+  metric_batcher_rejected_count_ = CreateCounterMetric(
+      Metrics::FamilyBatcherRejectedCount(), model_labels_);
+  for (const auto level : priority_levels) {
+    std::map<std::string, std::string> level_labels(model_labels_);
+    level_labels.emplace(kMetricsLabelPriorityLevel, std::to_string(level));
+    metric_batcher_queue_size_.push_back(
+        CreateGaugeMetric(Metrics::FamilyBatcherQueueSize(), level_labels));
+  }
+}
+
+void
+MetricModelReporter::ReportBatcherQueueSizeChange(
+    const size_t level_idx, const double delta)
+{
+  if (level_idx < metric_batcher_queue_size_.size()) {
+    metric_batcher_queue_size_[level_idx]->Increment(delta);
+  }
+}
+
+void
+MetricModelReporter::ReportBatcherBatch(
+    const size_t batch_size, const size_t max_batch_size)
+{
+  if ((metric_batcher_batch_count_ == nullptr) || (max_batch_size == 0)) {
+    return;
+  }
+
+  metric_batcher_batch_count_->Increment();
+  metric_batcher_batch_fill_->Increment(
+      static_cast<double>(batch_size) / max_batch_size);
+}
+
+void
+MetricModelReporter::ReportBatcherRejected(const size_t count)
+{
+  if (metric_batcher_rejected_count_ == nullptr) {
+    return;
+  }
+
+  metric_batcher_rejected_count_->Increment(count);
+}
+
+void
+MetricModelReporter::AcquireEnsembleStepMetrics(
+    const std::vector<std::string>& step_models,
+    std::vector<EnsembleStepMetrics*>* steps)
+{
+  steps->clear();
+  if (model_labels_.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(ensemble_steps_mu_);
+  for (size_t idx = 0; idx < step_models.size(); ++idx) {
+    const auto key = std::make_pair(idx, step_models[idx]);
+    auto it = metric_ensemble_steps_.find(key);
+    if (it != metric_ensemble_steps_.end()) {
+      it->second.users_++;
+      steps->push_back(&it->second);
+      continue;
+    }
+    std::map<std::string, std::string> step_labels(model_labels_);
+    step_labels.emplace(kMetricsLabelEnsembleStep, std::to_string(idx));
+    step_labels.emplace(kMetricsLabelEnsembleStepModel, step_models[idx]);
+    EnsembleStepMetrics step;
+    step.count_ =
+        CreateCounterMetric(Metrics::FamilyEnsembleStepCount(), step_labels);
+    step.dispatch_us_ =
+        CreateCounterMetric(Metrics::FamilyEnsembleStepDispatch(), step_labels);
+    step.model_us_ =
+        CreateCounterMetric(Metrics::FamilyEnsembleStepModel(), step_labels);
+    step.update_us_ =
+        CreateCounterMetric(Metrics::FamilyEnsembleStepUpdate(), step_labels);
+    step.critical_path_count_ = CreateCounterMetric(
+        Metrics::FamilyEnsembleStepCriticalPathCount(), step_labels);
+    step.critical_path_us_ = CreateCounterMetric(
+        Metrics::FamilyEnsembleStepCriticalPath(), step_labels);
+    step.users_ = 1;
+    it = metric_ensemble_steps_.emplace(key, step).first;
+    steps->push_back(&it->second);
+  }
+}
+
+void
+MetricModelReporter::ReleaseEnsembleStepMetrics(
+    const std::vector<EnsembleStepMetrics*>& steps)
+{
+  std::lock_guard<std::mutex> lk(ensemble_steps_mu_);
+  for (auto it = metric_ensemble_steps_.begin();
+       it != metric_ensemble_steps_.end();) {
+    if (std::find(steps.begin(), steps.end(), &it->second) != steps.end() &&
+        (--it->second.users_ == 0)) {
+      RemoveEnsembleStepMetrics(it->second);
+      it = metric_ensemble_steps_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void
+MetricModelReporter::RemoveEnsembleStepMetrics(const EnsembleStepMetrics& step)
+{
+  Metrics::FamilyEnsembleStepCount().Remove(step.count_);
+  Metrics::FamilyEnsembleStepDispatch().Remove(step.dispatch_us_);
+  Metrics::FamilyEnsembleStepModel().Remove(step.model_us_);
+  Metrics::FamilyEnsembleStepUpdate().Remove(step.update_us_);
+  Metrics::FamilyEnsembleStepCriticalPathCount().Remove(
+      step.critical_path_count_);
+  Metrics::FamilyEnsembleStepCriticalPath().Remove(step.critical_path_us_);
+}
+
+void
+MetricModelReporter::ReportEnsembleStep(
+    EnsembleStepMetrics* step, const uint64_t dispatch_ns,
+    const uint64_t model_ns, const uint64_t update_ns)
+{
+  if (step == nullptr) {
+    return;
+  }
+
+  step->count_->Increment();
+  step->dispatch_us_->Increment(dispatch_ns / 1000);
+  step->model_us_->Increment(model_ns / 1000);
+  step->update_us_->Increment(update_ns / 1000);
+}
+
+void
+MetricModelReporter::ReportEnsembleCriticalPath(
+    EnsembleStepMetrics* step, const uint64_t duration_ns)
+{
+  if (step == nullptr) {
+    return;
+  }
+
+  step->critical_path_count_->Increment();
+  step->critical_path_us_->Increment(duration_ns / 1000);
 }
 
 void
@@ -163,6 +574,14 @@ MetricModelReporter::CreateCounterMetric(
   return &family.Add(labels);
 }
 
+prometheus::Gauge*
+MetricModelReporter::CreateGaugeMetric(
+    prometheus::Family<prometheus::Gauge>& family,
+    const std::map<std::string, std::string>& labels)
+{
+  return &family.Add(labels);
+}
+
 }}  // namespace triton::core
 
 #endif  // TRITON_ENABLE_METRICS
@@ -25,8 +25,15 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 #include "status.h"
 #include "triton/common/model_config.h"
+#include "tritonserver_apis.h"
 
 #ifdef TRITON_ENABLE_METRICS
 #include "prometheus/registry.h"
@@ -34,6 +41,9 @@
 
 namespace triton { namespace core {
 
+class LatencyHistogram;
+class DeviceBusyGauge;
+
 //
 // Interface for a metric reporter for a given version of a model.
 //
@@ -84,6 +94,10 @@ class MetricModelReporter {
   {
     return *metric_inf_compute_output_duration_us_;
   }
+  prometheus::Gauge& MetricInferenceQueueDelayTarget() const
+  {
+    return *metric_inf_queue_delay_target_us_;
+  }
   prometheus::Counter& MetricCacheHitCount() const
   {
     return *metric_cache_hit_count_;
@@ -105,6 +119,103 @@ class MetricModelReporter {
     return *metric_cache_miss_insertion_duration_us_;
   }
 
+  // Record the durations of a successful request in the latency
+  // histograms, a no-op if the latency histograms are not enabled.
+  void ReportRequestLatency(
+      const uint64_t request_duration_ns, const uint64_t queue_duration_ns);
+
+  // Record the duration of a model execution, input, infer and output
+  // included, in the latency histograms.
+  void ReportComputeLatency(const uint64_t compute_duration_ns);
+
+  // Attribute 'compute_duration_ns' of execution to the GPU of the
+  // reporter, a no-op if the reporter is not specific to a GPU.
+  void ReportDeviceBusy(const uint64_t compute_duration_ns);
+
+  // Publish the memory usage of the model for 'memory_type', and
+  // count an allocation if 'allocated' is true. Only the reporter
+  // without a GPU label publishes memory usage, it is a no-op for the
+  // others.
+  void ReportMemoryUsage(
+      const TRITONSERVER_MemoryType memory_type, const uint64_t byte_size,
+      const uint64_t peak_byte_size, const bool allocated);
+
+  // Create the metrics of the sequence slots of 'batcher_cnt'
+  // sequence batchers. Must be called before the sequence slots are
+  // reported. Like the memory usage, the sequence metrics are only
+  // published by the reporter without a GPU label.
+  void CreateSequenceSlotMetrics(const size_t batcher_cnt);
+
+  // Publish the sequence statistics of the model.
+  void ReportSequenceSlotAssigned(
+      const size_t batcher_idx, const uint64_t wait_ns);
+  void ReportSequenceSlotReleased(const size_t batcher_idx);
+  void ReportSequenceBacklog(const bool added);
+  void ReportSequenceEvicted();
+  void ReportSequenceRejected();
+
+  // Create the per-model response cache usage metrics. Must be called
+  // before the cache usage is reported, only published by the reporter
+  // without a GPU label.
+  void CreateCacheUsageMetrics();
+
+  // Publish that the entries of the model hold 'byte_size' bytes of the
+  // response cache, and count a response that was not admitted if
+  // 'rejected' is true.
+  void ReportCacheUsage(const uint64_t byte_size, const bool rejected);
+
+  // Create the metrics of the dynamic batcher, 'priority_levels' holds
+  // the priority levels of its queue. Must be called before the batcher
+  // is reported, only published by the reporter without a GPU label.
+  void CreateBatcherMetrics(const std::vector<uint32_t>& priority_levels);
+
+  // Publish that the number of requests queued at the priority level at
+  // 'level_idx' changed by 'delta'. The queue sizes are reported as
+  // changes so that several batcher threads can share the gauges.
+  void ReportBatcherQueueSizeChange(const size_t level_idx, const double delta);
+
+  // Publish that the dynamic batcher formed a batch of 'batch_size'.
+  void ReportBatcherBatch(const size_t batch_size, const size_t max_batch_size);
+
+  // Publish that the queue policy rejected 'count' requests.
+  void ReportBatcherRejected(const size_t count);
+
+  // The metrics of a step of an ensemble, labeled with the step index
+  // and its composing model. Shared by the loaded versions of the
+  // ensemble, e.g. while it is reloaded, that have the same model at the
+  // step.
+  struct EnsembleStepMetrics {
+    prometheus::Counter* count_;
+    prometheus::Counter* dispatch_us_;
+    prometheus::Counter* model_us_;
+    prometheus::Counter* update_us_;
+    prometheus::Counter* critical_path_count_;
+    prometheus::Counter* critical_path_us_;
+    size_t users_;
+  };
+
+  // Acquire the metrics of the steps of an ensemble, 'step_models' holds
+  // the composing model of each step. Return in 'steps' the metrics of
+  // each step, empty if the reporter has a GPU label as the step metrics
+  // are only published by the reporter without a GPU label. The metrics
+  // of the steps that no ensemble uses anymore are removed by
+  // ReleaseEnsembleStepMetrics().
+  void AcquireEnsembleStepMetrics(
+      const std::vector<std::string>& step_models,
+      std::vector<EnsembleStepMetrics*>* steps);
+  void ReleaseEnsembleStepMetrics(
+      const std::vector<EnsembleStepMetrics*>& steps);
+
+  // Publish the durations of a completed request of 'step'.
+  void ReportEnsembleStep(
+      EnsembleStepMetrics* step, const uint64_t dispatch_ns,
+      const uint64_t model_ns, const uint64_t update_ns);
+
+  // Publish that 'step' added 'duration_ns' to the critical path of an
+  // ensemble request.
+  void ReportEnsembleCriticalPath(
+      EnsembleStepMetrics* step, const uint64_t duration_ns);
+
  private:
   MetricModelReporter(
       const std::string& model_name, const int64_t model_version,
@@ -117,6 +228,9 @@ class MetricModelReporter {
   prometheus::Counter* CreateCounterMetric(
       prometheus::Family<prometheus::Counter>& family,
       const std::map<std::string, std::string>& labels);
+  prometheus::Gauge* CreateGaugeMetric(
+      prometheus::Family<prometheus::Gauge>& family,
+      const std::map<std::string, std::string>& labels);
 
   prometheus::Counter* metric_inf_success_;
   prometheus::Counter* metric_inf_failure_;
@@ -127,11 +241,60 @@ class MetricModelReporter {
   prometheus::Counter* metric_inf_compute_input_duration_us_;
   prometheus::Counter* metric_inf_compute_infer_duration_us_;
   prometheus::Counter* metric_inf_compute_output_duration_us_;
+  prometheus::Gauge* metric_inf_queue_delay_target_us_;
   prometheus::Counter* metric_cache_hit_count_;
   prometheus::Counter* metric_cache_hit_lookup_duration_us_;
   prometheus::Counter* metric_cache_miss_count_;
   prometheus::Counter* metric_cache_miss_lookup_duration_us_;
   prometheus::Counter* metric_cache_miss_insertion_duration_us_;
+  // Response cache usage metrics. Null if the reporter doesn't publish
+  // cache usage.
+  prometheus::Gauge* metric_cache_bytes_;
+  prometheus::Counter* metric_cache_rejected_count_;
+
+  // Latency histograms. Null if the latency histograms are not enabled.
+  std::unique_ptr<LatencyHistogram> metric_inf_request_latency_us_;
+  std::unique_ptr<LatencyHistogram> metric_inf_queue_latency_us_;
+  std::unique_ptr<LatencyHistogram> metric_inf_compute_latency_us_;
+
+#ifdef TRITON_ENABLE_METRICS_GPU
+  // The GPU time attributed to the model. Null if the reporter is not
+  // specific to a GPU.
+  std::unique_ptr<DeviceBusyGauge> metric_gpu_busy_fraction_;
+#endif  // TRITON_ENABLE_METRICS_GPU
+
+  // Memory usage metrics, indexed by memory type. Null if the
+  // reporter doesn't publish memory usage.
+  static constexpr size_t kMemoryTypeCount = 3;
+  prometheus::Gauge* metric_memory_bytes_[kMemoryTypeCount];
+  prometheus::Gauge* metric_memory_peak_bytes_[kMemoryTypeCount];
+  prometheus::Counter* metric_memory_allocation_count_[kMemoryTypeCount];
+
+  // Sequence metrics. Null if the reporter doesn't publish sequence
+  // metrics.
+  // The labels of the model-level metrics, empty if the reporter has a
+  // GPU label.
+  std::map<std::string, std::string> model_labels_;
+  prometheus::Gauge* metric_sequence_active_;
+  prometheus::Gauge* metric_sequence_backlog_;
+  prometheus::Counter* metric_sequence_slot_count_;
+  prometheus::Counter* metric_sequence_slot_wait_us_;
+  prometheus::Counter* metric_sequence_evicted_count_;
+  prometheus::Counter* metric_sequence_rejected_count_;
+  std::vector<prometheus::Gauge*> metric_sequence_slots_occupied_;
+
+  // Dynamic batcher metrics. Null if the reporter doesn't publish
+  // batcher metrics. The queue sizes are indexed by priority level.
+  std::vector<prometheus::Gauge*> metric_batcher_queue_size_;
+  prometheus::Counter* metric_batcher_batch_count_;
+  prometheus::Counter* metric_batcher_batch_fill_;
+  prometheus::Counter* metric_batcher_rejected_count_;
+
+  // Ensemble step metrics, keyed by step index and composing model.
+  void RemoveEnsembleStepMetrics(const EnsembleStepMetrics& step);
+  std::mutex ensemble_steps_mu_;
+  std::map<std::pair<size_t, std::string>, EnsembleStepMetrics>
+      metric_ensemble_steps_;
 #endif  // TRITON_ENABLE_METRICS
 };
 
@@ -29,8 +29,12 @@
 
 #include "metrics.h"
 
+#include <algorithm>
+#include <limits>
 #include <thread>
 #include "constants.h"
+#include "hash_utils.h"
+#include "pinned_memory_manager.h"
 #include "prometheus/detail/utils.h"
 #include "triton/common/logging.h"
 
@@ -46,6 +50,7 @@ namespace triton { namespace core {
 
 Metrics::Metrics()
     : registry_(std::make_shared<prometheus::Registry>()),
+      polled_registry_(std::make_shared<prometheus::Registry>()),
       serializer_(new prometheus::TextSerializer()),
       inf_success_family_(
           prometheus::BuildCounter()
@@ -97,45 +102,69 @@ Metrics::Metrics()
               .Help("Cumulative inference compute output duration in "
                     "microseconds (does not include cached requests)")
               .Register(*registry_)),
+      inf_queue_delay_target_us_family_(
+          prometheus::BuildGauge()
+              .Name("nv_inference_queue_delay_target_us")
+              .Help("Maximum queue delay used by the dynamic batcher to form "
+                    "a batch, in microseconds")
+              .Register(*registry_)),
+      inf_request_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_request_latency_us")
+              .Help("Distribution of the inference request durations in "
+                    "microseconds")
+              .Register(*registry_)),
+      inf_queue_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_queue_latency_us")
+              .Help("Distribution of the inference queuing durations in "
+                    "microseconds")
+              .Register(*registry_)),
+      inf_compute_latency_us_family_(
+          prometheus::BuildHistogram()
+              .Name("nv_inference_compute_latency_us")
+              .Help("Distribution of the durations of the model executions "
+                    "in microseconds, input, infer and output included")
+              .Register(*registry_)),
       cache_num_entries_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_num_entries")
               .Help("Number of responses stored in response cache")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_num_lookups_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_num_lookups")
               .Help("Number of cache lookups in response cache")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_num_hits_family_(prometheus::BuildGauge()
                                  .Name("nv_cache_num_hits")
                                  .Help("Number of cache hits in response cache")
-                                 .Register(*registry_)),
+                                 .Register(*polled_registry_)),
       cache_num_misses_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_num_misses")
               .Help("Number of cache misses in response cache")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_num_evictions_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_num_evictions")
               .Help("Number of cache evictions in response cache")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_lookup_duration_us_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_lookup_duration")
               .Help(
                   "Total cache lookup duration (hit and miss), in microseconds")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_insertion_duration_us_family_(
           prometheus::BuildGauge()
               .Name("nv_cache_insertion_duration")
               .Help("Total cache insertion duration, in microseconds")
-              .Register(*registry_)),
+              .Register(*polled_registry_)),
       cache_util_family_(prometheus::BuildGauge()
                              .Name("nv_cache_util")
                              .Help("Cache utilization [0.0 - 1.0]")
-                             .Register(*registry_)),
+                             .Register(*polled_registry_)),
       // Per-model cache metric families
       cache_num_hits_model_family_(prometheus::BuildCounter()
                                        .Name("nv_cache_num_hits_per_model")
@@ -164,37 +193,231 @@ Metrics::Metrics()
               .Help("Total cache miss insertion duration per model, in "
                     "microseconds")
               .Register(*registry_)),
+      cache_model_bytes_family_(
+          prometheus::BuildGauge()
+              .Name("nv_cache_bytes_per_model")
+              .Help("Bytes of the response cache held by the entries of "
+                    "each model")
+              .Register(*registry_)),
+      cache_rejected_count_model_family_(
+          prometheus::BuildCounter()
+              .Name("nv_cache_num_rejected_per_model")
+              .Help("Number of responses not admitted to the response cache "
+                    "by the model policy, per model")
+              .Register(*registry_)),
+      model_memory_bytes_family_(
+          prometheus::BuildGauge()
+              .Name("nv_model_memory_bytes")
+              .Help("Memory currently allocated by the backend on behalf of "
+                    "the model, in bytes")
+              .Register(*registry_)),
+      model_memory_peak_bytes_family_(
+          prometheus::BuildGauge()
+              .Name("nv_model_memory_peak_bytes")
+              .Help("Peak memory allocated by the backend on behalf of the "
+                    "model, in bytes")
+              .Register(*registry_)),
+      model_memory_allocation_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_memory_allocation_count")
+              .Help("Number of memory allocations made by the backend on "
+                    "behalf of the model")
+              .Register(*registry_)),
+      sequence_active_family_(prometheus::BuildGauge()
+                                  .Name("nv_sequence_active")
+                                  .Help("Number of sequences holding a "
+                                        "sequence slot, per model")
+                                  .Register(*registry_)),
+      sequence_backlog_family_(prometheus::BuildGauge()
+                                   .Name("nv_sequence_backlog")
+                                   .Help("Number of sequences waiting in the "
+                                         "backlog for a sequence slot, per "
+                                         "model")
+                                   .Register(*registry_)),
+      sequence_slot_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_sequence_slot_count")
+              .Help("Number of sequences assigned a sequence slot, per model")
+              .Register(*registry_)),
+      sequence_slot_wait_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_sequence_slot_wait_us")
+              .Help("Cumulative time sequences waited for a sequence slot "
+                    "after their first request, in microseconds")
+              .Register(*registry_)),
+      sequence_evicted_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_sequence_evicted_count")
+              .Help("Number of idle sequences force-ended by the sequence "
+                    "batcher, per model")
+              .Register(*registry_)),
+      sequence_rejected_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_sequence_rejected_count")
+              .Help("Number of new sequences rejected because the sequence "
+                    "backlog was full, per model")
+              .Register(*registry_)),
+      sequence_slots_occupied_family_(
+          prometheus::BuildGauge()
+              .Name("nv_sequence_slots_occupied")
+              .Help("Number of occupied sequence slots, per sequence batcher "
+                    "of the model")
+              .Register(*registry_)),
+      batcher_queue_size_family_(
+          prometheus::BuildGauge()
+              .Name("nv_batcher_queue_size")
+              .Help("Number of requests waiting in the dynamic batcher queue, "
+                    "per priority level of the model")
+              .Register(*registry_)),
+      batcher_batch_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_batcher_batch_count")
+              .Help("Number of batches formed by the dynamic batcher, per "
+                    "model")
+              .Register(*registry_)),
+      batcher_batch_fill_family_(
+          prometheus::BuildCounter()
+              .Name("nv_batcher_batch_fill")
+              .Help("Cumulative ratio of the size of the batches formed by "
+                    "the dynamic batcher to the maximum batch size, divide by "
+                    "nv_batcher_batch_count for the average fill ratio")
+              .Register(*registry_)),
+      batcher_rejected_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_batcher_rejected_count")
+              .Help("Number of requests rejected by the queue policy of the "
+                    "dynamic batcher, per model")
+              .Register(*registry_)),
+      ensemble_step_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_count")
+              .Help("Number of requests completed by each step of the "
+                    "ensemble")
+              .Register(*registry_)),
+      ensemble_step_dispatch_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_dispatch_us")
+              .Help("Cumulative time from a step becoming ready to its "
+                    "request being enqueued, in microseconds")
+              .Register(*registry_)),
+      ensemble_step_model_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_model_us")
+              .Help("Cumulative time from a step request being enqueued to "
+                    "its final response, in microseconds")
+              .Register(*registry_)),
+      ensemble_step_update_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_update_us")
+              .Help("Cumulative time spent updating the ensemble state from "
+                    "the responses of a step, in microseconds")
+              .Register(*registry_)),
+      ensemble_step_critical_path_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_critical_path_count")
+              .Help("Number of ensemble requests whose critical path goes "
+                    "through the step")
+              .Register(*registry_)),
+      ensemble_step_critical_path_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_ensemble_step_critical_path_us")
+              .Help("Cumulative time the step adds to the critical path of "
+                    "the ensemble requests, in microseconds")
+              .Register(*registry_)),
+      model_download_bytes_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_download_bytes")
+              .Help("Number of bytes of the model directories downloaded "
+                    "from cloud storage")
+              .Register(*registry_)),
+      model_download_duration_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_download_duration_us")
+              .Help("Cumulative time spent downloading the model directories "
+                    "from cloud storage, in microseconds")
+              .Register(*registry_)),
+      model_download_retries_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_download_retries")
+              .Help("Number of ranged reads retried while downloading the "
+                    "model directories from cloud storage")
+              .Register(*registry_)),
+      model_download_cached_bytes_family_(
+          prometheus::BuildCounter()
+              .Name("nv_model_download_cached_bytes")
+              .Help("Number of bytes of the model directories reused from "
+                    "the local model cache instead of being downloaded")
+              .Register(*registry_)),
+      pinned_slab_hits_family_(
+          prometheus::BuildGauge()
+              .Name("nv_pinned_memory_slab_hits")
+              .Help("Number of pinned memory allocations served by the "
+                    "per-thread slab caches")
+              .Register(*polled_registry_)),
+      pinned_slab_misses_family_(
+          prometheus::BuildGauge()
+              .Name("nv_pinned_memory_slab_misses")
+              .Help("Number of pinned memory slab allocations that missed "
+                    "the per-thread slab caches")
+              .Register(*polled_registry_)),
+      pinned_slab_fragmentation_family_(
+          prometheus::BuildGauge()
+              .Name("nv_pinned_memory_slab_fragmentation")
+              .Help("Fraction of the reserved pinned memory slabs that is not "
+                    "in use [0.0 - 1.0]")
+              .Register(*polled_registry_)),
+      pinned_pool_bytes_family_(
+          prometheus::BuildGauge()
+              .Name("nv_pinned_memory_pool_bytes")
+              .Help("Pinned memory pool size including the extents registered "
+                    "on demand, in bytes")
+              .Register(*polled_registry_)),
+      pinned_fallback_family_(
+          prometheus::BuildGauge()
+              .Name("nv_pinned_memory_fallback_allocations")
+              .Help("Number of pinned memory allocations that fell back to "
+                    "non-pinned system memory")
+              .Register(*polled_registry_)),
 
 #ifdef TRITON_ENABLE_METRICS_GPU
       gpu_utilization_family_(prometheus::BuildGauge()
                                   .Name("nv_gpu_utilization")
                                   .Help("GPU utilization rate [0.0 - 1.0)")
-                                  .Register(*registry_)),
+                                  .Register(*polled_registry_)),
       gpu_memory_total_family_(prometheus::BuildGauge()
                                    .Name("nv_gpu_memory_total_bytes")
                                    .Help("GPU total memory, in bytes")
-                                   .Register(*registry_)),
+                                   .Register(*polled_registry_)),
       gpu_memory_used_family_(prometheus::BuildGauge()
                                   .Name("nv_gpu_memory_used_bytes")
                                   .Help("GPU used memory, in bytes")
-                                  .Register(*registry_)),
+                                  .Register(*polled_registry_)),
       gpu_power_usage_family_(prometheus::BuildGauge()
                                   .Name("nv_gpu_power_usage")
                                   .Help("GPU power usage in watts")
-                                  .Register(*registry_)),
+                                  .Register(*polled_registry_)),
       gpu_power_limit_family_(prometheus::BuildGauge()
                                   .Name("nv_gpu_power_limit")
                                   .Help("GPU power management limit in watts")
-                                  .Register(*registry_)),
+                                  .Register(*polled_registry_)),
       gpu_energy_consumption_family_(
           prometheus::BuildCounter()
               .Name("nv_energy_consumption")
               .Help("GPU energy consumption in joules since the Triton Server "
                     "started")
+              .Register(*polled_registry_)),
+      model_gpu_busy_fraction_family_(
+          prometheus::BuildGauge()
+              .Name("nv_gpu_model_busy_fraction")
+              .Help("Fraction of the last metrics interval the GPU spent "
+                    "executing the model, per model instance device")
               .Register(*registry_)),
+      device_busy_poll_ns_(0),
 #endif  // TRITON_ENABLE_METRICS_GPU
       metrics_enabled_(false), gpu_metrics_enabled_(false),
-      cache_metrics_enabled_(false), metrics_interval_ms_(2000)
+      cache_metrics_enabled_(false), pinned_memory_metrics_enabled_(false),
+      metrics_interval_ms_(2000), poll_generation_(0),
+      collected_poll_generation_(std::numeric_limits<uint64_t>::max())
 {
 }
 
@@ -266,11 +489,37 @@ Metrics::EnableCacheMetrics(
 
   // Setup metric families for cache metrics
   singleton->InitializeCacheMetrics(response_cache);
+  singleton->poll_generation_++;
 
   // Toggle flag so this function is only executed once
   singleton->cache_metrics_enabled_ = true;
 }
 
+void
+Metrics::EnablePinnedMemoryMetrics()
+{
+  auto singleton = GetSingleton();
+  std::lock_guard<std::mutex> lock(singleton->pinned_memory_metrics_enabling_);
+  if (singleton->pinned_memory_metrics_enabled_) {
+    return;
+  }
+
+  const std::map<std::string, std::string> pinned_labels;
+  singleton->pinned_slab_hits_ =
+      &singleton->pinned_slab_hits_family_.Add(pinned_labels);
+  singleton->pinned_slab_misses_ =
+      &singleton->pinned_slab_misses_family_.Add(pinned_labels);
+  singleton->pinned_slab_fragmentation_ =
+      &singleton->pinned_slab_fragmentation_family_.Add(pinned_labels);
+  singleton->pinned_pool_bytes_ =
+      &singleton->pinned_pool_bytes_family_.Add(pinned_labels);
+  singleton->pinned_fallback_ =
+      &singleton->pinned_fallback_family_.Add(pinned_labels);
+  singleton->poll_generation_++;
+
+  singleton->pinned_memory_metrics_enabled_ = true;
+}
+
 void
 Metrics::EnableGPUMetrics()
 {
@@ -284,6 +533,7 @@ Metrics::EnableGPUMetrics()
 
   if (std::getenv("TRITON_SERVER_CPU_ONLY") == nullptr) {
     singleton->InitializeDcgmMetrics();
+    singleton->poll_generation_++;
   }
 
   singleton->gpu_metrics_enabled_ = true;
@@ -296,6 +546,34 @@ Metrics::SetMetricsInterval(uint64_t metrics_interval_ms)
   singleton->metrics_interval_ms_ = metrics_interval_ms;
 }
 
+void
+Metrics::EnableLatencyHistograms(const std::vector<double>& buckets_us)
+{
+  auto singleton = GetSingleton();
+  if (buckets_us.empty()) {
+    singleton->latency_buckets_us_ = {100,    250,    500,    1000,
+                                      2500,   5000,   10000,  25000,
+                                      50000,  100000, 250000, 500000,
+                                      1000000};
+  } else {
+    singleton->latency_buckets_us_ = buckets_us;
+    std::sort(
+        singleton->latency_buckets_us_.begin(),
+        singleton->latency_buckets_us_.end());
+    singleton->latency_buckets_us_.erase(
+        std::unique(
+            singleton->latency_buckets_us_.begin(),
+            singleton->latency_buckets_us_.end()),
+        singleton->latency_buckets_us_.end());
+  }
+}
+
+const std::vector<double>&
+Metrics::LatencyHistogramBuckets()
+{
+  return GetSingleton()->latency_buckets_us_;
+}
+
 void
 Metrics::StartPollingThreadSingleton(
     std::shared_ptr<RequestResponseCache> response_cache)
@@ -320,9 +598,10 @@ Metrics::StartPollingThread(
     std::shared_ptr<RequestResponseCache> response_cache)
 {
   // Nothing to poll if no polling metrics enabled, don't spawn a thread
-  if (!cache_metrics_enabled_ && !gpu_metrics_enabled_) {
-    LOG_WARNING << "Neither cache metrics nor gpu metrics are enabled. Not "
-                   "polling for them.";
+  if (!cache_metrics_enabled_ && !gpu_metrics_enabled_ &&
+      !pinned_memory_metrics_enabled_) {
+    LOG_WARNING << "Neither cache metrics, gpu metrics nor pinned memory "
+                   "metrics are enabled. Not polling for them.";
     return false;
   }
   poll_thread_exit_.store(false);
@@ -340,19 +619,51 @@ Metrics::StartPollingThread(
         PollCacheMetrics(response_cache);
       }
 
+      // Poll pinned memory pool metrics
+      if (pinned_memory_metrics_enabled_) {
+        PollPinnedMemoryMetrics();
+      }
+
 #ifdef TRITON_ENABLE_METRICS_GPU
       // Poll DCGM GPU metrics
       if (gpu_metrics_enabled_ &&
           dcgm_metadata_.available_cuda_gpu_ids_.size() > 0) {
         PollDcgmMetrics();
       }
+
+      // Attribute the GPU time to the models
+      if (gpu_metrics_enabled_) {
+        PollDeviceBusyMetrics();
+      }
 #endif  // TRITON_ENABLE_METRICS_GPU
+
+      // Let the next serialization collect the polled families again
+      poll_generation_++;
     }
   }));
 
   return true;
 }
 
+#ifdef TRITON_ENABLE_METRICS_GPU
+void
+Metrics::PollDeviceBusyMetrics()
+{
+  const uint64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  const uint64_t interval_ns =
+      (device_busy_poll_ns_ == 0) ? 0 : (now_ns - device_busy_poll_ns_);
+  device_busy_poll_ns_ = now_ns;
+
+  std::lock_guard<std::mutex> lk(device_busy_gauges_mu_);
+  for (auto gauge : device_busy_gauges_) {
+    gauge->Update(interval_ns);
+  }
+}
+#endif  // TRITON_ENABLE_METRICS_GPU
+
 bool
 Metrics::PollCacheMetrics(std::shared_ptr<RequestResponseCache> response_cache)
 {
@@ -376,6 +687,30 @@ Metrics::PollCacheMetrics(std::shared_ptr<RequestResponseCache> response_cache)
   return true;
 }
 
+bool
+Metrics::PollPinnedMemoryMetrics()
+{
+  PinnedMemoryManager::SlabStats stats;
+  PinnedMemoryManager::GetSlabStats(&stats);
+  pinned_slab_hits_->Set(stats.hit_count_);
+  pinned_slab_misses_->Set(stats.miss_count_);
+  // The counters are read without synchronization so the in-use size may
+  // momentarily exceed the reserved size.
+  double fragmentation = 0;
+  if (stats.reserved_byte_size_ > stats.in_use_byte_size_) {
+    fragmentation = static_cast<double>(
+                        stats.reserved_byte_size_ - stats.in_use_byte_size_) /
+                    stats.reserved_byte_size_;
+  }
+  pinned_slab_fragmentation_->Set(fragmentation);
+
+  PinnedMemoryManager::PoolStats pool_stats;
+  PinnedMemoryManager::GetPoolStats(&pool_stats);
+  pinned_pool_bytes_->Set(pool_stats.byte_size_);
+  pinned_fallback_->Set(pool_stats.fallback_count_);
+  return true;
+}
+
 bool
 Metrics::PollDcgmMetrics()
 {
@@ -801,12 +1136,231 @@ Metrics::GetRegistry()
   return singleton->registry_;
 }
 
+namespace {
+
+// Return the digest of the labels and values of 'metrics'. Hashing the
+// values is much cheaper than formatting the metrics as text.
+uint64_t
+MetricsDigest(const std::vector<prometheus::ClientMetric>& metrics)
+{
+  StreamingHash64 hash;
+  hash.UpdateValue(metrics.size());
+  for (const auto& metric : metrics) {
+    hash.UpdateValue(metric.label.size());
+    for (const auto& label : metric.label) {
+      hash.Update(label.name);
+      hash.Update(label.value);
+    }
+    hash.UpdateValue(metric.counter.value);
+    hash.UpdateValue(metric.gauge.value);
+    hash.UpdateValue(metric.untyped.value);
+    hash.UpdateValue(metric.summary.sample_count);
+    hash.UpdateValue(metric.summary.sample_sum);
+    for (const auto& quantile : metric.summary.quantile) {
+      hash.UpdateValue(quantile.quantile);
+      hash.UpdateValue(quantile.value);
+    }
+    hash.UpdateValue(metric.histogram.sample_count);
+    hash.UpdateValue(metric.histogram.sample_sum);
+    for (const auto& bucket : metric.histogram.bucket) {
+      hash.UpdateValue(bucket.cumulative_count);
+      hash.UpdateValue(bucket.upper_bound);
+    }
+    hash.UpdateValue(metric.timestamp_ms);
+  }
+  return hash.Digest();
+}
+
+// Return the model 'metric' is associated with, or the empty string if
+// it is not associated with a model.
+const std::string&
+ModelLabel(const prometheus::ClientMetric& metric)
+{
+  static const std::string no_model;
+  for (const auto& label : metric.label) {
+    if (label.name == "model") {
+      return label.value;
+    }
+  }
+  return no_model;
+}
+
+}  // namespace
+
 const std::string
-Metrics::SerializedMetrics()
+Metrics::SerializedMetrics(
+    const std::set<std::string>& family_names,
+    const std::set<std::string>& model_names)
 {
   auto singleton = Metrics::GetSingleton();
-  return singleton->serializer_->Serialize(
-      singleton->registry_.get()->Collect());
+  {
+    std::lock_guard<std::mutex> lk(singleton->latency_histograms_mu_);
+    for (auto histogram : singleton->latency_histograms_) {
+      histogram->Flush();
+    }
+  }
+
+  std::vector<prometheus::MetricFamily> families =
+      singleton->registry_.get()->Collect();
+
+  std::lock_guard<std::mutex> lk(singleton->serialized_families_mu_);
+  const uint64_t poll_generation = singleton->poll_generation_.load();
+  if (poll_generation != singleton->collected_poll_generation_) {
+    singleton->polled_families_ = singleton->polled_registry_->Collect();
+    singleton->collected_poll_generation_ = poll_generation;
+  }
+  for (const auto& family : singleton->polled_families_) {
+    families.push_back(family);
+  }
+
+  std::string serialized;
+  std::vector<prometheus::MetricFamily> single(1);
+  std::unordered_map<std::string, SerializedFamily> serialized_families;
+  for (auto& family : families) {
+    const std::string name = family.name;
+    SerializedFamily entry;
+    auto it = singleton->serialized_families_.find(name);
+    if (it != singleton->serialized_families_.end()) {
+      entry = std::move(it->second);
+    } else {
+      single[0].name = family.name;
+      single[0].help = family.help;
+      single[0].type = family.type;
+      single[0].metric.clear();
+      entry.header_ = singleton->serializer_->Serialize(single);
+    }
+
+    // Group the metrics by model, in the order the models first appear.
+    std::vector<std::string> models;
+    std::unordered_map<std::string, std::vector<prometheus::ClientMetric>>
+        model_metrics;
+    for (auto& metric : family.metric) {
+      const std::string& model = ModelLabel(metric);
+      auto mit = model_metrics.find(model);
+      if (mit == model_metrics.end()) {
+        models.push_back(model);
+        mit = model_metrics
+                  .emplace(model, std::vector<prometheus::ClientMetric>())
+                  .first;
+      }
+      mit->second.push_back(std::move(metric));
+    }
+
+    const bool include_family =
+        family_names.empty() ||
+        (family_names.find(name) != family_names.end());
+    std::string text;
+    std::unordered_map<std::string, SerializedModel> serialized_models;
+    for (const auto& model : models) {
+      auto& metrics = model_metrics[model];
+      const uint64_t digest = MetricsDigest(metrics);
+      SerializedModel model_entry;
+      auto mit = entry.models_.find(model);
+      if ((mit != entry.models_.end()) && (mit->second.digest_ == digest)) {
+        model_entry = std::move(mit->second);
+      } else {
+        single[0].name = family.name;
+        single[0].help = family.help;
+        single[0].type = family.type;
+        single[0].metric = std::move(metrics);
+        model_entry.digest_ = digest;
+        model_entry.text_ = singleton->serializer_->Serialize(single);
+        if (model_entry.text_.compare(
+                0, entry.header_.size(), entry.header_) == 0) {
+          model_entry.text_.erase(0, entry.header_.size());
+        }
+      }
+      // The metrics not associated with a model are included in every
+      // model filtered request.
+      if (include_family && (model_names.empty() || model.empty() ||
+                             (model_names.find(model) != model_names.end()))) {
+        text += model_entry.text_;
+      }
+      serialized_models.emplace(model, std::move(model_entry));
+    }
+    entry.models_.swap(serialized_models);
+
+    // The families filtered by model are only included if some of their
+    // metrics are.
+    if (include_family && (model_names.empty() || !text.empty())) {
+      serialized += entry.header_;
+      serialized += text;
+    }
+    serialized_families.emplace(name, std::move(entry));
+  }
+  // Only keep the families and models that still exist.
+  singleton->serialized_families_.swap(serialized_families);
+  return serialized;
+}
+
+LatencyHistogram::LatencyHistogram(
+    prometheus::Family<prometheus::Histogram>& family,
+    const std::map<std::string, std::string>& labels,
+    const std::vector<double>& buckets_us)
+    : family_(family), histogram_(&family.Add(labels, buckets_us)),
+      buckets_us_(buckets_us),
+      stripe_size_(
+          ((buckets_us.size() + 2 + kCountersPerCacheLine - 1) /
+           kCountersPerCacheLine) *
+          kCountersPerCacheLine),
+      counters_(new std::atomic<uint64_t>[kStripeCount * stripe_size_])
+{
+  for (size_t idx = 0; idx < kStripeCount * stripe_size_; ++idx) {
+    counters_[idx].store(0, std::memory_order_relaxed);
+  }
+  auto singleton = Metrics::GetSingleton();
+  std::lock_guard<std::mutex> lk(singleton->latency_histograms_mu_);
+  singleton->latency_histograms_.insert(this);
+}
+
+LatencyHistogram::~LatencyHistogram()
+{
+  {
+    auto singleton = Metrics::GetSingleton();
+    std::lock_guard<std::mutex> lk(singleton->latency_histograms_mu_);
+    singleton->latency_histograms_.erase(this);
+  }
+  family_.Remove(histogram_);
+}
+
+void
+LatencyHistogram::Observe(const uint64_t duration_us)
+{
+  // Each thread records to the stripe it is assigned on first use.
+  static std::atomic<size_t> next_stripe(0);
+  thread_local const size_t stripe = next_stripe++ % kStripeCount;
+
+  const size_t bucket =
+      std::lower_bound(
+          buckets_us_.begin(), buckets_us_.end(),
+          static_cast<double>(duration_us)) -
+      buckets_us_.begin();
+  std::atomic<uint64_t>* counters = &counters_[stripe * stripe_size_];
+  counters[bucket].fetch_add(1, std::memory_order_relaxed);
+  counters[buckets_us_.size() + 1].fetch_add(
+      duration_us, std::memory_order_relaxed);
+}
+
+void
+LatencyHistogram::Flush()
+{
+  std::vector<double> bucket_increments(buckets_us_.size() + 1, 0);
+  uint64_t sum_us = 0;
+  bool observed = false;
+  for (size_t stripe = 0; stripe < kStripeCount; ++stripe) {
+    std::atomic<uint64_t>* counters = &counters_[stripe * stripe_size_];
+    for (size_t bucket = 0; bucket < bucket_increments.size(); ++bucket) {
+      const uint64_t count =
+          counters[bucket].exchange(0, std::memory_order_relaxed);
+      bucket_increments[bucket] += count;
+      observed |= (count != 0);
+    }
+    sum_us += counters[buckets_us_.size() + 1].exchange(
+        0, std::memory_order_relaxed);
+  }
+  if (observed) {
+    histogram_->ObserveMultiple(bucket_increments, sum_us);
+  }
 }
 
 Metrics*
@@ -816,6 +1370,39 @@ Metrics::GetSingleton()
   return &singleton;
 }
 
+#ifdef TRITON_ENABLE_METRICS_GPU
+DeviceBusyGauge::DeviceBusyGauge(
+    prometheus::Family<prometheus::Gauge>& family,
+    const std::map<std::string, std::string>& labels)
+    : family_(family), gauge_(&family.Add(labels)), busy_ns_(0),
+      last_busy_ns_(0)
+{
+  auto singleton = Metrics::GetSingleton();
+  std::lock_guard<std::mutex> lk(singleton->device_busy_gauges_mu_);
+  singleton->device_busy_gauges_.insert(this);
+}
+
+DeviceBusyGauge::~DeviceBusyGauge()
+{
+  {
+    auto singleton = Metrics::GetSingleton();
+    std::lock_guard<std::mutex> lk(singleton->device_busy_gauges_mu_);
+    singleton->device_busy_gauges_.erase(this);
+  }
+  family_.Remove(gauge_);
+}
+
+void
+DeviceBusyGauge::Update(const uint64_t interval_ns)
+{
+  const uint64_t busy_ns = busy_ns_.load(std::memory_order_relaxed);
+  if (interval_ns > 0) {
+    gauge_->Set(static_cast<double>(busy_ns - last_busy_ns_) / interval_ns);
+  }
+  last_busy_ns_ = busy_ns;
+}
+#endif  // TRITON_ENABLE_METRICS_GPU
+
 }}  // namespace triton::core
 
 #endif  // TRITON_ENABLE_METRICS
@@ -29,8 +29,15 @@
 #ifdef TRITON_ENABLE_METRICS
 
 #include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+#include "prometheus/metric_family.h"
 #include "prometheus/registry.h"
 #include "prometheus/serializer.h"
 #include "prometheus/text_serializer.h"
@@ -42,6 +49,9 @@
 
 namespace triton { namespace core {
 
+class LatencyHistogram;
+class DeviceBusyGauge;
+
 #ifdef TRITON_ENABLE_METRICS_GPU
 struct DcgmMetadata {
   // DCGM handles for initialization and destruction
@@ -89,6 +99,9 @@ class Metrics {
   static void EnableCacheMetrics(
       std::shared_ptr<RequestResponseCache> response_cache);
 
+  // Enable reporting of pinned memory pool metrics
+  static void EnablePinnedMemoryMetrics();
+
   // Start a thread for polling enabled metrics if any
   static void StartPollingThreadSingleton(
       std::shared_ptr<RequestResponseCache> response_cache);
@@ -96,11 +109,27 @@ class Metrics {
   // Set the time interval in secs at which metrics are collected
   static void SetMetricsInterval(uint64_t metrics_interval_ms);
 
+  // Enable the per-model latency histograms. 'buckets_us' holds the
+  // upper bounds of the buckets in microseconds, the default layout is
+  // used if it is empty. Must be called before the models are loaded.
+  static void EnableLatencyHistograms(const std::vector<double>& buckets_us);
+
+  // Return the bucket upper bounds of the latency histograms, empty if
+  // the latency histograms are not enabled.
+  static const std::vector<double>& LatencyHistogramBuckets();
+
   // Get the prometheus registry
   static std::shared_ptr<prometheus::Registry> GetRegistry();
 
-  // Get serialized metrics
-  static const std::string SerializedMetrics();
+  // Get serialized metrics. Only the metrics of the models that changed
+  // since the previous call are serialized again, the text of the others
+  // is reused. If 'family_names' is not empty only the families with these
+  // names are included. If 'model_names' is not empty only the metrics
+  // of these models are included, together with the metrics that are not
+  // associated with a model.
+  static const std::string SerializedMetrics(
+      const std::set<std::string>& family_names = std::set<std::string>(),
+      const std::set<std::string>& model_names = std::set<std::string>());
 
   // Get the UUID for a CUDA device. Return true and initialize 'uuid'
   // if a UUID is found, return false if a UUID cannot be returned.
@@ -165,6 +194,33 @@ class Metrics {
   {
     return GetSingleton()->inf_compute_output_duration_us_family_;
   }
+
+  // Metric family of the maximum queue delay currently used by the
+  // dynamic batcher, in microseconds
+  static prometheus::Family<prometheus::Gauge>&
+  FamilyInferenceQueueDelayTarget()
+  {
+    return GetSingleton()->inf_queue_delay_target_us_family_;
+  }
+
+  // Metric families of the distributions of the inference request, queue
+  // and compute durations, in microseconds. Only populated if the latency
+  // histograms are enabled.
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceRequestLatency()
+  {
+    return GetSingleton()->inf_request_latency_us_family_;
+  }
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceQueueLatency()
+  {
+    return GetSingleton()->inf_queue_latency_us_family_;
+  }
+  static prometheus::Family<prometheus::Histogram>&
+  FamilyInferenceComputeLatency()
+  {
+    return GetSingleton()->inf_compute_latency_us_family_;
+  }
   // Metric families of per-model response cache metrics
   static prometheus::Family<prometheus::Counter>& FamilyCacheHitCount()
   {
@@ -188,9 +244,141 @@ class Metrics {
   {
     return GetSingleton()->cache_miss_insertion_duration_us_model_family_;
   }
+  static prometheus::Family<prometheus::Gauge>& FamilyCacheModelBytes()
+  {
+    return GetSingleton()->cache_model_bytes_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyCacheRejectedCount()
+  {
+    return GetSingleton()->cache_rejected_count_model_family_;
+  }
+
+  // Metric families of the memory allocated through the backend
+  // memory manager on behalf of each model
+  static prometheus::Family<prometheus::Gauge>& FamilyModelMemoryBytes()
+  {
+    return GetSingleton()->model_memory_bytes_family_;
+  }
+  static prometheus::Family<prometheus::Gauge>& FamilyModelMemoryPeakBytes()
+  {
+    return GetSingleton()->model_memory_peak_bytes_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilyModelMemoryAllocationCount()
+  {
+    return GetSingleton()->model_memory_allocation_count_family_;
+  }
+
+  // Metric families of the sequences handled by the sequence batcher
+  // of each model
+  static prometheus::Family<prometheus::Gauge>& FamilySequenceActive()
+  {
+    return GetSingleton()->sequence_active_family_;
+  }
+  static prometheus::Family<prometheus::Gauge>& FamilySequenceBacklog()
+  {
+    return GetSingleton()->sequence_backlog_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilySequenceSlotCount()
+  {
+    return GetSingleton()->sequence_slot_count_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilySequenceSlotWait()
+  {
+    return GetSingleton()->sequence_slot_wait_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilySequenceEvictedCount()
+  {
+    return GetSingleton()->sequence_evicted_count_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilySequenceRejectedCount()
+  {
+    return GetSingleton()->sequence_rejected_count_family_;
+  }
+  static prometheus::Family<prometheus::Gauge>& FamilySequenceSlotsOccupied()
+  {
+    return GetSingleton()->sequence_slots_occupied_family_;
+  }
+
+  // Metric families of the queue and the batches of the dynamic batcher
+  // of each model
+  static prometheus::Family<prometheus::Gauge>& FamilyBatcherQueueSize()
+  {
+    return GetSingleton()->batcher_queue_size_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyBatcherBatchCount()
+  {
+    return GetSingleton()->batcher_batch_count_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyBatcherBatchFill()
+  {
+    return GetSingleton()->batcher_batch_fill_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyBatcherRejectedCount()
+  {
+    return GetSingleton()->batcher_rejected_count_family_;
+  }
+
+  // Metric families of the steps of the ensembles
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepCount()
+  {
+    return GetSingleton()->ensemble_step_count_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepDispatch()
+  {
+    return GetSingleton()->ensemble_step_dispatch_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepModel()
+  {
+    return GetSingleton()->ensemble_step_model_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepUpdate()
+  {
+    return GetSingleton()->ensemble_step_update_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilyEnsembleStepCriticalPathCount()
+  {
+    return GetSingleton()->ensemble_step_critical_path_count_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilyEnsembleStepCriticalPath()
+  {
+    return GetSingleton()->ensemble_step_critical_path_us_family_;
+  }
+
+  // Metric families of the model downloads from cloud storage
+  static prometheus::Family<prometheus::Counter>& FamilyModelDownloadBytes()
+  {
+    return GetSingleton()->model_download_bytes_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyModelDownloadDuration()
+  {
+    return GetSingleton()->model_download_duration_us_family_;
+  }
+  static prometheus::Family<prometheus::Counter>& FamilyModelDownloadRetries()
+  {
+    return GetSingleton()->model_download_retries_family_;
+  }
+  static prometheus::Family<prometheus::Counter>&
+  FamilyModelDownloadCachedBytes()
+  {
+    return GetSingleton()->model_download_cached_bytes_family_;
+  }
 
+#ifdef TRITON_ENABLE_METRICS_GPU
+  // Metric family of the fraction of time a GPU executes a model
+  static prometheus::Family<prometheus::Gauge>& FamilyModelGpuBusyFraction()
+  {
+    return GetSingleton()->model_gpu_busy_fraction_family_;
+  }
+#endif  // TRITON_ENABLE_METRICS_GPU
 
  private:
+  friend class LatencyHistogram;
+  friend class DeviceBusyGauge;
+
   Metrics();
   virtual ~Metrics();
   static Metrics* GetSingleton();
@@ -199,12 +387,17 @@ class Metrics {
       std::shared_ptr<RequestResponseCache> response_cache);
   bool StartPollingThread(std::shared_ptr<RequestResponseCache> response_cache);
   bool PollCacheMetrics(std::shared_ptr<RequestResponseCache> response_cache);
+  bool PollPinnedMemoryMetrics();
   bool PollDcgmMetrics();
+  void PollDeviceBusyMetrics();
 
   std::string dcgmValueToErrorMessage(double val);
   std::string dcgmValueToErrorMessage(int64_t val);
 
   std::shared_ptr<prometheus::Registry> registry_;
+  // The families only updated by the polling thread. They are collected
+  // again only once they may have changed.
+  std::shared_ptr<prometheus::Registry> polled_registry_;
   std::unique_ptr<prometheus::Serializer> serializer_;
 
   prometheus::Family<prometheus::Counter>& inf_success_family_;
@@ -219,6 +412,10 @@ class Metrics {
       inf_compute_infer_duration_us_family_;
   prometheus::Family<prometheus::Counter>&
       inf_compute_output_duration_us_family_;
+  prometheus::Family<prometheus::Gauge>& inf_queue_delay_target_us_family_;
+  prometheus::Family<prometheus::Histogram>& inf_request_latency_us_family_;
+  prometheus::Family<prometheus::Histogram>& inf_queue_latency_us_family_;
+  prometheus::Family<prometheus::Histogram>& inf_compute_latency_us_family_;
   // Global Response Cache metrics
   prometheus::Family<prometheus::Gauge>& cache_num_entries_family_;
   prometheus::Family<prometheus::Gauge>& cache_num_lookups_family_;
@@ -246,6 +443,51 @@ class Metrics {
       cache_miss_lookup_duration_us_model_family_;
   prometheus::Family<prometheus::Counter>&
       cache_miss_insertion_duration_us_model_family_;
+  prometheus::Family<prometheus::Gauge>& cache_model_bytes_family_;
+  prometheus::Family<prometheus::Counter>& cache_rejected_count_model_family_;
+  // Per-model memory usage metrics
+  prometheus::Family<prometheus::Gauge>& model_memory_bytes_family_;
+  prometheus::Family<prometheus::Gauge>& model_memory_peak_bytes_family_;
+  prometheus::Family<prometheus::Counter>&
+      model_memory_allocation_count_family_;
+  // Per-model sequence batcher metrics
+  prometheus::Family<prometheus::Gauge>& sequence_active_family_;
+  prometheus::Family<prometheus::Gauge>& sequence_backlog_family_;
+  prometheus::Family<prometheus::Counter>& sequence_slot_count_family_;
+  prometheus::Family<prometheus::Counter>& sequence_slot_wait_us_family_;
+  prometheus::Family<prometheus::Counter>& sequence_evicted_count_family_;
+  prometheus::Family<prometheus::Counter>& sequence_rejected_count_family_;
+  prometheus::Family<prometheus::Gauge>& sequence_slots_occupied_family_;
+  // Per-model dynamic batcher metrics
+  prometheus::Family<prometheus::Gauge>& batcher_queue_size_family_;
+  prometheus::Family<prometheus::Counter>& batcher_batch_count_family_;
+  prometheus::Family<prometheus::Counter>& batcher_batch_fill_family_;
+  prometheus::Family<prometheus::Counter>& batcher_rejected_count_family_;
+  // Per-step ensemble metrics
+  prometheus::Family<prometheus::Counter>& ensemble_step_count_family_;
+  prometheus::Family<prometheus::Counter>& ensemble_step_dispatch_us_family_;
+  prometheus::Family<prometheus::Counter>& ensemble_step_model_us_family_;
+  prometheus::Family<prometheus::Counter>& ensemble_step_update_us_family_;
+  prometheus::Family<prometheus::Counter>&
+      ensemble_step_critical_path_count_family_;
+  prometheus::Family<prometheus::Counter>&
+      ensemble_step_critical_path_us_family_;
+  // Model download metrics
+  prometheus::Family<prometheus::Counter>& model_download_bytes_family_;
+  prometheus::Family<prometheus::Counter>& model_download_duration_us_family_;
+  prometheus::Family<prometheus::Counter>& model_download_retries_family_;
+  prometheus::Family<prometheus::Counter>& model_download_cached_bytes_family_;
+  // Pinned memory slab allocator metrics
+  prometheus::Family<prometheus::Gauge>& pinned_slab_hits_family_;
+  prometheus::Family<prometheus::Gauge>& pinned_slab_misses_family_;
+  prometheus::Family<prometheus::Gauge>& pinned_slab_fragmentation_family_;
+  prometheus::Family<prometheus::Gauge>& pinned_pool_bytes_family_;
+  prometheus::Family<prometheus::Gauge>& pinned_fallback_family_;
+  prometheus::Gauge* pinned_slab_hits_;
+  prometheus::Gauge* pinned_slab_misses_;
+  prometheus::Gauge* pinned_slab_fragmentation_;
+  prometheus::Gauge* pinned_pool_bytes_;
+  prometheus::Gauge* pinned_fallback_;
 
 #ifdef TRITON_ENABLE_METRICS_GPU
   prometheus::Family<prometheus::Gauge>& gpu_utilization_family_;
@@ -254,6 +496,7 @@ class Metrics {
   prometheus::Family<prometheus::Gauge>& gpu_power_usage_family_;
   prometheus::Family<prometheus::Gauge>& gpu_power_limit_family_;
   prometheus::Family<prometheus::Counter>& gpu_energy_consumption_family_;
+  prometheus::Family<prometheus::Gauge>& model_gpu_busy_fraction_family_;
 
   std::vector<prometheus::Gauge*> gpu_utilization_;
   std::vector<prometheus::Gauge*> gpu_memory_total_;
@@ -263,6 +506,11 @@ class Metrics {
   std::vector<prometheus::Counter*> gpu_energy_consumption_;
 
   DcgmMetadata dcgm_metadata_;
+
+  // The live device busy gauges and the time of their last update.
+  std::mutex device_busy_gauges_mu_;
+  std::set<DeviceBusyGauge*> device_busy_gauges_;
+  uint64_t device_busy_poll_ns_;
 #endif  // TRITON_ENABLE_METRICS_GPU
 
   // Thread for polling cache/gpu metrics periodically
@@ -271,13 +519,118 @@ class Metrics {
   bool metrics_enabled_;
   bool gpu_metrics_enabled_;
   bool cache_metrics_enabled_;
+  bool pinned_memory_metrics_enabled_;
   bool poll_thread_started_;
   std::mutex gpu_metrics_enabling_;
   std::mutex cache_metrics_enabling_;
+  std::mutex pinned_memory_metrics_enabling_;
   std::mutex poll_thread_starting_;
   uint64_t metrics_interval_ms_;
+
+  // The bucket upper bounds of the latency histograms, empty if they are
+  // not enabled, and the live histograms to be folded into their
+  // prometheus histograms before the metrics are serialized.
+  std::vector<double> latency_buckets_us_;
+  std::mutex latency_histograms_mu_;
+  std::set<LatencyHistogram*> latency_histograms_;
+
+  // Incremented whenever the polled families may have changed, and the
+  // value it had when 'polled_families_' was collected.
+  std::atomic<uint64_t> poll_generation_;
+  uint64_t collected_poll_generation_;
+  std::vector<prometheus::MetricFamily> polled_families_;
+
+  // The text of the metrics of each family at their last serialization,
+  // keyed by family name and then by the value of the "model" label, the
+  // empty string for the metrics not associated with a model. Each model
+  // is kept along with the digest of its values at that time, so an
+  // inference only causes the metrics of its own model to be serialized
+  // again.
+  struct SerializedModel {
+    uint64_t digest_;
+    std::string text_;
+  };
+  struct SerializedFamily {
+    std::string header_;
+    std::unordered_map<std::string, SerializedModel> models_;
+  };
+  std::mutex serialized_families_mu_;
+  std::unordered_map<std::string, SerializedFamily> serialized_families_;
+};
+
+//
+// A histogram of durations in microseconds recorded without locks. The
+// observations are added to atomic bucket counters striped by recording
+// thread, so concurrent recording threads neither contend on the mutex
+// of the prometheus histogram nor share cache lines. The counters are
+// folded into the prometheus histogram when the metrics are serialized.
+//
+class LatencyHistogram {
+ public:
+  LatencyHistogram(
+      prometheus::Family<prometheus::Histogram>& family,
+      const std::map<std::string, std::string>& labels,
+      const std::vector<double>& buckets_us);
+  ~LatencyHistogram();
+
+  // Record a duration of 'duration_us' microseconds.
+  void Observe(const uint64_t duration_us);
+
+  // Fold the observations recorded since the last call into the
+  // prometheus histogram.
+  void Flush();
+
+ private:
+  static constexpr size_t kStripeCount = 16;
+  static constexpr size_t kCountersPerCacheLine =
+      64 / sizeof(std::atomic<uint64_t>);
+
+  prometheus::Family<prometheus::Histogram>& family_;
+  prometheus::Histogram* histogram_;
+  const std::vector<double> buckets_us_;
+  // Number of counters per stripe: one per bucket, one for the +Inf
+  // bucket and one for the sum of the durations, rounded up to whole
+  // cache lines.
+  const size_t stripe_size_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counters_;
 };
 
+#ifdef TRITON_ENABLE_METRICS_GPU
+//
+// DeviceBusyGauge
+//
+// The fraction of time the GPU of a model instance spends executing the
+// instance, from the compute durations reported by the instance. The
+// gauge is updated by the polling thread at each metrics interval. It
+// exceeds 1 when the instance executes several batches concurrently.
+//
+class DeviceBusyGauge {
+ public:
+  DeviceBusyGauge(
+      prometheus::Family<prometheus::Gauge>& family,
+      const std::map<std::string, std::string>& labels);
+  ~DeviceBusyGauge();
+
+  // Record 'duration_ns' nanoseconds of execution on the device.
+  void AddBusy(const uint64_t duration_ns)
+  {
+    busy_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  }
+
+ private:
+  friend class Metrics;
+
+  // Set the gauge to the fraction of the last 'interval_ns' nanoseconds
+  // the device was busy.
+  void Update(const uint64_t interval_ns);
+
+  prometheus::Family<prometheus::Gauge>& family_;
+  prometheus::Gauge* gauge_;
+  std::atomic<uint64_t> busy_ns_;
+  uint64_t last_busy_ns_;
+};
+#endif  // TRITON_ENABLE_METRICS_GPU
+
 }}  // namespace triton::core
 
 #endif  // TRITON_ENABLE_METRICS
@@ -51,6 +51,20 @@ Model::GetInput(
   return Status::Success;
 }
 
+Status
+Model::GetInputIndex(const std::string& name, int32_t* index) const
+{
+  const auto itr = input_index_map_.find(name);
+  if (itr == input_index_map_.end()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "unexpected inference input '" + name + "' for model '" + Name() + "'");
+  }
+
+  *index = itr->second;
+  return Status::Success;
+}
+
 Status
 Model::GetOutput(
     const std::string& name, const inference::ModelOutput** output) const
@@ -90,10 +104,13 @@ Model::Init()
 {
   RETURN_IF_ERROR(ValidateModelConfig(config_, min_compute_capability_));
   RETURN_IF_ERROR(ValidateModelIOConfig(config_));
+  config_snapshot_.reset(new ModelConfigSnapshot(config_));
 
   // Initialize the input map
-  for (const auto& io : config_.input()) {
+  for (int32_t idx = 0; idx < config_.input_size(); ++idx) {
+    const auto& io = config_.input(idx);
     input_map_.insert(std::make_pair(io.name(), io));
+    input_index_map_.insert(std::make_pair(io.name(), idx));
     if (!io.optional()) {
       ++required_input_count_;
     }
@@ -27,6 +27,10 @@
 
 #include "infer_stats.h"
 #include "label_provider.h"
+#include "memory_usage.h"
+#include "model_config_snapshot.h"
+#include "mpmc_queue.h"
+#include "sequence_stats.h"
 #include "model_config.pb.h"
 #include "scheduler.h"
 #include "status.h"
@@ -44,7 +48,8 @@ class Model {
       const double min_compute_capability, const std::string& model_dir,
       const int64_t version, const inference::ModelConfig& config)
       : config_(config), min_compute_capability_(min_compute_capability),
-        version_(version), required_input_count_(0), model_dir_(model_dir)
+        version_(version), required_input_count_(0), model_dir_(model_dir),
+        request_pool_(kRequestPoolCapacity)
   {
   }
   virtual ~Model() {}
@@ -58,6 +63,13 @@ class Model {
   // Get the configuration of model being served.
   const inference::ModelConfig& Config() const { return config_; }
 
+  // Get the snapshot of the configuration fields read by the request
+  // paths, only available once the model is initialized.
+  const ModelConfigSnapshot& ConfigSnapshot() const
+  {
+    return *config_snapshot_;
+  }
+
   // Get the number of required inputs
   size_t RequiredInputCount() const { return required_input_count_; }
 
@@ -71,10 +83,22 @@ class Model {
     return stats_aggregator_;
   }
 
+  // Get the accounting of the memory allocated on behalf of the model.
+  MemoryUsageTracker* MutableMemoryUsage() { return &memory_usage_; }
+  const MemoryUsageTracker& MemoryUsage() const { return memory_usage_; }
+
+  // Get the sequence statistics of the model, only maintained for a
+  // model using the sequence batcher.
+  SequenceStatsTracker* MutableSequenceStats() { return &sequence_stats_; }
+  const SequenceStatsTracker& SequenceStats() const { return sequence_stats_; }
+
   // Get the model configuration for a named input.
   Status GetInput(
       const std::string& name, const inference::ModelInput** input) const;
 
+  // Get the index in the model configuration inputs of a named input.
+  Status GetInputIndex(const std::string& name, int32_t* index) const;
+
   // Get the model configuration for a named output.
   Status GetOutput(
       const std::string& name, const inference::ModelOutput** output) const;
@@ -97,6 +121,13 @@ class Model {
     return scheduler_->Enqueue(request);
   }
 
+  // Enqueue requests that may be executed together, see
+  // Scheduler::EnqueueBatch().
+  Status EnqueueBatch(std::vector<std::unique_ptr<InferenceRequest>>& requests)
+  {
+    return scheduler_->EnqueueBatch(requests);
+  }
+
   // Return the number of in-flight inferences.
   size_t InflightInferenceCount()
   {
@@ -110,6 +141,16 @@ class Model {
 
   uint32_t MaxPriorityLevel() const { return max_priority_level_; }
 
+  // The normalization of the requests of the model.
+  NormalizeCache* MutableNormalizeCache() { return &normalize_cache_; }
+
+  // The request objects deleted through InferenceRequest::Delete(),
+  // reused by InferenceRequest::Create().
+  MPMCQueue<std::unique_ptr<InferenceRequest>>& RequestPool()
+  {
+    return request_pool_;
+  }
+
  protected:
   // Set the configuration of the model being served.
   Status SetModelConfig(const inference::ModelConfig& config);
@@ -134,14 +175,27 @@ class Model {
   // The stats collector for the model.
   InferenceStatsAggregator stats_aggregator_;
 
+  // The memory allocated on behalf of the model.
+  MemoryUsageTracker memory_usage_;
+
+  // The sequence statistics of the model.
+  SequenceStatsTracker sequence_stats_;
+
   // Label provider for this model.
   std::shared_ptr<LabelProvider> label_provider_;
 
+  // Built from 'config_' by Init().
+  std::unique_ptr<const ModelConfigSnapshot> config_snapshot_;
+
   size_t required_input_count_;
 
   // Map from input name to the model configuration for that input.
   std::unordered_map<std::string, inference::ModelInput> input_map_;
 
+  // Map from input name to the index of the input in the model
+  // configuration.
+  std::unordered_map<std::string, int32_t> input_index_map_;
+
   // Map from output name to the model configuration for that output.
   std::unordered_map<std::string, inference::ModelOutput> output_map_;
 
@@ -153,6 +207,13 @@ class Model {
 
   // The largest priority value for the model.
   uint32_t max_priority_level_;
+
+  // The pooled request objects, bounded so that a burst of requests
+  // doesn't keep its memory once the load drops.
+  static constexpr size_t kRequestPoolCapacity = 64;
+  MPMCQueue<std::unique_ptr<InferenceRequest>> request_pool_;
+
+  NormalizeCache normalize_cache_;
 };
 
 }}  // namespace triton::core
@@ -27,6 +27,7 @@
 #include "model_config_cuda.h"
 
 #include <cuda_runtime_api.h>
+#include <algorithm>
 
 namespace triton { namespace core {
 
@@ -58,4 +59,26 @@ GetCudaStreamPriority(
   return cuda_stream_priority;
 }
 
+std::vector<int>
+GetCudaStreamPriorities(const size_t count)
+{
+  // 'max' is the greatest priority, which is numerically the lowest
+  int min = 0, max = 0;
+  cudaError_t cuerr = cudaDeviceGetStreamPriorityRange(&min, &max);
+  if (cuerr != cudaSuccess) {
+    min = max = 0;
+  }
+
+  const size_t range = min - max + 1;
+  const size_t stream_count = std::min(count, range);
+  std::vector<int> priorities;
+  for (size_t idx = 0; idx < stream_count; ++idx) {
+    priorities.push_back(
+        (stream_count == 1) ? max
+                            : max + (int)(idx * (range - 1) /
+                                          (stream_count - 1)));
+  }
+  return priorities;
+}
+
 }}  // namespace triton::core
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <vector>
 #include "model_config.pb.h"
 
 namespace triton { namespace core {
@@ -37,4 +38,12 @@ namespace triton { namespace core {
 int GetCudaStreamPriority(
     inference::ModelOptimizationPolicy::ModelPriority priority);
 
+/// Get the CUDA stream priorities of at most 'count' streams of the
+/// current device, spread over its priority range from the highest
+/// priority to the lowest. Fewer priorities are returned if the range
+/// doesn't have 'count' distinct priorities.
+/// \param count The number of streams.
+/// \return The CUDA stream priorities.
+std::vector<int> GetCudaStreamPriorities(const size_t count);
+
 }}  // namespace triton::core
@@ -0,0 +1,71 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "model_config_snapshot.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+template <typename TensorConfig>
+ModelConfigSnapshot::Tensor
+SnapshotTensor(const TensorConfig& io)
+{
+  ModelConfigSnapshot::Tensor tensor;
+  tensor.name_ = io.name();
+  tensor.datatype_ = io.data_type();
+  tensor.dims_.assign(io.dims().begin(), io.dims().end());
+  tensor.has_reshape_ = io.has_reshape();
+  tensor.reshape_.assign(
+      io.reshape().shape().begin(), io.reshape().shape().end());
+  tensor.is_shape_tensor_ = io.is_shape_tensor();
+  return tensor;
+}
+
+}  // namespace
+
+ModelConfigSnapshot::ModelConfigSnapshot(const inference::ModelConfig& config)
+    : max_batch_size_(config.max_batch_size()),
+      batch_input_count_(config.batch_input_size())
+{
+  inputs_.reserve(config.input_size());
+  for (const auto& io : config.input()) {
+    inputs_.emplace_back(SnapshotTensor(io));
+  }
+  outputs_.reserve(config.output_size());
+  for (const auto& io : config.output()) {
+    output_index_.emplace(io.name(), outputs_.size());
+    outputs_.emplace_back(SnapshotTensor(io));
+  }
+}
+
+int32_t
+ModelConfigSnapshot::OutputIndex(const std::string& name) const
+{
+  const auto it = output_index_.find(name);
+  return (it == output_index_.end()) ? -1 : it->second;
+}
+
+}}  // namespace triton::core
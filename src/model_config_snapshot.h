@@ -0,0 +1,66 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "model_config.pb.h"
+
+namespace triton { namespace core {
+
+//
+// Immutable copy of the model configuration fields read for every
+// request, held in flat containers so that the request paths don't go
+// through the protobuf accessors or scan repeated fields by name. It is
+// built once the model configuration is final.
+//
+struct ModelConfigSnapshot {
+  struct Tensor {
+    std::string name_;
+    inference::DataType datatype_;
+    std::vector<int64_t> dims_;
+    // The shape of the tensor as seen by the model, only valid if
+    // 'has_reshape_' is true.
+    bool has_reshape_;
+    std::vector<int64_t> reshape_;
+    bool is_shape_tensor_;
+  };
+
+  explicit ModelConfigSnapshot(const inference::ModelConfig& config);
+
+  // Return the index of the output named 'name' in 'outputs_', -1 if
+  // there is none.
+  int32_t OutputIndex(const std::string& name) const;
+
+  int32_t max_batch_size_;
+  size_t batch_input_count_;
+  std::vector<Tensor> inputs_;
+  std::vector<Tensor> outputs_;
+  std::unordered_map<std::string, int32_t> output_index_;
+};
+
+}}  // namespace triton::core
@@ -27,6 +27,7 @@
 #include "model_config_utils.h"
 
 #include <google/protobuf/util/json_util.h>
+#include <algorithm>
 #include <deque>
 #include <mutex>
 #include <set>
@@ -1576,6 +1577,41 @@ ParseLongLongParameter(
   return Status::Success;
 }
 
+Status
+GetUnsignedParameter(
+    const inference::ModelConfig& config, const std::string& name,
+    const uint64_t default_value, uint64_t* value)
+{
+  *value = default_value;
+  const auto it = config.parameters().find(name);
+  if (it == config.parameters().end()) {
+    return Status::Success;
+  }
+  const std::string& str = it->second.string_value();
+  // Only accept digits, std::stoull() skips leading whitespace and wraps
+  // negative values around.
+  bool valid =
+      !str.empty() && std::all_of(str.begin(), str.end(), [](const char c) {
+        return (c >= '0') && (c <= '9');
+      });
+  if (valid) {
+    try {
+      *value = std::stoull(str);
+    }
+    catch (const std::out_of_range&) {
+      valid = false;
+    }
+  }
+  if (!valid) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model '" + config.name() + "' parameter '" + name +
+            "' must be a non-negative integer, got '" + str + "'");
+  }
+
+  return Status::Success;
+}
+
 Status
 GetProfileIndex(const std::string& profile_name, int* profile_index)
 {
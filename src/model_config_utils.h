@@ -193,6 +193,18 @@ Status ParseBoolParameter(
 Status ParseLongLongParameter(
     const std::string& key, const std::string& value, int64_t* parsed_value);
 
+/// Get the value of the model config parameter 'name' as a non-negative
+/// integer.
+/// \param config The model configuration.
+/// \param name The name of the parameter.
+/// \param default_value The value to return if the parameter isn't set.
+/// \param value Returns the value of the parameter.
+/// \return The error status. A non-OK status indicates that the parameter
+/// isn't a non-negative integer.
+Status GetUnsignedParameter(
+    const inference::ModelConfig& config, const std::string& name,
+    const uint64_t default_value, uint64_t* value);
+
 /// Obtain the 'profile_index' of the 'profile_name'.
 /// \param profile_name The name of the profile.
 /// \param profile_index Return the index of the profile.
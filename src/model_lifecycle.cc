@@ -37,6 +37,7 @@
 #include "model.h"
 #include "model_config_utils.h"
 #include "repo_agent.h"
+#include "server.h"
 #include "triton/common/logging.h"
 #include "triton/common/thread_pool.h"
 
@@ -188,8 +189,13 @@ ModelLifeCycle::LiveModelStates(bool strict_readiness)
 {
   LOG_VERBOSE(2) << "LiveModelStates()";
   std::lock_guard<std::mutex> map_lock(map_mtx_);
+  const uint64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
   ModelStateMap live_model_states;
   for (auto& model_version : map_) {
+    ReleaseCutoverVersions(&model_version.second, now_ns);
     bool live = false;
     VersionStateMap version_map;
 
@@ -325,12 +331,39 @@ ModelLifeCycle::GetModel(
     std::shared_ptr<Model>* model)
 {
   LOG_VERBOSE(2) << "GetModel() '" << model_name << "' version " << version;
+
+  // Look up the ready versions without locking, the lookups that need the
+  // state of the versions or the cut over take the lock below.
+  {
+    const auto ready_models = ready_models_.Read();
+    const auto rit = ready_models->find(model_name);
+    if (rit != ready_models->end()) {
+      const ReadyModel& ready = rit->second;
+      if (version != -1) {
+        const auto vit = ready.versions_.find(version);
+        if (vit != ready.versions_.end()) {
+          *model = vit->second;
+          return Status::Success;
+        }
+      } else if (!ready.in_cutover_ && (ready.latest_ != -1)) {
+        *model = ready.versions_.find(ready.latest_)->second;
+        return Status::Success;
+      }
+    }
+  }
+
   std::lock_guard<std::mutex> map_lock(map_mtx_);
   auto mit = map_.find(model_name);
   if (mit == map_.end()) {
     return Status(Status::Code::NOT_FOUND, "'" + model_name + "' is not found");
   }
 
+  const uint64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  ReleaseCutoverVersions(&mit->second, now_ns);
+
   auto vit = mit->second.find(version);
   if (vit == mit->second.end()) {
     if (version != -1) {
@@ -340,12 +373,26 @@ ModelLifeCycle::GetModel(
                                        " is not found");
     }
 
-    // The case where the request is asking for latest version
+    // The case where the request is asking for latest version, the versions
+    // being cut over from are only considered for their share of requests.
     int64_t latest = -1;
+    int64_t cutover = -1;
+    std::shared_ptr<Model> cutover_model;
+    double cutover_share = 0;
     for (auto& version_model : mit->second) {
-      if (version_model.first > latest) {
+      const bool in_cutover = (version_model.second->cutover_end_ns_ != 0);
+      if (version_model.first > (in_cutover ? cutover : latest)) {
         std::lock_guard<std::mutex> lock(version_model.second->mtx_);
         if (version_model.second->state_ == ModelReadyState::READY) {
+          if (in_cutover) {
+            const auto& info = version_model.second;
+            cutover = version_model.first;
+            cutover_model = info->model_;
+            cutover_share =
+                static_cast<double>(info->cutover_end_ns_ - now_ns) /
+                (info->cutover_end_ns_ - info->cutover_start_ns_);
+            continue;
+          }
           latest = version_model.first;
           // Tedious, but have to set handle for any "latest" version
           // at the moment to avoid edge case like the following:
@@ -356,6 +403,17 @@ ModelLifeCycle::GetModel(
         }
       }
     }
+    if (cutover != -1) {
+      // Spread the requests evenly by the fractional part of multiples of
+      // the golden ratio.
+      const double golden_ratio = 0.6180339887498949;
+      const double position = cutover_request_cnt_++ * golden_ratio;
+      if ((latest == -1) ||
+          ((position - static_cast<uint64_t>(position)) < cutover_share)) {
+        latest = cutover;
+        *model = std::move(cutover_model);
+      }
+    }
     if (latest == -1) {
       return Status(
           Status::Code::NOT_FOUND,
@@ -414,6 +472,7 @@ ModelLifeCycle::AsyncUnload(const std::string& model_name)
       model_info->Release();
     }
   }
+  PublishReadyModels();
 
   return Status::Success;
 }
@@ -444,13 +503,17 @@ ModelLifeCycle::AsyncLoad(
             model_name + "'");
   }
 
+  uint64_t cutover_ms;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      model_config, kVersionCutoverParameter, 0 /* default_value */,
+      &cutover_ms));
 
   const uint64_t now_ns =
       std::chrono::duration_cast<std::chrono::nanoseconds>(
           std::chrono::steady_clock::now().time_since_epoch())
           .count();
-  std::shared_ptr<LoadTracker> load_tracker(
-      new LoadTracker(versions.size(), now_ns));
+  std::shared_ptr<LoadTracker> load_tracker(new LoadTracker(
+      versions.size(), now_ns, cutover_ms * NANOS_PER_MILLIS));
   for (const auto& version : versions) {
     std::unique_ptr<ModelInfo> linfo(
         new ModelInfo(model_path, model_config, now_ns));
@@ -591,6 +654,11 @@ ModelLifeCycle::CreateModel(
           if (it != this->background_models_.end()) {
             this->background_models_.erase(it);
           }
+
+          // Shutdown waits for the models to be unloaded
+          if (this->server_ != nullptr) {
+            this->server_->NotifyDrainProgress();
+          }
         }));
   } else {
     LOG_ERROR << "failed to load '" << model_name << "' version " << version
@@ -600,6 +668,64 @@ ModelLifeCycle::CreateModel(
   }
 }
 
+void
+ModelLifeCycle::ReleaseCutoverVersions(
+    VersionMap* versions, const uint64_t now_ns)
+{
+  bool released = false;
+  for (auto& version_info : *versions) {
+    auto& mi = version_info.second;
+    if ((mi->cutover_end_ns_ == 0) || (mi->cutover_end_ns_ > now_ns)) {
+      continue;
+    }
+    std::lock_guard<std::mutex> info_lk(mi->mtx_);
+    mi->cutover_start_ns_ = 0;
+    mi->cutover_end_ns_ = 0;
+    released = true;
+    if (mi->state_ == ModelReadyState::READY) {
+      if (mi->agent_model_list_ != nullptr) {
+        auto status = mi->agent_model_list_->InvokeAgentModels(
+            TRITONREPOAGENT_ACTION_UNLOAD);
+        if (!status.IsOk()) {
+          LOG_ERROR << "Agent model returns error on "
+                       "TRITONREPOAGENT_ACTION_UNLOAD: "
+                    << status.AsString();
+        }
+      }
+      mi->Release();
+    }
+  }
+  if (released) {
+    PublishReadyModels();
+  }
+}
+
+void
+ModelLifeCycle::PublishReadyModels()
+{
+  std::unique_ptr<ReadyModelMap> ready_models(new ReadyModelMap());
+  for (const auto& model_version : map_) {
+    ReadyModel ready;
+    for (const auto& version_model : model_version.second) {
+      const auto& info = version_model.second;
+      std::lock_guard<std::mutex> lock(info->mtx_);
+      if (info->state_ != ModelReadyState::READY) {
+        continue;
+      }
+      ready.versions_.emplace(version_model.first, info->model_);
+      if (info->cutover_end_ns_ != 0) {
+        ready.in_cutover_ = true;
+      } else {
+        ready.latest_ = std::max(ready.latest_, version_model.first);
+      }
+    }
+    if (!ready.versions_.empty()) {
+      ready_models->emplace(model_version.first, std::move(ready));
+    }
+  }
+  ready_models_.Publish(std::move(ready_models));
+}
+
 void
 ModelLifeCycle::OnLoadComplete(
     const std::string& model_name, const int64_t version, ModelInfo* model_info,
@@ -665,12 +791,29 @@ ModelLifeCycle::OnLoadComplete(
         }
       }
     } else {
-      // Unload any previous loaded versions that are still available
+      // Unload any previous loaded versions that are still available. The
+      // versions that are not reloaded are cut over from instead if
+      // requested, once the new versions are ready.
+      const uint64_t now_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count();
       for (auto& version_info : it->second) {
         auto& mi = version_info.second;
         std::lock_guard<std::mutex> info_lk(mi->mtx_);
         if ((mi->state_ == ModelReadyState::READY) &&
             (mi->last_update_ns_ < load_tracker->last_update_ns_)) {
+          if ((load_tracker->cutover_ns_ != 0) &&
+              (load_tracker->load_set_.find(version_info.first) ==
+               load_tracker->load_set_.end())) {
+            if (mi->cutover_end_ns_ == 0) {
+              LOG_INFO << "cutting over from '" << model_name << "' version "
+                       << version_info.first;
+              mi->cutover_start_ns_ = now_ns;
+              mi->cutover_end_ns_ = now_ns + load_tracker->cutover_ns_;
+            }
+            continue;
+          }
           if (mi->agent_model_list_ != nullptr) {
             auto status = mi->agent_model_list_->InvokeAgentModels(
                 TRITONREPOAGENT_ACTION_UNLOAD);
@@ -727,6 +870,7 @@ ModelLifeCycle::OnLoadComplete(
         }
       }
     }
+    PublishReadyModels();
     if (OnComplete != nullptr) {
       OnComplete(
           load_tracker->load_failed_
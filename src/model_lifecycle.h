@@ -26,11 +26,14 @@
 //
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <unordered_map>
 #include "infer_parameter.h"
 #include "model_config.pb.h"
+#include "rcu_snapshot.h"
 #include "repo_agent.h"
 #include "status.h"
 #include "triton/common/model_config.h"
@@ -171,6 +174,8 @@ class ModelLifeCycle {
     // Explicitly clean up thread pool first to clean up any pending callbacks
     // that may modify model lifecycle members
     load_pool_.reset();
+    ready_models_.Publish(
+        std::unique_ptr<ReadyModelMap>(new ReadyModelMap()));
     map_.clear();
   }
 
@@ -187,8 +192,9 @@ class ModelLifeCycle {
   Status AsyncUnload(const std::string& model_name);
 
   // Get specified version of the model. Latest ready version will
-  // be retrieved if 'version' is -1. Return error if the version specified is
-  // not found or it is not ready.
+  // be retrieved if 'version' is -1, or a version being cut over from for
+  // its remaining share of the requests. Return error if the version
+  // specified is not found or it is not ready.
   Status GetModel(
       const std::string& model_name, const int64_t version,
       std::shared_ptr<Model>* model);
@@ -229,7 +235,8 @@ class ModelLifeCycle {
 #else
           is_ensemble_(false),
 #endif  // TRITON_ENABLE_ENSEMBLE
-          last_update_ns_(last_update_ns), state_(ModelReadyState::UNKNOWN)
+          last_update_ns_(last_update_ns), cutover_start_ns_(0),
+          cutover_end_ns_(0), state_(ModelReadyState::UNKNOWN)
     {
     }
 
@@ -252,6 +259,12 @@ class ModelLifeCycle {
 
     uint64_t last_update_ns_;
 
+    // Non-zero if the version is being cut over to newer versions, its
+    // share of the requests for the latest version decreases linearly from
+    // the start to the end, when the version is released.
+    uint64_t cutover_start_ns_;
+    uint64_t cutover_end_ns_;
+
     ModelReadyState state_;
     std::string state_reason_;
 
@@ -262,15 +275,19 @@ class ModelLifeCycle {
 
   struct LoadTracker {
     LoadTracker(
-        const size_t affected_version_cnt, const uint64_t last_update_ns)
+        const size_t affected_version_cnt, const uint64_t last_update_ns,
+        const uint64_t cutover_ns)
         : last_update_ns_(last_update_ns),
-          affected_version_cnt_(affected_version_cnt), load_failed_(false),
-          completed_version_cnt_(0)
+          affected_version_cnt_(affected_version_cnt), cutover_ns_(cutover_ns),
+          load_failed_(false), completed_version_cnt_(0)
     {
     }
 
     const uint64_t last_update_ns_;
     const size_t affected_version_cnt_;
+    // The duration of the cut over from the previous versions, 0 to unload
+    // them once the load completes.
+    const uint64_t cutover_ns_;
 
     std::mutex mtx_;
 
@@ -284,12 +301,16 @@ class ModelLifeCycle {
       : server_(server),
         min_compute_capability_(options.min_compute_capability_),
         cmdline_config_map_(options.backend_cmdline_config_map_),
-        host_policy_map_(options.host_policy_map_)
+        host_policy_map_(options.host_policy_map_), cutover_request_cnt_(0),
+        ready_models_(std::unique_ptr<ReadyModelMap>(new ReadyModelMap()))
   {
     load_pool_.reset(new triton::common::ThreadPool(
         std::max(1u, options.model_load_thread_count_)));
   }
 
+  using VersionMap = std::map<int64_t, std::unique_ptr<ModelInfo>>;
+  using ModelMap = std::map<std::string, VersionMap>;
+
   void CreateModel(
       const std::string& model_name, const int64_t version,
       ModelInfo* model_info);
@@ -302,12 +323,29 @@ class ModelLifeCycle {
       ModelInfo* model_info, std::function<void(Status)> OnComplete,
       std::shared_ptr<LoadTracker> load_tracker);
 
+  // Release the versions whose cut over has completed by 'now_ns'. Note
+  // that 'map_mtx_' should be acquired before invoking this function.
+  void ReleaseCutoverVersions(VersionMap* versions, const uint64_t now_ns);
+
+  // The ready versions of a model, for the lookups that don't lock
+  // 'map_mtx_'. 'latest_' is the latest ready version that is not being
+  // cut over from, or -1. If 'in_cutover_' is true, a version is being cut
+  // over from and the latest version must be looked up under the lock.
+  struct ReadyModel {
+    std::map<int64_t, std::shared_ptr<Model>> versions_;
+    int64_t latest_ = -1;
+    bool in_cutover_ = false;
+  };
+  using ReadyModelMap = std::unordered_map<std::string, ReadyModel>;
+
+  // Publish the ready versions in 'map_' to 'ready_models_'. Must be
+  // called with 'map_mtx_' held whenever a version becomes ready or stops
+  // being ready, or its cut over starts or ends.
+  void PublishReadyModels();
 
   // Mutex for 'map_' and 'background_models_'
   std::mutex map_mtx_;
 
-  using VersionMap = std::map<int64_t, std::unique_ptr<ModelInfo>>;
-  using ModelMap = std::map<std::string, VersionMap>;
   ModelMap map_;
   // Models that are being loaded / unloaded in background
   std::map<uintptr_t, std::unique_ptr<ModelInfo>> background_models_;
@@ -319,6 +357,14 @@ class ModelLifeCycle {
 
   // Fixed-size thread pool to load models at specified concurrency
   std::unique_ptr<triton::common::ThreadPool> load_pool_;
+
+  // The number of requests for the latest version of a model being cut
+  // over, used to spread the requests across the versions.
+  std::atomic<uint64_t> cutover_request_cnt_;
+
+  // The ready versions of the models, published under 'map_mtx_' and read
+  // by GetModel() without locking.
+  RcuSnapshot<ReadyModelMap> ready_models_;
 };
 
 }}  // namespace triton::core
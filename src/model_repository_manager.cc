@@ -28,13 +28,18 @@
 #include "model_repository_manager.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <deque>
-#include <future>
+#include <iomanip>
+#include <sstream>
 #include <stdexcept>
 #include <thread>
 #include "constants.h"
 #include "ensemble_utils.h"
 #include "filesystem.h"
+#include "hash_utils.h"
 #include "model.h"
 #include "model_config_utils.h"
 #include "triton/common/logging.h"
@@ -252,16 +257,108 @@ GetModifiedTime(const std::string& path)
 
   return mtime;
 }
-// Return true if any file in the subdirectory root at 'path' has been
-// modified more recently than 'last'. Return the most-recent modified
-// time in 'last'.
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// The normalized model configs are kept under TRITON_MODEL_CACHE_DIR,
+// one directory per repository and one entry per model, so that a
+// restart skips parsing the configs of the unmodified models. An entry
+// holds the digest of the key it was normalized for followed by the
+// config in binary protobuf. Return an empty path if TRITON_MODEL_CACHE_DIR
+// is not set.
+std::string
+NormalizedConfigPath(const std::string& model_path)
+{
+  static const std::string root = []() -> std::string {
+    const char* dir = std::getenv("TRITON_MODEL_CACHE_DIR");
+    if ((dir == nullptr) || (dir[0] == '\0')) {
+      return "";
+    }
+    return JoinPath({dir, "configs"});
+  }();
+  if (root.empty()) {
+    return "";
+  }
+
+  StreamingHash64 repository;
+  repository.Update(DirName(model_path));
+  std::stringstream dir;
+  dir << std::hex << std::setw(16) << std::setfill('0')
+      << repository.Digest();
+  return JoinPath({root, dir.str(), BaseName(model_path) + ".pb"});
+}
+
 bool
-IsModified(const std::string& path, int64_t* last_ns)
+ReadNormalizedConfig(
+    const std::string& model_path, const uint64_t key,
+    inference::ModelConfig* config)
 {
-  const int64_t repo_ns = GetModifiedTime(path);
-  bool modified = repo_ns > *last_ns;
-  *last_ns = repo_ns;
-  return modified;
+  const std::string path = NormalizedConfigPath(model_path);
+  bool exists = false;
+  if (path.empty() || !FileExists(path, &exists).IsOk() || !exists) {
+    return false;
+  }
+  std::string contents;
+  if (!ReadTextFile(path, &contents).IsOk() ||
+      (contents.size() < sizeof(key)) ||
+      (memcmp(contents.data(), &key, sizeof(key)) != 0)) {
+    return false;
+  }
+  if (!config->ParseFromArray(
+          contents.data() + sizeof(key), contents.size() - sizeof(key))) {
+    config->Clear();
+    return false;
+  }
+  LOG_VERBOSE(1) << "using cached normalized config of '" << model_path
+                 << "'";
+  return true;
+}
+
+void
+WriteNormalizedConfig(
+    const std::string& model_path, const uint64_t key,
+    const inference::ModelConfig& config)
+{
+  const std::string path = NormalizedConfigPath(model_path);
+  if (path.empty()) {
+    return;
+  }
+  std::string contents(reinterpret_cast<const char*>(&key), sizeof(key));
+  if (!config.AppendToString(&contents)) {
+    return;
+  }
+
+  // Other threads and processes may write the same entry, write to a
+  // unique file and rename it in place so a reader never sees a partial
+  // entry.
+  const std::string dir = DirName(path);
+  bool is_dir = false;
+  if (!MakeDirectory(dir, true /* recursive */).IsOk() &&
+      !(IsDirectory(dir, &is_dir).IsOk() && is_dir)) {
+    LOG_VERBOSE(1) << "failed to create config cache directory " << dir;
+    return;
+  }
+  const std::string tmp_path =
+      path + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+      "." + std::to_string(NowNs());
+  Status status = WriteBinaryFile(tmp_path, contents.data(), contents.size());
+  if (status.IsOk() && (std::rename(tmp_path.c_str(), path.c_str()) != 0)) {
+    status = Status(
+        Status::Code::INTERNAL,
+        "failed to rename " + tmp_path + ", errno:" + strerror(errno));
+  }
+  if (!status.IsOk()) {
+    std::remove(tmp_path.c_str());
+    LOG_VERBOSE(1) << "failed to cache normalized config of '" << model_path
+                   << "': " << status.Message();
+  }
 }
 
 }  // namespace
@@ -289,17 +386,32 @@ struct ModelRepositoryManager::ModelInfo {
 ModelRepositoryManager::ModelRepositoryManager(
     const std::set<std::string>& repository_paths, const bool autofill,
     const bool polling_enabled, const bool model_control_enabled,
-    const double min_compute_capability,
+    const double min_compute_capability, const std::string& server_version,
+    const unsigned int poll_thread_count,
     std::unique_ptr<ModelLifeCycle> life_cycle)
     : repository_paths_(repository_paths), autofill_(autofill),
       polling_enabled_(polling_enabled),
       model_control_enabled_(model_control_enabled),
       min_compute_capability_(min_compute_capability),
-      model_life_cycle_(std::move(life_cycle))
+      server_version_(server_version),
+      poll_thread_count_(std::max(1u, poll_thread_count)),
+      model_life_cycle_(std::move(life_cycle)), on_demand_load_(false),
+      idle_unload_timeout_ns_(0), gpu_memory_budget_(0),
+      idle_unload_exit_(false)
 {
 }
 
-ModelRepositoryManager::~ModelRepositoryManager() {}
+ModelRepositoryManager::~ModelRepositoryManager()
+{
+  if (idle_unload_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(last_request_mu_);
+      idle_unload_exit_ = true;
+    }
+    idle_unload_cv_.notify_all();
+    idle_unload_thread_.join();
+  }
+}
 
 Status
 ModelRepositoryManager::Create(
@@ -336,6 +448,7 @@ ModelRepositoryManager::Create(
       new ModelRepositoryManager(
           repository_paths, !strict_model_config, polling_enabled,
           model_control_enabled, life_cycle_options.min_compute_capability_,
+          server_version, life_cycle_options.model_load_thread_count_,
           std::move(life_cycle)));
   *model_repository_manager = std::move(local_manager);
 
@@ -465,64 +578,114 @@ ModelRepositoryManager::LoadModelByDependency()
 {
   std::map<std::string, Status> res;
   struct ModelState {
-    ModelState(DependencyNode* node) : node_(node), status_(Status::Success) {}
+    ModelState(DependencyNode* node)
+        : node_(node), status_(Status::Success), start_ns_(0), end_ns_(0)
+    {
+    }
     DependencyNode* node_;
     Status status_;
-    std::promise<void> ready_;
+    uint64_t start_ns_;
+    uint64_t end_ns_;
   };
-  NodeSet loaded_models;
-  auto set_pair = ModelsToLoadUnload(loaded_models);
-  // Loop until all model are loaded / unloaded
-  while ((!set_pair.first.empty()) || (!set_pair.second.empty())) {
-    loaded_models.clear();
-    // Unload invalid models first
-    for (auto& invalid_model : set_pair.second) {
-      model_life_cycle_->AsyncUnload(invalid_model->model_name_);
-      LOG_ERROR << invalid_model->status_.AsString();
-      invalid_model->loaded_versions_ = std::set<int64_t>();
-      loaded_models.emplace(invalid_model);
-    }
-    // load valid models and wait for load results
-    std::vector<std::unique_ptr<ModelState>> model_states;
-    for (auto& valid_model : set_pair.first) {
-      model_states.emplace_back(new ModelState(valid_model));
-      auto model_state = model_states.back().get();
-      const auto itr = infos_.find(valid_model->model_name_);
-      auto status = model_life_cycle_->AsyncLoad(
-          valid_model->model_name_, itr->second->model_path_,
-          valid_model->model_config_, itr->second->agent_model_list_,
-          [model_state](Status load_status) {
-            model_state->status_ = load_status;
-            model_state->ready_.set_value();
-          });
-      if (!status.IsOk()) {
-        model_state->status_ = status;
-        model_state->ready_.set_value();
-        LOG_ERROR << "failed to load model '" << valid_model->model_name_
-                  << "': " << status.Message();
-      }
-      loaded_models.emplace(valid_model);
-    }
-    for (auto& model_state : model_states) {
-      model_state->ready_.get_future().wait();
-      res[model_state->node_->model_name_] = model_state->status_;
-      const auto version_state =
-          model_life_cycle_->VersionStates(model_state->node_->model_name_);
-      model_state->node_->loaded_versions_.clear();
-      for (const auto& vs : version_state) {
-        if (vs.second.first == ModelReadyState::READY) {
-          model_state->node_->loaded_versions_.emplace(vs.first);
+  // The loads report their completion from the load threads, the
+  // dependency graph is only updated by this thread as the completions
+  // are consumed. The completion queue is shared with the callbacks so
+  // that it outlives the last one of them.
+  struct Completions {
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<ModelState*> queue_;
+  };
+  auto completions = std::make_shared<Completions>();
+  auto complete = [completions](ModelState* model_state, Status status) {
+    std::lock_guard<std::mutex> lk(completions->mu_);
+    model_state->status_ = status;
+    model_state->end_ns_ = NowNs();
+    completions->queue_.push_back(model_state);
+    completions->cv_.notify_one();
+  };
+
+  std::vector<std::unique_ptr<ModelState>> model_states;
+  size_t inflight = 0;
+  const uint64_t start_ns = NowNs();
+
+  // Unload the invalid models and start loading the valid models of
+  // 'set_pair', without waiting for the loads already in flight. The
+  // models depending on an invalid model are resolved right away.
+  std::function<void(const std::pair<NodeSet, NodeSet>&)> schedule =
+      [&](const std::pair<NodeSet, NodeSet>& set_pair) {
+        for (auto& invalid_model : set_pair.second) {
+          model_life_cycle_->AsyncUnload(invalid_model->model_name_);
+          LOG_ERROR << invalid_model->status_.AsString();
+          invalid_model->loaded_versions_ = std::set<int64_t>();
+          schedule(ModelsToLoadUnload(NodeSet{invalid_model}));
         }
+        for (auto& valid_model : set_pair.first) {
+          valid_model->loading_ = true;
+          model_states.emplace_back(new ModelState(valid_model));
+          auto model_state = model_states.back().get();
+          model_state->start_ns_ = NowNs();
+          ++inflight;
+          const auto itr = infos_.find(valid_model->model_name_);
+          auto status = model_life_cycle_->AsyncLoad(
+              valid_model->model_name_, itr->second->model_path_,
+              valid_model->model_config_, itr->second->agent_model_list_,
+              [complete, model_state](Status load_status) {
+                complete(model_state, load_status);
+              });
+          if (!status.IsOk()) {
+            LOG_ERROR << "failed to load model '" << valid_model->model_name_
+                      << "': " << status.Message();
+            complete(model_state, status);
+          }
+        }
+      };
+
+  schedule(ModelsToLoadUnload(NodeSet()));
+  // Consume the load completions in the order they finish, each one may
+  // make the models depending on it ready to load.
+  while (inflight > 0) {
+    ModelState* model_state;
+    {
+      std::unique_lock<std::mutex> lk(completions->mu_);
+      completions->cv_.wait(
+          lk, [&completions] { return !completions->queue_.empty(); });
+      model_state = completions->queue_.front();
+      completions->queue_.pop_front();
+    }
+    --inflight;
+
+    LOG_VERBOSE(1) << "model '" << model_state->node_->model_name_ << "' "
+                   << (model_state->status_.IsOk() ? "loaded" : "failed")
+                   << " in "
+                   << (model_state->end_ns_ - model_state->start_ns_) /
+                          NANOS_PER_MILLIS
+                   << " ms, ready to load after "
+                   << (model_state->start_ns_ - start_ns) / NANOS_PER_MILLIS
+                   << " ms";
+
+    res[model_state->node_->model_name_] = model_state->status_;
+    model_state->node_->loading_ = false;
+    const auto version_state =
+        model_life_cycle_->VersionStates(model_state->node_->model_name_);
+    model_state->node_->loaded_versions_.clear();
+    for (const auto& vs : version_state) {
+      if (vs.second.first == ModelReadyState::READY) {
+        model_state->node_->loaded_versions_.emplace(vs.first);
       }
-      // If the model failed to load, should revert the timestamp to
-      // ensure the next load request will attempt to load the model again
-      // for operation consistency.
-      if (!model_state->status_.IsOk()) {
-        auto& model_info = infos_.find(model_state->node_->model_name_)->second;
-        model_info->mtime_nsec_ = model_info->prev_mtime_ns_;
-      }
     }
-    set_pair = ModelsToLoadUnload(loaded_models);
+    // If the model failed to load, should revert the timestamp to
+    // ensure the next load request will attempt to load the model again
+    // for operation consistency.
+    if (!model_state->status_.IsOk()) {
+      auto& model_info = infos_.find(model_state->node_->model_name_)->second;
+      model_info->mtime_nsec_ = model_info->prev_mtime_ns_;
+    }
+    schedule(ModelsToLoadUnload(NodeSet{model_state->node_}));
+  }
+  if (!model_states.empty()) {
+    LOG_VERBOSE(1) << "loaded " << model_states.size() << " model(s) in "
+                   << (NowNs() - start_ns) / NANOS_PER_MILLIS << " ms";
   }
   // Clear temporary stored agent model list after all loads are triggerred
   for (auto& info : infos_) {
@@ -711,6 +874,9 @@ ModelRepositoryManager::LoadUnloadModels(
 Status
 ModelRepositoryManager::UnloadAllModels()
 {
+  // The models must not be loaded again by requests during shutdown
+  on_demand_load_ = false;
+
   Status status;
   for (const auto& name_info : infos_) {
     Status unload_status = model_life_cycle_->AsyncUnload(name_info.first);
@@ -723,6 +889,210 @@ ModelRepositoryManager::UnloadAllModels()
   return Status::Success;
 }
 
+void
+ModelRepositoryManager::EnableOnDemandLoad(
+    const uint64_t idle_timeout_ns, const uint64_t gpu_memory_budget)
+{
+  if (!model_control_enabled_) {
+    LOG_ERROR << "loading models on demand requires model control";
+    return;
+  }
+
+  idle_unload_timeout_ns_ = idle_timeout_ns;
+  gpu_memory_budget_ = gpu_memory_budget;
+  on_demand_load_ = true;
+  if ((idle_unload_timeout_ns_ != 0) && !idle_unload_thread_.joinable()) {
+    idle_unload_thread_ = std::thread([this]() { IdleUnloadThread(); });
+  }
+}
+
+Status
+ModelRepositoryManager::LoadOnDemand(
+    const std::string& model_name, const int64_t model_version,
+    std::shared_ptr<Model>* model)
+{
+  // Join the load in flight for the model if any, otherwise start one
+  std::promise<Status> load_promise;
+  std::shared_future<Status> load;
+  bool load_owner = false;
+  {
+    std::lock_guard<std::mutex> lk(on_demand_loads_mu_);
+    auto it = on_demand_loads_.find(model_name);
+    if (it == on_demand_loads_.end()) {
+      load = load_promise.get_future().share();
+      on_demand_loads_.emplace(model_name, load);
+      load_owner = true;
+    } else {
+      load = it->second;
+    }
+  }
+
+  if (load_owner) {
+    Status status;
+    // The model may have been loaded by a request that completed its
+    // load meanwhile
+    if (!model_life_cycle_->GetModel(model_name, model_version, model)
+             .IsOk()) {
+      LOG_INFO << "loading '" << model_name << "' on demand";
+      status = LoadUnloadModel(
+          {{model_name, {}}}, ActionType::LOAD, false /* unload_dependents */);
+      if (status.IsOk()) {
+        {
+          std::lock_guard<std::mutex> lk(last_request_mu_);
+          last_request_ns_[model_name] =
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch())
+                  .count();
+        }
+        std::lock_guard<std::mutex> lock(on_demand_mu_);
+        EnforceGpuMemoryBudget(model_name);
+      }
+    }
+    load_promise.set_value(status);
+    std::lock_guard<std::mutex> lk(on_demand_loads_mu_);
+    on_demand_loads_.erase(model_name);
+  }
+
+  RETURN_IF_ERROR(load.get());
+  return model_life_cycle_->GetModel(model_name, model_version, model);
+}
+
+bool
+ModelRepositoryManager::IsLoadableOnDemand(const std::string& model_name)
+{
+  // A request can join a load on demand that is in flight
+  {
+    std::lock_guard<std::mutex> lk(on_demand_loads_mu_);
+    if (on_demand_loads_.find(model_name) != on_demand_loads_.end()) {
+      return true;
+    }
+  }
+  for (const auto& version_state :
+       model_life_cycle_->VersionStates(model_name)) {
+    if ((version_state.second.first == ModelReadyState::READY) ||
+        (version_state.second.first == ModelReadyState::LOADING)) {
+      return false;
+    }
+  }
+
+  bool exists = false;
+  const auto mapping_it = model_mappings_.find(model_name);
+  if (mapping_it != model_mappings_.end()) {
+    return FileExists(mapping_it->second.second, &exists).IsOk() && exists;
+  }
+  for (const auto& repository_path : repository_paths_) {
+    if (FileExists(JoinPath({repository_path, model_name}), &exists).IsOk() &&
+        exists) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+ModelRepositoryManager::EnforceGpuMemoryBudget(const std::string& model_name)
+{
+  if (gpu_memory_budget_ == 0) {
+    return;
+  }
+
+  // Least recently requested first
+  std::vector<std::pair<uint64_t, std::string>> lru;
+  {
+    std::lock_guard<std::mutex> lk(last_request_mu_);
+    for (const auto& last_request : last_request_ns_) {
+      lru.emplace_back(last_request.second, last_request.first);
+    }
+  }
+  std::sort(lru.begin(), lru.end());
+
+  uint64_t total_byte_size = 0;
+  std::unordered_map<std::string, uint64_t> byte_sizes;
+  for (const auto& entry : lru) {
+    const auto& name = entry.second;
+    for (const auto& version : model_life_cycle_->VersionStates(name)) {
+      std::shared_ptr<Model> model;
+      if ((version.second.first == ModelReadyState::READY) &&
+          model_life_cycle_->GetModel(name, version.first, &model).IsOk()) {
+        const uint64_t byte_size =
+            model->MemoryUsage().GetStats(TRITONSERVER_MEMORY_GPU).byte_size_;
+        byte_sizes[name] += byte_size;
+        total_byte_size += byte_size;
+      }
+    }
+  }
+
+  for (const auto& entry : lru) {
+    if (total_byte_size <= gpu_memory_budget_) {
+      break;
+    }
+    const auto& name = entry.second;
+    if (name == model_name) {
+      continue;
+    }
+    LOG_INFO << "unloading '" << name << "' as the models loaded on demand "
+             << "use " << total_byte_size << " bytes of GPU memory, over the "
+             << "budget of " << gpu_memory_budget_ << " bytes";
+    UnloadOnDemand(name);
+    total_byte_size -= byte_sizes[name];
+  }
+}
+
+void
+ModelRepositoryManager::UnloadOnDemand(const std::string& model_name)
+{
+  Status status = LoadUnloadModel(
+      {{model_name, {}}}, ActionType::UNLOAD, false /* unload_dependents */);
+  if (!status.IsOk()) {
+    LOG_ERROR << "failed to unload '" << model_name
+              << "' loaded on demand: " << status.Message();
+  }
+  std::lock_guard<std::mutex> lk(last_request_mu_);
+  last_request_ns_.erase(model_name);
+}
+
+void
+ModelRepositoryManager::IdleUnloadThread()
+{
+  const std::chrono::nanoseconds period(
+      std::min(idle_unload_timeout_ns_, NANOS_PER_SECOND));
+  std::unique_lock<std::mutex> lk(last_request_mu_);
+  while (!idle_unload_exit_) {
+    idle_unload_cv_.wait_for(lk, period);
+    if (idle_unload_exit_) {
+      break;
+    }
+
+    const uint64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    std::vector<std::string> idle_models;
+    for (const auto& last_request : last_request_ns_) {
+      if ((now_ns - last_request.second) >= idle_unload_timeout_ns_) {
+        idle_models.push_back(last_request.first);
+      }
+    }
+    lk.unlock();
+
+    for (const auto& name : idle_models) {
+      std::lock_guard<std::mutex> lock(on_demand_mu_);
+      // Skip the model if it is requested or unloaded meanwhile
+      {
+        std::lock_guard<std::mutex> last_request_lk(last_request_mu_);
+        const auto it = last_request_ns_.find(name);
+        if ((it == last_request_ns_.end()) ||
+            ((now_ns - it->second) < idle_unload_timeout_ns_)) {
+          continue;
+        }
+      }
+      LOG_INFO << "unloading '" << name << "' loaded on demand as it is idle";
+      UnloadOnDemand(name);
+    }
+    lk.lock();
+  }
+}
+
 Status
 ModelRepositoryManager::StopAllModels()
 {
@@ -832,6 +1202,23 @@ ModelRepositoryManager::GetModel(
     std::shared_ptr<Model>* model)
 {
   Status status = model_life_cycle_->GetModel(model_name, model_version, model);
+  if (on_demand_load_) {
+    if (((status.ErrorCode() == Status::Code::NOT_FOUND) ||
+         (status.ErrorCode() == Status::Code::UNAVAILABLE)) &&
+        IsLoadableOnDemand(model_name)) {
+      status = LoadOnDemand(model_name, model_version, model);
+    }
+    if (status.IsOk()) {
+      std::lock_guard<std::mutex> lk(last_request_mu_);
+      const auto it = last_request_ns_.find(model_name);
+      if (it != last_request_ns_.end()) {
+        it->second =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+      }
+    }
+  }
   if (!status.IsOk()) {
     model->reset();
     status = Status(
@@ -852,6 +1239,7 @@ ModelRepositoryManager::Poll(
   // empty path is the special case to indicate the model should be loaded
   // from override file content in 'models'.
   std::map<std::string, std::string> model_to_path;
+  subtree_mtimes_.clear();
 
   // If no model is specified, poll all models in all model repositories.
   // Otherwise, only poll the specified models
@@ -865,6 +1253,16 @@ ModelRepositoryManager::Poll(
                   << "': " << status.Message();
         *all_models_polled = false;
       } else {
+        // Index the modification times of the whole repository with a
+        // single listing if the file system supports it, so unchanged
+        // models are not walked directory by directory.
+        std::map<std::string, int64_t> mtimes;
+        if (GetSubtreeModificationTimes(repository_path, &mtimes).IsOk()) {
+          for (const auto& mtime : mtimes) {
+            subtree_mtimes_.emplace(
+                JoinPath({repository_path, mtime.first}), mtime.second);
+          }
+        }
         for (const auto& subdir : subdirs) {
           if (!model_to_path
                    .emplace(subdir, JoinPath({repository_path, subdir}))
@@ -959,14 +1357,42 @@ ModelRepositoryManager::Poll(
   }
 
   // Poll each of the models. If error happens during polling the model,
-  // its state will fallback to the state before the polling.
+  // its state will fallback to the state before the polling. Reading,
+  // normalizing and validating the configs dominates the poll of many
+  // models so the model infos are initialized concurrently, the results
+  // are then applied in the model order.
+  std::vector<const std::pair<const std::string, std::string>*> polled;
   for (const auto& pair : model_to_path) {
-    std::unique_ptr<ModelInfo> model_info;
-    const auto& mit = models.find(pair.first);
+    polled.push_back(&pair);
+  }
+  std::vector<std::unique_ptr<ModelInfo>> polled_infos(polled.size());
+  std::vector<Status> polled_status(polled.size());
+  std::atomic<size_t> next_idx(0);
+  auto poll_models = [&]() {
     static std::vector<const InferenceParameter*> empty_params;
-    auto status = InitializeModelInfo(
-        pair.first, pair.second,
-        ((mit == models.end()) ? empty_params : mit->second), &model_info);
+    for (size_t idx = next_idx++; idx < polled.size(); idx = next_idx++) {
+      const auto& mit = models.find(polled[idx]->first);
+      polled_status[idx] = InitializeModelInfo(
+          polled[idx]->first, polled[idx]->second,
+          ((mit == models.end()) ? empty_params : mit->second),
+          &polled_infos[idx]);
+    }
+  };
+  const size_t thread_count =
+      std::min(static_cast<size_t>(poll_thread_count_), polled.size());
+  std::vector<std::thread> poll_threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    poll_threads.emplace_back(poll_models);
+  }
+  poll_models();
+  for (auto& thread : poll_threads) {
+    thread.join();
+  }
+
+  for (size_t idx = 0; idx < polled.size(); ++idx) {
+    const auto& pair = *polled[idx];
+    std::unique_ptr<ModelInfo>& model_info = polled_infos[idx];
+    const Status& status = polled_status[idx];
 
     const auto& iitr = infos_.find(pair.first);
     const bool invalid_add = (!status.IsOk()) && (iitr == infos_.end());
@@ -1002,6 +1428,25 @@ ModelRepositoryManager::Poll(
   return Status::Success;
 }
 
+int64_t
+ModelRepositoryManager::ModelModifiedTime(const std::string& path)
+{
+  const auto it = subtree_mtimes_.find(path);
+  if (it != subtree_mtimes_.end()) {
+    return it->second;
+  }
+
+  std::map<std::string, int64_t> mtimes;
+  if (GetSubtreeModificationTimes(path, &mtimes).IsOk() && !mtimes.empty()) {
+    int64_t mtime = 0;
+    for (const auto& entry : mtimes) {
+      mtime = std::max(mtime, entry.second);
+    }
+    return mtime;
+  }
+  return GetModifiedTime(path);
+}
+
 bool
 ModelRepositoryManager::ModelDirectoryOverride(
     const std::vector<const InferenceParameter*>& model_params)
@@ -1065,14 +1510,11 @@ ModelRepositoryManager::InitializeModelInfo(
     linfo->agent_model_list_.reset(new TritonRepoAgentModelList());
     linfo->agent_model_list_->AddAgentModel(std::move(localize_agent_model));
   } else {
-    if (iitr == infos_.end()) {
-      linfo->mtime_nsec_ = GetModifiedTime(std::string(linfo->model_path_));
-    } else {
+    linfo->mtime_nsec_ = ModelModifiedTime(linfo->model_path_);
+    if (iitr != infos_.end()) {
       // Check the current timestamps to determine if model actually has been
       // modified
-      linfo->mtime_nsec_ = linfo->prev_mtime_ns_;
-      unmodified =
-          !IsModified(std::string(linfo->model_path_), &linfo->mtime_nsec_);
+      unmodified = (linfo->mtime_nsec_ <= linfo->prev_mtime_ns_);
     }
   }
 
@@ -1109,48 +1551,76 @@ ModelRepositoryManager::InitializeModelInfo(
     return Status::Success;
   }
 
-  // Create the associated repo agent models when a model is to be loaded,
-  // this must be done before normalizing model config as agents might
-  // redirect to use the model config at a different location
-  if (!parsed_config) {
-    const auto config_path = JoinPath({linfo->model_path_, kModelConfigPbTxt});
-    bool model_config_exists = false;
-    RETURN_IF_ERROR(FileExists(config_path, &model_config_exists));
-    // model config can be missing if auto fill is set
-    if (autofill_ && !model_config_exists) {
-      linfo->model_config_.Clear();
-    } else {
-      RETURN_IF_ERROR(ReadTextProto(config_path, &linfo->model_config_));
-      parsed_config = true;
-    }
+  // Reuse the config normalized for the same model directory content
+  // and server setup, so unmodified models skip parsing, auto-complete and
+  // validation. The configs of models with repo agents are not cached as
+  // the agents must run on every load, so a cached config has none.
+  const bool cacheable = (!parsed_config) && (linfo->mtime_nsec_ > 0);
+  uint64_t config_key = 0;
+  bool cached_config = false;
+  if (cacheable) {
+    StreamingHash64 key;
+    key.Update(server_version_);
+    key.Update(name);
+    key.Update(linfo->model_path_);
+    key.UpdateValue(linfo->mtime_nsec_);
+    key.UpdateValue(min_compute_capability_);
+    key.UpdateValue(autofill_);
+    config_key = key.Digest();
+    cached_config = ReadNormalizedConfig(
+        linfo->model_path_, config_key, &linfo->model_config_);
   }
-  if (parsed_config) {
-    RETURN_IF_ERROR(CreateAgentModelListWithLoadAction(
-        linfo->model_config_, linfo->model_path_, &linfo->agent_model_list_));
-    if (linfo->agent_model_list_ != nullptr) {
-      // Get the latest repository path
-      const char* location;
-      TRITONREPOAGENT_ArtifactType artifact_type;
-      RETURN_IF_ERROR(linfo->agent_model_list_->Back()->Location(
-          &artifact_type, &location));
-      auto latest_path = std::string(location);
-      linfo->model_path_ = latest_path;
+
+  if (!cached_config) {
+    // Create the associated repo agent models when a model is to be loaded,
+    // this must be done before normalizing model config as agents might
+    // redirect to use the model config at a different location
+    if (!parsed_config) {
+      const auto config_path =
+          JoinPath({linfo->model_path_, kModelConfigPbTxt});
+      bool model_config_exists = false;
+      RETURN_IF_ERROR(FileExists(config_path, &model_config_exists));
+      // model config can be missing if auto fill is set
+      if (autofill_ && !model_config_exists) {
+        linfo->model_config_.Clear();
+      } else {
+        RETURN_IF_ERROR(ReadTextProto(config_path, &linfo->model_config_));
+        parsed_config = true;
+      }
+    }
+    if (parsed_config) {
+      RETURN_IF_ERROR(CreateAgentModelListWithLoadAction(
+          linfo->model_config_, linfo->model_path_, &linfo->agent_model_list_));
+      if (linfo->agent_model_list_ != nullptr) {
+        // Get the latest repository path
+        const char* location;
+        TRITONREPOAGENT_ArtifactType artifact_type;
+        RETURN_IF_ERROR(linfo->agent_model_list_->Back()->Location(
+            &artifact_type, &location));
+        auto latest_path = std::string(location);
+        linfo->model_path_ = latest_path;
+      }
     }
-  }
 
-  // Try to automatically generate missing parts of the model
-  // configuration (autofill) that don't require model detail
-  RETURN_IF_ERROR(GetNormalizedModelConfig(
-      name, linfo->model_path_, min_compute_capability_,
-      &linfo->model_config_));
+    // Try to automatically generate missing parts of the model
+    // configuration (autofill) that don't require model detail
+    RETURN_IF_ERROR(GetNormalizedModelConfig(
+        name, linfo->model_path_, min_compute_capability_,
+        &linfo->model_config_));
 
-  // Note that the model inputs and outputs are not validated until
-  // the model model is intialized as they may not be auto-completed
-  // until model is intialized.
-  RETURN_IF_ERROR(
-      ValidateModelConfig(linfo->model_config_, min_compute_capability_));
-  if (!autofill_) {
-    RETURN_IF_ERROR(ValidateModelIOConfig(linfo->model_config_));
+    // Note that the model inputs and outputs are not validated until
+    // the model model is intialized as they may not be auto-completed
+    // until model is intialized.
+    RETURN_IF_ERROR(
+        ValidateModelConfig(linfo->model_config_, min_compute_capability_));
+    if (!autofill_) {
+      RETURN_IF_ERROR(ValidateModelIOConfig(linfo->model_config_));
+    }
+
+    if (cacheable && (linfo->agent_model_list_ == nullptr)) {
+      WriteNormalizedConfig(
+          linfo->model_path_, config_key, linfo->model_config_);
+    }
   }
 
   // If the model is mapped, update its config name based on the
@@ -1542,7 +2012,9 @@ ModelRepositoryManager::CheckNode(DependencyNode* node)
   // it should not be loaded
   if (node->status_.IsOk()) {
     for (auto& upstream : node->upstreams_) {
-      if (!upstream.first->checked_) {
+      // The upstream must be checked and, if it is loading, done loading
+      // before the node can be validated against its loaded versions.
+      if (!upstream.first->checked_ || upstream.first->loading_) {
         node_ready = false;
         break;
       }
@@ -26,10 +26,14 @@
 //
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <map>
 #include <mutex>
 #include <set>
+#include <thread>
 #include "infer_parameter.h"
 #include "model_config.pb.h"
 #include "model_lifecycle.h"
@@ -74,13 +78,17 @@ class ModelRepositoryManager {
   /// repository manager.
   struct DependencyNode {
     DependencyNode(const std::string& model_name)
-        : model_name_(model_name), status_(Status::Success), checked_(false)
+        : model_name_(model_name), status_(Status::Success), checked_(false),
+          loading_(false)
     {
     }
 
     std::string model_name_;
     Status status_;
     bool checked_;
+    // Whether the model is scheduled to load and the load has not
+    // completed yet, the downstreams are not checked until it completes.
+    bool loading_;
     // FIXME
     bool explicitly_load_;
     inference::ModelConfig model_config_;
@@ -140,6 +148,16 @@ class ModelRepositoryManager {
   /// \return error status.
   Status UnloadAllModels();
 
+  /// Load the models that are requested while not loaded, see GetModel().
+  /// Only supported if model control is enabled.
+  /// \param idle_timeout_ns The time after its last request that a model
+  /// loaded on demand is unloaded, 0 to keep the models loaded.
+  /// \param gpu_memory_budget The GPU memory that the models loaded on
+  /// demand may allocate before the least recently used ones are unloaded,
+  /// 0 for no limit.
+  void EnableOnDemandLoad(
+      const uint64_t idle_timeout_ns, const uint64_t gpu_memory_budget);
+
   /// Instruct all models to stop accepting new inference requests. However,
   /// the models are still capable of processing inference requests
   /// if the model considers them as part of the in-flight inference.
@@ -176,7 +194,9 @@ class ModelRepositoryManager {
   /// \return error status.
   Status RepositoryIndex(const bool ready_only, std::vector<ModelIndex>* index);
 
-  /// Obtain the specified model.
+  /// Obtain the specified model. If loading on demand is enabled, a model
+  /// that is not loaded is loaded from the model repository before it is
+  /// returned.
   /// \param model_name The name of the model.
   /// \param model_version The version of the model.
   /// \param model Return the model object.
@@ -212,7 +232,8 @@ class ModelRepositoryManager {
   ModelRepositoryManager(
       const std::set<std::string>& repository_paths, const bool autofill,
       const bool polling_enabled, const bool model_control_enabled,
-      const double min_compute_capability,
+      const double min_compute_capability, const std::string& server_version,
+      const unsigned int poll_thread_count,
       std::unique_ptr<ModelLifeCycle> life_cycle);
 
   /// The internal function that are called in Create() and PollAndUpdate().
@@ -251,6 +272,8 @@ class ModelRepositoryManager {
       ModelInfoMap* updated_infos, bool* all_models_polled);
 
   /// Helper function for Poll() to initialize ModelInfo for the model.
+  /// Called concurrently for the polled models, it must only read the
+  /// manager state.
   /// \param name The name of the model.
   /// \param path The model path. Empty path means the model is provided via
   /// 'params'
@@ -263,9 +286,42 @@ class ModelRepositoryManager {
       const std::vector<const InferenceParameter*>& params,
       std::unique_ptr<ModelInfo>* info);
 
-  /// Load models based on the dependency graph. The function will iteratively
-  /// load models that all the models they depend on has been loaded, and unload
-  /// models if their dependencies are no longer satisfied.
+  /// Helper function for Poll() to get the most recent modification time
+  /// of the files in the model directory. The index built by the current
+  /// poll is used if it covers 'path', otherwise the directory is listed.
+  /// \param path The model path.
+  /// \return The modification time in nanoseconds, 0 on error.
+  int64_t ModelModifiedTime(const std::string& path);
+
+  /// Helper function for GetModel() to load a model that is not loaded.
+  /// The concurrent requests for the same model wait for a single load.
+  Status LoadOnDemand(
+      const std::string& model_name, const int64_t model_version,
+      std::shared_ptr<Model>* model);
+
+  /// Helper function for GetModel() to check if a model can be loaded on
+  /// demand, it must be in a model repository and have no version that is
+  /// loading or ready, unless it is being loaded on demand.
+  bool IsLoadableOnDemand(const std::string& model_name);
+
+  /// Unload the least recently requested models loaded on demand, other
+  /// than 'model_name', until their GPU memory usage is within the budget.
+  /// Note that 'on_demand_mu_' should be acquired.
+  void EnforceGpuMemoryBudget(const std::string& model_name);
+
+  /// Unload a model loaded on demand. Note that 'on_demand_mu_' should be
+  /// acquired.
+  void UnloadOnDemand(const std::string& model_name);
+
+  /// Unload the models loaded on demand that are idle for longer than the
+  /// timeout.
+  void IdleUnloadThread();
+
+  /// Load models based on the dependency graph. All the models whose
+  /// dependencies are resolved are loaded concurrently, and each model
+  /// starts loading as soon as the last model it depends on finishes
+  /// loading. Models whose dependencies are no longer satisfied are
+  /// unloaded.
   /// \return The status of the model loads.
   std::map<std::string, Status> LoadModelByDependency();
 
@@ -326,10 +382,18 @@ class ModelRepositoryManager {
   const bool polling_enabled_;
   const bool model_control_enabled_;
   const double min_compute_capability_;
+  const std::string server_version_;
+  // The number of threads initializing the model infos of a poll.
+  const unsigned int poll_thread_count_;
 
   std::mutex poll_mu_;
   ModelInfoMap infos_;
 
+  // The most recent modification time of each model directory, keyed by
+  // the model path, for the repositories that could be listed at once in
+  // the current poll.
+  std::unordered_map<std::string, int64_t> subtree_mtimes_;
+
   std::unordered_map<std::string, std::unique_ptr<DependencyNode>>
       dependency_graph_;
   std::unordered_map<std::string, std::unique_ptr<DependencyNode>>
@@ -341,6 +405,24 @@ class ModelRepositoryManager {
       model_mappings_;
 
   std::unique_ptr<ModelLifeCycle> model_life_cycle_;
+
+  std::atomic<bool> on_demand_load_;
+  uint64_t idle_unload_timeout_ns_;
+  uint64_t gpu_memory_budget_;
+  // Serialize the unloads on demand.
+  std::mutex on_demand_mu_;
+  // The loads on demand in flight by model name, guarded by
+  // 'on_demand_loads_mu_'.
+  std::mutex on_demand_loads_mu_;
+  std::unordered_map<std::string, std::shared_future<Status>>
+      on_demand_loads_;
+  // Mutex for 'last_request_ns_' and 'idle_unload_exit_'
+  std::mutex last_request_mu_;
+  // The time of the last request for each model loaded on demand.
+  std::unordered_map<std::string, uint64_t> last_request_ns_;
+  std::condition_variable idle_unload_cv_;
+  bool idle_unload_exit_;
+  std::thread idle_unload_thread_;
 };
 
 }}  // namespace triton::core
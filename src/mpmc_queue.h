@@ -0,0 +1,139 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace triton { namespace core {
+
+//
+// Bounded lock-free queue for many producers and many consumers. Same
+// layout as MPSCQueue, except that consumers also claim their position
+// on the sequence number of the cell so that any thread may pop. Push()
+// and Pop() never block, they fail if the queue is full or empty
+// respectively.
+//
+template <typename T>
+class MPMCQueue {
+ public:
+  // Create a queue holding at least 'capacity' values, the capacity is
+  // rounded up to a power of two.
+  explicit MPMCQueue(const size_t capacity)
+  {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t idx = 0; idx < size; ++idx) {
+      cells_[idx].sequence_.store(idx, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  // Push 'value' into the queue. Return false and leave 'value' untouched
+  // if the queue is full.
+  bool Push(T& value)
+  {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value_ = std::move(value);
+    cell->sequence_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pop the oldest published value into 'value'. Return false if there is
+  // no published value.
+  bool Pop(T* value)
+  {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    *value = std::move(cell->value_);
+    cell->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence_;
+    T value_;
+  };
+
+  // Padding keeps the producer and consumer positions on separate cache
+  // lines
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> dequeue_pos_;
+};
+
+}}  // namespace triton::core
@@ -29,8 +29,14 @@
 #include <numa.h>
 #include <numaif.h>
 #endif
+#include <algorithm>
+#include <fstream>
 #include "triton/common/logging.h"
 
+#ifdef TRITON_ENABLE_GPU
+#include <cuda_runtime_api.h>
+#endif  // TRITON_ENABLE_GPU
+
 namespace triton { namespace core {
 
 namespace {
@@ -98,6 +104,14 @@ SetNumaThreadAffinity(
 {
   return Status::Success;
 }
+
+Status
+AddGpuNumaHostPolicy(
+    const int32_t device_id,
+    triton::common::HostPolicyCmdlineConfig* host_policy)
+{
+  return Status::Success;
+}
 #else
 // Use variable to make sure no NUMA related function is actually called
 // if Triton is not running with NUMA awareness. i.e. Extra docker permission
@@ -232,6 +246,67 @@ SetNumaThreadAffinity(
   }
   return Status::Success;
 }
+
+Status
+AddGpuNumaHostPolicy(
+    const int32_t device_id,
+    triton::common::HostPolicyCmdlineConfig* host_policy)
+{
+#ifdef TRITON_ENABLE_GPU
+  char bus_id[32];
+  if (cudaDeviceGetPCIBusId(bus_id, sizeof(bus_id), device_id) !=
+      cudaSuccess) {
+    LOG_VERBOSE(1) << "Unable to get PCI bus ID of GPU " << device_id
+                   << ", NUMA placement is not applied";
+    return Status::Success;
+  }
+  std::string device_path(bus_id);
+  std::transform(
+      device_path.begin(), device_path.end(), device_path.begin(),
+      [](unsigned char c) { return std::tolower(c); });
+  device_path = "/sys/bus/pci/devices/" + device_path;
+
+  // A negative node means the platform doesn't report the device locality
+  int node_id = -1;
+  std::string cpu_list;
+  {
+    std::ifstream node_file(device_path + "/numa_node");
+    std::ifstream cpu_file(device_path + "/local_cpulist");
+    if (!(node_file >> node_id) || !(cpu_file >> cpu_list) || (node_id < 0)) {
+      LOG_VERBOSE(1) << "NUMA locality of GPU " << device_id
+                     << " is not available, NUMA placement is not applied";
+      return Status::Success;
+    }
+  }
+
+  // 'cpu-cores' expects ranges, convert the single CPUs of the list, i.e.
+  // "0-7,9" to "0-7,9-9".
+  std::string cpu_cores;
+  size_t current_pos = 0;
+  while (current_pos < cpu_list.size()) {
+    size_t delim_pos = cpu_list.find(",", current_pos);
+    if (delim_pos == std::string::npos) {
+      delim_pos = cpu_list.size();
+    }
+    const std::string range =
+        cpu_list.substr(current_pos, delim_pos - current_pos);
+    if (!cpu_cores.empty()) {
+      cpu_cores += ",";
+    }
+    cpu_cores += (range.find("-") == std::string::npos)
+                     ? (range + "-" + range)
+                     : range;
+    current_pos = delim_pos + 1;
+  }
+
+  LOG_VERBOSE(1) << "GPU " << device_id << " is local to NUMA node " << node_id
+                 << " with CPUs " << cpu_cores;
+  (*host_policy)["numa-node"] = std::to_string(node_id);
+  (*host_policy)["cpu-cores"] = cpu_cores;
+#endif  // TRITON_ENABLE_GPU
+
+  return Status::Success;
+}
 #endif
 
 }}  // namespace triton::core
@@ -53,5 +53,12 @@ Status SetNumaThreadAffinity(
     std::thread::native_handle_type thread,
     const triton::common::HostPolicyCmdlineConfig& host_policy);
 
+// Add 'numa-node' and 'cpu-cores' settings for the NUMA node closest to
+// GPU 'device_id', as reported by the PCIe topology, to 'host_policy'.
+// 'host_policy' is left unchanged if the topology is not available.
+Status AddGpuNumaHostPolicy(
+    const int32_t device_id,
+    triton::common::HostPolicyCmdlineConfig* host_policy);
+
 
 }}  // namespace triton::core
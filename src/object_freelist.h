@@ -0,0 +1,82 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "mpmc_queue.h"
+
+namespace triton { namespace core {
+
+//
+// Bounded freelist of shared objects that can be used by many threads
+// without locking. An object may still be referenced by its last user
+// when it is returned, Get() only hands out objects that are no longer
+// referenced elsewhere. Both Get() and Put() are constant time, Get()
+// checks the oldest object only and Put() drops the object if the
+// freelist is full.
+//
+template <typename T>
+class SharedObjectFreelist {
+ public:
+  // Create a freelist holding at least 'capacity' objects, no object is
+  // kept if 'capacity' is 0.
+  explicit SharedObjectFreelist(const size_t capacity)
+      : enabled_(capacity > 0), objects_(capacity)
+  {
+  }
+
+  // Return in 'object' an object for reuse. Return false and leave
+  // 'object' empty if no object is available.
+  bool Get(std::shared_ptr<T>* object)
+  {
+    if (!enabled_ || !objects_.Pop(object)) {
+      return false;
+    }
+    if (object->use_count() != 1) {
+      objects_.Push(*object);
+      object->reset();
+      return false;
+    }
+    return true;
+  }
+
+  // Return 'object' to the freelist, 'object' is moved from unless the
+  // freelist is full.
+  void Put(std::shared_ptr<T>& object)
+  {
+    if (enabled_) {
+      objects_.Push(object);
+    }
+  }
+
+ private:
+  const bool enabled_;
+  MPMCQueue<std::shared_ptr<T>> objects_;
+};
+
+}}  // namespace triton::core
@@ -32,9 +32,14 @@ Payload::Payload()
     : op_type_(Operation::INFER_RUN),
       requests_(std::vector<std::unique_ptr<InferenceRequest>>()),
       OnCallback_([]() {}), instance_(nullptr), state_(State::UNINITIALIZED),
-      batcher_start_ns_(0), saturated_(false)
+      batcher_start_ns_(0), oldest_enqueue_ns_(0), closest_timeout_ns_(0),
+      scheduled_ns_(0), saturated_(false)
 {
   exec_mu_.reset(new std::mutex());
+#ifdef TRITON_ENABLE_TRACING
+  traced_.store(false, std::memory_order_relaxed);
+  trace_activity_count_ = 0;
+#endif  // TRITON_ENABLE_TRACING
 }
 
 Status
@@ -58,9 +63,19 @@ Payload::MergePayload(std::shared_ptr<Payload>& payload)
         "Attempted to merge payloads that are not in executing state");
   }
 
+#ifdef TRITON_ENABLE_TRACING
+  // The payloads may have recorded different activities, the caller holds
+  // the exec mutex of both.
+  FlushTraceActivities();
+  payload->FlushTraceActivities();
+  if (payload->traced_.load(std::memory_order_relaxed)) {
+    traced_.store(true, std::memory_order_relaxed);
+  }
+#endif  // TRITON_ENABLE_TRACING
   requests_.insert(
       requests_.end(), std::make_move_iterator(payload->Requests().begin()),
       std::make_move_iterator(payload->Requests().end()));
+  UpdateDeadline(payload->OldestEnqueueNs(), payload->ClosestTimeoutNs());
 
   payload->Callback();
 
@@ -76,9 +91,16 @@ Payload::Reset(const Operation op_type, TritonModelInstance* instance)
   release_callbacks_.clear();
   instance_ = instance;
   state_ = State::UNINITIALIZED;
-  status_.reset(new std::promise<Status>());
+  status_.Reset();
   batcher_start_ns_ = 0;
+  oldest_enqueue_ns_ = 0;
+  closest_timeout_ns_ = 0;
+  scheduled_ns_ = 0;
   saturated_ = false;
+#ifdef TRITON_ENABLE_TRACING
+  traced_.store(false, std::memory_order_relaxed);
+  trace_activity_count_ = 0;
+#endif  // TRITON_ENABLE_TRACING
 }
 
 void
@@ -91,7 +113,29 @@ Payload::Release()
   instance_ = nullptr;
   state_ = State::RELEASED;
   batcher_start_ns_ = 0;
+  oldest_enqueue_ns_ = 0;
+  closest_timeout_ns_ = 0;
+  scheduled_ns_ = 0;
   saturated_ = false;
+#ifdef TRITON_ENABLE_TRACING
+  traced_.store(false, std::memory_order_relaxed);
+  trace_activity_count_ = 0;
+#endif  // TRITON_ENABLE_TRACING
+}
+
+void
+Payload::UpdateDeadline(
+    const uint64_t oldest_enqueue_ns, const uint64_t closest_timeout_ns)
+{
+  if ((oldest_enqueue_ns != 0) &&
+      ((oldest_enqueue_ns_ == 0) || (oldest_enqueue_ns < oldest_enqueue_ns_))) {
+    oldest_enqueue_ns_ = oldest_enqueue_ns;
+  }
+  if ((closest_timeout_ns != 0) &&
+      ((closest_timeout_ns_ == 0) ||
+       (closest_timeout_ns < closest_timeout_ns_))) {
+    closest_timeout_ns_ = closest_timeout_ns;
+  }
 }
 
 size_t
@@ -117,9 +161,59 @@ Payload::AddRequest(std::unique_ptr<InferenceRequest> request)
       (batcher_start_ns_ > request->BatcherStartNs())) {
     batcher_start_ns_ = request->BatcherStartNs();
   }
+#ifdef TRITON_ENABLE_TRACING
+  if (request->Trace() != nullptr) {
+    traced_.store(true, std::memory_order_relaxed);
+  }
+#endif  // TRITON_ENABLE_TRACING
   requests_.push_back(std::move(request));
 }
 
+void
+Payload::ReportTraceActivity(const TRITONSERVER_InferenceTraceActivity activity)
+{
+#ifdef TRITON_ENABLE_TRACING
+  // The stages reporting the activities hand the payload over to each
+  // other so only the requests, which the batcher may still add to, need
+  // the exec mutex.
+  if (!traced_.load(std::memory_order_relaxed) ||
+      (trace_activity_count_ == kMaxTraceActivities)) {
+    return;
+  }
+  const uint64_t timestamp_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  trace_activities_[trace_activity_count_++] =
+      std::make_pair(activity, timestamp_ns);
+#endif  // TRITON_ENABLE_TRACING
+}
+
+#ifdef TRITON_ENABLE_TRACING
+void
+Payload::FlushTraceActivities()
+{
+  if (trace_activity_count_ == 0) {
+    return;
+  }
+  const uint64_t batch_size = BatchSize();
+  for (const auto& request : requests_) {
+    const auto& trace = request->Trace();
+    if (trace == nullptr) {
+      continue;
+    }
+    for (size_t idx = 0; idx < trace_activity_count_; ++idx) {
+      const auto& activity = trace_activities_[idx];
+      if (activity.first == TRITONSERVER_TRACE_BATCH_FORMED) {
+        trace->SetBatchSize(batch_size);
+      }
+      trace->Report(activity.first, activity.second);
+    }
+  }
+  trace_activity_count_ = 0;
+}
+#endif  // TRITON_ENABLE_TRACING
+
 void
 Payload::SetCallback(std::function<void()> OnCallback)
 {
@@ -153,7 +247,7 @@ Payload::SetState(Payload::State state)
 Status
 Payload::Wait()
 {
-  return status_->get_future().get();
+  return status_.Wait();
 }
 
 void
@@ -182,6 +276,13 @@ Payload::Execute(bool* should_exit)
   Status status;
   switch (op_type_) {
     case Operation::INFER_RUN:
+#ifdef TRITON_ENABLE_TRACING
+      ReportTraceActivity(TRITONSERVER_TRACE_BACKEND_DEQUEUE);
+      if (trace_activity_count_ != 0) {
+        std::lock_guard<std::mutex> exec_lock(*exec_mu_);
+        FlushTraceActivities();
+      }
+#endif  // TRITON_ENABLE_TRACING
       instance_->Schedule(std::move(requests_), OnCallback_);
       break;
     case Operation::INIT:
@@ -194,7 +295,7 @@ Payload::Execute(bool* should_exit)
       *should_exit = true;
   }
 
-  status_->set_value(status);
+  status_.Complete(status);
 }
 
 }}  // namespace triton::core
@@ -25,14 +25,16 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <functional>
-#include <future>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
 #include <vector>
 
 #include "backend_model_instance.h"
+#include "completion.h"
 #include "infer_request.h"
 #include "status.h"
 
@@ -64,6 +66,19 @@ class Payload {
     return requests_;
   }
   uint64_t BatcherStartNs() { return batcher_start_ns_; }
+  // Record the oldest enqueue time and closest timeout of the requests
+  // added to the payload, a value of 0 means unknown.
+  void UpdateDeadline(
+      const uint64_t oldest_enqueue_ns, const uint64_t closest_timeout_ns);
+  uint64_t OldestEnqueueNs() { return oldest_enqueue_ns_; }
+  uint64_t ClosestTimeoutNs() { return closest_timeout_ns_; }
+  // The time the payload was scheduled for execution, only recorded when
+  // the rate limiter hedges the payloads of the model.
+  void SetScheduledNs(const uint64_t scheduled_ns)
+  {
+    scheduled_ns_ = scheduled_ns;
+  }
+  uint64_t ScheduledNs() { return scheduled_ns_; }
   void SetCallback(std::function<void()> OnCallback);
   void Callback();
   void AddInternalReleaseCallback(std::function<void()>&& callback);
@@ -73,6 +88,13 @@ class Payload {
   void MarkSaturated();
   bool IsSaturated() { return saturated_; }
 
+  // Report trace 'activity' at the current time for all the requests
+  // in the payload. The activity is only recorded on the payload and
+  // reported to the traces once the requests of the payload are final,
+  // when the payload is executed or merged, so that the payload is locked
+  // once. A TRITONSERVER_TRACE_BATCH_FORMED activity also records the
+  // batch size of the payload in the traces.
+  void ReportTraceActivity(const TRITONSERVER_InferenceTraceActivity activity);
 
   State GetState() { return state_; }
   void SetState(State state);
@@ -87,11 +109,30 @@ class Payload {
   std::vector<std::function<void()>> release_callbacks_;
   TritonModelInstance* instance_;
   State state_;
-  std::unique_ptr<std::promise<Status>> status_;
+  // Completed once the payload is executed, no allocation or locking is
+  // involved unless there is a waiter.
+  Completion<Status> status_;
   std::unique_ptr<std::mutex> exec_mu_;
   uint64_t batcher_start_ns_;
+  uint64_t oldest_enqueue_ns_;
+  uint64_t closest_timeout_ns_;
+  uint64_t scheduled_ns_;
 
   bool saturated_;
+
+#ifdef TRITON_ENABLE_TRACING
+  // Report the recorded activities to the traces of the requests, must be
+  // called with 'exec_mu_' held.
+  void FlushTraceActivities();
+
+  // Whether any request of the payload is traced, set by the batcher
+  // while the activities may be recorded by the rate limiter.
+  std::atomic<bool> traced_;
+  static constexpr size_t kMaxTraceActivities = 8;
+  std::pair<TRITONSERVER_InferenceTraceActivity, uint64_t>
+      trace_activities_[kMaxTraceActivities];
+  size_t trace_activity_count_;
+#endif  // TRITON_ENABLE_TRACING
 };
 
 }}  // namespace triton::core
@@ -27,7 +27,9 @@
 
 #include "pinned_memory_manager.h"
 
+#include <algorithm>
 #include <sstream>
+#include "host_memory.h"
 #include "numa_utils.h"
 #include "triton/common/logging.h"
 
@@ -61,24 +63,187 @@ ParseIntOption(const std::string& msg, const std::string& arg, int* value)
   return Status::Success;
 }
 
+// Allocations up to 256 KB are served by power of two size classes
+// starting at 256 bytes, from 2 MB slabs. Small pools don't use slabs as
+// they would be taken up by a few size classes.
+constexpr int kMinChunkShift = 8;
+constexpr int kSlabClassCount = 11;
+constexpr int kSlabShift = 21;
+constexpr uint64_t kSlabByteSize = uint64_t{1} << kSlabShift;
+constexpr uint64_t kMinSlabPoolByteSize = 16 * kSlabByteSize;
+
+// A thread caches at most 1 MB or 64 chunks per size class, and takes
+// chunks from the shared lists by batches of up to 8.
+constexpr uint64_t kMaxCachedByteSize = uint64_t{1} << 20;
+constexpr size_t kMaxCachedChunkCount = 64;
+constexpr size_t kRefillChunkCount = 8;
+
+uint64_t
+ChunkByteSize(const int size_class)
+{
+  return uint64_t{1} << (kMinChunkShift + size_class);
+}
+
+// Return the smallest size class holding 'size' bytes, -1 if too large.
+int
+SizeClass(const uint64_t size)
+{
+  if (size > ChunkByteSize(kSlabClassCount - 1)) {
+    return -1;
+  }
+  int size_class = 0;
+  while (ChunkByteSize(size_class) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+// Extents are a quarter of the initial pool, rounded up to whole slabs,
+// or larger if needed by the allocation. 'kExtentReserveByteSize' covers
+// the bookkeeping of the managed buffer.
+constexpr uint64_t kExtentReserveByteSize = 4096;
+
+uint64_t
+ExtentByteSize(const uint64_t pool_byte_size, const uint64_t alloc_byte_size)
+{
+  const uint64_t byte_size = std::max(
+      pool_byte_size / 4, alloc_byte_size + kExtentReserveByteSize);
+  return ((byte_size + kSlabByteSize - 1) / kSlabByteSize) * kSlabByteSize;
+}
+
+size_t
+MaxCachedChunkCount(const int size_class)
+{
+  return std::max(
+      size_t{2}, std::min(
+                     kMaxCachedChunkCount,
+                     static_cast<size_t>(
+                         kMaxCachedByteSize / ChunkByteSize(size_class))));
+}
+
 }  // namespace
 
 std::unique_ptr<PinnedMemoryManager> PinnedMemoryManager::instance_;
 uint64_t PinnedMemoryManager::pinned_memory_byte_size_;
+thread_local PinnedMemoryManager::SlabCache PinnedMemoryManager::slab_cache_;
 
 PinnedMemoryManager::PinnedMemory::PinnedMemory(
-    void* pinned_memory_buffer, uint64_t size)
-    : pinned_memory_buffer_(pinned_memory_buffer)
+    void* pinned_memory_buffer, uint64_t size, uint64_t max_size)
+    : pinned_memory_buffer_(pinned_memory_buffer), byte_size_(size),
+      registered_byte_size_(size), max_byte_size_(std::max(size, max_size)),
+      first_slab_index_(0),
+      slab_index_count_(0), max_slab_byte_size_(0),
+      free_chunks_(kSlabClassCount), hit_count_(0), miss_count_(0),
+      reserved_byte_size_(0), in_use_byte_size_(0)
 {
   if (pinned_memory_buffer_ != nullptr) {
     managed_pinned_memory_ = boost::interprocess::managed_external_buffer(
         boost::interprocess::create_only_t{}, pinned_memory_buffer_, size);
+    if (size >= kMinSlabPoolByteSize) {
+      const uintptr_t begin =
+          reinterpret_cast<uintptr_t>(pinned_memory_buffer_);
+      first_slab_index_ = begin >> kSlabShift;
+      slab_index_count_ =
+          ((begin + size - 1) >> kSlabShift) - first_slab_index_ + 1;
+      slab_classes_.reset(new std::atomic<int>[slab_index_count_]);
+      for (size_t idx = 0; idx < slab_index_count_; ++idx) {
+        slab_classes_[idx].store(-1, std::memory_order_relaxed);
+      }
+      max_slab_byte_size_ = size / 4;
+    }
+  }
+}
+
+int
+PinnedMemoryManager::PinnedMemory::SlabClass(void* ptr) const
+{
+  if (slab_classes_ == nullptr) {
+    return -1;
+  }
+  const uintptr_t index = reinterpret_cast<uintptr_t>(ptr) >> kSlabShift;
+  if ((index < first_slab_index_) ||
+      (index - first_slab_index_ >= slab_index_count_)) {
+    return -1;
+  }
+  return slab_classes_[index - first_slab_index_].load(
+      std::memory_order_acquire);
+}
+
+bool
+PinnedMemoryManager::PinnedMemory::TakeChunks(
+    const int size_class, const size_t count, std::vector<void*>* chunks)
+{
+  std::lock_guard<std::mutex> lk(slab_mtx_);
+  auto& free_chunks = free_chunks_[size_class];
+  if (free_chunks.empty()) {
+    if (reserved_byte_size_ + kSlabByteSize > max_slab_byte_size_) {
+      return false;
+    }
+    void* slab = nullptr;
+    {
+      std::lock_guard<std::mutex> buffer_lk(buffer_mtx_);
+      slab = managed_pinned_memory_.allocate_aligned(
+          kSlabByteSize, kSlabByteSize, std::nothrow_t{});
+    }
+    if (slab == nullptr) {
+      return false;
+    }
+    slab_classes_
+        [(reinterpret_cast<uintptr_t>(slab) >> kSlabShift) - first_slab_index_]
+            .store(size_class, std::memory_order_release);
+    reserved_byte_size_ += kSlabByteSize;
+    LOG_VERBOSE(1) << "pinned memory slab allocation: chunk size "
+                   << ChunkByteSize(size_class) << ", addr " << slab;
+
+    const uint64_t chunk_byte_size = ChunkByteSize(size_class);
+    char* base = reinterpret_cast<char*>(slab);
+    for (uint64_t offset = kSlabByteSize; offset > 0;) {
+      offset -= chunk_byte_size;
+      free_chunks.push_back(base + offset);
+    }
+  }
+
+  const size_t take_count = std::min(count, free_chunks.size());
+  chunks->insert(
+      chunks->end(), free_chunks.end() - take_count, free_chunks.end());
+  free_chunks.resize(free_chunks.size() - take_count);
+  return true;
+}
+
+void
+PinnedMemoryManager::PinnedMemory::ReturnChunks(
+    const int size_class, std::vector<void*>* chunks)
+{
+  std::lock_guard<std::mutex> lk(slab_mtx_);
+  auto& free_chunks = free_chunks_[size_class];
+  free_chunks.insert(free_chunks.end(), chunks->begin(), chunks->end());
+  chunks->clear();
+}
+
+PinnedMemoryManager::SlabCache::~SlabCache()
+{
+  Flush();
+}
+
+void
+PinnedMemoryManager::SlabCache::Flush()
+{
+  auto owner = owner_.lock();
+  for (size_t size_class = 0; size_class < chunks_.size(); ++size_class) {
+    if ((owner != nullptr) && !chunks_[size_class].empty()) {
+      owner->ReturnChunks(size_class, &chunks_[size_class]);
+    }
+    // The chunks of a destroyed pool are simply dropped.
+    chunks_[size_class].clear();
   }
+  owner_raw_ = nullptr;
+  owner_.reset();
 }
 
 
 PinnedMemoryManager::PinnedMemory::~PinnedMemory()
 {
+  extents_.clear();
 #ifdef TRITON_ENABLE_GPU
   if (pinned_memory_buffer_ != nullptr) {
     cudaFreeHost(pinned_memory_buffer_);
@@ -86,6 +251,128 @@ PinnedMemoryManager::PinnedMemory::~PinnedMemory()
 #endif  // TRITON_ENABLE_GPU
 }
 
+PinnedMemoryManager::PinnedMemory::Extent::Extent(void* base, uint64_t size)
+    : base_(reinterpret_cast<char*>(base)), size_(size),
+      managed_memory_(boost::interprocess::create_only_t{}, base_, size_)
+{
+}
+
+PinnedMemoryManager::PinnedMemory::Extent::~Extent()
+{
+#ifdef TRITON_ENABLE_GPU
+  cudaHostUnregister(base_);
+#endif  // TRITON_ENABLE_GPU
+  free(base_);
+}
+
+void*
+PinnedMemoryManager::PinnedMemory::Allocate(uint64_t size)
+{
+  {
+    std::lock_guard<std::mutex> lk(buffer_mtx_);
+    void* ptr = managed_pinned_memory_.allocate(size, std::nothrow_t{});
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    for (auto& extent : extents_) {
+      ptr = extent->managed_memory_.allocate(size, std::nothrow_t{});
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
+  }
+  return Grow(size);
+}
+
+void*
+PinnedMemoryManager::PinnedMemory::Grow(uint64_t size)
+{
+#ifndef TRITON_ENABLE_GPU
+  return nullptr;
+#else
+  const uint64_t extent_byte_size = ExtentByteSize(byte_size_, size);
+  {
+    std::lock_guard<std::mutex> lk(buffer_mtx_);
+    if (registered_byte_size_ + extent_byte_size > max_byte_size_) {
+      return nullptr;
+    }
+    registered_byte_size_ += extent_byte_size;
+  }
+
+  // Register the extent without holding the lock as it may take a while,
+  // other allocations go on with the memory already available.
+  void* base = HostAlloc(extent_byte_size);
+  cudaError_t err = cudaSuccess;
+  if (base != nullptr) {
+    err = cudaHostRegister(base, extent_byte_size, cudaHostRegisterPortable);
+    if (err != cudaSuccess) {
+      free(base);
+      base = nullptr;
+    }
+  }
+
+  std::lock_guard<std::mutex> lk(buffer_mtx_);
+  if (base == nullptr) {
+    registered_byte_size_ -= extent_byte_size;
+    LOG_WARNING << "Unable to grow pinned memory pool by " << extent_byte_size
+                << " bytes"
+                << ((err != cudaSuccess)
+                        ? (": " + std::string(cudaGetErrorString(err)))
+                        : std::string());
+    return nullptr;
+  }
+  extents_.emplace_back(new Extent(base, extent_byte_size));
+  LOG_VERBOSE(1) << "pinned memory pool extent is registered at '"
+                 << PointerToString(base) << "' with size "
+                 << extent_byte_size;
+  return extents_.back()->managed_memory_.allocate(size, std::nothrow_t{});
+#endif  // TRITON_ENABLE_GPU
+}
+
+void
+PinnedMemoryManager::PinnedMemory::Deallocate(void* ptr)
+{
+  std::unique_ptr<Extent> released_extent;
+  {
+    std::lock_guard<std::mutex> lk(buffer_mtx_);
+    char* cptr = reinterpret_cast<char*>(ptr);
+    char* buffer = reinterpret_cast<char*>(pinned_memory_buffer_);
+    if ((cptr >= buffer) && (cptr < buffer + byte_size_)) {
+      managed_pinned_memory_.deallocate(ptr);
+      return;
+    }
+
+    for (auto it = extents_.begin(); it != extents_.end(); ++it) {
+      auto& extent = *it;
+      if ((cptr < extent->base_) || (cptr >= extent->base_ + extent->size_)) {
+        continue;
+      }
+      extent->managed_memory_.deallocate(ptr);
+      if (extent->managed_memory_.all_memory_deallocated()) {
+        size_t unused_count = 0;
+        for (const auto& other : extents_) {
+          if (other->managed_memory_.all_memory_deallocated()) {
+            ++unused_count;
+          }
+        }
+        if (unused_count > 1) {
+          registered_byte_size_ -= extent->size_;
+          released_extent = std::move(extent);
+          extents_.erase(it);
+        }
+      }
+      break;
+    }
+  }
+
+  // The extent is unregistered when 'released_extent' goes out of scope,
+  // outside of the lock.
+  if (released_extent != nullptr) {
+    LOG_VERBOSE(1) << "pinned memory pool extent is released at '"
+                   << PointerToString(released_extent->base_) << "'";
+  }
+}
+
 PinnedMemoryManager::~PinnedMemoryManager()
 {
   // Clean up
@@ -105,16 +392,94 @@ PinnedMemoryManager::AddPinnedMemoryBuffer(
   pinned_memory_buffers_[node_mask] = pinned_memory_buffer;
 }
 
+bool
+PinnedMemoryManager::AllocSlabChunk(
+    void** ptr, uint64_t size,
+    const std::shared_ptr<PinnedMemory>& pinned_memory_buffer)
+{
+  const int size_class = SizeClass(size);
+  if ((size_class < 0) || (pinned_memory_buffer->slab_classes_ == nullptr)) {
+    return false;
+  }
+
+  auto& cache = slab_cache_;
+  if ((cache.owner_raw_ != pinned_memory_buffer.get()) ||
+      cache.owner_.expired()) {
+    cache.Flush();
+    cache.owner_raw_ = pinned_memory_buffer.get();
+    cache.owner_ = pinned_memory_buffer;
+    cache.chunks_.resize(kSlabClassCount);
+  }
+
+  auto& chunks = cache.chunks_[size_class];
+  if (chunks.empty()) {
+    pinned_memory_buffer->miss_count_.fetch_add(1, std::memory_order_relaxed);
+    if (!pinned_memory_buffer->TakeChunks(
+            size_class,
+            std::min(kRefillChunkCount, MaxCachedChunkCount(size_class) / 2),
+            &chunks)) {
+      return false;
+    }
+  } else {
+    pinned_memory_buffer->hit_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  *ptr = chunks.back();
+  chunks.pop_back();
+  pinned_memory_buffer->in_use_byte_size_.fetch_add(
+      ChunkByteSize(size_class), std::memory_order_relaxed);
+  return true;
+}
+
+bool
+PinnedMemoryManager::FreeSlabChunk(void* ptr)
+{
+  for (const auto& buffer : pinned_memory_buffers_) {
+    const auto& pinned_memory_buffer = buffer.second;
+    const int size_class = pinned_memory_buffer->SlabClass(ptr);
+    if (size_class < 0) {
+      continue;
+    }
+    pinned_memory_buffer->in_use_byte_size_.fetch_sub(
+        ChunkByteSize(size_class), std::memory_order_relaxed);
+
+    auto& cache = slab_cache_;
+    if ((cache.owner_raw_ != pinned_memory_buffer.get()) ||
+        cache.owner_.expired()) {
+      std::vector<void*> chunks{ptr};
+      pinned_memory_buffer->ReturnChunks(size_class, &chunks);
+      return true;
+    }
+
+    auto& chunks = cache.chunks_[size_class];
+    chunks.push_back(ptr);
+    const size_t max_count = MaxCachedChunkCount(size_class);
+    if (chunks.size() > max_count) {
+      std::vector<void*> excess_chunks(
+          chunks.begin() + max_count / 2, chunks.end());
+      chunks.resize(max_count / 2);
+      pinned_memory_buffer->ReturnChunks(size_class, &excess_chunks);
+    }
+    return true;
+  }
+  return false;
+}
+
 Status
 PinnedMemoryManager::AllocInternal(
     void** ptr, uint64_t size, TRITONSERVER_MemoryType* allocated_type,
-    bool allow_nonpinned_fallback, PinnedMemory* pinned_memory_buffer)
+    bool allow_nonpinned_fallback,
+    const std::shared_ptr<PinnedMemory>& pinned_memory_buffer)
 {
   auto status = Status::Success;
   if (pinned_memory_buffer->pinned_memory_buffer_ != nullptr) {
-    std::lock_guard<std::mutex> lk(pinned_memory_buffer->buffer_mtx_);
-    *ptr = pinned_memory_buffer->managed_pinned_memory_.allocate(
-        size, std::nothrow_t{});
+    // Small allocations are served by the slabs, without locking in the
+    // common case.
+    if (AllocSlabChunk(ptr, size, pinned_memory_buffer)) {
+      *allocated_type = TRITONSERVER_MEMORY_CPU_PINNED;
+      return Status::Success;
+    }
+    *ptr = pinned_memory_buffer->Allocate(size);
     *allocated_type = TRITONSERVER_MEMORY_CPU_PINNED;
     if (*ptr == nullptr) {
       status = Status(
@@ -134,9 +499,10 @@ PinnedMemoryManager::AllocInternal(
                   << ", falling back to non-pinned system memory";
       warning_logged = true;
     }
-    *ptr = malloc(size);
+    *ptr = HostAlloc(size);
     *allocated_type = TRITONSERVER_MEMORY_CPU;
     is_pinned = false;
+    fallback_count_.fetch_add(1, std::memory_order_relaxed);
     if (*ptr == nullptr) {
       status = Status(
           Status::Code::INTERNAL,
@@ -151,7 +517,7 @@ PinnedMemoryManager::AllocInternal(
     std::lock_guard<std::mutex> lk(info_mtx_);
     if (status.IsOk()) {
       auto res = memory_info_.emplace(
-          *ptr, std::make_pair(is_pinned, pinned_memory_buffer));
+          *ptr, std::make_pair(is_pinned, pinned_memory_buffer.get()));
       if (!res.second) {
         status = Status(
             Status::Code::INTERNAL, "unexpected memory address collision, '" +
@@ -166,8 +532,7 @@ PinnedMemoryManager::AllocInternal(
 
   if ((!status.IsOk()) && (*ptr != nullptr)) {
     if (is_pinned) {
-      std::lock_guard<std::mutex> lk(pinned_memory_buffer->buffer_mtx_);
-      pinned_memory_buffer->managed_pinned_memory_.deallocate(*ptr);
+      pinned_memory_buffer->Deallocate(*ptr);
     } else {
       free(*ptr);
     }
@@ -179,6 +544,10 @@ PinnedMemoryManager::AllocInternal(
 Status
 PinnedMemoryManager::FreeInternal(void* ptr)
 {
+  if (FreeSlabChunk(ptr)) {
+    return Status::Success;
+  }
+
   bool is_pinned = true;
   PinnedMemory* pinned_memory_buffer = nullptr;
   {
@@ -200,8 +569,7 @@ PinnedMemoryManager::FreeInternal(void* ptr)
   }
 
   if (is_pinned) {
-    std::lock_guard<std::mutex> lk(pinned_memory_buffer->buffer_mtx_);
-    pinned_memory_buffer->managed_pinned_memory_.deallocate(ptr);
+    pinned_memory_buffer->Deallocate(ptr);
   } else {
     free(ptr);
   }
@@ -245,8 +613,9 @@ PinnedMemoryManager::Create(const Options& options)
     }
 #endif  // TRITON_ENABLE_GPU
     instance_->AddPinnedMemoryBuffer(
-        std::shared_ptr<PinnedMemory>(
-            new PinnedMemory(buffer, options.pinned_memory_pool_byte_size_)),
+        std::shared_ptr<PinnedMemory>(new PinnedMemory(
+            buffer, options.pinned_memory_pool_byte_size_,
+            options.pinned_memory_pool_max_byte_size_)),
         0);
   } else {
     // Create only one buffer / manager should be created for one node,
@@ -297,8 +666,9 @@ PinnedMemoryManager::Create(const Options& options)
 #endif  // TRITON_ENABLE_GPU
       ResetNumaMemoryPolicy();
       instance_->AddPinnedMemoryBuffer(
-          std::shared_ptr<PinnedMemory>(
-              new PinnedMemory(buffer, options.pinned_memory_pool_byte_size_)),
+          std::shared_ptr<PinnedMemory>(new PinnedMemory(
+              buffer, options.pinned_memory_pool_byte_size_,
+              options.pinned_memory_pool_max_byte_size_)),
           node_mask);
     }
     // If no pinned memory is allocated, add an empty entry where all allocation
@@ -324,21 +694,21 @@ PinnedMemoryManager::Alloc(
         Status::Code::UNAVAILABLE, "PinnedMemoryManager has not been created");
   }
 
-  auto pinned_memory_buffer =
-      instance_->pinned_memory_buffers_.begin()->second.get();
+  const std::shared_ptr<PinnedMemory>* pinned_memory_buffer =
+      &instance_->pinned_memory_buffers_.begin()->second;
   if (instance_->pinned_memory_buffers_.size() > 1) {
     unsigned long node_mask;
     if (GetNumaMemoryPolicyNodeMask(&node_mask).IsOk()) {
       auto it = instance_->pinned_memory_buffers_.find(node_mask);
       if (it != instance_->pinned_memory_buffers_.end()) {
-        pinned_memory_buffer = it->second.get();
+        pinned_memory_buffer = &it->second;
       }
     }
   }
 
   return instance_->AllocInternal(
       ptr, size, allocated_type, allow_nonpinned_fallback,
-      pinned_memory_buffer);
+      *pinned_memory_buffer);
 }
 
 Status
@@ -352,4 +722,43 @@ PinnedMemoryManager::Free(void* ptr)
   return instance_->FreeInternal(ptr);
 }
 
+void
+PinnedMemoryManager::GetSlabStats(SlabStats* stats)
+{
+  *stats = SlabStats();
+  if (instance_ == nullptr) {
+    return;
+  }
+  for (const auto& buffer : instance_->pinned_memory_buffers_) {
+    const auto& pinned_memory_buffer = buffer.second;
+    stats->hit_count_ += pinned_memory_buffer->hit_count_.load();
+    stats->miss_count_ += pinned_memory_buffer->miss_count_.load();
+    stats->reserved_byte_size_ +=
+        pinned_memory_buffer->reserved_byte_size_.load();
+    stats->in_use_byte_size_ += pinned_memory_buffer->in_use_byte_size_.load();
+  }
+}
+
+void
+PinnedMemoryManager::GetPoolStats(PoolStats* stats)
+{
+  *stats = PoolStats();
+  if (instance_ == nullptr) {
+    return;
+  }
+  for (const auto& buffer : instance_->pinned_memory_buffers_) {
+    const auto& pinned_memory_buffer = buffer.second;
+    if (pinned_memory_buffer->pinned_memory_buffer_ == nullptr) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lk(pinned_memory_buffer->buffer_mtx_);
+    stats->byte_size_ += pinned_memory_buffer->byte_size_;
+    for (const auto& extent : pinned_memory_buffer->extents_) {
+      stats->byte_size_ += extent->size_;
+    }
+    stats->extent_count_ += pinned_memory_buffer->extents_.size();
+  }
+  stats->fallback_count_ = instance_->fallback_count_.load();
+}
+
 }}  // namespace triton::core
@@ -26,10 +26,12 @@
 //
 #pragma once
 
+#include <atomic>
 #include <boost/interprocess/managed_external_buffer.hpp>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 #include "status.h"
 #include "triton/common/model_config.h"
 
@@ -44,13 +46,19 @@ class PinnedMemoryManager {
   struct Options {
     Options(
         uint64_t b = 0,
-        const triton::common::HostPolicyCmdlineConfigMap& host_policy_map = {})
-        : pinned_memory_pool_byte_size_(b), host_policy_map_(host_policy_map)
+        const triton::common::HostPolicyCmdlineConfigMap& host_policy_map = {},
+        uint64_t max_b = 0)
+        : pinned_memory_pool_byte_size_(b), host_policy_map_(host_policy_map),
+          pinned_memory_pool_max_byte_size_(max_b)
     {
     }
 
     uint64_t pinned_memory_pool_byte_size_;
     triton::common::HostPolicyCmdlineConfigMap host_policy_map_;
+    // The size each pool may grow to by registering additional host
+    // memory once it is exhausted. The pool doesn't grow if it is not
+    // larger than 'pinned_memory_pool_byte_size_'.
+    uint64_t pinned_memory_pool_max_byte_size_;
   };
 
   ~PinnedMemoryManager();
@@ -72,6 +80,43 @@ class PinnedMemoryManager {
   // Return Status object indicating success or failure.
   static Status Free(void* ptr);
 
+  // Statistics of the size-class slab caches serving small allocations.
+  struct SlabStats {
+    SlabStats()
+        : hit_count_(0), miss_count_(0), reserved_byte_size_(0),
+          in_use_byte_size_(0)
+    {
+    }
+
+    // The number of allocations served from the cache of the thread and
+    // the number of allocations that had to go to the shared chunk lists
+    // or carve a new slab.
+    uint64_t hit_count_;
+    uint64_t miss_count_;
+    // The bytes carved into slabs and the bytes of the chunks currently
+    // allocated from them, the difference is cached but unused.
+    uint64_t reserved_byte_size_;
+    uint64_t in_use_byte_size_;
+  };
+
+  // Return the slab cache statistics summed over all pinned memory pools.
+  static void GetSlabStats(SlabStats* stats);
+
+  // Statistics of the size of the pinned memory pools.
+  struct PoolStats {
+    PoolStats() : byte_size_(0), extent_count_(0), fallback_count_(0) {}
+
+    // The pinned memory currently held, including the extents
+    // registered after creation.
+    uint64_t byte_size_;
+    uint64_t extent_count_;
+    // The number of allocations that fell back to non-pinned memory.
+    uint64_t fallback_count_;
+  };
+
+  // Return the statistics summed over all pinned memory pools.
+  static void GetPoolStats(PoolStats* stats);
+
  protected:
   // Provide explicit control on the lifecycle of the CUDA memory manager,
   // for testing only.
@@ -80,25 +125,102 @@ class PinnedMemoryManager {
  private:
   class PinnedMemory {
    public:
-    PinnedMemory(void* pinned_memory_buffer, uint64_t size);
+    PinnedMemory(
+        void* pinned_memory_buffer, uint64_t size, uint64_t max_size = 0);
     ~PinnedMemory();
+
+    // Allocate 'size' bytes from the pool, registering a new extent if
+    // the pool is exhausted and may still grow. Return nullptr on failure.
+    void* Allocate(uint64_t size);
+    // Release 'ptr' allocated by Allocate(). Extents left unused are
+    // released, except one kept to absorb the next burst.
+    void Deallocate(void* ptr);
+
+    // Return the size class of the slab chunk 'ptr', -1 if 'ptr' is not
+    // allocated from a slab of this pool.
+    int SlabClass(void* ptr) const;
+    // Return in 'chunks' up to 'count' chunks of size class 'size_class',
+    // carving a new slab if needed. Return false if no chunk is available.
+    bool TakeChunks(
+        const int size_class, const size_t count, std::vector<void*>* chunks);
+    // Return 'chunks' of size class 'size_class' to the shared lists.
+    void ReturnChunks(const int size_class, std::vector<void*>* chunks);
+
+    // Host memory registered as pinned after the pool is created.
+    struct Extent {
+      Extent(void* base, uint64_t size);
+      ~Extent();
+
+      char* base_;
+      uint64_t size_;
+      boost::interprocess::managed_external_buffer managed_memory_;
+    };
+
+    void* Grow(uint64_t size);
+
     void* pinned_memory_buffer_;
+    uint64_t byte_size_;
     std::mutex buffer_mtx_;
     boost::interprocess::managed_external_buffer managed_pinned_memory_;
+
+    // Protected by 'buffer_mtx_'. 'registered_byte_size_' accounts the
+    // pool and the extents, including the ones being registered, and is
+    // bounded by 'max_byte_size_'.
+    std::vector<std::unique_ptr<Extent>> extents_;
+    uint64_t registered_byte_size_;
+    uint64_t max_byte_size_;
+
+    // Slabs are aligned to their size so the slab holding a chunk is
+    // found from its address. 'slab_classes_' holds the size class of
+    // each slab-sized region of the pool, -1 if it is not a slab. Slabs
+    // are never returned to the managed buffer and their total size is
+    // capped to 'max_slab_byte_size_'.
+    uintptr_t first_slab_index_;
+    size_t slab_index_count_;
+    std::unique_ptr<std::atomic<int>[]> slab_classes_;
+    uint64_t max_slab_byte_size_;
+
+    std::mutex slab_mtx_;
+    std::vector<std::vector<void*>> free_chunks_;
+
+    std::atomic<uint64_t> hit_count_;
+    std::atomic<uint64_t> miss_count_;
+    std::atomic<uint64_t> reserved_byte_size_;
+    std::atomic<uint64_t> in_use_byte_size_;
+  };
+
+  // Per-thread cache of slab chunks from one pinned memory pool.
+  struct SlabCache {
+    ~SlabCache();
+    void Flush();
+
+    // 'owner_raw_' avoids touching the reference count of the owner on
+    // every allocation, 'owner_' tells whether it is still alive.
+    PinnedMemory* owner_raw_ = nullptr;
+    std::weak_ptr<PinnedMemory> owner_;
+    std::vector<std::vector<void*>> chunks_;
   };
 
   PinnedMemoryManager() = default;
 
   Status AllocInternal(
       void** ptr, uint64_t size, TRITONSERVER_MemoryType* allocated_type,
-      bool allow_nonpinned_fallback, PinnedMemory* pinned_memory_buffer);
+      bool allow_nonpinned_fallback,
+      const std::shared_ptr<PinnedMemory>& pinned_memory_buffer);
   Status FreeInternal(void* ptr);
+  bool AllocSlabChunk(
+      void** ptr, uint64_t size,
+      const std::shared_ptr<PinnedMemory>& pinned_memory_buffer);
+  bool FreeSlabChunk(void* ptr);
   void AddPinnedMemoryBuffer(
       const std::shared_ptr<PinnedMemory>& pinned_memory_buffer,
       unsigned long node_mask);
 
   static std::unique_ptr<PinnedMemoryManager> instance_;
   static uint64_t pinned_memory_byte_size_;
+  static thread_local SlabCache slab_cache_;
+
+  std::atomic<uint64_t> fallback_count_{0};
 
   std::mutex info_mtx_;
   std::map<void*, std::pair<bool, PinnedMemory*>> memory_info_;
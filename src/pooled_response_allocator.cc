@@ -0,0 +1,166 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "pooled_response_allocator.h"
+
+#include <cstdlib>
+#include "host_memory.h"
+#include "pinned_memory_manager.h"
+#include "status.h"
+#include "triton/common/logging.h"
+
+#ifdef TRITON_ENABLE_GPU
+#include "cuda_memory_manager.h"
+#endif  // TRITON_ENABLE_GPU
+
+namespace triton { namespace core {
+
+ResponseAllocator*
+PooledResponseAllocator::Create()
+{
+  ResponseAllocator* allocator = new ResponseAllocator(
+      &PooledResponseAllocator::Alloc, &PooledResponseAllocator::Release,
+      nullptr /* start_fn */);
+  allocator->SetQueryFunction(&PooledResponseAllocator::Query);
+  return allocator;
+}
+
+TRITONSERVER_Error*
+PooledResponseAllocator::Alloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id, void* userp, void** buffer, void** buffer_userp,
+    TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *buffer = nullptr;
+  *buffer_userp = nullptr;
+  *actual_memory_type = memory_type;
+  *actual_memory_type_id = memory_type_id;
+
+  // Don't need to do anything if no memory was requested.
+  if (byte_size == 0) {
+    return nullptr;  // success
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    Status status = CudaMemoryManager::Alloc(buffer, byte_size, memory_type_id);
+    if (status.IsOk()) {
+      return nullptr;  // success
+    }
+    LOG_VERBOSE(1) << "failed to allocate " << byte_size
+                   << " bytes of GPU memory for output '" << tensor_name
+                   << "' on device " << memory_type_id << ": "
+                   << status.Message() << ", using host memory";
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return AllocHost(
+      byte_size, buffer, actual_memory_type, actual_memory_type_id);
+}
+
+TRITONSERVER_Error*
+PooledResponseAllocator::AllocHost(
+    size_t byte_size, void** buffer,
+    TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *actual_memory_type_id = 0;
+
+#ifdef TRITON_ENABLE_GPU
+  // Pinned memory is returned for CPU requests too, it is served from
+  // the slabs and makes a later copy to the device faster. The pinned
+  // memory manager falls back to system memory and tracks which
+  // buffers it did so for.
+  Status status = PinnedMemoryManager::Alloc(
+      buffer, byte_size, actual_memory_type,
+      true /* allow_nonpinned_fallback */);
+  if (!status.IsOk()) {
+    *buffer = nullptr;
+    return TRITONSERVER_ErrorNew(
+        StatusCodeToTritonCode(status.StatusCode()), status.Message().c_str());
+  }
+#else
+  *buffer = HostAlloc(byte_size);
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  if (*buffer == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNAVAILABLE, "CPU memory allocation failed");
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+PooledResponseAllocator::Release(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  if (buffer == nullptr) {
+    return nullptr;  // success
+  }
+
+  Status status;
+#ifdef TRITON_ENABLE_GPU
+  if (memory_type == TRITONSERVER_MEMORY_GPU) {
+    status = CudaMemoryManager::Free(buffer, memory_type_id);
+  } else {
+    status = PinnedMemoryManager::Free(buffer);
+  }
+#else
+  free(buffer);
+#endif  // TRITON_ENABLE_GPU
+
+  if (!status.IsOk()) {
+    return TRITONSERVER_ErrorNew(
+        StatusCodeToTritonCode(status.StatusCode()), status.Message().c_str());
+  }
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+PooledResponseAllocator::Query(
+    TRITONSERVER_ResponseAllocator* allocator, void* userp,
+    const char* tensor_name, size_t* byte_size,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  // Every memory type is served, but GPU memory only in GPU builds.
+#ifdef TRITON_ENABLE_GPU
+  if (*memory_type != TRITONSERVER_MEMORY_GPU) {
+    *memory_type = TRITONSERVER_MEMORY_CPU_PINNED;
+    *memory_type_id = 0;
+  }
+#else
+  *memory_type = TRITONSERVER_MEMORY_CPU;
+  *memory_type_id = 0;
+#endif  // TRITON_ENABLE_GPU
+  return nullptr;  // success
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,96 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "precision_convert.h"
+
+#include <cstring>
+
+namespace triton { namespace core {
+
+// The conversions are computed on the bits of the values with selects
+// instead of branches so that the compiler vectorizes the loops for the
+// SIMD instructions of the target.
+
+void
+FloatToHalf(const float* src, const size_t count, uint16_t* dst)
+{
+  // Adding this value as a float aligns the mantissa of the values below
+  // the normal half precision range to the subnormal half mantissa,
+  // rounding it to nearest even.
+  constexpr uint32_t kDenormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+  float denorm_magic;
+  std::memcpy(&denorm_magic, &kDenormMagic, sizeof(denorm_magic));
+
+  for (size_t idx = 0; idx < count; ++idx) {
+    uint32_t bits;
+    std::memcpy(&bits, &src[idx], sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7fffffff;
+
+    // Values that overflow, and infinities and NaN values
+    const uint32_t special = 0x7c00 | ((uint32_t)(bits > 0x7f800000) << 9);
+
+    // Values below the normal half precision range
+    float magnitude;
+    std::memcpy(&magnitude, &bits, sizeof(magnitude));
+    const float denorm = magnitude + denorm_magic;
+    uint32_t denorm_bits;
+    std::memcpy(&denorm_bits, &denorm, sizeof(denorm_bits));
+    const uint32_t subnormal = denorm_bits - kDenormMagic;
+
+    // Normal values, rebias the exponent and round the mantissa to nearest
+    // even
+    const uint32_t odd = (bits >> 13) & 1;
+    const uint32_t normal =
+        (bits + (static_cast<uint32_t>(15 - 127) << 23) + 0xfff + odd) >> 13;
+
+    // Select the result with masks, which the compiler doesn't turn into
+    // branches
+    const uint32_t is_special =
+        0u - (uint32_t)(bits >= (uint32_t)((127 + 16) << 23));
+    const uint32_t is_subnormal = 0u - (uint32_t)(bits < (uint32_t)(113 << 23));
+    const uint32_t half =
+        (special & is_special) |
+        (subnormal & is_subnormal & ~is_special) |
+        (normal & ~is_subnormal & ~is_special);
+    dst[idx] = static_cast<uint16_t>(half | sign);
+  }
+}
+
+void
+FloatToBFloat16(const float* src, const size_t count, uint16_t* dst)
+{
+  for (size_t idx = 0; idx < count; ++idx) {
+    uint32_t bits;
+    std::memcpy(&bits, &src[idx], sizeof(bits));
+    const uint32_t rounded = (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+    // Rounding must not turn a NaN into an infinity, the NaN is quieted
+    const uint32_t nan = (bits >> 16) | 0x40;
+    dst[idx] = static_cast<uint16_t>(
+        ((bits & 0x7fffffff) > 0x7f800000) ? nan : rounded);
+  }
+}
+
+}}  // namespace triton::core
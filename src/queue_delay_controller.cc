@@ -0,0 +1,150 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "queue_delay_controller.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace triton { namespace core {
+
+namespace {
+
+// Weight of a new observation in the smoothed statistics.
+constexpr double kSmoothingFactor = 0.2;
+
+// Fraction of a batch size's throughput that the arrival rate may use
+// for the batch size to be considered able to keep up.
+constexpr double kTargetUtilization = 0.8;
+
+double
+Smooth(const double current, const double observed)
+{
+  return (kSmoothingFactor * observed) + ((1 - kSmoothingFactor) * current);
+}
+
+}  // namespace
+
+QueueDelayController::QueueDelayController(
+    const uint64_t latency_slo_ns, const uint64_t max_delay_ns,
+    const uint64_t initial_delay_ns, const size_t max_batch_size)
+    : latency_slo_ns_(latency_slo_ns), max_delay_ns_(max_delay_ns),
+      max_batch_size_(std::max((size_t)1, max_batch_size)),
+      delay_ns_(std::min(initial_delay_ns, max_delay_ns)), arrival_rate_(-1)
+{
+}
+
+void
+QueueDelayController::RecordArrivals(
+    const uint64_t request_count, const uint64_t duration_ns)
+{
+  if (duration_ns == 0) {
+    return;
+  }
+  const double rate = (double)request_count / duration_ns;
+  arrival_rate_ = (arrival_rate_ < 0) ? rate : Smooth(arrival_rate_, rate);
+}
+
+void
+QueueDelayController::RecordExecutions(
+    const size_t batch_size, const uint64_t execution_count,
+    const uint64_t duration_ns)
+{
+  if ((batch_size == 0) || (execution_count == 0)) {
+    return;
+  }
+  const double latency = (double)duration_ns / execution_count;
+  auto it = execution_ns_.find(batch_size);
+  if (it == execution_ns_.end()) {
+    execution_ns_.emplace(batch_size, latency);
+  } else {
+    it->second = Smooth(it->second, latency);
+  }
+}
+
+double
+QueueDelayController::ExecutionNs(const size_t batch_size) const
+{
+  if (execution_ns_.empty()) {
+    return 0;
+  }
+
+  // Batch sizes larger than any observed are assumed to scale linearly
+  // with the largest one, smaller ones to be no faster than the smallest.
+  auto upper = execution_ns_.lower_bound(batch_size);
+  if (upper == execution_ns_.end()) {
+    const auto& largest = *execution_ns_.rbegin();
+    return largest.second * batch_size / largest.first;
+  }
+  if ((upper->first == batch_size) || (upper == execution_ns_.begin())) {
+    return upper->second;
+  }
+
+  // Interpolate between the closest observed batch sizes
+  auto lower = std::prev(upper);
+  const double fraction =
+      (double)(batch_size - lower->first) / (upper->first - lower->first);
+  return lower->second + (fraction * (upper->second - lower->second));
+}
+
+uint64_t
+QueueDelayController::Update()
+{
+  // Keep the current delay until both the arrival rate and some
+  // execution latency has been observed.
+  if ((arrival_rate_ <= 0) || execution_ns_.empty()) {
+    return delay_ns_;
+  }
+
+  double best_delay_ns = -1;
+  double best_throughput = 0;
+  for (size_t batch_size = 1; batch_size <= max_batch_size_; ++batch_size) {
+    // The first request of the batch waits for the remaining requests
+    // to arrive.
+    const double delay_ns = (batch_size - 1) / arrival_rate_;
+    if (delay_ns > max_delay_ns_) {
+      break;
+    }
+    const double execution_ns = ExecutionNs(batch_size);
+    if ((delay_ns + execution_ns) > latency_slo_ns_) {
+      break;
+    }
+
+    const double throughput = batch_size / execution_ns;
+    if ((best_delay_ns < 0) || (throughput > best_throughput)) {
+      best_delay_ns = delay_ns;
+      best_throughput = throughput;
+    }
+    if ((throughput * kTargetUtilization) >= arrival_rate_) {
+      best_delay_ns = delay_ns;
+      break;
+    }
+  }
+
+  delay_ns_ = (best_delay_ns < 0) ? 0 : (uint64_t)best_delay_ns;
+  return delay_ns_;
+}
+
+}}  // namespace triton::core
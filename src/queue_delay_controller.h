@@ -0,0 +1,88 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace triton { namespace core {
+
+//
+// Controller that picks the maximum queue delay of a dynamic batcher
+// online. The controller is given the observed request arrival rate and
+// the execution latency of the batch sizes that were executed, and
+// chooses the smallest batch size expected to keep up with the arrival
+// rate while the time spent collecting the batch plus its execution
+// latency stays within the latency SLO. If no batch size keeps up, the
+// batch size with the highest throughput within the SLO is used. The
+// queue delay is the expected time to collect that batch.
+//
+// The controller is not thread-safe.
+//
+class QueueDelayController {
+ public:
+  // 'latency_slo_ns' is the target latency of a request, 'max_delay_ns'
+  // caps the chosen delay and 'initial_delay_ns' is used until enough
+  // statistics are observed.
+  QueueDelayController(
+      const uint64_t latency_slo_ns, const uint64_t max_delay_ns,
+      const uint64_t initial_delay_ns, const size_t max_batch_size);
+
+  // Record that 'request_count' requests arrived over 'duration_ns'.
+  void RecordArrivals(const uint64_t request_count, const uint64_t duration_ns);
+
+  // Record 'execution_count' executions of 'batch_size' that took
+  // 'duration_ns' in total.
+  void RecordExecutions(
+      const size_t batch_size, const uint64_t execution_count,
+      const uint64_t duration_ns);
+
+  // Recompute and return the queue delay from the recorded statistics.
+  uint64_t Update();
+
+  uint64_t DelayNs() const { return delay_ns_; }
+
+ private:
+  // Return the expected execution latency of 'batch_size', or 0 if it
+  // can't be estimated.
+  double ExecutionNs(const size_t batch_size) const;
+
+  const double latency_slo_ns_;
+  const uint64_t max_delay_ns_;
+  const size_t max_batch_size_;
+  uint64_t delay_ns_;
+
+  // Smoothed arrival rate in requests per nanosecond, negative if not
+  // observed yet.
+  double arrival_rate_;
+
+  // Smoothed execution latency, in nanoseconds, of each observed batch
+  // size.
+  std::map<size_t, double> execution_ns_;
+};
+
+}}  // namespace triton::core
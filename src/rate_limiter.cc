@@ -26,12 +26,82 @@
 
 #include "rate_limiter.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "model_config_utils.h"
 #include "triton/common/logging.h"
 
 namespace triton { namespace core {
 
 constexpr size_t MAX_PAYLOAD_BUCKET_COUNT = 1000;
 
+namespace {
+
+// Model config parameter that lets an idle instance of the model take
+// over the payloads scheduled for another instance once they have waited
+// longer than the given percentile of the recent waits of the payloads of
+// the model. Only the dedicated backend threads watch for stalled
+// payloads while they wait. The pooled backend threads look for them
+// only when they run, i.e. when a payload is scheduled for one of their
+// instances, as nothing schedules them when a payload stalls.
+constexpr char kHedgePercentileParameter[] = "rate_limiter_hedge_percentile";
+
+// Model config parameter that sets the minimum wait, in microseconds,
+// before a payload is taken over.
+constexpr char kHedgeMinDelayParameter[] =
+    "rate_limiter_hedge_min_delay_microseconds";
+constexpr uint64_t kDefaultHedgeMinDelayUs = 1000;
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Status
+CreateHedgePolicy(
+    const inference::ModelConfig& config, std::unique_ptr<HedgePolicy>* hedge)
+{
+  uint64_t percentile;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kHedgePercentileParameter, 0 /* default_value */,
+      &percentile));
+  if (percentile == 0) {
+    return Status::Success;
+  }
+  if (percentile > 100) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model '" + config.name() + "' parameter '" +
+            kHedgePercentileParameter + "' must be in [0, 100], got " +
+            std::to_string(percentile));
+  }
+  // The instances of a sequence model hold the state of the sequences
+  // assigned to them.
+  if (config.has_sequence_batching()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "model '" + config.name() + "' parameter '" +
+            kHedgePercentileParameter +
+            "' is not supported with sequence batching");
+  }
+  uint64_t min_delay_us;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kHedgeMinDelayParameter, kDefaultHedgeMinDelayUs,
+      &min_delay_us));
+  hedge->reset(new HedgePolicy(
+      percentile, std::max(min_delay_us, uint64_t{1}) * 1000));
+  return Status::Success;
+}
+
+}  // namespace
+
 //=========================================================================
 //  Core Implementation
 //=========================================================================
@@ -39,11 +109,12 @@ constexpr size_t MAX_PAYLOAD_BUCKET_COUNT = 1000;
 Status
 RateLimiter::Create(
     const bool ignore_resources_and_priority,
+    const bool earliest_deadline_first,
     const RateLimiter::ResourceMap& resource_map,
     std::unique_ptr<RateLimiter>* rate_limiter)
 {
-  std::unique_ptr<RateLimiter> local_rate_limiter(
-      new RateLimiter(ignore_resources_and_priority, resource_map));
+  std::unique_ptr<RateLimiter> local_rate_limiter(new RateLimiter(
+      ignore_resources_and_priority, earliest_deadline_first, resource_map));
   *rate_limiter = std::move(local_rate_limiter);
 
   return Status::Success;
@@ -74,9 +145,11 @@ RateLimiter::RegisterModelInstance(
       resource_manager_->AddModelInstance(model_instances.back().get());
       RETURN_IF_ERROR(resource_manager_->UpdateResourceLimits());
     }
-  }
 
-  InitializePayloadQueues(triton_model_instance);
+    // Within the lock as the instances of a model may be registered
+    // concurrently.
+    RETURN_IF_ERROR(InitializePayloadQueues(triton_model_instance));
+  }
 
   return Status::Success;
 }
@@ -98,7 +171,14 @@ RateLimiter::UnregisterModel(const TritonModel* model)
       }
     }
 
+    if (!ignore_resources_and_priority_) {
+      for (const auto& instance : removed_instance_ctxs_[model]) {
+        resource_manager_->RemoveModelInstance(instance.get());
+      }
+    }
+
     model_instance_ctxs_.erase(model);
+    removed_instance_ctxs_.erase(model);
     model_contexts_.erase(model);
   }
 
@@ -113,6 +193,95 @@ RateLimiter::UnregisterModel(const TritonModel* model)
   return Status::Success;
 }
 
+Status
+RateLimiter::RemoveModelInstance(
+    TritonModelInstance* triton_model_instance, bool* removed)
+{
+  *removed = false;
+  const TritonModel* model = triton_model_instance->Model();
+  {
+    std::lock_guard<std::mutex> lk1(model_ctx_mtx_);
+    std::lock_guard<std::mutex> lk2(model_instance_ctx_mtx_);
+
+    auto ctx_it = model_contexts_.find(model);
+    if (ctx_it == model_contexts_.end()) {
+      return Status(
+          Status::Code::INTERNAL,
+          "Requested model is not yet registered with rate limiter");
+    }
+    auto& model_instances = model_instance_ctxs_[model];
+    auto instance_it = std::find_if(
+        model_instances.begin(), model_instances.end(),
+        [triton_model_instance](
+            const std::shared_ptr<ModelInstanceContext>& instance) {
+          return instance->RawInstance() == triton_model_instance;
+        });
+    if (instance_it == model_instances.end()) {
+      return Status(
+          Status::Code::INTERNAL,
+          "Requested model instance is not registered with rate limiter");
+    }
+    if (!ctx_it->second.RemoveAvailableInstance(instance_it->get())) {
+      return Status::Success;
+    }
+
+    // The context is kept until the instance is released, the instance
+    // may still be finishing its last payload.
+    removed_instance_ctxs_[model].push_back(std::move(*instance_it));
+    model_instances.erase(instance_it);
+  }
+
+  PayloadQueue* payload_queue = payload_queues_[model].get();
+  {
+    std::lock_guard<std::mutex> lk(payload_queue->mu_);
+    payload_queue->removed_instances_.insert(triton_model_instance);
+  }
+  *removed = true;
+
+  return Status::Success;
+}
+
+void
+RateLimiter::ReleaseModelInstance(const TritonModelInstance* instance)
+{
+  const TritonModel* model = instance->Model();
+  bool released = false;
+  {
+    std::lock_guard<std::mutex> lk1(model_ctx_mtx_);
+    std::lock_guard<std::mutex> lk2(model_instance_ctx_mtx_);
+    auto removed_it = removed_instance_ctxs_.find(model);
+    if (removed_it != removed_instance_ctxs_.end()) {
+      auto& removed_ctxs = removed_it->second;
+      auto ctx_it = std::find_if(
+          removed_ctxs.begin(), removed_ctxs.end(),
+          [instance](const std::shared_ptr<ModelInstanceContext>& ctx) {
+            return ctx->RawInstance() == instance;
+          });
+      if (ctx_it != removed_ctxs.end()) {
+        if (!ignore_resources_and_priority_) {
+          resource_manager_->RemoveModelInstance(ctx_it->get());
+        }
+        removed_ctxs.erase(ctx_it);
+        released = true;
+      }
+    }
+  }
+  if (released && !ignore_resources_and_priority_) {
+    LOG_STATUS_ERROR(
+        resource_manager_->UpdateResourceLimits(),
+        "failed updating resource limits after releasing instance");
+  }
+
+  auto queue_it = payload_queues_.find(model);
+  if (queue_it == payload_queues_.end()) {
+    return;
+  }
+  PayloadQueue* payload_queue = queue_it->second.get();
+  std::lock_guard<std::mutex> lk(payload_queue->mu_);
+  payload_queue->specific_queues_.erase(instance);
+  payload_queue->removed_instances_.erase(instance);
+}
+
 bool
 RateLimiter::PayloadSlotAvailable(const TritonModel* model)
 {
@@ -135,19 +304,23 @@ RateLimiter::EnqueuePayload(
     LOG_INFO << "Should not print this ";
   }
   PayloadQueue* payload_queue = payload_queues_[model].get();
+  payload->ReportTraceActivity(TRITONSERVER_TRACE_RATE_LIMITER_ENQUEUE);
+  bool direct_schedule = ignore_resources_and_priority_;
   {
     std::lock_guard<std::mutex> lk(payload_queue->mu_);
     payload->SetState(Payload::State::REQUESTED);
-    if (ignore_resources_and_priority_) {
+    // A removed instance is no longer allocated by the rate limiter so
+    // the exit payload of its backend thread is scheduled directly.
+    direct_schedule |=
+        ((pinstance != nullptr) &&
+         (payload_queue->removed_instances_.find(pinstance) !=
+          payload_queue->removed_instances_.end()));
+    if (direct_schedule) {
       SchedulePayload(pinstance, payload_queue, payload);
     }
   }
-  if (ignore_resources_and_priority_) {
-    if (pinstance == nullptr) {
-      payload_queue->cv_.notify_one();
-    } else {
-      payload_queue->cv_.notify_all();
-    }
+  if (direct_schedule) {
+    NotifyPayloadScheduled(pinstance, payload_queue);
   } else {
     StandardScheduleFunc sched_func = [this, payload_queue,
                                        payload](ModelInstanceContext* mi) {
@@ -157,65 +330,304 @@ RateLimiter::EnqueuePayload(
       }
       auto cb = [mi]() { mi->Release(); };
       payload->AddInternalReleaseCallback(cb);
-      if (mi->RawInstance() == nullptr) {
-        payload_queue->cv_.notify_one();
-      } else {
-        payload_queue->cv_.notify_all();
-      }
+      this->NotifyPayloadScheduled(mi->RawInstance(), payload_queue);
     };
-    DeferPayloadSchedule(sched_func, model, payload->GetInstance());
+    DeferPayloadSchedule(
+        SchedRequest{
+            sched_func, payload->OldestEnqueueNs(),
+            payload->ClosestTimeoutNs()},
+        model, payload->GetInstance());
   }
   return Status::Success;
 }
 
 void
-RateLimiter::DequeuePayload(
+RateLimiter::DequeuePayloads(
     std::deque<TritonModelInstance*>& instances,
-    std::shared_ptr<Payload>* payload)
+    const size_t max_payload_count, const uint64_t spin_ns,
+    std::vector<std::shared_ptr<Payload>>* payloads)
 {
-  payload->reset();
+  payloads->clear();
   if (payload_queues_.find(instances[0]->Model()) == payload_queues_.end()) {
     LOG_INFO << "Should not print this ";
   }
   PayloadQueue* payload_queue = payload_queues_[instances[0]->Model()].get();
+
+  // Poll for a payload for a short time before blocking on the condition
+  // variable, the payload may be for other instances in which case the
+  // thread blocks as usual.
+  payload_queue->waiting_count_++;
+  if (spin_ns > 0) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::nanoseconds(spin_ns);
+    while ((payload_queue->scheduled_count_.load(std::memory_order_relaxed) ==
+            0) &&
+           (std::chrono::steady_clock::now() < deadline)) {
+      std::this_thread::yield();
+    }
+  }
+
   std::vector<std::shared_ptr<Payload>> merged_payloads;
-  size_t instance_index;
   {
     std::unique_lock<std::mutex> lk(payload_queue->mu_);
-    payload_queue->cv_.wait(lk, [&instances, &instance_index, payload_queue]() {
-      bool empty = payload_queue->queue_->Empty();
-      if (empty) {
-        instance_index = 0;
-        for (const auto instance : instances) {
-          empty = payload_queue->specific_queues_[instance]->Empty();
-          if (empty) {
-            instance_index++;
-          } else {
-            break;
-          }
+    size_t instance_index;
+    InstanceQueue* stalled_queue;
+    uint64_t stall_delay_ns;
+    auto ready = [this, &instance_index, &stalled_queue, &stall_delay_ns,
+                  &instances, payload_queue]() {
+      stalled_queue = nullptr;
+      stall_delay_ns = std::numeric_limits<uint64_t>::max();
+      instance_index = FindReadyInstance(payload_queue, instances);
+      if ((instance_index < instances.size()) ||
+          !payload_queue->queue_->Empty()) {
+        return true;
+      }
+      stalled_queue = FindStalledQueue(payload_queue, &stall_delay_ns);
+      return (stalled_queue != nullptr);
+    };
+    if (payload_queue->hedge_ == nullptr) {
+      payload_queue->cv_.wait(lk, ready);
+    } else {
+      // Nothing is notified when a payload in the queue of another
+      // instance becomes stalled, so wake up when the oldest of them may
+      // stall. Scheduling a payload for an instance notifies every
+      // waiting thread, so the thread blocks while none is queued.
+      while (!ready()) {
+        if (stall_delay_ns == std::numeric_limits<uint64_t>::max()) {
+          payload_queue->cv_.wait(lk);
+        } else {
+          payload_queue->cv_.wait_for(
+              lk, std::chrono::nanoseconds(stall_delay_ns));
         }
       }
-      return !empty;
-    });
-    if (instance_index < instances.size()) {
-      TritonModelInstance* instance = instances[instance_index];
-      if (!payload_queue->specific_queues_[instance]->Empty()) {
-        payload_queue->specific_queues_[instance]->Dequeue(
-            payload, &merged_payloads);
+    }
+    payload_queue->waiting_count_--;
+    if (stalled_queue != nullptr) {
+      TakeStalledPayload(
+          payload_queue, stalled_queue, instances, payloads, &merged_payloads);
+    } else {
+      TakeReadyPayloads(
+          payload_queue, instance_index, instances, max_payload_count,
+          true /* take_more_generic */, payloads, &merged_payloads);
+    }
+  }
+  FinishDequeue(payloads, &merged_payloads);
+}
+
+bool
+RateLimiter::TryDequeuePayloads(
+    std::deque<TritonModelInstance*>& instances,
+    const size_t max_payload_count,
+    std::vector<std::shared_ptr<Payload>>* payloads)
+{
+  payloads->clear();
+  PayloadQueue* payload_queue = payload_queues_[instances[0]->Model()].get();
+  if (payload_queue->scheduled_count_.load() == 0) {
+    return false;
+  }
+
+  std::vector<std::shared_ptr<Payload>> merged_payloads;
+  {
+    std::lock_guard<std::mutex> lk(payload_queue->mu_);
+    const size_t instance_index = FindReadyInstance(payload_queue, instances);
+    if ((instance_index == instances.size()) &&
+        payload_queue->queue_->Empty()) {
+      InstanceQueue* stalled_queue = FindStalledQueue(payload_queue);
+      if (stalled_queue == nullptr) {
+        return false;
       }
+      TakeStalledPayload(
+          payload_queue, stalled_queue, instances, payloads, &merged_payloads);
     } else {
-      payload_queue->queue_->Dequeue(payload, &merged_payloads);
+      // The caller doesn't wait for payloads so there is no telling whether
+      // another caller may take the payloads for any instance.
+      TakeReadyPayloads(
+          payload_queue, instance_index, instances, max_payload_count,
+          false /* take_more_generic */, payloads, &merged_payloads);
     }
   }
-  for (auto& merge_payload : merged_payloads) {
+  FinishDequeue(payloads, &merged_payloads);
+  return true;
+}
+
+bool
+RateLimiter::HasPayloads(const std::deque<TritonModelInstance*>& instances)
+{
+  PayloadQueue* payload_queue = payload_queues_[instances[0]->Model()].get();
+  std::lock_guard<std::mutex> lk(payload_queue->mu_);
+  return (FindReadyInstance(payload_queue, instances) < instances.size()) ||
+         !payload_queue->queue_->Empty() ||
+         (FindStalledQueue(payload_queue) != nullptr);
+}
+
+void
+RateLimiter::SetPayloadScheduledCallback(
+    const TritonModel* model,
+    std::function<void(TritonModelInstance*)>&& callback)
+{
+  PayloadQueue* payload_queue = payload_queues_[model].get();
+  std::lock_guard<std::mutex> lk(payload_queue->mu_);
+  if (payload_queue->scheduled_callback_holder_ == nullptr) {
+    payload_queue->scheduled_callback_holder_.reset(
+        new std::function<void(TritonModelInstance*)>(std::move(callback)));
+    payload_queue->scheduled_callback_.store(
+        payload_queue->scheduled_callback_holder_.get());
+  }
+}
+
+size_t
+RateLimiter::FindReadyInstance(
+    PayloadQueue* payload_queue,
+    const std::deque<TritonModelInstance*>& instances)
+{
+  size_t instance_index = 0;
+  for (const auto instance : instances) {
+    if (!payload_queue->specific_queues_[instance]->Empty()) {
+      break;
+    }
+    instance_index++;
+  }
+  return instance_index;
+}
+
+void
+RateLimiter::TakeReadyPayloads(
+    PayloadQueue* payload_queue, size_t instance_index,
+    std::deque<TritonModelInstance*>& instances,
+    const size_t max_payload_count, const bool take_more_generic,
+    std::vector<std::shared_ptr<Payload>>* payloads,
+    std::vector<std::shared_ptr<Payload>>* merged_payloads)
+{
+  const uint64_t now_ns = (payload_queue->hedge_ != nullptr) ? NowNs() : 0;
+  while (true) {
+    std::shared_ptr<Payload> payload;
+    const size_t merged_count = merged_payloads->size();
+    if (instance_index < instances.size()) {
+      payload_queue->specific_queues_[instances[instance_index]]->Dequeue(
+          &payload, merged_payloads);
+    } else {
+      payload_queue->queue_->Dequeue(&payload, merged_payloads);
+      instance_index = 0;
+    }
+    payload_queue->scheduled_count_ -=
+        1 + merged_payloads->size() - merged_count;
+    if (payload_queue->hedge_ != nullptr) {
+      payload_queue->hedge_->RecordWait(
+          (now_ns > payload->ScheduledNs()) ? (now_ns - payload->ScheduledNs())
+                                            : 0);
+    }
+
+    // The payloads are executed in order so the same instance may be
+    // assigned to the next payload.
+    TritonModelInstance* instance = instances[instance_index];
+    if (payload->GetInstance() == nullptr) {
+      payload->SetInstance(instance);
+    }
+    instances.erase(instances.begin() + instance_index);
+    instances.push_back(instance);
+    payloads->push_back(std::move(payload));
+
+    if ((payloads->size() >= max_payload_count) ||
+        (payloads->back()->GetOpType() == Payload::Operation::EXIT)) {
+      break;
+    }
+    instance_index = FindReadyInstance(payload_queue, instances);
+    if ((instance_index == instances.size()) &&
+        (!take_more_generic || payload_queue->queue_->Empty() ||
+         (payload_queue->waiting_count_ > 0))) {
+      break;
+    }
+  }
+}
+
+InstanceQueue*
+RateLimiter::FindStalledQueue(
+    PayloadQueue* payload_queue, uint64_t* stall_delay_ns)
+{
+  if (payload_queue->hedge_ == nullptr) {
+    return nullptr;
+  }
+  // The oldest payload is the first to stall and it is taken over first.
+  // Only the inference payloads may execute on another instance.
+  InstanceQueue* oldest_queue = nullptr;
+  uint64_t oldest_ns = std::numeric_limits<uint64_t>::max();
+  for (const auto& specific_queue : payload_queue->specific_queues_) {
+    InstanceQueue* queue = specific_queue.second.get();
+    if (queue->Empty()) {
+      continue;
+    }
+    const auto& payload = queue->Front();
+    if ((payload->GetOpType() == Payload::Operation::INFER_RUN) &&
+        (payload->ScheduledNs() < oldest_ns)) {
+      oldest_queue = queue;
+      oldest_ns = payload->ScheduledNs();
+    }
+  }
+  if (oldest_queue == nullptr) {
+    return nullptr;
+  }
+  const uint64_t delay_ns =
+      payload_queue->hedge_->StallDelayNs(oldest_ns, NowNs());
+  if (delay_ns > 0) {
+    if (stall_delay_ns != nullptr) {
+      *stall_delay_ns = delay_ns;
+    }
+    return nullptr;
+  }
+  return oldest_queue;
+}
+
+void
+RateLimiter::TakeStalledPayload(
+    PayloadQueue* payload_queue, InstanceQueue* stalled_queue,
+    std::deque<TritonModelInstance*>& instances,
+    std::vector<std::shared_ptr<Payload>>* payloads,
+    std::vector<std::shared_ptr<Payload>>* merged_payloads)
+{
+  std::shared_ptr<Payload> payload;
+  const size_t merged_count = merged_payloads->size();
+  stalled_queue->Dequeue(&payload, merged_payloads);
+  payload_queue->scheduled_count_ -=
+      1 + merged_payloads->size() - merged_count;
+
+  // The resources allocated to the stalled instance are released with the
+  // payload, so the rate limiter stays conservative while the payload
+  // executes on this instance instead.
+  TritonModelInstance* instance = instances.front();
+  LOG_VERBOSE(1) << "Stalled payload taken over by " << instance->Name();
+  payload->SetInstance(instance);
+  instances.pop_front();
+  instances.push_back(instance);
+  payloads->push_back(std::move(payload));
+}
+
+void
+RateLimiter::FinishDequeue(
+    std::vector<std::shared_ptr<Payload>>* payloads,
+    std::vector<std::shared_ptr<Payload>>* merged_payloads)
+{
+  for (auto& merge_payload : *merged_payloads) {
     PayloadRelease(merge_payload);
   }
-  (*payload)->Callback();
-  if ((*payload)->GetInstance() == nullptr) {
-    (*payload)->SetInstance(instances.front());
-    instances.pop_front();
+  for (auto& payload : *payloads) {
+    payload->Callback();
+  }
+}
+
+void
+RateLimiter::NotifyPayloadScheduled(
+    TritonModelInstance* instance, PayloadQueue* payload_queue)
+{
+  if (instance == nullptr) {
+    payload_queue->cv_.notify_one();
   } else {
-    instances.erase(instances.begin() + instance_index);
+    payload_queue->cv_.notify_all();
+  }
+  // The callback is never replaced once set so it can be invoked without
+  // holding the lock.
+  auto callback = payload_queue->scheduled_callback_.load();
+  if (callback != nullptr) {
+    (*callback)(instance);
   }
 }
 
@@ -224,25 +636,7 @@ RateLimiter::GetPayload(
     const Payload::Operation op_type, TritonModelInstance* instance)
 {
   std::shared_ptr<Payload> payload;
-
-  if (max_payload_bucket_count_ > 0) {
-    std::lock_guard<std::mutex> lock(alloc_mu_);
-
-    if (!payload_bucket_.empty()) {
-      payload = payload_bucket_.back();
-      payload_bucket_.pop_back();
-    }
-    if (payload.get() == nullptr && (!payloads_in_use_.empty())) {
-      // Just checking the front of the queue instead the entire queue for
-      // an available payload to save time.
-      if (payloads_in_use_.front().use_count() == 1) {
-        payload = payloads_in_use_.front();
-        payloads_in_use_.pop_front();
-      }
-    }
-  }
-
-  if (payload.get() == nullptr) {
+  if (!payload_bucket_.Get(&payload)) {
     payload.reset(new Payload());
   }
 
@@ -255,31 +649,27 @@ RateLimiter::PayloadRelease(std::shared_ptr<Payload>& payload)
 {
   payload->OnRelease();
   if (max_payload_bucket_count_ > 0) {
-    std::lock_guard<std::mutex> lock(alloc_mu_);
-
-    if (payloads_in_use_.size() + payload_bucket_.size() <
-        max_payload_bucket_count_) {
-      // Release iff the payload shared_ptr is uniquely held.
-      if (payload.use_count() == 1) {
-        payload->Release();
-        payload_bucket_.push_back(std::move(payload));
-        return;
-      } else {
-        payloads_in_use_.push_back(std::move(payload));
-      }
+    // Release iff the payload shared_ptr is uniquely held, otherwise the
+    // payload is released when it is reused.
+    if (payload.use_count() == 1) {
+      payload->Release();
     }
+    payload_bucket_.Put(payload);
   }
 }
 
 RateLimiter::RateLimiter(
-    const bool ignore_resources_and_priority, const ResourceMap& resource_map)
+    const bool ignore_resources_and_priority,
+    const bool earliest_deadline_first, const ResourceMap& resource_map)
     : ignore_resources_and_priority_(ignore_resources_and_priority),
-      max_payload_bucket_count_(MAX_PAYLOAD_BUCKET_COUNT)
+      earliest_deadline_first_(earliest_deadline_first),
+      max_payload_bucket_count_(MAX_PAYLOAD_BUCKET_COUNT),
+      payload_bucket_(MAX_PAYLOAD_BUCKET_COUNT)
 {
   ResourceManager::Create(resource_map, &resource_manager_);
 }
 
-void
+Status
 RateLimiter::InitializePayloadQueues(const TritonModelInstance* instance)
 {
   auto& config = instance->Model()->Config();
@@ -299,12 +689,16 @@ RateLimiter::InitializePayloadQueues(const TritonModelInstance* instance)
     max_queue_delay_microseconds = 0;
   }
   if (payload_queues_.find(instance->Model()) == payload_queues_.end()) {
-    payload_queues_.emplace(
+    std::unique_ptr<HedgePolicy> hedge;
+    RETURN_IF_ERROR(CreateHedgePolicy(config, &hedge));
+    auto res = payload_queues_.emplace(
         instance->Model(),
         new PayloadQueue(
             config.max_batch_size(), max_queue_delay_microseconds * 1000));
+    res.first->second->hedge_ = std::move(hedge);
   }
   PayloadQueue* payload_queue = payload_queues_[instance->Model()].get();
+  std::lock_guard<std::mutex> lk(payload_queue->mu_);
   if (payload_queue->specific_queues_.find(instance) ==
       payload_queue->specific_queues_.end()) {
     payload_queue->specific_queues_.emplace(
@@ -312,11 +706,12 @@ RateLimiter::InitializePayloadQueues(const TritonModelInstance* instance)
         new InstanceQueue(
             config.max_batch_size(), max_queue_delay_microseconds * 1000));
   }
+  return Status::Success;
 }
 
 Status
 RateLimiter::DeferPayloadSchedule(
-    const StandardScheduleFunc& OnSchedule, const TritonModel* model,
+    const SchedRequest& request, const TritonModel* model,
     TritonModelInstance* triton_model_instance)
 {
   std::lock_guard<std::mutex> lk(model_ctx_mtx_);
@@ -335,7 +730,7 @@ RateLimiter::DeferPayloadSchedule(
         "removed");
   }
 
-  itr->second.EnqueueModelInstanceRequest(OnSchedule, triton_model_instance);
+  itr->second.EnqueueModelInstanceRequest(request, triton_model_instance);
   itr->second.StageInstanceIfAvailable(triton_model_instance);
 
   return Status::Success;
@@ -346,11 +741,17 @@ RateLimiter::SchedulePayload(
     TritonModelInstance* tmi, PayloadQueue* payload_queue,
     const std::shared_ptr<Payload>& payload)
 {
+  // Report before the payload is visible to the backend threads.
+  payload->ReportTraceActivity(TRITONSERVER_TRACE_INSTANCE_ALLOCATED);
+  if (payload_queue->hedge_ != nullptr) {
+    payload->SetScheduledNs(NowNs());
+  }
   if (tmi == nullptr) {
     payload_queue->queue_->Enqueue(payload);
   } else {
     payload_queue->specific_queues_[tmi]->Enqueue(payload);
   }
+  payload_queue->scheduled_count_++;
   payload->SetState(Payload::State::SCHEDULED);
 }
 
@@ -358,8 +759,17 @@ void
 RateLimiter::OnStage(ModelInstanceContext* instance)
 {
   {
+    AllocationOrder order{0, 0, instance->ScaledPriority()};
+    if (earliest_deadline_first_) {
+      order.deadline_ns_ = (instance->staged_timeout_ns_ == 0)
+                               ? std::numeric_limits<uint64_t>::max()
+                               : instance->staged_timeout_ns_;
+      order.enqueue_ns_ = (instance->staged_enqueue_ns_ == 0)
+                              ? std::numeric_limits<uint64_t>::max()
+                              : instance->staged_enqueue_ns_;
+    }
     std::lock_guard<std::recursive_mutex> lk(staged_instances_mtx_);
-    staged_instances_.push(instance);
+    staged_instances_.Push(instance, order);
   }
   AttemptAllocation();
 }
@@ -380,10 +790,10 @@ void
 RateLimiter::AttemptAllocation()
 {
   std::lock_guard<std::recursive_mutex> lk(staged_instances_mtx_);
-  if (!staged_instances_.empty()) {
-    ModelInstanceContext* instance = staged_instances_.top();
+  if (!staged_instances_.Empty()) {
+    ModelInstanceContext* instance = staged_instances_.Top();
     if (resource_manager_->AllocateResources(instance)) {
-      staged_instances_.pop();
+      staged_instances_.Pop();
       instance->Allocate();
     }
   }
@@ -397,18 +807,17 @@ RateLimiter::ModelContext::ModelContext() : removal_in_progress_(false) {}
 
 Status
 RateLimiter::ModelContext::EnqueueModelInstanceRequest(
-    const StandardScheduleFunc& OnSchedule,
-    TritonModelInstance* triton_model_instance)
+    const SchedRequest& request, TritonModelInstance* triton_model_instance)
 {
   std::lock_guard<std::recursive_mutex> lk(sched_request_queue_mtx_);
 
   if (triton_model_instance == nullptr) {
-    generic_sched_request_queue_.push(OnSchedule);
+    generic_sched_request_queue_.push(request);
   } else if (
       (uint32_t)triton_model_instance->Index() <
       specific_sched_request_queues_.size()) {
     specific_sched_request_queues_[triton_model_instance->Index()].push(
-        OnSchedule);
+        request);
   } else {
     return Status(
         Status::Code::INTERNAL,
@@ -424,93 +833,116 @@ void
 RateLimiter::ModelContext::AddAvailableInstance(ModelInstanceContext* instance)
 {
   std::lock_guard<std::recursive_mutex> lk(avbl_instances_mtx_);
-  avbl_instances_.push(instance);
+  avbl_instances_.Push(instance, instance->ScaledPriority());
+  instance_ctxs_[instance->RawInstance()] = instance;
   instance->MarkAvailable();
 }
 
+bool
+RateLimiter::ModelContext::RemoveAvailableInstance(
+    ModelInstanceContext* instance)
+{
+  std::lock_guard<std::recursive_mutex> lk1(sched_request_queue_mtx_);
+  std::lock_guard<std::recursive_mutex> lk2(avbl_instances_mtx_);
+  if (!avbl_instances_.Contains(instance) ||
+      !specific_sched_request_queues_[instance->RawInstance()->Index()]
+           .empty()) {
+    return false;
+  }
+  avbl_instances_.Remove(instance);
+  instance_ctxs_.erase(instance->RawInstance());
+  return true;
+}
 
 void
 RateLimiter::ModelContext::StageInstanceIfAvailable(
     TritonModelInstance* req_instance)
 {
-  std::lock_guard<std::recursive_mutex> lk1(sched_request_queue_mtx_);
-  std::lock_guard<std::recursive_mutex> lk2(avbl_instances_mtx_);
-  PriorityQueue backup_queue;
-
-  while (!avbl_instances_.empty()) {
-    ModelInstanceContext* instance = avbl_instances_.top();
-    if ((req_instance != nullptr) &&
-        (instance->RawInstance() != req_instance)) {
-      backup_queue.push(instance);
-      avbl_instances_.pop();
-      continue;
-    }
-    if (!specific_sched_request_queues_[instance->RawInstance()->Index()]
-             .empty()) {
-      // Prioritize the specific requests for the available model
-      // instance highest priority.
-      const StandardScheduleFunc func =
-          specific_sched_request_queues_[instance->RawInstance()->Index()]
-              .front();
-      specific_sched_request_queues_[instance->RawInstance()->Index()].pop();
-      instance->Stage(func);
-    } else if (!generic_sched_request_queue_.empty()) {
-      // If request is for generic model instance then use the
-      // instance with the highest priority.
-      const StandardScheduleFunc func = generic_sched_request_queue_.front();
-      generic_sched_request_queue_.pop();
-      instance->Stage(func);
-    } else {
-      // If there are requests for a specific model instance then backup
-      // the model instance and keep searching through the available
-      // model instances. The prioritization will be taken care of in the
-      // staging priority queue.
-      backup_queue.push(instance);
-    }
-    avbl_instances_.pop();
-  }
-  // Restore the backup queue
-  if (!backup_queue.empty()) {
-    avbl_instances_.swap(backup_queue);
-  }
+  ScheduleAvailableInstances(req_instance, false /* direct_allocate */);
 }
 
 void
 RateLimiter::ModelContext::AllocateInstanceIfAvailable()
+{
+  ScheduleAvailableInstances(nullptr, true /* direct_allocate */);
+}
+
+void
+RateLimiter::ModelContext::ScheduleAvailableInstances(
+    TritonModelInstance* req_instance, const bool direct_allocate)
 {
   std::lock_guard<std::recursive_mutex> lk1(sched_request_queue_mtx_);
   std::lock_guard<std::recursive_mutex> lk2(avbl_instances_mtx_);
-  PriorityQueue backup_queue;
-  while (!avbl_instances_.empty()) {
-    ModelInstanceContext* instance = avbl_instances_.top();
+
+  // The instances are removed from the available set before being
+  // scheduled.
+  auto schedule = [direct_allocate](
+                      ModelInstanceContext* instance,
+                      const SchedRequest& request) {
+    if (direct_allocate) {
+      instance->DirectAllocate(request.OnSchedule_);
+    } else {
+      instance->Stage(request);
+    }
+  };
+  SchedRequest request;
+
+  if (req_instance != nullptr) {
+    const auto it = instance_ctxs_.find(req_instance);
+    if ((it != instance_ctxs_.end()) && avbl_instances_.Contains(it->second) &&
+        NextSchedRequest(it->second, &request)) {
+      avbl_instances_.Remove(it->second);
+      schedule(it->second, request);
+    }
+    return;
+  }
+
+  // While there are requests for generic model instance, use the available
+  // instances in priority order, each prioritizing its specific requests.
+  while ((!generic_sched_request_queue_.empty()) &&
+         (!avbl_instances_.Empty())) {
+    ModelInstanceContext* instance = avbl_instances_.Top();
+    NextSchedRequest(instance, &request);
+    avbl_instances_.Pop();
+    schedule(instance, request);
+  }
+
+  // The remaining instances can only serve their specific requests, which
+  // doesn't depend on the priority order. The prioritization will be taken
+  // care of in the staging priority queue.
+  std::vector<ModelInstanceContext*> ready_instances;
+  for (size_t idx = 0; idx < avbl_instances_.Size(); ++idx) {
+    ModelInstanceContext* instance = avbl_instances_.At(idx);
     if (!specific_sched_request_queues_[instance->RawInstance()->Index()]
              .empty()) {
-      // Prioritize the specific requests for the available model
-      // instance highest priority.
-      const StandardScheduleFunc func =
-          specific_sched_request_queues_[instance->RawInstance()->Index()]
-              .front();
-      specific_sched_request_queues_[instance->RawInstance()->Index()].pop();
-      instance->DirectAllocate(func);
-    } else if (!generic_sched_request_queue_.empty()) {
-      // If request is for generic model instance then use the
-      // instance with the highest priority.
-      const StandardScheduleFunc func = generic_sched_request_queue_.front();
-      generic_sched_request_queue_.pop();
-      instance->DirectAllocate(func);
-    } else {
-      // If there are requests for a specific model instance then backup
-      // the model instance and keep searching through the available
-      // model instances. The prioritization will be taken care of in the
-      // staging priority queue.
-      backup_queue.push(instance);
+      ready_instances.push_back(instance);
     }
-    avbl_instances_.pop();
   }
-  // Restore the backup queue
-  if (!backup_queue.empty()) {
-    avbl_instances_.swap(backup_queue);
+  for (auto instance : ready_instances) {
+    NextSchedRequest(instance, &request);
+    avbl_instances_.Remove(instance);
+    schedule(instance, request);
+  }
+}
+
+bool
+RateLimiter::ModelContext::NextSchedRequest(
+    ModelInstanceContext* instance, SchedRequest* request)
+{
+  auto& specific_queue =
+      specific_sched_request_queues_[instance->RawInstance()->Index()];
+  if (!specific_queue.empty()) {
+    // Prioritize the specific requests for the available model
+    // instance highest priority.
+    *request = specific_queue.front();
+    specific_queue.pop();
+    return true;
+  } else if (!generic_sched_request_queue_.empty()) {
+    *request = generic_sched_request_queue_.front();
+    generic_sched_request_queue_.pop();
+    return true;
   }
+  return false;
 }
 
 void
@@ -548,7 +980,8 @@ RateLimiter::ModelInstanceContext::ModelInstanceContext(
     : triton_model_instance_(triton_model_instance),
       index_(triton_model_instance->Index()), model_context_(model_context),
       rate_limiter_config_(rate_limiter_config), OnStage_(OnStage),
-      OnRelease_(OnRelease), exec_count_(0), state_(AVAILABLE)
+      OnRelease_(OnRelease), exec_count_(0), state_(AVAILABLE),
+      staged_enqueue_ns_(0), staged_timeout_ns_(0)
 {
 }
 
@@ -560,7 +993,7 @@ RateLimiter::ModelInstanceContext::MarkAvailable()
 }
 
 Status
-RateLimiter::ModelInstanceContext::Stage(StandardScheduleFunc OnSchedule)
+RateLimiter::ModelInstanceContext::Stage(const SchedRequest& request)
 {
   {
     std::lock_guard<std::mutex> lk(state_mtx_);
@@ -572,7 +1005,9 @@ RateLimiter::ModelInstanceContext::Stage(StandardScheduleFunc OnSchedule)
     }
 
     state_ = STAGED;
-    OnSchedule_ = OnSchedule;
+    OnSchedule_ = request.OnSchedule_;
+    staged_enqueue_ns_ = request.oldest_enqueue_ns_;
+    staged_timeout_ns_ = request.closest_timeout_ns_;
   }
 
   OnStage_(this);
@@ -696,8 +1131,7 @@ RateLimiter::ResourceManager::Create(
 }
 
 void
-RateLimiter::ResourceManager::AddModelInstance(
-    const ModelInstanceContext* instance)
+RateLimiter::ResourceManager::AddModelInstance(ModelInstanceContext* instance)
 {
   std::lock_guard<std::mutex> lk(model_resources_mtx_);
   auto pr = model_resources_.emplace(std::make_pair(instance, ResourceMap()));
@@ -710,6 +1144,25 @@ RateLimiter::ResourceManager::AddModelInstance(
           resource.count();
     }
   }
+
+  // Resolve the counters of the required resources, sorted by counter so
+  // that allocations always update them in the same order.
+  instance->resources_.clear();
+  for (const auto& ditr : pr.first->second) {
+    for (const auto& ritr : ditr.second) {
+      auto& counter =
+          resource_counters_[std::make_pair(ditr.first, ritr.first)];
+      if (counter == nullptr) {
+        counter.reset(new ResourceCounter());
+      }
+      instance->resources_.push_back({counter.get(), ritr.second});
+    }
+  }
+  std::sort(
+      instance->resources_.begin(), instance->resources_.end(),
+      [](const ResourceRequirement& a, const ResourceRequirement& b) {
+        return a.counter_ < b.counter_;
+      });
 }
 
 Status
@@ -761,6 +1214,18 @@ RateLimiter::ResourceManager::UpdateResourceLimits()
   }
   RETURN_IF_ERROR(ValidateMaxResources());
 
+  for (const auto& counter : resource_counters_) {
+    size_t max_count = 0;
+    const auto ditr = max_resources_.find(counter.first.first);
+    if (ditr != max_resources_.end()) {
+      const auto ritr = ditr->second.find(counter.first.second);
+      if (ritr != ditr->second.end()) {
+        max_count = ritr->second;
+      }
+    }
+    counter.second->max_.store(max_count);
+  }
+
   if (LOG_VERBOSE_IS_ON(1)) {
     std::string resource_map_str{"\nMax Resource Map===>\n"};
     for (const auto& ditr : max_resources_) {
@@ -864,42 +1329,23 @@ bool
 RateLimiter::ResourceManager::AllocateResources(
     const ModelInstanceContext* instance)
 {
-  std::lock_guard<std::mutex> lk1(model_resources_mtx_);
-  std::lock_guard<std::mutex> lk2(allocated_resources_mtx_);
-  const auto& itr = model_resources_.find(instance);
-  if (itr == model_resources_.end()) {
-    return false;
-  } else {
-    // First pass to verify if resources are available
-    {
-      std::lock_guard<std::mutex> lk3(max_resources_mtx_);
-      for (const auto& ditr : itr->second) {
-        auto allocated_ditr = allocated_resources_.find(ditr.first);
-        if (allocated_ditr == allocated_resources_.end()) {
-          allocated_ditr =
-              allocated_resources_
-                  .emplace(ditr.first, std::map<std::string, size_t>())
-                  .first;
-        }
-        for (const auto& ritr : ditr.second) {
-          auto allocated_ritr = allocated_ditr->second.find(ritr.first);
-          if (allocated_ritr == allocated_ditr->second.end()) {
-            allocated_ritr =
-                allocated_ditr->second.emplace(ritr.first, 0).first;
-          }
-          if ((allocated_ritr->second + ritr.second) >
-              (max_resources_[ditr.first])[ritr.first]) {
-            return false;
-          }
-        }
-      }
-    }
-
-    // Second pass to actually allocate the resources
-    for (const auto& ditr : itr->second) {
-      for (const auto& ritr : ditr.second) {
-        (allocated_resources_[ditr.first])[ritr.first] += ritr.second;
+  // Reserve each resource with a compare-and-swap on its counter, and give
+  // back the reserved resources if one of them is not available.
+  const auto& resources = instance->resources_;
+  for (size_t idx = 0; idx < resources.size(); ++idx) {
+    ResourceCounter* counter = resources[idx].counter_;
+    const size_t max_count = counter->max_.load();
+    size_t allocated = counter->allocated_.load();
+    bool available;
+    do {
+      available = ((allocated + resources[idx].count_) <= max_count);
+    } while (available && !counter->allocated_.compare_exchange_weak(
+                              allocated, allocated + resources[idx].count_));
+    if (!available) {
+      for (size_t ridx = 0; ridx < idx; ++ridx) {
+        resources[ridx].counter_->allocated_ -= resources[ridx].count_;
       }
+      return false;
     }
   }
 
@@ -910,19 +1356,8 @@ Status
 RateLimiter::ResourceManager::ReleaseResources(
     const ModelInstanceContext* instance)
 {
-  std::lock_guard<std::mutex> lk1(model_resources_mtx_);
-  std::lock_guard<std::mutex> lk2(allocated_resources_mtx_);
-  const auto& itr = model_resources_.find(instance);
-  if (itr == model_resources_.end()) {
-    return Status(
-        Status::Code::INTERNAL,
-        "Unable find the instance resources to release");
-  } else {
-    for (const auto& ditr : itr->second) {
-      for (const auto& ritr : ditr.second) {
-        (allocated_resources_[ditr.first])[ritr.first] -= ritr.second;
-      }
-    }
+  for (const auto& resource : instance->resources_) {
+    resource.counter_->allocated_ -= resource.count_;
   }
 
   return Status::Success;
@@ -25,16 +25,22 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <unordered_map>
 #include <queue>
+#include <set>
 #include <vector>
 
 #include "backend_model.h"
 #include "backend_model_instance.h"
+#include "hedge_policy.h"
+#include "indexed_heap.h"
 #include "instance_queue.h"
 #include "model_config.pb.h"
+#include "object_freelist.h"
 #include "payload.h"
 #include "status.h"
 
@@ -64,11 +70,16 @@ class RateLimiter {
   /// \param ignore_resources_and_priority Whether or not to ignore resource
   /// constraints and cross-model priority. An available instance is directly
   /// allocated when true.
+  /// \param earliest_deadline_first Whether the staged instances are
+  /// allocated by the closest timeout of their payload, then by the oldest
+  /// enqueue time, instead of by their scaled priority only. The scaled
+  /// priority breaks the ties.
   /// \param resource_map The map to the available resource count provided
   /// explicitly.
   /// \return Status object indicating success or failure.
   static Status Create(
-      const bool ignore_resources_and_priority, const ResourceMap& resource_map,
+      const bool ignore_resources_and_priority,
+      const bool earliest_deadline_first, const ResourceMap& resource_map,
       std::unique_ptr<RateLimiter>* rate_limiter);
 
   /// Registers the model instance with the rate limiter.
@@ -86,6 +97,23 @@ class RateLimiter {
   /// \return Status object indicating success or failure.
   Status UnregisterModel(const TritonModel* model);
 
+  /// Removes an available model instance of a model that remains
+  /// registered so that no more payloads are scheduled for it. The
+  /// backend thread of the instance must be stopped afterwards, which
+  /// still executes the payloads already scheduled for the instance, and
+  /// then ReleaseModelInstance() be called.
+  /// \param instance The pointer to the TritonModelInstance object to
+  /// remove.
+  /// \param removed Returns false if the instance is not removed as it is
+  /// not available at the moment.
+  /// \return Status object indicating success or failure.
+  Status RemoveModelInstance(TritonModelInstance* instance, bool* removed);
+
+  /// Releases the payload queue of a model instance removed with
+  /// RemoveModelInstance() once its backend thread is stopped.
+  /// \param instance The pointer to the removed TritonModelInstance object.
+  void ReleaseModelInstance(const TritonModelInstance* instance);
+
   /// Returns true if there is a payload slot available for the given model.
   /// \param model The pointer to TritonModel object to be removed.
   /// \return slot availability in boolean.
@@ -98,16 +126,52 @@ class RateLimiter {
   Status EnqueuePayload(
       const TritonModel* model, std::shared_ptr<Payload> payload);
 
-  /// Returns the payload that has been scheduled for the given set of model
-  /// instances. Note that this call is blocking and depends upon the
-  /// availability of payloads in the rate limiter for the triton model
-  /// instance.
-  /// \param instance The pointers to TritonModelInstance objects whose
-  /// payload is being requested.
-  /// \param payload The shared pointer to the payload object.
-  void DequeuePayload(
-      std::deque<TritonModelInstance*>& instance,
-      std::shared_ptr<Payload>* payload);
+  /// Returns the payloads that have been scheduled for the given set of
+  /// model instances, to be executed in order by the caller. Note that this
+  /// call is blocking until at least one payload is available in the rate
+  /// limiter for the triton model instances. More payloads are returned only
+  /// if they are already available, a payload that may be executed by any
+  /// model instance is only added if no other thread is waiting for it.
+  /// \param instances The pointers to TritonModelInstance objects whose
+  /// payloads are being requested. The instance assigned to each returned
+  /// payload is moved to the back.
+  /// \param max_payload_count The maximum number of payloads to return.
+  /// \param spin_ns The time to poll for a payload before blocking.
+  /// \param payloads Returns the shared pointers to the payload objects.
+  void DequeuePayloads(
+      std::deque<TritonModelInstance*>& instances,
+      const size_t max_payload_count, const uint64_t spin_ns,
+      std::vector<std::shared_ptr<Payload>>* payloads);
+
+  /// Non-blocking version of DequeuePayloads(), a payload that may be
+  /// executed by any model instance is only returned first.
+  /// \param instances The pointers to TritonModelInstance objects whose
+  /// payloads are being requested. The instance assigned to each returned
+  /// payload is moved to the back.
+  /// \param max_payload_count The maximum number of payloads to return.
+  /// \param payloads Returns the shared pointers to the payload objects.
+  /// \return True if at least one payload is returned, false otherwise.
+  bool TryDequeuePayloads(
+      std::deque<TritonModelInstance*>& instances,
+      const size_t max_payload_count,
+      std::vector<std::shared_ptr<Payload>>* payloads);
+
+  /// Returns true if there is a payload that can be executed by any of the
+  /// given model instances.
+  /// \param instances The pointers to TritonModelInstance objects.
+  /// \return Payload availability in boolean.
+  bool HasPayloads(const std::deque<TritonModelInstance*>& instances);
+
+  /// Sets the function to be called whenever a payload is scheduled for
+  /// the given model, the function is called without holding any rate
+  /// limiter lock. The function is set only once per model and must be set
+  /// before any payload is enqueued for the model instances relying on it.
+  /// \param model The pointer to TritonModel object.
+  /// \param callback The function to call with the model instance that the
+  /// payload is scheduled for, nullptr if any instance may execute it.
+  void SetPayloadScheduledCallback(
+      const TritonModel* model,
+      std::function<void(TritonModelInstance*)>&& callback);
 
   /// Returns a new payload object.
   /// \param op_type The operation type for the payload.
@@ -131,6 +195,46 @@ class RateLimiter {
   using StandardScheduleFunc = std::function<void(ModelInstanceContext*)>;
   using StandardStageFunc = std::function<void(ModelInstanceContext*)>;
 
+  // A pending request to schedule a payload, along with the deadline
+  // information of the payload.
+  struct SchedRequest {
+    StandardScheduleFunc OnSchedule_;
+    uint64_t oldest_enqueue_ns_;
+    uint64_t closest_timeout_ns_;
+  };
+
+  // The allocation order of a staged model instance, lowest first. The
+  // deadline fields are only set for earliest deadline first allocation,
+  // a payload without timeout has the furthest deadline.
+  struct AllocationOrder {
+    uint64_t deadline_ns_;
+    uint64_t enqueue_ns_;
+    double priority_;
+    bool operator<(const AllocationOrder& rhs) const
+    {
+      if (deadline_ns_ != rhs.deadline_ns_) {
+        return deadline_ns_ < rhs.deadline_ns_;
+      }
+      if (enqueue_ns_ != rhs.enqueue_ns_) {
+        return enqueue_ns_ < rhs.enqueue_ns_;
+      }
+      return priority_ < rhs.priority_;
+    }
+  };
+
+  // The allocated and maximum count of a resource on a device.
+  struct ResourceCounter {
+    ResourceCounter() : allocated_(0), max_(0) {}
+    std::atomic<size_t> allocated_;
+    std::atomic<size_t> max_;
+  };
+
+  // The count of a resource required by a model instance.
+  struct ResourceRequirement {
+    ResourceCounter* counter_;
+    size_t count_;
+  };
+
   // Holds the state of the model instance.
   class ModelInstanceContext {
    public:
@@ -153,7 +257,7 @@ class RateLimiter {
     }
     void MarkAvailable();
     double ScaledPriority();
-    Status Stage(StandardScheduleFunc OnSchedule);
+    Status Stage(const SchedRequest& request);
     Status Allocate();
     Status DirectAllocate(StandardScheduleFunc OnSchedule);
     void RequestRemoval();
@@ -172,21 +276,20 @@ class RateLimiter {
     std::mutex state_mtx_;
 
     StandardScheduleFunc OnSchedule_;
+    // The deadline information of the staged payload.
+    uint64_t staged_enqueue_ns_;
+    uint64_t staged_timeout_ns_;
 
     std::condition_variable cv_;
-  };
 
-  class ScaledPriorityComparator {
-   public:
-    bool operator()(ModelInstanceContext* a, ModelInstanceContext* b)
-    {
-      return a->ScaledPriority() > b->ScaledPriority();
-    }
+    // The resources required by the instance, set by the ResourceManager
+    // when the instance is added.
+    std::vector<ResourceRequirement> resources_;
   };
 
-  using PriorityQueue = std::priority_queue<
-      ModelInstanceContext*, std::vector<ModelInstanceContext*>,
-      ScaledPriorityComparator>;
+  // Model instances ordered by the scaled priority they had when added,
+  // lowest first.
+  using PriorityQueue = IndexedHeap<ModelInstanceContext*, double>;
 
   // Holds the active context to a model
   class ModelContext {
@@ -194,9 +297,12 @@ class RateLimiter {
     ModelContext();
 
     Status EnqueueModelInstanceRequest(
-        const StandardScheduleFunc& OnSchedule,
+        const SchedRequest& request,
         TritonModelInstance* triton_model_instance);
     void AddAvailableInstance(ModelInstanceContext* instance);
+    // Remove 'instance' from the instances of the model if it is available
+    // and has no pending specific requests, return false otherwise.
+    bool RemoveAvailableInstance(ModelInstanceContext* instance);
     void StageInstanceIfAvailable(TritonModelInstance* triton_model_instance);
     void AllocateInstanceIfAvailable();
     void AddSpecificRequestQueue();
@@ -205,16 +311,28 @@ class RateLimiter {
     bool isRemovalInProgress() { return removal_in_progress_; }
 
    private:
+    // Stage or directly allocate the available instances that can serve the
+    // pending scheduling requests. Only 'req_instance' is considered if it
+    // is not nullptr.
+    void ScheduleAvailableInstances(
+        TritonModelInstance* req_instance, const bool direct_allocate);
+    // Pop the next scheduling request that 'instance' can serve into
+    // 'request', the requests specific to 'instance' first. Return false if
+    // there is none.
+    bool NextSchedRequest(
+        ModelInstanceContext* instance, SchedRequest* request);
+
     bool removal_in_progress_;
 
     // Queue holding pending scheduling request
-    std::queue<StandardScheduleFunc> generic_sched_request_queue_;
-    std::vector<std::queue<StandardScheduleFunc>>
-        specific_sched_request_queues_;
+    std::queue<SchedRequest> generic_sched_request_queue_;
+    std::vector<std::queue<SchedRequest>> specific_sched_request_queues_;
     std::recursive_mutex sched_request_queue_mtx_;
 
     // The set of instances that are available at the moment
     PriorityQueue avbl_instances_;
+    std::unordered_map<const TritonModelInstance*, ModelInstanceContext*>
+        instance_ctxs_;
     std::recursive_mutex avbl_instances_mtx_;
   };
 
@@ -224,7 +342,7 @@ class RateLimiter {
     static Status Create(
         const ResourceMap& resource_map,
         std::unique_ptr<ResourceManager>* resource_manager);
-    void AddModelInstance(const ModelInstanceContext* instance);
+    void AddModelInstance(ModelInstanceContext* instance);
     Status RemoveModelInstance(const ModelInstanceContext* instance);
     Status UpdateResourceLimits();
     bool AllocateResources(const ModelInstanceContext* instance);
@@ -243,17 +361,20 @@ class RateLimiter {
     ResourceMap max_resources_;
     std::mutex max_resources_mtx_;
 
-    ResourceMap allocated_resources_;
-    std::mutex allocated_resources_mtx_;
+    // The counter of each resource on each device, created when the first
+    // instance requiring the resource is added so that allocation only
+    // updates the counters referenced by the instance without locking.
+    std::map<std::pair<int, std::string>, std::unique_ptr<ResourceCounter>>
+        resource_counters_;
   };
 
   RateLimiter(
       const bool ignore_resources_and_priority,
-      const ResourceMap& resource_map);
+      const bool earliest_deadline_first, const ResourceMap& resource_map);
 
-  void InitializePayloadQueues(const TritonModelInstance* instance);
+  Status InitializePayloadQueues(const TritonModelInstance* instance);
   Status DeferPayloadSchedule(
-      const StandardScheduleFunc& OnSchedule, const TritonModel* model,
+      const SchedRequest& request, const TritonModel* model,
       TritonModelInstance* instance = nullptr);
   void OnStage(ModelInstanceContext* instance_ptr);
   void OnRelease(ModelInstanceContext* instance_ptr);
@@ -261,13 +382,41 @@ class RateLimiter {
   void SchedulePayload(
       TritonModelInstance* tmi, PayloadQueue* payload_queue,
       const std::shared_ptr<Payload>& payload);
+  void NotifyPayloadScheduled(
+      TritonModelInstance* instance, PayloadQueue* payload_queue);
+  size_t FindReadyInstance(
+      PayloadQueue* payload_queue,
+      const std::deque<TritonModelInstance*>& instances);
+  void TakeReadyPayloads(
+      PayloadQueue* payload_queue, size_t instance_index,
+      std::deque<TritonModelInstance*>& instances,
+      const size_t max_payload_count, const bool take_more_generic,
+      std::vector<std::shared_ptr<Payload>>* payloads,
+      std::vector<std::shared_ptr<Payload>>* merged_payloads);
+  InstanceQueue* FindStalledQueue(
+      PayloadQueue* payload_queue, uint64_t* stall_delay_ns = nullptr);
+  void TakeStalledPayload(
+      PayloadQueue* payload_queue, InstanceQueue* stalled_queue,
+      std::deque<TritonModelInstance*>& instances,
+      std::vector<std::shared_ptr<Payload>>* payloads,
+      std::vector<std::shared_ptr<Payload>>* merged_payloads);
+  void FinishDequeue(
+      std::vector<std::shared_ptr<Payload>>* payloads,
+      std::vector<std::shared_ptr<Payload>>* merged_payloads);
 
   bool ignore_resources_and_priority_;
+  bool earliest_deadline_first_;
 
   // Instance context for the models
   std::map<
       const TritonModel*, std::vector<std::shared_ptr<ModelInstanceContext>>>
       model_instance_ctxs_;
+  // The contexts of the removed instances are kept until the instance is
+  // released as the instance may still be releasing itself when it is
+  // removed.
+  std::map<
+      const TritonModel*, std::vector<std::shared_ptr<ModelInstanceContext>>>
+      removed_instance_ctxs_;
   std::mutex model_instance_ctx_mtx_;
 
   // Running context of the models
@@ -275,31 +424,47 @@ class RateLimiter {
   std::mutex model_ctx_mtx_;
 
   // Holds the model instances that have been staged
-  PriorityQueue staged_instances_;
+  IndexedHeap<ModelInstanceContext*, AllocationOrder> staged_instances_;
   std::recursive_mutex staged_instances_mtx_;
 
   // Manager to keep track of the resource allocations
   std::unique_ptr<ResourceManager> resource_manager_;
 
-  // Mutex to serialize Payload allocation
-  std::mutex alloc_mu_;
-
   // Keep some number of Payload objects for reuse to avoid the overhead
-  // of creating a Payload for every new request.
+  // of creating a Payload for every new request. The freelist is lock-free
+  // so that getting and releasing payloads doesn't serialize the callers.
+  // A payload may be released while still referenced elsewhere, it is
+  // only reused once the freelist holds the last reference.
   const size_t max_payload_bucket_count_;
-  std::vector<std::shared_ptr<Payload>> payload_bucket_;
-  std::deque<std::shared_ptr<Payload>> payloads_in_use_;
+  SharedObjectFreelist<Payload> payload_bucket_;
 
   struct PayloadQueue {
     explicit PayloadQueue(size_t max_batch_size, uint64_t max_queue_delay_ns)
+        : scheduled_count_(0), waiting_count_(0), scheduled_callback_(nullptr)
     {
       queue_.reset(new InstanceQueue(max_batch_size, max_queue_delay_ns));
     }
     std::unique_ptr<InstanceQueue> queue_;
     std::map<const TritonModelInstance*, std::unique_ptr<InstanceQueue>>
         specific_queues_;
+    // The removed instances whose payloads, the exit payload of their
+    // backend thread, are scheduled directly.
+    std::set<const TritonModelInstance*> removed_instances_;
     std::mutex mu_;
     std::condition_variable cv_;
+    // The number of payloads in the queues, modified under 'mu_' but may be
+    // polled without it.
+    std::atomic<size_t> scheduled_count_;
+    // The number of threads waiting for a payload.
+    std::atomic<size_t> waiting_count_;
+    // The function called after a payload is scheduled, set at most once.
+    std::unique_ptr<std::function<void(TritonModelInstance*)>>
+        scheduled_callback_holder_;
+    std::atomic<std::function<void(TritonModelInstance*)>*>
+        scheduled_callback_;
+    // The policy of taking over the payloads stalled in the queue of an
+    // instance, nullptr if the payloads are not hedged.
+    std::unique_ptr<HedgePolicy> hedge_;
   };
   std::map<const TritonModel*, std::unique_ptr<PayloadQueue>> payload_queues_;
 };
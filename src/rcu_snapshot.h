@@ -0,0 +1,139 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace triton { namespace core {
+
+//
+// Read-mostly value that readers access without taking a lock. The
+// value is immutable once published; an update publishes a new value,
+// and the previous one is destroyed once no reader can see it anymore.
+//
+// Readers announce themselves in a counter of the current epoch. The
+// counters are spread over cache lines to avoid contention between reader
+// threads. A publisher swaps the value, flips the epoch, and then waits
+// for the counters of the previous epoch to drain. Reads are short, so
+// the publisher waits only briefly. Publishers must be serialized by the
+// caller.
+//
+template <typename T>
+class RcuSnapshot {
+ public:
+  // Guard of a read, the value stays valid until the guard is destroyed.
+  class ReadGuard {
+   public:
+    ReadGuard(ReadGuard&& rhs) : counter_(rhs.counter_), value_(rhs.value_)
+    {
+      rhs.counter_ = nullptr;
+    }
+    ~ReadGuard()
+    {
+      if (counter_ != nullptr) {
+        counter_->fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    const T* operator->() const { return value_; }
+    const T& operator*() const { return *value_; }
+
+   private:
+    friend class RcuSnapshot;
+    ReadGuard(std::atomic<uint64_t>* counter, const T* value)
+        : counter_(counter), value_(value)
+    {
+    }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    std::atomic<uint64_t>* counter_;
+    const T* value_;
+  };
+
+  explicit RcuSnapshot(std::unique_ptr<T> value)
+      : value_(value.release()), epoch_(0)
+  {
+  }
+  ~RcuSnapshot() { delete value_.load(); }
+
+  // Return a guard of the current value.
+  ReadGuard Read() const
+  {
+    const size_t shard = Shard();
+    while (true) {
+      const uint64_t epoch = epoch_.load();
+      auto& counter = counters_[epoch & 1][shard].count_;
+      counter.fetch_add(1);
+      // The publisher may have flipped the epoch before the counter was
+      // incremented, in which case it may not be waiting for this reader.
+      if (epoch_.load() == epoch) {
+        return ReadGuard(&counter, value_.load());
+      }
+      counter.fetch_sub(1);
+    }
+  }
+
+  // Publish 'value' and destroy the previous value once the readers that
+  // may see it are done.
+  void Publish(std::unique_ptr<T> value)
+  {
+    T* previous = value_.exchange(value.release());
+    const uint64_t epoch = epoch_.fetch_add(1);
+    for (auto& counter : counters_[epoch & 1]) {
+      while (counter.count_.load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+    delete previous;
+  }
+
+ private:
+  static constexpr size_t kShardCount = 16;
+
+  // Return the counter shard of the calling thread.
+  static size_t Shard()
+  {
+    static std::atomic<size_t> next_shard(0);
+    thread_local size_t shard = next_shard++ % kShardCount;
+    return shard;
+  }
+
+  struct Counter {
+    std::atomic<uint64_t> count_{0};
+    char padding_[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  std::atomic<T*> value_;
+  std::atomic<uint64_t> epoch_;
+  mutable Counter counters_[2][kShardCount];
+};
+
+}}  // namespace triton::core
@@ -26,8 +26,11 @@
 
 #include "repo_agent.h"
 
+#include <map>
+#include <set>
 #include <string>
 #include "filesystem.h"
+#include "hash_utils.h"
 #include "shared_library.h"
 #include "triton/common/logging.h"
 #include "tritonserver_apis.h"
@@ -46,6 +49,69 @@
 
 namespace triton { namespace core {
 
+namespace {
+
+// Add the names and the contents of the files under 'path' to 'hash'.
+// The contents are hashed rather than the modification times, which are
+// kept when files are copied or synced into the repository and may not
+// change when a file is rewritten within the time resolution of the file
+// system. Hashing is much cheaper than the agent actions it saves.
+Status
+FingerprintDirectory(const std::string& path, StreamingHash64* hash)
+{
+  std::set<std::string> contents;
+  RETURN_IF_ERROR(GetDirectoryContents(path, &contents));
+  for (const auto& content : contents) {
+    const auto full_path = JoinPath({path, content});
+    hash->Update(content);
+    bool is_dir = false;
+    RETURN_IF_ERROR(IsDirectory(full_path, &is_dir));
+    hash->UpdateValue(is_dir);
+    if (is_dir) {
+      RETURN_IF_ERROR(FingerprintDirectory(full_path, hash));
+      continue;
+    }
+
+    // Local files are hashed through a mapping so that they are not
+    // copied, the files of a cloud repository are read.
+    std::shared_ptr<const MappedFile> mapped;
+    if (MapFile(full_path, &mapped).IsOk()) {
+      hash->UpdateValue(static_cast<uint64_t>(mapped->ByteSize()));
+      hash->Update(mapped->Base(), mapped->ByteSize());
+    } else {
+      std::string file_contents;
+      RETURN_IF_ERROR(ReadTextFile(full_path, &file_contents));
+      hash->UpdateValue(static_cast<uint64_t>(file_contents.size()));
+      hash->Update(file_contents);
+    }
+  }
+  return Status::Success;
+}
+
+Status
+LoadResultKey(
+    const std::string& agent_name,
+    const TritonRepoAgent::Parameters& agent_parameters,
+    const inference::ModelConfig& config,
+    const TRITONREPOAGENT_ArtifactType type, const std::string& location,
+    uint64_t* key)
+{
+  StreamingHash64 hash;
+  hash.Update(agent_name);
+  for (const auto& param : agent_parameters) {
+    hash.Update(param.first);
+    hash.Update(param.second);
+  }
+  hash.Update(config.SerializeAsString());
+  hash.UpdateValue(type);
+  hash.Update(location);
+  RETURN_IF_ERROR(FingerprintDirectory(location, &hash));
+  *key = hash.Digest();
+  return Status::Success;
+}
+
+}  // namespace
+
 std::string
 TritonRepoAgentLibraryName(const std::string& agent_name)
 {
@@ -175,8 +241,9 @@ TritonRepoAgentModel::Create(
 
 TritonRepoAgentModel::~TritonRepoAgentModel()
 {
-  // Need to ensure the proper lifecycle is informed
-  if (action_type_set_) {
+  // Need to ensure the proper lifecycle is informed, the agent is not
+  // aware of the model if the LOAD result was taken from the cache
+  if (action_type_set_ && !cached_) {
     switch (current_action_type_) {
       case TRITONREPOAGENT_ACTION_LOAD:
         LOG_TRITONSERVER_ERROR(
@@ -221,9 +288,11 @@ TritonRepoAgentModel::~TritonRepoAgentModel()
             reinterpret_cast<TRITONREPOAGENT_AgentModel*>(this)),
         "~TritonRepoAgentModel");
   }
-  if (!acquired_location_.empty()) {
-    DeleteMutableLocation();
+  if (holds_result_) {
+    TritonRepoAgentManager::ReleaseLoadResult(
+        agent_->Name(), result_location_, result_key_);
   }
+  acquired_.reset();
 }
 
 Status
@@ -276,12 +345,118 @@ TritonRepoAgentModel::InvokeAgent(const TRITONREPOAGENT_ActionType action_type)
   }
   current_action_type_ = action_type;
   action_type_set_ = true;
+  if (action_type == TRITONREPOAGENT_ACTION_LOAD) {
+    return InvokeLoad();
+  }
+  if (cached_) {
+    return Status::Success;
+  }
   RETURN_IF_TRITONSERVER_ERROR(agent_->AgentModelActionFn()(
       reinterpret_cast<TRITONREPOAGENT_Agent*>(agent_.get()),
       reinterpret_cast<TRITONREPOAGENT_AgentModel*>(this), action_type));
   return Status::Success;
 }
 
+Status
+TritonRepoAgentModel::InvokeLoad()
+{
+  const TRITONREPOAGENT_ArtifactType original_type = type_;
+  const std::string original_location = location_;
+
+  // Only fingerprint the model files once the agent has declared a
+  // result as cacheable, the other agents don't pay for the lookup
+  uint64_t key = 0;
+  bool has_key = false;
+  if (agent_->ResultsCacheable()) {
+    has_key = LoadResultKey(
+                  agent_->Name(), agent_parameters_, config_, original_type,
+                  original_location, &key)
+                  .IsOk();
+    TritonRepoAgentLoadResult result;
+    if (has_key && TritonRepoAgentManager::FindLoadResult(
+                       agent_->Name(), original_location, key, &result)) {
+      type_ = result.type_;
+      location_ = result.location_;
+      acquired_ = result.acquired_;
+      cached_ = true;
+      result_location_ = original_location;
+      result_key_ = key;
+      holds_result_ = true;
+      LOG_VERBOSE(1) << "Reusing the result of repository agent '"
+                     << agent_->Name() << "' for '" << original_location
+                     << "'";
+      return Status::Success;
+    }
+  }
+
+  RETURN_IF_TRITONSERVER_ERROR(agent_->AgentModelActionFn()(
+      reinterpret_cast<TRITONREPOAGENT_Agent*>(agent_.get()),
+      reinterpret_cast<TRITONREPOAGENT_AgentModel*>(this),
+      TRITONREPOAGENT_ACTION_LOAD));
+  if (!cacheable_) {
+    return Status::Success;
+  }
+
+  // The result can only be reused if Triton controls the lifetime of
+  // the updated location, a location owned by the agent may be removed
+  // once the agent is done with this model.
+  const bool owned_location =
+      (location_ == original_location) ||
+      ((acquired_ != nullptr) && (location_ == acquired_->Path()));
+  if (!owned_location) {
+    LOG_VERBOSE(1) << "Result of repository agent '" << agent_->Name()
+                   << "' for '" << original_location
+                   << "' is not cached, the updated location must be "
+                      "acquired with "
+                      "TRITONREPOAGENT_ModelRepositoryLocationAcquire";
+    return Status::Success;
+  }
+  if (!has_key) {
+    auto status = LoadResultKey(
+        agent_->Name(), agent_parameters_, config_, original_type,
+        original_location, &key);
+    if (!status.IsOk()) {
+      LOG_VERBOSE(1) << "Result of repository agent '" << agent_->Name()
+                     << "' for '" << original_location
+                     << "' is not cached: " << status.AsString();
+      return Status::Success;
+    }
+  }
+
+  TritonRepoAgentLoadResult result;
+  result.key_ = key;
+  result.type_ = type_;
+  result.location_ = location_;
+  if (location_ != original_location) {
+    result.acquired_ = acquired_;
+  }
+  TritonRepoAgentManager::AddLoadResult(
+      agent_->Name(), original_location, result);
+  result_location_ = original_location;
+  result_key_ = key;
+  holds_result_ = true;
+  return Status::Success;
+}
+
+Status
+TritonRepoAgentModel::SetResultCacheable(const bool cacheable)
+{
+  if (current_action_type_ != TRITONREPOAGENT_ACTION_LOAD) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "result can only be declared cacheable during "
+        "TRITONREPOAGENT_ACTION_LOAD, current action type is " +
+            (action_type_set_
+                 ? TRITONREPOAGENT_ActionTypeString(current_action_type_)
+                 : "not set"));
+  }
+  cacheable_ = cacheable;
+  if (cacheable) {
+    agent_->SetResultsCacheable();
+  }
+  return Status::Success;
+}
+
 Status
 TritonRepoAgentModel::SetLocation(
     const TRITONREPOAGENT_ArtifactType type, const std::string& location)
@@ -323,32 +498,47 @@ TritonRepoAgentModel::AcquireMutableLocation(
         "Unexpected artifact type, expects "
         "'TRITONREPOAGENT_ARTIFACT_FILESYSTEM'");
   }
-  if (acquired_location_.empty()) {
-    std::string lacquired_location;
-    RETURN_IF_ERROR(
-        MakeTemporaryDirectory(FileSystemType::LOCAL, &lacquired_location));
-    acquired_location_.swap(lacquired_location);
+  if (acquired_ == nullptr) {
+    RETURN_IF_ERROR(TritonRepoAgentLocation::Create(&acquired_));
     acquired_type_ = type;
   }
-  *location = acquired_location_.c_str();
+  *location = acquired_->Path().c_str();
   return Status::Success;
 }
 
 Status
 TritonRepoAgentModel::DeleteMutableLocation()
 {
-  if (acquired_location_.empty()) {
+  if (acquired_ == nullptr) {
     return Status(
         Status::Code::UNAVAILABLE, "No mutable location to be deleted");
   }
 
-  auto status = DeleteDirectory(acquired_location_);
+  // The directory is deleted once no cached result references it
+  acquired_.reset();
+  return Status::Success;
+}
+
+//
+// TritonRepoAgentLocation
+//
+Status
+TritonRepoAgentLocation::Create(
+    std::shared_ptr<TritonRepoAgentLocation>* location)
+{
+  std::string path;
+  RETURN_IF_ERROR(MakeTemporaryDirectory(FileSystemType::LOCAL, &path));
+  location->reset(new TritonRepoAgentLocation(path));
+  return Status::Success;
+}
+
+TritonRepoAgentLocation::~TritonRepoAgentLocation()
+{
+  auto status = DeleteDirectory(path_);
   if (!status.IsOk()) {
-    LOG_ERROR << "Failed to delete previously acquired location '"
-              << acquired_location_ << "': " << status.AsString();
+    LOG_ERROR << "Failed to delete previously acquired location '" << path_
+              << "': " << status.AsString();
   }
-  acquired_location_.clear();
-  return Status::Success;
 }
 
 //
@@ -444,6 +634,62 @@ TritonRepoAgentManager::AgentState(
   return Status::Success;
 }
 
+bool
+TritonRepoAgentManager::FindLoadResult(
+    const std::string& agent_name, const std::string& location,
+    const uint64_t key, TritonRepoAgentLoadResult* result)
+{
+  auto& singleton_manager = Singleton();
+  std::lock_guard<std::mutex> lock(singleton_manager.result_mu_);
+
+  const auto itr =
+      singleton_manager.load_results_.find(agent_name + ":" + location);
+  if ((itr == singleton_manager.load_results_.end()) ||
+      (itr->second.key_ != key)) {
+    return false;
+  }
+  itr->second.users_++;
+  *result = itr->second;
+  return true;
+}
+
+void
+TritonRepoAgentManager::AddLoadResult(
+    const std::string& agent_name, const std::string& location,
+    const TritonRepoAgentLoadResult& result)
+{
+  auto& singleton_manager = Singleton();
+  std::lock_guard<std::mutex> lock(singleton_manager.result_mu_);
+  auto& cached = singleton_manager.load_results_[agent_name + ":" + location];
+  // A concurrent load of the same files may have added its result first,
+  // the first result is kept.
+  if ((cached.users_ != 0) && (cached.key_ == result.key_)) {
+    cached.users_++;
+    return;
+  }
+  cached = result;
+  cached.users_ = 1;
+}
+
+void
+TritonRepoAgentManager::ReleaseLoadResult(
+    const std::string& agent_name, const std::string& location,
+    const uint64_t key)
+{
+  auto& singleton_manager = Singleton();
+  std::lock_guard<std::mutex> lock(singleton_manager.result_mu_);
+  const auto itr =
+      singleton_manager.load_results_.find(agent_name + ":" + location);
+  // The result may have been replaced by the result of newer files
+  if ((itr == singleton_manager.load_results_.end()) ||
+      (itr->second.key_ != key)) {
+    return;
+  }
+  if (--itr->second.users_ == 0) {
+    singleton_manager.load_results_.erase(itr);
+  }
+}
+
 extern "C" {
 
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
@@ -495,6 +741,16 @@ TRITONREPOAGENT_ModelRepositoryUpdate(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONREPOAGENT_ModelSetResultCacheable(
+    TRITONREPOAGENT_Agent* agent, TRITONREPOAGENT_AgentModel* model,
+    const bool cacheable)
+{
+  TritonRepoAgentModel* tam = reinterpret_cast<TritonRepoAgentModel*>(model);
+  RETURN_TRITONSERVER_ERROR_IF_ERROR(tam->SetResultCacheable(cacheable));
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONREPOAGENT_ModelParameterCount(
     TRITONREPOAGENT_Agent* agent, TRITONREPOAGENT_AgentModel* model,
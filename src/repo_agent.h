@@ -27,6 +27,7 @@
 
 #include "tritonserver_apis.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -83,13 +84,18 @@ class TritonRepoAgent {
     return model_fini_fn_;
   }
 
+  // Whether any model of the agent has declared its LOAD result as
+  // cacheable, so that new loads should look for a cached result.
+  bool ResultsCacheable() const { return results_cacheable_; }
+  void SetResultsCacheable() { results_cacheable_ = true; }
+
  protected:
   DISALLOW_COPY_AND_ASSIGN(TritonRepoAgent);
 
   TritonRepoAgent(const std::string& name)
       : name_(name), state_(nullptr), dlhandle_(nullptr), init_fn_(nullptr),
         fini_fn_(nullptr), model_init_fn_(nullptr), model_fini_fn_(nullptr),
-        model_action_fn_(nullptr)
+        model_action_fn_(nullptr), results_cacheable_(false)
   {
   }
   const std::string name_;
@@ -102,6 +108,39 @@ class TritonRepoAgent {
   TritonRepoAgentModelInitFn_t model_init_fn_;
   TritonRepoAgentModelFiniFn_t model_fini_fn_;
   TritonRepoAgentModelActionFn_t model_action_fn_;
+
+  std::atomic<bool> results_cacheable_;
+};
+
+// A local directory acquired for an agent model, deleted once the last
+// reference is released. A cached agent result holds a reference so
+// the directory outlives the agent model that produced it.
+class TritonRepoAgentLocation {
+ public:
+  static Status Create(std::shared_ptr<TritonRepoAgentLocation>* location);
+  ~TritonRepoAgentLocation();
+
+  const std::string& Path() const { return path_; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TritonRepoAgentLocation);
+
+  explicit TritonRepoAgentLocation(const std::string& path) : path_(path) {}
+
+  const std::string path_;
+};
+
+// The model location produced by the LOAD action of an agent.
+struct TritonRepoAgentLoadResult {
+  // Fingerprint of the agent, its parameters, the model config and the
+  // files at the original location.
+  uint64_t key_;
+  TRITONREPOAGENT_ArtifactType type_;
+  std::string location_;
+  std::shared_ptr<TritonRepoAgentLocation> acquired_;
+  // Number of models using the result, the result is evicted once the
+  // last of them is unloaded.
+  size_t users_ = 0;
 };
 
 class TritonRepoAgentModel {
@@ -131,6 +170,11 @@ class TritonRepoAgentModel {
   Status DeleteMutableLocation();
   const inference::ModelConfig Config() { return config_; }
 
+  // Declare whether the result of the current LOAD action only depends
+  // on the agent parameters, the model config and the model files, so
+  // it can be reused by later loads of identical files.
+  Status SetResultCacheable(const bool cacheable);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TritonRepoAgentModel);
 
@@ -142,10 +186,14 @@ class TritonRepoAgentModel {
       : state_(nullptr), config_(config), agent_(agent),
         agent_parameters_(agent_parameters), type_(type), location_(location),
         action_type_set_(false),
-        current_action_type_(TRITONREPOAGENT_ACTION_UNLOAD_COMPLETE)
+        current_action_type_(TRITONREPOAGENT_ACTION_UNLOAD_COMPLETE),
+        cacheable_(false), cached_(false), result_key_(0),
+        holds_result_(false)
   {
   }
 
+  Status InvokeLoad();
+
   void* state_;
   const inference::ModelConfig config_;
   const std::shared_ptr<TritonRepoAgent> agent_;
@@ -153,9 +201,21 @@ class TritonRepoAgentModel {
   TRITONREPOAGENT_ArtifactType type_;
   std::string location_;
   TRITONREPOAGENT_ArtifactType acquired_type_;
-  std::string acquired_location_;
+  std::shared_ptr<TritonRepoAgentLocation> acquired_;
   bool action_type_set_;
   TRITONREPOAGENT_ActionType current_action_type_;
+
+  // Whether the agent declared the LOAD result as cacheable, and
+  // whether the LOAD result was taken from the cache, in which case
+  // the agent is not informed of any action on this model.
+  bool cacheable_;
+  bool cached_;
+
+  // The cached LOAD result used by this model, released when the model
+  // is destroyed.
+  std::string result_location_;
+  uint64_t result_key_;
+  bool holds_result_;
 };
 
 class TritonRepoAgentManager {
@@ -168,6 +228,26 @@ class TritonRepoAgentManager {
       std::unique_ptr<std::unordered_map<std::string, std::string>>*
           agent_state);
 
+  // Return in 'result' the cached LOAD result of 'agent_name' for the
+  // model at 'location', false if there is none matching 'key'. A result
+  // that is found is used until it is released by ReleaseLoadResult().
+  static bool FindLoadResult(
+      const std::string& agent_name, const std::string& location,
+      const uint64_t key, TritonRepoAgentLoadResult* result);
+
+  // Cache the LOAD result of 'agent_name' for the model at 'location',
+  // replacing the one of previous files at the same location. The result
+  // is used until it is released by ReleaseLoadResult().
+  static void AddLoadResult(
+      const std::string& agent_name, const std::string& location,
+      const TritonRepoAgentLoadResult& result);
+
+  // Release a use of the LOAD result of 'agent_name' for the model at
+  // 'location' with 'key', the result is evicted once it has no use.
+  static void ReleaseLoadResult(
+      const std::string& agent_name, const std::string& location,
+      const uint64_t key);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TritonRepoAgentManager);
 
@@ -177,6 +257,10 @@ class TritonRepoAgentManager {
   std::mutex mu_;
   std::string global_search_path_;
   std::unordered_map<std::string, std::weak_ptr<TritonRepoAgent>> agent_map_;
+
+  // Cached LOAD results, keyed by agent name and original location.
+  std::mutex result_mu_;
+  std::unordered_map<std::string, TritonRepoAgentLoadResult> load_results_;
 };
 
 }}  // namespace triton::core
@@ -38,8 +38,10 @@ class ResponseAllocator {
       TRITONSERVER_ResponseAllocatorAllocFn_t alloc_fn,
       TRITONSERVER_ResponseAllocatorReleaseFn_t release_fn,
       TRITONSERVER_ResponseAllocatorStartFn_t start_fn)
-      : alloc_fn_(alloc_fn), buffer_attributes_fn_(nullptr), query_fn_(nullptr),
-        release_fn_(release_fn), start_fn_(start_fn)
+      : alloc_fn_(alloc_fn), batch_alloc_fn_(nullptr),
+        buffer_attributes_fn_(nullptr), query_fn_(nullptr),
+        release_fn_(release_fn), start_fn_(start_fn),
+        borrowed_buffers_accepted_(false)
   {
   }
 
@@ -54,7 +56,22 @@ class ResponseAllocator {
     buffer_attributes_fn_ = buffer_attributes_fn;
   }
 
+  void SetBatchAllocFunction(
+      TRITONSERVER_ResponseAllocatorBatchAllocFn_t batch_alloc_fn)
+  {
+    batch_alloc_fn_ = batch_alloc_fn;
+  }
+
+  void SetBorrowedBuffersAccepted(bool accepted)
+  {
+    borrowed_buffers_accepted_ = accepted;
+  }
+
   TRITONSERVER_ResponseAllocatorAllocFn_t AllocFn() const { return alloc_fn_; }
+  TRITONSERVER_ResponseAllocatorBatchAllocFn_t BatchAllocFn() const
+  {
+    return batch_alloc_fn_;
+  }
   TRITONSERVER_ResponseAllocatorBufferAttributesFn_t BufferAttributesFn() const
   {
     return buffer_attributes_fn_;
@@ -66,12 +83,18 @@ class ResponseAllocator {
   }
   TRITONSERVER_ResponseAllocatorStartFn_t StartFn() const { return start_fn_; }
 
+  // Whether the client accepts output buffers in CPU memory that are
+  // owned by Triton instead of being allocated through 'alloc_fn_'.
+  bool BorrowedBuffersAccepted() const { return borrowed_buffers_accepted_; }
+
  private:
   TRITONSERVER_ResponseAllocatorAllocFn_t alloc_fn_;
+  TRITONSERVER_ResponseAllocatorBatchAllocFn_t batch_alloc_fn_;
   TRITONSERVER_ResponseAllocatorBufferAttributesFn_t buffer_attributes_fn_;
   TRITONSERVER_ResponseAllocatorQueryFn_t query_fn_;
   TRITONSERVER_ResponseAllocatorReleaseFn_t release_fn_;
   TRITONSERVER_ResponseAllocatorStartFn_t start_fn_;
+  bool borrowed_buffers_accepted_;
 };
 
 }}  // namespace triton::core
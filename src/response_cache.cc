@@ -25,9 +25,21 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "response_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include "cuda_utils.h"
 #include "infer_stats.h"
+#include "pinned_memory_manager.h"
 #include "triton/common/logging.h"
 
+#ifdef TRITON_ENABLE_GPU
+#include "cuda_memory_manager.h"
+#endif  // TRITON_ENABLE_GPU
+
 namespace {
 
 enum class ScopedTimerType { INSERTION, LOOKUP };
@@ -35,8 +47,8 @@ enum class ScopedTimerType { INSERTION, LOOKUP };
 class ScopedTimer {
  public:
   explicit ScopedTimer(
-      triton::core::InferenceRequest& request, uint64_t& duration,
-      ScopedTimerType type)
+      triton::core::InferenceRequest& request,
+      std::atomic<uint64_t>& duration, ScopedTimerType type)
       : request_(request), duration_(duration), type_(type)
   {
     switch (type_) {
@@ -67,7 +79,7 @@ class ScopedTimer {
 
  private:
   triton::core::InferenceRequest& request_;
-  uint64_t& duration_;
+  std::atomic<uint64_t>& duration_;
   ScopedTimerType type_;
 };
 
@@ -83,63 +95,351 @@ PointerToString(void* ptr)
 
 namespace triton { namespace core {
 
+namespace {
+
+// Copy 'byte_size' bytes between any two memory types on 'cuda_stream' and
+// wait for the copy to complete
+Status
+CopyBufferSync(
+    const std::string& msg, const TRITONSERVER_MemoryType src_memory_type,
+    const int64_t src_memory_type_id,
+    const TRITONSERVER_MemoryType dst_memory_type,
+    const int64_t dst_memory_type_id, const size_t byte_size, const void* src,
+    void* dst, cudaStream_t cuda_stream)
+{
+  bool cuda_used = false;
+  RETURN_IF_ERROR(CopyBuffer(
+      msg, src_memory_type, src_memory_type_id, dst_memory_type,
+      dst_memory_type_id, byte_size, src, dst, cuda_stream, &cuda_used));
+#ifdef TRITON_ENABLE_GPU
+  if (cuda_used) {
+    RETURN_IF_CUDA_ERR(
+        cudaStreamSynchronize(cuda_stream),
+        msg + ": failed to synchronize CUDA copy");
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return Status::Success;
+}
+
+// Version of the layout of serialized cache entries, bumped whenever the
+// layout changes so that servers of different versions sharing a remote
+// tier don't misread each other's entries
+constexpr uint32_t kSerializedEntryVersion = 2;
+
+// Leading bytes of a response cache snapshot file, "TRTCSNAP"
+constexpr uint64_t kSnapshotMagic = 0x50414E5343545254ULL;
+
+// Prefix of the remote tier keys of response cache entries
+constexpr char kRemoteKeyPrefix[] = "triton_response_cache_";
+
+// Append the raw bytes of 'value' to 'buffer'. Entries are serialized in
+// host byte order, servers sharing a remote tier must share the byte order
+template <typename T>
+void
+AppendValue(const T& value, std::string* buffer)
+{
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Read a value written by AppendValue() at 'offset' of 'buffer' and
+// advance 'offset'. Return false if 'buffer' is too short.
+template <typename T>
+bool
+ReadValue(const std::string& buffer, size_t* offset, T* value)
+{
+  if ((buffer.size() < *offset) || ((buffer.size() - *offset) < sizeof(T))) {
+    return false;
+  }
+  std::memcpy(value, buffer.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return true;
+}
+
+// Returns the bytes of storage used by the outputs of 'entry'
+uint64_t
+EntryByteSize(const CacheEntry& entry)
+{
+  uint64_t byte_size = 0;
+  for (const auto& output : entry.outputs_) {
+    byte_size += output.buffer_size_;
+  }
+  return byte_size;
+}
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Returns whether 'entry' was produced by a request to the same model as
+// 'request'
+bool
+SameModel(const CacheEntry& entry, const InferenceRequest& request)
+{
+  return (entry.model_version_ == request.ActualModelVersion()) &&
+         (entry.model_name_ == request.ModelName());
+}
+
+}  // namespace
+
 Status
 RequestResponseCache::Create(
     uint64_t cache_size, std::unique_ptr<RequestResponseCache>* cache)
 {
-  cache->reset(new RequestResponseCache(cache_size));
+  return Create(Options(cache_size), cache);
+}
+
+Status
+RequestResponseCache::Create(
+    const Options& options, std::unique_ptr<RequestResponseCache>* cache)
+{
+  if (options.num_shards_ == 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "response cache must have at least one shard");
+  }
+
+  switch (options.memory_type_) {
+    case TRITONSERVER_MEMORY_CPU:
+      break;
+    case TRITONSERVER_MEMORY_GPU:
+#ifdef TRITON_ENABLE_GPU
+      break;
+#else
+      return Status(
+          Status::Code::UNSUPPORTED,
+          "response cache in GPU memory requires GPU support");
+#endif  // TRITON_ENABLE_GPU
+    default:
+      return Status(
+          Status::Code::INVALID_ARG,
+          "response cache can only be stored in CPU or GPU memory");
+  }
+
+  // Validate the eviction policy before allocating the cache buffer
+  std::unique_ptr<CacheEvictionPolicy> policy;
+  RETURN_IF_ERROR(CacheEvictionPolicy::Create(
+      options.eviction_policy_, options.cache_size_, &policy));
+
+  cache->reset(new RequestResponseCache(options));
+  if (!options.snapshot_path_.empty()) {
+    // A warm restart is best effort, the cache starts with the entries
+    // restored so far if the snapshot can't be used
+    Status status = (*cache)->RestoreSnapshot(options.snapshot_path_);
+    if (!status.IsOk()) {
+      LOG_WARNING << "failed to restore response cache snapshot: "
+                  << status.Message();
+    }
+  }
+  if (options.remote_tier_ != nullptr) {
+    (*cache)->remote_writer_ =
+        std::thread(&RequestResponseCache::RemoteWriteThread, cache->get());
+  }
 
   return Status::Success;
 }
 
-RequestResponseCache::RequestResponseCache(const uint64_t size)
+RequestResponseCache::RequestResponseCache(const Options& options)
+    : collision_safe_(options.collision_safe_),
+      eviction_policy_(options.eviction_policy_),
+      memory_type_(options.memory_type_),
+      memory_type_id_(options.memory_type_id_), copy_stream_(nullptr),
+      next_evict_shard_(0),
+      total_lookup_latency_ns_(0), total_insertion_latency_ns_(0),
+      snapshot_path_(options.snapshot_path_),
+      remote_tier_(options.remote_tier_),
+      remote_lookup_timeout_us_(options.remote_lookup_timeout_us_),
+      remote_write_queue_size_(options.remote_write_queue_size_),
+      num_remote_hits_(0), num_remote_timeouts_(0), remote_exit_(false)
 {
+  const uint64_t size = options.cache_size_;
+  const uint32_t num_shards = options.num_shards_;
+
+#ifdef TRITON_ENABLE_GPU
+  // Responses may live in device memory even when the cache does not, so the
+  // copy stream is created regardless of the cache memory type. On failure
+  // copies fall back to the default stream.
+  auto cuerr = cudaStreamCreateWithFlags(&copy_stream_, cudaStreamNonBlocking);
+  if (cuerr != cudaSuccess) {
+    copy_stream_ = nullptr;
+    LOG_ERROR << "unable to create stream for response cache copies: "
+              << cudaGetErrorString(cuerr);
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  // GPU storage is allocated per output from the CUDA memory manager, only
+  // the byte size is split across shards
+  if (memory_type_ == TRITONSERVER_MEMORY_GPU) {
+    for (uint32_t idx = 0; idx < num_shards; ++idx) {
+      std::shared_ptr<Shard> shard(new Shard());
+      shard->memory_type_ = memory_type_;
+      shard->memory_type_id_ = memory_type_id_;
+      shard->device_byte_size_ = size / num_shards;
+      shard->index_ = idx;
+      // The policy kind was validated in Create()
+      CacheEvictionPolicy::Create(
+          eviction_policy_, shard->device_byte_size_, &shard->policy_);
+      shards_.emplace_back(std::move(shard));
+    }
+
+    LOG_INFO << "Response Cache is created on GPU " << memory_type_id_
+             << " with size " << size << " in " << num_shards << " shard(s)"
+             << " using " << CacheEvictionPolicyKindString(eviction_policy_)
+             << " eviction" << (collision_safe_ ? ", collision-safe" : "");
+    return;
+  }
+
   // Allocate buffer
-  buffer_ = malloc(size);
+  void* buffer = malloc(size);
   // Exit early if buffer allocation failed
-  if (buffer_ == nullptr) {
+  if (buffer == nullptr) {
     throw std::runtime_error("failed to allocate buffer");
   }
+  buffer_.reset(buffer, free);
+
+  // Slice the buffer evenly across shards, keeping each slice aligned so
+  // that the managed buffers can be placed at the start of the slice.
+  constexpr uint64_t kSliceAlignment = 64;
+  const uint64_t slice_size =
+      (num_shards == 1) ? size : (size / num_shards) & ~(kSliceAlignment - 1);
+  char* base = reinterpret_cast<char*>(buffer);
+  for (uint32_t idx = 0; idx < num_shards; ++idx) {
+    std::shared_ptr<Shard> shard(new Shard());
+    shard->buffer_ = buffer_;
+    shard->index_ = idx;
+    // Create shard as managed buffer
+    shard->managed_buffer_ = boost::interprocess::managed_external_buffer(
+        boost::interprocess::create_only_t{}, base + idx * slice_size,
+        slice_size);
+    // The policy kind was validated in Create()
+    CacheEvictionPolicy::Create(eviction_policy_, slice_size, &shard->policy_);
+    shards_.emplace_back(std::move(shard));
+  }
 
-  // Create cache as managed buffer
-  managed_buffer_ = boost::interprocess::managed_external_buffer(
-      boost::interprocess::create_only_t{}, buffer_, size);
-
-  LOG_INFO << "Response Cache is created at '" << PointerToString(buffer_)
-           << "' with size " << size;
+  LOG_INFO << "Response Cache is created at '" << PointerToString(buffer)
+           << "' with size " << size << " in " << num_shards << " shard(s)"
+           << " using " << CacheEvictionPolicyKindString(eviction_policy_)
+           << " eviction"
+           << (collision_safe_ ? ", collision-safe" : "");
 }
 
 RequestResponseCache::~RequestResponseCache()
 {
-  // Deallocate each chunk from managed buffer
-  for (auto& iter : cache_) {
-    auto& entry = iter.second;
-    for (auto& output : entry.outputs_) {
-      if (output.buffer_ != nullptr) {
-        managed_buffer_.deallocate(output.buffer_);
-      }
+  // Stop the write-back thread first, writes still pending are dropped
+  if (remote_writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(remote_mu_);
+      remote_exit_ = true;
+    }
+    remote_cv_.notify_one();
+    remote_writer_.join();
+  }
+  remote_writes_.clear();
+
+  if (!snapshot_path_.empty()) {
+    Status status = WriteSnapshot(snapshot_path_);
+    if (!status.IsOk()) {
+      LOG_ERROR << "failed to write response cache snapshot: "
+                << status.Message();
     }
   }
 
-  // Validate we freed all underlying memory managed by cache
-  if (!managed_buffer_.all_memory_deallocated()) {
+  for (auto& shard : shards_) {
+    // Release each entry, which deallocates its chunks from managed buffer
+    // unless the entry is still pinned by a response. Pinned entries keep
+    // the shard and the cache buffer alive until they are released.
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    shard->cache_.clear();
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  if (copy_stream_ != nullptr) {
+    cudaError_t err = cudaStreamDestroy(copy_stream_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+}
+
+RequestResponseCache::Shard::~Shard()
+{
+  // Validate we freed all underlying memory managed by shard
+  const bool all_memory_deallocated =
+      (memory_type_ == TRITONSERVER_MEMORY_GPU)
+          ? (device_allocated_bytes_ == 0)
+          : managed_buffer_.all_memory_deallocated();
+  if (!all_memory_deallocated) {
     // Destructors can't throw exceptions
     LOG_ERROR << "failed to free managed cache memory";
   }
+}
+
+void*
+RequestResponseCache::Shard::Allocate(const size_t byte_size)
+{
+  if (memory_type_ != TRITONSERVER_MEMORY_GPU) {
+    return managed_buffer_.allocate(byte_size, std::nothrow_t{});
+  }
 
-  // Free total cache buffer
-  if (buffer_ != nullptr) {
-    free(buffer_);
+  void* buffer = nullptr;
+#ifdef TRITON_ENABLE_GPU
+  if (byte_size > (device_byte_size_ - device_allocated_bytes_)) {
+    return nullptr;
+  }
+  Status status = CudaMemoryManager::Alloc(&buffer, byte_size, memory_type_id_);
+  if (!status.IsOk()) {
+    LOG_VERBOSE(1) << "failed to allocate GPU memory for cache entry: "
+                   << status.Message();
+    return nullptr;
   }
+  device_allocated_bytes_ += byte_size;
+#endif  // TRITON_ENABLE_GPU
+  return buffer;
+}
+
+void
+RequestResponseCache::Shard::Deallocate(void* buffer, const size_t byte_size)
+{
+  if (memory_type_ != TRITONSERVER_MEMORY_GPU) {
+    managed_buffer_.deallocate(buffer);
+    return;
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  Status status = CudaMemoryManager::Free(buffer, memory_type_id_);
+  if (!status.IsOk()) {
+    LOG_ERROR << "failed to release GPU memory of cache entry: "
+              << status.Message();
+  }
+  device_allocated_bytes_ -= byte_size;
+#endif  // TRITON_ENABLE_GPU
+}
+
+size_t
+RequestResponseCache::Shard::TotalBytes()
+{
+  return (memory_type_ == TRITONSERVER_MEMORY_GPU)
+             ? device_byte_size_
+             : managed_buffer_.get_size();
+}
+
+size_t
+RequestResponseCache::Shard::FreeBytes()
+{
+  return (memory_type_ == TRITONSERVER_MEMORY_GPU)
+             ? (device_byte_size_ - device_allocated_bytes_)
+             : managed_buffer_.get_free_memory();
 }
 
 Status
 RequestResponseCache::Lookup(
     InferenceResponse* const response, InferenceRequest* const request)
 {
-  // Lock on cache lookup
-  std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-
   if (request == nullptr) {
     return Status(
         Status::Code::INTERNAL, "Cache Lookup passed a nullptr request");
@@ -154,34 +454,72 @@ RequestResponseCache::Lookup(
     RETURN_IF_ERROR(HashAndSet(request));
   }
   const uint64_t key = request->CacheKey();
+  const auto& shard = ShardForKey(key);
 
-  num_lookups_++;
-  LOG_VERBOSE(1) << request->LogRequest()
-                 << "Looking up key [" + std::to_string(key) + "] in cache.";
+  // Hold a reference on the entry so it stays valid after the shard lock is
+  // released, even if it is evicted in the meantime
+  std::shared_ptr<CacheEntry> entry;
+  {
+    // Lock on shard lookup
+    std::lock_guard<std::mutex> lk(shard->mtx_);
 
-  // Search cache for request hash key
-  auto iter = cache_.find(key);
-  if (iter == cache_.end()) {
-    num_misses_++;
+    shard->num_lookups_++;
     LOG_VERBOSE(1) << request->LogRequest()
-                   << "MISS for key [" + std::to_string(key) + "] in cache.";
+                   << "Looking up key [" + std::to_string(key) + "] in cache.";
+
+    // Search cache for request hash key
+    auto iter = shard->cache_.find(key);
+    if (iter == shard->cache_.end()) {
+      shard->num_misses_++;
+      shard->policy_->OnMiss(key);
+      LOG_VERBOSE(1) << request->LogRequest()
+                     << "MISS for key [" + std::to_string(key) + "] in cache.";
+    } else if (
+        collision_safe_ && (iter->second->digest_ != request->CacheDigest())) {
+      // In collision-safe mode a hit requires the secondary digest to match
+      // as well, otherwise the key collided with another request
+      shard->num_misses_++;
+      shard->policy_->OnMiss(key);
+      LOG_VERBOSE(1) << request->LogRequest()
+                     << "MISS for key [" + std::to_string(key) +
+                            "] in cache, digest mismatch.";
+    } else if (!SameModel(*iter->second, *request)) {
+      // A restored entry of a model that changed version since the
+      // snapshot was taken
+      shard->num_misses_++;
+      shard->policy_->OnMiss(key);
+      LOG_VERBOSE(1) << request->LogRequest()
+                     << "MISS for key [" + std::to_string(key) +
+                            "] in cache, model mismatch.";
+    } else {
+      // If find succeeds, it's a cache hit
+      shard->num_hits_++;
+      LOG_VERBOSE(1) << request->LogRequest()
+                     << "HIT for key [" + std::to_string(key) + "] in cache.";
+
+      entry = iter->second;
+      shard->policy_->OnHit(key);
+      // Keep the entries of the model in use order for its quota
+      auto& lru = entry->usage_->lru_[shard->index_];
+      lru.splice(lru.begin(), lru, entry->lru_iter_);
+      entry->last_use_ns_ = NowNs();
+    }
+  }
+
+  // Fall back to the remote tier on a local miss
+  if ((entry == nullptr) &&
+      ((remote_tier_ == nullptr) ||
+       !LookupRemote(*request, key, shard, &entry))) {
     return Status(
         Status::Code::INTERNAL,
         request->LogRequest() + "key not found in cache");
   }
+  entry->usage_->hits_++;
 
-  // If find succeeds, it's a cache hit
-  num_hits_++;
-  LOG_VERBOSE(1) << request->LogRequest()
-                 << "HIT for key [" + std::to_string(key) + "] in cache.";
-
-  // Populate passed-in "response" from cache entry
-  auto entry = iter->second;
-  // Build InferenceResponse from CacheEntry
+  // Populate passed-in "response" from cache entry without holding the
+  // shard lock
   RETURN_IF_ERROR(BuildInferenceResponse(entry, response));
 
-  // Update this key to front of LRU list
-  UpdateLRU(iter);
   LOG_VERBOSE(1) << request->LogRequest()
                  << "Using cached response for key [" + std::to_string(key) +
                         "].";
@@ -192,9 +530,21 @@ Status
 RequestResponseCache::Insert(
     const InferenceResponse& response, InferenceRequest* const request)
 {
-  // Lock on cache insertion
-  std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
+  if (request == nullptr) {
+    return Status(
+        Status::Code::INTERNAL, "Cache Insert passed a nullptr request");
+  }
+
+  ModelPolicy policy;
+  auto usage = ModelUsage(request->ModelName(), &policy);
+  return Insert(response, request, usage, policy);
+}
 
+Status
+RequestResponseCache::Insert(
+    const InferenceResponse& response, InferenceRequest* const request,
+    const std::shared_ptr<CacheModelUsage>& usage, const ModelPolicy& policy)
+{
   if (request == nullptr) {
     return Status(
         Status::Code::INTERNAL, "Cache Insert passed a nullptr request");
@@ -209,109 +559,741 @@ RequestResponseCache::Insert(
     RETURN_IF_ERROR(HashAndSet(request));
   }
   const uint64_t key = request->CacheKey();
-
-  // Exit early if key already exists in cache
-  auto iter = cache_.find(key);
-  if (iter != cache_.end()) {
+  const auto& shard = ShardForKey(key);
+  const auto already_exists = [request, key]() {
     return Status(
         Status::Code::ALREADY_EXISTS, request->LogRequest() + "key [" +
                                           std::to_string(key) +
                                           "] already exists in cache");
+  };
+
+  // Lock on shard insertion
+  std::unique_lock<std::mutex> lk(shard->mtx_);
+
+  // Exit early if key already exists in cache
+  if (shard->cache_.find(key) != shard->cache_.end()) {
+    return already_exists();
+  }
+
+  // Exit early if the model policy doesn't admit the response
+  usage->misses_++;
+  uint64_t byte_size = 0;
+  std::string reason;
+  if (!Admit(response, policy, usage.get(), &byte_size, &reason)) {
+    usage->rejections_++;
+    return Status(
+        Status::Code::UNAVAILABLE, request->LogRequest() + "key [" +
+                                       std::to_string(key) +
+                                       "] not admitted to cache: " + reason);
+  }
+
+  // Make room within the quota of the model from its own entries. The
+  // quota is shared by the shards, so concurrent insertions may exceed it
+  // by the size of the entries being inserted.
+  if ((policy.byte_quota_ != 0) &&
+      ((usage->allocated_bytes_ + byte_size) > policy.byte_quota_)) {
+    lk.unlock();
+    if (!EvictModelEntries(usage.get(), policy.byte_quota_, byte_size)) {
+      usage->rejections_++;
+      return Status(
+          Status::Code::UNAVAILABLE,
+          request->LogRequest() + "key [" + std::to_string(key) +
+              "] not admitted to cache: model cache quota of " +
+              std::to_string(policy.byte_quota_) + " bytes is exhausted");
+    }
+    lk.lock();
+    // Another request may have inserted the key meanwhile
+    if (shard->cache_.find(key) != shard->cache_.end()) {
+      return already_exists();
+    }
   }
 
   // Construct cache entry from response
-  auto entry = CacheEntry();
-  RETURN_IF_ERROR(BuildCacheEntry(response, &entry));
+  auto entry = NewCacheEntry(shard);
+  RETURN_IF_ERROR(BuildCacheEntry(response, shard.get(), entry.get()));
+  entry->digest_ = request->CacheDigest();
+  entry->model_name_ = request->ModelName();
+  entry->model_version_ = request->ActualModelVersion();
 
   // Insert entry into cache
   LOG_VERBOSE(1) << request->LogRequest()
                  << "Inserting key [" + std::to_string(key) + "] into cache.";
-  auto cache_pair = cache_.insert({key, entry});
   // Exit early if cache insertion failed
-  if (!cache_pair.second) {
+  if (!AddEntry(key, entry, usage, shard.get())) {
     LOG_ERROR << request->LogRequest() << "Failed to insert key into map.";
     return Status(
         Status::Code::INTERNAL,
         request->LogRequest() + "Cache insertion failed");
   }
-  // Update LRU with new cache entry
-  auto cache_iter = cache_pair.first;
-  UpdateLRU(cache_iter);
+
+  if (remote_tier_ != nullptr) {
+    EnqueueRemoteWrite(key, entry);
+  }
 
   return Status::Success;
 }
 
-// LRU
+bool
+RequestResponseCache::LookupRemote(
+    const InferenceRequest& request, const uint64_t key,
+    const std::shared_ptr<Shard>& shard, std::shared_ptr<CacheEntry>* entry)
+{
+  // The state is shared with the callback since the remote tier may
+  // complete the lookup after the deadline expired
+  struct RemoteLookup {
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    bool found_ = false;
+    std::string value_;
+  };
+  auto lookup = std::make_shared<RemoteLookup>();
+  remote_tier_->Get(
+      kRemoteKeyPrefix + std::to_string(key),
+      [lookup](const Status& status, bool found, std::string&& value) {
+        {
+          std::lock_guard<std::mutex> lk(lookup->mu_);
+          lookup->done_ = true;
+          lookup->found_ = status.IsOk() && found;
+          if (lookup->found_) {
+            lookup->value_ = std::move(value);
+          }
+        }
+        lookup->cv_.notify_all();
+      });
+
+  {
+    std::unique_lock<std::mutex> lk(lookup->mu_);
+    if (!lookup->cv_.wait_for(
+            lk, std::chrono::microseconds(remote_lookup_timeout_us_),
+            [&lookup] { return lookup->done_; })) {
+      num_remote_timeouts_++;
+      LOG_VERBOSE(1) << request.LogRequest()
+                     << "Remote lookup of key [" + std::to_string(key) +
+                            "] exceeded the deadline.";
+      return false;
+    }
+  }
+  // The value is no longer written once the lookup is done
+  if (!lookup->found_) {
+    return false;
+  }
+
+  auto remote_entry = NewCacheEntry(shard);
+  {
+    // Lock on shard insertion
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    Status status =
+        DeserializeCacheEntry(lookup->value_, shard.get(), remote_entry.get());
+    if (!status.IsOk()) {
+      LOG_VERBOSE(1) << request.LogRequest()
+                     << "Failed to use remote entry for key [" +
+                            std::to_string(key) + "]: " + status.Message();
+      return false;
+    }
+    const auto matches = [this, &request](const CacheEntry& candidate) {
+      return (!collision_safe_ ||
+              (candidate.digest_ == request.CacheDigest())) &&
+             SameModel(candidate, request);
+    };
+    if (!matches(*remote_entry)) {
+      return false;
+    }
+
+    // Keep the local entry if another request inserted the key meanwhile,
+    // it must match the request as well.
+    if (!AddEntry(
+            key, remote_entry, ModelUsage(remote_entry->model_name_),
+            shard.get())) {
+      const auto it = shard->cache_.find(key);
+      if ((it == shard->cache_.end()) || !matches(*it->second)) {
+        return false;
+      }
+      remote_entry = it->second;
+    }
+    *entry = remote_entry;
+  }
+
+  num_remote_hits_++;
+  LOG_VERBOSE(1) << request.LogRequest()
+                 << "HIT for key [" + std::to_string(key) + "] in remote tier.";
+  return true;
+}
+
+Status
+RequestResponseCache::WriteSnapshot(const std::string& path)
+{
+  // Write to a temporary file that replaces the snapshot once complete so
+  // that a failed write doesn't leave a truncated snapshot behind
+  const std::string tmp_path = path + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to open response cache snapshot '" + tmp_path + "'");
+  }
+
+  // The snapshot is a fixed-size header followed by one record per entry,
+  // each a key and byte size followed by the serialized entry
+  std::string record;
+  AppendValue(kSnapshotMagic, &record);
+  AppendValue(kSerializedEntryVersion, &record);
+  out.write(record.data(), record.size());
+
+  size_t entry_count = 0;
+  std::string value;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    std::vector<uint64_t> keys;
+    shard->policy_->EvictionOrder(&keys);
+    for (const auto key : keys) {
+      auto iter = shard->cache_.find(key);
+      if (iter == shard->cache_.end()) {
+        continue;
+      }
+      Status status = SerializeCacheEntry(*iter->second, &value);
+      if (!status.IsOk()) {
+        out.close();
+        std::remove(tmp_path.c_str());
+        return status;
+      }
+      record.clear();
+      AppendValue(key, &record);
+      AppendValue(static_cast<uint64_t>(value.size()), &record);
+      out.write(record.data(), record.size());
+      out.write(value.data(), value.size());
+      ++entry_count;
+    }
+  }
+
+  out.close();
+  if (!out) {
+    std::remove(tmp_path.c_str());
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to write response cache snapshot '" + tmp_path + "'");
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return Status(
+        Status::Code::INTERNAL,
+        "failed to replace response cache snapshot '" + path + "'");
+  }
+
+  LOG_INFO << "Response Cache snapshot of " << entry_count
+           << " entries is written to '" << path << "'";
+  return Status::Success;
+}
+
+Status
+RequestResponseCache::RestoreSnapshot(const std::string& path)
+{
+  // No snapshot was taken yet
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return Status::Success;
+  }
+  const std::string snapshot(
+      (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  size_t offset = 0;
+  uint64_t magic = 0;
+  uint32_t version = 0;
+  if (!ReadValue(snapshot, &offset, &magic) || (magic != kSnapshotMagic) ||
+      !ReadValue(snapshot, &offset, &version) ||
+      (version != kSerializedEntryVersion)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "response cache snapshot '" + path + "' has an unsupported layout");
+  }
+
+  // Entries are inserted in eviction order, so if the cache is smaller
+  // than the snapshot the entries that would be evicted first are dropped
+  size_t entry_count = 0;
+  std::string value;
+  while (offset < snapshot.size()) {
+    uint64_t key = 0;
+    uint64_t value_size = 0;
+    if (!ReadValue(snapshot, &offset, &key) ||
+        !ReadValue(snapshot, &offset, &value_size) ||
+        ((snapshot.size() - offset) < value_size)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "response cache snapshot '" + path + "' is truncated");
+    }
+    value.assign(snapshot, offset, value_size);
+    offset += value_size;
+
+    const auto& shard = ShardForKey(key);
+    auto entry = NewCacheEntry(shard);
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    if (shard->cache_.find(key) != shard->cache_.end()) {
+      continue;
+    }
+    Status status = DeserializeCacheEntry(value, shard.get(), entry.get());
+    if (!status.IsOk()) {
+      LOG_VERBOSE(1) << "Skipping snapshot entry for key [" << key
+                     << "]: " << status.Message();
+      continue;
+    }
+    AddEntry(key, entry, ModelUsage(entry->model_name_), shard.get());
+    ++entry_count;
+  }
+
+  LOG_INFO << "Response Cache restored " << entry_count
+           << " entries from snapshot '" << path << "'";
+  return Status::Success;
+}
+
+void
+RequestResponseCache::EnqueueRemoteWrite(
+    const uint64_t key, const std::shared_ptr<CacheEntry>& entry)
+{
+  {
+    std::lock_guard<std::mutex> lk(remote_mu_);
+    if (remote_writes_.size() >= remote_write_queue_size_) {
+      LOG_VERBOSE(1) << "Remote write queue is full, dropping write of key ["
+                     << key << "].";
+      return;
+    }
+    remote_writes_.emplace_back(key, entry);
+  }
+  remote_cv_.notify_one();
+}
+
+void
+RequestResponseCache::RemoteWriteThread()
+{
+  while (true) {
+    std::pair<uint64_t, std::shared_ptr<CacheEntry>> write;
+    {
+      std::unique_lock<std::mutex> lk(remote_mu_);
+      remote_cv_.wait(
+          lk, [this] { return remote_exit_ || !remote_writes_.empty(); });
+      if (remote_exit_) {
+        break;
+      }
+      write = std::move(remote_writes_.front());
+      remote_writes_.pop_front();
+    }
+
+    std::string value;
+    Status status = SerializeCacheEntry(*write.second, &value);
+    // Release the entry before the remote write, which may block
+    write.second.reset();
+    if (status.IsOk()) {
+      status = remote_tier_->Put(
+          kRemoteKeyPrefix + std::to_string(write.first), value);
+    }
+    if (!status.IsOk()) {
+      LOG_VERBOSE(1) << "Failed to write key [" << write.first
+                     << "] to remote tier: " << status.Message();
+    }
+  }
+}
+
 Status
 RequestResponseCache::Evict()
 {
-  // Lock on cache eviction
-  std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
+  const size_t start = next_evict_shard_++;
+  for (size_t idx = 0; idx < shards_.size(); ++idx) {
+    Shard* shard = shards_[(start + idx) % shards_.size()].get();
+    // Lock on shard eviction
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    if (!shard->cache_.empty()) {
+      return EvictLocked(shard);
+    }
+  }
 
   // Nothing to evict if cache is empty
-  if (NumEntries() == 0) {
+  return Status(Status::Code::INTERNAL, "Cache is empty, nothing to evict.");
+}
+
+Status
+RequestResponseCache::EvictLocked(Shard* shard)
+{
+  // Nothing to evict if shard is empty
+  uint64_t victim_key = 0;
+  if (shard->cache_.empty() || !shard->policy_->Evict(&victim_key)) {
     return Status(Status::Code::INTERNAL, "Cache is empty, nothing to evict.");
   }
 
-  // Least recently used key in back of LRU list
-  uint64_t lru_key = lru_.back();
-  LOG_VERBOSE(1) << "Evicting key [" + std::to_string(lru_key) +
+  LOG_VERBOSE(1) << "Evicting key [" + std::to_string(victim_key) +
                         "] from cache.";
 
-  // Find cache entry for least recently used key
-  auto iter = cache_.find(lru_key);
+  // Find cache entry for the key selected by the eviction policy
+  auto iter = shard->cache_.find(victim_key);
   // Error check if key isn't in cache, but this shouldn't happen in evict
   // and probably indicates a bug
-  if (iter == cache_.end()) {
+  if (iter == shard->cache_.end()) {
     return Status(
         Status::Code::INTERNAL,
-        "key [" + std::to_string(lru_key) +
+        "key [" + std::to_string(victim_key) +
             "] not found in cache during eviction: this indicates a bug in the "
             "code");
   }
-  // Get size of cache entry being evicted to update available size
-  auto entry = iter->second;
-  // Free managed memory used in cache entry's outputs
-  for (auto& output : entry.outputs_) {
-    // Lock on buffer deallocation
-    std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
-    managed_buffer_.deallocate(output.buffer_);
-  }
 
-  // Remove LRU entry from cache
-  cache_.erase(lru_key);
-  // Remove LRU key from LRU list
-  lru_.pop_back();
+  // Remove entry from cache, managed memory used in the entry's outputs
+  // is freed once no lookup is referencing the entry anymore
+  RemoveEntry(shard, iter);
   // Increment number of evictions
-  num_evictions_++;
+  shard->num_evictions_++;
 
   return Status::Success;
 }
 
+void
+RequestResponseCache::RemoveEntry(
+    Shard* shard,
+    std::unordered_map<uint64_t, std::shared_ptr<CacheEntry>>::iterator iter)
+{
+  const auto& entry = iter->second;
+  entry->usage_->lru_[shard->index_].erase(entry->lru_iter_);
+  shard->cache_.erase(iter);
+}
+
+bool
+RequestResponseCache::EvictModelEntries(
+    CacheModelUsage* usage, const uint64_t byte_quota,
+    const uint64_t byte_size)
+{
+  const uint64_t allocated_bytes = usage->allocated_bytes_;
+  if ((allocated_bytes + byte_size) <= byte_quota) {
+    return true;
+  }
+  // An evicted entry pinned by a response is only released with the
+  // response, so count the bytes of the evicted entries instead of
+  // waiting for the usage of the model to drop
+  uint64_t needed_bytes = allocated_bytes + byte_size - byte_quota;
+  while (true) {
+    // The entries of the model are ordered within each shard, evict the
+    // least recently used of the oldest entries of the shards
+    Shard* victim_shard = nullptr;
+    uint64_t victim_use_ns = std::numeric_limits<uint64_t>::max();
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lk(shard->mtx_);
+      auto& lru = usage->lru_[shard->index_];
+      // Drop the stale keys whose entry is no longer in the shard, or
+      // was replaced by an entry of another model
+      auto iter = shard->cache_.end();
+      while (!lru.empty()) {
+        iter = shard->cache_.find(lru.back());
+        if ((iter != shard->cache_.end()) &&
+            (iter->second->usage_.get() == usage)) {
+          break;
+        }
+        lru.pop_back();
+      }
+      if (!lru.empty()) {
+        const auto& entry = iter->second;
+        if (entry->last_use_ns_ <= victim_use_ns) {
+          victim_shard = shard.get();
+          victim_use_ns = entry->last_use_ns_;
+        }
+      }
+    }
+    if (victim_shard == nullptr) {
+      return false;
+    }
+
+    // Lock on shard eviction, the oldest entry of the shard may have
+    // changed since the shard was visited
+    std::lock_guard<std::mutex> lk(victim_shard->mtx_);
+    auto& lru = usage->lru_[victim_shard->index_];
+    if (lru.empty()) {
+      continue;
+    }
+    const uint64_t victim_key = lru.back();
+    auto iter = victim_shard->cache_.find(victim_key);
+    if ((iter == victim_shard->cache_.end()) ||
+        (iter->second->usage_.get() != usage)) {
+      lru.pop_back();
+      continue;
+    }
+    const uint64_t victim_byte_size = EntryByteSize(*iter->second);
+    LOG_VERBOSE(1) << "Evicting key [" + std::to_string(victim_key) +
+                          "] from cache for the quota of its model.";
+    victim_shard->policy_->OnErase(victim_key);
+    RemoveEntry(victim_shard, iter);
+    victim_shard->num_evictions_++;
+    if (victim_byte_size >= needed_bytes) {
+      return true;
+    }
+    needed_bytes -= victim_byte_size;
+  }
+}
+
+size_t
+RequestResponseCache::NumEntries()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    total += shard->cache_.size();
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::NumEvictions()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    total += shard->num_evictions_;
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::NumLookups()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    total += shard->num_lookups_;
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::NumHits()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    total += shard->num_hits_;
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::NumMisses()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mtx_);
+    total += shard->num_misses_;
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::TotalBytes()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->buffer_mtx_);
+    total += shard->TotalBytes();
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::FreeBytes()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->buffer_mtx_);
+    total += shard->FreeBytes();
+  }
+  return total;
+}
+
+size_t
+RequestResponseCache::AllocatedBytes()
+{
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->buffer_mtx_);
+    total += shard->TotalBytes() - shard->FreeBytes();
+  }
+  return total;
+}
+
+double
+RequestResponseCache::TotalUtilization()
+{
+  return static_cast<double>(AllocatedBytes()) /
+         static_cast<double>(TotalBytes());
+}
+
 // Helpers
+std::shared_ptr<CacheEntry>
+RequestResponseCache::NewCacheEntry(const std::shared_ptr<Shard>& shard)
+{
+  return std::shared_ptr<CacheEntry>(new CacheEntry(), [shard](CacheEntry* e) {
+    if (e->usage_ != nullptr) {
+      e->usage_->allocated_bytes_ -= EntryByteSize(*e);
+    }
+    {
+      // Lock on buffer deallocation
+      std::lock_guard<std::mutex> lk(shard->buffer_mtx_);
+      // Free managed memory used in cache entry's outputs
+      for (auto& output : e->outputs_) {
+        if (output.buffer_ != nullptr) {
+          shard->Deallocate(output.buffer_, output.buffer_size_);
+        }
+      }
+    }
+    delete e;
+  });
+}
+
+std::shared_ptr<CacheModelUsage>
+RequestResponseCache::ModelUsage(
+    const std::string& model_name, ModelPolicy* policy)
+{
+  std::lock_guard<std::mutex> lk(models_mu_);
+  if (policy != nullptr) {
+    auto it = model_policies_.find(model_name);
+    *policy = (it != model_policies_.end()) ? it->second : ModelPolicy();
+  }
+  auto& usage = model_usage_[model_name];
+  if (usage == nullptr) {
+    usage.reset(new CacheModelUsage());
+    usage->lru_.resize(shards_.size());
+  }
+  return usage;
+}
+
 void
-RequestResponseCache::UpdateLRU(
-    std::unordered_map<uint64_t, CacheEntry>::iterator& cache_iter)
+RequestResponseCache::SetModelPolicy(
+    const std::string& model_name, const ModelPolicy& policy)
+{
+  std::lock_guard<std::mutex> lk(models_mu_);
+  model_policies_[model_name] = policy;
+}
+
+uint64_t
+RequestResponseCache::ModelAllocatedBytes(const std::string& model_name)
+{
+  return ModelUsage(model_name)->allocated_bytes_;
+}
+
+uint64_t
+RequestResponseCache::ModelNumRejections(const std::string& model_name)
 {
-  // Lock on cache update
-  std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
+  return ModelUsage(model_name)->rejections_;
+}
 
-  const auto& key = cache_iter->first;
-  auto& cache_entry = cache_iter->second;
-  // Remove key from LRU list if it was already in there
-  auto lru_iter = std::find(lru_.begin(), lru_.end(), key);
-  if (lru_iter != lru_.end()) {
-    lru_.erase(lru_iter);
+bool
+RequestResponseCache::AddEntry(
+    const uint64_t key, const std::shared_ptr<CacheEntry>& entry,
+    const std::shared_ptr<CacheModelUsage>& usage, Shard* shard)
+{
+  if (!shard->cache_.insert({key, entry}).second) {
+    return false;
   }
-  // Add key to front of LRU list since it's most recently used
-  lru_.push_front(key);
-  // Set CacheEntry LRU iterator to new LRU key location
-  cache_entry.lru_iter_ = lru_.begin();
+  // Start tracking the entry in the eviction policy and account its
+  // storage to the model until the entry is released
+  const uint64_t byte_size = EntryByteSize(*entry);
+  entry->usage_ = usage;
+  usage->allocated_bytes_ += byte_size;
+  shard->policy_->OnInsert(key, byte_size);
+  auto& lru = usage->lru_[shard->index_];
+  lru.push_front(key);
+  entry->lru_iter_ = lru.begin();
+  entry->last_use_ns_ = NowNs();
+  return true;
+}
+
+bool
+RequestResponseCache::Admit(
+    const InferenceResponse& response, const ModelPolicy& policy,
+    CacheModelUsage* usage, uint64_t* byte_size, std::string* reason)
+{
+  *byte_size = 0;
+  if ((policy.byte_quota_ != 0) || (policy.max_entry_byte_size_ != 0)) {
+    for (const auto& output : response.Outputs()) {
+      const void* buffer;
+      size_t output_byte_size = 0;
+      TRITONSERVER_MemoryType memory_type;
+      int64_t memory_type_id;
+      void* userp;
+      Status status = output.DataBuffer(
+          &buffer, &output_byte_size, &memory_type, &memory_type_id, &userp);
+      if (status.IsOk()) {
+        *byte_size += output_byte_size;
+      }
+    }
+    if ((policy.max_entry_byte_size_ != 0) &&
+        (*byte_size > policy.max_entry_byte_size_)) {
+      *reason = "response of " + std::to_string(*byte_size) +
+                " bytes is larger than the model limit";
+      return false;
+    }
+    if ((policy.byte_quota_ != 0) && (*byte_size > policy.byte_quota_)) {
+      *reason = "response of " + std::to_string(*byte_size) +
+                " bytes is larger than the model cache quota";
+      return false;
+    }
+  }
+
+  if (policy.min_hit_rate_ > 0) {
+    const uint64_t hits = usage->hits_;
+    const uint64_t misses = usage->misses_;
+    const uint64_t lookups = hits + misses;
+    if ((lookups >= policy.min_lookups_) &&
+        (hits < (policy.min_hit_rate_ * lookups)) &&
+        ((misses % kAdmissionSampleInterval) != 0)) {
+      *reason = "model cache hit rate is below the admission threshold";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+Status
+RequestResponseCache::AllocateBuffer(
+    Shard* shard, const size_t byte_size, void** buffer)
+{
+  // Attempt to allocate buffer until success or eviction from cache fails.
+  // The buffer lock is only held around the managed buffer access since
+  // eviction may release entries, which takes the lock itself.
+  *buffer = nullptr;
+  while (*buffer == nullptr) {
+    size_t free_bytes = 0;
+    {
+      std::lock_guard<std::mutex> lk(shard->buffer_mtx_);
+
+      // Exit early if cache entry will be larger than available cache size
+      if (byte_size > shard->TotalBytes()) {
+        return Status(
+            Status::Code::INTERNAL,
+            "Cache entry is larger than total cache size");
+      }
+
+      // NOTE: free memory doesn't account for allocator overhead so
+      //       allocation may fail even if byte_size is less than the free
+      //       memory
+      free_bytes = shard->FreeBytes();
+      if (byte_size <= free_bytes) {
+        *buffer = shard->Allocate(byte_size);
+      }
+    }
+
+    // Attempt to evict if allocation fails
+    if (*buffer == nullptr) {
+      if (byte_size > free_bytes) {
+        LOG_VERBOSE(1) << "EVICT: Response larger than remaining available "
+                          "memory, attempting to evict from cache.";
+      } else {
+        LOG_VERBOSE(1) << "FAILED to allocate buffer in cache. Attempting to "
+                          "evict an entry.";
+      }
+      // Exit out if Eviction fails
+      RETURN_IF_ERROR(EvictLocked(shard));
+    }
+  }
+
+  return Status::Success;
 }
 
 Status
 RequestResponseCache::BuildCacheEntry(
-    const InferenceResponse& response, CacheEntry* const entry)
+    const InferenceResponse& response, Shard* shard, CacheEntry* const entry)
 {
   // Build cache entry data from response outputs
   for (const auto& response_output : response.Outputs()) {
@@ -327,131 +1309,205 @@ RequestResponseCache::BuildCacheEntry(
         &response_buffer, &response_byte_size, &response_memory_type,
         &response_memory_type_id, &userp));
 
-    // TODO: Handle other memory types
-    if (response_memory_type != TRITONSERVER_MEMORY_CPU &&
-        response_memory_type != TRITONSERVER_MEMORY_CPU_PINNED) {
-      return Status(
-          Status::Code::INTERNAL,
-          "Only input buffers in CPU memory are allowed in cache currently");
-    }
-
     // Exit early if response buffer from output is invalid
     if (response_buffer == nullptr) {
       return Status(
           Status::Code::INTERNAL, "Response buffer from output was nullptr");
     }
 
-    // Lock on managed buffer references
-    {
-      std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
+    // Allocate buffer for response output in cache entry
+    RETURN_IF_ERROR(
+        AllocateBuffer(shard, response_byte_size, &cache_output.buffer_));
 
-      // Exit early if cache entry will be larger than available cache size
-      if (response_byte_size > managed_buffer_.get_size()) {
-        return Status(
-            Status::Code::INTERNAL,
-            "Cache entry is larger than total cache size");
-      }
+    // Set output metadata
+    cache_output.name_ = response_output.Name();
+    cache_output.dtype_ = response_output.DType();
+    cache_output.shape_ = response_output.Shape();
+    cache_output.buffer_size_ = static_cast<uint64_t>(response_byte_size);
 
-      // If cache doesn't have enough space, evict until enough space available
-      // NOTE: FreeBytes() doesn't account for allocator overhead so allocation
-      //       may fail even if response_byte_size is less than FreeBytes()
-      while (response_byte_size > FreeBytes()) {
-        LOG_VERBOSE(1) << "EVICT: Response larger than remaining available "
-                          "memory, attempting to evict from cache.";
-        RETURN_IF_ERROR(Evict());
-      }
+    // Add each output to cache entry before copying so that the storage is
+    // released with the entry if the copy fails
+    entry->outputs_.push_back(cache_output);
 
-      // Attempt to allocate buffer until success or eviction from cache fails
-      while (cache_output.buffer_ == nullptr) {
-        // Allocate buffer for response output in cache entry
-        cache_output.buffer_ =
-            managed_buffer_.allocate(response_byte_size, std::nothrow_t{});
-        // Attempt to evict if allocation fails
-        if (cache_output.buffer_ == nullptr) {
-          LOG_VERBOSE(1) << "FAILED to allocate buffer in cache. Attempting to "
-                            "evict an entry.";
-          // Exit out if Eviction fails
-          RETURN_IF_ERROR(Evict());
-        }
-      }
+    // Copy data from response buffer to cache entry output buffer
+    RETURN_IF_ERROR(CopyBufferSync(
+        "cache insertion", response_memory_type, response_memory_type_id,
+        shard->memory_type_, shard->memory_type_id_, response_byte_size,
+        response_buffer, cache_output.buffer_, copy_stream_));
+  }
 
-      // Copy data from response buffer to cache entry output buffer
-      // TODO: Handle other memory types
-      std::memcpy(cache_output.buffer_, response_buffer, response_byte_size);
+  return Status::Success;
+}
 
-      // Set output metadata
-      cache_output.name_ = response_output.Name();
-      cache_output.dtype_ = response_output.DType();
-      cache_output.shape_ = response_output.Shape();
-      cache_output.buffer_size_ = static_cast<uint64_t>(response_byte_size);
+Status
+RequestResponseCache::SerializeCacheEntry(
+    const CacheEntry& entry, std::string* value)
+{
+  // Serialized in the order of the CacheEntry and Output members
+  value->clear();
+  AppendValue(kSerializedEntryVersion, value);
+  AppendValue(entry.digest_, value);
+  AppendValue(static_cast<uint32_t>(entry.model_name_.size()), value);
+  value->append(entry.model_name_);
+  AppendValue(entry.model_version_, value);
+  AppendValue(static_cast<uint32_t>(entry.outputs_.size()), value);
+  for (const auto& output : entry.outputs_) {
+    AppendValue(output.buffer_size_, value);
+    AppendValue(static_cast<uint32_t>(output.name_.size()), value);
+    value->append(output.name_);
+    AppendValue(static_cast<int32_t>(output.dtype_), value);
+    AppendValue(static_cast<uint32_t>(output.shape_.size()), value);
+    for (const auto dim : output.shape_) {
+      AppendValue(dim, value);
     }
 
-    // Add each output to cache entry
-    entry->outputs_.push_back(cache_output);
+    const size_t offset = value->size();
+    value->resize(offset + output.buffer_size_);
+    RETURN_IF_ERROR(CopyBufferSync(
+        "cache serialization", memory_type_, memory_type_id_,
+        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */, output.buffer_size_,
+        output.buffer_, &(*value)[offset], copy_stream_));
   }
 
   return Status::Success;
 }
 
+Status
+RequestResponseCache::DeserializeCacheEntry(
+    const std::string& value, Shard* shard, CacheEntry* const entry)
+{
+  const Status malformed(
+      Status::Code::INVALID_ARG, "malformed serialized cache entry");
+  size_t offset = 0;
+  uint32_t version = 0;
+  uint32_t model_name_size = 0;
+  uint32_t output_count = 0;
+  if (!ReadValue(value, &offset, &version) ||
+      (version != kSerializedEntryVersion) ||
+      !ReadValue(value, &offset, &entry->digest_) ||
+      !ReadValue(value, &offset, &model_name_size) ||
+      ((value.size() - offset) < model_name_size)) {
+    return malformed;
+  }
+  entry->model_name_ = value.substr(offset, model_name_size);
+  offset += model_name_size;
+  if (!ReadValue(value, &offset, &entry->model_version_) ||
+      !ReadValue(value, &offset, &output_count)) {
+    return malformed;
+  }
+
+  for (uint32_t idx = 0; idx < output_count; ++idx) {
+    auto cache_output = Output();
+    uint32_t name_size = 0;
+    int32_t dtype = 0;
+    uint32_t dims = 0;
+    if (!ReadValue(value, &offset, &cache_output.buffer_size_) ||
+        !ReadValue(value, &offset, &name_size) ||
+        ((value.size() - offset) < name_size)) {
+      return malformed;
+    }
+    cache_output.name_ = value.substr(offset, name_size);
+    offset += name_size;
+    if (!ReadValue(value, &offset, &dtype) ||
+        !inference::DataType_IsValid(dtype) ||
+        !ReadValue(value, &offset, &dims)) {
+      return malformed;
+    }
+    cache_output.dtype_ = static_cast<inference::DataType>(dtype);
+    for (uint32_t dim_idx = 0; dim_idx < dims; ++dim_idx) {
+      int64_t dim = 0;
+      if (!ReadValue(value, &offset, &dim)) {
+        return malformed;
+      }
+      cache_output.shape_.push_back(dim);
+    }
+    if ((value.size() - offset) < cache_output.buffer_size_) {
+      return malformed;
+    }
+
+    RETURN_IF_ERROR(AllocateBuffer(
+        shard, cache_output.buffer_size_, &cache_output.buffer_));
+    // Add each output to cache entry before copying so that the storage is
+    // released with the entry if the copy fails
+    entry->outputs_.push_back(cache_output);
+    RETURN_IF_ERROR(CopyBufferSync(
+        "cache deserialization", TRITONSERVER_MEMORY_CPU,
+        0 /* memory_type_id */, shard->memory_type_, shard->memory_type_id_,
+        cache_output.buffer_size_, value.data() + offset,
+        cache_output.buffer_, copy_stream_));
+    offset += cache_output.buffer_size_;
+  }
+
+  return Status::Success;
+}
 
 Status
 RequestResponseCache::BuildInferenceResponse(
-    const CacheEntry& entry, InferenceResponse* const response)
+    const std::shared_ptr<CacheEntry>& entry,
+    InferenceResponse* const response)
 {
   if (response == nullptr) {
     return Status(Status::Code::INTERNAL, "invalid response ptr passed in");
   }
 
-  // Lock on cache references
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
+  // Reference the cached data directly if the client accepts buffers that
+  // it doesn't own, borrowed buffers are always in CPU memory
+  const ResponseAllocator* allocator = response->Allocator();
+  const bool borrow = (memory_type_ == TRITONSERVER_MEMORY_CPU) &&
+                      (allocator != nullptr) &&
+                      allocator->BorrowedBuffersAccepted();
+
+  // Inference response outputs should be empty so we can append to them
+  if (response->Outputs().size() != 0) {
+    return Status(
+        Status::Code::INTERNAL,
+        "InferenceResponse already contains some outputs");
+  }
 
-    // Inference response outputs should be empty so we can append to them
-    if (response->Outputs().size() != 0) {
+  for (auto& cache_output : entry->outputs_) {
+    InferenceResponse::Output* response_output = nullptr;
+    RETURN_IF_ERROR(response->AddOutput(
+        cache_output.name_, cache_output.dtype_, cache_output.shape_,
+        &response_output));
+
+    if (response_output == nullptr) {
       return Status(
           Status::Code::INTERNAL,
-          "InferenceResponse already contains some outputs");
+          "InferenceResponse::Output pointer as nullptr");
     }
 
-    for (auto& cache_output : entry.outputs_) {
-      InferenceResponse::Output* response_output = nullptr;
-      RETURN_IF_ERROR(response->AddOutput(
-          cache_output.name_, cache_output.dtype_, cache_output.shape_,
-          &response_output));
-
-      if (response_output == nullptr) {
-        return Status(
-            Status::Code::INTERNAL,
-            "InferenceResponse::Output pointer as nullptr");
-      }
-
-      TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
-      int64_t memory_type_id = 0;
-
-      // Allocate buffer for inference response
-      void* buffer;
-      RETURN_IF_ERROR(response_output->AllocateDataBuffer(
-          &buffer, cache_output.buffer_size_, &memory_type, &memory_type_id));
+    // Each borrowed output pins the entry, the entry memory can't be
+    // reclaimed by eviction until the response releases the output
+    if (borrow) {
+      RETURN_IF_ERROR(response_output->SetBorrowedDataBuffer(
+          cache_output.buffer_, cache_output.buffer_size_,
+          TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */, entry));
+      continue;
+    }
 
-      // TODO: Handle other memory types
-      if (memory_type != TRITONSERVER_MEMORY_CPU &&
-          memory_type != TRITONSERVER_MEMORY_CPU_PINNED) {
-        return Status(
-            Status::Code::INTERNAL,
-            "Only input buffers in CPU memory are allowed in cache currently");
-      }
+    // Prefer the memory the output is cached in so that a hit doesn't
+    // need to cross PCIe if the allocator can provide it
+    TRITONSERVER_MemoryType memory_type = memory_type_;
+    int64_t memory_type_id = memory_type_id_;
 
-      if (buffer == nullptr) {
-        return Status(
-            Status::Code::INTERNAL, "failed to allocate buffer for output '" +
-                                        cache_output.name_ + "'");
-      }
-      // Copy cached output buffer to allocated response output buffer
-      std::memcpy(buffer, cache_output.buffer_, cache_output.buffer_size_);
+    // Allocate buffer for inference response
+    void* buffer;
+    RETURN_IF_ERROR(response_output->AllocateDataBuffer(
+        &buffer, cache_output.buffer_size_, &memory_type, &memory_type_id));
 
-      // TODO: Add field to InferenceResponse to indicate this was from cache
-      // response.cached = true;
+    if (buffer == nullptr) {
+      return Status(
+          Status::Code::INTERNAL, "failed to allocate buffer for output '" +
+                                      cache_output.name_ + "'");
     }
+    // Copy cached output buffer to allocated response output buffer
+    RETURN_IF_ERROR(CopyBufferSync(
+        "cache lookup", memory_type_, memory_type_id_, memory_type,
+        memory_type_id, cache_output.buffer_size_, cache_output.buffer_,
+        buffer, copy_stream_));
+
+    // TODO: Add field to InferenceResponse to indicate this was from cache
+    // response.cached = true;
   }
 
   return Status::Success;
@@ -459,31 +1515,74 @@ RequestResponseCache::BuildInferenceResponse(
 
 Status
 RequestResponseCache::HashInputBuffers(
-    const InferenceRequest::Input* input, size_t* seed)
+    const InferenceRequest::Input* input, StreamingHash64* hash,
+    StreamingHash64* digest)
 {
-  // Iterate over each data buffer in input in case of non-contiguous memory
-  for (size_t idx = 0; idx < input->DataBufferCount(); ++idx) {
-    const void* src_buffer;
-    size_t src_byte_size;
-    TRITONSERVER_MemoryType src_memory_type;
-    int64_t src_memory_type_id;
-
+  // Collect the data buffers of the input in case of non-contiguous memory
+  struct Chunk {
+    const void* buffer_;
+    size_t byte_size_;
+    TRITONSERVER_MemoryType memory_type_;
+    int64_t memory_type_id_;
+  };
+  std::vector<Chunk> chunks(input->DataBufferCount());
+  size_t gpu_byte_size = 0;
+  for (size_t idx = 0; idx < chunks.size(); ++idx) {
+    auto& chunk = chunks[idx];
     RETURN_IF_ERROR(input->DataBuffer(
-        idx, &src_buffer, &src_byte_size, &src_memory_type,
-        &src_memory_type_id));
+        idx, &chunk.buffer_, &chunk.byte_size_, &chunk.memory_type_,
+        &chunk.memory_type_id_));
+    if (chunk.memory_type_ == TRITONSERVER_MEMORY_GPU) {
+      gpu_byte_size += chunk.byte_size_;
+    }
+  }
 
-    // TODO: Handle other memory types
-    if (src_memory_type != TRITONSERVER_MEMORY_CPU &&
-        src_memory_type != TRITONSERVER_MEMORY_CPU_PINNED) {
-      return Status(
-          Status::Code::INTERNAL,
-          "Only input buffers in CPU memory are allowed in cache currently");
+  // Hash GPU-resident data through a pinned staging buffer. The copies
+  // are issued back to back on the stream of the calling thread and
+  // synchronized once, without serializing with the other streams as
+  // the default stream does.
+  std::unique_ptr<char, void (*)(char*)> staging(
+      nullptr, [](char* buffer) { PinnedMemoryManager::Free(buffer); });
+  if (gpu_byte_size != 0) {
+#ifdef TRITON_ENABLE_GPU
+    void* buffer = nullptr;
+    TRITONSERVER_MemoryType staging_memory_type;
+    RETURN_IF_ERROR(PinnedMemoryManager::Alloc(
+        &buffer, gpu_byte_size, &staging_memory_type,
+        true /* allow_nonpinned_fallback */));
+    staging.reset(reinterpret_cast<char*>(buffer));
+    bool cuda_used = false;
+    char* dst = staging.get();
+    for (auto& chunk : chunks) {
+      if (chunk.memory_type_ != TRITONSERVER_MEMORY_GPU) {
+        continue;
+      }
+      bool chunk_cuda_used = false;
+      RETURN_IF_ERROR(CopyBuffer(
+          "cache input hashing", chunk.memory_type_, chunk.memory_type_id_,
+          staging_memory_type, 0 /* memory_type_id */, chunk.byte_size_,
+          chunk.buffer_, dst, cudaStreamPerThread, &chunk_cuda_used));
+      cuda_used |= chunk_cuda_used;
+      chunk.buffer_ = dst;
+      dst += chunk.byte_size_;
+    }
+    if (cuda_used) {
+      RETURN_IF_CUDA_ERR(
+          cudaStreamSynchronize(cudaStreamPerThread),
+          std::string("cache input hashing: failed to synchronize CUDA copy"));
     }
+#else
+    return Status(
+        Status::Code::INTERNAL,
+        "cache input hashing: input in GPU memory while GPU is not supported");
+#endif  // TRITON_ENABLE_GPU
+  }
 
-    // Add each byte of input buffer chunk to hash
-    const unsigned char* tmp = static_cast<const unsigned char*>(src_buffer);
-    for (uint64_t byte = 0; byte < src_byte_size; byte++) {
-      boost::hash_combine(*seed, tmp[byte]);
+  // Add the whole input buffer chunks to hash
+  for (const auto& chunk : chunks) {
+    hash->Update(chunk.buffer_, chunk.byte_size_);
+    if (digest != nullptr) {
+      digest->Update(chunk.buffer_, chunk.byte_size_);
     }
   }
 
@@ -492,18 +1591,29 @@ RequestResponseCache::HashInputBuffers(
 
 
 Status
-RequestResponseCache::HashInputs(const InferenceRequest& request, size_t* seed)
+RequestResponseCache::HashInputs(
+    const InferenceRequest& request, StreamingHash64* hash,
+    StreamingHash64* digest)
 {
   const auto& inputs = request.ImmutableInputs();
   // Convert inputs to ordered map for consistency in hashing
   // inputs sorted by key (input) name
-  std::map<std::string, InferenceRequest::Input*> ordered_inputs(
-      inputs.begin(), inputs.end());
+  std::map<std::string, InferenceRequest::Input*> ordered_inputs;
+  for (const auto& entry : inputs) {
+    ordered_inputs.emplace(entry.input_->Name(), entry.input_);
+  }
   for (const auto& input : ordered_inputs) {
-    // Add input name to hash
-    boost::hash_combine(*seed, input.second->Name());
+    // Add input name and data byte size to hash so that the boundaries
+    // between inputs are part of the key
+    const uint64_t byte_size = input.second->Data()->TotalByteSize();
+    hash->Update(input.second->Name());
+    hash->UpdateValue(byte_size);
+    if (digest != nullptr) {
+      digest->Update(input.second->Name());
+      digest->UpdateValue(byte_size);
+    }
     // Fetch input buffer for hashing raw data
-    RETURN_IF_ERROR(HashInputBuffers(input.second, seed));
+    RETURN_IF_ERROR(HashInputBuffers(input.second, hash, digest));
   }
 
   return Status::Success;
@@ -511,15 +1621,28 @@ RequestResponseCache::HashInputs(const InferenceRequest& request, size_t* seed)
 
 
 Status
-RequestResponseCache::Hash(const InferenceRequest& request, uint64_t* key)
-{
-  std::size_t seed = 0;
-  // Add request model name to hash
-  boost::hash_combine(seed, request.ModelName());
-  // Add request model version to hash
-  boost::hash_combine(seed, request.ActualModelVersion());
-  RETURN_IF_ERROR(HashInputs(request, &seed));
-  *key = static_cast<uint64_t>(seed);
+RequestResponseCache::Hash(
+    const InferenceRequest& request, uint64_t* key, uint64_t* digest)
+{
+  // The secondary digest uses an independent seed so that a collision of
+  // the key is very unlikely to also be a collision of the digest
+  static constexpr uint64_t kDigestSeed = 0x9E3779B97F4A7C15ULL;
+  StreamingHash64 hash;
+  StreamingHash64 digest_hash(kDigestSeed);
+  StreamingHash64* digest_ptr = collision_safe_ ? &digest_hash : nullptr;
+
+  // Add request model name and version to hash
+  const int64_t model_version = request.ActualModelVersion();
+  hash.Update(request.ModelName());
+  hash.UpdateValue(model_version);
+  if (digest_ptr != nullptr) {
+    digest_ptr->Update(request.ModelName());
+    digest_ptr->UpdateValue(model_version);
+  }
+  RETURN_IF_ERROR(HashInputs(request, &hash, digest_ptr));
+
+  *key = hash.Digest();
+  *digest = (digest_ptr != nullptr) ? digest_ptr->Digest() : 0;
   return Status::Success;
 }
 
@@ -527,8 +1650,9 @@ Status
 RequestResponseCache::HashAndSet(InferenceRequest* const request)
 {
   uint64_t key = 0;
-  RETURN_IF_ERROR(Hash(*request, &key));
-  request->SetCacheKey(key);
+  uint64_t digest = 0;
+  RETURN_IF_ERROR(Hash(*request, &key, &digest));
+  request->SetCacheKey(key, digest);
   return Status::Success;
 }
 
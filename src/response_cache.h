@@ -26,23 +26,33 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "cache_eviction_policy.h"
+#include "cache_remote_tier.h"
+#include "cuda_utils.h"
+#include "hash_utils.h"
 #include "infer_request.h"
 #include "infer_response.h"
 #include "model.h"
 #include "status.h"
 
-#include <boost/functional/hash.hpp>
 #include <boost/interprocess/managed_external_buffer.hpp>
 
 namespace triton { namespace core {
 
-// Assuming CPU memory only for now
 struct Output {
-  // Output tensor data buffer
+  // Output tensor data buffer, in the memory type of the cache storage
   void* buffer_;
   // Size of "buffer" above
   uint64_t buffer_size_ = 0;
@@ -54,20 +64,116 @@ struct Output {
   std::vector<int64_t> shape_;
 };
 
+// Usage of the response cache by the entries of one model, shared by the
+// entries so that their storage is accounted until it is released
+struct CacheModelUsage {
+  // Bytes of storage held by the entries of the model
+  std::atomic<uint64_t> allocated_bytes_{0};
+  // Lookups that hit an entry of the model, and responses of the model
+  // offered for insertion after a miss
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  // Responses that were not admitted to the cache
+  std::atomic<uint64_t> rejections_{0};
+  // Keys of the entries of the model in each shard, sorted from most to
+  // least recently used. Each list is protected by the lock of its shard.
+  std::vector<std::list<uint64_t>> lru_;
+};
+
 struct CacheEntry {
   explicit CacheEntry() {}
-  // Point to key in LRU list for maintaining LRU order
-  std::list<uint64_t>::iterator lru_iter_;
   // each output buffer = managed_buffer.allocate(size, ...)
   std::vector<Output> outputs_;
+  // Secondary digest of the request that produced this entry, only
+  // verified on lookup in collision-safe mode
+  uint64_t digest_ = 0;
+  // Model of the request that produced this entry, verified on lookup so
+  // that an entry restored from a snapshot or fetched from the remote tier
+  // is only used for the same model name and version
+  std::string model_name_;
+  int64_t model_version_ = -1;
+  // Usage of the model, set once the entry is added to the cache
+  std::shared_ptr<CacheModelUsage> usage_;
+  // Position of the entry in the list of its model in the shard, and the
+  // time the entry was inserted or last hit
+  std::list<uint64_t>::iterator lru_iter_;
+  uint64_t last_use_ns_ = 0;
 };
 
 class RequestResponseCache {
  public:
+  // Options to configure the request/response cache.
+  struct Options {
+    Options(
+        uint64_t cache_size = 0, uint32_t num_shards = 1,
+        bool collision_safe = false,
+        CacheEvictionPolicy::Kind eviction_policy =
+            CacheEvictionPolicy::Kind::LRU,
+        TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU,
+        int64_t memory_type_id = 0)
+        : cache_size_(cache_size), num_shards_(num_shards),
+          collision_safe_(collision_safe), eviction_policy_(eviction_policy),
+          memory_type_(memory_type), memory_type_id_(memory_type_id)
+    {
+    }
+
+    // Total byte size of the cache
+    uint64_t cache_size_;
+    // Number of independently locked shards. Each shard owns an equal
+    // slice of 'cache_size_', so an entry must fit within a single slice.
+    uint32_t num_shards_;
+    // Whether a second, independent 64-bit digest of the request is
+    // stored with each entry and checked on lookup, so that a collision
+    // of the 64-bit cache key is reported as a miss.
+    bool collision_safe_;
+    // Policy used to select the entry to evict, each shard runs its own
+    // instance of the policy over its slice of the cache.
+    CacheEvictionPolicy::Kind eviction_policy_;
+    // Memory that cached outputs are stored in, either CPU memory or the
+    // CUDA memory pool of GPU 'memory_type_id_'. GPU storage keeps hits
+    // on the device when the response is allocated in GPU memory.
+    TRITONSERVER_MemoryType memory_type_;
+    int64_t memory_type_id_;
+    // Optional remote tier behind the cache. A local miss waits at most
+    // 'remote_lookup_timeout_us_' for the remote tier and a remote hit is
+    // inserted into the local cache. Inserted entries are written back to
+    // the remote tier asynchronously, at most 'remote_write_queue_size_'
+    // writes are pending and further writes are dropped.
+    std::shared_ptr<CacheRemoteTier> remote_tier_;
+    uint64_t remote_lookup_timeout_us_ = 2000;
+    size_t remote_write_queue_size_ = 1024;
+    // Optional file the cache is restored from on creation and written to
+    // when the cache is destroyed. The file holds the entries of each
+    // shard in eviction order so that the order is kept on restore.
+    std::string snapshot_path_;
+  };
+
+  // Admission and quota settings of the entries of a model.
+  struct ModelPolicy {
+    // Maximum total bytes of the entries of the model, 0 for no limit.
+    // A response that would exceed the quota evicts the least recently
+    // used entries of the model, so the model can't evict the entries of
+    // other models beyond its quota. Responses larger than the quota are
+    // not admitted.
+    uint64_t byte_quota_ = 0;
+    // Responses larger than this are not admitted, 0 for no limit
+    uint64_t max_entry_byte_size_ = 0;
+    // Once the model had 'min_lookups_' lookups, its responses are only
+    // admitted while the hit rate of the model is at least
+    // 'min_hit_rate_'. One in 'kAdmissionSampleInterval' responses is
+    // still admitted so that the hit rate can recover.
+    double min_hit_rate_ = 0;
+    uint64_t min_lookups_ = 1000;
+  };
+  static constexpr uint64_t kAdmissionSampleInterval = 16;
+
   ~RequestResponseCache();
-  // Create the request/response cache object
+  // Create the request/response cache object with a single shard
   static Status Create(
       uint64_t cache_size, std::unique_ptr<RequestResponseCache>* cache);
+  // Create the request/response cache object based on 'options'
+  static Status Create(
+      const Options& options, std::unique_ptr<RequestResponseCache>* cache);
   // Hash inference request for cache access and store it in "request" object.
   // This will also be called internally in Lookup/Insert if the request hasn't
   // already stored it's hash. It is up to the user to update the hash in the
@@ -76,123 +182,261 @@ class RequestResponseCache {
   Status HashAndSet(InferenceRequest* const request);
 
   // Lookup 'request' hash in cache and return the inference response in
-  // 'response' on cache hit or nullptr on cache miss
+  // 'response' on cache hit or nullptr on cache miss. If the response
+  // allocator of 'response' accepts borrowed buffers, the outputs reference
+  // the cached data directly and the cache entry memory is pinned until
+  // 'response' releases its outputs. Otherwise the cached data is copied
+  // into buffers allocated through the response allocator.
   // Return Status object indicating success or failure.
   Status Lookup(
       InferenceResponse* const response, InferenceRequest* const request);
   // Insert response into cache, evict entries to make space if necessary
-  // Return Status object indicating success or failure.
+  // Return Status object indicating success or failure, UNAVAILABLE if the
+  // model policy doesn't admit the response.
   Status Insert(
       const InferenceResponse& response, InferenceRequest* const request);
-  // Evict entry from cache based on policy
+  // Insert response of the model with 'usage' and 'policy' into cache, so
+  // that callers inserting the responses of one model resolve them once
+  // through ModelUsage() instead of on each insertion.
+  Status Insert(
+      const InferenceResponse& response, InferenceRequest* const request,
+      const std::shared_ptr<CacheModelUsage>& usage,
+      const ModelPolicy& policy);
+  // Evict entry from cache based on the eviction policy. The shards are
+  // visited in round-robin order and the first non-empty shard is evicted
+  // from.
   // Return Status object indicating success or failure.
   Status Evict();
+  // Set the admission and quota policy of the entries of 'model_name',
+  // shared by all versions of the model
+  void SetModelPolicy(const std::string& model_name, const ModelPolicy& policy);
+  // Returns the usage of 'model_name', created on first use, and its
+  // policy in 'policy' if not nullptr. The usage stays valid for the
+  // lifetime of the cache.
+  std::shared_ptr<CacheModelUsage> ModelUsage(
+      const std::string& model_name, ModelPolicy* policy = nullptr);
+  // Returns the bytes held by the entries of 'model_name'
+  uint64_t ModelAllocatedBytes(const std::string& model_name);
+  // Returns number of responses of 'model_name' that were not admitted
+  uint64_t ModelNumRejections(const std::string& model_name);
+  // Returns number of shards in cache
+  size_t NumShards() const { return shards_.size(); }
+  // Returns whether cache entries are verified with a secondary digest
+  bool CollisionSafe() const { return collision_safe_; }
+  // Returns the eviction policy used by the cache
+  CacheEvictionPolicy::Kind EvictionPolicy() const { return eviction_policy_; }
+  // Returns the memory type and memory type ID of the cache storage
+  TRITONSERVER_MemoryType MemoryType() const { return memory_type_; }
+  int64_t MemoryTypeId() const { return memory_type_id_; }
   // Returns number of items in cache
-  size_t NumEntries()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return cache_.size();
-  }
+  size_t NumEntries();
   // Returns number of items evicted in cache lifespan
-  size_t NumEvictions()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return num_evictions_;
-  }
+  size_t NumEvictions();
   // Returns number of lookups in cache lifespan, should sum to hits + misses
-  size_t NumLookups()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return num_lookups_;
-  }
+  size_t NumLookups();
   // Returns number of cache hits in cache lifespan
-  size_t NumHits()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return num_hits_;
-  }
-  // Returns number of cache hits in cache lifespan
-  size_t NumMisses()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return num_misses_;
-  }
+  size_t NumHits();
+  // Returns number of cache misses in cache lifespan
+  size_t NumMisses();
+  // Returns number of local misses that hit in the remote tier
+  size_t NumRemoteHits() { return num_remote_hits_; }
+  // Returns number of remote tier lookups that exceeded the deadline
+  size_t NumRemoteTimeouts() { return num_remote_timeouts_; }
   // Returns the total lookup latency (nanoseconds) of all lookups in cache
   // lifespan
-  uint64_t TotalLookupLatencyNs()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return total_lookup_latency_ns_;
-  }
-
-  uint64_t TotalInsertionLatencyNs()
-  {
-    std::lock_guard<std::recursive_mutex> lk(cache_mtx_);
-    return total_insertion_latency_ns_;
-  }
+  uint64_t TotalLookupLatencyNs() { return total_lookup_latency_ns_; }
+  // Returns the total insertion latency (nanoseconds) of all insertions in
+  // cache lifespan
+  uint64_t TotalInsertionLatencyNs() { return total_insertion_latency_ns_; }
 
   // Returns total number of bytes allocated for cache
-  size_t TotalBytes()
-  {
-    std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
-    return managed_buffer_.get_size();
-  }
+  size_t TotalBytes();
   // Returns number of free bytes in cache
-  size_t FreeBytes()
-  {
-    std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
-    return managed_buffer_.get_free_memory();
-  }
+  size_t FreeBytes();
   // Returns number of bytes in use by cache
-  size_t AllocatedBytes()
-  {
-    std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
-    return managed_buffer_.get_size() - managed_buffer_.get_free_memory();
-  }
+  size_t AllocatedBytes();
   // Returns fraction of bytes allocated over total cache size between [0, 1]
-  double TotalUtilization()
-  {
-    std::lock_guard<std::recursive_mutex> lk(buffer_mtx_);
-    return static_cast<double>(AllocatedBytes()) /
-           static_cast<double>(TotalBytes());
-  }
+  double TotalUtilization();
 
  private:
-  explicit RequestResponseCache(const uint64_t cache_size);
-  // Update LRU ordering on lookup
-  void UpdateLRU(std::unordered_map<uint64_t, CacheEntry>::iterator&);
-  // Build CacheEntry from InferenceResponse
+  // A shard holds a slice of the cache buffer along with the map and
+  // eviction policy of the keys that hash to it. All shard state except
+  // the managed buffer is protected by 'mtx_'. Shards are reference
+  // counted by the entries allocated from them so that an entry pinned by
+  // a response can outlive the cache.
+  struct Shard {
+    ~Shard();
+    // Allocate 'byte_size' bytes of storage for an entry output, return
+    // nullptr if the shard doesn't have enough free space. The buffer lock
+    // must be held by the caller for all storage functions.
+    void* Allocate(const size_t byte_size);
+    // Release storage returned by Allocate()
+    void Deallocate(void* buffer, const size_t byte_size);
+    size_t TotalBytes();
+    size_t FreeBytes();
+
+    // Memory type of the shard storage
+    TRITONSERVER_MemoryType memory_type_ = TRITONSERVER_MEMORY_CPU;
+    int64_t memory_type_id_ = 0;
+    // Cache buffer that this shard's slice belongs to, CPU storage only
+    std::shared_ptr<void> buffer_;
+    // Managed buffer over this shard's slice of the cache buffer, CPU
+    // storage only
+    boost::interprocess::managed_external_buffer managed_buffer_;
+    // Byte size of the shard and bytes in use, GPU storage only. Storage
+    // is allocated from the CUDA memory manager.
+    uint64_t device_byte_size_ = 0;
+    uint64_t device_allocated_bytes_ = 0;
+    // key -> CacheEntry containing values. Entries are shared so that a
+    // lookup can keep using an entry after releasing the shard lock, the
+    // entry's managed memory is released when the last reference goes
+    // away.
+    std::unordered_map<uint64_t, std::shared_ptr<CacheEntry>> cache_;
+    // Eviction policy over the keys in 'cache_'
+    std::unique_ptr<CacheEvictionPolicy> policy_;
+    // Index of the shard in the cache, selects the lists of the shard in
+    // CacheModelUsage::lru_
+    size_t index_ = 0;
+    // Shard metrics
+    size_t num_evictions_ = 0;
+    size_t num_lookups_ = 0;
+    size_t num_hits_ = 0;
+    size_t num_misses_ = 0;
+    // Mutex for managed buffer synchronization
+    std::mutex buffer_mtx_;
+    // Mutex for map, eviction policy and metrics synchronization
+    std::mutex mtx_;
+  };
+
+  explicit RequestResponseCache(const Options& options);
+  // Return the shard that owns 'key'
+  const std::shared_ptr<Shard>& ShardForKey(const uint64_t key)
+  {
+    return shards_[(key ^ (key >> 32)) % shards_.size()];
+  }
+  // Evict entry from 'shard', the shard lock must be held by the caller
+  Status EvictLocked(Shard* shard);
+  // Remove the entry of 'iter' from 'shard', the shard lock must be held
+  // by the caller
+  void RemoveEntry(
+      Shard* shard,
+      std::unordered_map<uint64_t, std::shared_ptr<CacheEntry>>::iterator
+          iter);
+  // Evict the least recently used entries of the model of 'usage' until
+  // 'byte_size' more bytes fit within 'byte_quota'. Return false if the
+  // entries of the model can't make enough room. No shard lock may be held
+  // by the caller.
+  bool EvictModelEntries(
+      CacheModelUsage* usage, const uint64_t byte_quota,
+      const uint64_t byte_size);
+  // Create an empty CacheEntry whose managed memory is returned to 'shard'
+  // when the last reference is released
+  std::shared_ptr<CacheEntry> NewCacheEntry(
+      const std::shared_ptr<Shard>& shard);
+  // Add 'entry' under 'key' to 'shard' and account it to its model. Return
+  // false if the key is already cached. The shard lock must be held by the
+  // caller.
+  bool AddEntry(
+      const uint64_t key, const std::shared_ptr<CacheEntry>& entry,
+      const std::shared_ptr<CacheModelUsage>& usage, Shard* shard);
+  // Returns whether 'response' of 'usage' is admitted under 'policy', and
+  // the byte size of the response in 'byte_size' if the policy limits the
+  // bytes of the model
+  bool Admit(
+      const InferenceResponse& response, const ModelPolicy& policy,
+      CacheModelUsage* usage, uint64_t* byte_size, std::string* reason);
+  // Allocate 'byte_size' bytes of entry storage from 'shard', evicting
+  // entries as needed. The shard lock must be held by the caller.
+  Status AllocateBuffer(Shard* shard, const size_t byte_size, void** buffer);
+  // Build CacheEntry from InferenceResponse, the shard lock must be held by
+  // the caller
   Status BuildCacheEntry(
-      const InferenceResponse& response, CacheEntry* const entry);
+      const InferenceResponse& response, Shard* shard,
+      CacheEntry* const entry);
   // Build InferenceResponse from CacheEntry
   Status BuildInferenceResponse(
-      const CacheEntry& entry, InferenceResponse* const response);
-  // Helper function to hash data buffers used by "input"
-  Status HashInputBuffers(const InferenceRequest::Input* input, size_t* seed);
-  // Helper function to hash each input in "request"
-  Status HashInputs(const InferenceRequest& request, size_t* seed);
-  // Helper function to hash request and store it in "key"
-  Status Hash(const InferenceRequest& request, uint64_t* key);
-
-  // Cache buffer
-  void* buffer_;
-  // Managed buffer
-  boost::interprocess::managed_external_buffer managed_buffer_;
-  // key -> CacheEntry containing values and list iterator for LRU management
-  std::unordered_map<uint64_t, CacheEntry> cache_;
-  // List of keys sorted from most to least recently used
-  std::list<uint64_t> lru_;
-  // Cache metrics
-  size_t num_evictions_ = 0;
-  size_t num_lookups_ = 0;
-  size_t num_hits_ = 0;
-  size_t num_misses_ = 0;
-  uint64_t total_lookup_latency_ns_ = 0;
-  uint64_t total_insertion_latency_ns_ = 0;
-  // Mutex for buffer synchronization
-  std::recursive_mutex buffer_mtx_;
-  // Mutex for cache synchronization
-  std::recursive_mutex cache_mtx_;
+      const std::shared_ptr<CacheEntry>& entry,
+      InferenceResponse* const response);
+  // Serialize 'entry' into 'value' for the remote tier
+  Status SerializeCacheEntry(const CacheEntry& entry, std::string* value);
+  // Build CacheEntry from a value serialized by SerializeCacheEntry(), the
+  // shard lock must be held by the caller
+  Status DeserializeCacheEntry(
+      const std::string& value, Shard* shard, CacheEntry* const entry);
+  // Look up 'key' in the remote tier and insert the entry into 'shard' on
+  // a hit. Return false on a miss, on an error or if the deadline expired.
+  bool LookupRemote(
+      const InferenceRequest& request, const uint64_t key,
+      const std::shared_ptr<Shard>& shard, std::shared_ptr<CacheEntry>* entry);
+  // Write all entries to the snapshot file 'path'
+  Status WriteSnapshot(const std::string& path);
+  // Insert the entries of the snapshot file 'path' into the cache. A
+  // missing file is not an error.
+  Status RestoreSnapshot(const std::string& path);
+  // Queue 'entry' to be written back to the remote tier
+  void EnqueueRemoteWrite(
+      const uint64_t key, const std::shared_ptr<CacheEntry>& entry);
+  // Write queued entries back to the remote tier until the cache is
+  // destroyed
+  void RemoteWriteThread();
+  // Helper function to add data buffers used by "input" to "hash" and,
+  // if not nullptr, to "digest"
+  Status HashInputBuffers(
+      const InferenceRequest::Input* input, StreamingHash64* hash,
+      StreamingHash64* digest);
+  // Helper function to add each input in "request" to "hash" and, if not
+  // nullptr, to "digest"
+  Status HashInputs(
+      const InferenceRequest& request, StreamingHash64* hash,
+      StreamingHash64* digest);
+  // Helper function to hash request and store it in "key". The secondary
+  // digest is stored in "digest" in collision-safe mode, 0 otherwise.
+  Status Hash(
+      const InferenceRequest& request, uint64_t* key, uint64_t* digest);
+
+  // Whether cache entries are verified with a secondary digest
+  const bool collision_safe_;
+  // Policy used to select the entry to evict
+  const CacheEvictionPolicy::Kind eviction_policy_;
+  // Memory type of the cache storage
+  const TRITONSERVER_MemoryType memory_type_;
+  const int64_t memory_type_id_;
+  // Non-blocking stream used for copies to and from device memory, so that
+  // they neither serialize with nor wait on the legacy default stream
+  cudaStream_t copy_stream_;
+  // Cache buffer, sliced across all shards, CPU storage only
+  std::shared_ptr<void> buffer_;
+  // Cache shards
+  std::vector<std::shared_ptr<Shard>> shards_;
+  // Shard to start the search from on the next Evict() call
+  std::atomic<size_t> next_evict_shard_;
+  // Latency metrics, updated without holding any shard lock
+  std::atomic<uint64_t> total_lookup_latency_ns_;
+  std::atomic<uint64_t> total_insertion_latency_ns_;
+
+  // Usage and policy of each model with cached entries, protected by
+  // 'models_mu_'. Lookup hits reach the usage through the entry, and the
+  // schedulers resolve it once through ModelUsage().
+  std::mutex models_mu_;
+  std::unordered_map<std::string, std::shared_ptr<CacheModelUsage>>
+      model_usage_;
+  std::unordered_map<std::string, ModelPolicy> model_policies_;
+  // Snapshot file, empty if no snapshot is taken
+  const std::string snapshot_path_;
+  // Remote tier, nullptr if the cache is local only
+  const std::shared_ptr<CacheRemoteTier> remote_tier_;
+  const uint64_t remote_lookup_timeout_us_;
+  const size_t remote_write_queue_size_;
+  std::atomic<size_t> num_remote_hits_;
+  std::atomic<size_t> num_remote_timeouts_;
+  // Entries waiting to be written back to the remote tier, protected by
+  // 'remote_mu_'. The entries are referenced so their memory stays valid
+  // until they are serialized.
+  std::mutex remote_mu_;
+  std::condition_variable remote_cv_;
+  std::deque<std::pair<uint64_t, std::shared_ptr<CacheEntry>>> remote_writes_;
+  bool remote_exit_;
+  std::thread remote_writer_;
 };
 
 }}  // namespace triton::core
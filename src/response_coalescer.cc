@@ -0,0 +1,268 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "response_coalescer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include "infer_response.h"
+#include "timer_wheel.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+//
+// The thread flushing the batches whose delay expired, shared by all
+// the coalescers.
+//
+class FlushTimer {
+ public:
+  static FlushTimer& Instance()
+  {
+    static FlushTimer timer;
+    return timer;
+  }
+
+  ~FlushTimer()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      exit_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+  // Flush batch 'batch_id' of 'coalescer' at 'deadline_ns'.
+  void Schedule(
+      const uint64_t deadline_ns,
+      const std::weak_ptr<ResponseCoalescer>& coalescer,
+      const uint64_t batch_id)
+  {
+    bool notify;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      const uint64_t id = next_id_++;
+      timers_.emplace(id, std::make_pair(coalescer, batch_id));
+      wheel_.Schedule(deadline_ns, id);
+      notify = (wheel_.Size() == 1);
+    }
+    if (notify) {
+      cv_.notify_one();
+    }
+  }
+
+ private:
+  // The resolution of the flush deadlines.
+  static constexpr uint64_t kTickNs = 20000;
+
+  FlushTimer()
+      : wheel_(kTickNs, NowNs()), next_id_(0), exit_(false),
+        thread_([this] { Run(); })
+  {
+  }
+
+  void Run()
+  {
+    std::vector<uint64_t> expired;
+    std::vector<std::pair<std::weak_ptr<ResponseCoalescer>, uint64_t>> flushes;
+    std::unique_lock<std::mutex> lk(mu_);
+    while (!exit_) {
+      if (wheel_.Size() == 0) {
+        cv_.wait(lk, [this] { return exit_ || (wheel_.Size() != 0); });
+        continue;
+      }
+      cv_.wait_for(lk, std::chrono::nanoseconds(kTickNs));
+
+      wheel_.Advance(NowNs(), &expired);
+      for (const auto id : expired) {
+        auto it = timers_.find(id);
+        flushes.emplace_back(std::move(it->second));
+        timers_.erase(it);
+      }
+      expired.clear();
+
+      lk.unlock();
+      for (auto& flush : flushes) {
+        auto coalescer = flush.first.lock();
+        if (coalescer != nullptr) {
+          coalescer->Flush(flush.second);
+        }
+      }
+      flushes.clear();
+      lk.lock();
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  TimerWheel wheel_;
+  uint64_t next_id_;
+  std::unordered_map<
+      uint64_t, std::pair<std::weak_ptr<ResponseCoalescer>, uint64_t>>
+      timers_;
+  bool exit_;
+  std::thread thread_;
+};
+
+}  // namespace
+
+Status
+ResponseCoalescer::Create(
+    TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn, void* userp,
+    const uint32_t max_response_count, const uint64_t max_delay_us,
+    std::shared_ptr<ResponseCoalescer>* coalescer)
+{
+  if (batch_fn == nullptr) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "response coalescing requires a batch response callback");
+  }
+  if (max_response_count == 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "response coalescing requires a maximum response count of at least "
+        "1");
+  }
+
+  coalescer->reset(new ResponseCoalescer(
+      batch_fn, userp, max_response_count, max_delay_us));
+  return Status::Success;
+}
+
+ResponseCoalescer::ResponseCoalescer(
+    TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn, void* userp,
+    const uint32_t max_response_count, const uint64_t max_delay_us)
+    : batch_fn_(batch_fn), userp_(userp),
+      max_response_count_(max_response_count),
+      max_delay_ns_(max_delay_us * 1000), batch_id_(0), delivering_(false)
+{
+  pending_.reserve(max_response_count_);
+}
+
+ResponseCoalescer::~ResponseCoalescer()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!pending_.empty()) {
+      QueueLocked(0 /* flags */);
+    }
+  }
+  DeliverQueued();
+}
+
+void
+ResponseCoalescer::Enqueue(
+    std::unique_ptr<InferenceResponse>&& response, const uint32_t flags)
+{
+  uint64_t batch_id = 0;
+  bool schedule = false;
+  bool deliver = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (response != nullptr) {
+      pending_.push_back(
+          reinterpret_cast<TRITONSERVER_InferenceResponse*>(
+              response.release()));
+    }
+
+    if (((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) ||
+        (pending_.size() >= max_response_count_)) {
+      QueueLocked(flags);
+      deliver = true;
+    } else if ((pending_.size() == 1) && (max_delay_ns_ != 0)) {
+      batch_id = batch_id_;
+      schedule = true;
+    }
+  }
+
+  if (deliver) {
+    DeliverQueued();
+  }
+  // Scheduled outside of 'mu_', the flush timer may be flushing this
+  // coalescer.
+  if (schedule) {
+    FlushTimer::Instance().Schedule(
+        NowNs() + max_delay_ns_, shared_from_this(), batch_id);
+  }
+}
+
+void
+ResponseCoalescer::Flush(const uint64_t batch_id)
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if ((batch_id != batch_id_) || pending_.empty()) {
+      return;
+    }
+    QueueLocked(0 /* flags */);
+  }
+  DeliverQueued();
+}
+
+void
+ResponseCoalescer::QueueLocked(const uint32_t flags)
+{
+  queued_.emplace_back();
+  queued_.back().responses_.swap(pending_);
+  queued_.back().flags_ = flags;
+  pending_.reserve(max_response_count_);
+  ++batch_id_;
+}
+
+void
+ResponseCoalescer::DeliverQueued()
+{
+  std::unique_lock<std::mutex> lk(mu_);
+  if (delivering_) {
+    return;
+  }
+  delivering_ = true;
+  while (!queued_.empty()) {
+    Batch batch = std::move(queued_.front());
+    queued_.pop_front();
+    lk.unlock();
+    // The callback takes ownership of the responses.
+    batch_fn_(
+        batch.responses_.data(), batch.responses_.size(), batch.flags_,
+        userp_);
+    lk.lock();
+  }
+  delivering_ = false;
+}
+
+}}  // namespace triton::core
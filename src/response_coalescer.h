@@ -0,0 +1,100 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "status.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+class InferenceResponse;
+
+//
+// Coalesce the responses sent for a request so that they are delivered
+// to the response callback in batches. A batch is delivered once it
+// holds 'max_response_count' responses, once the response with the
+// final flag is sent or 'max_delay_us' after its first response was
+// sent, whichever comes first. A 'max_delay_us' of 0 doesn't bound the
+// time a response is held. The batches are delivered in order, the
+// final flag is only set on the last batch.
+//
+class ResponseCoalescer
+    : public std::enable_shared_from_this<ResponseCoalescer> {
+ public:
+  static Status Create(
+      TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn, void* userp,
+      const uint32_t max_response_count, const uint64_t max_delay_us,
+      std::shared_ptr<ResponseCoalescer>* coalescer);
+
+  // Deliver the responses still held, without the final flag.
+  ~ResponseCoalescer();
+
+  // Add 'response' to the batch being coalesced, 'response' may be
+  // nullptr if only 'flags' are sent.
+  void Enqueue(
+      std::unique_ptr<InferenceResponse>&& response, const uint32_t flags);
+
+  // Deliver the batch with id 'batch_id' if it is still pending.
+  void Flush(const uint64_t batch_id);
+
+ private:
+  ResponseCoalescer(
+      TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn, void* userp,
+      const uint32_t max_response_count, const uint64_t max_delay_us);
+
+  // Queue the pending responses for delivery with 'flags', must be
+  // called with 'mu_' held.
+  void QueueLocked(const uint32_t flags);
+
+  // Deliver the queued batches, must be called without 'mu_' held. The
+  // callback isn't invoked with 'mu_' held, the batches are delivered in
+  // order by the thread that finds no delivery in progress.
+  void DeliverQueued();
+
+  const TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_fn_;
+  void* const userp_;
+  const uint32_t max_response_count_;
+  const uint64_t max_delay_ns_;
+
+  std::mutex mu_;
+  std::vector<TRITONSERVER_InferenceResponse*> pending_;
+  // The id of the pending batch, the flush timers armed for the
+  // batches already delivered are ignored.
+  uint64_t batch_id_;
+
+  struct Batch {
+    std::vector<TRITONSERVER_InferenceResponse*> responses_;
+    uint32_t flags_;
+  };
+  std::deque<Batch> queued_;
+  bool delivering_;
+};
+
+}}  // namespace triton::core
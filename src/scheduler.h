@@ -69,6 +69,19 @@ class Scheduler {
   // caller still retains ownership of 'request'.
   virtual Status Enqueue(std::unique_ptr<InferenceRequest>& request) = 0;
 
+  // Enqueue 'requests' that may be executed together. Each request
+  // that is enqueued is set to nullptr, if non-success is returned then
+  // the caller still retains ownership of the remaining requests. By
+  // default the requests are enqueued individually.
+  virtual Status EnqueueBatch(
+      std::vector<std::unique_ptr<InferenceRequest>>& requests)
+  {
+    for (auto& request : requests) {
+      RETURN_IF_ERROR(Enqueue(request));
+    }
+    return Status::Success;
+  }
+
   // Return the number of in-flight inferences tracked by the scheduler.
   virtual size_t InflightInferenceCount() = 0;
 
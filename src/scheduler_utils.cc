@@ -26,6 +26,7 @@
 
 #include "scheduler_utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include "constants.h"
 #include "triton/common/logging.h"
@@ -41,7 +42,7 @@ InitRequiredEqualInputs(
   required_equal_inputs->clear();
 
   for (const auto& pr : request->ImmutableInputs()) {
-    const InferenceRequest::Input* input = pr.second;
+    const InferenceRequest::Input* input = pr.input_;
     const auto itr = enforce_equal_shape_tensors.find(input->Name());
     if (itr != enforce_equal_shape_tensors.end()) {
       required_equal_inputs->emplace(
@@ -73,7 +74,7 @@ CompareWithRequiredEqualInputs(
     return false;
   }
   for (const auto& pr : request->ImmutableInputs()) {
-    const InferenceRequest::Input* input = pr.second;
+    const InferenceRequest::Input* input = pr.input_;
     const auto itr = required_equal_inputs.find(input->Name());
     if (itr != required_equal_inputs.end()) {
       if (itr->second.first != nullptr) {
@@ -127,8 +128,43 @@ CompareWithRequiredEqualInputs(
   return true;
 }
 
+namespace {
+
+// Resolution of request timeouts.
+constexpr uint64_t kTimeoutTickNs = 100 * 1000;
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+PriorityQueue::PolicyQueue::PolicyQueue()
+    : timeout_action_(inference::ModelQueuePolicy::REJECT),
+      default_timeout_us_(0), allow_timeout_override_(false),
+      max_queue_size_(0), next_request_id_(0), fair_(false),
+      timers_(kTimeoutTickNs, NowNs())
+{
+}
+
+PriorityQueue::PolicyQueue::PolicyQueue(
+    const inference::ModelQueuePolicy& policy)
+    : timeout_action_(policy.timeout_action()),
+      default_timeout_us_(policy.default_timeout_microseconds()),
+      allow_timeout_override_(policy.allow_timeout_override()),
+      max_queue_size_(policy.max_queue_size()), next_request_id_(0),
+      fair_(false), timers_(kTimeoutTickNs, NowNs())
+{
+}
+
 Status
-PriorityQueue::PolicyQueue::Enqueue(std::unique_ptr<InferenceRequest>& request)
+PriorityQueue::PolicyQueue::Enqueue(
+    std::unique_ptr<InferenceRequest>& request, const std::string* tenant,
+    size_t* idx)
 {
   if ((max_queue_size_ != 0) && (Size() >= max_queue_size_)) {
     return Status(
@@ -136,27 +172,57 @@ PriorityQueue::PolicyQueue::Enqueue(std::unique_ptr<InferenceRequest>& request)
         request->LogRequest() + "Exceeds maximum queue size");
   }
 
-  queue_.emplace_back(std::move(request));
   auto timeout_us = default_timeout_us_;
   if (allow_timeout_override_) {
-    auto override_timeout_us = queue_.back()->TimeoutMicroseconds();
+    auto override_timeout_us = request->TimeoutMicroseconds();
     if (override_timeout_us != 0 && override_timeout_us < timeout_us) {
       timeout_us = override_timeout_us;
     }
   }
+  const uint64_t request_id = next_request_id_++;
+  uint64_t timeout_ns = 0;
   if (timeout_us != 0) {
-    timeout_timestamp_ns_.emplace_back(
-        std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::steady_clock::now().time_since_epoch())
-            .count() +
-        timeout_us * 1000);
+    timeout_ns = NowNs() + timeout_us * 1000;
+    timers_.Schedule(timeout_ns, request_id);
+  }
+
+  // The requests of equal tags keep their arrival order.
+  uint64_t tag = 0;
+  *idx = queue_.size();
+  if (fair_ && (tenant != nullptr)) {
+    tag = fair_clock_.Tag(*tenant, std::max(1U, request->BatchSize()));
+    *idx = std::upper_bound(fair_tags_.begin(), fair_tags_.end(), tag) -
+           fair_tags_.begin();
+  }
+  if (*idx == queue_.size()) {
+    queue_.emplace_back(std::move(request));
+    request_ids_.emplace_back(request_id);
+    timeout_timestamp_ns_.emplace_back(timeout_ns);
+    fair_tags_.emplace_back(tag);
   } else {
-    timeout_timestamp_ns_.emplace_back(0);
+    queue_.emplace(queue_.begin() + *idx, std::move(request));
+    request_ids_.emplace(request_ids_.begin() + *idx, request_id);
+    timeout_timestamp_ns_.emplace(
+        timeout_timestamp_ns_.begin() + *idx, timeout_ns);
+    fair_tags_.emplace(fair_tags_.begin() + *idx, tag);
+  }
+  if (fair_ && (timeout_ns != 0)) {
+    timer_tags_.emplace(request_id, tag);
   }
 
   return Status::Success;
 }
 
+void
+PriorityQueue::PolicyQueue::EnableFairQueuing(
+    const std::unordered_map<std::string, uint32_t>& weights)
+{
+  fair_ = true;
+  for (const auto& pr : weights) {
+    fair_clock_.SetWeight(pr.first, pr.second);
+  }
+}
+
 Status
 PriorityQueue::PolicyQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
 {
@@ -164,6 +230,11 @@ PriorityQueue::PolicyQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
     *request = std::move(queue_.front());
     queue_.pop_front();
     timeout_timestamp_ns_.pop_front();
+    request_ids_.pop_front();
+    if (fair_) {
+      fair_clock_.Serve(fair_tags_.front());
+    }
+    fair_tags_.pop_front();
   } else {
     *request = std::move(delayed_queue_.front());
     delayed_queue_.pop_front();
@@ -173,51 +244,205 @@ PriorityQueue::PolicyQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
 }
 
 bool
-PriorityQueue::PolicyQueue::ApplyPolicy(
-    size_t idx, size_t* rejected_count, size_t* rejected_batch_size)
+PriorityQueue::PolicyQueue::DequeueIf(
+    const std::function<bool(const InferenceRequest&)>& match,
+    const size_t max_batch_size, const size_t max_count,
+    std::vector<std::unique_ptr<InferenceRequest>>* requests,
+    size_t* batch_size)
 {
-  uint64_t now_nanoseconds =
-      std::chrono::duration_cast<std::chrono::nanoseconds>(
-          std::chrono::steady_clock::now().time_since_epoch())
-          .count();
-  if (idx < queue_.size()) {
-    size_t curr_idx = idx;
-    while (curr_idx < queue_.size()) {
-      if ((timeout_timestamp_ns_[curr_idx] != 0) &&
-          (now_nanoseconds > timeout_timestamp_ns_[curr_idx])) {
-        if (timeout_action_ == inference::ModelQueuePolicy::DELAY) {
-          delayed_queue_.emplace_back(std::move(queue_[curr_idx]));
-        } else {
-          rejected_queue_.emplace_back(std::move(queue_[curr_idx]));
-          *rejected_count += 1;
-          *rejected_batch_size +=
-              std::max(1U, rejected_queue_.back()->BatchSize());
-        }
-        curr_idx++;
+  bool full = false;
+  size_t count = 0;
+  // Return true if 'request' is moved to 'requests'.
+  const auto take = [&](std::unique_ptr<InferenceRequest>& request) {
+    if (!match(*request)) {
+      return false;
+    }
+    const size_t request_batch_size = std::max(1U, request->BatchSize());
+    if (!requests->empty() &&
+        ((*batch_size + request_batch_size) > max_batch_size)) {
+      full = true;
+      return false;
+    }
+    *batch_size += request_batch_size;
+    requests->emplace_back(std::move(request));
+    ++count;
+    return true;
+  };
+  // Stop at the first request that doesn't fit or once all the matching
+  // requests are moved, the requests after it keep their place.
+  const auto done = [&]() { return full || (count >= max_count); };
+
+  size_t write_idx = 0;
+  size_t read_idx = 0;
+  for (; (read_idx < queue_.size()) && !done(); ++read_idx) {
+    if (take(queue_[read_idx])) {
+      if (fair_) {
+        fair_clock_.Serve(fair_tags_[read_idx]);
+      }
+      continue;
+    }
+    if (write_idx != read_idx) {
+      queue_[write_idx] = std::move(queue_[read_idx]);
+      timeout_timestamp_ns_[write_idx] = timeout_timestamp_ns_[read_idx];
+      request_ids_[write_idx] = request_ids_[read_idx];
+      fair_tags_[write_idx] = fair_tags_[read_idx];
+    }
+    ++write_idx;
+  }
+  queue_.erase(queue_.begin() + write_idx, queue_.begin() + read_idx);
+  timeout_timestamp_ns_.erase(
+      timeout_timestamp_ns_.begin() + write_idx,
+      timeout_timestamp_ns_.begin() + read_idx);
+  request_ids_.erase(
+      request_ids_.begin() + write_idx, request_ids_.begin() + read_idx);
+  fair_tags_.erase(
+      fair_tags_.begin() + write_idx, fair_tags_.begin() + read_idx);
+
+  write_idx = 0;
+  read_idx = 0;
+  for (; (read_idx < delayed_queue_.size()) && !done(); ++read_idx) {
+    if (take(delayed_queue_[read_idx])) {
+      continue;
+    }
+    if (write_idx != read_idx) {
+      delayed_queue_[write_idx] = std::move(delayed_queue_[read_idx]);
+    }
+    ++write_idx;
+  }
+  delayed_queue_.erase(
+      delayed_queue_.begin() + write_idx, delayed_queue_.begin() + read_idx);
+
+  return full;
+}
+
+void
+PriorityQueue::PolicyQueue::ExpireTimeouts(
+    size_t first_idx, const uint64_t now_ns, size_t* rejected_count,
+    size_t* rejected_batch_size)
+{
+  std::vector<uint64_t> expired_ids;
+  expired_ids.swap(pending_expired_ids_);
+  timers_.Advance(now_ns, &expired_ids);
+  if (expired_ids.empty()) {
+    return;
+  }
+
+  // Find the expired requests that are still in 'queue_'. The requests
+  // are ordered by tag and then by id, so each one is searched within
+  // the requests of its tag.
+  first_idx = std::min(first_idx, queue_.size());
+  std::vector<size_t> expired_idx;
+  for (const auto id : expired_ids) {
+    uint64_t tag = 0;
+    if (fair_) {
+      const auto tag_it = timer_tags_.find(id);
+      if (tag_it == timer_tags_.end()) {
+        continue;
+      }
+      tag = tag_it->second;
+    }
+    const auto tags =
+        std::equal_range(fair_tags_.begin(), fair_tags_.end(), tag);
+    const auto first = request_ids_.begin() + (tags.first - fair_tags_.begin());
+    const auto last = request_ids_.begin() + (tags.second - fair_tags_.begin());
+    const auto it = std::lower_bound(first, last, id);
+    if ((it == last) || (*it != id)) {
+      timer_tags_.erase(id);
+      continue;
+    }
+    const size_t idx = it - request_ids_.begin();
+    if (idx < first_idx) {
+      pending_expired_ids_.push_back(id);
+    } else {
+      expired_idx.push_back(idx);
+      timer_tags_.erase(id);
+    }
+  }
+  if (expired_idx.empty()) {
+    return;
+  }
+
+  // Remove all expired requests in a single pass over the queue, starting
+  // from the first one. The expired requests keep their relative order in
+  // the delayed or rejected queue.
+  std::sort(expired_idx.begin(), expired_idx.end());
+  size_t next_expired = 0;
+  size_t write_idx = expired_idx[0];
+  for (size_t read_idx = expired_idx[0]; read_idx < queue_.size();
+       ++read_idx) {
+    if ((next_expired < expired_idx.size()) &&
+        (expired_idx[next_expired] == read_idx)) {
+      ++next_expired;
+      if (timeout_action_ == inference::ModelQueuePolicy::DELAY) {
+        delayed_queue_.emplace_back(std::move(queue_[read_idx]));
       } else {
-        break;
+        rejected_queue_.emplace_back(std::move(queue_[read_idx]));
+        *rejected_count += 1;
+        *rejected_batch_size +=
+            std::max(1U, rejected_queue_.back()->BatchSize());
       }
+    } else {
+      queue_[write_idx] = std::move(queue_[read_idx]);
+      timeout_timestamp_ns_[write_idx] = timeout_timestamp_ns_[read_idx];
+      request_ids_[write_idx] = request_ids_[read_idx];
+      fair_tags_[write_idx] = fair_tags_[read_idx];
+      ++write_idx;
     }
+  }
+  queue_.erase(queue_.begin() + write_idx, queue_.end());
+  timeout_timestamp_ns_.erase(
+      timeout_timestamp_ns_.begin() + write_idx, timeout_timestamp_ns_.end());
+  request_ids_.erase(request_ids_.begin() + write_idx, request_ids_.end());
+  fair_tags_.erase(fair_tags_.begin() + write_idx, fair_tags_.end());
+}
 
-    // Use range erasure on deque as all erasure functions are linear,
-    // this implies in the edge case where this function is always called on
-    // 'bad' index can be O(n^2). However, for data structures that are O(1)
-    // erasure, the traversal may not be as efficient due to cache miss
-    // (elements not stored contiguously).
-    queue_.erase(queue_.begin() + idx, queue_.begin() + curr_idx);
-    timeout_timestamp_ns_.erase(
-        timeout_timestamp_ns_.begin() + idx,
-        timeout_timestamp_ns_.begin() + curr_idx);
-
-    // Current idx is pointing to an item with unexpired timeout
-    if (idx < queue_.size()) {
-      return true;
+void
+PriorityQueue::PolicyQueue::RemoveCancelled(
+    size_t first_idx, size_t* rejected_count, size_t* rejected_batch_size)
+{
+  const auto reject = [this, rejected_count, rejected_batch_size](
+                          std::unique_ptr<InferenceRequest>& request) {
+    rejected_queue_.emplace_back(std::move(request));
+    *rejected_count += 1;
+    *rejected_batch_size += std::max(1U, rejected_queue_.back()->BatchSize());
+  };
+
+  size_t write_idx = std::min(first_idx, queue_.size());
+  for (size_t read_idx = write_idx; read_idx < queue_.size(); ++read_idx) {
+    if (queue_[read_idx]->IsCancelled()) {
+      reject(queue_[read_idx]);
+    } else {
+      if (write_idx != read_idx) {
+        queue_[write_idx] = std::move(queue_[read_idx]);
+        timeout_timestamp_ns_[write_idx] = timeout_timestamp_ns_[read_idx];
+        request_ids_[write_idx] = request_ids_[read_idx];
+        fair_tags_[write_idx] = fair_tags_[read_idx];
+      }
+      ++write_idx;
     }
   }
-  // At this point, idx is pointing to an item with expired timeout.
-  // If the item is in delayed queue, then return true. Otherwise, false
-  // meaning the queue has no item with this 'idx'.
-  return ((idx - queue_.size()) < delayed_queue_.size());
+  queue_.erase(queue_.begin() + write_idx, queue_.end());
+  timeout_timestamp_ns_.erase(
+      timeout_timestamp_ns_.begin() + write_idx, timeout_timestamp_ns_.end());
+  request_ids_.erase(request_ids_.begin() + write_idx, request_ids_.end());
+  fair_tags_.erase(fair_tags_.begin() + write_idx, fair_tags_.end());
+
+  // The delayed queue follows 'queue_' in the index space.
+  first_idx = (first_idx > write_idx) ? (first_idx - write_idx) : 0;
+  write_idx = std::min(first_idx, delayed_queue_.size());
+  for (size_t read_idx = write_idx; read_idx < delayed_queue_.size();
+       ++read_idx) {
+    if (delayed_queue_[read_idx]->IsCancelled()) {
+      reject(delayed_queue_[read_idx]);
+    } else {
+      if (write_idx != read_idx) {
+        delayed_queue_[write_idx] = std::move(delayed_queue_[read_idx]);
+      }
+      ++write_idx;
+    }
+  }
+  delayed_queue_.erase(
+      delayed_queue_.begin() + write_idx, delayed_queue_.end());
 }
 
 void
@@ -248,7 +473,8 @@ PriorityQueue::PolicyQueue::TimeoutAt(size_t idx)
 }
 
 PriorityQueue::PriorityQueue()
-    : size_(0), front_priority_level_(0), last_priority_level_(0)
+    : size_(0), cancel_count_(0), front_priority_level_(0),
+      last_priority_level_(0)
 {
   inference::ModelQueuePolicy default_policy;
   queues_.emplace(0, PolicyQueue(default_policy));
@@ -259,7 +485,7 @@ PriorityQueue::PriorityQueue()
 PriorityQueue::PriorityQueue(
     const inference::ModelQueuePolicy& default_queue_policy,
     uint32_t priority_levels, const ModelQueuePolicyMap queue_policy_map)
-    : size_(0), last_priority_level_(priority_levels)
+    : size_(0), cancel_count_(0), last_priority_level_(priority_levels)
 {
   if (priority_levels == 0) {
     queues_.emplace(0, PolicyQueue(default_queue_policy));
@@ -281,17 +507,36 @@ Status
 PriorityQueue::Enqueue(
     uint32_t priority_level, std::unique_ptr<InferenceRequest>& request)
 {
-  auto status = queues_[priority_level].Enqueue(request);
+  std::string tenant;
+  const bool fair = !fair_tenant_parameter_.empty();
+  if (fair) {
+    for (const auto& parameter : request->Parameters()) {
+      if (parameter.Name() == fair_tenant_parameter_) {
+        if (parameter.Type() == TRITONSERVER_PARAMETER_STRING) {
+          tenant = parameter.ValueString();
+        } else if (parameter.Type() == TRITONSERVER_PARAMETER_INT) {
+          tenant = std::to_string(
+              *reinterpret_cast<const int64_t*>(parameter.ValuePointer()));
+        }
+        break;
+      }
+    }
+  }
+
+  size_t idx;
+  auto status = queues_[priority_level].Enqueue(
+      request, fair ? &tenant : nullptr, &idx);
   if (status.IsOk()) {
     size_++;
     front_priority_level_ = std::min(front_priority_level_, priority_level);
     // Invalidate the pending batch cursor if the enqueued item is placed
     // within the pending batch. At the same priority level the request is
-    // guaranteed to be after pending batch if the batch hasn't reached
-    // delayed queue.
+    // after the pending batch if the batch hasn't reached the delayed
+    // queue, and unless a fair queue placed it ahead of the cursor.
     if ((priority_level < pending_cursor_.curr_it_->first) ||
         ((priority_level == pending_cursor_.curr_it_->first) &&
-         (pending_cursor_.at_delayed_queue_))) {
+         (pending_cursor_.at_delayed_queue_ ||
+          (idx < pending_cursor_.queue_idx_)))) {
       pending_cursor_.valid_ = false;
     }
   }
@@ -299,6 +544,17 @@ PriorityQueue::Enqueue(
   return status;
 }
 
+void
+PriorityQueue::EnableFairQueuing(
+    const std::string& tenant_parameter,
+    const std::unordered_map<std::string, uint32_t>& weights)
+{
+  fair_tenant_parameter_ = tenant_parameter;
+  for (auto& queue : queues_) {
+    queue.second.EnableFairQueuing(weights);
+  }
+}
+
 Status
 PriorityQueue::Dequeue(std::unique_ptr<InferenceRequest>* request)
 {
@@ -340,6 +596,47 @@ PriorityQueue::ReleaseRejectedRequests(
   requests->swap(res);
 }
 
+void
+PriorityQueue::PriorityLevels(std::vector<uint32_t>* levels)
+{
+  levels->clear();
+  for (const auto& queue : queues_) {
+    levels->push_back(queue.first);
+  }
+}
+
+size_t
+PriorityQueue::DequeueIf(
+    const std::function<bool(const InferenceRequest&)>& match,
+    const size_t max_batch_size, const size_t max_count,
+    std::vector<std::unique_ptr<InferenceRequest>>* requests)
+{
+  const size_t request_count = requests->size();
+  size_t batch_size = 0;
+  for (auto& queue : queues_) {
+    const size_t count = requests->size() - request_count;
+    if ((count >= max_count) ||
+        queue.second.DequeueIf(
+            match, max_batch_size, max_count - count, requests,
+            &batch_size)) {
+      break;
+    }
+  }
+  size_ -= (requests->size() - request_count);
+  ResetCursor();
+  return batch_size;
+}
+
+void
+PriorityQueue::SizePerPriorityLevel(std::vector<size_t>* sizes)
+{
+  sizes->resize(queues_.size());
+  size_t idx = 0;
+  for (auto& queue : queues_) {
+    (*sizes)[idx++] = queue.second.Size();
+  }
+}
+
 bool
 PriorityQueue::IsCursorValid()
 {
@@ -362,23 +659,45 @@ PriorityQueue::Cursor::Cursor(PriorityQueues::iterator start_it)
 size_t
 PriorityQueue::ApplyPolicyAtCursor()
 {
+  // Expire the timed out requests of all priority levels that are not
+  // in the pending batch, the levels before the cursor are entirely in
+  // the pending batch.
+  const uint64_t now_ns = NowNs();
   size_t rejected_batch_size = 0;
   size_t rejected_count = 0;
-  while (pending_cursor_.curr_it_ != queues_.end()) {
-    if (!(pending_cursor_.curr_it_->second.ApplyPolicy(
-            pending_cursor_.queue_idx_, &rejected_count,
-            &rejected_batch_size))) {
-      if (size_ > pending_cursor_.pending_batch_count_ + rejected_count) {
-        pending_cursor_.curr_it_++;
-        pending_cursor_.queue_idx_ = 0;
-        continue;
-      }
+  // Only look for cancelled requests if a request was cancelled since the
+  // last sweep, the requests in the pending batch are left to the backend.
+  const uint64_t cancel_count = InferenceRequest::CancelCount();
+  const bool sweep_cancelled = (cancel_count != cancel_count_);
+  cancel_count_ = cancel_count;
+  bool before_cursor = (pending_cursor_.curr_it_ != queues_.end());
+  for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+    size_t first_idx = 0;
+    if (it == pending_cursor_.curr_it_) {
+      first_idx = pending_cursor_.queue_idx_;
+      before_cursor = false;
+    } else if (before_cursor) {
+      first_idx = it->second.Size();
+    }
+    it->second.ExpireTimeouts(
+        first_idx, now_ns, &rejected_count, &rejected_batch_size);
+    if (sweep_cancelled) {
+      it->second.RemoveCancelled(
+          first_idx, &rejected_count, &rejected_batch_size);
     }
-    // Control reach here if the cursor points to a request that is candidate
-    // for pending batch, or if all requests are in pending batch.
-    break;
   }
   size_ -= rejected_count;
+
+  // Move the cursor to the next priority level if there is no candidate for
+  // pending batch left in the current level, unless all requests are in
+  // pending batch.
+  while ((pending_cursor_.curr_it_ != queues_.end()) &&
+         (pending_cursor_.queue_idx_ >=
+          pending_cursor_.curr_it_->second.Size()) &&
+         (size_ > pending_cursor_.pending_batch_count_)) {
+    pending_cursor_.curr_it_++;
+    pending_cursor_.queue_idx_ = 0;
+  }
   return rejected_batch_size;
 }
 
@@ -26,8 +26,12 @@
 #pragma once
 
 #include <deque>
+#include <functional>
 #include <unordered_map>
+#include <vector>
+#include "fair_share_clock.h"
 #include "scheduler.h"
+#include "timer_wheel.h"
 
 namespace triton { namespace core {
 
@@ -77,6 +81,27 @@ class PriorityQueue {
   // Dequeue the request at the front of the queue.
   Status Dequeue(std::unique_ptr<InferenceRequest>* request);
 
+  // Move the requests for which 'match' returns true to 'requests' in
+  // dequeue order while their total batch size stays within
+  // 'max_batch_size', at least one request is moved if any matches. At
+  // most 'max_count' requests are moved, the search stops once they are.
+  // The other requests keep their place. The cursor is reset. Return the
+  // total batch size of the moved requests.
+  size_t DequeueIf(
+      const std::function<bool(const InferenceRequest&)>& match,
+      const size_t max_batch_size, const size_t max_count,
+      std::vector<std::unique_ptr<InferenceRequest>>* requests);
+
+  // Share each priority level fairly between the tenants given by the
+  // value of the request parameter 'tenant_parameter' instead of serving
+  // the requests of the level in arrival order. A tenant is served in
+  // proportion to its weight in 'weights', 1 by default, and the requests
+  // without the parameter belong to the same tenant. Must be called
+  // before any request is enqueued.
+  void EnableFairQueuing(
+      const std::string& tenant_parameter,
+      const std::unordered_map<std::string, uint32_t>& weights);
+
   // Retrieve the requests that are rejected based on the queue policies.
   void ReleaseRejectedRequests(
       std::shared_ptr<
@@ -87,6 +112,14 @@ class PriorityQueue {
   // not included.
   size_t Size() { return size_; }
 
+  // Return the priority levels of the queue in increasing order, a queue
+  // without priority levels has the single level 0.
+  void PriorityLevels(std::vector<uint32_t>* levels);
+
+  // Return the number of requests in the queue at each priority level,
+  // in the order of PriorityLevels(). Rejected requests are not included.
+  void SizePerPriorityLevel(std::vector<size_t>* sizes);
+
   // Is the queue is empty? Rejected requests are not included.
   bool Empty() { return Size() == 0; }
 
@@ -146,41 +179,58 @@ class PriorityQueue {
    public:
     // Construct a policy queue with default policy, which will behave the same
     // as regular queue.
-    PolicyQueue()
-        : timeout_action_(inference::ModelQueuePolicy::REJECT),
-          default_timeout_us_(0), allow_timeout_override_(false),
-          max_queue_size_(0)
-    {
-    }
+    PolicyQueue();
 
     // Construct a policy queue with given 'policy'.
-    PolicyQueue(const inference::ModelQueuePolicy& policy)
-        : timeout_action_(policy.timeout_action()),
-          default_timeout_us_(policy.default_timeout_microseconds()),
-          allow_timeout_override_(policy.allow_timeout_override()),
-          max_queue_size_(policy.max_queue_size())
-    {
-    }
+    PolicyQueue(const inference::ModelQueuePolicy& policy);
 
     // Enqueue a request and set up its timeout accordingly. If
     // Status::Success is returned then the queue has taken ownership
     // of the request object and so 'request' will be nullptr. If
     // non-success is returned then the caller still retains ownership
-    // of 'request'.
-    Status Enqueue(std::unique_ptr<InferenceRequest>& request);
+    // of 'request'. The request is placed by its fair share tag if
+    // 'tenant' is not nullptr, otherwise it is appended. 'idx' returns
+    // the index of the request in the queue.
+    Status Enqueue(
+        std::unique_ptr<InferenceRequest>& request, const std::string* tenant,
+        size_t* idx);
+
+    // Set up the fair share clock of the queue, see
+    // PriorityQueue::EnableFairQueuing().
+    void EnableFairQueuing(
+        const std::unordered_map<std::string, uint32_t>& weights);
 
     // Dequeue the request at the front of the queue.
     Status Dequeue(std::unique_ptr<InferenceRequest>* request);
 
-    // Apply the queue policy to the request at 'idx'.
+    // Move the matching requests to 'requests', see
+    // PriorityQueue::DequeueIf(). 'batch_size' is the total batch size
+    // of 'requests' and is incremented by the moved requests. Return
+    // true if a matching request didn't fit in 'max_batch_size'.
+    bool DequeueIf(
+        const std::function<bool(const InferenceRequest&)>& match,
+        const size_t max_batch_size, const size_t max_count,
+        std::vector<std::unique_ptr<InferenceRequest>>* requests,
+        size_t* batch_size);
+
+    // Apply the queue policy to the requests whose timeout expired by
+    // 'now_ns' and that are at 'first_idx' or after. Expired requests
+    // before 'first_idx' are kept until a later call covers them.
     // 'rejected_count' will be incremented by the number of the newly rejected
     // requets after applying the policy.
     // 'rejected_batch_size' will be incremented by the total batch size of the
     // newly rejected requests after applying the policy.
-    // Return true if the 'idx' still points to a request after applying the
-    // policy, false otherwise.
-    bool ApplyPolicy(
-        size_t idx, size_t* rejected_count, size_t* rejected_batch_size);
+    void ExpireTimeouts(
+        size_t first_idx, const uint64_t now_ns, size_t* rejected_count,
+        size_t* rejected_batch_size);
+
+    // Move the cancelled requests that are at 'first_idx' or after to
+    // the rejected queue, regardless of the timeout action of the
+    // policy. 'rejected_count' and 'rejected_batch_size' are incremented
+    // as in ExpireTimeouts().
+    void RemoveCancelled(
+        size_t first_idx, size_t* rejected_count,
+        size_t* rejected_batch_size);
 
     // Return the rejected requests held by the queue.
     void ReleaseRejectedQueue(
@@ -212,6 +262,24 @@ class PriorityQueue {
 
     std::deque<uint64_t> timeout_timestamp_ns_;
     std::deque<std::unique_ptr<InferenceRequest>> queue_;
+    // Id of each request in 'queue_', used to find the requests whose
+    // timer expired in 'timers_'. Timers are not cancelled when a request
+    // leaves 'queue_', their ids are ignored on expiration. The ids are
+    // increasing among the requests of equal fair share tag.
+    std::deque<uint64_t> request_ids_;
+    uint64_t next_request_id_;
+    // The fair share tag of each request in 'queue_', in increasing order.
+    // The tags are 0 unless the queue is fair.
+    std::deque<uint64_t> fair_tags_;
+    // The fair share tag of the requests with a pending timer, by id, so
+    // that an expired request is searched among the requests of its tag.
+    // Only used if the queue is fair.
+    std::unordered_map<uint64_t, uint64_t> timer_tags_;
+    bool fair_;
+    FairShareClock fair_clock_;
+    TimerWheel timers_;
+    // Ids of expired requests that were before 'first_idx' when expired.
+    std::vector<uint64_t> pending_expired_ids_;
     std::deque<std::unique_ptr<InferenceRequest>> delayed_queue_;
     std::deque<std::unique_ptr<InferenceRequest>> rejected_queue_;
   };
@@ -238,6 +306,14 @@ class PriorityQueue {
   PriorityQueues queues_;
   size_t size_;
 
+  // The request parameter holding the tenant of the requests, empty if
+  // the queue is not fair.
+  std::string fair_tenant_parameter_;
+
+  // The InferenceRequest::CancelCount() at the last sweep for cancelled
+  // requests.
+  uint64_t cancel_count_;
+
   // Keep track of the priority level that the first request in the queue
   // is at to avoid traversing 'queues_'
   uint32_t front_priority_level_;
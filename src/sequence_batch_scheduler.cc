@@ -32,6 +32,7 @@
 #include <unistd.h>
 #endif
 #include <algorithm>
+#include "batch_fill_policy.h"
 #include "constants.h"
 #include "dynamic_batch_scheduler.h"
 #include "model_config_utils.h"
@@ -66,8 +67,49 @@ SequenceBatchScheduler::Create(
   sched->max_sequence_idle_microseconds_ =
       config.sequence_batching().max_sequence_idle_microseconds();
 
+  // Idle time after which the implicit state is offloaded from GPU
+  // memory...
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kSequenceStateOffloadParameter, 0 /* default_value */,
+      &sched->state_offload_idle_microseconds_));
+
+  // Continuous batching...
+  sched->continuous_batching_ = false;
+  const auto continuous_it =
+      config.parameters().find(kContinuousBatchingParameter);
+  if (continuous_it != config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kContinuousBatchingParameter, continuous_it->second.string_value(),
+        &sched->continuous_batching_));
+    if (sched->continuous_batching_ &&
+        !config.sequence_batching().has_oldest()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "model '" + config.name() + "' parameter '" +
+              kContinuousBatchingParameter +
+              "' requires the oldest sequence batching strategy");
+    }
+  }
+
   sched->max_batch_size_ = config.max_batch_size();
 
+  // Backlog limit...
+  uint64_t max_backlog_sequences;
+  RETURN_IF_ERROR(GetUnsignedParameter(
+      config, kMaxBacklogSequencesParameter, 0 /* default_value */,
+      &max_backlog_sequences));
+  sched->max_backlog_sequences_ = max_backlog_sequences;
+
+  // Placement of the new sequences...
+  sched->load_aware_placement_ = false;
+  const auto placement_it =
+      config.parameters().find(kLoadAwarePlacementParameter);
+  if (placement_it != config.parameters().end()) {
+    RETURN_IF_ERROR(ParseBoolParameter(
+        kLoadAwarePlacementParameter, placement_it->second.string_value(),
+        &sched->load_aware_placement_));
+  }
+
   // Implicit States
   auto& states = config.sequence_batching().state();
 
@@ -125,6 +167,11 @@ SequenceBatchScheduler::Create(
   // SequenceBatch object has a thread that manages the batch of
   // requests.
   const auto& instances = model->Instances();
+  sched->sequence_stats_ = model->MutableSequenceStats();
+  sched->sequence_stats_->SetBatcherCount(instances.size());
+  sched->ready_seq_slots_.resize(instances.size());
+  sched->ready_seq_slot_cnt_ = 0;
+  sched->seq_slot_cnt_ = seq_slot_cnt;
   uint32_t index = 0;
   for (const auto& instance : instances) {
     bool init_state;
@@ -144,14 +191,18 @@ SequenceBatchScheduler::Create(
           cont, notready, &init_state));
     }
 
+    sched->batcher_devices_.push_back(
+        (instance->Kind() == TRITONSERVER_INSTANCEGROUPKIND_GPU)
+            ? instance->DeviceId()
+            : -1);
     if (init_state) {
       sched->batchers_.push_back(std::move(sb));
       // All sequence slots in the batcher are initially ready for a
       // new sequence.
       for (size_t b = 0; b < seq_slot_cnt; ++b) {
-        sched->ready_batcher_seq_slots_.push(
-            SequenceBatchScheduler::BatcherSequenceSlot(index, b));
+        sched->ready_seq_slots_[index].push(b);
       }
+      sched->ready_seq_slot_cnt_ += seq_slot_cnt;
     }
     ++index;
   }
@@ -561,123 +612,169 @@ SequenceBatchScheduler::Enqueue(std::unique_ptr<InferenceRequest>& irequest)
         "inference requests");
   }
 
-  std::unique_lock<std::mutex> lock(mu_);
-
-  auto sb_itr = sequence_to_batcherseqslot_map_.find(correlation_id);
-  auto bl_itr = sequence_to_backlog_map_.find(correlation_id);
-
-  // If this request is not starting a new sequence its correlation ID
-  // should already be known with a target in either a sequence slot
-  // or in the backlog. If it doesn't then the sequence wasn't started
-  // correctly or there has been a correlation ID conflict. In either
-  // case fail this request.
-  if (!seq_start && (sb_itr == sequence_to_batcherseqslot_map_.end()) &&
-      (bl_itr == sequence_to_backlog_map_.end())) {
-    std::string correlation_id_str{""};
-    if (correlation_id.Type() ==
-        InferenceRequest::SequenceId::DataType::STRING) {
-      correlation_id_str = correlation_id.StringValue();
-    } else if (
-        correlation_id.Type() ==
-        InferenceRequest::SequenceId::DataType::UINT64) {
-      correlation_id_str = std::to_string(correlation_id.UnsignedIntValue());
+  // The timestamp of this request for the correlation ID. The reaper
+  // thread will check to make sure that max_sequence_idle_microseconds
+  // value is not exceed for any sequence, and if it is it will release the
+  // sequence slot (if any) allocated to that sequence.
+  const uint64_t now_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+
+  SequenceShard& shard = Shard(correlation_id);
+  BatcherSequenceSlotMap& batcherseqslot_map =
+      shard.sequence_to_batcherseqslot_map_;
+  size_t batcher_idx;
+  uint32_t seq_slot;
+
+  // A request continuing a sequence that already has an assigned slot
+  // only needs the lock of the shard of the sequence.
+  bool assigned = false;
+  if (!seq_start) {
+    std::lock_guard<std::mutex> shard_lock(shard.mu_);
+    auto sb_itr = batcherseqslot_map.find(correlation_id);
+    if (sb_itr != batcherseqslot_map.end()) {
+      shard.RecordActivity(correlation_id, now_us);
+      batcher_idx = sb_itr->second.batcher_idx_;
+      seq_slot = sb_itr->second.seq_slot_;
+      if (seq_end) {
+        batcherseqslot_map.erase(sb_itr);
+      }
+      assigned = true;
     }
-    return Status(
-        Status::Code::INVALID_ARG,
-        "inference request for sequence " + correlation_id_str + " to model '" +
-            irequest->ModelName() +
-            "' must specify the START flag on the first request of the "
-            "sequence");
   }
 
-  // Record the timestamp of this request for the correlation ID. The
-  // reaper thread will check to make sure that
-  // max_sequence_idle_microseconds value is not exceed for any
-  // sequence, and if it is it will release the sequence slot (if any)
-  // allocated to that sequence.
-  {
-    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
-                          std::chrono::steady_clock::now().time_since_epoch())
-                          .count();
-    correlation_id_timestamps_[correlation_id] = now_us;
-  }
-
-  // If this request starts a new sequence but the correlation ID
-  // already has an in-progress sequence then that previous sequence
-  // did not end correctly, or there is a correlation ID conflict. In
-  // this case we continue the new sequence (in either backlog or
-  // sequence slot). It is ok for a backlog/slot to have multiple
-  // starts... as long as it has a single end. The previous sequence
-  // that was not correctly ended will have its existing requests
-  // handled and then the new sequence will start.
-  if (seq_start && ((sb_itr != sequence_to_batcherseqslot_map_.end()) ||
-                    (bl_itr != sequence_to_backlog_map_.end()))) {
-    LOG_WARNING
-        << "sequence " << correlation_id << " for model '"
-        << irequest->ModelName()
-        << "' has a conflict. The previous sequence did not end before this "
-           "sequence start. Previous sequence will be terminated early.";
-  }
-
-  // This request already has an assigned slot...
-  if (sb_itr != sequence_to_batcherseqslot_map_.end()) {
-    target = &sb_itr->second;
-  }
-  // This request already has a queue in the backlog...
-  else if (bl_itr != sequence_to_backlog_map_.end()) {
-    LOG_VERBOSE(1) << "Enqueuing CORRID " << correlation_id
-                   << " into existing backlog: " << irequest->ModelName();
-
-    bl_itr->second->emplace_back(std::move(irequest));
-
-    // If the sequence is ending then forget correlation ID
-    // connection to this backlog queue. If another sequence starts
-    // with the same correlation ID it will be collected in another
-    // backlog queue.
-    if (seq_end) {
-      sequence_to_backlog_map_.erase(bl_itr);
+  // Otherwise the sequence may be starting or in the backlog, which
+  // require the scheduler lock. The slot assignment is checked again as it
+  // may have changed while no lock was held.
+  if (!assigned) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::lock_guard<std::mutex> shard_lock(shard.mu_);
+
+    auto sb_itr = batcherseqslot_map.find(correlation_id);
+    auto bl_itr = sequence_to_backlog_map_.find(correlation_id);
+
+    // If this request is not starting a new sequence its correlation ID
+    // should already be known with a target in either a sequence slot
+    // or in the backlog. If it doesn't then the sequence wasn't started
+    // correctly or there has been a correlation ID conflict. In either
+    // case fail this request.
+    if (!seq_start && (sb_itr == batcherseqslot_map.end()) &&
+        (bl_itr == sequence_to_backlog_map_.end())) {
+      std::string correlation_id_str{""};
+      if (correlation_id.Type() ==
+          InferenceRequest::SequenceId::DataType::STRING) {
+        correlation_id_str = correlation_id.StringValue();
+      } else if (
+          correlation_id.Type() ==
+          InferenceRequest::SequenceId::DataType::UINT64) {
+        correlation_id_str = std::to_string(correlation_id.UnsignedIntValue());
+      }
+      return Status(
+          Status::Code::INVALID_ARG,
+          "inference request for sequence " + correlation_id_str +
+              " to model '" + irequest->ModelName() +
+              "' must specify the START flag on the first request of the "
+              "sequence");
     }
-    return Status::Success;
-  }
-  // This request does not have an assigned backlog or sequence
-  // slot. By the above checks it must be starting. If there is a free
-  // sequence slot available then assign this sequence to that slot...
-  else if (!ready_batcher_seq_slots_.empty()) {
-    target = &sequence_to_batcherseqslot_map_[correlation_id];
-    *target = ready_batcher_seq_slots_.top();
-    ready_batcher_seq_slots_.pop();
-  }
-  // Last option is to assign this request to the backlog...
-  else {
-    LOG_VERBOSE(1) << "Enqueuing CORRID " << correlation_id
-                   << " into new backlog: " << irequest->ModelName();
-
-    auto backlog =
-        std::make_shared<std::deque<std::unique_ptr<InferenceRequest>>>();
-    backlog_queues_.push_back(backlog);
-    backlog->emplace_back(std::move(irequest));
-    if (!seq_end) {
-      sequence_to_backlog_map_[correlation_id] = std::move(backlog);
+
+    // A new sequence that has to wait in the backlog is rejected if the
+    // backlog is full.
+    if ((max_backlog_sequences_ > 0) && (sb_itr == batcherseqslot_map.end()) &&
+        (bl_itr == sequence_to_backlog_map_.end()) &&
+        (ready_seq_slot_cnt_ == 0) &&
+        (backlog_queues_.size() >= max_backlog_sequences_)) {
+      sequence_stats_->SequenceRejected();
+      return Status(
+          Status::Code::UNAVAILABLE,
+          "inference request starting a sequence to model '" +
+              irequest->ModelName() +
+              "' rejected, the sequence backlog is full with " +
+              std::to_string(backlog_queues_.size()) + " sequences");
     }
-    return Status::Success;
-  }
 
-  // Need to grab the target contents before the erase below since
-  // that can free it.
-  const size_t batcher_idx = target->batcher_idx_;
-  const uint32_t seq_slot = target->seq_slot_;
+    shard.RecordActivity(correlation_id, now_us);
+
+    // If this request starts a new sequence but the correlation ID
+    // already has an in-progress sequence then that previous sequence
+    // did not end correctly, or there is a correlation ID conflict. In
+    // this case we continue the new sequence (in either backlog or
+    // sequence slot). It is ok for a backlog/slot to have multiple
+    // starts... as long as it has a single end. The previous sequence
+    // that was not correctly ended will have its existing requests
+    // handled and then the new sequence will start.
+    if (seq_start && ((sb_itr != batcherseqslot_map.end()) ||
+                      (bl_itr != sequence_to_backlog_map_.end()))) {
+      LOG_WARNING
+          << "sequence " << correlation_id << " for model '"
+          << irequest->ModelName()
+          << "' has a conflict. The previous sequence did not end before "
+             "this sequence start. Previous sequence will be terminated "
+             "early.";
+    }
 
-  // At this point the request has been assigned to a sequence
-  // slot. If the sequence is ending then stop tracking the
-  // correlation.
-  if (seq_end) {
-    sequence_to_batcherseqslot_map_.erase(correlation_id);
-  }
+    // This request already has an assigned slot...
+    if (sb_itr != batcherseqslot_map.end()) {
+      target = &sb_itr->second;
+    }
+    // This request already has a queue in the backlog...
+    else if (bl_itr != sequence_to_backlog_map_.end()) {
+      LOG_VERBOSE(1) << "Enqueuing CORRID " << correlation_id
+                     << " into existing backlog: " << irequest->ModelName();
+
+      bl_itr->second->emplace_back(std::move(irequest));
+
+      // If the sequence is ending then forget correlation ID
+      // connection to this backlog queue. If another sequence starts
+      // with the same correlation ID it will be collected in another
+      // backlog queue.
+      if (seq_end) {
+        sequence_to_backlog_map_.erase(bl_itr);
+      }
+      return Status::Success;
+    }
+    // This request does not have an assigned backlog or sequence
+    // slot. By the above checks it must be starting. If there is a free
+    // sequence slot available then assign this sequence to that slot...
+    else if (ready_seq_slot_cnt_ > 0) {
+      target = &batcherseqslot_map[correlation_id];
+      *target = TakeSequenceSlot(SelectBatcher(*irequest));
+      sequence_stats_->SequenceSlotAssigned(
+          target->batcher_idx_, 0 /* wait_ns */);
+    }
+    // Last option is to assign this request to the backlog...
+    else {
+      LOG_VERBOSE(1) << "Enqueuing CORRID " << correlation_id
+                     << " into new backlog: " << irequest->ModelName();
+
+      std::shared_ptr<BacklogQueue> backlog;
+      if (!backlog_freelist_.Get(&backlog)) {
+        backlog = std::make_shared<BacklogQueue>();
+      }
+      backlog_queues_.push_back(backlog);
+      sequence_stats_->SequenceBacklogged();
+      backlog->emplace_back(std::move(irequest));
+      if (!seq_end) {
+        sequence_to_backlog_map_[correlation_id] = std::move(backlog);
+      }
+      return Status::Success;
+    }
+
+    // Need to grab the target contents before the erase below since
+    // that can free it.
+    batcher_idx = target->batcher_idx_;
+    seq_slot = target->seq_slot_;
 
-  // Enqueue request into batcher and sequence slot.  Don't hold the
-  // lock while enqueuing in a specific batcher.
-  lock.unlock();
+    // At this point the request has been assigned to a sequence
+    // slot. If the sequence is ending then stop tracking the
+    // correlation.
+    if (seq_end) {
+      batcherseqslot_map.erase(correlation_id);
+    }
+  }
 
+  // Enqueue request into batcher and sequence slot. Don't hold the
+  // locks while enqueuing in a specific batcher.
   LOG_VERBOSE(1) << "Enqueuing CORRID " << correlation_id << " into batcher "
                  << batcher_idx << ", sequence slot " << seq_slot << ": "
                  << irequest->ModelName();
@@ -697,9 +794,15 @@ SequenceBatchScheduler::ReleaseSequenceSlot(
   // If there is a backlogged sequence and it is requested, return it
   // so that it can use the newly available sequence slot.
   if (!backlog_queues_.empty()) {
-    auto& backlog = backlog_queues_.front();
-    *requests = std::move(*backlog);
+    std::shared_ptr<BacklogQueue> backlog = std::move(backlog_queues_.front());
     backlog_queues_.pop_front();
+    sequence_stats_->SequenceUnbacklogged();
+    requests->clear();
+    for (auto& backlog_request : *backlog) {
+      requests->emplace_back(std::move(backlog_request));
+    }
+    backlog->clear();
+    backlog_freelist_.Put(backlog);
     if (!requests->empty()) {  // should never be empty...
       const auto& irequest = requests->back();
       const InferenceRequest::SequenceId& correlation_id =
@@ -713,11 +816,14 @@ SequenceBatchScheduler::ReleaseSequenceSlot(
       const bool seq_end =
           ((irequest->Flags() & TRITONSERVER_REQUEST_FLAG_SEQUENCE_END) != 0);
       if (!seq_end) {
+        SequenceShard& shard = Shard(correlation_id);
+        std::lock_guard<std::mutex> shard_lock(shard.mu_);
+
         // Since the correlation ID is being actively collected in the
         // backlog, there should not be any in-flight sequences with
         // that same correlation ID that have an assigned slot.
-        if (sequence_to_batcherseqslot_map_.find(correlation_id) !=
-            sequence_to_batcherseqslot_map_.end()) {
+        if (shard.sequence_to_batcherseqslot_map_.find(correlation_id) !=
+            shard.sequence_to_batcherseqslot_map_.end()) {
           LOG_ERROR << irequest->LogRequest() << "internal: backlog sequence "
                     << correlation_id
                     << " conflicts with in-flight sequence for model '"
@@ -725,13 +831,26 @@ SequenceBatchScheduler::ReleaseSequenceSlot(
         }
 
         sequence_to_backlog_map_.erase(correlation_id);
-        sequence_to_batcherseqslot_map_[correlation_id] = batcher_seq_slot;
+        shard.sequence_to_batcherseqslot_map_[correlation_id] =
+            batcher_seq_slot;
       }
 
       LOG_VERBOSE(1) << irequest->LogRequest() << "CORRID " << correlation_id
                      << " reusing batcher " << batcher_seq_slot.batcher_idx_
                      << ", slot " << batcher_seq_slot.seq_slot_ << ": "
                      << irequest->ModelName();
+
+      // The previous sequence of the slot has ended and the backlogged
+      // sequence takes its place.
+      const uint64_t now_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count();
+      const uint64_t queue_start_ns = requests->front()->QueueStartNs();
+      sequence_stats_->SequenceSlotReleased(batcher_seq_slot.batcher_idx_);
+      sequence_stats_->SequenceSlotAssigned(
+          batcher_seq_slot.batcher_idx_,
+          (now_ns > queue_start_ns) ? (now_ns - queue_start_ns) : 0);
       return correlation_id;
     }
   }
@@ -740,10 +859,85 @@ SequenceBatchScheduler::ReleaseSequenceSlot(
   LOG_VERBOSE(1) << "Freeing slot in batcher " << batcher_seq_slot.batcher_idx_
                  << ", slot " << batcher_seq_slot.seq_slot_;
 
-  ready_batcher_seq_slots_.push(batcher_seq_slot);
+  ready_seq_slots_[batcher_seq_slot.batcher_idx_].push(
+      batcher_seq_slot.seq_slot_);
+  ++ready_seq_slot_cnt_;
+  --device_sequence_cnts_[batcher_devices_[batcher_seq_slot.batcher_idx_]];
+  sequence_stats_->SequenceSlotReleased(batcher_seq_slot.batcher_idx_);
   return InferenceRequest::SequenceId();
 }
 
+size_t
+SequenceBatchScheduler::SelectBatcher(const InferenceRequest& irequest)
+{
+  const std::string* affinity = nullptr;
+  if (load_aware_placement_) {
+    affinity = irequest.StringParameter(kSequenceAffinityParameter);
+    if (affinity != nullptr) {
+      const auto itr = affinity_batchers_.find(*affinity);
+      if ((itr != affinity_batchers_.end()) &&
+          !ready_seq_slots_[itr->second].empty()) {
+        return itr->second;
+      }
+    }
+  }
+
+  size_t selected = ready_seq_slots_.size();
+  size_t selected_device_cnt = 0;
+  size_t selected_batcher_cnt = 0;
+  for (size_t b = 0; b < ready_seq_slots_.size(); ++b) {
+    const auto& ready = ready_seq_slots_[b];
+    if (ready.empty()) {
+      continue;
+    }
+
+    const size_t device_cnt = device_sequence_cnts_[batcher_devices_[b]];
+    const size_t batcher_cnt = seq_slot_cnt_ - ready.size();
+    bool better = (selected == ready_seq_slots_.size());
+    if (!better) {
+      if (load_aware_placement_ && (device_cnt != selected_device_cnt)) {
+        better = (device_cnt < selected_device_cnt);
+      } else if (
+          load_aware_placement_ && (batcher_cnt != selected_batcher_cnt)) {
+        better = (batcher_cnt < selected_batcher_cnt);
+      } else {
+        better = (ready.top() < ready_seq_slots_[selected].top());
+      }
+    }
+    if (better) {
+      selected = b;
+      selected_device_cnt = device_cnt;
+      selected_batcher_cnt = batcher_cnt;
+    }
+  }
+
+  if (affinity != nullptr) {
+    auto res = affinity_batchers_.emplace(*affinity, selected);
+    if (res.second) {
+      affinity_order_.push_back(*affinity);
+      if (affinity_order_.size() > kMaxAffinityCount) {
+        affinity_batchers_.erase(affinity_order_.front());
+        affinity_order_.pop_front();
+      }
+    } else {
+      res.first->second = selected;
+    }
+  }
+
+  return selected;
+}
+
+SequenceBatchScheduler::BatcherSequenceSlot
+SequenceBatchScheduler::TakeSequenceSlot(const size_t batcher_idx)
+{
+  auto& ready = ready_seq_slots_[batcher_idx];
+  BatcherSequenceSlot batcher_seq_slot(batcher_idx, ready.top());
+  ready.pop();
+  --ready_seq_slot_cnt_;
+  ++device_sequence_cnts_[batcher_devices_[batcher_idx]];
+  return batcher_seq_slot;
+}
+
 bool
 SequenceBatchScheduler::DelayScheduler(
     const uint32_t batcher_idx, const size_t cnt, const size_t total)
@@ -774,6 +968,25 @@ SequenceBatchScheduler::DelayScheduler(
   return false;
 }
 
+void
+SequenceBatchScheduler::SequenceShard::RecordActivity(
+    const InferenceRequest::SequenceId& correlation_id, const uint64_t now_us)
+{
+  auto res = correlation_id_timestamps_.emplace(
+      correlation_id, SequenceActivity{now_us, sequence_lru_.end()});
+  SequenceActivity& activity = res.first->second;
+  activity.timestamp_us_ = now_us;
+  if (activity.lru_itr_ != sequence_lru_.end()) {
+    sequence_lru_.splice(sequence_lru_.end(), sequence_lru_, activity.lru_itr_);
+  } else {
+    if (!res.second) {
+      idle_backlog_sequences_.erase(correlation_id);
+    }
+    activity.lru_itr_ =
+        sequence_lru_.insert(sequence_lru_.end(), correlation_id);
+  }
+}
+
 void
 SequenceBatchScheduler::ReaperThread(const int nice)
 {
@@ -792,6 +1005,10 @@ SequenceBatchScheduler::ReaperThread(const int nice)
 
   const uint64_t backlog_idle_wait_microseconds = 50 * 1000;
 
+  // Bound the number of idle sequences handled each time the lock is held
+  // so that a burst of expiring sequences doesn't stall the requests.
+  const size_t max_reap_count = 1024;
+
   while (!reaper_thread_exit_) {
     uint64_t wait_microseconds = max_sequence_idle_microseconds_;
     BatcherSequenceSlotMap force_end_sequences;
@@ -803,50 +1020,93 @@ SequenceBatchScheduler::ReaperThread(const int nice)
                             std::chrono::steady_clock::now().time_since_epoch())
                             .count();
 
-      for (auto cid_itr = correlation_id_timestamps_.cbegin();
-           cid_itr != correlation_id_timestamps_.cend();) {
-        int64_t remaining_microseconds =
-            (int64_t)max_sequence_idle_microseconds_ -
-            (now_us - cid_itr->second);
-        if (remaining_microseconds > 0) {
-          wait_microseconds =
-              std::min(wait_microseconds, (uint64_t)remaining_microseconds + 1);
-          ++cid_itr;
-          continue;
-        }
-
-        const InferenceRequest::SequenceId& idle_correlation_id =
-            cid_itr->first;
-        LOG_VERBOSE(1) << "Reaper: CORRID " << idle_correlation_id
-                       << ": max sequence idle exceeded";
-
-        auto idle_sb_itr =
-            sequence_to_batcherseqslot_map_.find(idle_correlation_id);
-
-        // If the idle correlation ID has an assigned sequence slot,
-        // then release that assignment so it becomes available for
-        // another sequence. Release is done by enqueuing and must be
-        // done outside the lock, so just collect needed info here.
-        if (idle_sb_itr != sequence_to_batcherseqslot_map_.end()) {
-          force_end_sequences[idle_correlation_id] = idle_sb_itr->second;
-
-          sequence_to_batcherseqslot_map_.erase(idle_correlation_id);
-          cid_itr = correlation_id_timestamps_.erase(cid_itr);
-        } else {
-          // If the idle correlation ID is in the backlog, then just
-          // need to increase the timeout so that we revisit it again in
-          // the future to check if it is assigned to a sequence slot.
-          auto idle_bl_itr = sequence_to_backlog_map_.find(idle_correlation_id);
-          if (idle_bl_itr != sequence_to_backlog_map_.end()) {
-            LOG_VERBOSE(1) << "Reaper: found idle CORRID "
-                           << idle_correlation_id;
+      size_t reap_count = 0;
+      for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> shard_lock(shard.mu_);
+
+        // Revisit the idle sequences that were waiting in the backlog to
+        // check if they have been assigned a sequence slot.
+        for (auto cid_itr = shard.idle_backlog_sequences_.begin();
+             cid_itr != shard.idle_backlog_sequences_.end();) {
+          const InferenceRequest::SequenceId& idle_correlation_id = *cid_itr;
+          auto idle_sb_itr =
+              shard.sequence_to_batcherseqslot_map_.find(idle_correlation_id);
+          if (idle_sb_itr != shard.sequence_to_batcherseqslot_map_.end()) {
+            LOG_VERBOSE(1) << "Reaper: CORRID " << idle_correlation_id
+                           << ": max sequence idle exceeded";
+            force_end_sequences[idle_correlation_id] = idle_sb_itr->second;
+            shard.sequence_to_batcherseqslot_map_.erase(idle_sb_itr);
+          } else if (
+              sequence_to_backlog_map_.find(idle_correlation_id) !=
+              sequence_to_backlog_map_.end()) {
             wait_microseconds =
                 std::min(wait_microseconds, backlog_idle_wait_microseconds);
             ++cid_itr;
+            continue;
           } else {
             LOG_VERBOSE(1) << "Reaper: ignoring stale idle CORRID "
                            << idle_correlation_id;
-            cid_itr = correlation_id_timestamps_.erase(cid_itr);
+          }
+          shard.correlation_id_timestamps_.erase(idle_correlation_id);
+          cid_itr = shard.idle_backlog_sequences_.erase(cid_itr);
+        }
+
+        while (!shard.sequence_lru_.empty()) {
+          auto cid_itr = shard.correlation_id_timestamps_.find(
+              shard.sequence_lru_.front());
+          int64_t remaining_microseconds =
+              (int64_t)max_sequence_idle_microseconds_ -
+              (now_us - cid_itr->second.timestamp_us_);
+          if (remaining_microseconds > 0) {
+            wait_microseconds = std::min(
+                wait_microseconds, (uint64_t)remaining_microseconds + 1);
+            break;
+          }
+
+          // Come back right away for the remaining idle sequences once the
+          // lock has been released.
+          if (reap_count == max_reap_count) {
+            wait_microseconds = 0;
+            break;
+          }
+          ++reap_count;
+
+          const InferenceRequest::SequenceId& idle_correlation_id =
+              cid_itr->first;
+          LOG_VERBOSE(1) << "Reaper: CORRID " << idle_correlation_id
+                         << ": max sequence idle exceeded";
+          shard.sequence_lru_.pop_front();
+
+          auto idle_sb_itr =
+              shard.sequence_to_batcherseqslot_map_.find(idle_correlation_id);
+
+          // If the idle correlation ID has an assigned sequence slot,
+          // then release that assignment so it becomes available for
+          // another sequence. Release is done by enqueuing and must be
+          // done outside the lock, so just collect needed info here.
+          if (idle_sb_itr != shard.sequence_to_batcherseqslot_map_.end()) {
+            force_end_sequences[idle_correlation_id] = idle_sb_itr->second;
+
+            shard.sequence_to_batcherseqslot_map_.erase(idle_sb_itr);
+            shard.correlation_id_timestamps_.erase(cid_itr);
+          } else {
+            // If the idle correlation ID is in the backlog, then just
+            // need to revisit it in the future to check if it is assigned
+            // to a sequence slot.
+            auto idle_bl_itr =
+                sequence_to_backlog_map_.find(idle_correlation_id);
+            if (idle_bl_itr != sequence_to_backlog_map_.end()) {
+              LOG_VERBOSE(1) << "Reaper: found idle CORRID "
+                             << idle_correlation_id;
+              wait_microseconds =
+                  std::min(wait_microseconds, backlog_idle_wait_microseconds);
+              cid_itr->second.lru_itr_ = shard.sequence_lru_.end();
+              shard.idle_backlog_sequences_.insert(idle_correlation_id);
+            } else {
+              LOG_VERBOSE(1) << "Reaper: ignoring stale idle CORRID "
+                             << idle_correlation_id;
+              shard.correlation_id_timestamps_.erase(cid_itr);
+            }
           }
         }
       }
@@ -868,6 +1128,17 @@ SequenceBatchScheduler::ReaperThread(const int nice)
       std::unique_ptr<InferenceRequest> null_request;
       batchers_[batcher_idx]->Enqueue(
           seq_slot, idle_correlation_id, null_request);
+      sequence_stats_->SequenceEvicted();
+    }
+
+    // Offload the implicit state of the idle sequences outside of the
+    // lock, the batchers only offload the states not used by any request.
+    if (state_offload_idle_microseconds_ > 0) {
+      for (auto& batcher : batchers_) {
+        batcher->OffloadIdleStates(state_offload_idle_microseconds_ * 1000);
+      }
+      wait_microseconds =
+          std::min(wait_microseconds, state_offload_idle_microseconds_);
     }
 
     // Wait until the next idle timeout needs to be checked
@@ -905,8 +1176,32 @@ SequenceBatch::SequenceBatch(
       startend_input_overrides_(startend_input_overrides),
       continue_input_overrides_(continue_input_overrides),
       notready_input_overrides_(notready_input_overrides),
-      sequence_states_(seq_slot_cnt)
+      sequence_states_(seq_slot_cnt), state_use_ns_(seq_slot_cnt, 0),
+      state_stream_(nullptr)
 {
+#ifdef TRITON_ENABLE_GPU
+  if ((base_->StateOffloadIdleMicroseconds() > 0) &&
+      !base_->StateOutputConfigMap().empty()) {
+    auto cuerr = cudaStreamCreate(&state_stream_);
+    if (cuerr != cudaSuccess) {
+      state_stream_ = nullptr;
+      LOG_ERROR << "unable to create stream for sequence states of batcher "
+                << batcher_idx_ << ": " << cudaGetErrorString(cuerr);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+}
+
+SequenceBatch::~SequenceBatch()
+{
+#ifdef TRITON_ENABLE_GPU
+  if (state_stream_ != nullptr) {
+    cudaError_t err = cudaStreamDestroy(state_stream_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "Failed to destroy cuda stream: " << cudaGetErrorString(err);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
 }
 
 bool
@@ -950,12 +1245,54 @@ SequenceBatch::CreateCorrelationIDControl(const inference::ModelConfig& config)
       tensor_shape_with_batch_dim.push_back(1);
     }
 
-    auto override = std::make_shared<InferenceRequest::Input>(
-        correlation_id_tensor_name, correlation_id_datatype, tensor_shape);
-    *override->MutableShape() = override->OriginalShape();
-    *override->MutableShapeWithBatchDim() = tensor_shape_with_batch_dim;
+    size_t corrid_byte_size =
+        triton::common::GetDataTypeByteSize(correlation_id_datatype);
+    if (correlation_id_datatype == inference::DataType::TYPE_STRING) {
+      // 4 bytes for length of string plus pre-defined max string correlation id
+      // length in bytes
+      corrid_byte_size =
+          4 + triton::core::STRING_CORRELATION_ID_MAX_LENGTH_BYTES;
+    }
+
+    // The CORRID values of all the sequence slots are held in one buffer,
+    // in slot order, so that the values of a batch of consecutive slots are
+    // contiguous. Each slot has an override input referring to its part of
+    // the buffer that is updated in place for each request.
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    corrid_block_ = std::make_shared<AllocatedMemory>(
+        corrid_byte_size * seq_slot_cnt_, TRITONSERVER_MEMORY_CPU, 0);
+    char* corrid_block_ptr =
+        corrid_block_->MutableBuffer(&memory_type, &memory_type_id);
+    if ((corrid_block_ptr == nullptr) ||
+        ((memory_type != TRITONSERVER_MEMORY_CPU) &&
+         (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) ||
+        (memory_type_id != 0)) {
+      LOG_ERROR << "failed to allocate sequence CORRID control signal in CPU "
+                   "memory";
+      return false;
+    }
+
+    for (size_t seq_slot = 0; seq_slot < seq_slot_cnt_; ++seq_slot) {
+      auto override = std::make_shared<InferenceRequest::Input>(
+          correlation_id_tensor_name, correlation_id_datatype, tensor_shape);
+      *override->MutableShape() = override->OriginalShape();
+      *override->MutableShapeWithBatchDim() = tensor_shape_with_batch_dim;
+
+      auto corrid_p = std::make_shared<MemoryReference>();
+      corrid_p->AddBuffer(
+          corrid_block_ptr + (seq_slot * corrid_byte_size), corrid_byte_size,
+          memory_type, memory_type_id);
+      Status status = override->SetData(corrid_p);
+      if (!status.IsOk()) {
+        LOG_ERROR << "failed creating CORRID control for sequence-batch "
+                     "scheduler thread "
+                  << batcher_idx_ << " for " << correlation_id_tensor_name;
+        return false;
+      }
 
-    seq_slot_corrid_override_ = std::move(override);
+      seq_slot_corrid_overrides_.emplace_back(std::move(override));
+    }
   }
 
   return true;
@@ -991,41 +1328,17 @@ SequenceBatch::SetControlTensors(
     irequest->AddOverrideInput(control);
   }
 
-  // Set correlation ID control tensor if requested by the model.
-  if (seq_slot_corrid_override_ != nullptr) {
-    auto& seq_corr_id = seq_slot_corrid_override_;
-    size_t size_p = triton::common::GetDataTypeByteSize(seq_corr_id->DType());
-    if (seq_corr_id->DType() == inference::DataType::TYPE_STRING) {
-      // 4 bytes for length of string plus pre-defined max string correlation id
-      // length in bytes
-      size_p = 4 + triton::core::STRING_CORRELATION_ID_MAX_LENGTH_BYTES;
-    }
-
+  // Set correlation ID control tensor if requested by the model. The
+  // previous request of the slot has completed so its value can be
+  // overwritten.
+  if (!seq_slot_corrid_overrides_.empty()) {
+    const auto& override = seq_slot_corrid_overrides_[seq_slot];
+    size_t byte_size;
     TRITONSERVER_MemoryType memory_type;
     int64_t memory_type_id;
-    auto corrid_p =
-        std::make_shared<AllocatedMemory>(size_p, TRITONSERVER_MEMORY_CPU, 0);
-    char* corrid_p_ptr = corrid_p->MutableBuffer(&memory_type, &memory_type_id);
-    if ((corrid_p_ptr == nullptr) ||
-        ((memory_type != TRITONSERVER_MEMORY_CPU) &&
-         (memory_type != TRITONSERVER_MEMORY_CPU_PINNED)) ||
-        (memory_type_id != 0)) {
-      LOG_ERROR << "failed to allocate sequence CORRID control signal in CPU "
-                   "memory";
-      return;
-    }
-
-    auto override = std::make_shared<InferenceRequest::Input>(
-        seq_corr_id->Name(), seq_corr_id->DType(), seq_corr_id->Shape());
-    *override->MutableShape() = override->OriginalShape();
-    *override->MutableShapeWithBatchDim() = seq_corr_id->ShapeWithBatchDim();
-    Status corrid_status = override->SetData(corrid_p);
-    if (!corrid_status.IsOk()) {
-      LOG_ERROR << "failed creating CORRID control for sequence-batch "
-                   "scheduler thread "
-                << batcher_idx_ << " for " << seq_corr_id->Name();
-      return;
-    }
+    char* corrid_p_ptr = const_cast<char*>(override->Data()->BufferAt(
+        0, &byte_size, &memory_type, &memory_type_id));
+    memset(corrid_p_ptr, 0, byte_size);
 
     if (corrid.Type() == InferenceRequest::SequenceId::DataType::STRING) {
       std::string correlation_id = corrid.StringValue();
@@ -1038,7 +1351,8 @@ SequenceBatch::SetControlTensors(
         corrid.Type() == InferenceRequest::SequenceId::DataType::UINT64) {
       uint64_t correlation_id = corrid.UnsignedIntValue();
       const char* corrid_ptr = reinterpret_cast<const char*>(&correlation_id);
-      memcpy(corrid_p_ptr, corrid_ptr, size_p);
+      memcpy(
+          corrid_p_ptr, corrid_ptr, std::min(byte_size, sizeof(uint64_t)));
     }
     irequest->AddOverrideInput(override);
   }
@@ -1052,9 +1366,34 @@ SequenceBatch::UpdateImplicitState(
   if (!base_->StateOutputConfigMap().empty()) {
     auto& sequence_states = sequence_states_[seq_slot];
 
-    // Initialize the input state if the sequence is starting.
-    if ((irequest->Flags() & TRITONSERVER_REQUEST_FLAG_SEQUENCE_START) != 0) {
-      sequence_states = nullptr;
+    // Initialize the input state if the sequence is starting, unless it
+    // was already done for this request. The states of the previous
+    // sequence in the slot are initialized again so that their buffers are
+    // reused, unless a request still holds them.
+    if (((irequest->Flags() & TRITONSERVER_REQUEST_FLAG_SEQUENCE_START) !=
+         0) &&
+        (irequest->GetSequenceStates() != sequence_states)) {
+      // The states of the previous sequence may be the target of a
+      // pending restore, which must complete before they are reset or
+      // freed.
+      if (sequence_states != nullptr) {
+        Status status = sequence_states->WaitRestore();
+        if (!status.IsOk()) {
+          LOG_ERROR << "failed to restore the sequence state in batcher "
+                    << batcher_idx_ << ", slot " << seq_slot << ": "
+                    << status.Message();
+        }
+      }
+      if ((sequence_states != nullptr) &&
+          ((sequence_states.use_count() != 1) ||
+           sequence_states->IsOffloaded())) {
+        sequence_states = nullptr;
+      }
+      if (sequence_states != nullptr) {
+        sequence_states->Initialize(
+            base_->StateOutputConfigMap(), base_->MaxBatchSize(),
+            base_->InitialState());
+      }
     }
 
     // Create the state for the first request in the sequence.
@@ -1063,12 +1402,115 @@ SequenceBatch::UpdateImplicitState(
       sequence_states->Initialize(
           base_->StateOutputConfigMap(), base_->MaxBatchSize(),
           base_->InitialState());
+    } else if (sequence_states->IsOffloaded()) {
+      // Bring back an offloaded state, the restore may already have been
+      // started when the request was enqueued. On failure the states left
+      // in system memory are still valid input for the model.
+      Status status = sequence_states->Restore(state_stream_);
+      Status wait_status = sequence_states->WaitRestore();
+      if (status.IsOk()) {
+        status = wait_status;
+      }
+      if (!status.IsOk()) {
+        LOG_ERROR << "failed to restore the sequence state in batcher "
+                  << batcher_idx_ << ", slot " << seq_slot << ": "
+                  << status.Message();
+      }
+    }
+
+    if (base_->StateOffloadIdleMicroseconds() > 0) {
+      state_use_ns_[seq_slot] =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count();
     }
 
     irequest->SetSequenceStates(sequence_states);
   }
 }
 
+bool
+SequenceBatch::OffloadIdleState(
+    const uint32_t seq_slot, const uint64_t now_ns, const uint64_t idle_ns)
+{
+  // The state is only referenced by the slot when no request is using it,
+  // and requests only get the state while holding the batcher lock that
+  // the caller holds.
+  auto& sequence_states = sequence_states_[seq_slot];
+  if ((sequence_states == nullptr) || (sequence_states.use_count() != 1) ||
+      sequence_states->IsOffloaded() ||
+      ((now_ns - state_use_ns_[seq_slot]) < idle_ns)) {
+    return false;
+  }
+
+  Status status = sequence_states->Offload(state_stream_);
+  if (!status.IsOk()) {
+    LOG_ERROR << "failed to offload the sequence state in batcher "
+              << batcher_idx_ << ", slot " << seq_slot << ": "
+              << status.Message();
+  } else if (sequence_states->IsOffloaded()) {
+    LOG_VERBOSE(1) << "offloaded idle sequence state in batcher "
+                   << batcher_idx_ << ", slot " << seq_slot;
+  }
+  return true;
+}
+
+void
+SequenceBatch::FinishOffloads(
+    const std::vector<uint32_t>& seq_slots, std::mutex* mu)
+{
+  if (seq_slots.empty()) {
+    return;
+  }
+
+  // Wait for the copies without holding the batcher lock so that the
+  // other sequence slots are not stalled. The GPU memory of the states is
+  // then released under the lock, unless a request restored or replaced
+  // the states in the meantime.
+#ifdef TRITON_ENABLE_GPU
+  if (state_stream_ != nullptr) {
+    cudaError_t err = cudaStreamSynchronize(state_stream_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "failed to offload the sequence states in batcher "
+                << batcher_idx_ << ": " << cudaGetErrorString(err);
+    }
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  std::lock_guard<std::mutex> lock(*mu);
+  for (const auto seq_slot : seq_slots) {
+    auto& sequence_states = sequence_states_[seq_slot];
+    if (sequence_states != nullptr) {
+      Status status = sequence_states->WaitOffload();
+      if (!status.IsOk()) {
+        LOG_ERROR << "failed to offload the sequence state in batcher "
+                  << batcher_idx_ << ", slot " << seq_slot << ": "
+                  << status.Message();
+      }
+    }
+  }
+}
+
+void
+SequenceBatch::PrefetchState(
+    const uint32_t seq_slot, const std::unique_ptr<InferenceRequest>& request)
+{
+  // A starting sequence doesn't use the state of the previous one.
+  if ((request == nullptr) ||
+      ((request->Flags() & TRITONSERVER_REQUEST_FLAG_SEQUENCE_START) != 0)) {
+    return;
+  }
+  auto& sequence_states = sequence_states_[seq_slot];
+  if ((sequence_states != nullptr) && sequence_states->IsOffloaded()) {
+    Status status = sequence_states->Restore(state_stream_);
+    if (!status.IsOk()) {
+      LOG_ERROR << "failed to prefetch the sequence state in batcher "
+                << batcher_idx_ << ", slot " << seq_slot << ": "
+                << status.Message();
+    }
+  }
+}
+
 DirectSequenceBatch::DirectSequenceBatch(
     SequenceBatchScheduler* base, const uint32_t batcher_idx,
     const size_t seq_slot_cnt, TritonModelInstance* model_instance,
@@ -1108,6 +1550,8 @@ DirectSequenceBatch::DirectSequenceBatch(
       config.sequence_batching().direct().minimum_slot_utilization();
   pending_batch_delay_ns_ =
       config.sequence_batching().direct().max_queue_delay_microseconds() * 1000;
+  fill_policy_.reset(new BatchFillPolicy(
+      minimum_slot_utilization_, pending_batch_delay_ns_, max_batch_size_));
 
   // Create a scheduler thread associated with 'batcher_idx' that
   // executes the queued requests.
@@ -1150,6 +1594,7 @@ DirectSequenceBatch::Enqueue(
   {
     std::lock_guard<std::mutex> lock(mu_);
 
+    PrefetchState(seq_slot, request);
     queues_[seq_slot].emplace_back(std::move(request));
 
     seq_slot_correlation_ids_[seq_slot] = correlation_id;
@@ -1167,6 +1612,28 @@ DirectSequenceBatch::Enqueue(
   }
 }
 
+void
+DirectSequenceBatch::OffloadIdleStates(const uint64_t idle_ns)
+{
+  std::vector<uint32_t> offloaded_slots;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+
+    const uint64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    for (int32_t seq_slot = 0; seq_slot <= max_active_seq_slot_;
+         ++seq_slot) {
+      if (queues_[seq_slot].empty() &&
+          OffloadIdleState(seq_slot, now_ns, idle_ns)) {
+        offloaded_slots.push_back(seq_slot);
+      }
+    }
+  }
+  FinishOffloads(offloaded_slots, &mu_);
+}
+
 void
 DirectSequenceBatch::NewPayload()
 {
@@ -1317,40 +1784,37 @@ DirectSequenceBatch::BatcherThread(const int nice)
         }
 
         if (max_seq_slot != -1) {
-          if ((pending_batch_delay_ns_ == 0) ||
-              (minimum_slot_utilization_ == 0.0)) {
+          if (!fill_policy_->Enabled()) {
             wait_microseconds = 0;
           } else {
-            // Compare the age of the oldest pending request to the maximum
-            // batch queuing delay, and the size of the ready requests in the
-            // batch, execute now if queuing delay is exceeded or the batch
-            // size is large enough. Otherwise create a timer to wakeup a
-            // thread to check again at the maximum allowed delay.
+            // Execute now if the batch is filled enough or its oldest
+            // request waited long enough. Otherwise wake up to check again
+            // when the oldest request reaches the maximum delay, or when a
+            // new request is enqueued.
             uint64_t now_ns =
                 std::chrono::duration_cast<std::chrono::nanoseconds>(
                     std::chrono::steady_clock::now().time_since_epoch())
                     .count();
-            uint64_t current_batch_delay_ns =
-                (now_ns - earliest_enqueue_time_ns);
-            if ((current_batch_delay_ns > pending_batch_delay_ns_) ||
-                (((float)ready_cnt) / max_batch_size_ >=
-                 minimum_slot_utilization_)) {
+            const uint64_t wait_ns = fill_policy_->WaitNs(
+                ready_cnt, earliest_enqueue_time_ns, now_ns);
+            if (wait_ns == 0) {
               wait_microseconds = 0;
               LOG_VERBOSE(1)
                   << "start sequence batch execution. "
-                  << "current batch delay: " << current_batch_delay_ns
+                  << "current batch delay: "
+                  << (now_ns - earliest_enqueue_time_ns)
                   << "; maximum delay allowed: " << pending_batch_delay_ns_
                   << "slot utilization: " << ready_cnt << "/" << max_batch_size_
                   << "; utilization threshold: " << minimum_slot_utilization_;
             } else {
-              wait_microseconds =
-                  (pending_batch_delay_ns_ - current_batch_delay_ns) / 1000;
+              wait_microseconds = std::max<uint64_t>(1, wait_ns / 1000);
               // reset 'max_seq_slot' so that not request is pulled from the
               // queues
               max_seq_slot = -1;
               LOG_VERBOSE(1)
                   << "defer sequence batch execution. "
-                  << "current batch delay: " << current_batch_delay_ns
+                  << "current batch delay: "
+                  << (now_ns - earliest_enqueue_time_ns)
                   << "; maximum delay allowed: " << pending_batch_delay_ns_
                   << "slot utilization: " << ready_cnt << "/" << max_batch_size_
                   << "; utilization threshold: " << minimum_slot_utilization_;
@@ -1536,9 +2000,24 @@ OldestSequenceBatch::OldestSequenceBatch(
   // Create a dynamic batcher use to batch together sequences for
   // inference.
   std::set<int32_t> preferred_batch_sizes;
-  for (const auto size :
-       config.sequence_batching().oldest().preferred_batch_size()) {
-    preferred_batch_sizes.insert(size);
+  uint64_t max_queue_delay_microseconds =
+      config.sequence_batching().oldest().max_queue_delay_microseconds();
+  bool preserve_ordering = true;
+  if (base_->ContinuousBatching()) {
+    // With continuous batching a batch is formed as soon as the instance
+    // is available, from all the sequences with a ready request. The next
+    // request of a sequence is queued when its previous request is
+    // released, so the sequences of a batch are ready again for the next
+    // execution, and a sequence taking a freed slot joins it. A sequence
+    // never has more than one request in the dynamic batcher, so the
+    // responses don't need to be reordered.
+    max_queue_delay_microseconds = 0;
+    preserve_ordering = false;
+  } else {
+    for (const auto size :
+         config.sequence_batching().oldest().preferred_batch_size()) {
+      preferred_batch_sizes.insert(size);
+    }
   }
 
   // TODO: Provide appropriate request_cache_enable flag when caching
@@ -1547,10 +2026,9 @@ OldestSequenceBatch::OldestSequenceBatch(
       model_instance->Model(), model_instance,
       triton::common::GetCpuNiceLevel(config),
       true /* dynamic_batching_enabled */, config.max_batch_size(),
-      enforce_equal_shape_tensors_, true /* preserve_ordering */,
+      enforce_equal_shape_tensors_, preserve_ordering,
       false /* response_cache_enable */, preferred_batch_sizes,
-      config.sequence_batching().oldest().max_queue_delay_microseconds(),
-      &dynamic_batcher_);
+      max_queue_delay_microseconds, &dynamic_batcher_);
   if (!status.IsOk()) {
     LOG_ERROR << "failed creating dynamic sequence batcher for OldestFirst "
               << batcher_idx_ << ": " << status.Message();
@@ -1679,12 +2157,36 @@ OldestSequenceBatch::Enqueue(
     std::lock_guard<std::mutex> lock(mu_);
 
     std::deque<std::unique_ptr<InferenceRequest>>& queue = queues_[seq_slot];
-    queue.emplace_back(std::move(request));
     in_flight = in_flight_[seq_slot];
+    if (in_flight) {
+      PrefetchState(seq_slot, request);
+    }
+    queue.emplace_back(std::move(request));
   }
 
   if (!in_flight) {
     CompleteAndNext(seq_slot);
   }
 }
+
+void
+OldestSequenceBatch::OffloadIdleStates(const uint64_t idle_ns)
+{
+  std::vector<uint32_t> offloaded_slots;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+
+    const uint64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    for (uint32_t seq_slot = 0; seq_slot < seq_slot_cnt_; ++seq_slot) {
+      if (!in_flight_[seq_slot] && queues_[seq_slot].empty() &&
+          OffloadIdleState(seq_slot, now_ns, idle_ns)) {
+        offloaded_slots.push_back(seq_slot);
+      }
+    }
+  }
+  FinishOffloads(offloaded_slots, &mu_);
+}
 }}  // namespace triton::core
@@ -25,26 +25,33 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <future>
+#include <list>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include "backend_model.h"
 #include "backend_model_instance.h"
 #include "model_config.pb.h"
+#include "object_freelist.h"
 #include "rate_limiter.h"
 #include "scheduler.h"
 #include "scheduler_utils.h"
 #include "sequence_state.h"
+#include "sequence_stats.h"
 #include "status.h"
 #include "triton/common/model_config.h"
 
 namespace triton { namespace core {
 
+class BatchFillPolicy;
 class SequenceBatch;
 
 // Scheduler that implements batching across sequences of correlated
@@ -69,8 +76,12 @@ class SequenceBatchScheduler : public Scheduler {
   // \see Scheduler::InflightInferenceCount()
   size_t InflightInferenceCount() override
   {
-    std::unique_lock<std::mutex> lock(mu_);
-    return sequence_to_batcherseqslot_map_.size();
+    size_t count = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> shard_lock(shard.mu_);
+      count += shard.sequence_to_batcherseqslot_map_.size();
+    }
+    return count;
   }
 
   // \see Scheduler::Stop()
@@ -105,6 +116,17 @@ class SequenceBatchScheduler : public Scheduler {
   }
 
   size_t MaxBatchSize() { return max_batch_size_; }
+
+  // The idle time after which the implicit state of a sequence is
+  // offloaded from GPU memory. Zero if the state is never offloaded.
+  uint64_t StateOffloadIdleMicroseconds()
+  {
+    return state_offload_idle_microseconds_;
+  }
+
+  // Whether the oldest strategy uses continuous batching.
+  bool ContinuousBatching() { return continuous_batching_; }
+
   const std::unordered_map<std::string, SequenceStates::InitialStateData>&
   InitialState()
   {
@@ -126,17 +148,25 @@ class SequenceBatchScheduler : public Scheduler {
       const inference::ModelSequenceBatching_InitialState& initial_state,
       const inference::ModelSequenceBatching_State& state, TritonModel* model);
 
-  struct BatcherSequenceSlotCompare {
-    bool operator()(
-        const BatcherSequenceSlot& a, const BatcherSequenceSlot& b) const
-    {
-      return a.seq_slot_ > b.seq_slot_;
-    }
-  };
+  // Select the batcher of a new sequence starting with 'irequest' among
+  // the batchers with a free sequence slot. Must be called with 'mu_'
+  // held and at least one free sequence slot.
+  size_t SelectBatcher(const InferenceRequest& irequest);
+
+  // Take the lowest free sequence slot of 'batcher_idx' for a new
+  // sequence. Must be called with 'mu_' held.
+  BatcherSequenceSlot TakeSequenceSlot(const size_t batcher_idx);
 
   // The max_sequence_idle_microseconds value for this scheduler.
   uint64_t max_sequence_idle_microseconds_;
 
+  // The sequence_state_offload_idle_microseconds parameter value for this
+  // scheduler.
+  uint64_t state_offload_idle_microseconds_;
+
+  // The sequence_batching_continuous parameter value for this scheduler.
+  bool continuous_batching_;
+
   bool stop_;
 
   // Mutex
@@ -154,32 +184,103 @@ class SequenceBatchScheduler : public Scheduler {
   // assigned to that correlation ID.
   using BatcherSequenceSlotMap =
       std::unordered_map<InferenceRequest::SequenceId, BatcherSequenceSlot>;
-  BatcherSequenceSlotMap sequence_to_batcherseqslot_map_;
+
+  // The correlation IDs ordered from the least to the most recently
+  // active. As all the sequences have the same idle timeout the front is
+  // always the next sequence to become idle, so the reaper only visits the
+  // sequences that are expiring.
+  using SequenceLRU = std::list<InferenceRequest::SequenceId>;
+
+  // The most recently seen timestamp, in microseconds, for a request using
+  // a correlation ID, and the position of the correlation ID in the LRU.
+  // The position is the end of the LRU for an idle sequence in the backlog.
+  struct SequenceActivity {
+    uint64_t timestamp_us_;
+    SequenceLRU::iterator lru_itr_;
+  };
+
+  // The state of the sequences whose correlation IDs hash to the shard. A
+  // request continuing a sequence that has a sequence slot only needs the
+  // lock of its shard, 'mu_' is only needed when a sequence starts, is in
+  // the backlog, or gets a sequence slot released. 'mu_' must be acquired
+  // before the lock of a shard when both are needed.
+  struct SequenceShard {
+    std::mutex mu_;
+
+    BatcherSequenceSlotMap sequence_to_batcherseqslot_map_;
+
+    SequenceLRU sequence_lru_;
+    std::unordered_map<InferenceRequest::SequenceId, SequenceActivity>
+        correlation_id_timestamps_;
+
+    // The idle sequences that were still in the backlog when they timed
+    // out. They are revisited periodically until they get a sequence slot
+    // or become active again.
+    std::unordered_set<InferenceRequest::SequenceId> idle_backlog_sequences_;
+
+    // Record a request of the sequence with 'correlation_id' at 'now_us',
+    // making it the most recently active sequence. Must be called with
+    // 'mu_' of the shard held.
+    void RecordActivity(
+        const InferenceRequest::SequenceId& correlation_id,
+        const uint64_t now_us);
+  };
+
+  static constexpr size_t kSequenceShardCount = 16;
+  SequenceShard& Shard(const InferenceRequest::SequenceId& correlation_id)
+  {
+    return shards_
+        [std::hash<InferenceRequest::SequenceId>()(correlation_id) %
+         kSequenceShardCount];
+  }
+  std::array<SequenceShard, kSequenceShardCount> shards_;
+
+  // The requests of a sequence waiting in the backlog. The queues are
+  // recycled through 'backlog_freelist_' so that a burst of backlogged
+  // sequences doesn't allocate a queue for each of them.
+  using BacklogQueue = std::vector<std::unique_ptr<InferenceRequest>>;
+  static constexpr size_t kBacklogFreelistCapacity = 1024;
+  SharedObjectFreelist<BacklogQueue> backlog_freelist_{
+      kBacklogFreelistCapacity};
 
   // Map from a request's correlation ID to the backlog queue
   // collecting requests for that correlation ID.
   using BacklogMap = std::unordered_map<
-      InferenceRequest::SequenceId,
-      std::shared_ptr<std::deque<std::unique_ptr<InferenceRequest>>>>;
+      InferenceRequest::SequenceId, std::shared_ptr<BacklogQueue>>;
   BacklogMap sequence_to_backlog_map_;
 
   // The ordered backlog of sequences waiting for a free sequenceslot.
-  std::deque<std::shared_ptr<std::deque<std::unique_ptr<InferenceRequest>>>>
-      backlog_queues_;
+  std::deque<std::shared_ptr<BacklogQueue>> backlog_queues_;
+
+  // The maximum number of sequences in 'backlog_queues_', 0 if unlimited.
+  size_t max_backlog_sequences_;
 
-  // The batcher/sequence-slot locations ready to accept a new
-  // sequence. Ordered from lowest sequence-slot-number to highest so
+  // The sequence slots of each batcher ready to accept a new sequence.
+  // By default the lowest sequence slot across the batchers is used, so
   // that all batchers grow at the same rate and attempt to remain as
   // small as possible.
-  std::priority_queue<
-      BatcherSequenceSlot, std::vector<BatcherSequenceSlot>,
-      BatcherSequenceSlotCompare>
-      ready_batcher_seq_slots_;
-
-  // For each correlation ID the most recently seen timestamp, in
-  // microseconds, for a request using that correlation ID.
-  std::unordered_map<InferenceRequest::SequenceId, uint64_t>
-      correlation_id_timestamps_;
+  using ReadySequenceSlots = std::priority_queue<
+      uint32_t, std::vector<uint32_t>, std::greater<uint32_t>>;
+  std::vector<ReadySequenceSlots> ready_seq_slots_;
+  size_t ready_seq_slot_cnt_;
+  size_t seq_slot_cnt_;
+
+  // With load aware placement a new sequence goes to the GPU with the
+  // fewest sequences, as they also hold its state memory, and then to the
+  // batcher of that GPU with the fewest sequences. A client can keep its
+  // sequences on the same batcher with an affinity request parameter, the
+  // batcher last used for each affinity is kept for the
+  // 'kMaxAffinityCount' most recent ones.
+  bool load_aware_placement_;
+  std::vector<int32_t> batcher_devices_;
+  std::unordered_map<int32_t, size_t> device_sequence_cnts_;
+  static constexpr size_t kMaxAffinityCount = 64 * 1024;
+  std::unordered_map<std::string, size_t> affinity_batchers_;
+  std::deque<std::string> affinity_order_;
+
+  // The sequence statistics of the model. They are updated where the
+  // sequence slots and the backlog change, without additional locking.
+  SequenceStatsTracker* sequence_stats_;
 
   // Used for debugging/testing.
   size_t backlog_delay_cnt_;
@@ -214,7 +315,7 @@ class SequenceBatch {
           continue_input_overrides,
       const std::shared_ptr<SequenceBatchScheduler::ControlInputs>&
           notready_input_overrides);
-  virtual ~SequenceBatch() = default;
+  virtual ~SequenceBatch();
 
   // Enqueue a request into the appropriate queue for the requested
   // sequence slot. This function takes ownership of 'request' so on
@@ -224,6 +325,11 @@ class SequenceBatch {
       const InferenceRequest::SequenceId& correlation_id,
       std::unique_ptr<InferenceRequest>& request) = 0;
 
+  // Offload the implicit state of the sequence slots that have no
+  // pending or in-flight request and have been idle for at least
+  // 'idle_ns'.
+  virtual void OffloadIdleStates(const uint64_t idle_ns) = 0;
+
  protected:
   bool CreateCorrelationIDControl(const inference::ModelConfig& config);
   void SetControlTensors(
@@ -235,6 +341,24 @@ class SequenceBatch {
   void UpdateImplicitState(
       std::unique_ptr<InferenceRequest>& irequest, const int32_t seq_slot);
 
+  // Start offloading the implicit state of 'seq_slot' if it has been idle
+  // for at least 'idle_ns' at 'now_ns' and is not used by any request.
+  // Return true if the offload was started, 'FinishOffloads()' must then
+  // be called for the slot.
+  bool OffloadIdleState(
+      const uint32_t seq_slot, const uint64_t now_ns, const uint64_t idle_ns);
+
+  // Wait for the offloads of 'seq_slots' started while holding 'mu', the
+  // batcher lock, which must not be held by the caller.
+  void FinishOffloads(const std::vector<uint32_t>& seq_slots, std::mutex* mu);
+
+  // Start restoring the implicit state of 'seq_slot' for 'request' if it
+  // has been offloaded, so that the copy overlaps with the wait for the
+  // request to be scheduled.
+  void PrefetchState(
+      const uint32_t seq_slot,
+      const std::unique_ptr<InferenceRequest>& request);
+
   // The controlling scheduler.
   SequenceBatchScheduler* const base_;
 
@@ -268,12 +392,22 @@ class SequenceBatch {
   std::shared_ptr<SequenceBatchScheduler::ControlInputs>
       notready_input_overrides_;
 
-  // The correlation ID override. Empty if model does not specify the
+  // The correlation ID override of each sequence slot and the buffer
+  // holding their values. Empty if model does not specify the
   // CONTROL_SEQUENCE_CORRID control.
-  std::shared_ptr<InferenceRequest::Input> seq_slot_corrid_override_;
+  std::vector<std::shared_ptr<InferenceRequest::Input>>
+      seq_slot_corrid_overrides_;
+  std::shared_ptr<AllocatedMemory> corrid_block_;
 
   // For each sequence slot store the optional state i/o tensors.
   std::vector<std::shared_ptr<SequenceStates>> sequence_states_;
+
+  // For each sequence slot the last time, in nanoseconds, the state was
+  // given to a request.
+  std::vector<uint64_t> state_use_ns_;
+
+  // The stream used to offload and restore the states.
+  cudaStream_t state_stream_;
 };
 
 // Scheduler that implements the Direct sequence scheduling strategy
@@ -303,6 +437,8 @@ class DirectSequenceBatch : public SequenceBatch {
       const InferenceRequest::SequenceId& correlation_id,
       std::unique_ptr<InferenceRequest>& request) override;
 
+  void OffloadIdleStates(const uint64_t idle_ns) override;
+
  private:
   void BatcherThread(const int nice);
   void NewPayload();
@@ -345,6 +481,7 @@ class DirectSequenceBatch : public SequenceBatch {
   size_t max_batch_size_;
   float minimum_slot_utilization_;
   uint64_t pending_batch_delay_ns_;
+  std::unique_ptr<BatchFillPolicy> fill_policy_;
 };
 
 // Scheduler that implements the oldest-first sequence scheduling
@@ -374,6 +511,8 @@ class OldestSequenceBatch : public SequenceBatch {
       const InferenceRequest::SequenceId& correlation_id,
       std::unique_ptr<InferenceRequest>& request) override;
 
+  void OffloadIdleStates(const uint64_t idle_ns) override;
+
  private:
   void CompleteAndNext(const uint32_t seq_slot);
 
@@ -90,6 +90,43 @@ SequenceState::SetStringDataToZero()
   return Status::Success;
 }
 
+namespace {
+
+// Return the buffer of the state 'name' in 'states' if it can hold a state
+// of 'byte_size' bytes, nullptr otherwise. A buffer that must be
+// initialized is only reused if it is in system memory.
+std::shared_ptr<Memory>
+ReusableBuffer(
+    const std::map<std::string, std::unique_ptr<SequenceState>>& states,
+    const std::string& name, const size_t byte_size, const bool initialize)
+{
+  const auto itr = states.find(name);
+  if ((itr == states.end()) || (itr->second == nullptr) ||
+      (itr->second->Data()->TotalByteSize() != byte_size)) {
+    return nullptr;
+  }
+
+  size_t buffer_byte_size;
+  TRITONSERVER_MemoryType memory_type;
+  int64_t memory_type_id;
+  itr->second->Data()->BufferAt(
+      0, &buffer_byte_size, &memory_type, &memory_type_id);
+  if (initialize && (memory_type == TRITONSERVER_MEMORY_GPU)) {
+    return nullptr;
+  }
+  return itr->second->Data();
+}
+
+}  // namespace
+
+SequenceStates::~SequenceStates()
+{
+  Status status = WaitRestore();
+  if (!status.IsOk()) {
+    LOG_ERROR << status.Message();
+  }
+}
+
 Status
 SequenceStates::Initialize(
     const std::unordered_map<
@@ -98,8 +135,16 @@ SequenceStates::Initialize(
     const size_t max_batch_size,
     const std::unordered_map<std::string, InitialStateData>& initial_state)
 {
-  input_states_.clear();
-  output_states_.clear();
+  // The buffers of the previous sequence may still be the target of a
+  // pending restore.
+  RETURN_IF_ERROR(WaitRestore());
+
+  // Keep the buffers of the previous sequence so that the states of the
+  // same size reuse them instead of allocating new ones.
+  std::map<std::string, std::unique_ptr<SequenceState>> prev_input_states;
+  std::map<std::string, std::unique_ptr<SequenceState>> prev_output_states;
+  prev_input_states.swap(input_states_);
+  prev_output_states.swap(output_states_);
 
   for (auto& state : state_output_config_map) {
     auto& state_config = state.second;
@@ -118,16 +163,24 @@ SequenceStates::Initialize(
       }
     }
 
-    std::shared_ptr<AllocatedMemory> data;
+    std::shared_ptr<Memory> data;
     auto initial_state_it = initial_state.find(state_config.input_name());
     if (initial_state_it != initial_state.end()) {
-      data = std::make_shared<AllocatedMemory>(
+      data = ReusableBuffer(
+          prev_input_states, state_config.input_name(),
           initial_state_it->second.data_->TotalByteSize(),
-          TRITONSERVER_MEMORY_CPU, 0);
+          true /* initialize */);
+      if (data == nullptr) {
+        data = std::make_shared<AllocatedMemory>(
+            initial_state_it->second.data_->TotalByteSize(),
+            TRITONSERVER_MEMORY_CPU, 0);
+      }
 
       TRITONSERVER_MemoryType memory_type;
       int64_t memory_type_id;
-      char* dst_buffer = data->MutableBuffer(&memory_type, &memory_type_id);
+      char* dst_buffer =
+          reinterpret_cast<const std::shared_ptr<MutableMemory>&>(data)
+              ->MutableBuffer(&memory_type, &memory_type_id);
       char* initial_state_buffer =
           initial_state_it->second.data_->MutableBuffer(
               &memory_type, &memory_type_id);
@@ -146,8 +199,13 @@ SequenceStates::Initialize(
         state_size =
             triton::common::GetByteSize(state.second.data_type(), dims);
       }
-      data = std::make_shared<AllocatedMemory>(
-          state_size, TRITONSERVER_MEMORY_CPU, 0);
+      data = ReusableBuffer(
+          prev_input_states, state_config.input_name(), state_size,
+          state.second.data_type() == inference::DataType::TYPE_STRING);
+      if (data == nullptr) {
+        data = std::make_shared<AllocatedMemory>(
+            state_size, TRITONSERVER_MEMORY_CPU, 0);
+      }
     }
 
     const auto& input_pair = input_states_.emplace(
@@ -184,6 +242,20 @@ SequenceStates::Initialize(
 
       continue;
     }
+
+    // Also keep the buffer that the output state was written to so that
+    // the two buffers of the state keep being swapped.
+    const auto prev_output_itr =
+        prev_output_states.find(state_config.output_name());
+    if ((prev_output_itr != prev_output_states.end()) &&
+        (prev_output_itr->second != nullptr)) {
+      const auto& prev_output_state = prev_output_itr->second;
+      output_pair.first->second.reset(new SequenceState(
+          prev_output_state->Name(), prev_output_state->DType(),
+          prev_output_state->Shape()));
+      RETURN_IF_ERROR(
+          output_pair.first->second->SetData(prev_output_state->Data()));
+    }
   }
 
   return Status::Success;
@@ -232,36 +304,15 @@ SequenceStates::OutputState(
   }
 
   output_state_r->SetStateUpdateCallback([&output_state_r, &input_state_r]() {
-    // Swap the internal memory if the size of the input and output state is
-    // equal
-
-    if (output_state_r->Data()->TotalByteSize() ==
-        input_state_r->Data()->TotalByteSize()) {
-      std::shared_ptr<Memory> temp_memory = input_state_r->Data();
-      RETURN_IF_ERROR(input_state_r->RemoveAllData());
-      RETURN_IF_ERROR(input_state_r->SetData(output_state_r->Data()));
-      RETURN_IF_ERROR(output_state_r->RemoveAllData());
-      RETURN_IF_ERROR(output_state_r->SetData(temp_memory));
-    } else {
-      // If the size of output state is different from the input state, allocate
-      // a new memory for the input state with the same size as output state.
-      TRITONSERVER_MemoryType memory_type;
-      int64_t memory_type_id;
-
-      const std::shared_ptr<MutableMemory>& input_memory =
-          reinterpret_cast<const std::shared_ptr<MutableMemory>&>(
-              input_state_r->Data());
-
-      input_memory->MutableBuffer(&memory_type, &memory_type_id);
-      std::shared_ptr<AllocatedMemory> memory =
-          std::make_shared<AllocatedMemory>(
-              output_state_r->Data()->TotalByteSize(), memory_type,
-              memory_type_id);
-      RETURN_IF_ERROR(input_state_r->RemoveAllData());
-      RETURN_IF_ERROR(input_state_r->SetData(output_state_r->Data()));
-      RETURN_IF_ERROR(output_state_r->RemoveAllData());
-      RETURN_IF_ERROR(output_state_r->SetData(memory));
-    }
+    // Swap the buffers of the input and output state so that the next
+    // update writes into the buffer that was just read. If the sizes
+    // differ TRITONBACKEND_StateBuffer replaces the buffer the next output
+    // state gets.
+    std::shared_ptr<Memory> temp_memory = input_state_r->Data();
+    RETURN_IF_ERROR(input_state_r->RemoveAllData());
+    RETURN_IF_ERROR(input_state_r->SetData(output_state_r->Data()));
+    RETURN_IF_ERROR(output_state_r->RemoveAllData());
+    RETURN_IF_ERROR(output_state_r->SetData(temp_memory));
 
     // Update the shape and data type of the output state if it doesn't match
     // the input state.
@@ -287,6 +338,166 @@ SequenceStates::OutputState(
   return OutputState(name, datatype, shape.data(), shape.size(), output_state);
 }
 
+Status
+SequenceStates::Offload(cudaStream_t stream)
+{
+  for (auto& input_state : input_states_) {
+    auto& state = input_state.second;
+    const size_t byte_size = state->Data()->TotalByteSize();
+    if (byte_size == 0) {
+      continue;
+    }
+
+    TRITONSERVER_MemoryType src_memory_type;
+    int64_t src_memory_type_id;
+    size_t src_byte_size;
+    const char* src = state->Data()->BufferAt(
+        0, &src_byte_size, &src_memory_type, &src_memory_type_id);
+    if (src_memory_type != TRITONSERVER_MEMORY_GPU) {
+      continue;
+    }
+
+    TRITONSERVER_MemoryType dst_memory_type;
+    int64_t dst_memory_type_id;
+    std::shared_ptr<AllocatedMemory> dst_memory =
+        std::make_shared<AllocatedMemory>(
+            byte_size, TRITONSERVER_MEMORY_CPU_PINNED, 0);
+    char* dst =
+        dst_memory->MutableBuffer(&dst_memory_type, &dst_memory_type_id);
+    if (dst == nullptr) {
+      return Status(
+          Status::Code::INTERNAL,
+          "failed to allocate system memory to offload state '" +
+              input_state.first + "'");
+    }
+
+    bool cuda_used = false;
+    RETURN_IF_ERROR(CopyBuffer(
+        "sequence state offload", src_memory_type, src_memory_type_id,
+        dst_memory_type, dst_memory_type_id, byte_size, src, dst, stream,
+        &cuda_used));
+    if (cuda_used) {
+      offloading_states_.push_back(state->Data());
+      offload_stream_ = stream;
+    }
+
+    RETURN_IF_ERROR(state->RemoveAllData());
+    RETURN_IF_ERROR(state->SetData(dst_memory));
+    offloaded_devices_[input_state.first] = src_memory_type_id;
+  }
+
+  // The output states are only buffers for the next update of the input
+  // states, so they are released and will be allocated again when needed.
+  for (auto& output_state : output_states_) {
+    if (output_state.second == nullptr) {
+      continue;
+    }
+    TRITONSERVER_MemoryType memory_type;
+    int64_t memory_type_id;
+    size_t byte_size;
+    output_state.second->Data()->BufferAt(
+        0, &byte_size, &memory_type, &memory_type_id);
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      output_state.second.reset();
+    }
+  }
+
+  return Status::Success;
+}
+
+Status
+SequenceStates::WaitOffload()
+{
+  if (offloading_states_.empty()) {
+    return Status::Success;
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  RETURN_IF_CUDA_ERR(
+      cudaStreamSynchronize(offload_stream_),
+      std::string("failed to offload sequence states"));
+#endif  // TRITON_ENABLE_GPU
+  offloading_states_.clear();
+
+  return Status::Success;
+}
+
+Status
+SequenceStates::Restore(cudaStream_t stream)
+{
+  // The copies back to the GPU are ordered after the pending offload
+  // copies on the same stream, which then complete with the restore.
+  if (offload_stream_ != stream) {
+    RETURN_IF_ERROR(WaitOffload());
+  }
+  for (auto itr = offloaded_devices_.begin();
+       itr != offloaded_devices_.end();) {
+    auto& state = input_states_[itr->first];
+    const size_t byte_size = state->Data()->TotalByteSize();
+
+    TRITONSERVER_MemoryType dst_memory_type;
+    int64_t dst_memory_type_id;
+    std::shared_ptr<AllocatedMemory> dst_memory =
+        std::make_shared<AllocatedMemory>(
+            byte_size, TRITONSERVER_MEMORY_GPU, itr->second);
+    char* dst =
+        dst_memory->MutableBuffer(&dst_memory_type, &dst_memory_type_id);
+    if ((dst == nullptr) || (dst_memory_type != TRITONSERVER_MEMORY_GPU)) {
+      LOG_VERBOSE(1) << "unable to allocate GPU memory to restore state '"
+                     << itr->first << "', keeping it in system memory";
+      itr = offloaded_devices_.erase(itr);
+      continue;
+    }
+
+    TRITONSERVER_MemoryType src_memory_type;
+    int64_t src_memory_type_id;
+    size_t src_byte_size;
+    const char* src = state->Data()->BufferAt(
+        0, &src_byte_size, &src_memory_type, &src_memory_type_id);
+
+    bool cuda_used = false;
+    RETURN_IF_ERROR(CopyBuffer(
+        "sequence state restore", src_memory_type, src_memory_type_id,
+        dst_memory_type, dst_memory_type_id, byte_size, src, dst, stream,
+        &cuda_used));
+    if (cuda_used) {
+      restoring_states_.push_back(state->Data());
+      restore_stream_ = stream;
+    }
+
+    RETURN_IF_ERROR(state->RemoveAllData());
+    RETURN_IF_ERROR(state->SetData(dst_memory));
+    itr = offloaded_devices_.erase(itr);
+  }
+  if (!offloading_states_.empty()) {
+    restoring_states_.insert(
+        restoring_states_.end(), offloading_states_.begin(),
+        offloading_states_.end());
+    offloading_states_.clear();
+    restore_stream_ = stream;
+  }
+
+  return Status::Success;
+}
+
+Status
+SequenceStates::WaitRestore()
+{
+  RETURN_IF_ERROR(WaitOffload());
+  if (restoring_states_.empty()) {
+    return Status::Success;
+  }
+
+#ifdef TRITON_ENABLE_GPU
+  RETURN_IF_CUDA_ERR(
+      cudaStreamSynchronize(restore_stream_),
+      std::string("failed to restore sequence states"));
+#endif  // TRITON_ENABLE_GPU
+  restoring_states_.clear();
+
+  return Status::Success;
+}
+
 std::shared_ptr<SequenceStates>
 SequenceStates::CopyAsNull(const std::shared_ptr<SequenceStates>& from)
 {
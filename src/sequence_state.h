@@ -27,6 +27,8 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <vector>
+#include "cuda_utils.h"
 #include "memory.h"
 #include "status.h"
 #include "triton/common/model_config.h"
@@ -112,6 +114,10 @@ class SequenceStates {
     std::shared_ptr<MutableMemory> data_;
   };
 
+  // Wait for the pending offload and restore copies, whose buffers are
+  // owned by the states.
+  ~SequenceStates();
+
   // Initialize the state tensors according to the state model configuration.
   // Will use a default value of 1 for the variable dimensions in the state
   // tensor configuration.
@@ -158,11 +164,54 @@ class SequenceStates {
 
   bool IsNullRequest() { return is_null_request_; }
 
+  // Move the input states held in GPU memory to pinned system memory and
+  // release the output states held in GPU memory, so that the states of
+  // an idle sequence don't occupy GPU memory. The GPU of each moved input
+  // state is remembered so that 'Restore()' can move it back. The copies
+  // are issued on 'stream' and the GPU memory of the input states is
+  // released by 'WaitOffload()'. Must only be called when no request is
+  // using the states.
+  Status Offload(cudaStream_t stream);
+
+  // Wait for the copies issued by 'Offload()' to complete and release the
+  // GPU memory they copied from.
+  Status WaitOffload();
+
+  // Start copying the offloaded input states back to the GPU they were
+  // offloaded from. The copies are issued on 'stream' and 'WaitRestore()'
+  // must be called before the states are used. An input state stays in
+  // system memory, which is still a valid location for it, if its GPU
+  // memory can't be allocated.
+  Status Restore(cudaStream_t stream);
+
+  // Wait for the copies issued by 'Restore()', and by an 'Offload()' not
+  // yet waited for, to complete.
+  Status WaitRestore();
+
+  // Return true if the states have been offloaded and not yet restored.
+  bool IsOffloaded() const
+  {
+    return !offloaded_devices_.empty() || !restoring_states_.empty();
+  }
+
  private:
   std::map<std::string, std::unique_ptr<SequenceState>> input_states_;
   std::map<std::string, std::unique_ptr<SequenceState>> output_states_;
   std::shared_ptr<SequenceStates> null_sequence_states_;
   bool is_null_request_ = false;
+
+  // The GPU each offloaded input state was held in, keyed by state name.
+  std::map<std::string, int64_t> offloaded_devices_;
+
+  // The system memory copies of the input states being restored, kept
+  // until the copies to the GPU complete.
+  std::vector<std::shared_ptr<Memory>> restoring_states_;
+  cudaStream_t restore_stream_ = nullptr;
+
+  // The GPU memory of the input states being offloaded, kept until the
+  // copies to system memory complete.
+  std::vector<std::shared_ptr<Memory>> offloading_states_;
+  cudaStream_t offload_stream_ = nullptr;
 };
 
 }}  // namespace triton::core
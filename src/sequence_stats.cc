@@ -0,0 +1,158 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "sequence_stats.h"
+
+#ifdef TRITON_ENABLE_METRICS
+#include "metric_model_reporter.h"
+#endif  // TRITON_ENABLE_METRICS
+
+namespace triton { namespace core {
+
+void
+SequenceStatsTracker::SetMetricReporter(
+    const std::shared_ptr<MetricModelReporter>& reporter)
+{
+  reporter_ = reporter;
+}
+
+void
+SequenceStatsTracker::SetBatcherCount(const size_t batcher_cnt)
+{
+  batcher_cnt_ = batcher_cnt;
+  slots_occupied_.reset(new std::atomic<uint64_t>[batcher_cnt]);
+  for (size_t b = 0; b < batcher_cnt; ++b) {
+    slots_occupied_[b].store(0);
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->CreateSequenceSlotMetrics(batcher_cnt);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceSlotAssigned(
+    const size_t batcher_idx, const uint64_t wait_ns)
+{
+  active_count_.fetch_add(1, std::memory_order_relaxed);
+  slot_count_.fetch_add(1, std::memory_order_relaxed);
+  slot_wait_duration_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+  if (batcher_idx < batcher_cnt_) {
+    slots_occupied_[batcher_idx].fetch_add(1, std::memory_order_relaxed);
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceSlotAssigned(batcher_idx, wait_ns);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceSlotReleased(const size_t batcher_idx)
+{
+  active_count_.fetch_sub(1, std::memory_order_relaxed);
+  if (batcher_idx < batcher_cnt_) {
+    slots_occupied_[batcher_idx].fetch_sub(1, std::memory_order_relaxed);
+  }
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceSlotReleased(batcher_idx);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceBacklogged()
+{
+  backlog_count_.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceBacklog(true /* added */);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceUnbacklogged()
+{
+  backlog_count_.fetch_sub(1, std::memory_order_relaxed);
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceBacklog(false /* added */);
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceEvicted()
+{
+  evicted_count_.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceEvicted();
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+void
+SequenceStatsTracker::SequenceRejected()
+{
+  rejected_count_.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef TRITON_ENABLE_METRICS
+  if (reporter_ != nullptr) {
+    reporter_->ReportSequenceRejected();
+  }
+#endif  // TRITON_ENABLE_METRICS
+}
+
+SequenceStatsTracker::Stats
+SequenceStatsTracker::GetStats() const
+{
+  Stats stats;
+  stats.active_count_ = active_count_.load(std::memory_order_relaxed);
+  stats.backlog_count_ = backlog_count_.load(std::memory_order_relaxed);
+  stats.slot_count_ = slot_count_.load(std::memory_order_relaxed);
+  stats.slot_wait_duration_ns_ =
+      slot_wait_duration_ns_.load(std::memory_order_relaxed);
+  stats.evicted_count_ = evicted_count_.load(std::memory_order_relaxed);
+  stats.rejected_count_ = rejected_count_.load(std::memory_order_relaxed);
+  stats.slots_occupied_.reserve(batcher_cnt_);
+  for (size_t b = 0; b < batcher_cnt_; ++b) {
+    stats.slots_occupied_.push_back(
+        slots_occupied_[b].load(std::memory_order_relaxed));
+  }
+  return stats;
+}
+
+}}  // namespace triton::core
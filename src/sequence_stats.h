@@ -0,0 +1,109 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace triton { namespace core {
+
+class MetricModelReporter;
+
+//
+// Sequence statistics of a model, maintained by the sequence batch
+// scheduler. The statistics are held in atomics so that they can be
+// updated without a lock and read while the scheduler is running.
+//
+class SequenceStatsTracker {
+ public:
+  struct Stats {
+    Stats()
+        : active_count_(0), backlog_count_(0), slot_count_(0),
+          slot_wait_duration_ns_(0), evicted_count_(0), rejected_count_(0)
+    {
+    }
+    // The number of sequences currently holding a sequence slot.
+    uint64_t active_count_;
+    // The number of sequences currently waiting in the backlog.
+    uint64_t backlog_count_;
+    // The number of sequences that have been assigned a sequence slot,
+    // and the total time they waited for it from their first request.
+    uint64_t slot_count_;
+    uint64_t slot_wait_duration_ns_;
+    // The number of sequences force-ended by the idle sequence reaper.
+    uint64_t evicted_count_;
+    // The number of sequences rejected because the backlog was full.
+    uint64_t rejected_count_;
+    // The number of occupied sequence slots of each batcher.
+    std::vector<uint64_t> slots_occupied_;
+  };
+
+  SequenceStatsTracker() : batcher_cnt_(0) {}
+
+  // Set the reporter to publish the statistics to, if metrics are
+  // enabled. Must be called before SetBatcherCount().
+  void SetMetricReporter(const std::shared_ptr<MetricModelReporter>& reporter);
+
+  // Set the number of batchers whose sequence slots are tracked. Must
+  // be called before the statistics are updated.
+  void SetBatcherCount(const size_t batcher_cnt);
+
+  // Record that a sequence is assigned a slot of 'batcher_idx' after
+  // waiting 'wait_ns' since its first request.
+  void SequenceSlotAssigned(const size_t batcher_idx, const uint64_t wait_ns);
+
+  // Record that a sequence released its slot of 'batcher_idx'.
+  void SequenceSlotReleased(const size_t batcher_idx);
+
+  // Record that a sequence was added to or removed from the backlog.
+  void SequenceBacklogged();
+  void SequenceUnbacklogged();
+
+  // Record that a sequence was force-ended by the reaper.
+  void SequenceEvicted();
+
+  // Record that a new sequence was rejected.
+  void SequenceRejected();
+
+  // Return a snapshot of the statistics. The snapshot is not atomic as
+  // a whole, each statistic is read independently.
+  Stats GetStats() const;
+
+ private:
+  std::atomic<uint64_t> active_count_{0};
+  std::atomic<uint64_t> backlog_count_{0};
+  std::atomic<uint64_t> slot_count_{0};
+  std::atomic<uint64_t> slot_wait_duration_ns_{0};
+  std::atomic<uint64_t> evicted_count_{0};
+  std::atomic<uint64_t> rejected_count_{0};
+  size_t batcher_cnt_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_occupied_;
+  std::shared_ptr<MetricModelReporter> reporter_;
+};
+
+}}  // namespace triton::core
@@ -29,15 +29,19 @@
 #include <stdint.h>
 #include <time.h>
 #include <algorithm>
+#include <chrono>
 #include <csignal>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "backend_manager.h"
+#include "backend_model.h"
 #include "constants.h"
 #include "cuda_utils.h"
+#include "host_memory.h"
 #include "model.h"
 #include "model_config.pb.h"
 #include "model_config_utils.h"
@@ -72,6 +76,12 @@ class ScopedAtomicIncrement {
   std::atomic<uint64_t>& counter_;
 };
 
+// Bounds of the interval between two drain checks in Stop() when no
+// progress is signalled, as the requests already in flight when the
+// server starts exiting don't signal their completion.
+constexpr std::chrono::milliseconds kMinDrainCheckInterval(1);
+constexpr std::chrono::milliseconds kMaxDrainCheckInterval(100);
+
 }  // namespace
 
 //
@@ -100,7 +110,20 @@ InferenceServer::InferenceServer()
   strict_model_config_ = true;
   strict_readiness_ = true;
   exit_timeout_secs_ = 30;
+  model_load_on_demand_ = false;
+  model_idle_unload_timeout_secs_ = 0;
+  model_gpu_memory_budget_ = 0;
+  traffic_capture_max_byte_size_ = 0;
+  cuda_memory_pool_stream_ordered_ = false;
   pinned_memory_pool_size_ = 1 << 28;
+  pinned_memory_pool_max_size_ = 0;
+  host_huge_page_threshold_ = 0;
+  response_cache_shard_count_ = 1;
+  response_cache_collision_safe_ = false;
+  response_cache_eviction_policy_ = CacheEvictionPolicy::Kind::LRU;
+  response_cache_memory_type_ = TRITONSERVER_MEMORY_CPU;
+  response_cache_memory_type_id_ = 0;
+  response_cache_remote_timeout_us_ = 2000;
   buffer_manager_thread_count_ = 0;
   model_load_thread_count_ =
       std::max(2u, 2 * std::thread::hardware_concurrency());
@@ -112,6 +135,7 @@ InferenceServer::InferenceServer()
 #endif  // TRITON_ENABLE_GPU
 
   inflight_request_counter_ = 0;
+  drain_generation_ = 0;
 }
 
 Status
@@ -157,17 +181,23 @@ InferenceServer::Init()
   std::unique_ptr<RateLimiter> local_rate_limiter;
   bool ignore_resources_and_priority =
       (rate_limit_mode_ == RateLimitMode::RL_OFF);
+  bool earliest_deadline_first =
+      (rate_limit_mode_ == RateLimitMode::RL_DEADLINE);
 
   status = RateLimiter::Create(
-      ignore_resources_and_priority, rate_limit_resource_map_,
-      &local_rate_limiter);
+      ignore_resources_and_priority, earliest_deadline_first,
+      rate_limit_resource_map_, &local_rate_limiter);
   rate_limiter_ = std::move(local_rate_limiter);
   if (!status.IsOk()) {
     ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
     return status;
   }
 
-  PinnedMemoryManager::Options options(pinned_memory_pool_size_);
+  SetHugePageThreshold(host_huge_page_threshold_);
+
+  PinnedMemoryManager::Options options(
+      pinned_memory_pool_size_, {} /* host_policy_map */,
+      pinned_memory_pool_max_size_);
   status = PinnedMemoryManager::Create(options);
   if (!status.IsOk()) {
     ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
@@ -176,8 +206,14 @@ InferenceServer::Init()
 
   if (response_cache_byte_size_ > 0) {
     std::unique_ptr<RequestResponseCache> local_response_cache;
-    status = RequestResponseCache::Create(
-        response_cache_byte_size_, &local_response_cache);
+    RequestResponseCache::Options cache_options(
+        response_cache_byte_size_, response_cache_shard_count_,
+        response_cache_collision_safe_, response_cache_eviction_policy_,
+        response_cache_memory_type_, response_cache_memory_type_id_);
+    cache_options.remote_tier_ = response_cache_remote_tier_;
+    cache_options.remote_lookup_timeout_us_ = response_cache_remote_timeout_us_;
+    cache_options.snapshot_path_ = response_cache_snapshot_path_;
+    status = RequestResponseCache::Create(cache_options, &local_response_cache);
     if (!status.IsOk()) {
       ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
       return status;
@@ -186,6 +222,15 @@ InferenceServer::Init()
     response_cache_ = std::move(local_response_cache);
   }
 
+  if (!traffic_capture_path_.empty()) {
+    status = TrafficCapture::Create(
+        traffic_capture_path_, traffic_capture_max_byte_size_,
+        &traffic_capture_);
+    if (!status.IsOk()) {
+      ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+      return status;
+    }
+  }
 
 #ifdef TRITON_ENABLE_GPU
   // Set the default CUDA memory pool size for GPUs where it is not
@@ -201,7 +246,8 @@ InferenceServer::Init()
   }
 
   CudaMemoryManager::Options cuda_options(
-      min_supported_compute_capability_, cuda_memory_pool_size_);
+      min_supported_compute_capability_, cuda_memory_pool_size_,
+      cuda_memory_pool_stream_ordered_);
   status = CudaMemoryManager::Create(cuda_options);
   // If CUDA memory manager can't be created, just log error as the
   // server can still function properly
@@ -221,6 +267,30 @@ InferenceServer::Init()
   bool polling_enabled = (model_control_mode_ == ModelControlMode::MODE_POLL);
   bool model_control_enabled =
       (model_control_mode_ == ModelControlMode::MODE_EXPLICIT);
+  if (model_load_on_demand_ && !model_control_enabled) {
+    ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
+    return Status(
+        Status::Code::INVALID_ARG,
+        "loading models on demand requires explicit model control mode");
+  }
+  // The backends are preloaded while the model repository is polled and
+  // the startup models are loaded, the loads that need a backend being
+  // preloaded wait for it.
+  std::vector<std::future<void>> backend_preloads;
+  for (const auto& backend_name : preload_backends_) {
+    backend_preloads.emplace_back(
+        std::async(std::launch::async, [this, backend_name] {
+          Status status = TritonModel::PreloadBackend(
+              this, backend_cmdline_config_map_, backend_name);
+          if (status.IsOk()) {
+            LOG_INFO << "preloaded backend '" << backend_name << "'";
+          } else {
+            LOG_WARNING << "failed to preload backend '" << backend_name
+                        << "': " << status.Message();
+          }
+        }));
+  }
+
   const ModelLifeCycleOptions life_cycle_options(
       min_supported_compute_capability_, backend_cmdline_config_map_,
       host_policy_map_, model_load_thread_count_);
@@ -228,6 +298,14 @@ InferenceServer::Init()
       this, version_, model_repository_paths_, startup_models_,
       strict_model_config_, polling_enabled, model_control_enabled,
       life_cycle_options, &model_repository_manager_);
+  for (auto& preload : backend_preloads) {
+    preload.wait();
+  }
+  if (model_load_on_demand_ && (model_repository_manager_ != nullptr)) {
+    model_repository_manager_->EnableOnDemandLoad(
+        model_idle_unload_timeout_secs_ * NANOS_PER_SECOND,
+        model_gpu_memory_budget_);
+  }
   if (!status.IsOk()) {
     if (model_repository_manager_ == nullptr) {
       ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
@@ -268,20 +346,43 @@ InferenceServer::Stop(const bool force)
   }
 
   // Wait for all in-flight non-inference requests to complete and all
-  // loaded models to unload, or for the exit timeout to expire.
-  uint32_t exit_timeout_iters = exit_timeout_secs_;
+  // loaded models to unload, or for the exit timeout to expire. The
+  // state is checked again whenever progress is signalled, the
+  // progress is logged at most once per second.
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(exit_timeout_secs_);
+  auto next_log = std::chrono::steady_clock::now();
+  auto check_interval = kMinDrainCheckInterval;
   bool unloading_model = false;
   while (true) {
+    uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lock(drain_mu_);
+      generation = drain_generation_;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const bool log_progress = (now >= next_log);
+    if (log_progress) {
+      next_log = now + std::chrono::seconds(1);
+    }
+    const auto exit_timeout_secs =
+        (now < deadline)
+            ? std::chrono::duration_cast<std::chrono::seconds>(deadline - now)
+                  .count()
+            : 0;
+
     if (!unloading_model) {
       // Check if all in-flight inference requests / sequences are completed
       const auto& inflight_status = model_repository_manager_->InflightStatus();
-      LOG_INFO << "Timeout " << exit_timeout_iters << ": Found "
-               << inflight_status.size()
-               << " model versions that have in-flight inferences";
-      for (const auto& inflight : inflight_status) {
-        LOG_INFO << "Model '" << std::get<0>(inflight) << "' "
-                 << "(version " << std::get<1>(inflight) << ") has "
-                 << std::get<2>(inflight) << " in-flight inferences";
+      if (log_progress) {
+        LOG_INFO << "Timeout " << exit_timeout_secs << ": Found "
+                 << inflight_status.size()
+                 << " model versions that have in-flight inferences";
+        for (const auto& inflight : inflight_status) {
+          LOG_INFO << "Model '" << std::get<0>(inflight) << "' "
+                   << "(version " << std::get<1>(inflight) << ") has "
+                   << std::get<2>(inflight) << " in-flight inferences";
+        }
       }
 
       if (inflight_status.size() == 0) {
@@ -297,11 +398,13 @@ InferenceServer::Stop(const bool force)
     } else {
       const auto& live_models = model_repository_manager_->LiveModelStates();
 
-      LOG_INFO << "Timeout " << exit_timeout_iters << ": Found "
-               << live_models.size() << " live models and "
-               << inflight_request_counter_
-               << " in-flight non-inference requests";
-      if (LOG_VERBOSE_IS_ON(1)) {
+      if (log_progress) {
+        LOG_INFO << "Timeout " << exit_timeout_secs << ": Found "
+                 << live_models.size() << " live models and "
+                 << inflight_request_counter_
+                 << " in-flight non-inference requests";
+      }
+      if (log_progress && LOG_VERBOSE_IS_ON(1)) {
         for (const auto& m : live_models) {
           for (const auto& v : m.second) {
             LOG_VERBOSE(1) << m.first << " v" << v.first << ": "
@@ -314,18 +417,38 @@ InferenceServer::Stop(const bool force)
         return Status::Success;
       }
     }
-    if (exit_timeout_iters <= 0) {
+    if (now >= deadline) {
       break;
     }
 
-    exit_timeout_iters--;
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    // Back off while nothing signals progress
+    std::unique_lock<std::mutex> lock(drain_mu_);
+    const bool signalled = drain_cv_.wait_for(
+        lock, std::min<std::chrono::steady_clock::duration>(
+                  check_interval, deadline - now),
+        [this, generation] { return drain_generation_ != generation; });
+    check_interval =
+        signalled ? kMinDrainCheckInterval
+                  : std::min(check_interval * 2, kMaxDrainCheckInterval);
   }
 
   return Status(
       Status::Code::INTERNAL, "Exit timeout expired. Exiting immediately.");
 }
 
+void
+InferenceServer::NotifyDrainProgress()
+{
+  if (ready_state_ != ServerReadyState::SERVER_EXITING) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(drain_mu_);
+    drain_generation_++;
+  }
+  drain_cv_.notify_all();
+}
+
 Status
 InferenceServer::PollModelRepository()
 {
@@ -489,6 +612,18 @@ InferenceServer::RepositoryIndex(
 
 Status
 InferenceServer::InferAsync(std::unique_ptr<InferenceRequest>& request)
+{
+  RETURN_IF_ERROR(AdmitRequest(request));
+
+  if (traffic_capture_ != nullptr) {
+    traffic_capture_->Record(*request);
+  }
+
+  return InferenceRequest::Run(request);
+}
+
+Status
+InferenceServer::AdmitRequest(std::unique_ptr<InferenceRequest>& request)
 {
   // Allow inference request while server exiting to provide graceful
   // completion of inference sequence that spans multiple requests.
@@ -504,7 +639,15 @@ InferenceServer::InferAsync(std::unique_ptr<InferenceRequest>& request)
       request->RequestStartNs());
 #endif  // TRITON_ENABLE_STATS
 
-  return InferenceRequest::Run(request);
+  // The requests admitted while exiting continue in-flight sequences,
+  // signal their completion so Stop() can finish as soon as the last
+  // one is done.
+  if (ready_state_ == ServerReadyState::SERVER_EXITING) {
+    RETURN_IF_ERROR(request->AddInternalReleaseCallback(
+        [this]() { NotifyDrainProgress(); }));
+  }
+
+  return Status::Success;
 }
 
 Status
@@ -28,7 +28,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <atomic>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -40,6 +42,7 @@
 #include "rate_limiter.h"
 #include "response_cache.h"
 #include "status.h"
+#include "traffic_capture.h"
 #include "triton/common/model_config.h"
 
 namespace triton { namespace core {
@@ -49,7 +52,7 @@ class InferenceRequest;
 
 enum class ModelControlMode { MODE_NONE, MODE_POLL, MODE_EXPLICIT };
 
-enum class RateLimitMode { RL_EXEC_COUNT, RL_OFF };
+enum class RateLimitMode { RL_EXEC_COUNT, RL_OFF, RL_DEADLINE };
 
 // Readiness status for the inference server.
 enum class ServerReadyState {
@@ -84,6 +87,10 @@ class InferenceServer {
   // server even if it is not in a ready state.
   Status Stop(const bool force = false);
 
+  // Wake up Stop() to check again whether the in-flight inferences
+  // and the live models are drained. No effect unless exiting.
+  void NotifyDrainProgress();
+
   // Check the model repository for changes and update server state
   // based on those changes.
   Status PollModelRepository();
@@ -118,6 +125,11 @@ class InferenceServer {
   // ownership of 'request'.
   Status InferAsync(std::unique_ptr<InferenceRequest>& request);
 
+  // Admit 'request' for inference without enqueuing it, for the requests
+  // that are enqueued to their model by the caller. Return an error if
+  // the server doesn't accept inference requests.
+  Status AdmitRequest(std::unique_ptr<InferenceRequest>& request);
+
   // Load the corresponding model. Reload the model if it has been loaded.
   Status LoadModel(
       const std::unordered_map<
@@ -192,6 +204,21 @@ class InferenceServer {
     pinned_memory_pool_size_ = std::max((int64_t)0, s);
   }
 
+  // Get / set the byte size the pinned memory pool may grow to.
+  uint64_t PinnedMemoryPoolMaxByteSize() const
+  {
+    return pinned_memory_pool_max_size_;
+  }
+  void SetPinnedMemoryPoolMaxByteSize(uint64_t s)
+  {
+    pinned_memory_pool_max_size_ = s;
+  }
+
+  // Get / set the byte size from which host allocations are backed by huge
+  // pages, 0 if disabled.
+  uint64_t HostHugePageThreshold() const { return host_huge_page_threshold_; }
+  void SetHostHugePageThreshold(uint64_t s) { host_huge_page_threshold_ = s; }
+
   // Get / set the response cache byte size.
   uint64_t ResponseCacheByteSize() const { return response_cache_byte_size_; }
   void SetResponseCacheByteSize(uint64_t s)
@@ -202,6 +229,93 @@ class InferenceServer {
 
   bool ResponseCacheEnabled() const { return response_cache_enabled_; }
 
+  // Get / set the number of response cache shards.
+  uint32_t ResponseCacheShardCount() const
+  {
+    return response_cache_shard_count_;
+  }
+  void SetResponseCacheShardCount(uint32_t c)
+  {
+    response_cache_shard_count_ = std::max((uint32_t)1, c);
+  }
+
+  // Get / set whether response cache entries are verified with a
+  // secondary digest on lookup.
+  bool ResponseCacheCollisionSafe() const
+  {
+    return response_cache_collision_safe_;
+  }
+  void SetResponseCacheCollisionSafe(bool e)
+  {
+    response_cache_collision_safe_ = e;
+  }
+
+  // Get / set the response cache eviction policy.
+  CacheEvictionPolicy::Kind ResponseCacheEvictionPolicy() const
+  {
+    return response_cache_eviction_policy_;
+  }
+  void SetResponseCacheEvictionPolicy(CacheEvictionPolicy::Kind p)
+  {
+    response_cache_eviction_policy_ = p;
+  }
+
+  // Get / set the memory type and device that cached responses are
+  // stored in.
+  TRITONSERVER_MemoryType ResponseCacheMemoryType() const
+  {
+    return response_cache_memory_type_;
+  }
+  int64_t ResponseCacheMemoryTypeId() const
+  {
+    return response_cache_memory_type_id_;
+  }
+  void SetResponseCacheMemoryType(TRITONSERVER_MemoryType t, int64_t id)
+  {
+    response_cache_memory_type_ = t;
+    response_cache_memory_type_id_ = id;
+  }
+
+  // Get / set the file the response cache is restored from at startup and
+  // snapshotted to on shutdown, empty if no snapshot is taken.
+  const std::string& ResponseCacheSnapshotPath() const
+  {
+    return response_cache_snapshot_path_;
+  }
+  void SetResponseCacheSnapshotPath(const std::string& p)
+  {
+    response_cache_snapshot_path_ = p;
+  }
+
+  // Get / set the file the request traffic is captured to, empty if the
+  // traffic is not captured, and the byte size the capture stops at.
+  const std::string& TrafficCapturePath() const
+  {
+    return traffic_capture_path_;
+  }
+  void SetTrafficCapture(const std::string& p, uint64_t max_byte_size)
+  {
+    traffic_capture_path_ = p;
+    traffic_capture_max_byte_size_ = max_byte_size;
+  }
+
+  // Get / set the remote tier shared with the response caches of other
+  // servers and the deadline of its lookups, in microseconds.
+  const std::shared_ptr<CacheRemoteTier>& ResponseCacheRemoteTier() const
+  {
+    return response_cache_remote_tier_;
+  }
+  uint64_t ResponseCacheRemoteTimeoutUs() const
+  {
+    return response_cache_remote_timeout_us_;
+  }
+  void SetResponseCacheRemoteTier(
+      const std::shared_ptr<CacheRemoteTier>& tier, uint64_t timeout_us)
+  {
+    response_cache_remote_tier_ = tier;
+    response_cache_remote_timeout_us_ = timeout_us;
+  }
+
   // Get / set CUDA memory pool size
   const std::map<int, uint64_t>& CudaMemoryPoolByteSize() const
   {
@@ -213,6 +327,16 @@ class InferenceServer {
     cuda_memory_pool_size_ = s;
   }
 
+  // Get / set whether the CUDA memory pools are stream-ordered.
+  bool CudaMemoryPoolStreamOrdered() const
+  {
+    return cuda_memory_pool_stream_ordered_;
+  }
+  void SetCudaMemoryPoolStreamOrdered(bool s)
+  {
+    cuda_memory_pool_stream_ordered_ = s;
+  }
+
   // Get / set the minimum support CUDA compute capability.
   double MinSupportedComputeCapability() const
   {
@@ -231,6 +355,21 @@ class InferenceServer {
   int32_t ExitTimeoutSeconds() const { return exit_timeout_secs_; }
   void SetExitTimeoutSeconds(int32_t s) { exit_timeout_secs_ = std::max(0, s); }
 
+  // Get / set loading models on demand, with the idle timeout, in
+  // seconds, and the GPU memory budget of the models loaded on demand.
+  bool ModelLoadOnDemand() const { return model_load_on_demand_; }
+  uint32_t ModelIdleUnloadTimeoutSeconds() const
+  {
+    return model_idle_unload_timeout_secs_;
+  }
+  uint64_t ModelGpuMemoryBudget() const { return model_gpu_memory_budget_; }
+  void SetModelLoadOnDemand(bool e, uint32_t timeout_secs, uint64_t budget)
+  {
+    model_load_on_demand_ = e;
+    model_idle_unload_timeout_secs_ = timeout_secs;
+    model_gpu_memory_budget_ = budget;
+  }
+
   void SetBufferManagerThreadCount(unsigned int c)
   {
     buffer_manager_thread_count_ = c;
@@ -245,6 +384,16 @@ class InferenceServer {
     backend_cmdline_config_map_ = bc;
   }
 
+  // Get / set the backends loaded when the server starts.
+  const std::set<std::string>& PreloadBackends() const
+  {
+    return preload_backends_;
+  }
+  void SetPreloadBackends(const std::set<std::string>& b)
+  {
+    preload_backends_ = b;
+  }
+
   void SetHostPolicyCmdlineConfig(
       const triton::common::HostPolicyCmdlineConfigMap& hp)
   {
@@ -294,14 +443,31 @@ class InferenceServer {
   bool strict_model_config_;
   bool strict_readiness_;
   uint32_t exit_timeout_secs_;
+  bool model_load_on_demand_;
+  uint32_t model_idle_unload_timeout_secs_;
+  uint64_t model_gpu_memory_budget_;
   uint32_t buffer_manager_thread_count_;
   uint32_t model_load_thread_count_;
   uint64_t pinned_memory_pool_size_;
+  uint64_t pinned_memory_pool_max_size_;
+  uint64_t host_huge_page_threshold_;
   uint64_t response_cache_byte_size_;
   bool response_cache_enabled_;
+  uint32_t response_cache_shard_count_;
+  bool response_cache_collision_safe_;
+  CacheEvictionPolicy::Kind response_cache_eviction_policy_;
+  TRITONSERVER_MemoryType response_cache_memory_type_;
+  int64_t response_cache_memory_type_id_;
+  std::string response_cache_snapshot_path_;
+  std::string traffic_capture_path_;
+  uint64_t traffic_capture_max_byte_size_;
+  std::shared_ptr<CacheRemoteTier> response_cache_remote_tier_;
+  uint64_t response_cache_remote_timeout_us_;
   std::map<int, uint64_t> cuda_memory_pool_size_;
+  bool cuda_memory_pool_stream_ordered_;
   double min_supported_compute_capability_;
   triton::common::BackendCmdlineConfigMap backend_cmdline_config_map_;
+  std::set<std::string> preload_backends_;
   triton::common::HostPolicyCmdlineConfigMap host_policy_map_;
   std::string repoagent_dir_;
   RateLimitMode rate_limit_mode_;
@@ -317,10 +483,17 @@ class InferenceServer {
   // requests but that is determined by model shared_ptr).
   std::atomic<uint64_t> inflight_request_counter_;
 
+  // Signalled on drain progress while exiting, 'drain_generation_' is
+  // incremented on every signal so Stop() doesn't miss any.
+  std::mutex drain_mu_;
+  std::condition_variable drain_cv_;
+  uint64_t drain_generation_;
+
   std::shared_ptr<RateLimiter> rate_limiter_;
   std::unique_ptr<ModelRepositoryManager> model_repository_manager_;
   std::shared_ptr<TritonBackendManager> backend_manager_;
   std::shared_ptr<RequestResponseCache> response_cache_;
+  std::unique_ptr<TrafficCapture> traffic_capture_;
 };
 
 }}  // namespace triton::core
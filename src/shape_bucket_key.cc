@@ -0,0 +1,130 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shape_bucket_key.h"
+
+#include <algorithm>
+#include <vector>
+#include "hash_utils.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+// Copy the shape tensor buffer 'src' in GPU memory to 'dst' and wait for
+// the copy to complete.
+Status
+CopyShapeTensorToHost(
+    const char* src, const size_t byte_size, const int64_t memory_type_id,
+    std::vector<char>* dst, cudaStream_t cuda_stream)
+{
+  dst->resize(byte_size);
+  bool cuda_used = false;
+  RETURN_IF_ERROR(CopyBuffer(
+      "shape bucket key", TRITONSERVER_MEMORY_GPU, memory_type_id,
+      TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */, byte_size, src,
+      dst->data(), cuda_stream, &cuda_used));
+#ifdef TRITON_ENABLE_GPU
+  if (cuda_used) {
+    RETURN_IF_CUDA_ERR(
+        cudaStreamSynchronize(cuda_stream),
+        std::string("shape bucket key: failed to synchronize CUDA copy"));
+  }
+#endif  // TRITON_ENABLE_GPU
+
+  return Status::Success;
+}
+
+}  // namespace
+
+uint64_t
+ShapeBucketKey(
+    const InferenceRequest& request,
+    const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors,
+    const bool has_optional_input, cudaStream_t cuda_stream)
+{
+  // Visit the inputs by name so that the key doesn't depend on the order
+  // in which the inputs were added.
+  std::vector<const InferenceRequest::Input*> inputs;
+  inputs.reserve(request.ImmutableInputs().size());
+  for (const auto& pr : request.ImmutableInputs()) {
+    inputs.emplace_back(pr.input_);
+  }
+  std::sort(
+      inputs.begin(), inputs.end(),
+      [](const InferenceRequest::Input* lhs,
+         const InferenceRequest::Input* rhs) {
+        return lhs->Name() < rhs->Name();
+      });
+
+  StreamingHash64 hash;
+  std::vector<char> host_buffer;
+  for (const auto input : inputs) {
+    const auto itr = enforce_equal_shape_tensors.find(input->Name());
+    if (itr == enforce_equal_shape_tensors.end()) {
+      // With optional inputs, only requests with the same inputs batch.
+      if (has_optional_input) {
+        hash.Update(input->Name());
+      }
+      continue;
+    }
+    hash.Update(input->Name());
+    const auto& shape = input->Shape();
+    hash.UpdateValue(shape.size());
+    hash.Update(shape.data(), shape.size() * sizeof(int64_t));
+
+    // The values of a shape tensor must match as well.
+    if (itr->second) {
+      const auto& data = input->Data();
+      for (size_t idx = 0; idx < data->BufferCount(); ++idx) {
+        size_t byte_size;
+        TRITONSERVER_MemoryType memory_type;
+        int64_t memory_type_id;
+        const char* buffer =
+            data->BufferAt(idx, &byte_size, &memory_type, &memory_type_id);
+        if (buffer == nullptr) {
+          continue;
+        }
+        if (memory_type == TRITONSERVER_MEMORY_GPU) {
+          Status status = CopyShapeTensorToHost(
+              buffer, byte_size, memory_type_id, &host_buffer, cuda_stream);
+          if (!status.IsOk()) {
+            LOG_VERBOSE(1) << "shape tensor '" << input->Name()
+                           << "' not bucketed: " << status.Message();
+            hash.UpdateValue(reinterpret_cast<uintptr_t>(&request));
+            break;
+          }
+          buffer = host_buffer.data();
+        }
+        hash.Update(buffer, byte_size);
+      }
+    }
+  }
+  return hash.Digest();
+}
+
+}}  // namespace triton::core
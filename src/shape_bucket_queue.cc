@@ -0,0 +1,151 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shape_bucket_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace triton { namespace core {
+
+void
+ShapeBucketIndex::Add(
+    const uint64_t key, const size_t batch_size, const uint64_t enqueue_ns)
+{
+  auto& bucket = buckets_[key];
+  bucket.batch_size_ += batch_size;
+  bucket.enqueue_ns_.insert(enqueue_ns);
+  ++size_;
+}
+
+void
+ShapeBucketIndex::Remove(
+    const uint64_t key, const size_t batch_size, const uint64_t enqueue_ns)
+{
+  auto it = buckets_.find(key);
+  if (it == buckets_.end()) {
+    return;
+  }
+  auto& bucket = it->second;
+  auto eit = bucket.enqueue_ns_.find(enqueue_ns);
+  if (eit == bucket.enqueue_ns_.end()) {
+    return;
+  }
+  bucket.enqueue_ns_.erase(eit);
+  bucket.batch_size_ -= std::min(bucket.batch_size_, batch_size);
+  --size_;
+  if (bucket.enqueue_ns_.empty()) {
+    buckets_.erase(it);
+  }
+}
+
+size_t
+ShapeBucketIndex::Count(const uint64_t key) const
+{
+  const auto it = buckets_.find(key);
+  return (it == buckets_.end()) ? 0 : it->second.enqueue_ns_.size();
+}
+
+uint64_t
+ShapeBucketIndex::NextReady(
+    const uint64_t now_ns, const size_t full_batch_size,
+    const uint64_t max_delay_ns, uint64_t* key) const
+{
+  uint64_t wait_ns = UINT64_MAX;
+  uint64_t first_ready_ns = UINT64_MAX;
+  for (const auto& pr : buckets_) {
+    const auto& bucket = pr.second;
+    const uint64_t enqueue_ns = *bucket.enqueue_ns_.begin();
+    const uint64_t age_ns = (now_ns > enqueue_ns) ? (now_ns - enqueue_ns) : 0;
+    if ((bucket.batch_size_ >= full_batch_size) || (age_ns >= max_delay_ns)) {
+      if (enqueue_ns <= first_ready_ns) {
+        first_ready_ns = enqueue_ns;
+        *key = pr.first;
+      }
+      wait_ns = 0;
+    } else if (wait_ns != 0) {
+      wait_ns = std::min(wait_ns, max_delay_ns - age_ns);
+    }
+  }
+  return wait_ns;
+}
+
+int64_t
+BucketDim(const int64_t dim, const uint64_t granularity)
+{
+  if ((dim <= 0) || (granularity == 0)) {
+    return dim;
+  }
+  const int64_t g = static_cast<int64_t>(granularity);
+  return ((dim + g - 1) / g) * g;
+}
+
+namespace {
+
+void
+PadDim(
+    const char* src, const std::vector<int64_t>& shape,
+    const std::vector<size_t>& src_strides,
+    const std::vector<size_t>& dst_strides, const size_t dim, char* dst)
+{
+  if (dim + 1 == shape.size()) {
+    memcpy(dst, src, src_strides[dim] * shape[dim]);
+    return;
+  }
+  for (int64_t idx = 0; idx < shape[dim]; ++idx) {
+    PadDim(
+        src + idx * src_strides[dim], shape, src_strides, dst_strides,
+        dim + 1, dst + idx * dst_strides[dim]);
+  }
+}
+
+}  // namespace
+
+void
+PadTensor(
+    const char* src, const std::vector<int64_t>& shape,
+    const std::vector<int64_t>& padded_shape, const size_t element_size,
+    char* dst)
+{
+  // The byte stride of each dimension, that is, the byte size of one
+  // element in that dimension.
+  std::vector<size_t> src_strides(shape.size() + 1, element_size);
+  std::vector<size_t> dst_strides(shape.size() + 1, element_size);
+  for (size_t dim = shape.size(); dim-- > 0;) {
+    src_strides[dim] = src_strides[dim + 1] * shape[dim];
+    dst_strides[dim] = dst_strides[dim + 1] * padded_shape[dim];
+  }
+  memset(dst, 0, dst_strides[0]);
+  if (shape.empty()) {
+    memcpy(dst, src, element_size);
+  } else if (src_strides[0] != 0) {
+    src_strides.erase(src_strides.begin());
+    dst_strides.erase(dst_strides.begin());
+    PadDim(src, shape, src_strides, dst_strides, 0, dst);
+  }
+}
+
+}}  // namespace triton::core
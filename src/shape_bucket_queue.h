@@ -0,0 +1,100 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// Index of the requests queued by a dynamic batcher, bucketed by the
+// hash of their shape so that requests of different shapes are batched
+// separately instead of closing the batch whenever the shape changes.
+// The requests themselves stay in the scheduler queue, the index only
+// keeps the count, the total batch size and the enqueue times of each
+// bucket up to date as requests are added and removed. A bucket is
+// ready once its batch size reaches the full batch size or once its
+// oldest request has waited for the maximum delay. Between the ready
+// buckets, the one with the oldest request is dispatched first, so the
+// buckets follow the order the requests are enqueued in.
+//
+// The index is not thread-safe.
+//
+class ShapeBucketIndex {
+ public:
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+  size_t BucketCount() const { return buckets_.size(); }
+
+  // Add a request of 'batch_size' enqueued at 'enqueue_ns' to the bucket
+  // of 'key'.
+  void Add(
+      const uint64_t key, const size_t batch_size, const uint64_t enqueue_ns);
+
+  // Remove a request added with the same arguments from the bucket of
+  // 'key'.
+  void Remove(
+      const uint64_t key, const size_t batch_size, const uint64_t enqueue_ns);
+
+  // Return the number of requests in the bucket of 'key'.
+  size_t Count(const uint64_t key) const;
+
+  // Return 0 and set 'key' to the bucket to dispatch at 'now_ns', or
+  // return the nanoseconds until a bucket is ready. A delay of 0 makes
+  // every bucket ready. The index must not be empty.
+  uint64_t NextReady(
+      const uint64_t now_ns, const size_t full_batch_size,
+      const uint64_t max_delay_ns, uint64_t* key) const;
+
+ private:
+  struct Bucket {
+    size_t batch_size_ = 0;
+    // The enqueue times of the requests in the bucket, the first one is
+    // the oldest request.
+    std::multiset<uint64_t> enqueue_ns_;
+  };
+
+  std::unordered_map<uint64_t, Bucket> buckets_;
+  size_t size_ = 0;
+};
+
+// Return 'dim' rounded up to a multiple of 'granularity', a variable or
+// zero granularity leaves 'dim' unchanged.
+int64_t BucketDim(const int64_t dim, const uint64_t granularity);
+
+// Copy the tensor of 'shape' in 'src' into 'dst' of 'padded_shape',
+// zero-filling the padding at the end of every dimension. Every
+// dimension of 'padded_shape' must be at least the one of 'shape'.
+void PadTensor(
+    const char* src, const std::vector<int64_t>& shape,
+    const std::vector<int64_t>& padded_shape, const size_t element_size,
+    char* dst);
+
+}}  // namespace triton::core
@@ -0,0 +1,242 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shared_buffer_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "cuda_utils.h"
+#include "host_memory.h"
+#include "memory_usage.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace core {
+
+SharedBufferRegistry::SharedBuffer::SharedBuffer(
+    MemoryUsageTracker* usage, const TRITONSERVER_MemoryType memory_type,
+    const int64_t memory_type_id, const uint64_t byte_size)
+    : usage_(usage), memory_type_(memory_type),
+      memory_type_id_(memory_type_id), byte_size_(byte_size), buffer_(nullptr),
+      initializer_(nullptr)
+{
+}
+
+Status
+SharedBufferRegistry::SharedBuffer::Allocate()
+{
+  // The buffers are long-lived and potentially large, so they are not
+  // taken from the CUDA memory pool that serves the request buffers.
+  if (memory_type_ == TRITONSERVER_MEMORY_GPU) {
+#ifdef TRITON_ENABLE_GPU
+    int current_device;
+    RETURN_IF_CUDA_ERR(
+        cudaGetDevice(&current_device), std::string("Failed to get device"));
+    RETURN_IF_CUDA_ERR(
+        cudaSetDevice(memory_type_id_), std::string("Failed to set device"));
+    const cudaError_t err =
+        cudaMalloc(&buffer_, std::max(byte_size_, (uint64_t)1));
+    cudaSetDevice(current_device);
+    if (err != cudaSuccess) {
+      buffer_ = nullptr;
+      return Status(
+          Status::Code::UNAVAILABLE,
+          "failed to allocate shared buffer of " + std::to_string(byte_size_) +
+              " bytes on GPU " + std::to_string(memory_type_id_) + ": " +
+              cudaGetErrorString(err));
+    }
+#else
+    return Status(
+        Status::Code::UNSUPPORTED, "GPU memory allocation not supported");
+#endif  // TRITON_ENABLE_GPU
+  } else {
+    buffer_ = HostAlloc(std::max(byte_size_, (uint64_t)1));
+    if (buffer_ == nullptr) {
+      return Status(
+          Status::Code::UNAVAILABLE,
+          "failed to allocate shared buffer of " + std::to_string(byte_size_) +
+              " bytes of CPU memory");
+    }
+  }
+  if (usage_ != nullptr) {
+    usage_->RecordAllocation(buffer_, memory_type_, byte_size_);
+  }
+  return Status::Success;
+}
+
+SharedBufferRegistry::SharedBuffer::~SharedBuffer()
+{
+  if (buffer_ == nullptr) {
+    return;
+  }
+  if (usage_ != nullptr) {
+    usage_->RecordFree(buffer_);
+  }
+  if (memory_type_ == TRITONSERVER_MEMORY_GPU) {
+#ifdef TRITON_ENABLE_GPU
+    // cudaFree() doesn't depend on the current device
+    cudaError_t err = cudaFree(buffer_);
+    if (err != cudaSuccess) {
+      LOG_ERROR << "failed to free shared buffer: " << cudaGetErrorString(err);
+    }
+#endif  // TRITON_ENABLE_GPU
+  } else {
+    free(buffer_);
+  }
+}
+
+SharedBufferRegistry::SharedBufferRegistry(
+    const std::string& model_name, MemoryUsageTracker* usage,
+    const uint64_t wait_timeout_ms)
+    : model_name_(model_name), usage_(usage),
+      wait_timeout_ms_(wait_timeout_ms), stopped_(false)
+{
+}
+
+Status
+SharedBufferRegistry::Acquire(
+    const void* holder, const std::string& name,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const uint64_t byte_size, void** buffer, bool* initialize)
+{
+  const Key key(name, memory_type, memory_type_id);
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(wait_timeout_ms_);
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    if (stopped_) {
+      return Status(
+          Status::Code::UNAVAILABLE, "shared buffer '" + name +
+                                         "' can't be acquired, model '" +
+                                         model_name_ + "' is unloading");
+    }
+    auto it = buffers_.find(key);
+    if (it == buffers_.end()) {
+      std::unique_ptr<SharedBuffer> shared_buffer(
+          new SharedBuffer(usage_, memory_type, memory_type_id, byte_size));
+      RETURN_IF_ERROR(shared_buffer->Allocate());
+      shared_buffer->initializer_ = holder;
+      it = buffers_.emplace(key, std::move(shared_buffer)).first;
+    } else if (it->second->byte_size_ != byte_size) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "shared buffer '" + name + "' of model '" + model_name_ + "' has " +
+              std::to_string(it->second->byte_size_) + " bytes, requested " +
+              std::to_string(byte_size) + " bytes");
+    } else if (
+        (it->second->initializer_ != nullptr) &&
+        (it->second->initializer_ != holder)) {
+      // The buffer may be released or initialized meanwhile, so it is
+      // looked up again after each wake up
+      if (cv_.wait_until(lk, deadline) == std::cv_status::timeout) {
+        return Status(
+            Status::Code::UNAVAILABLE,
+            "timed out after " + std::to_string(wait_timeout_ms_) +
+                " ms waiting for shared buffer '" + name + "' of model '" +
+                model_name_ + "' to be initialized");
+      }
+      continue;
+    }
+
+    SharedBuffer* shared_buffer = it->second.get();
+    shared_buffer->holders_.insert(holder);
+    *buffer = shared_buffer->buffer_;
+    *initialize = (shared_buffer->initializer_ == holder);
+    return Status::Success;
+  }
+}
+
+Status
+SharedBufferRegistry::SetInitialized(
+    const void* holder, const std::string& holder_name,
+    const std::string& name, const TRITONSERVER_MemoryType memory_type,
+    const int64_t memory_type_id, const bool success)
+{
+  // A failed buffer is freed outside of the lock
+  std::unique_ptr<SharedBuffer> released;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = buffers_.find(Key(name, memory_type, memory_type_id));
+    if ((it == buffers_.end()) || (it->second->initializer_ != holder)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "shared buffer '" + name + "' of model '" + model_name_ +
+              "' is not being initialized by instance " + holder_name);
+    }
+    if (success) {
+      it->second->initializer_ = nullptr;
+    } else {
+      // Only the initializer holds the buffer
+      released = std::move(it->second);
+      buffers_.erase(it);
+    }
+  }
+  cv_.notify_all();
+  return Status::Success;
+}
+
+void
+SharedBufferRegistry::Release(
+    const void* holder, const std::string& holder_name)
+{
+  // The buffers are freed outside of the lock
+  std::vector<std::unique_ptr<SharedBuffer>> released;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto it = buffers_.begin(); it != buffers_.end();) {
+      auto& shared_buffer = it->second;
+      shared_buffer->holders_.erase(holder);
+      if (shared_buffer->initializer_ == holder) {
+        LOG_WARNING << "shared buffer '" << std::get<0>(it->first)
+                    << "' of model '" << model_name_
+                    << "' was not initialized by instance " << holder_name
+                    << ", releasing it";
+        shared_buffer->holders_.clear();
+      }
+      if (shared_buffer->holders_.empty()) {
+        released.emplace_back(std::move(shared_buffer));
+        it = buffers_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (!released.empty()) {
+    cv_.notify_all();
+  }
+}
+
+void
+SharedBufferRegistry::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,114 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include "status.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+class MemoryUsageTracker;
+
+//
+// Buffers shared by the instances of a model on a device, see
+// TRITONBACKEND_ModelSharedBufferAcquire. The first holder to acquire a
+// buffer initializes it while the other holders wait, and a buffer is
+// freed once no holder holds it. Holders are opaque, e.g. the model
+// instances.
+//
+class SharedBufferRegistry {
+ public:
+  // Create the registry of the buffers of 'model_name', the allocations
+  // are recorded in 'usage' if not nullptr. An acquisition waits at most
+  // 'wait_timeout_ms' for another holder to initialize the buffer.
+  SharedBufferRegistry(
+      const std::string& model_name, MemoryUsageTracker* usage,
+      const uint64_t wait_timeout_ms);
+
+  // Acquire the buffer 'name' in 'memory_type' and 'memory_type_id' for
+  // 'holder'. Wait while the buffer is being initialized by another
+  // holder, and fail if it isn't initialized in time or the registry is
+  // stopped meanwhile. Return in 'initialize' whether 'holder' must
+  // initialize the buffer.
+  Status Acquire(
+      const void* holder, const std::string& name,
+      const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+      const uint64_t byte_size, void** buffer, bool* initialize);
+
+  // Complete the initialization of the buffer that 'holder', named
+  // 'holder_name', acquired first. A buffer that failed is released and
+  // the next holder waiting for it initializes a new buffer.
+  Status SetInitialized(
+      const void* holder, const std::string& holder_name,
+      const std::string& name, const TRITONSERVER_MemoryType memory_type,
+      const int64_t memory_type_id, const bool success);
+
+  // Drop the references of 'holder' to the buffers, the buffers it is
+  // still initializing are treated as failed.
+  void Release(const void* holder, const std::string& holder_name);
+
+  // Fail the acquisitions that are waiting and the later ones, e.g. once
+  // the model is unloading.
+  void Stop();
+
+ private:
+  struct SharedBuffer {
+    SharedBuffer(
+        MemoryUsageTracker* usage, const TRITONSERVER_MemoryType memory_type,
+        const int64_t memory_type_id, const uint64_t byte_size);
+    ~SharedBuffer();
+    Status Allocate();
+
+    MemoryUsageTracker* usage_;
+    const TRITONSERVER_MemoryType memory_type_;
+    const int64_t memory_type_id_;
+    const uint64_t byte_size_;
+    void* buffer_;
+    // The holder initializing the buffer, nullptr once initialized.
+    const void* initializer_;
+    std::set<const void*> holders_;
+  };
+  // The buffers by name and device.
+  using Key = std::tuple<std::string, TRITONSERVER_MemoryType, int64_t>;
+
+  const std::string model_name_;
+  MemoryUsageTracker* const usage_;
+  const uint64_t wait_timeout_ms_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stopped_;
+  std::map<Key, std::unique_ptr<SharedBuffer>> buffers_;
+};
+
+}}  // namespace triton::core
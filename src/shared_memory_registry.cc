@@ -0,0 +1,313 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shared_memory_registry.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "cuda_utils.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+// Alignment of the buffers allocated inside a region, relative to the
+// start of the region.
+constexpr size_t kBufferAlignment = 256;
+
+}  // namespace
+
+SharedMemoryRegion::SharedMemoryRegion(
+    const std::string& name, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id, char* base, size_t byte_size)
+    : name_(name), memory_type_(memory_type), memory_type_id_(memory_type_id),
+      base_(base), byte_size_(byte_size), mapped_base_(nullptr),
+      mapped_byte_size_(0)
+{
+  const size_t usable_byte_size =
+      (byte_size_ / kBufferAlignment) * kBufferAlignment;
+  if (usable_byte_size > 0) {
+    free_ranges_.emplace(0, usable_byte_size);
+  }
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+  if (mapped_base_ == nullptr) {
+    return;
+  }
+  if (memory_type_ == TRITONSERVER_MEMORY_GPU) {
+#ifdef TRITON_ENABLE_GPU
+    int current_device;
+    if (cudaGetDevice(&current_device) == cudaSuccess) {
+      const bool overridden = (current_device != memory_type_id_);
+      if (overridden) {
+        cudaSetDevice(memory_type_id_);
+      }
+      cudaError_t err = cudaIpcCloseMemHandle(mapped_base_);
+      if (err != cudaSuccess) {
+        LOG_ERROR << "failed to close CUDA IPC handle of shared memory region '"
+                  << name_ << "': " << cudaGetErrorString(err);
+      }
+      if (overridden) {
+        cudaSetDevice(current_device);
+      }
+    }
+#endif  // TRITON_ENABLE_GPU
+  } else {
+#ifndef _WIN32
+    if (munmap(mapped_base_, mapped_byte_size_) != 0) {
+      LOG_ERROR << "failed to unmap shared memory region '" << name_
+                << "', errno:" << strerror(errno);
+    }
+#endif  // !_WIN32
+  }
+}
+
+bool
+SharedMemoryRegion::Allocate(size_t byte_size, void** buffer, size_t* offset)
+{
+  const size_t aligned_byte_size =
+      ((std::max(byte_size, size_t{1}) + kBufferAlignment - 1) /
+       kBufferAlignment) *
+      kBufferAlignment;
+
+  // First fit, the lowest free range keeps the end of the region free
+  // for the large buffers.
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it) {
+    if (it->second < aligned_byte_size) {
+      continue;
+    }
+    *offset = it->first;
+    if (it->second > aligned_byte_size) {
+      free_ranges_.emplace(
+          it->first + aligned_byte_size, it->second - aligned_byte_size);
+    }
+    free_ranges_.erase(it);
+    allocated_ranges_.emplace(*offset, aligned_byte_size);
+    *buffer = base_ + *offset;
+    return true;
+  }
+  return false;
+}
+
+void
+SharedMemoryRegion::Release(size_t offset)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  auto ait = allocated_ranges_.find(offset);
+  if (ait == allocated_ranges_.end()) {
+    LOG_ERROR << "releasing unknown buffer at offset " << offset
+              << " of shared memory region '" << name_ << "'";
+    return;
+  }
+  size_t range_offset = offset;
+  size_t range_byte_size = ait->second;
+  allocated_ranges_.erase(ait);
+
+  // Merge with the adjacent free ranges.
+  auto next = free_ranges_.lower_bound(range_offset);
+  if ((next != free_ranges_.end()) &&
+      (next->first == range_offset + range_byte_size)) {
+    range_byte_size += next->second;
+    next = free_ranges_.erase(next);
+  }
+  if (next != free_ranges_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == range_offset) {
+      range_offset = prev->first;
+      range_byte_size += prev->second;
+      free_ranges_.erase(prev);
+    }
+  }
+  free_ranges_.emplace(range_offset, range_byte_size);
+}
+
+SharedMemoryRegistry&
+SharedMemoryRegistry::Singleton()
+{
+  static SharedMemoryRegistry shared_memory_registry;
+  return shared_memory_registry;
+}
+
+Status
+SharedMemoryRegistry::RegisterSystemRegion(
+    const std::string& name, const std::string& shm_key, size_t offset,
+    size_t byte_size)
+{
+#ifdef _WIN32
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "system shared memory regions are not supported on Windows");
+#else
+  if (byte_size == 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "shared memory region '" + name + "' must not be empty");
+  }
+  const int fd = shm_open(shm_key.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    return Status(
+        Status::Code::INVALID_ARG, "failed to open shared memory key '" +
+                                       shm_key + "' of region '" + name +
+                                       "', errno:" + strerror(errno));
+  }
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < offset + byte_size)) {
+    close(fd);
+    return Status(
+        Status::Code::INVALID_ARG,
+        "shared memory region '" + name + "' exceeds the size of key '" +
+            shm_key + "'");
+  }
+  // The offset may not be page-aligned so the object is mapped from its
+  // start.
+  void* mapped = mmap(
+      nullptr, offset + byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return Status(
+        Status::Code::INTERNAL, "failed to map shared memory region '" +
+                                    name + "', errno:" + strerror(errno));
+  }
+
+  std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion(
+      name, TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */,
+      reinterpret_cast<char*>(mapped) + offset, byte_size));
+  region->mapped_base_ = mapped;
+  region->mapped_byte_size_ = offset + byte_size;
+  return Singleton().Add(std::move(region));
+#endif  // _WIN32
+}
+
+Status
+SharedMemoryRegistry::RegisterCudaRegion(
+    const std::string& name, const void* cuda_ipc_handle, size_t byte_size,
+    int64_t device_id)
+{
+#ifdef TRITON_ENABLE_GPU
+  if (byte_size == 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "shared memory region '" + name + "' must not be empty");
+  }
+  cudaIpcMemHandle_t handle;
+  memcpy(&handle, cuda_ipc_handle, CUDA_IPC_STRUCT_SIZE);
+
+  int current_device;
+  RETURN_IF_CUDA_ERR(
+      cudaGetDevice(&current_device), std::string("Failed to get device"));
+  const bool overridden = (current_device != device_id);
+  if (overridden) {
+    RETURN_IF_CUDA_ERR(
+        cudaSetDevice(device_id), std::string("Failed to set device"));
+  }
+  void* base = nullptr;
+  cudaError_t err =
+      cudaIpcOpenMemHandle(&base, handle, cudaIpcMemLazyEnablePeerAccess);
+  if (overridden) {
+    cudaSetDevice(current_device);
+  }
+  if (err != cudaSuccess) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to open CUDA IPC handle of shared memory region '" + name +
+            "': " + cudaGetErrorString(err));
+  }
+
+  std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion(
+      name, TRITONSERVER_MEMORY_GPU, device_id, reinterpret_cast<char*>(base),
+      byte_size));
+  region->mapped_base_ = base;
+  region->mapped_byte_size_ = byte_size;
+  region->cuda_ipc_handle_.assign(
+      reinterpret_cast<const char*>(cuda_ipc_handle),
+      reinterpret_cast<const char*>(cuda_ipc_handle) + CUDA_IPC_STRUCT_SIZE);
+  return Singleton().Add(std::move(region));
+#else
+  return Status(
+      Status::Code::UNSUPPORTED,
+      "CUDA shared memory regions are not supported, GPU support is not "
+      "enabled");
+#endif  // TRITON_ENABLE_GPU
+}
+
+Status
+SharedMemoryRegistry::Add(std::unique_ptr<SharedMemoryRegion> region)
+{
+  std::lock_guard<std::mutex> lk(mu_);
+  const std::string name = region->Name();
+  if (!regions_.emplace(name, std::move(region)).second) {
+    return Status(
+        Status::Code::ALREADY_EXISTS,
+        "shared memory region '" + name + "' is already registered");
+  }
+  LOG_VERBOSE(1) << "Registered shared memory region '" << name << "'";
+  return Status::Success;
+}
+
+Status
+SharedMemoryRegistry::Unregister(const std::string& name)
+{
+  auto& registry = Singleton();
+  std::lock_guard<std::mutex> lk(registry.mu_);
+  if (registry.regions_.erase(name) == 0) {
+    return Status(
+        Status::Code::NOT_FOUND,
+        "shared memory region '" + name + "' is not registered");
+  }
+  LOG_VERBOSE(1) << "Unregistered shared memory region '" << name << "'";
+  return Status::Success;
+}
+
+Status
+SharedMemoryRegistry::Find(
+    const std::string& name, std::shared_ptr<SharedMemoryRegion>* region)
+{
+  auto& registry = Singleton();
+  std::lock_guard<std::mutex> lk(registry.mu_);
+  auto it = registry.regions_.find(name);
+  if (it == registry.regions_.end()) {
+    return Status(
+        Status::Code::NOT_FOUND,
+        "shared memory region '" + name + "' is not registered");
+  }
+  *region = it->second;
+  return Status::Success;
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,138 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+#include "status.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+//
+// A region of system or CUDA shared memory created by another process
+// and mapped into the server. Output buffers are allocated inside the
+// region so that the process that created it reads the outputs without
+// a copy. The region is unmapped once it is unregistered and the last
+// buffer allocated from it is released.
+//
+class SharedMemoryRegion {
+ public:
+  ~SharedMemoryRegion();
+
+  const std::string& Name() const { return name_; }
+  TRITONSERVER_MemoryType MemoryType() const { return memory_type_; }
+  int64_t MemoryTypeId() const { return memory_type_id_; }
+  size_t ByteSize() const { return byte_size_; }
+
+  // The CUDA IPC handle the region was opened from, nullptr if the region
+  // is in system shared memory.
+  const char* CudaIpcHandle() const
+  {
+    return cuda_ipc_handle_.empty() ? nullptr : cuda_ipc_handle_.data();
+  }
+
+  // Allocate 'byte_size' bytes inside the region, returning the address
+  // of the buffer and its offset from the start of the region. Return
+  // false if the region has no free range large enough.
+  bool Allocate(size_t byte_size, void** buffer, size_t* offset);
+
+  // Release the buffer allocated at 'offset'.
+  void Release(size_t offset);
+
+ private:
+  friend class SharedMemoryRegistry;
+  DISALLOW_COPY_AND_ASSIGN(SharedMemoryRegion);
+
+  SharedMemoryRegion(
+      const std::string& name, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id, char* base, size_t byte_size);
+
+  const std::string name_;
+  const TRITONSERVER_MemoryType memory_type_;
+  const int64_t memory_type_id_;
+  char* const base_;
+  const size_t byte_size_;
+
+  // The mapping to undo when the region is destroyed, the region may
+  // start at an offset into the mapping.
+  void* mapped_base_;
+  size_t mapped_byte_size_;
+  std::vector<char> cuda_ipc_handle_;
+
+  // The free ranges of the region and the byte size of the allocated
+  // ranges, both keyed by offset. Adjacent free ranges are merged.
+  std::mutex mu_;
+  std::map<size_t, size_t> free_ranges_;
+  std::unordered_map<size_t, size_t> allocated_ranges_;
+};
+
+//
+// Registry of the shared memory regions, by name, which the responses
+// may allocate their output buffers in.
+//
+class SharedMemoryRegistry {
+ public:
+  // Register 'byte_size' bytes at 'offset' of the POSIX shared memory
+  // object 'shm_key'.
+  static Status RegisterSystemRegion(
+      const std::string& name, const std::string& shm_key, size_t offset,
+      size_t byte_size);
+
+  // Register 'byte_size' bytes of device memory on 'device_id' exported
+  // by another process as 'cuda_ipc_handle', a cudaIpcMemHandle_t.
+  static Status RegisterCudaRegion(
+      const std::string& name, const void* cuda_ipc_handle, size_t byte_size,
+      int64_t device_id);
+
+  static Status Unregister(const std::string& name);
+
+  // Find the region registered as 'name'.
+  static Status Find(
+      const std::string& name, std::shared_ptr<SharedMemoryRegion>* region);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SharedMemoryRegistry);
+
+  SharedMemoryRegistry() = default;
+  static SharedMemoryRegistry& Singleton();
+  Status Add(std::unique_ptr<SharedMemoryRegion> region);
+
+  std::mutex mu_;
+  std::unordered_map<std::string, std::shared_ptr<SharedMemoryRegion>>
+      regions_;
+};
+
+}}  // namespace triton::core
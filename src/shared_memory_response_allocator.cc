@@ -0,0 +1,157 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "shared_memory_response_allocator.h"
+
+#include "buffer_attributes.h"
+#include "pooled_response_allocator.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace core {
+
+ResponseAllocator*
+SharedMemoryResponseAllocator::Create()
+{
+  ResponseAllocator* allocator = new ResponseAllocator(
+      &SharedMemoryResponseAllocator::Alloc,
+      &SharedMemoryResponseAllocator::Release, nullptr /* start_fn */);
+  allocator->SetBufferAttributesFunction(
+      &SharedMemoryResponseAllocator::BufferAttributes);
+  allocator->SetQueryFunction(&SharedMemoryResponseAllocator::Query);
+  return allocator;
+}
+
+TRITONSERVER_Error*
+SharedMemoryResponseAllocator::Alloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id, void* userp, void** buffer, void** buffer_userp,
+    TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *buffer = nullptr;
+  *buffer_userp = nullptr;
+
+  if ((userp != nullptr) && (byte_size > 0)) {
+    std::shared_ptr<SharedMemoryRegion> region;
+    Status status = SharedMemoryRegistry::Find(
+        reinterpret_cast<const char*>(userp), &region);
+    if (!status.IsOk()) {
+      return TRITONSERVER_ErrorNew(
+          StatusCodeToTritonCode(status.StatusCode()),
+          status.Message().c_str());
+    }
+    size_t offset;
+    if (region->Allocate(byte_size, buffer, &offset)) {
+      *actual_memory_type = region->MemoryType();
+      *actual_memory_type_id = region->MemoryTypeId();
+      *buffer_userp = new Allocation{std::move(region), offset};
+      return nullptr;  // success
+    }
+    LOG_VERBOSE(1) << "shared memory region '" << region->Name()
+                   << "' has no room for " << byte_size
+                   << " bytes of output '" << tensor_name
+                   << "', using the memory pools";
+  }
+
+  return PooledResponseAllocator::Alloc(
+      allocator, tensor_name, byte_size, memory_type, memory_type_id, userp,
+      buffer, buffer_userp, actual_memory_type, actual_memory_type_id);
+}
+
+TRITONSERVER_Error*
+SharedMemoryResponseAllocator::BufferAttributes(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    TRITONSERVER_BufferAttributes* buffer_attributes, void* userp,
+    void* buffer_userp)
+{
+  // The consumer of a buffer in CUDA shared memory finds it by the IPC
+  // handle of the region it created.
+  if (buffer_userp != nullptr) {
+    const auto& region = reinterpret_cast<Allocation*>(buffer_userp)->region_;
+    if (region->CudaIpcHandle() != nullptr) {
+      reinterpret_cast<triton::core::BufferAttributes*>(buffer_attributes)
+          ->SetCudaIpcHandle(const_cast<char*>(region->CudaIpcHandle()));
+    }
+  }
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryResponseAllocator::Release(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  if (buffer_userp == nullptr) {
+    return PooledResponseAllocator::Release(
+        allocator, buffer, buffer_userp, byte_size, memory_type,
+        memory_type_id);
+  }
+
+  // Releasing the last buffer of an unregistered region unmaps it.
+  std::unique_ptr<Allocation> allocation(
+      reinterpret_cast<Allocation*>(buffer_userp));
+  allocation->region_->Release(allocation->offset_);
+  return nullptr;  // success
+}
+
+TRITONSERVER_Error*
+SharedMemoryResponseAllocator::Query(
+    TRITONSERVER_ResponseAllocator* allocator, void* userp,
+    const char* tensor_name, size_t* byte_size,
+    TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id)
+{
+  if (userp != nullptr) {
+    std::shared_ptr<SharedMemoryRegion> region;
+    Status status = SharedMemoryRegistry::Find(
+        reinterpret_cast<const char*>(userp), &region);
+    if (status.IsOk()) {
+      *memory_type = region->MemoryType();
+      *memory_type_id = region->MemoryTypeId();
+      return nullptr;  // success
+    }
+  }
+  return PooledResponseAllocator::Query(
+      allocator, userp, tensor_name, byte_size, memory_type, memory_type_id);
+}
+
+Status
+SharedMemoryResponseAllocator::Location(
+    void* buffer_userp, const char** region_name, size_t* offset)
+{
+  if (buffer_userp == nullptr) {
+    return Status(
+        Status::Code::NOT_FOUND,
+        "buffer is not allocated in a shared memory region");
+  }
+  const Allocation* allocation = reinterpret_cast<Allocation*>(buffer_userp);
+  *region_name = allocation->region_->Name().c_str();
+  *offset = allocation->offset_;
+  return Status::Success;
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,89 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+
+#include "response_allocator.h"
+#include "shared_memory_registry.h"
+#include "status.h"
+#include "tritonserver_apis.h"
+
+namespace triton { namespace core {
+
+//
+// The callbacks of the response allocator returned by
+// TRITONSERVER_ResponseAllocatorNewSharedMemory. The allocator 'userp'
+// of a request is the name of the registered shared memory region that
+// the output buffers of its responses are allocated in, and the
+// 'buffer_userp' of a buffer records where it is in the region. The
+// outputs of the requests that name no region, or that don't fit in the
+// region, are allocated by the pooled allocator instead and have a null
+// 'buffer_userp'.
+//
+class SharedMemoryResponseAllocator {
+ public:
+  // Create a response allocator using the shared memory callbacks.
+  static ResponseAllocator* Create();
+
+  static TRITONSERVER_Error* Alloc(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id, void* userp, void** buffer, void** buffer_userp,
+      TRITONSERVER_MemoryType* actual_memory_type,
+      int64_t* actual_memory_type_id);
+
+  static TRITONSERVER_Error* BufferAttributes(
+      TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+      TRITONSERVER_BufferAttributes* buffer_attributes, void* userp,
+      void* buffer_userp);
+
+  static TRITONSERVER_Error* Release(
+      TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+      void* buffer_userp, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+      int64_t memory_type_id);
+
+  static TRITONSERVER_Error* Query(
+      TRITONSERVER_ResponseAllocator* allocator, void* userp,
+      const char* tensor_name, size_t* byte_size,
+      TRITONSERVER_MemoryType* memory_type, int64_t* memory_type_id);
+
+  // Return the region and the offset in the region of the buffer
+  // associated with 'buffer_userp'.
+  static Status Location(
+      void* buffer_userp, const char** region_name, size_t* offset);
+
+ private:
+  // The 'buffer_userp' of a buffer allocated in a region, holding the
+  // region until the buffer is released.
+  struct Allocation {
+    std::shared_ptr<SharedMemoryRegion> region_;
+    size_t offset_;
+  };
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,91 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// Groups of identical items keyed by a hash, where only the leader of a
+// group executes and the other items of the group wait for its result.
+// A group is released by its leader only, so a leader that releases late,
+// e.g. once its item is destroyed, doesn't release the waiters of a newer
+// leader of the same key.
+//
+// The groups are thread-safe.
+//
+template <typename T>
+class SingleFlightGroups {
+ public:
+  // Make 'item' the leader of the group of 'key' and return true if the
+  // group has no leader. Otherwise take 'item' as a waiter of the group
+  // and return false.
+  bool Join(const uint64_t key, std::unique_ptr<T>& item)
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto res = groups_.emplace(key, Group());
+    if (res.second) {
+      res.first->second.leader_ = item.get();
+      return true;
+    }
+    res.first->second.waiters_.emplace_back(std::move(item));
+    return false;
+  }
+
+  // Return the waiters of the group of 'key' and remove the group if it
+  // is led by 'leader', otherwise return no waiters. The returned items
+  // must rejoin to wait for a new leader.
+  std::vector<std::unique_ptr<T>> Release(
+      const uint64_t key, const T* leader)
+  {
+    std::vector<std::unique_ptr<T>> waiters;
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = groups_.find(key);
+    if ((it == groups_.end()) || (it->second.leader_ != leader)) {
+      return waiters;
+    }
+    waiters.swap(it->second.waiters_);
+    groups_.erase(it);
+    return waiters;
+  }
+
+ private:
+  struct Group {
+    const T* leader_ = nullptr;
+    std::vector<std::unique_ptr<T>> waiters_;
+  };
+
+  std::mutex mu_;
+  std::unordered_map<uint64_t, Group> groups_;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,82 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "admission_controller.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kUs = 1000;
+
+TEST(AdmissionControllerTest, AdmitUntilObserved)
+{
+  tc::AdmissionController controller(1000 * kUs, 0);
+  EXPECT_EQ(controller.ExpectedLatencyNs(1000), 0u);
+  EXPECT_TRUE(controller.Admit(controller.ExpectedLatencyNs(1000), 0, 0));
+}
+
+TEST(AdmissionControllerTest, ExpectedLatency)
+{
+  // Batches of 10 requests take 1 ms on each of 2 instances, so a request
+  // takes 50 us of the model
+  tc::AdmissionController controller(0, 0);
+  controller.RecordExecutions(100, 10, 10 * 1000 * kUs, 2);
+  EXPECT_EQ(controller.ExpectedLatencyNs(0), 1000 * kUs);
+  EXPECT_EQ(controller.ExpectedLatencyNs(20), 2000 * kUs);
+}
+
+TEST(AdmissionControllerTest, Budget)
+{
+  tc::AdmissionController controller(1000 * kUs, 0);
+  EXPECT_TRUE(controller.Admit(1000 * kUs, 0, 0));
+  EXPECT_FALSE(controller.Admit(1001 * kUs, 0, 0));
+
+  // The timeout is used if shorter than the SLO
+  EXPECT_FALSE(controller.Admit(600 * kUs, 0, 500 * kUs));
+  EXPECT_TRUE(controller.Admit(600 * kUs, 0, 2000 * kUs));
+
+  // Only the timeouts are enforced without SLO
+  tc::AdmissionController timeout_only(0, 0);
+  EXPECT_TRUE(timeout_only.Admit(10000 * kUs, 0, 0));
+  EXPECT_FALSE(timeout_only.Admit(600 * kUs, 0, 500 * kUs));
+}
+
+TEST(AdmissionControllerTest, PriorityShedding)
+{
+  // The budget shrinks from the whole SLO for priority 1 to half of it
+  // for priority 3
+  tc::AdmissionController controller(1000 * kUs, 3);
+  EXPECT_TRUE(controller.Admit(800 * kUs, 1, 0));
+  EXPECT_TRUE(controller.Admit(700 * kUs, 2, 0));
+  EXPECT_FALSE(controller.Admit(800 * kUs, 2, 0));
+  EXPECT_TRUE(controller.Admit(500 * kUs, 3, 0));
+  EXPECT_FALSE(controller.Admit(600 * kUs, 3, 0));
+}
+
+}  // namespace
@@ -0,0 +1,132 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include "arena.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+bool
+InBuffer(const void* ptr, const void* buffer, size_t byte_size)
+{
+  const char* p = reinterpret_cast<const char*>(ptr);
+  const char* b = reinterpret_cast<const char*>(buffer);
+  return (p >= b) && (p < b + byte_size);
+}
+
+TEST(ArenaTest, AllocateFromBuffer)
+{
+  alignas(std::max_align_t) char buffer[256];
+  tc::MonotonicArena arena(buffer, sizeof(buffer));
+
+  void* first = arena.Allocate(10, 1);
+  void* second = arena.Allocate(8, 8);
+  EXPECT_TRUE(InBuffer(first, buffer, sizeof(buffer)));
+  EXPECT_TRUE(InBuffer(second, buffer, sizeof(buffer)));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % 8, 0u);
+  EXPECT_GE(
+      reinterpret_cast<char*>(second), reinterpret_cast<char*>(first) + 10);
+  EXPECT_EQ(arena.BlockCount(), 0u);
+}
+
+TEST(ArenaTest, OverflowToHeap)
+{
+  tc::InlineMonotonicArena<64> arena;
+  arena.Allocate(48, 8);
+  void* overflow = arena.Allocate(48, 8);
+  EXPECT_EQ(arena.BlockCount(), 1u);
+
+  // Larger than the next block size.
+  void* large = arena.Allocate(16 * 1024, 16);
+  EXPECT_EQ(arena.BlockCount(), 2u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 16, 0u);
+  EXPECT_NE(overflow, large);
+}
+
+TEST(ArenaTest, ResetKeepsLargestBlock)
+{
+  alignas(std::max_align_t) char buffer[64];
+  tc::MonotonicArena arena(buffer, sizeof(buffer));
+  arena.Allocate(48, 8);
+  arena.Allocate(512, 8);
+  void* large = arena.Allocate(8 * 1024, 8);
+  EXPECT_EQ(arena.BlockCount(), 2u);
+
+  arena.Reset();
+  EXPECT_EQ(arena.BlockCount(), 0u);
+  EXPECT_TRUE(InBuffer(arena.Allocate(48, 8), buffer, sizeof(buffer)))
+      << "Expect allocation from the buffer after Reset()";
+
+  // The same usage must be served by the spare block without growing.
+  arena.Allocate(8 * 1024, 8);
+  EXPECT_EQ(arena.BlockCount(), 1u);
+  EXPECT_EQ(arena.Allocate(1, 1), reinterpret_cast<char*>(large) + 8 * 1024)
+      << "Expect the largest block to be reused";
+}
+
+TEST(ArenaTest, Containers)
+{
+  tc::InlineMonotonicArena<1024> arena;
+  using Map = std::unordered_map<
+      std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+      tc::ArenaAllocator<std::pair<const std::string, int>>>;
+  using Deque = std::deque<int, tc::ArenaAllocator<int>>;
+
+  for (size_t round = 0; round < 3; ++round) {
+    {
+      Map map{Map::allocator_type(&arena)};
+      Deque deque{Deque::allocator_type(&arena)};
+      for (int i = 0; i < 200; ++i) {
+        map.emplace("key_" + std::to_string(i), i);
+        deque.push_back(i);
+      }
+      ASSERT_EQ(map.size(), 200u);
+      EXPECT_EQ(map.at("key_42"), 42);
+      EXPECT_EQ(deque[199], 199);
+
+      Map copy(map);
+      EXPECT_EQ(copy.get_allocator(), map.get_allocator());
+      EXPECT_EQ(copy.at("key_199"), 199);
+    }
+    arena.Reset();
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
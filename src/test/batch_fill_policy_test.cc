@@ -0,0 +1,81 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "batch_fill_policy.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kUs = 1000;
+
+TEST(BatchFillPolicyTest, Disabled)
+{
+  // Either a zero utilization or a zero delay executes right away
+  tc::BatchFillPolicy no_utilization(0.0, 100 * kUs, 8);
+  EXPECT_FALSE(no_utilization.Enabled());
+  EXPECT_EQ(no_utilization.WaitNs(1, 0, 0), 0);
+
+  tc::BatchFillPolicy no_delay(0.5, 0, 8);
+  EXPECT_FALSE(no_delay.Enabled());
+  EXPECT_EQ(no_delay.WaitNs(1, 0, 0), 0);
+}
+
+TEST(BatchFillPolicyTest, Utilization)
+{
+  tc::BatchFillPolicy policy(0.5, 100 * kUs, 8);
+  EXPECT_TRUE(policy.Enabled());
+
+  // Less than half of the slots ready waits for the remaining delay
+  EXPECT_EQ(policy.WaitNs(3, 1000 * kUs, 1000 * kUs), 100 * kUs);
+  EXPECT_EQ(policy.WaitNs(3, 1000 * kUs, 1040 * kUs), 60 * kUs);
+
+  // Half of the slots ready executes
+  EXPECT_EQ(policy.WaitNs(4, 1000 * kUs, 1000 * kUs), 0);
+  EXPECT_EQ(policy.WaitNs(8, 1000 * kUs, 1000 * kUs), 0);
+
+  // The threshold is not lowered by float rounding
+  tc::BatchFillPolicy rounding(0.3, 100 * kUs, 10);
+  EXPECT_EQ(rounding.WaitNs(3, 0, 0), 0);
+  EXPECT_NE(rounding.WaitNs(2, 0, 0), 0);
+}
+
+TEST(BatchFillPolicyTest, MaxDelay)
+{
+  tc::BatchFillPolicy policy(1.0, 100 * kUs, 8);
+
+  // A sparse batch executes once its oldest request waited the maximum
+  // delay
+  EXPECT_EQ(policy.WaitNs(1, 1000 * kUs, 1099 * kUs), 1 * kUs);
+  EXPECT_EQ(policy.WaitNs(1, 1000 * kUs, 1100 * kUs), 0);
+  EXPECT_EQ(policy.WaitNs(1, 1000 * kUs, 5000 * kUs), 0);
+
+  // A request enqueued after 'now' waits the whole delay
+  EXPECT_EQ(policy.WaitNs(1, 1000 * kUs, 900 * kUs), 100 * kUs);
+}
+
+}  // namespace
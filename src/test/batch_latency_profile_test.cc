@@ -0,0 +1,110 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <map>
+#include <set>
+#include "batch_latency_profile.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(BatchLatencyProfileTest, Record)
+{
+  tc::BatchLatencyProfile profile;
+  profile.Record(0, 1000);
+  profile.Record(4, 1000);
+  profile.Record(4, 2000);
+
+  std::map<size_t, double> latency_ns;
+  profile.Snapshot(&latency_ns);
+  ASSERT_EQ(latency_ns.size(), 1u) << "Expect batch size 0 to be ignored";
+  EXPECT_GT(latency_ns[4], 1000);
+  EXPECT_LT(latency_ns[4], 2000);
+}
+
+TEST(BatchLatencyProfileTest, TooFewBatchSizes)
+{
+  std::set<int32_t> batch_sizes;
+  EXPECT_FALSE(tc::BatchLatencyProfile::EfficientBatchSizes(
+      {{8, 1000}}, 32, &batch_sizes));
+  EXPECT_TRUE(batch_sizes.empty());
+}
+
+TEST(BatchLatencyProfileTest, NoCliff)
+{
+  // Latency grows slower than the batch size, only the maximum batch
+  // size is worth waiting for
+  std::set<int32_t> batch_sizes;
+  EXPECT_TRUE(tc::BatchLatencyProfile::EfficientBatchSizes(
+      {{1, 110}, {16, 260}}, 32, &batch_sizes));
+  EXPECT_EQ(batch_sizes, std::set<int32_t>({32}));
+}
+
+TEST(BatchLatencyProfileTest, Cliffs)
+{
+  // Latency jumps after batch size 8 and 12
+  std::map<size_t, double> latency_ns;
+  for (size_t batch_size = 1; batch_size <= 16; ++batch_size) {
+    double latency = 100 + (10 * batch_size);
+    if (batch_size > 8) {
+      latency += 200;
+    }
+    if (batch_size > 12) {
+      latency += 200;
+    }
+    latency_ns[batch_size] = latency;
+  }
+
+  std::set<int32_t> batch_sizes;
+  EXPECT_TRUE(tc::BatchLatencyProfile::EfficientBatchSizes(
+      latency_ns, 32, &batch_sizes));
+  EXPECT_EQ(batch_sizes, std::set<int32_t>({8, 12, 32}));
+
+  // Cliffs beyond the maximum batch size are ignored
+  EXPECT_TRUE(tc::BatchLatencyProfile::EfficientBatchSizes(
+      latency_ns, 10, &batch_sizes));
+  EXPECT_EQ(batch_sizes, std::set<int32_t>({8, 10}));
+}
+
+TEST(BatchLatencyProfileTest, InterpolatedCliff)
+{
+  // Sparse observations, the throughput drops between 8 and 16
+  std::set<int32_t> batch_sizes;
+  EXPECT_TRUE(tc::BatchLatencyProfile::EfficientBatchSizes(
+      {{1, 100}, {8, 200}, {16, 800}}, 16, &batch_sizes));
+  EXPECT_EQ(batch_sizes, std::set<int32_t>({8, 16}));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
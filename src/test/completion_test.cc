@@ -0,0 +1,139 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "completion.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(CompletionTest, CompleteBeforeWait)
+{
+  tc::Completion<int> completion;
+  EXPECT_FALSE(completion.IsCompleted());
+  completion.Complete(7);
+  EXPECT_TRUE(completion.IsCompleted());
+  EXPECT_EQ(completion.Wait(), 7);
+  EXPECT_EQ(completion.Wait(), 7) << "Expect Wait() to be repeatable";
+}
+
+TEST(CompletionTest, WaitBeforeComplete)
+{
+  tc::Completion<int> completion;
+  std::thread completer([&completion]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    completion.Complete(3);
+  });
+  EXPECT_EQ(completion.Wait(), 3);
+  completer.join();
+}
+
+TEST(CompletionTest, Reuse)
+{
+  tc::Completion<int> completion;
+  for (int i = 0; i < 1000; ++i) {
+    completion.Reset();
+    EXPECT_FALSE(completion.IsCompleted());
+    std::thread completer([&completion, i]() { completion.Complete(i); });
+    EXPECT_EQ(completion.Wait(), i);
+    completer.join();
+  }
+}
+
+// Per-payload completion overhead compared to the std::promise previously
+// allocated for every payload. INFER_RUN and EXIT payloads are completed
+// without waiter while INIT and WARM_UP payloads are waited on by the
+// thread loading the model.
+TEST(CompletionTest, Overhead)
+{
+  constexpr size_t kIterations = 200000;
+  const auto report = [](const std::string& name, const size_t iterations,
+                         const std::chrono::steady_clock::time_point& start) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    std::cout << "[ BENCHMARK] " << name << ": "
+              << (static_cast<double>(elapsed) / iterations)
+              << " ns per payload" << std::endl;
+  };
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+      std::unique_ptr<std::promise<int>> promise(new std::promise<int>());
+      promise->set_value(0);
+    }
+    report("promise, INFER_RUN / EXIT", kIterations, start);
+
+    tc::Completion<int> completion;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+      completion.Reset();
+      completion.Complete(0);
+    }
+    report("completion, INFER_RUN / EXIT", kIterations, start);
+  }
+
+  {
+    constexpr size_t kWaitIterations = kIterations / 10;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kWaitIterations; ++i) {
+      std::unique_ptr<std::promise<int>> promise(new std::promise<int>());
+      std::future<int> future = promise->get_future();
+      std::thread completer([&promise]() { promise->set_value(0); });
+      EXPECT_EQ(future.get(), 0);
+      completer.join();
+    }
+    report("promise, INIT / WARM_UP", kWaitIterations, start);
+
+    tc::Completion<int> completion;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kWaitIterations; ++i) {
+      completion.Reset();
+      std::thread completer([&completion]() { completion.Complete(0); });
+      EXPECT_EQ(completion.Wait(), 0);
+      completer.join();
+    }
+    report("completion, INIT / WARM_UP", kWaitIterations, start);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,250 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <cuda_runtime_api.h>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <vector>
+#include "copy_batch.h"
+#include "pinned_memory_manager.h"
+#include "triton/common/sync_queue.h"
+#include "tritonserver_apis.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+// Wrapper of PinnedMemoryManager class to expose Reset() for unit testing
+class TestingPinnedMemoryManager : public tc::PinnedMemoryManager {
+ public:
+  static void Reset() { PinnedMemoryManager::Reset(); }
+};
+
+class CopyBatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    tc::PinnedMemoryManager::Options options;
+    options.pinned_memory_pool_byte_size_ = 1 << 20;
+    auto status = tc::PinnedMemoryManager::Create(options);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+
+    auto cuerr = cudaMalloc(&device_buffer_, kDeviceByteSize);
+    ASSERT_TRUE(cuerr == cudaSuccess)
+        << "Failed to allocate device buffer: " << cudaGetErrorString(cuerr);
+  }
+
+  void TearDown() override
+  {
+    cudaFree(device_buffer_);
+    TestingPinnedMemoryManager::Reset();
+  }
+
+  // Copy the device buffer back to host and compare it with 'expected'.
+  void ExpectDeviceContent(const std::vector<char>& expected)
+  {
+    std::vector<char> content(expected.size());
+    auto cuerr = cudaMemcpy(
+        content.data(), device_buffer_, content.size(),
+        cudaMemcpyDeviceToHost);
+    ASSERT_TRUE(cuerr == cudaSuccess)
+        << "Failed to read device buffer: " << cudaGetErrorString(cuerr);
+    EXPECT_EQ(content, expected);
+  }
+
+  static constexpr size_t kDeviceByteSize = 1 << 20;
+  void* device_buffer_ = nullptr;
+};
+
+std::vector<char>
+MakeData(size_t byte_size, char first)
+{
+  std::vector<char> data(byte_size);
+  std::iota(data.begin(), data.end(), first);
+  return data;
+}
+
+TEST_F(CopyBatchTest, MergeContiguousHostRegions)
+{
+  std::vector<char> src = MakeData(96, 0);
+  std::vector<char> dst(src.size(), 0);
+
+  tc::CopyBatch batch("test", 0);
+  for (size_t offset = 0; offset < src.size(); offset += 32) {
+    batch.Add(
+        TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_CPU, 0, 32,
+        src.data() + offset, dst.data() + offset);
+  }
+  EXPECT_EQ(batch.RegionCount(), 1);
+
+  bool cuda_used = true;
+  auto status = batch.Flush(&cuda_used);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_FALSE(cuda_used);
+  EXPECT_EQ(batch.CudaCopyCount(), 0);
+  EXPECT_EQ(batch.RegionCount(), 0);
+  EXPECT_EQ(dst, src);
+}
+
+TEST_F(CopyBatchTest, KeepNonContiguousHostRegions)
+{
+  std::vector<char> src = MakeData(96, 0);
+  std::vector<char> dst(src.size(), 0);
+
+  // Reverse the order of the chunks so that neither side is contiguous
+  tc::CopyBatch batch("test", 0);
+  for (size_t idx = 0; idx < 3; ++idx) {
+    batch.Add(
+        TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_CPU, 0, 32,
+        src.data() + (2 - idx) * 32, dst.data() + idx * 32);
+  }
+  EXPECT_EQ(batch.RegionCount(), 3);
+
+  bool cuda_used = true;
+  auto status = batch.Flush(&cuda_used);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_FALSE(cuda_used);
+  for (size_t idx = 0; idx < 3; ++idx) {
+    EXPECT_TRUE(std::equal(
+        dst.begin() + idx * 32, dst.begin() + (idx + 1) * 32,
+        src.begin() + (2 - idx) * 32));
+  }
+}
+
+TEST_F(CopyBatchTest, GatherSmallHostRegions)
+{
+  // Separate host allocations that are collated into one device buffer
+  std::vector<std::vector<char>> srcs;
+  std::vector<char> expected;
+  for (size_t idx = 0; idx < 8; ++idx) {
+    srcs.emplace_back(MakeData(1024, idx));
+    expected.insert(expected.end(), srcs.back().begin(), srcs.back().end());
+  }
+
+  tc::CopyBatch batch("test", 0);
+  size_t offset = 0;
+  for (const auto& src : srcs) {
+    batch.Add(
+        TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_GPU, 0, src.size(),
+        src.data(), reinterpret_cast<char*>(device_buffer_) + offset);
+    offset += src.size();
+  }
+  EXPECT_EQ(batch.RegionCount(), srcs.size());
+
+  bool cuda_used = false;
+  auto status = batch.Flush(&cuda_used);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_TRUE(cuda_used);
+  EXPECT_EQ(batch.CudaCopyCount(), 1);
+  ASSERT_TRUE(cudaStreamSynchronize(0) == cudaSuccess);
+  ExpectDeviceContent(expected);
+}
+
+TEST_F(CopyBatchTest, CopyLargeRegionsDirectly)
+{
+  const size_t byte_size = tc::CopyBatch::kGatherThreshold + 1;
+  std::vector<char> first = MakeData(byte_size, 0);
+  std::vector<char> second = MakeData(byte_size, 1);
+  std::vector<char> expected(first);
+  expected.insert(expected.end(), second.begin(), second.end());
+
+  tc::CopyBatch batch("test", 0);
+  batch.Add(
+      TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_GPU, 0, byte_size,
+      first.data(), device_buffer_);
+  batch.Add(
+      TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_GPU, 0, byte_size,
+      second.data(), reinterpret_cast<char*>(device_buffer_) + byte_size);
+
+  bool cuda_used = false;
+  auto status = batch.Flush(&cuda_used);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_TRUE(cuda_used);
+  EXPECT_EQ(batch.CudaCopyCount(), 2);
+  ASSERT_TRUE(cudaStreamSynchronize(0) == cudaSuccess);
+  ExpectDeviceContent(expected);
+}
+
+TEST_F(CopyBatchTest, CopySeparatelyWithoutStaging)
+{
+  // Without pinned memory manager the regions can't be staged
+  TestingPinnedMemoryManager::Reset();
+
+  std::vector<char> first = MakeData(64, 0);
+  std::vector<char> second = MakeData(64, 64);
+  std::vector<char> expected(first);
+  expected.insert(expected.end(), second.begin(), second.end());
+
+  tc::CopyBatch batch("test", 0);
+  batch.Add(
+      TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_GPU, 0, first.size(),
+      first.data(), device_buffer_);
+  batch.Add(
+      TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_GPU, 0, second.size(),
+      second.data(), reinterpret_cast<char*>(device_buffer_) + first.size());
+
+  bool cuda_used = false;
+  auto status = batch.Flush(&cuda_used);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_TRUE(cuda_used);
+  EXPECT_EQ(batch.CudaCopyCount(), 2);
+  ASSERT_TRUE(cudaStreamSynchronize(0) == cudaSuccess);
+  ExpectDeviceContent(expected);
+}
+
+TEST_F(CopyBatchTest, HandlerCompletesOncePerBatch)
+{
+  std::vector<char> src = MakeData(256, 0);
+  std::vector<char> dst(src.size(), 0);
+
+  tc::CopyBatch batch("test", 0);
+  for (size_t offset = 0; offset < src.size(); offset += 64) {
+    batch.Add(
+        TRITONSERVER_MEMORY_CPU, 0, TRITONSERVER_MEMORY_CPU, 0, 64,
+        src.data() + offset, dst.data() + (src.size() - offset - 64));
+  }
+
+  triton::common::SyncQueue<std::tuple<tc::Status, bool, void*>> queue;
+  int tag = 0;
+  tc::CopyBatchHandler(&batch, &tag, &queue);
+  ASSERT_FALSE(queue.Empty());
+  auto result = queue.Get();
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_TRUE(std::get<0>(result).IsOk()) << std::get<0>(result).Message();
+  EXPECT_FALSE(std::get<1>(result));
+  EXPECT_EQ(std::get<2>(result), &tag);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
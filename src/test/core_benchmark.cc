@@ -0,0 +1,398 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks of the core hot paths. The inference benchmarks go through
+// the public API and so cover request creation and normalization, the
+// scheduler queue, the dynamic batcher and the rate limiter. They run
+// against models of the null backend generated in a temporary model
+// repository, so they measure the core rather than a framework. The
+// null backend is loaded from the backend directory named by the
+// TRITON_BENCHMARK_BACKEND_DIR environment variable, "./backends" by
+// default, which is where the build places it.
+//
+// Use --benchmark_format=json or --benchmark_out=<file> to record the
+// results for trend tracking.
+#include "benchmark/benchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hash_utils.h"
+#include "pinned_memory_manager.h"
+#include "tool_utils.h"
+#include "triton/core/tritonserver.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr size_t kElementCount = 16;
+
+// The models generated for the benchmarks.
+constexpr char kModel[] = "null_fp32";
+constexpr char kCacheModel[] = "null_fp32_cache";
+constexpr char kPriorityModel[] = "null_fp32_priority";
+constexpr uint32_t kPriorityLevels = 4;
+
+std::string
+EnvOrDefault(const char* name, const char* default_value)
+{
+  const char* value = std::getenv(name);
+  return (value == nullptr) ? default_value : value;
+}
+
+void
+InferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  TRITONSERVER_InferenceRequestDelete(request);
+}
+
+void
+InferResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  if (response != nullptr) {
+    TRITONSERVER_InferenceResponseDelete(response);
+  }
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    reinterpret_cast<std::promise<void>*>(userp)->set_value();
+  }
+}
+
+// The configuration of a null backend model of the benchmarks, which
+// batches a FP32 input INPUT0 into a FP32 output OUTPUT0 of shape [-1].
+std::string
+ModelConfig(
+    const std::string& name, const std::string& extra_config,
+    const std::string& extra_batching = "")
+{
+  std::ostringstream config;
+  config << "name: \"" << name << "\"\n"
+         << "backend: \"null\"\n"
+         << "max_batch_size: 16\n"
+         << "input [ { name: \"INPUT0\" data_type: TYPE_FP32 dims: [ -1 ] "
+            "} ]\n"
+         << "output [ { name: \"OUTPUT0\" data_type: TYPE_FP32 dims: [ -1 "
+            "] } ]\n"
+         << "dynamic_batching {\n"
+         << extra_batching << "}\n"
+         << "instance_group [ { kind: KIND_CPU count: 1 } ]\n"
+         << extra_config;
+  return config.str();
+}
+
+// The server shared by all the inference benchmarks, created on first
+// use and never deleted so that its lifetime spans all the benchmarks.
+// The generated repository is removed when the benchmarks exit.
+class BenchmarkServer {
+ public:
+  static BenchmarkServer* Get()
+  {
+    static BenchmarkServer* server = new BenchmarkServer();
+    return server;
+  }
+
+  TRITONSERVER_Server* Server() { return server_; }
+  TRITONSERVER_ResponseAllocator* Allocator() { return allocator_; }
+
+ private:
+  BenchmarkServer()
+  {
+    // The repository is removed when the benchmarks exit.
+    static tc::test::GeneratedRepository repository("core_benchmark");
+    repository.AddModel(kModel, ModelConfig(kModel, ""));
+    repository.AddModel(
+        kCacheModel,
+        ModelConfig(kCacheModel, "response_cache { enable: true }\n"));
+    // The requests queue behind a short execution so that the priority
+    // queue of the dynamic batcher holds requests of every level.
+    repository.AddModel(
+        kPriorityModel,
+        ModelConfig(
+            kPriorityModel,
+            "parameters { key: \"exec_time_us\" value: { string_value: "
+            "\"50\" } }\n",
+            "  priority_levels: " + std::to_string(kPriorityLevels) +
+                "\n  default_priority_level: " +
+                std::to_string(kPriorityLevels) + "\n"));
+
+    const std::string backend_dir =
+        EnvOrDefault("TRITON_BENCHMARK_BACKEND_DIR", "./backends");
+
+    TRITONSERVER_ServerOptions* server_options = nullptr;
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsNew(&server_options),
+        "creating server options");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetModelRepositoryPath(
+            server_options, repository.Path().c_str()),
+        "setting model repository path");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetBackendDirectory(
+            server_options, backend_dir.c_str()),
+        "setting backend directory");
+    // Small enough for the insertion benchmark to evict entries.
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetResponseCacheByteSize(
+            server_options, 1024 * 1024),
+        "setting response cache byte size");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetRepoAgentDirectory(
+            server_options, "/opt/tritonserver/repoagents"),
+        "setting repository agent directory");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsSetStrictModelConfig(server_options, true),
+        "setting strict model configuration");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerNew(&server_, server_options), "creating server");
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerOptionsDelete(server_options),
+        "deleting server options");
+
+    // Wait until the server is both live and ready.
+    for (size_t health_iters = 0;; ++health_iters) {
+      bool live, ready;
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerIsLive(server_, &live),
+          "unable to get server liveness");
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerIsReady(server_, &ready),
+          "unable to get server readiness");
+      if (live && ready) {
+        break;
+      }
+      if (health_iters >= 10) {
+        FAIL("failed to find healthy inference server");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    FAIL_IF_ERR(
+        TRITONSERVER_ResponseAllocatorNew(
+            &allocator_, tc::test::ResponseAlloc, tc::test::ResponseRelease,
+            nullptr /* start_fn */),
+        "creating response allocator");
+  }
+
+  TRITONSERVER_Server* server_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+};
+
+TRITONSERVER_InferenceRequest*
+NewRequest(const std::string& model_name, const std::vector<float>& input)
+{
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestNew(
+          &irequest, BenchmarkServer::Get()->Server(), model_name.c_str(),
+          -1 /* model_version */),
+      "creating inference request");
+  const int64_t shape[] = {1, static_cast<int64_t>(input.size())};
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestAddInput(
+          irequest, "INPUT0", TRITONSERVER_TYPE_FP32, shape, 2),
+      "adding input");
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestAppendInputData(
+          irequest, "INPUT0", input.data(), input.size() * sizeof(float),
+          TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */),
+      "appending input data");
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestAddRequestedOutput(irequest, "OUTPUT0"),
+      "adding requested output");
+  return irequest;
+}
+
+// Send 'irequest' with the response callback signaling 'completed'.
+void
+SendRequest(
+    TRITONSERVER_InferenceRequest* irequest, std::promise<void>* completed)
+{
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestSetReleaseCallback(
+          irequest, InferRequestComplete, nullptr /* request_release_userp */),
+      "setting request release callback");
+  FAIL_IF_ERR(
+      TRITONSERVER_InferenceRequestSetResponseCallback(
+          irequest, BenchmarkServer::Get()->Allocator(),
+          nullptr /* response_allocator_userp */, InferResponseComplete,
+          completed),
+      "setting response callback");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerInferAsync(
+          BenchmarkServer::Get()->Server(), irequest, nullptr /* trace */),
+      "running inference");
+}
+
+// Run synchronous inferences of 'model_name' with a new request for
+// each inference. With multiple threads the dynamic batcher forms
+// batches out of the concurrent requests. If 'distinct_inputs' is true
+// the input of each request differs from the inputs of the previous
+// requests.
+void
+RunInfer(
+    benchmark::State& state, const std::string& model_name,
+    const bool distinct_inputs = false)
+{
+  static std::atomic<uint64_t> next_input(0);
+  std::vector<float> input(kElementCount, 1.0f);
+  for (auto _ : state) {
+    if (distinct_inputs) {
+      const uint64_t value = next_input++;
+      input[0] = static_cast<float>(value & 0xffffff);
+      input[1] = static_cast<float>(value >> 24);
+    }
+    TRITONSERVER_InferenceRequest* irequest = NewRequest(model_name, input);
+    std::promise<void> completed;
+    SendRequest(irequest, &completed);
+    completed.get_future().get();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void
+BM_InferenceRequestNew(benchmark::State& state)
+{
+  std::vector<float> input(kElementCount, 1.0f);
+  for (auto _ : state) {
+    TRITONSERVER_InferenceRequest* irequest = NewRequest(kModel, input);
+    FAIL_IF_ERR(
+        TRITONSERVER_InferenceRequestDelete(irequest), "deleting request");
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InferenceRequestNew);
+
+void
+BM_Infer(benchmark::State& state)
+{
+  RunInfer(state, kModel);
+}
+BENCHMARK(BM_Infer)->ThreadRange(1, 16)->UseRealTime();
+
+// Every request hits the response cache after the first one.
+void
+BM_InferCacheHit(benchmark::State& state)
+{
+  RunInfer(state, kCacheModel);
+}
+BENCHMARK(BM_InferCacheHit)->ThreadRange(1, 16)->UseRealTime();
+
+// Every request misses the response cache and its response is inserted,
+// evicting the oldest entries once the cache is full.
+void
+BM_InferCacheInsert(benchmark::State& state)
+{
+  RunInfer(state, kCacheModel, true /* distinct_inputs */);
+}
+BENCHMARK(BM_InferCacheInsert)->ThreadRange(1, 16)->UseRealTime();
+
+// Send bursts of requests spread over the priority levels, so that the
+// priority queue of the dynamic batcher is filled and drained across
+// its levels.
+void
+BM_InferPriorityQueue(benchmark::State& state)
+{
+  const size_t burst_size = state.range(0);
+  std::vector<float> input(kElementCount, 1.0f);
+  for (auto _ : state) {
+    std::vector<std::promise<void>> completed(burst_size);
+    for (size_t idx = 0; idx < burst_size; ++idx) {
+      TRITONSERVER_InferenceRequest* irequest =
+          NewRequest(kPriorityModel, input);
+      FAIL_IF_ERR(
+          TRITONSERVER_InferenceRequestSetPriority(
+              irequest, (idx % kPriorityLevels) + 1),
+          "setting request priority");
+      SendRequest(irequest, &completed[idx]);
+    }
+    for (auto& burst_completed : completed) {
+      burst_completed.get_future().get();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * burst_size);
+}
+BENCHMARK(BM_InferPriorityQueue)
+    ->RangeMultiplier(8)
+    ->Range(8, 512)
+    ->UseRealTime();
+
+// The hash of the request inputs computed for every response cache
+// lookup and insertion.
+void
+BM_StreamingHash64(benchmark::State& state)
+{
+  std::vector<char> data(state.range(0), 'x');
+  for (auto _ : state) {
+    tc::StreamingHash64 hash;
+    hash.Update(data.data(), data.size());
+    benchmark::DoNotOptimize(hash.Digest());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_StreamingHash64)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+void
+BM_PinnedMemoryAllocFree(benchmark::State& state)
+{
+  static bool created = [] {
+    tc::PinnedMemoryManager::Options options(1 << 28 /* 256 MB */);
+    return tc::PinnedMemoryManager::Create(options).IsOk();
+  }();
+  if (!created) {
+    state.SkipWithError("failed to create pinned memory manager");
+    return;
+  }
+
+  for (auto _ : state) {
+    void* ptr = nullptr;
+    TRITONSERVER_MemoryType allocated_type;
+    auto status = tc::PinnedMemoryManager::Alloc(
+        &ptr, state.range(0), &allocated_type,
+        true /* allow_nonpinned_fallback */);
+    if (!status.IsOk()) {
+      state.SkipWithError(status.Message().c_str());
+      break;
+    }
+    tc::PinnedMemoryManager::Free(ptr);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PinnedMemoryAllocFree)
+    ->RangeMultiplier(16)
+    ->Range(64, 1 << 24)
+    ->ThreadRange(1, 8);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "cuda_graph_registry.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(CudaGraphRegistryTest, AddAndContains)
+{
+  tc::CudaGraphRegistry registry;
+  EXPECT_EQ(registry.Generation(), 0u);
+  EXPECT_FALSE(registry.Contains(4, "INPUT0:16"));
+
+  EXPECT_TRUE(registry.Add(4, "INPUT0:16"));
+  EXPECT_EQ(registry.Generation(), 1u);
+  EXPECT_TRUE(registry.Contains(4, "INPUT0:16"));
+
+  // The signature includes both the batch size and the shapes
+  EXPECT_FALSE(registry.Contains(8, "INPUT0:16"));
+  EXPECT_FALSE(registry.Contains(4, "INPUT0:32"));
+
+  // Recording a signature again doesn't change the generation
+  EXPECT_FALSE(registry.Add(4, "INPUT0:16"));
+  EXPECT_EQ(registry.Generation(), 1u);
+}
+
+TEST(CudaGraphRegistryTest, BatchSizes)
+{
+  tc::CudaGraphRegistry registry;
+  registry.Add(4, "INPUT0:16");
+  registry.Add(4, "INPUT0:32");
+  registry.Add(1, "INPUT0:16");
+  EXPECT_EQ(registry.Generation(), 3u);
+
+  // The batch sizes are added to the existing ones
+  std::set<int32_t> batch_sizes{8};
+  registry.BatchSizes(&batch_sizes);
+  EXPECT_EQ(batch_sizes, (std::set<int32_t>{1, 4, 8}));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
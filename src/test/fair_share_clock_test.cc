@@ -0,0 +1,173 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "fair_share_clock.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+// Items ordered by their tag, items of equal tags keep their arrival order
+// as in the scheduler queue.
+class TaggedQueue {
+ public:
+  explicit TaggedQueue(tc::FairShareClock* clock) : clock_(clock) {}
+
+  void Push(const std::string& tenant, const uint64_t cost = 1)
+  {
+    const uint64_t tag = clock_->Tag(tenant, cost);
+    const auto it = std::upper_bound(
+        items_.begin(), items_.end(), tag,
+        [](const uint64_t lhs, const std::pair<uint64_t, std::string>& rhs) {
+          return lhs < rhs.first;
+        });
+    items_.emplace(it, tag, tenant);
+  }
+
+  std::string Pop()
+  {
+    const auto item = items_.front();
+    items_.erase(items_.begin());
+    clock_->Serve(item.first);
+    return item.second;
+  }
+
+  bool Empty() const { return items_.empty(); }
+
+ private:
+  tc::FairShareClock* clock_;
+  std::vector<std::pair<uint64_t, std::string>> items_;
+};
+
+TEST(FairShareClockTest, InterleaveTenants)
+{
+  tc::FairShareClock clock;
+  TaggedQueue queue(&clock);
+  for (size_t idx = 0; idx < 100; ++idx) {
+    queue.Push("a");
+  }
+  for (size_t idx = 0; idx < 10; ++idx) {
+    queue.Push("b");
+  }
+
+  // The burst of 'a' doesn't delay the items of 'b'
+  size_t b_count = 0;
+  for (size_t idx = 0; idx < 20; ++idx) {
+    b_count += (queue.Pop() == "b") ? 1 : 0;
+  }
+  EXPECT_EQ(b_count, 10);
+  while (!queue.Empty()) {
+    EXPECT_EQ(queue.Pop(), "a");
+  }
+}
+
+TEST(FairShareClockTest, Weights)
+{
+  tc::FairShareClock clock;
+  clock.SetWeight("a", 3);
+  TaggedQueue queue(&clock);
+  for (size_t idx = 0; idx < 100; ++idx) {
+    queue.Push("a");
+    queue.Push("b");
+  }
+
+  size_t a_count = 0;
+  for (size_t idx = 0; idx < 40; ++idx) {
+    a_count += (queue.Pop() == "a") ? 1 : 0;
+  }
+  EXPECT_EQ(a_count, 30);
+}
+
+TEST(FairShareClockTest, Cost)
+{
+  tc::FairShareClock clock;
+  TaggedQueue queue(&clock);
+  for (size_t idx = 0; idx < 10; ++idx) {
+    queue.Push("a", 4 /* cost */);
+  }
+  for (size_t idx = 0; idx < 40; ++idx) {
+    queue.Push("b", 1 /* cost */);
+  }
+
+  // Each item of 'a' is worth four items of 'b'
+  size_t a_count = 0;
+  for (size_t idx = 0; idx < 25; ++idx) {
+    a_count += (queue.Pop() == "a") ? 1 : 0;
+  }
+  EXPECT_EQ(a_count, 5);
+}
+
+TEST(FairShareClockTest, IdleTenantHasNoCredit)
+{
+  tc::FairShareClock clock;
+  TaggedQueue queue(&clock);
+  for (size_t idx = 0; idx < 50; ++idx) {
+    queue.Push("a");
+  }
+  for (size_t idx = 0; idx < 40; ++idx) {
+    EXPECT_EQ(queue.Pop(), "a");
+  }
+
+  // 'b' starts from the virtual time instead of being ahead of all the
+  // remaining items of 'a'
+  for (size_t idx = 0; idx < 10; ++idx) {
+    queue.Push("b");
+  }
+  size_t b_count = 0;
+  for (size_t idx = 0; idx < 10; ++idx) {
+    b_count += (queue.Pop() == "b") ? 1 : 0;
+  }
+  EXPECT_EQ(b_count, 5);
+}
+
+TEST(FairShareClockTest, VirtualTimeIsMonotonic)
+{
+  tc::FairShareClock clock;
+  const uint64_t tag = clock.Tag("a", 1);
+  clock.Serve(clock.Tag("a", 1));
+  const uint64_t virtual_time = clock.VirtualTime();
+  EXPECT_GT(virtual_time, tag);
+  clock.Serve(tag);
+  EXPECT_EQ(clock.VirtualTime(), virtual_time);
+}
+
+TEST(FairShareClockTest, PruneIdleTenants)
+{
+  tc::FairShareClock clock;
+  TaggedQueue queue(&clock);
+  for (size_t idx = 0; idx < 1000; ++idx) {
+    queue.Push("tenant" + std::to_string(idx));
+    queue.Pop();
+  }
+  EXPECT_LE(clock.TenantCount(), 64);
+}
+
+}  // namespace
@@ -0,0 +1,112 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "hedge_policy.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kUs = 1000;
+
+TEST(HedgePolicyTest, NotStalledUntilObserved)
+{
+  tc::HedgePolicy policy(90, 100 * kUs);
+  for (size_t i = 0; i < 16; ++i) {
+    policy.RecordWait(10 * kUs);
+  }
+  EXPECT_FALSE(policy.IsStalled(1000 * 1000 * kUs));
+}
+
+TEST(HedgePolicyTest, Percentile)
+{
+  tc::HedgePolicy policy(90, 1);
+  // Waits of 1 to 100 us, the 90th percentile is 90 us
+  for (uint64_t i = 1; i <= 100; ++i) {
+    policy.RecordWait(i * kUs);
+  }
+  // The threshold is updated every 16 waits
+  for (uint64_t i = 1; i <= 12; ++i) {
+    policy.RecordWait(i * 50 * kUs / 6);
+  }
+  EXPECT_FALSE(policy.IsStalled(80 * kUs));
+  EXPECT_TRUE(policy.IsStalled(120 * kUs));
+}
+
+TEST(HedgePolicyTest, MinDelay)
+{
+  tc::HedgePolicy policy(50, 500 * kUs);
+  for (size_t i = 0; i < 64; ++i) {
+    policy.RecordWait(10 * kUs);
+  }
+  EXPECT_EQ(policy.ThresholdNs(), 500 * kUs);
+  EXPECT_FALSE(policy.IsStalled(400 * kUs));
+  EXPECT_TRUE(policy.IsStalled(600 * kUs));
+}
+
+TEST(HedgePolicyTest, RecentWaits)
+{
+  tc::HedgePolicy policy(50, 1);
+  for (size_t i = 0; i < 256; ++i) {
+    policy.RecordWait(1000 * kUs);
+  }
+  EXPECT_EQ(policy.ThresholdNs(), 1000 * kUs);
+
+  // The old waits leave the window
+  for (size_t i = 0; i < 256; ++i) {
+    policy.RecordWait(10 * kUs);
+  }
+  EXPECT_EQ(policy.ThresholdNs(), 10 * kUs);
+}
+
+TEST(HedgePolicyTest, StallDelay)
+{
+  tc::HedgePolicy policy(50, 100 * kUs);
+  const uint64_t scheduled_ns = 1000 * kUs;
+  // Until the threshold is known the payload is checked again after the
+  // minimum delay
+  EXPECT_EQ(policy.StallDelayNs(scheduled_ns, scheduled_ns), 100 * kUs);
+
+  for (size_t i = 0; i < 64; ++i) {
+    policy.RecordWait(200 * kUs);
+  }
+  ASSERT_EQ(policy.ThresholdNs(), 200 * kUs);
+  EXPECT_EQ(policy.StallDelayNs(scheduled_ns, scheduled_ns), 200 * kUs + 1);
+  EXPECT_EQ(
+      policy.StallDelayNs(scheduled_ns, scheduled_ns + 150 * kUs),
+      50 * kUs + 1);
+  EXPECT_EQ(policy.StallDelayNs(scheduled_ns, scheduled_ns + 200 * kUs), 1u);
+  EXPECT_EQ(
+      policy.StallDelayNs(scheduled_ns, scheduled_ns + 200 * kUs + 1), 0u)
+      << "Expect the payload is stalled past the threshold";
+  EXPECT_EQ(
+      policy.StallDelayNs(scheduled_ns, scheduled_ns - kUs), 200 * kUs + 1)
+      << "Expect a payload scheduled after now waited 0";
+}
+
+}  // namespace
@@ -0,0 +1,123 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <map>
+#include <random>
+#include "indexed_heap.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(IndexedHeapTest, PopInOrder)
+{
+  tc::IndexedHeap<int, double> heap;
+  EXPECT_TRUE(heap.Empty());
+  const double keys[] = {5.0, 1.0, 4.0, 2.0, 3.0, 0.5};
+  for (int i = 0; i < 6; ++i) {
+    heap.Push(i, keys[i]);
+  }
+  EXPECT_EQ(heap.Size(), 6u);
+  const int expected[] = {5, 1, 3, 4, 2, 0};
+  for (const int item : expected) {
+    ASSERT_FALSE(heap.Empty());
+    EXPECT_EQ(heap.Top(), item);
+    heap.Pop();
+  }
+  EXPECT_TRUE(heap.Empty());
+}
+
+TEST(IndexedHeapTest, UpdateAndRemove)
+{
+  tc::IndexedHeap<int, int, std::greater<int>> heap;
+  for (int i = 0; i < 10; ++i) {
+    heap.Push(i, i);
+  }
+  EXPECT_EQ(heap.Top(), 9);
+
+  // Decrease the top, increase a leaf
+  EXPECT_TRUE(heap.Update(9, -1));
+  EXPECT_EQ(heap.Top(), 8);
+  EXPECT_TRUE(heap.Update(0, 20));
+  EXPECT_EQ(heap.Top(), 0);
+
+  // Push of an existing item updates its key
+  heap.Push(3, 30);
+  EXPECT_EQ(heap.Size(), 10u);
+  EXPECT_EQ(heap.Top(), 3);
+
+  EXPECT_TRUE(heap.Remove(3));
+  EXPECT_FALSE(heap.Remove(3));
+  EXPECT_FALSE(heap.Contains(3));
+  EXPECT_FALSE(heap.Update(3, 0));
+  EXPECT_EQ(heap.Top(), 0);
+  EXPECT_EQ(heap.Size(), 9u);
+}
+
+TEST(IndexedHeapTest, Random)
+{
+  // Compare against a reference ordered by (key, item)
+  std::mt19937 rng(7);
+  tc::IndexedHeap<int, int> heap;
+  std::map<int, int> keys;
+  for (size_t step = 0; step < 20000; ++step) {
+    const int item = rng() % 200;
+    const int key = rng() % 1000;
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        heap.Push(item, key);
+        keys[item] = key;
+        break;
+      case 2:
+        EXPECT_EQ(heap.Remove(item), keys.erase(item) == 1);
+        break;
+      default:
+        if (!heap.Empty()) {
+          int min_key = heap.TopKey();
+          for (const auto& k : keys) {
+            min_key = std::min(min_key, k.second);
+          }
+          EXPECT_EQ(heap.TopKey(), min_key);
+          EXPECT_EQ(keys[heap.Top()], heap.TopKey());
+          keys.erase(heap.Top());
+          heap.Pop();
+        }
+        break;
+    }
+    ASSERT_EQ(heap.Size(), keys.size());
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
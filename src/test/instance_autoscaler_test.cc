@@ -0,0 +1,95 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "instance_autoscaler.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+using Decision = tc::InstanceAutoscaler::Decision;
+
+constexpr uint64_t kMs = 1000 * 1000;
+
+TEST(InstanceAutoscalerTest, ScaleUpOnSustainedDelay)
+{
+  tc::InstanceAutoscaler autoscaler(2, 10 * kMs, 0, 100 * kMs, 1000 * kMs);
+
+  // Pressure must hold for the sustain duration
+  EXPECT_EQ(autoscaler.Update(1 * kMs, 20 * kMs, 4, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(50 * kMs, 20 * kMs, 4, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(101 * kMs, 20 * kMs, 4, 0), Decision::SCALE_UP);
+
+  // The next instance requires another sustain duration
+  EXPECT_EQ(autoscaler.Update(150 * kMs, 20 * kMs, 4, 1), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(201 * kMs, 20 * kMs, 4, 1), Decision::SCALE_UP);
+
+  // Up to the maximum extra instances
+  EXPECT_EQ(autoscaler.Update(400 * kMs, 20 * kMs, 4, 2), Decision::NONE);
+}
+
+TEST(InstanceAutoscalerTest, PressureInterrupted)
+{
+  tc::InstanceAutoscaler autoscaler(2, 10 * kMs, 0, 100 * kMs, 1000 * kMs);
+  EXPECT_EQ(autoscaler.Update(1 * kMs, 20 * kMs, 4, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(50 * kMs, 5 * kMs, 4, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(101 * kMs, 20 * kMs, 4, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(201 * kMs, 20 * kMs, 4, 0), Decision::SCALE_UP);
+}
+
+TEST(InstanceAutoscalerTest, ScaleUpOnDepth)
+{
+  tc::InstanceAutoscaler autoscaler(1, 0, 16, 0, 1000 * kMs);
+  EXPECT_EQ(autoscaler.Update(1 * kMs, 1000 * kMs, 8, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(2 * kMs, 0, 16, 0), Decision::SCALE_UP);
+}
+
+TEST(InstanceAutoscalerTest, ScaleDownAfterCooldown)
+{
+  tc::InstanceAutoscaler autoscaler(2, 10 * kMs, 0, 100 * kMs, 1000 * kMs);
+
+  // Only the extra instances are retired
+  EXPECT_EQ(autoscaler.Update(1 * kMs, 0, 0, 0), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(2000 * kMs, 0, 0, 0), Decision::NONE);
+
+  // The queue must stay empty for the cooldown duration
+  EXPECT_EQ(autoscaler.Update(2500 * kMs, 0, 1, 2), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(2600 * kMs, 0, 0, 2), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(3000 * kMs, 0, 0, 2), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(3600 * kMs, 0, 0, 2), Decision::SCALE_DOWN);
+  EXPECT_EQ(autoscaler.Update(4000 * kMs, 0, 0, 1), Decision::NONE);
+  EXPECT_EQ(autoscaler.Update(4600 * kMs, 0, 0, 1), Decision::SCALE_DOWN);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
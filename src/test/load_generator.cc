@@ -0,0 +1,467 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// An in-process load generator driving the server through the
+// TRITONSERVER_InferenceRequest and TRITONSERVER_ServerInferAsync API
+// with a fixed number of concurrent requests, each completion issuing
+// the next request. Unless a model repository is given, a repository
+// holding a single model served by the null backend is generated from
+// the command line options, so that the overhead of the core can be
+// measured in isolation. The throughput and the latency quantiles of
+// the requests are reported at the end of the run.
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tool_utils.h"
+#include "triton/core/tritonserver.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+using tc::test::NowNs;
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-r <path> Model repository to use instead of generating one."
+            << std::endl;
+  std::cerr << "\t-m <name> Model to send the requests to. Default \"null\"."
+            << std::endl;
+  std::cerr << "\t-b <path> Backend directory. Default \"./backends\"."
+            << std::endl;
+  std::cerr << "\t-c <count> Concurrent requests. Default 64." << std::endl;
+  std::cerr << "\t-n <count> Measured requests. Default 100000." << std::endl;
+  std::cerr << "\t-w <count> Warmup requests. Default 1000." << std::endl;
+  std::cerr << "\t-s <count> FP32 elements of INPUT0. Default 16."
+            << std::endl;
+  std::cerr << "Options of the generated model:" << std::endl;
+  std::cerr << "\t-B <size> Max batch size, 0 disables batching and the batch "
+               "dimension of INPUT0. Default 8."
+            << std::endl;
+  std::cerr << "\t-d <us> Max queue delay of the dynamic batcher. Default 100."
+            << std::endl;
+  std::cerr << "\t-i <count> Model instances. Default 1." << std::endl;
+  std::cerr << "\t-e <us> Execution time of a batch. Default 0." << std::endl;
+  std::cerr << "\t-p <us> Execution time added per batch item. Default 0."
+            << std::endl;
+  std::cerr << "\t-D <count> Responses per request of a decoupled model, 0 "
+               "for a non-decoupled model. Default 0."
+            << std::endl;
+  std::cerr << "\t-S Spin instead of sleeping for the execution time."
+            << std::endl;
+
+  exit(1);
+}
+
+struct ModelOptions {
+  int max_batch_size_ = 8;
+  int max_queue_delay_us_ = 100;
+  int instance_count_ = 1;
+  int exec_time_us_ = 0;
+  int exec_time_per_item_us_ = 0;
+  int decoupled_response_count_ = 0;
+  bool busy_wait_ = false;
+};
+
+// Add the model "null" of 'options' to 'repository'.
+void
+AddModel(
+    tc::test::GeneratedRepository* repository, const ModelOptions& options)
+{
+  std::ostringstream config;
+  config << "name: \"null\"\n";
+  config << "backend: \"null\"\n";
+  config << "max_batch_size: " << options.max_batch_size_ << "\n";
+  config << "input [ { name: \"INPUT0\" data_type: TYPE_FP32 dims: [ -1 ] } "
+            "]\n";
+  config << "output [ { name: \"OUTPUT0\" data_type: TYPE_FP32 dims: [ -1 "
+            "] } ]\n";
+  if (options.max_batch_size_ > 0) {
+    config << "dynamic_batching { max_queue_delay_microseconds: "
+           << options.max_queue_delay_us_ << " }\n";
+  }
+  config << "instance_group [ { kind: KIND_CPU count: "
+         << options.instance_count_ << " } ]\n";
+  if (options.decoupled_response_count_ > 0) {
+    config << "model_transaction_policy { decoupled: true }\n";
+  }
+  tc::test::WriteParameter(&config, "exec_time_us", options.exec_time_us_);
+  tc::test::WriteParameter(
+      &config, "exec_time_per_item_us", options.exec_time_per_item_us_);
+  tc::test::WriteParameter(
+      &config, "response_count",
+      std::max(1, options.decoupled_response_count_));
+  tc::test::WriteParameter(
+      &config, "busy_wait", options.busy_wait_ ? "true" : "false");
+  repository->AddModel("null", config.str());
+}
+
+//
+// LoadContext
+//
+// The state of a run shared by all the in-flight requests.
+//
+struct LoadContext {
+  TRITONSERVER_Server* server_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+  std::string model_name_;
+  std::vector<float> input_;
+  std::vector<int64_t> shape_;
+
+  size_t warmup_count_;
+  size_t total_count_;
+  std::atomic<size_t> issued_count_{0};
+  std::atomic<size_t> completed_count_{0};
+  std::atomic<size_t> error_count_{0};
+  std::atomic<size_t> active_slot_count_{0};
+  std::atomic<uint64_t> measure_start_ns_{0};
+  std::atomic<uint64_t> last_completion_ns_{0};
+
+  // The latencies of the measured requests, in completion order.
+  std::vector<uint64_t> latencies_ns_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
+// A slot of the concurrency window, reissued on each completion.
+struct Slot {
+  LoadContext* ctx_;
+  uint64_t start_ns_;
+};
+
+void IssueNext(Slot* slot);
+
+void
+InferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  TRITONSERVER_InferenceRequestDelete(request);
+}
+
+void
+InferResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  Slot* slot = reinterpret_cast<Slot*>(userp);
+  LoadContext* ctx = slot->ctx_;
+  if (response != nullptr) {
+    TRITONSERVER_Error* err = TRITONSERVER_InferenceResponseError(response);
+    if (err != nullptr) {
+      if (ctx->error_count_++ == 0) {
+        std::cerr << "error: inference failed: "
+                  << TRITONSERVER_ErrorMessage(err) << std::endl;
+      }
+      TRITONSERVER_ErrorDelete(err);
+    }
+    TRITONSERVER_InferenceResponseDelete(response);
+  }
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) == 0) {
+    return;
+  }
+
+  const uint64_t now_ns = NowNs();
+  const size_t idx = ctx->completed_count_++;
+  if (idx + 1 == ctx->warmup_count_) {
+    ctx->measure_start_ns_ = now_ns;
+  } else if (idx >= ctx->warmup_count_) {
+    ctx->latencies_ns_[idx - ctx->warmup_count_] = now_ns - slot->start_ns_;
+    ctx->last_completion_ns_ = now_ns;
+  }
+  IssueNext(slot);
+}
+
+TRITONSERVER_Error*
+Issue(Slot* slot)
+{
+  LoadContext* ctx = slot->ctx_;
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  TRITONSERVER_Error* err = TRITONSERVER_InferenceRequestNew(
+      &irequest, ctx->server_, ctx->model_name_.c_str(),
+      -1 /* model_version */);
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestAddInput(
+        irequest, "INPUT0", TRITONSERVER_TYPE_FP32, ctx->shape_.data(),
+        ctx->shape_.size());
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestAppendInputData(
+        irequest, "INPUT0", ctx->input_.data(),
+        ctx->input_.size() * sizeof(float), TRITONSERVER_MEMORY_CPU,
+        0 /* memory_type_id */);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+        irequest, InferRequestComplete, nullptr /* request_release_userp */);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, ctx->allocator_, nullptr /* response_allocator_userp */,
+        InferResponseComplete, slot);
+  }
+  if (err == nullptr) {
+    slot->start_ns_ = NowNs();
+    err = TRITONSERVER_ServerInferAsync(
+        ctx->server_, irequest, nullptr /* trace */);
+  }
+  if ((err != nullptr) && (irequest != nullptr)) {
+    TRITONSERVER_InferenceRequestDelete(irequest);
+  }
+  return err;
+}
+
+// Issue the next request of 'slot', or retire the slot once all the
+// requests of the run are issued.
+void
+IssueNext(Slot* slot)
+{
+  LoadContext* ctx = slot->ctx_;
+  while (ctx->issued_count_++ < ctx->total_count_) {
+    TRITONSERVER_Error* err = Issue(slot);
+    if (err == nullptr) {
+      return;
+    }
+    if (ctx->error_count_++ == 0) {
+      std::cerr << "error: failed to issue request: "
+                << TRITONSERVER_ErrorMessage(err) << std::endl;
+    }
+    TRITONSERVER_ErrorDelete(err);
+  }
+
+  delete slot;
+  if (--ctx->active_slot_count_ == 0) {
+    std::lock_guard<std::mutex> lk(ctx->mu_);
+    ctx->cv_.notify_all();
+  }
+}
+
+void
+Report(LoadContext* ctx)
+{
+  // The requests that failed to be issued have no latency.
+  std::vector<uint64_t>& latencies = ctx->latencies_ns_;
+  if (ctx->completed_count_ <= ctx->warmup_count_) {
+    return;
+  }
+  latencies.resize(std::min(
+      latencies.size(), ctx->completed_count_ - ctx->warmup_count_));
+  const size_t count = latencies.size();
+  std::sort(latencies.begin(), latencies.end());
+  uint64_t sum_ns = 0;
+  for (const auto latency_ns : latencies) {
+    sum_ns += latency_ns;
+  }
+
+  const uint64_t start_ns = ctx->measure_start_ns_;
+  const uint64_t end_ns = ctx->last_completion_ns_;
+  const double duration_s =
+      (end_ns > start_ns) ? (end_ns - start_ns) / 1e9 : 0;
+  std::cout << "Requests: " << count << ", errors: " << ctx->error_count_
+            << std::endl;
+  if (duration_s > 0) {
+    std::cout << "Throughput: " << (count / duration_s) << " infer/sec"
+              << std::endl;
+  }
+  std::cout << "Latency (us): avg " << (sum_ns / count / 1000);
+  for (const double q : {0.5, 0.9, 0.95, 0.99, 0.999}) {
+    const size_t idx = std::min(count - 1, static_cast<size_t>(q * count));
+    std::cout << ", p" << (q * 100) << " " << (latencies[idx] / 1000);
+  }
+  std::cout << ", max " << (latencies.back() / 1000) << std::endl;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string repository_path;
+  std::string model_name;
+  std::string backend_dir("./backends");
+  int concurrency = 64;
+  int request_count = 100000;
+  int warmup_count = 1000;
+  int element_count = 16;
+  ModelOptions model_options;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:m:b:c:n:w:s:B:d:i:e:p:D:S")) != -1) {
+    switch (opt) {
+      case 'r':
+        repository_path = optarg;
+        break;
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'b':
+        backend_dir = optarg;
+        break;
+      case 'c':
+        concurrency = std::atoi(optarg);
+        break;
+      case 'n':
+        request_count = std::atoi(optarg);
+        break;
+      case 'w':
+        warmup_count = std::atoi(optarg);
+        break;
+      case 's':
+        element_count = std::atoi(optarg);
+        break;
+      case 'B':
+        model_options.max_batch_size_ = std::atoi(optarg);
+        break;
+      case 'd':
+        model_options.max_queue_delay_us_ = std::atoi(optarg);
+        break;
+      case 'i':
+        model_options.instance_count_ = std::atoi(optarg);
+        break;
+      case 'e':
+        model_options.exec_time_us_ = std::atoi(optarg);
+        break;
+      case 'p':
+        model_options.exec_time_per_item_us_ = std::atoi(optarg);
+        break;
+      case 'D':
+        model_options.decoupled_response_count_ = std::atoi(optarg);
+        break;
+      case 'S':
+        model_options.busy_wait_ = true;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+  if ((concurrency <= 0) || (request_count <= 0) || (warmup_count < 0) ||
+      (element_count <= 0)) {
+    Usage(argv, "-c, -n and -s must be positive and -w not negative");
+  }
+  if (repository_path.empty() && !model_name.empty() &&
+      (model_name != "null")) {
+    Usage(argv, "-m requires -r when the model repository is generated");
+  }
+
+  std::unique_ptr<tc::test::GeneratedRepository> generated;
+  if (repository_path.empty()) {
+    generated.reset(new tc::test::GeneratedRepository("null_repository"));
+    AddModel(generated.get(), model_options);
+    repository_path = generated->Path();
+  }
+  if (model_name.empty()) {
+    model_name = "null";
+  }
+
+  TRITONSERVER_ServerOptions* server_options = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsNew(&server_options),
+      "creating server options");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetModelRepositoryPath(
+          server_options, repository_path.c_str()),
+      "setting model repository path");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetBackendDirectory(
+          server_options, backend_dir.c_str()),
+      "setting backend directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetStrictModelConfig(server_options, true),
+      "setting strict model configuration");
+  TRITONSERVER_Server* server = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerNew(&server, server_options), "creating server");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsDelete(server_options),
+      "deleting server options");
+
+  bool ready = false;
+  for (size_t health_iters = 0; !ready; ++health_iters) {
+    FAIL_IF_ERR(
+        TRITONSERVER_ServerModelIsReady(
+            server, model_name.c_str(), -1 /* model_version */, &ready),
+        "unable to get model readiness");
+    if (!ready) {
+      if (health_iters >= 10) {
+        FAIL("model '" + model_name + "' is not ready");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+  }
+
+  LoadContext ctx;
+  ctx.server_ = server;
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &ctx.allocator_, tc::test::ResponseAlloc, tc::test::ResponseRelease,
+          nullptr /* start_fn */),
+      "creating response allocator");
+  ctx.model_name_ = model_name;
+  ctx.input_.assign(element_count, 1.0f);
+  if (model_options.max_batch_size_ > 0) {
+    ctx.shape_.push_back(1);
+  }
+  ctx.shape_.push_back(element_count);
+  ctx.warmup_count_ = warmup_count;
+  ctx.total_count_ = warmup_count + request_count;
+  ctx.latencies_ns_.resize(request_count);
+  if (warmup_count == 0) {
+    ctx.measure_start_ns_ = NowNs();
+  }
+
+  ctx.active_slot_count_ = concurrency;
+  for (int s = 0; s < concurrency; ++s) {
+    IssueNext(new Slot{&ctx, 0});
+  }
+  {
+    std::unique_lock<std::mutex> lk(ctx.mu_);
+    ctx.cv_.wait(lk, [&ctx] { return ctx.active_slot_count_ == 0; });
+  }
+
+  Report(&ctx);
+
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorDelete(ctx.allocator_),
+      "deleting response allocator");
+  FAIL_IF_ERR(TRITONSERVER_ServerDelete(server), "deleting server");
+  return (ctx.error_count_ == 0) ? 0 : 1;
+}
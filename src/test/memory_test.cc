@@ -26,8 +26,12 @@
 #include "gtest/gtest.h"
 
 #include <cuda_runtime_api.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
 #include "cuda_memory_manager.h"
 #include "cuda_utils.h"
+#include "host_memory.h"
 #include "memory.h"
 #include "pinned_memory_manager.h"
 
@@ -166,6 +170,38 @@ TEST_F(CudaMemoryManagerTest, MultipleAlloc)
   CHECK_POINTER_ATTRIBUTES(second_ptr, cudaMemoryTypeDevice, 0);
 }
 
+TEST_F(CudaMemoryManagerTest, StreamOrderedAlloc)
+{
+  // The pool size is only the release threshold, allocations larger than
+  // it succeed
+  options_.stream_ordered_ = true;
+  auto status = tc::CudaMemoryManager::Create(options_);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+
+  void* first_ptr = nullptr;
+  status = tc::CudaMemoryManager::Alloc(&first_ptr, 2048, 0);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  CHECK_POINTER_ATTRIBUTES(first_ptr, cudaMemoryTypeDevice, 0);
+
+  // Allocate and free on a stream without synchronizing
+  cudaStream_t stream;
+  ASSERT_TRUE(cudaStreamCreate(&stream) == cudaSuccess);
+  void* second_ptr = nullptr;
+  status = tc::CudaMemoryManager::Alloc(&second_ptr, 2048, 0, stream);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(
+      cudaMemcpyAsync(
+          second_ptr, first_ptr, 2048, cudaMemcpyDeviceToDevice, stream) ==
+      cudaSuccess);
+  status = tc::CudaMemoryManager::Free(second_ptr, 0, stream);
+  EXPECT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(cudaStreamSynchronize(stream) == cudaSuccess);
+  ASSERT_TRUE(cudaStreamDestroy(stream) == cudaSuccess);
+
+  status = tc::CudaMemoryManager::Free(first_ptr, 0);
+  EXPECT_TRUE(status.IsOk()) << status.Message();
+}
+
 TEST_F(CudaMemoryManagerTest, MultipleDevice)
 {
   std::set<int> supported_gpus;
@@ -392,6 +428,87 @@ TEST_F(AllocatedMemoryTest, Release)
   CHECK_POINTER_ATTRIBUTES(ptr, cudaMemoryTypeDevice, expect_id);
 }
 
+class HostMemoryTest : public ::testing::Test {
+ protected:
+  void TearDown() override { tc::SetHugePageThreshold(0); }
+
+  // Return the throughput in GB/s of copying 'byte_size' bytes between
+  // two buffers allocated by HostAlloc() with the current threshold.
+  double CopyThroughput(size_t byte_size, size_t iterations)
+  {
+    char* src = reinterpret_cast<char*>(tc::HostAlloc(byte_size));
+    char* dst = reinterpret_cast<char*>(tc::HostAlloc(byte_size));
+    EXPECT_NE(src, nullptr);
+    EXPECT_NE(dst, nullptr);
+    if ((src == nullptr) || (dst == nullptr)) {
+      free(src);
+      free(dst);
+      return 0;
+    }
+
+    // Touch the buffers so that page faults are not measured
+    memset(src, 1, byte_size);
+    memset(dst, 0, byte_size);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      memcpy(dst, src, byte_size);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(memcmp(src, dst, byte_size), 0);
+
+    free(src);
+    free(dst);
+    return (byte_size * iterations) / elapsed.count() / (1 << 30);
+  }
+};
+
+TEST_F(HostMemoryTest, AllocBelowThreshold)
+{
+  tc::SetHugePageThreshold(1 << 20);
+  EXPECT_EQ(tc::HugePageThreshold(), 1 << 20);
+
+  void* ptr = tc::HostAlloc(1024);
+  ASSERT_NE(ptr, nullptr);
+  memset(ptr, 0, 1024);
+  free(ptr);
+}
+
+TEST_F(HostMemoryTest, AllocHugePages)
+{
+  // The allocation is rounded up to whole huge pages
+  const size_t huge_page_byte_size = 2 * 1024 * 1024;
+  const size_t byte_size = 3 * 1024 * 1024;
+  tc::SetHugePageThreshold(1 << 20);
+
+  void* ptr = tc::HostAlloc(byte_size);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % huge_page_byte_size, 0)
+      << "Expect allocation aligned to huge page, got: " << ptr;
+  memset(ptr, 0, 2 * huge_page_byte_size);
+  free(ptr);
+}
+
+TEST_F(HostMemoryTest, CopyThroughput)
+{
+  // Report the copy throughput of large buffers with and without huge
+  // pages, the difference depends on the system so only sanity check it.
+  const size_t byte_size = 64 * 1024 * 1024;
+  const size_t iterations = 16;
+
+  tc::SetHugePageThreshold(0);
+  const double regular_throughput = CopyThroughput(byte_size, iterations);
+  tc::SetHugePageThreshold(byte_size);
+  const double huge_page_throughput = CopyThroughput(byte_size, iterations);
+
+  std::cout << "Copy throughput of " << byte_size << " bytes buffers: "
+            << regular_throughput << " GB/s with regular pages, "
+            << huge_page_throughput << " GB/s with huge pages" << std::endl;
+  EXPECT_GT(regular_throughput, 0);
+  EXPECT_GT(huge_page_throughput, 0);
+}
+
 }  // namespace
 
 int
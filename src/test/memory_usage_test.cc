@@ -0,0 +1,124 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+#include "memory_usage.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(MemoryUsageTrackerTest, AllocateAndFree)
+{
+  tc::MemoryUsageTracker tracker;
+  char buffers[3];
+
+  tracker.RecordAllocation(&buffers[0], TRITONSERVER_MEMORY_CPU, 100);
+  tracker.RecordAllocation(&buffers[1], TRITONSERVER_MEMORY_CPU, 50);
+  tracker.RecordAllocation(&buffers[2], TRITONSERVER_MEMORY_GPU, 1000);
+
+  auto cpu = tracker.GetStats(TRITONSERVER_MEMORY_CPU);
+  EXPECT_EQ(cpu.byte_size_, 150u);
+  EXPECT_EQ(cpu.peak_byte_size_, 150u);
+  EXPECT_EQ(cpu.allocation_count_, 2u);
+
+  tracker.RecordFree(&buffers[0]);
+  tracker.RecordAllocation(&buffers[0], TRITONSERVER_MEMORY_CPU, 20);
+  cpu = tracker.GetStats(TRITONSERVER_MEMORY_CPU);
+  EXPECT_EQ(cpu.byte_size_, 70u);
+  EXPECT_EQ(cpu.peak_byte_size_, 150u) << "Expect the peak to be retained";
+  EXPECT_EQ(cpu.allocation_count_, 3u);
+
+  auto gpu = tracker.GetStats(TRITONSERVER_MEMORY_GPU);
+  EXPECT_EQ(gpu.byte_size_, 1000u);
+  tracker.RecordFree(&buffers[2]);
+  gpu = tracker.GetStats(TRITONSERVER_MEMORY_GPU);
+  EXPECT_EQ(gpu.byte_size_, 0u);
+  EXPECT_EQ(gpu.peak_byte_size_, 1000u);
+
+  const auto pinned = tracker.GetStats(TRITONSERVER_MEMORY_CPU_PINNED);
+  EXPECT_EQ(pinned.byte_size_, 0u);
+  EXPECT_EQ(pinned.allocation_count_, 0u);
+}
+
+TEST(MemoryUsageTrackerTest, UnknownBuffer)
+{
+  tc::MemoryUsageTracker tracker;
+  char buffers[2];
+
+  tracker.RecordAllocation(&buffers[0], TRITONSERVER_MEMORY_CPU, 10);
+  tracker.RecordFree(&buffers[1]);
+  tracker.RecordFree(nullptr);
+  EXPECT_EQ(tracker.GetStats(TRITONSERVER_MEMORY_CPU).byte_size_, 10u);
+
+  // A buffer is only accounted once
+  tracker.RecordFree(&buffers[0]);
+  tracker.RecordFree(&buffers[0]);
+  EXPECT_EQ(tracker.GetStats(TRITONSERVER_MEMORY_CPU).byte_size_, 0u);
+}
+
+TEST(MemoryUsageTrackerTest, Concurrent)
+{
+  constexpr size_t kThreadCount = 4;
+  constexpr size_t kAllocationCount = 1000;
+  tc::MemoryUsageTracker tracker;
+  std::vector<std::vector<char>> buffers(
+      kThreadCount, std::vector<char>(kAllocationCount));
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&tracker, &buffers, t]() {
+      for (size_t idx = 0; idx < kAllocationCount; ++idx) {
+        tracker.RecordAllocation(
+            &buffers[t][idx], TRITONSERVER_MEMORY_CPU_PINNED, 8);
+      }
+      for (size_t idx = 0; idx < kAllocationCount; ++idx) {
+        tracker.RecordFree(&buffers[t][idx]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const auto stats = tracker.GetStats(TRITONSERVER_MEMORY_CPU_PINNED);
+  EXPECT_EQ(stats.byte_size_, 0u);
+  EXPECT_EQ(stats.allocation_count_, kThreadCount * kAllocationCount);
+  EXPECT_GE(stats.peak_byte_size_, kAllocationCount * 8);
+  EXPECT_LE(stats.peak_byte_size_, kThreadCount * kAllocationCount * 8);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
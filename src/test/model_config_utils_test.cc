@@ -0,0 +1,96 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <string>
+#include "model_config.pb.h"
+#include "model_config_utils.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr char kParameter[] = "param";
+
+inference::ModelConfig
+ConfigWithParameter(const std::string& value)
+{
+  inference::ModelConfig config;
+  config.set_name("model");
+  (*config.mutable_parameters())[kParameter].set_string_value(value);
+  return config;
+}
+
+TEST(GetUnsignedParameterTest, Value)
+{
+  uint64_t value = 0;
+  ASSERT_TRUE(tc::GetUnsignedParameter(
+                  ConfigWithParameter("42"), kParameter, 7, &value)
+                  .IsOk());
+  EXPECT_EQ(value, 42);
+  ASSERT_TRUE(tc::GetUnsignedParameter(
+                  ConfigWithParameter("18446744073709551615"), kParameter, 7,
+                  &value)
+                  .IsOk());
+  EXPECT_EQ(value, UINT64_MAX);
+}
+
+TEST(GetUnsignedParameterTest, Default)
+{
+  uint64_t value = 0;
+  ASSERT_TRUE(
+      tc::GetUnsignedParameter(inference::ModelConfig(), kParameter, 7, &value)
+          .IsOk());
+  EXPECT_EQ(value, 7);
+}
+
+TEST(GetUnsignedParameterTest, Invalid)
+{
+  // Whitespace, signs, an empty value, trailing characters and values out
+  // of range are all rejected.
+  for (const auto& str :
+       {" 5", " -5", "-5", "+5", "", "5 ", "5x", "0x10",
+        "18446744073709551616"}) {
+    uint64_t value = 0;
+    const tc::Status status = tc::GetUnsignedParameter(
+        ConfigWithParameter(str), kParameter, 7, &value);
+    EXPECT_EQ(status.StatusCode(), tc::Status::Code::INVALID_ARG)
+        << "value '" << str << "'";
+    EXPECT_NE(
+        status.Message().find("must be a non-negative integer"),
+        std::string::npos)
+        << status.Message();
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "mpmc_queue.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(MPMCQueueTest, FullAndEmpty)
+{
+  tc::MPMCQueue<int> queue(3);
+  EXPECT_EQ(queue.Capacity(), 4u);
+  int value = 0;
+  EXPECT_FALSE(queue.Pop(&value));
+  for (int i = 0; i < 4; ++i) {
+    value = i;
+    EXPECT_TRUE(queue.Push(value)) << "Expect push " << i << " to succeed";
+  }
+  value = 4;
+  EXPECT_FALSE(queue.Push(value)) << "Expect push to fail when queue is full";
+  EXPECT_EQ(value, 4);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(value, i) << "Expect values in FIFO order";
+  }
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(MPMCQueueTest, MoveOnlyValue)
+{
+  tc::MPMCQueue<std::unique_ptr<int>> queue(2);
+  std::unique_ptr<int> value(new int(7));
+  EXPECT_TRUE(queue.Push(value));
+  EXPECT_EQ(value, nullptr);
+
+  std::unique_ptr<int> popped;
+  EXPECT_TRUE(queue.Pop(&popped));
+  ASSERT_NE(popped, nullptr);
+  EXPECT_EQ(*popped, 7);
+}
+
+TEST(MPMCQueueTest, MultipleProducersAndConsumers)
+{
+  const size_t thread_count = 4;
+  const size_t value_count = 10000;
+  tc::MPMCQueue<size_t> queue(64);
+
+  // Every value must be popped exactly once
+  std::vector<std::atomic<size_t>> seen(thread_count * value_count);
+  for (auto& s : seen) {
+    s.store(0);
+  }
+  std::atomic<size_t> total(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&queue, t, value_count]() {
+      for (size_t i = 0; i < value_count; ++i) {
+        size_t value = (t * value_count) + i;
+        while (!queue.Push(value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&queue, &seen, &total, thread_count, value_count]() {
+      while (total.load() < (thread_count * value_count)) {
+        size_t value;
+        if (!queue.Pop(&value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        seen[value]++;
+        total++;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t idx = 0; idx < seen.size(); ++idx) {
+    EXPECT_EQ(seen[idx].load(), 1u) << "Unexpected count for value " << idx;
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
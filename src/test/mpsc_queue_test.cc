@@ -0,0 +1,131 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include "mpsc_queue.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(MPSCQueueTest, CapacityRoundedUp)
+{
+  tc::MPSCQueue<int> queue(100);
+  EXPECT_EQ(queue.Capacity(), 128u);
+}
+
+TEST(MPSCQueueTest, FullAndEmpty)
+{
+  tc::MPSCQueue<int> queue(4);
+  int value = 0;
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Pop(&value));
+  for (int i = 0; i < 4; ++i) {
+    value = i;
+    EXPECT_TRUE(queue.Push(value)) << "Expect push " << i << " to succeed";
+  }
+  value = 4;
+  EXPECT_FALSE(queue.Push(value)) << "Expect push to fail when queue is full";
+  EXPECT_EQ(value, 4);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_FALSE(queue.Empty());
+    EXPECT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(value, i) << "Expect values in FIFO order";
+  }
+  EXPECT_TRUE(queue.Empty());
+
+  // Positions wrap around the ring
+  value = 5;
+  EXPECT_TRUE(queue.Push(value));
+  EXPECT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 5);
+}
+
+TEST(MPSCQueueTest, MoveOnlyValue)
+{
+  tc::MPSCQueue<std::unique_ptr<int>> queue(2);
+  std::unique_ptr<int> value(new int(7));
+  EXPECT_TRUE(queue.Push(value));
+  EXPECT_EQ(value, nullptr);
+
+  std::unique_ptr<int> popped;
+  EXPECT_TRUE(queue.Pop(&popped));
+  ASSERT_NE(popped, nullptr);
+  EXPECT_EQ(*popped, 7);
+}
+
+TEST(MPSCQueueTest, MultipleProducers)
+{
+  const size_t producer_count = 4;
+  const size_t value_count = 10000;
+  tc::MPSCQueue<size_t> queue(64);
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < producer_count; ++p) {
+    producers.emplace_back([&queue, p, value_count]() {
+      for (size_t i = 0; i < value_count; ++i) {
+        size_t value = (p * value_count) + i;
+        while (!queue.Push(value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Values from the same producer must be popped in the order they are
+  // pushed, and every value must be seen exactly once
+  std::vector<size_t> next(producer_count, 0);
+  size_t total = 0;
+  while (total < (producer_count * value_count)) {
+    size_t value;
+    if (!queue.Pop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const size_t p = value / value_count;
+    ASSERT_LT(p, producer_count);
+    EXPECT_EQ(value % value_count, next[p]);
+    next[p] = (value % value_count) + 1;
+    ++total;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
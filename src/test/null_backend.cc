@@ -0,0 +1,393 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A backend that does no computation, used to measure the overhead of
+// the core in isolation. The first input of each request is returned as
+// OUTPUT0 after the simulated execution time of the batch elapsed. The
+// behavior is configured by the model configuration parameters:
+//
+//   exec_time_us: The fixed execution time of a batch. Default 0.
+//   exec_time_per_item_us: The execution time added for each item of the
+//     batch, the batch size being the sum of the batch size of the
+//     requests. Default 0.
+//   busy_wait: If "true", spin instead of sleeping for the execution time
+//     for better accuracy with short execution times. Default "false".
+//   response_count: The number of responses sent for each request when
+//     the model is decoupled. Default 1.
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include "triton/core/tritonbackend.h"
+
+#define TRITONJSON_STATUSTYPE TRITONSERVER_Error*
+#define TRITONJSON_STATUSRETURN(M) \
+  return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, (M).c_str())
+#define TRITONJSON_STATUSSUCCESS nullptr
+#include "triton/common/triton_json.h"
+
+namespace triton { namespace backend { namespace null {
+
+#define RETURN_IF_ERR(X)             \
+  do {                               \
+    TRITONSERVER_Error* err__ = (X); \
+    if (err__ != nullptr) {          \
+      return err__;                  \
+    }                                \
+  } while (false)
+
+namespace {
+
+uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Read the unsigned integer parameter 'name' of the model configuration
+// if it is specified.
+TRITONSERVER_Error*
+ParameterAsUInt(
+    common::TritonJson::Value& parameters, const char* name, uint64_t* value)
+{
+  common::TritonJson::Value parameter;
+  if (parameters.Find(name, &parameter)) {
+    std::string str;
+    RETURN_IF_ERR(parameter.MemberAsString("string_value", &str));
+    try {
+      *value = std::stoull(str);
+    }
+    catch (const std::exception& ex) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          (std::string("failed to parse parameter '") + name + "': " +
+           ex.what())
+              .c_str());
+    }
+  }
+  return nullptr;  // Success
+}
+
+}  // namespace
+
+//
+// ModelState
+//
+// The configuration of the simulated execution of a model.
+//
+struct ModelState {
+  ModelState()
+      : max_batch_size_(0), decoupled_(false), exec_time_us_(0),
+        exec_time_per_item_us_(0), busy_wait_(false), response_count_(1)
+  {
+  }
+
+  TRITONSERVER_Error* Init(TRITONBACKEND_Model* model);
+
+  // Return the simulated execution time of a batch of 'batch_size'.
+  uint64_t ExecTimeNs(const uint64_t batch_size) const
+  {
+    return (exec_time_us_ + exec_time_per_item_us_ * batch_size) * 1000;
+  }
+
+  int64_t max_batch_size_;
+  bool decoupled_;
+  uint64_t exec_time_us_;
+  uint64_t exec_time_per_item_us_;
+  bool busy_wait_;
+  uint64_t response_count_;
+};
+
+TRITONSERVER_Error*
+ModelState::Init(TRITONBACKEND_Model* model)
+{
+  TRITONSERVER_Message* message;
+  RETURN_IF_ERR(TRITONBACKEND_ModelConfig(model, 1 /* version */, &message));
+  const char* buffer;
+  size_t byte_size;
+  TRITONSERVER_Error* err =
+      TRITONSERVER_MessageSerializeToJson(message, &buffer, &byte_size);
+  common::TritonJson::Value config;
+  if (err == nullptr) {
+    err = config.Parse(buffer, byte_size);
+  }
+  TRITONSERVER_MessageDelete(message);
+  RETURN_IF_ERR(err);
+
+  if (config.Find("max_batch_size")) {
+    RETURN_IF_ERR(config.MemberAsInt("max_batch_size", &max_batch_size_));
+  }
+  common::TritonJson::Value policy;
+  if (config.Find("model_transaction_policy", &policy) &&
+      policy.Find("decoupled")) {
+    RETURN_IF_ERR(policy.MemberAsBool("decoupled", &decoupled_));
+  }
+
+  common::TritonJson::Value parameters;
+  if (config.Find("parameters", &parameters)) {
+    RETURN_IF_ERR(ParameterAsUInt(parameters, "exec_time_us", &exec_time_us_));
+    RETURN_IF_ERR(ParameterAsUInt(
+        parameters, "exec_time_per_item_us", &exec_time_per_item_us_));
+    RETURN_IF_ERR(
+        ParameterAsUInt(parameters, "response_count", &response_count_));
+    common::TritonJson::Value parameter;
+    if (parameters.Find("busy_wait", &parameter)) {
+      std::string str;
+      RETURN_IF_ERR(parameter.MemberAsString("string_value", &str));
+      busy_wait_ = (str == "true");
+    }
+  }
+
+  return nullptr;  // Success
+}
+
+namespace {
+
+// Create a response of 'request' with OUTPUT0 holding a copy of 'input'.
+TRITONSERVER_Error*
+FillResponse(TRITONBACKEND_Response* response, TRITONBACKEND_Input* input)
+{
+  const char* name;
+  TRITONSERVER_DataType datatype;
+  const int64_t* shape;
+  uint32_t dims_count;
+  uint64_t byte_size;
+  uint32_t buffer_count;
+  RETURN_IF_ERR(TRITONBACKEND_InputProperties(
+      input, &name, &datatype, &shape, &dims_count, &byte_size,
+      &buffer_count));
+
+  TRITONBACKEND_Output* output;
+  RETURN_IF_ERR(TRITONBACKEND_ResponseOutput(
+      response, &output, "OUTPUT0", datatype, shape, dims_count));
+  void* obuffer;
+  TRITONSERVER_MemoryType memory_type = TRITONSERVER_MEMORY_CPU;
+  int64_t memory_type_id = 0;
+  RETURN_IF_ERR(TRITONBACKEND_OutputBuffer(
+      output, &obuffer, byte_size, &memory_type, &memory_type_id));
+  if ((byte_size > 0) && (memory_type == TRITONSERVER_MEMORY_GPU)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        "null backend does not support GPU output buffers");
+  }
+
+  uint64_t offset = 0;
+  for (uint32_t idx = 0; idx < buffer_count; ++idx) {
+    const void* ibuffer;
+    uint64_t ibuffer_byte_size;
+    RETURN_IF_ERR(TRITONBACKEND_InputBuffer(
+        input, idx, &ibuffer, &ibuffer_byte_size, &memory_type,
+        &memory_type_id));
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_UNSUPPORTED,
+          "null backend does not support GPU input buffers");
+    }
+    memcpy(
+        reinterpret_cast<char*>(obuffer) + offset, ibuffer, ibuffer_byte_size);
+    offset += ibuffer_byte_size;
+  }
+  return nullptr;  // Success
+}
+
+// Send the responses of 'request'. Return the error the request failed
+// with, 'responded' returns whether the final response was sent.
+TRITONSERVER_Error*
+Respond(
+    const ModelState& state, TRITONBACKEND_Request* request, bool* responded)
+{
+  *responded = false;
+  TRITONBACKEND_Input* input;
+  RETURN_IF_ERR(TRITONBACKEND_RequestInputByIndex(request, 0, &input));
+
+  if (!state.decoupled_) {
+    TRITONBACKEND_Response* response;
+    RETURN_IF_ERR(TRITONBACKEND_ResponseNew(&response, request));
+    // The response is sent with the error of filling it, which is still
+    // owned here.
+    TRITONSERVER_Error* err = FillResponse(response, input);
+    TRITONSERVER_Error* send_err = TRITONBACKEND_ResponseSend(
+        response, TRITONSERVER_RESPONSE_COMPLETE_FINAL, err);
+    if (send_err != nullptr) {
+      TRITONSERVER_ErrorDelete(err);
+      return send_err;
+    }
+    *responded = true;
+    return err;
+  }
+
+  TRITONBACKEND_ResponseFactory* factory;
+  RETURN_IF_ERR(TRITONBACKEND_ResponseFactoryNew(&factory, request));
+  std::unique_ptr<
+      TRITONBACKEND_ResponseFactory,
+      decltype(&TRITONBACKEND_ResponseFactoryDelete)>
+      factory_guard(factory, TRITONBACKEND_ResponseFactoryDelete);
+  for (uint64_t idx = 0; idx < state.response_count_; ++idx) {
+    TRITONBACKEND_Response* response;
+    RETURN_IF_ERR(TRITONBACKEND_ResponseNewFromFactory(&response, factory));
+    // A response that can't be filled is the final one.
+    TRITONSERVER_Error* err = FillResponse(response, input);
+    TRITONSERVER_Error* send_err = TRITONBACKEND_ResponseSend(
+        response, (err == nullptr) ? 0 : TRITONSERVER_RESPONSE_COMPLETE_FINAL,
+        err);
+    if (send_err != nullptr) {
+      TRITONSERVER_ErrorDelete(err);
+      return send_err;
+    }
+    if (err != nullptr) {
+      *responded = true;
+      return err;
+    }
+  }
+  RETURN_IF_ERR(TRITONBACKEND_ResponseFactorySendFlags(
+      factory, TRITONSERVER_RESPONSE_COMPLETE_FINAL));
+  *responded = true;
+  return nullptr;  // Success
+}
+
+// Return the batch size of 'request'.
+uint64_t
+RequestBatchSize(const ModelState& state, TRITONBACKEND_Request* request)
+{
+  if (state.max_batch_size_ == 0) {
+    return 1;
+  }
+  TRITONBACKEND_Input* input;
+  TRITONSERVER_Error* err =
+      TRITONBACKEND_RequestInputByIndex(request, 0, &input);
+  if (err != nullptr) {
+    // The request is failed when responding.
+    TRITONSERVER_ErrorDelete(err);
+    return 1;
+  }
+  const int64_t* shape;
+  uint32_t dims_count;
+  TRITONBACKEND_InputProperties(
+      input, nullptr, nullptr, &shape, &dims_count, nullptr, nullptr);
+  return (dims_count == 0) ? 1 : shape[0];
+}
+
+}  // namespace
+
+extern "C" {
+
+TRITONSERVER_Error*
+TRITONBACKEND_Initialize(TRITONBACKEND_Backend* backend)
+{
+  uint32_t api_version_major, api_version_minor;
+  RETURN_IF_ERR(
+      TRITONBACKEND_ApiVersion(&api_version_major, &api_version_minor));
+  if ((api_version_major != TRITONBACKEND_API_VERSION_MAJOR) ||
+      (api_version_minor < TRITONBACKEND_API_VERSION_MINOR)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_UNSUPPORTED,
+        "triton backend API version does not support this backend");
+  }
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInitialize(TRITONBACKEND_Model* model)
+{
+  std::unique_ptr<ModelState> state(new ModelState());
+  RETURN_IF_ERR(state->Init(model));
+  RETURN_IF_ERR(
+      TRITONBACKEND_ModelSetState(model, reinterpret_cast<void*>(state.get())));
+  state.release();
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelFinalize(TRITONBACKEND_Model* model)
+{
+  void* vstate;
+  RETURN_IF_ERR(TRITONBACKEND_ModelState(model, &vstate));
+  delete reinterpret_cast<ModelState*>(vstate);
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONBACKEND_ModelInstanceExecute(
+    TRITONBACKEND_ModelInstance* instance, TRITONBACKEND_Request** requests,
+    const uint32_t request_count)
+{
+  TRITONBACKEND_Model* model;
+  RETURN_IF_ERR(TRITONBACKEND_ModelInstanceModel(instance, &model));
+  void* vstate;
+  RETURN_IF_ERR(TRITONBACKEND_ModelState(model, &vstate));
+  const ModelState& state = *reinterpret_cast<ModelState*>(vstate);
+
+  const uint64_t exec_start_ns = NowNs();
+  uint64_t batch_size = 0;
+  for (uint32_t r = 0; r < request_count; ++r) {
+    batch_size += RequestBatchSize(state, requests[r]);
+  }
+
+  // Simulate the execution of the batch.
+  const uint64_t exec_time_ns = state.ExecTimeNs(batch_size);
+  if (exec_time_ns > 0) {
+    if (state.busy_wait_) {
+      while ((NowNs() - exec_start_ns) < exec_time_ns) {
+      }
+    } else {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(exec_time_ns));
+    }
+  }
+  const uint64_t compute_end_ns = NowNs();
+
+  for (uint32_t r = 0; r < request_count; ++r) {
+    TRITONBACKEND_Request* request = requests[r];
+    bool responded;
+    TRITONSERVER_Error* err = Respond(state, request, &responded);
+    if ((err != nullptr) && !responded) {
+      TRITONBACKEND_Response* response;
+      TRITONSERVER_Error* new_err =
+          TRITONBACKEND_ResponseNew(&response, request);
+      if (new_err == nullptr) {
+        new_err = TRITONBACKEND_ResponseSend(
+            response, TRITONSERVER_RESPONSE_COMPLETE_FINAL, err);
+      }
+      TRITONSERVER_ErrorDelete(new_err);
+    }
+    TRITONBACKEND_ModelInstanceReportStatistics(
+        instance, request, (err == nullptr), exec_start_ns, exec_start_ns,
+        compute_end_ns, NowNs());
+    TRITONSERVER_ErrorDelete(err);
+    TRITONBACKEND_RequestRelease(request, TRITONSERVER_REQUEST_RELEASE_ALL);
+  }
+
+  TRITONBACKEND_ModelInstanceReportBatchStatistics(
+      instance, batch_size, exec_start_ns, exec_start_ns, compute_end_ns,
+      NowNs());
+  return nullptr;  // Success
+}
+
+}  // extern "C"
+
+}}}  // namespace triton::backend::null
@@ -0,0 +1,160 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "object_freelist.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+struct Object {
+  int value_ = 0;
+};
+
+TEST(SharedObjectFreelistTest, Empty)
+{
+  tc::SharedObjectFreelist<Object> freelist(4);
+  std::shared_ptr<Object> object;
+  EXPECT_FALSE(freelist.Get(&object));
+  EXPECT_EQ(object, nullptr);
+}
+
+TEST(SharedObjectFreelistTest, Disabled)
+{
+  tc::SharedObjectFreelist<Object> freelist(0);
+  std::shared_ptr<Object> object = std::make_shared<Object>();
+  freelist.Put(object);
+  EXPECT_NE(object, nullptr) << "Expect object to be kept by the caller";
+  std::shared_ptr<Object> reused;
+  EXPECT_FALSE(freelist.Get(&reused));
+}
+
+TEST(SharedObjectFreelistTest, ReuseUnreferenced)
+{
+  tc::SharedObjectFreelist<Object> freelist(4);
+  std::shared_ptr<Object> object = std::make_shared<Object>();
+  Object* raw = object.get();
+  freelist.Put(object);
+  EXPECT_EQ(object, nullptr) << "Expect object to be moved to the freelist";
+
+  std::shared_ptr<Object> reused;
+  ASSERT_TRUE(freelist.Get(&reused));
+  EXPECT_EQ(reused.get(), raw);
+  EXPECT_FALSE(freelist.Get(&reused)) << "Expect freelist to be empty";
+}
+
+TEST(SharedObjectFreelistTest, SkipReferenced)
+{
+  tc::SharedObjectFreelist<Object> freelist(4);
+  std::shared_ptr<Object> object = std::make_shared<Object>();
+  std::shared_ptr<Object> holder = object;
+  freelist.Put(object);
+
+  std::shared_ptr<Object> reused;
+  EXPECT_FALSE(freelist.Get(&reused))
+      << "Expect object still referenced not to be reused";
+  EXPECT_EQ(reused, nullptr);
+
+  holder.reset();
+  ASSERT_TRUE(freelist.Get(&reused))
+      << "Expect object to be kept and reused once unreferenced";
+}
+
+TEST(SharedObjectFreelistTest, DropWhenFull)
+{
+  tc::SharedObjectFreelist<Object> freelist(2);
+  for (size_t i = 0; i < 3; ++i) {
+    std::shared_ptr<Object> object = std::make_shared<Object>();
+    freelist.Put(object);
+  }
+  size_t reused_count = 0;
+  std::shared_ptr<Object> reused;
+  while (freelist.Get(&reused)) {
+    reused.reset();
+    reused_count++;
+    if (reused_count > 3) {
+      break;
+    }
+  }
+  EXPECT_EQ(reused_count, 2u);
+}
+
+// Get / Put throughput benchmark with a payload-like usage, each thread
+// gets an object, resets it and puts it back. Reports the operations per
+// second for increasing thread counts so regressions show up in the logs.
+TEST(SharedObjectFreelistTest, Throughput)
+{
+  constexpr size_t kIterations = 20000;
+  for (size_t thread_count = 1; thread_count <= 64; thread_count *= 2) {
+    tc::SharedObjectFreelist<Object> freelist(1024);
+    std::atomic<size_t> allocated(0);
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&freelist, &allocated]() {
+        for (size_t i = 0; i < kIterations; ++i) {
+          std::shared_ptr<Object> object;
+          if (!freelist.Get(&object)) {
+            object = std::make_shared<Object>();
+            allocated.fetch_add(1, std::memory_order_relaxed);
+          }
+          object->value_++;
+          freelist.Put(object);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    const double ops = 1e9 * thread_count * kIterations /
+                       std::max<int64_t>(elapsed, int64_t{1});
+    std::cout << "[ BENCHMARK] threads " << thread_count << ": "
+              << static_cast<uint64_t>(ops) << " get/put per second, "
+              << allocated.load() << " allocations" << std::endl;
+    EXPECT_LE(allocated.load(), thread_count * kIterations);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -265,6 +265,53 @@ TEST_F(PinnedMemoryManagerTest, MultipleAlloc)
   CHECK_POINTER_ATTRIBUTES(second_ptr, cudaMemoryTypeHost, 0);
 }
 
+TEST_F(PinnedMemoryManagerTest, GrowAndShrink)
+{
+  options_.pinned_memory_pool_max_byte_size_ = uint64_t(1) << 23 /* 8 MB */;
+  auto status = tc::PinnedMemoryManager::Create(options_);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+
+  // 2048 > 1024, the pool grows by an extent instead of failing
+  void* first_ptr = nullptr;
+  TRITONSERVER_MemoryType allocated_type = TRITONSERVER_MEMORY_GPU;
+  status = tc::PinnedMemoryManager::Alloc(
+      &first_ptr, 2048, &allocated_type, false /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(allocated_type == TRITONSERVER_MEMORY_CPU_PINNED)
+      << "Expect pointer to pinned memory";
+  CHECK_POINTER_ATTRIBUTES(first_ptr, cudaMemoryTypeHost, 0);
+
+  // An allocation that doesn't fit in the extent needs another extent
+  void* second_ptr = nullptr;
+  status = tc::PinnedMemoryManager::Alloc(
+      &second_ptr, 3 << 20, &allocated_type,
+      false /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  tc::PinnedMemoryManager::PoolStats stats;
+  tc::PinnedMemoryManager::GetPoolStats(&stats);
+  EXPECT_EQ(stats.extent_count_, 2u);
+  EXPECT_EQ(stats.fallback_count_, 0u);
+
+  // The pool can't grow past the maximum size
+  void* third_ptr = nullptr;
+  status = tc::PinnedMemoryManager::Alloc(
+      &third_ptr, 6 << 20, &allocated_type,
+      true /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(allocated_type == TRITONSERVER_MEMORY_CPU)
+      << "Expect pointer to non-pinned memory";
+  tc::PinnedMemoryManager::GetPoolStats(&stats);
+  EXPECT_EQ(stats.fallback_count_, 1u);
+
+  // Only one unused extent is kept
+  EXPECT_TRUE(tc::PinnedMemoryManager::Free(first_ptr).IsOk());
+  EXPECT_TRUE(tc::PinnedMemoryManager::Free(second_ptr).IsOk());
+  EXPECT_TRUE(tc::PinnedMemoryManager::Free(third_ptr).IsOk());
+  tc::PinnedMemoryManager::GetPoolStats(&stats);
+  EXPECT_EQ(stats.extent_count_, 1u);
+  EXPECT_LT(stats.byte_size_, options_.pinned_memory_pool_max_byte_size_);
+}
+
 TEST_F(PinnedMemoryManagerTest, ParallelAlloc)
 {
   options_.pinned_memory_pool_byte_size_ = uint64_t(1) << 28 /* 256 MB */;
@@ -288,6 +335,55 @@ TEST_F(PinnedMemoryManagerTest, ParallelAlloc)
   }
 }
 
+TEST_F(PinnedMemoryManagerTest, SlabAllocReuse)
+{
+  options_.pinned_memory_pool_byte_size_ = uint64_t(1) << 26 /* 64 MB */;
+  auto status = tc::PinnedMemoryManager::Create(options_);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+
+  // The first small allocation misses the thread cache, releasing it and
+  // allocating the same size again must reuse the cached chunk.
+  void* first_ptr = nullptr;
+  TRITONSERVER_MemoryType allocated_type = TRITONSERVER_MEMORY_GPU;
+  status = tc::PinnedMemoryManager::Alloc(
+      &first_ptr, 1000, &allocated_type, false /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(allocated_type == TRITONSERVER_MEMORY_CPU_PINNED)
+      << "Expect pointer to pinned memory";
+  CHECK_POINTER_ATTRIBUTES(first_ptr, cudaMemoryTypeHost, 0);
+
+  tc::PinnedMemoryManager::SlabStats stats;
+  tc::PinnedMemoryManager::GetSlabStats(&stats);
+  EXPECT_EQ(stats.miss_count_, 1u);
+  EXPECT_EQ(stats.hit_count_, 0u);
+  EXPECT_EQ(stats.in_use_byte_size_, 1024u);
+  EXPECT_GT(stats.reserved_byte_size_, stats.in_use_byte_size_);
+
+  status = tc::PinnedMemoryManager::Free(first_ptr);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+
+  void* second_ptr = nullptr;
+  status = tc::PinnedMemoryManager::Alloc(
+      &second_ptr, 1000, &allocated_type, false /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  EXPECT_EQ(first_ptr, second_ptr);
+  tc::PinnedMemoryManager::GetSlabStats(&stats);
+  EXPECT_EQ(stats.hit_count_, 1u);
+
+  // Large allocations are still served by the managed buffer.
+  void* large_ptr = nullptr;
+  status = tc::PinnedMemoryManager::Alloc(
+      &large_ptr, 1 << 20, &allocated_type,
+      false /* allow_nonpinned_fallback */);
+  ASSERT_TRUE(status.IsOk()) << status.Message();
+  ASSERT_TRUE(allocated_type == TRITONSERVER_MEMORY_CPU_PINNED)
+      << "Expect pointer to pinned memory";
+  tc::PinnedMemoryManager::GetSlabStats(&stats);
+  EXPECT_EQ(stats.in_use_byte_size_, 1024u);
+
+  EXPECT_TRUE(tc::PinnedMemoryManager::Free(second_ptr).IsOk());
+  EXPECT_TRUE(tc::PinnedMemoryManager::Free(large_ptr).IsOk());
+}
 
 TEST_F(PinnedMemoryManagerTest, ParallelAllocFallback)
 {
@@ -0,0 +1,143 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "precision_convert.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+uint16_t
+Half(const float value)
+{
+  uint16_t half;
+  tc::FloatToHalf(&value, 1, &half);
+  return half;
+}
+
+uint16_t
+BFloat16(const float value)
+{
+  uint16_t bf16;
+  tc::FloatToBFloat16(&value, 1, &bf16);
+  return bf16;
+}
+
+float
+FromBits(const uint32_t bits)
+{
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Reference decoding of a finite half precision value
+float
+HalfValue(const uint16_t half)
+{
+  const int exponent = (half >> 10) & 0x1f;
+  const int mantissa = half & 0x3ff;
+  const float magnitude =
+      (exponent == 0) ? std::ldexp((float)mantissa, -24)
+                      : std::ldexp((float)(mantissa | 0x400), exponent - 25);
+  return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+TEST(PrecisionConvertTest, HalfValues)
+{
+  EXPECT_EQ(Half(0.0f), 0x0000);
+  EXPECT_EQ(Half(-0.0f), 0x8000);
+  EXPECT_EQ(Half(1.0f), 0x3c00);
+  EXPECT_EQ(Half(-2.0f), 0xc000);
+  EXPECT_EQ(Half(0.5f), 0x3800);
+  EXPECT_EQ(Half(65504.0f), 0x7bff);
+  // Smallest subnormal and normal values
+  EXPECT_EQ(Half(std::ldexp(1.0f, -24)), 0x0001);
+  EXPECT_EQ(Half(std::ldexp(1.0f, -14)), 0x0400);
+}
+
+TEST(PrecisionConvertTest, HalfSpecialValues)
+{
+  EXPECT_EQ(Half(std::numeric_limits<float>::infinity()), 0x7c00);
+  EXPECT_EQ(Half(-std::numeric_limits<float>::infinity()), 0xfc00);
+  EXPECT_EQ(Half(std::numeric_limits<float>::quiet_NaN()) & 0x7fff, 0x7e00);
+  // Overflow and underflow
+  EXPECT_EQ(Half(65520.0f), 0x7c00);
+  EXPECT_EQ(Half(1e10f), 0x7c00);
+  EXPECT_EQ(Half(std::ldexp(1.0f, -26)), 0x0000);
+}
+
+TEST(PrecisionConvertTest, HalfRoundToNearestEven)
+{
+  // Halfway between 1 and the next half value rounds down to even, the
+  // next halfway value rounds up to even.
+  EXPECT_EQ(Half(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+  EXPECT_EQ(Half(1.0f + 3 * std::ldexp(1.0f, -11)), 0x3c02);
+  EXPECT_EQ(Half(1.0f + std::ldexp(1.0f, -11) + std::ldexp(1.0f, -20)), 0x3c01);
+  // Subnormal halfway values
+  EXPECT_EQ(Half(std::ldexp(1.0f, -25)), 0x0000);
+  EXPECT_EQ(Half(3 * std::ldexp(1.0f, -25)), 0x0002);
+}
+
+TEST(PrecisionConvertTest, HalfRoundTrip)
+{
+  // Every finite half value converts back to itself
+  std::vector<float> values;
+  std::vector<uint16_t> expected;
+  for (uint32_t half = 0; half <= 0xffff; ++half) {
+    if (((half >> 10) & 0x1f) != 0x1f) {
+      values.push_back(HalfValue(half));
+      expected.push_back(half);
+    }
+  }
+  std::vector<uint16_t> converted(values.size());
+  tc::FloatToHalf(values.data(), values.size(), converted.data());
+  EXPECT_EQ(converted, expected);
+}
+
+TEST(PrecisionConvertTest, BFloat16)
+{
+  EXPECT_EQ(BFloat16(1.0f), 0x3f80);
+  EXPECT_EQ(BFloat16(-2.0f), 0xc000);
+  EXPECT_EQ(BFloat16(0.0f), 0x0000);
+  EXPECT_EQ(BFloat16(std::numeric_limits<float>::infinity()), 0x7f80);
+  // Round to nearest even
+  EXPECT_EQ(BFloat16(FromBits(0x3f808000)), 0x3f80);
+  EXPECT_EQ(BFloat16(FromBits(0x3f818000)), 0x3f82);
+  EXPECT_EQ(BFloat16(FromBits(0x3f808001)), 0x3f81);
+  // The largest values round to infinity, NaN values stay NaN
+  EXPECT_EQ(BFloat16(FromBits(0x7f7fffff)), 0x7f80);
+  const uint16_t nan = BFloat16(FromBits(0x7f800001));
+  EXPECT_EQ(nan & 0x7f80, 0x7f80);
+  EXPECT_NE(nan & 0x7f, 0);
+}
+
+}  // namespace
@@ -0,0 +1,125 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "queue_delay_controller.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kUs = 1000;
+constexpr uint64_t kInterval = 100 * 1000 * kUs;
+
+// Record executions whose latency is 100 us plus 10 us per request
+void
+RecordLinearExecutions(tc::QueueDelayController* controller)
+{
+  for (const size_t batch_size : {1, 8, 64}) {
+    controller->RecordExecutions(
+        batch_size, 10, 10 * (100 + 10 * batch_size) * kUs);
+  }
+}
+
+TEST(QueueDelayControllerTest, InitialDelay)
+{
+  tc::QueueDelayController controller(1000 * kUs, 1000 * kUs, 200 * kUs, 64);
+  EXPECT_EQ(controller.DelayNs(), 200 * kUs);
+
+  // Delay is kept until both arrivals and executions are observed
+  controller.RecordArrivals(1000, kInterval);
+  EXPECT_EQ(controller.Update(), 200 * kUs);
+
+  tc::QueueDelayController capped(1000 * kUs, 100 * kUs, 200 * kUs, 64);
+  EXPECT_EQ(capped.DelayNs(), 100 * kUs);
+}
+
+TEST(QueueDelayControllerTest, LowLoad)
+{
+  // A request every 1 ms is handled without batching
+  tc::QueueDelayController controller(1000 * kUs, 1000 * kUs, 200 * kUs, 64);
+  RecordLinearExecutions(&controller);
+  controller.RecordArrivals(100, kInterval);
+  EXPECT_EQ(controller.Update(), 0u);
+}
+
+TEST(QueueDelayControllerTest, ModerateLoad)
+{
+  // A request every 50 us needs a batch of 4 to keep up, which takes
+  // 150 us to collect
+  tc::QueueDelayController controller(1000 * kUs, 1000 * kUs, 0, 64);
+  RecordLinearExecutions(&controller);
+  controller.RecordArrivals(2000, kInterval);
+  EXPECT_NEAR(controller.Update(), 150 * kUs, kUs);
+}
+
+TEST(QueueDelayControllerTest, Overload)
+{
+  // A request every 10 us can't be kept up with, the largest batch
+  // within the SLO is 45 which takes 440 us to collect
+  tc::QueueDelayController controller(1000 * kUs, 1000 * kUs, 0, 64);
+  RecordLinearExecutions(&controller);
+  controller.RecordArrivals(10000, kInterval);
+  EXPECT_NEAR(controller.Update(), 440 * kUs, kUs);
+
+  // Delay is also bounded by the maximum delay
+  tc::QueueDelayController capped(1000 * kUs, 200 * kUs, 0, 64);
+  RecordLinearExecutions(&capped);
+  capped.RecordArrivals(10000, kInterval);
+  EXPECT_LE(capped.Update(), 200 * kUs);
+}
+
+TEST(QueueDelayControllerTest, SloNotReachable)
+{
+  // Execution alone exceeds the SLO, don't delay requests at all
+  tc::QueueDelayController controller(50 * kUs, 50 * kUs, 20 * kUs, 64);
+  RecordLinearExecutions(&controller);
+  controller.RecordArrivals(10000, kInterval);
+  EXPECT_EQ(controller.Update(), 0u);
+}
+
+TEST(QueueDelayControllerTest, FollowsArrivalRate)
+{
+  tc::QueueDelayController controller(1000 * kUs, 1000 * kUs, 0, 64);
+  RecordLinearExecutions(&controller);
+  controller.RecordArrivals(100, kInterval);
+  EXPECT_EQ(controller.Update(), 0u);
+
+  // The smoothed arrival rate converges to the new load
+  for (size_t i = 0; i < 50; ++i) {
+    controller.RecordArrivals(2000, kInterval);
+  }
+  EXPECT_NEAR(controller.Update(), 150 * kUs, kUs);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rcu_snapshot.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+// Value that records whether it is read after being destroyed
+struct Value {
+  explicit Value(int v) : value_(v), alive_(true) {}
+  ~Value() { alive_ = false; }
+  int value_;
+  std::atomic<bool> alive_;
+};
+
+TEST(RcuSnapshotTest, Publish)
+{
+  tc::RcuSnapshot<Value> snapshot(std::unique_ptr<Value>(new Value(1)));
+  EXPECT_EQ(snapshot.Read()->value_, 1);
+  snapshot.Publish(std::unique_ptr<Value>(new Value(2)));
+  EXPECT_EQ(snapshot.Read()->value_, 2);
+}
+
+TEST(RcuSnapshotTest, ConcurrentReaders)
+{
+  tc::RcuSnapshot<Value> snapshot(std::unique_ptr<Value>(new Value(0)));
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> errors(0);
+  std::vector<std::thread> readers;
+  for (size_t idx = 0; idx < 4; ++idx) {
+    readers.emplace_back([&snapshot, &stop, &errors]() {
+      int last = 0;
+      while (!stop) {
+        auto guard = snapshot.Read();
+        // Values are published in increasing order and stay alive while
+        // read.
+        if (!guard->alive_ || (guard->value_ < last)) {
+          ++errors;
+        }
+        last = guard->value_;
+      }
+    });
+  }
+
+  for (int value = 1; value <= 1000; ++value) {
+    snapshot.Publish(std::unique_ptr<Value>(new Value(value)));
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(snapshot.Read()->value_, 1000);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
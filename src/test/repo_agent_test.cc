@@ -27,6 +27,7 @@
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <utime.h>
 #include <fstream>
 #include <functional>
 #include <future>
@@ -1346,6 +1347,167 @@ TEST_F(TritonRepoAgentModelTest, WrongLifeCycle)
   }
 }
 
+class TritonRepoAgentResultCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    simple_config_.set_name("simple_config");
+
+    // Add a agent handle that counts the LOAD actions and declares the
+    // updated location in an acquired directory as cacheable
+    tc::TritonRepoAgent::TritonRepoAgentModelActionFn_t CacheActionFn =
+        [](TRITONREPOAGENT_Agent* agent, TRITONREPOAGENT_AgentModel* model,
+           const TRITONREPOAGENT_ActionType action_type)
+        -> TRITONSERVER_Error* {
+      if (action_type != TRITONREPOAGENT_ACTION_LOAD) {
+        return nullptr;
+      }
+      auto lagent = reinterpret_cast<tc::TritonRepoAgent*>(agent);
+      auto lmodel = reinterpret_cast<tc::TritonRepoAgentModel*>(model);
+      (*reinterpret_cast<size_t*>(lagent->State()))++;
+      const char* acquired_location;
+      auto status = lmodel->AcquireMutableLocation(
+          TRITONREPOAGENT_ARTIFACT_FILESYSTEM, &acquired_location);
+      if (status.IsOk()) {
+        status = lmodel->SetLocation(
+            TRITONREPOAGENT_ARTIFACT_FILESYSTEM, acquired_location);
+      }
+      if (status.IsOk()) {
+        status = lmodel->SetResultCacheable(true);
+      }
+      return TritonServerError::Create(status);
+    };
+    auto cache_agent_handle = MockSharedLibraryHandle();
+    cache_agent_handle.AddEntryPoint(
+        "TRITONREPOAGENT_ModelAction", reinterpret_cast<void*>(CacheActionFn));
+    global_mock_agents.emplace("cache_agent_path", cache_agent_handle);
+
+    auto status = tc::MakeTemporaryDirectory(
+        tc::FileSystemType::LOCAL, &original_location_);
+    ASSERT_TRUE(status.IsOk())
+        << "Expect successful temporary directory creation: "
+        << status.AsString();
+    WriteModelFile("1");
+
+    status =
+        tc::TritonRepoAgent::Create("cache_agent", "cache_agent_path", &agent_);
+    ASSERT_TRUE(status.IsOk())
+        << "Expect successful agent creation: " << status.AsString();
+    agent_->SetState(reinterpret_cast<void*>(&load_count_));
+  }
+  void TearDown() override
+  {
+    agent_.reset();
+    global_mock_agents.clear();
+    tc::DeleteDirectory(original_location_);
+  }
+
+  // Write the model file with a fixed modification time so that only
+  // the contents tell the versions apart
+  void WriteModelFile(const std::string& contents)
+  {
+    const auto path = tc::JoinPath({original_location_, "model.txt"});
+    ASSERT_TRUE(tc::WriteBinaryFile(path, contents.data(), contents.size())
+                    .IsOk());
+    struct utimbuf times;
+    times.actime = 1000;
+    times.modtime = 1000;
+    ASSERT_EQ(utime(path.c_str(), &times), 0);
+  }
+
+  // Create a model and invoke the LOAD action on it, return the location
+  // of the loaded model in 'location'
+  void LoadModel(
+      std::unique_ptr<tc::TritonRepoAgentModel>* model, std::string* location)
+  {
+    auto status = tc::TritonRepoAgentModel::Create(
+        TRITONREPOAGENT_ARTIFACT_FILESYSTEM, original_location_,
+        simple_config_, agent_, tc::TritonRepoAgent::Parameters(), model);
+    ASSERT_TRUE(status.IsOk())
+        << "Expect successful model creation: " << status.AsString();
+    for (const auto action :
+         {TRITONREPOAGENT_ACTION_LOAD, TRITONREPOAGENT_ACTION_LOAD_COMPLETE}) {
+      status = (*model)->InvokeAgent(action);
+      ASSERT_TRUE(status.IsOk())
+          << "Expect successful agent invocation with "
+          << tc::TRITONREPOAGENT_ActionTypeString(action) << ": "
+          << status.AsString();
+    }
+    TRITONREPOAGENT_ArtifactType type;
+    const char* loaded_location;
+    status = (*model)->Location(&type, &loaded_location);
+    ASSERT_TRUE(status.IsOk())
+        << "Expect location is returned: " << status.AsString();
+    *location = loaded_location;
+  }
+
+  std::shared_ptr<tc::TritonRepoAgent> agent_;
+  size_t load_count_ = 0;
+  std::string original_location_;
+  inference::ModelConfig simple_config_;
+};
+
+TEST_F(TritonRepoAgentResultCacheTest, ReuseIdenticalContents)
+{
+  std::unique_ptr<tc::TritonRepoAgentModel> model;
+  std::string location;
+  LoadModel(&model, &location);
+  EXPECT_EQ(load_count_, (size_t)1);
+  EXPECT_NE(location, original_location_)
+      << "Expect the model is loaded from the acquired location";
+
+  std::unique_ptr<tc::TritonRepoAgentModel> reloaded_model;
+  std::string reloaded_location;
+  LoadModel(&reloaded_model, &reloaded_location);
+  EXPECT_EQ(load_count_, (size_t)1)
+      << "Expect the agent is not invoked for identical model files";
+  EXPECT_EQ(reloaded_location, location)
+      << "Expect the cached location is reused";
+}
+
+TEST_F(TritonRepoAgentResultCacheTest, ChangedContentsSameModificationTime)
+{
+  std::unique_ptr<tc::TritonRepoAgentModel> model;
+  std::string location;
+  LoadModel(&model, &location);
+  EXPECT_EQ(load_count_, (size_t)1);
+
+  WriteModelFile("2");
+  std::unique_ptr<tc::TritonRepoAgentModel> reloaded_model;
+  std::string reloaded_location;
+  LoadModel(&reloaded_model, &reloaded_location);
+  EXPECT_EQ(load_count_, (size_t)2)
+      << "Expect the agent is invoked for changed model files";
+  EXPECT_NE(reloaded_location, location)
+      << "Expect the stale location is not reused";
+}
+
+TEST_F(TritonRepoAgentResultCacheTest, EvictAfterLastModel)
+{
+  std::unique_ptr<tc::TritonRepoAgentModel> model;
+  std::string location;
+  LoadModel(&model, &location);
+  std::unique_ptr<tc::TritonRepoAgentModel> reloaded_model;
+  std::string reloaded_location;
+  LoadModel(&reloaded_model, &reloaded_location);
+  EXPECT_EQ(load_count_, (size_t)1);
+
+  // The result is kept while a model uses it
+  model.reset();
+  bool exists = false;
+  ASSERT_TRUE(tc::FileExists(location, &exists).IsOk());
+  EXPECT_TRUE(exists) << "Expect the location in use is not removed";
+
+  reloaded_model.reset();
+  ASSERT_TRUE(tc::FileExists(location, &exists).IsOk());
+  EXPECT_FALSE(exists)
+      << "Expect the acquired location is removed with the last model";
+
+  LoadModel(&model, &location);
+  EXPECT_EQ(load_count_, (size_t)2)
+      << "Expect the agent is invoked once the result is evicted";
+}
+
 class TritonRepoAgentAPITest : public ::testing::Test {
  public:
   static std::function<void(TRITONREPOAGENT_Agent*)> agent_init_fn_;
@@ -25,6 +25,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <map>
 #include <random>
 #include <thread>
 #include "memory.h"
@@ -84,14 +90,13 @@ InferenceRequest::PrepareForInference()
 {
   // Remove override inputs as those are added during any previous
   // inference execution.
-  inputs_.clear();
-  override_inputs_.clear();
+  ClearInferenceInputs();
 
   // Initially show the actual inputs to be only the original
   // inputs. If overrides are added later they will be added to
   // 'inputs_'.
   for (auto& pr : original_inputs_) {
-    inputs_.emplace(std::make_pair(pr.first, std::addressof(pr.second)));
+    inputs_.Emplace(std::addressof(pr.second), pr.second.ConfigIndex());
   }
 
   // Clear the timestamps
@@ -105,6 +110,15 @@ InferenceRequest::PrepareForInference()
   return Status::Success;
 }
 
+void
+InferenceRequest::ClearInferenceInputs()
+{
+  inputs_ = InputMap(InputMap::allocator_type(&arena_));
+  override_inputs_ =
+      OverrideInputMap(OverrideInputMap::allocator_type(&arena_));
+  arena_.Reset();
+}
+
 Status
 InferenceRequest::Input::DataBuffer(
     const size_t idx, const void** base, size_t* byte_size,
@@ -175,9 +189,12 @@ InferenceResponse::InferenceResponse(
     void* response_userp,
     const std::function<
         void(std::unique_ptr<InferenceResponse>&&, const uint32_t)>& delegator)
-    : model_(model), id_(id), allocator_(allocator), alloc_userp_(alloc_userp),
-      response_fn_(response_fn), response_userp_(response_userp),
-      response_delegator_(delegator), null_response_(false)
+    : model_(model), id_(id),
+      parameters_(ParameterDeque::allocator_type(&arena_)),
+      outputs_(OutputDeque::allocator_type(&arena_)), allocator_(allocator),
+      alloc_userp_(alloc_userp), response_fn_(response_fn),
+      response_userp_(response_userp), response_delegator_(delegator),
+      null_response_(false)
 {
   // Skip allocator logic / references in unit test
 }
@@ -205,7 +222,9 @@ InferenceResponse::Output::~Output()
 Status
 InferenceResponse::Output::ReleaseDataBuffer()
 {
-  if (allocated_buffer_ != nullptr) {
+  if (borrowed_buffer_owner_ != nullptr) {
+    borrowed_buffer_owner_.reset();
+  } else if (allocated_buffer_ != nullptr) {
     free(allocated_buffer_);
   }
 
@@ -267,6 +286,33 @@ InferenceResponse::Output::AllocateDataBuffer(
   return Status::Success;
 }
 
+// Same as defined in infer_response.cc
+Status
+InferenceResponse::Output::SetBorrowedDataBuffer(
+    const void* buffer, const size_t buffer_byte_size,
+    const TRITONSERVER_MemoryType memory_type, const int64_t memory_type_id,
+    const std::shared_ptr<void>& owner)
+{
+  if (allocated_buffer_ != nullptr) {
+    return Status(
+        Status::Code::ALREADY_EXISTS,
+        "allocated buffer for output '" + name_ + "' already exists");
+  }
+  if ((buffer == nullptr) || (owner == nullptr)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "borrowed buffer for output '" + name_ + "' must have an owner");
+  }
+
+  allocated_buffer_ = const_cast<void*>(buffer);
+  buffer_attributes_.SetByteSize(buffer_byte_size);
+  buffer_attributes_.SetMemoryType(memory_type);
+  buffer_attributes_.SetMemoryTypeId(memory_type_id);
+  allocated_userp_ = nullptr;
+  borrowed_buffer_owner_ = owner;
+  return Status::Success;
+}
+
 Status
 InferenceResponse::AddOutput(
     const std::string& name, const inference::DataType datatype,
@@ -431,6 +477,83 @@ generate_data(size_t size)
   return data;
 }
 
+// Key trace with a skewed set of small, frequently used responses mixed
+// with large responses that are only requested once. Each element is the
+// key and the number of ints in its response.
+std::vector<std::pair<int, size_t>>
+GenerateScanTrace(
+    size_t length, size_t hot_keys, size_t small_size, size_t large_size)
+{
+  // Fixed seed and raw engine output so the trace is the same everywhere
+  std::mt19937 generator(42);
+  std::vector<double> cdf(hot_keys);
+  double total = 0;
+  for (size_t k = 0; k < hot_keys; k++) {
+    total += 1.0 / static_cast<double>(k + 1);
+    cdf[k] = total;
+  }
+
+  std::vector<std::pair<int, size_t>> trace;
+  int next_one_off = hot_keys;
+  for (size_t idx = 0; idx < length; idx++) {
+    if ((idx % 10) == 9) {
+      trace.emplace_back(next_one_off++, large_size);
+      continue;
+    }
+    const double u = total * static_cast<double>(generator()) /
+                     static_cast<double>(generator.max());
+    const size_t key = std::min<size_t>(
+        std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin(),
+        hot_keys - 1);
+    trace.emplace_back(static_cast<int>(key), small_size);
+  }
+  return trace;
+}
+
+// Remote tier kept in memory, answering lookups from a separate thread
+// unless 'respond_' is false
+class FakeRemoteTier : public tc::CacheRemoteTier {
+ public:
+  void Get(const std::string& key, GetCallback callback) override
+  {
+    std::string value;
+    bool found = false;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (!respond_) {
+        pending_.push_back(std::move(callback));
+        return;
+      }
+      auto it = values_.find(key);
+      found = (it != values_.end());
+      if (found) {
+        value = it->second;
+      }
+    }
+    std::thread([callback, found, value]() mutable {
+      callback(tc::Status::Success, found, std::move(value));
+    }).detach();
+  }
+
+  tc::Status Put(const std::string& key, const std::string& value) override
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    values_[key] = value;
+    return tc::Status::Success;
+  }
+
+  size_t Size()
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    return values_.size();
+  }
+
+  std::mutex mu_;
+  bool respond_ = true;
+  std::map<std::string, std::string> values_;
+  std::vector<GetCallback> pending_;
+};
+
 // Test Fixture
 class RequestResponseCacheTest : public ::testing::Test {
  protected:
@@ -469,14 +592,15 @@ class RequestResponseCacheTest : public ::testing::Test {
     ASSERT_NE(request4, nullptr);
 
     // Generate a set of random requests to use for various tests
-    for (size_t idx; idx < thread_count; idx++) {
-      std::vector<int>* data = new std::vector<int>(generate_data(4));
-      // Ensure data survives lifetime of tests. Automatically cleaned up
-      random_data.emplace_back(data);
+    for (size_t idx = 0; idx < thread_count; idx++) {
+      // The request references the data of the tensors, ensure they
+      // survive the lifetime of tests. Automatically cleaned up
+      std::vector<Tensor>* inputs =
+          new std::vector<Tensor>{Tensor{"input", generate_data(4)}};
+      random_inputs.emplace_back(inputs);
 
-      std::vector<Tensor> inputs{Tensor{"input", *data}};
       auto request = GenerateRequest(
-          model, model_version, dtype, memory_type, memory_type_id, inputs);
+          model, model_version, dtype, memory_type, memory_type_id, *inputs);
       ASSERT_NE(request, nullptr);
       random_requests.emplace_back(request);
     }
@@ -524,7 +648,7 @@ class RequestResponseCacheTest : public ::testing::Test {
   std::vector<Tensor> inputs0, inputs1, inputs2, inputs3, inputs4, inputs100;
   std::vector<Tensor> outputs0, outputs100;
   tc::InferenceRequest *request0, *request1, *request2, *request3, *request4;
-  std::vector<std::unique_ptr<std::vector<int>>> random_data;
+  std::vector<std::unique_ptr<std::vector<Tensor>>> random_inputs;
   std::vector<tc::InferenceRequest*> random_requests;
   std::unique_ptr<tc::InferenceResponse> response0, response_400bytes;
 };
@@ -559,6 +683,82 @@ TEST_F(RequestResponseCacheTest, TestHashing)
   ASSERT_EQ(request3->CacheKey(), request4->CacheKey());
 }
 
+// Test hashing is independent of how input data is split into buffers
+TEST_F(RequestResponseCacheTest, TestHashingChunks)
+{
+  // Create cache
+  std::cout << "Create cache" << std::endl;
+  uint64_t cache_size = 4 * 1024 * 1024;
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  tc::RequestResponseCache::Create(cache_size, &cache);
+
+  // Split data0 across two buffers of the same input
+  std::unique_ptr<tc::InferenceRequest> chunked_request(
+      new tc::InferenceRequest(model, model_version));
+  tc::InferenceRequest::Input* request_input = nullptr;
+  std::vector<int64_t> shape{1, static_cast<int64_t>(data0.size())};
+  check_status(chunked_request->AddOriginalInput(
+      "input", dtype, shape, &request_input));
+  ASSERT_NE(request_input, nullptr);
+  const size_t half = data0.size() / 2;
+  check_status(request_input->AppendData(
+      data0.data(), sizeof(int) * half, memory_type, memory_type_id));
+  check_status(request_input->AppendData(
+      data0.data() + half, sizeof(int) * (data0.size() - half), memory_type,
+      memory_type_id));
+  check_status(chunked_request->PrepareForInference());
+
+  check_status(cache->HashAndSet(request0));
+  check_status(cache->HashAndSet(chunked_request.get()));
+  ASSERT_EQ(request0->CacheKey(), chunked_request->CacheKey());
+
+  // Input boundaries are part of the key, the same bytes split across
+  // differently named inputs must not collide with a single input
+  // The request references the input data so it must outlive the request
+  std::vector<Tensor> split_inputs{
+      {"input", std::vector<int>(data0.begin(), data0.begin() + half)},
+      {"input_", std::vector<int>(data0.begin() + half, data0.end())}};
+  auto split_request = GenerateRequest(
+      model, model_version, dtype, memory_type, memory_type_id, split_inputs);
+  ASSERT_NE(split_request, nullptr);
+  check_status(cache->HashAndSet(split_request));
+  ASSERT_NE(request0->CacheKey(), split_request->CacheKey());
+  delete split_request;
+}
+
+// Test collision-safe mode treats a key collision as a cache miss
+TEST_F(RequestResponseCacheTest, TestCollisionSafe)
+{
+  // Create cache
+  std::cout << "Create collision-safe cache" << std::endl;
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(
+      tc::RequestResponseCache::Options(
+          1024, 1 /* num_shards */, true /* collision_safe */),
+      &cache));
+  ASSERT_TRUE(cache->CollisionSafe());
+
+  check_status(cache->HashAndSet(request0));
+  check_status(cache->HashAndSet(request1));
+  ASSERT_NE(request0->CacheDigest(), 0u);
+  ASSERT_NE(request0->CacheDigest(), request1->CacheDigest());
+  check_status(cache->Insert(*response0, request0));
+
+  // Same request is a hit
+  std::unique_ptr<tc::InferenceResponse> response;
+  reset_response(&response, request0);
+  check_status(cache->Lookup(response.get(), request0));
+
+  // Force request1 to collide with the key of request0, the digest differs
+  // so the lookup must miss
+  request1->SetCacheKey(request0->CacheKey(), request1->CacheDigest());
+  reset_response(&response, request1);
+  auto status = cache->Lookup(response.get(), request1);
+  ASSERT_FALSE(status.IsOk()) << "colliding key should miss in cache";
+  ASSERT_EQ(cache->NumHits(), 1u);
+  ASSERT_EQ(cache->NumMisses(), 1u);
+}
+
 // Test cache too small for entry
 TEST_F(RequestResponseCacheTest, TestCacheTooSmall)
 {
@@ -586,6 +786,25 @@ TEST_F(RequestResponseCacheTest, TestCacheTooSmall)
       << "Inserting item larger than cache succeeded when it should fail";
 }
 
+// Test cache creation rejects storage the cache can't manage
+TEST_F(RequestResponseCacheTest, TestStorageMemoryType)
+{
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  auto status = tc::RequestResponseCache::Create(
+      tc::RequestResponseCache::Options(
+          1024 /* cache_size */, 1 /* num_shards */,
+          false /* collision_safe */, tc::CacheEvictionPolicy::Kind::LRU,
+          TRITONSERVER_MEMORY_CPU_PINNED, 0 /* memory_type_id */),
+      &cache);
+  ASSERT_FALSE(status.IsOk())
+      << "Creating cache in pinned memory succeeded when it should fail";
+  ASSERT_EQ(cache, nullptr);
+
+  check_status(tc::RequestResponseCache::Create(1024, &cache));
+  ASSERT_EQ(cache->MemoryType(), TRITONSERVER_MEMORY_CPU);
+  ASSERT_EQ(cache->MemoryTypeId(), 0);
+}
+
 // Test hashing for consistency on same request
 TEST_F(RequestResponseCacheTest, TestEviction)
 {
@@ -853,7 +1072,262 @@ TEST_F(RequestResponseCacheTest, TestParallelLookup)
   }
 }
 
+// Test inserting into and looking up from a sharded cache with multiple
+// threads in parallel and asserting the metrics are aggregated over shards
+TEST_F(RequestResponseCacheTest, TestShardedCache)
+{
+  // Create cache
+  std::cout << "Create sharded cache" << std::endl;
+  uint64_t cache_size = 4096;
+  uint32_t num_shards = 4;
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(
+      tc::RequestResponseCache::Options(cache_size, num_shards), &cache));
+  cache_stats(cache);
+  ASSERT_EQ(cache->NumShards(), (size_t)num_shards);
+
+  // Create threads
+  std::vector<std::thread> threads;
+  std::vector<std::unique_ptr<tc::InferenceResponse>> responses;
+
+  // Insert [thread_count] entries into cache in parallel
+  std::cout << "Insert responses into cache with [" << thread_count
+            << "] threads in parallel" << std::endl;
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    threads.emplace_back(std::thread(
+        &tc::RequestResponseCache::Insert, cache.get(), std::ref(*response0),
+        random_requests[idx]));
+  }
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    threads[idx].join();
+  }
+  threads.clear();
+
+  // Assert all entries were put into cache and no evictions occurred yet
+  cache_stats(cache);
+  ASSERT_EQ(cache->NumEntries(), (uint64_t)thread_count)
+      << "NumEntries: " << cache->NumEntries();
+  ASSERT_EQ(cache->NumEvictions(), 0u)
+      << "NumEvictions: " << cache->NumEvictions();
+
+  // Lookup [thread_count] entries from cache in parallel
+  std::cout << "Lookup from cache with [" << thread_count
+            << "] threads in parallel" << std::endl;
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    std::unique_ptr<tc::InferenceResponse> response;
+    check_status(
+        random_requests[idx]->ResponseFactory().CreateResponse(&response));
+    responses.push_back(std::move(response));
+  }
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    threads.emplace_back(std::thread(
+        &tc::RequestResponseCache::Lookup, cache.get(), responses[idx].get(),
+        random_requests[idx]));
+  }
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    threads[idx].join();
+  }
+
+  // Hits and lookups are aggregated over all shards
+  ASSERT_EQ(cache->NumLookups(), (uint64_t)thread_count);
+  ASSERT_EQ(cache->NumHits(), (uint64_t)thread_count);
+  ASSERT_EQ(cache->NumMisses(), 0u);
+
+  // Verify output results from cache
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    const void* response_buffer = nullptr;
+    size_t response_byte_size = 0;
+    TRITONSERVER_MemoryType response_memory_type;
+    int64_t response_memory_type_id;
+    void* userp;
+
+    ASSERT_EQ(responses[idx]->Outputs().size(), 1u);
+    check_status(responses[idx]->Outputs()[0].DataBuffer(
+        &response_buffer, &response_byte_size, &response_memory_type,
+        &response_memory_type_id, &userp));
+    ASSERT_EQ(response_byte_size, output0_size);
+    int* cache_output = (int*)response_buffer;
+    for (size_t i = 0; i < response_byte_size / sizeof(int); i++) {
+      ASSERT_EQ(cache_output[i], data0[i]);
+    }
+  }
+
+  // An entry must fit in the slice of a single shard
+  std::unique_ptr<tc::RequestResponseCache> small_cache;
+  check_status(tc::RequestResponseCache::Create(
+      tc::RequestResponseCache::Options(1024, num_shards), &small_cache));
+  auto status = small_cache->Insert(*response_400bytes, request0);
+  ASSERT_FALSE(status.IsOk())
+      << "Inserting item larger than a shard succeeded when it should fail";
+
+  // Evict all entries, visiting every shard
+  for (size_t idx = 0; idx < thread_count; idx++) {
+    check_status(cache->Evict());
+  }
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  ASSERT_EQ(cache->NumEvictions(), (uint64_t)thread_count);
+  ASSERT_FALSE(cache->Evict().IsOk());
+}
+
 // Test end-to-end flow of cache
+TEST_F(RequestResponseCacheTest, TestZeroCopyLookup)
+{
+  // Create cache
+  std::cout << "Create cache" << std::endl;
+  uint64_t cache_size = 1024;
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(cache_size, &cache));
+  check_status(cache->Insert(*response_400bytes, request0));
+  const uint64_t allocated_bytes = cache->AllocatedBytes();
+
+  // Allocator that accepts buffers owned by the cache, the allocation
+  // functions must never be called
+  tc::ResponseAllocator allocator(nullptr, nullptr, nullptr);
+  allocator.SetBorrowedBuffersAccepted(true);
+  std::unique_ptr<tc::InferenceResponse> response(new tc::InferenceResponse(
+      nullptr, "", &allocator, nullptr, nullptr, nullptr, nullptr));
+
+  std::cout << "Lookup request0 with zero-copy response" << std::endl;
+  check_status(cache->Lookup(response.get(), request0));
+  ASSERT_EQ(response->Outputs().size(), 1u);
+
+  const void* buffer = nullptr;
+  size_t byte_size = 0;
+  TRITONSERVER_MemoryType buffer_memory_type;
+  int64_t buffer_memory_type_id;
+  void* userp;
+  check_status(response->Outputs()[0].DataBuffer(
+      &buffer, &byte_size, &buffer_memory_type, &buffer_memory_type_id,
+      &userp));
+  ASSERT_EQ(byte_size, data100.size() * sizeof(int));
+  ASSERT_EQ(buffer_memory_type, TRITONSERVER_MEMORY_CPU);
+
+  // Evicting the entry must not reclaim the memory the response references
+  std::cout << "Evict entry referenced by response" << std::endl;
+  check_status(cache->Evict());
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  ASSERT_EQ(cache->AllocatedBytes(), allocated_bytes);
+  const int* output = reinterpret_cast<const int*>(buffer);
+  for (size_t i = 0; i < data100.size(); i++) {
+    ASSERT_EQ(output[i], data100[i]);
+  }
+
+  // Releasing the response returns the memory to the cache
+  std::cout << "Release zero-copy response" << std::endl;
+  response.reset();
+  ASSERT_LT(cache->AllocatedBytes(), allocated_bytes);
+
+  // A response whose allocator doesn't accept borrowed buffers gets a copy
+  check_status(cache->Insert(*response_400bytes, request0));
+  std::unique_ptr<tc::InferenceResponse> response_copy;
+  reset_response(&response_copy, request0);
+  check_status(cache->Lookup(response_copy.get(), request0));
+  check_status(response_copy->Outputs()[0].DataBuffer(
+      &buffer, &byte_size, &buffer_memory_type, &buffer_memory_type_id,
+      &userp));
+  check_status(cache->Evict());
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  output = reinterpret_cast<const int*>(buffer);
+  for (size_t i = 0; i < data100.size(); i++) {
+    ASSERT_EQ(output[i], data100[i]);
+  }
+
+  // The cache may be destroyed while an entry is still referenced
+  std::cout << "Destroy cache with outstanding zero-copy response" << std::endl;
+  check_status(cache->Insert(*response_400bytes, request0));
+  response.reset(new tc::InferenceResponse(
+      nullptr, "", &allocator, nullptr, nullptr, nullptr, nullptr));
+  check_status(cache->Lookup(response.get(), request0));
+  cache.reset();
+  check_status(response->Outputs()[0].DataBuffer(
+      &buffer, &byte_size, &buffer_memory_type, &buffer_memory_type_id,
+      &userp));
+  output = reinterpret_cast<const int*>(buffer);
+  for (size_t i = 0; i < data100.size(); i++) {
+    ASSERT_EQ(output[i], data100[i]);
+  }
+  response.reset();
+  std::cout << "Done!" << std::endl;
+}
+
+// Replay a key trace against each eviction policy, inserting the response
+// on every miss, and compare the resulting hit rates
+TEST_F(RequestResponseCacheTest, TestEvictionPolicyHitRate)
+{
+  const size_t small_size = 16;
+  const size_t large_size = 512;
+  const auto trace = GenerateScanTrace(20000, 200, small_size, large_size);
+
+  // One request per distinct key, the input data must outlive the requests
+  std::map<int, std::unique_ptr<tc::InferenceRequest>> requests;
+  std::list<std::vector<Tensor>> request_inputs;
+  for (const auto& access : trace) {
+    if (requests.find(access.first) == requests.end()) {
+      request_inputs.emplace_back(
+          std::vector<Tensor>{{"input", std::vector<int>(1, access.first)}});
+      tc::InferenceRequest* request = GenerateRequest(
+          model, model_version, dtype, memory_type, memory_type_id,
+          request_inputs.back());
+      ASSERT_NE(request, nullptr);
+      requests[access.first].reset(request);
+    }
+  }
+
+  const std::vector<tc::CacheEvictionPolicy::Kind> kinds{
+      tc::CacheEvictionPolicy::Kind::LRU,
+      tc::CacheEvictionPolicy::Kind::TINY_LFU,
+      tc::CacheEvictionPolicy::Kind::SIZE_AWARE};
+  std::map<tc::CacheEvictionPolicy::Kind, double> hit_rates;
+  for (const auto kind : kinds) {
+    std::unique_ptr<tc::RequestResponseCache> cache;
+    check_status(tc::RequestResponseCache::Create(
+        tc::RequestResponseCache::Options(
+            8192 /* cache_size */, 1 /* num_shards */,
+            false /* collision_safe */, kind),
+        &cache));
+    ASSERT_EQ(cache->EvictionPolicy(), kind);
+
+    for (const auto& access : trace) {
+      tc::InferenceRequest* request = requests[access.first].get();
+      std::unique_ptr<tc::InferenceResponse> response;
+      reset_response(&response, request);
+      if (cache->Lookup(response.get(), request).IsOk()) {
+        continue;
+      }
+
+      // Build the response of the missed key and insert it
+      reset_response(&response, request);
+      tc::InferenceResponse::Output* output = nullptr;
+      std::vector<int64_t> shape{1, static_cast<int64_t>(access.second)};
+      check_status(response->AddOutput("output", dtype, shape, &output));
+      void* buffer = nullptr;
+      TRITONSERVER_MemoryType output_memory_type = memory_type;
+      int64_t output_memory_type_id = memory_type_id;
+      check_status(output->AllocateDataBuffer(
+          &buffer, access.second * sizeof(int), &output_memory_type,
+          &output_memory_type_id));
+      std::fill_n(reinterpret_cast<int*>(buffer), access.second, access.first);
+      check_status(cache->Insert(*response, request));
+    }
+
+    ASSERT_EQ(cache->NumLookups(), trace.size());
+    hit_rates[kind] = static_cast<double>(cache->NumHits()) /
+                      static_cast<double>(cache->NumLookups());
+    std::cout << tc::CacheEvictionPolicyKindString(kind)
+              << " hit rate: " << hit_rates[kind]
+              << ", evictions: " << cache->NumEvictions() << std::endl;
+  }
+
+  // The one-off large responses flush out the hot small responses under
+  // LRU, the other policies are expected to protect them
+  ASSERT_GT(
+      hit_rates[tc::CacheEvictionPolicy::Kind::TINY_LFU],
+      hit_rates[tc::CacheEvictionPolicy::Kind::LRU]);
+  ASSERT_GT(
+      hit_rates[tc::CacheEvictionPolicy::Kind::SIZE_AWARE],
+      hit_rates[tc::CacheEvictionPolicy::Kind::LRU]);
+}
+
 TEST_F(RequestResponseCacheTest, TestEndToEnd)
 {
   // Create cache
@@ -947,6 +1421,206 @@ TEST_F(RequestResponseCacheTest, TestEndToEnd)
   std::cout << "Done!" << std::endl;
 }
 
+// Test sharing entries between caches through a remote tier
+TEST_F(RequestResponseCacheTest, TestRemoteTier)
+{
+  auto remote = std::make_shared<FakeRemoteTier>();
+  tc::RequestResponseCache::Options options(1024);
+  options.remote_tier_ = remote;
+  options.remote_lookup_timeout_us_ = 1000000;
+  std::unique_ptr<tc::RequestResponseCache> cache0, cache1;
+  check_status(tc::RequestResponseCache::Create(options, &cache0));
+  check_status(tc::RequestResponseCache::Create(options, &cache1));
+
+  // Inserted entries are written back asynchronously
+  check_status(cache0->Insert(*response0, request0));
+  for (size_t retry = 0; (remote->Size() == 0) && (retry < 1000); ++retry) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(remote->Size(), 1u);
+
+  // A local miss of the other cache is served from the remote tier and
+  // the entry is inserted into the local cache
+  std::unique_ptr<tc::InferenceResponse> response;
+  reset_response(&response, request0);
+  check_status(cache1->Lookup(response.get(), request0));
+  ASSERT_EQ(cache1->NumRemoteHits(), 1u);
+  ASSERT_EQ(cache1->NumMisses(), 1u);
+  ASSERT_EQ(cache1->NumEntries(), 1u);
+
+  const void* response_buffer = nullptr;
+  size_t response_byte_size = 0;
+  TRITONSERVER_MemoryType response_memory_type;
+  int64_t response_memory_type_id;
+  void* userp;
+  ASSERT_EQ(response->Outputs().size(), 1u);
+  ASSERT_EQ(response->Outputs()[0].Name(), "output");
+  check_status(response->Outputs()[0].DataBuffer(
+      &response_buffer, &response_byte_size, &response_memory_type,
+      &response_memory_type_id, &userp));
+  ASSERT_EQ(response_byte_size, output0_size);
+  int* cache_output = (int*)response_buffer;
+  for (size_t i = 0; i < response_byte_size / sizeof(int); i++) {
+    ASSERT_EQ(cache_output[i], data0[i]);
+  }
+
+  // The next lookup hits locally
+  reset_response(&response, request0);
+  check_status(cache1->Lookup(response.get(), request0));
+  ASSERT_EQ(cache1->NumHits(), 1u);
+  ASSERT_EQ(cache1->NumRemoteHits(), 1u);
+
+  // A key missing in both tiers is a miss
+  reset_response(&response, request1);
+  ASSERT_FALSE(cache1->Lookup(response.get(), request1).IsOk());
+  ASSERT_EQ(cache1->NumRemoteHits(), 1u);
+
+  // Corrupted remote values are ignored
+  for (auto& value : remote->values_) {
+    value.second.resize(value.second.size() / 2);
+  }
+  check_status(cache0->Evict());
+  reset_response(&response, request0);
+  ASSERT_FALSE(cache0->Lookup(response.get(), request0).IsOk());
+  ASSERT_EQ(cache0->NumRemoteHits(), 0u);
+}
+
+// Test that a slow remote tier doesn't block lookups past the deadline
+TEST_F(RequestResponseCacheTest, TestRemoteTierDeadline)
+{
+  auto remote = std::make_shared<FakeRemoteTier>();
+  remote->respond_ = false;
+  tc::RequestResponseCache::Options options(1024);
+  options.remote_tier_ = remote;
+  options.remote_lookup_timeout_us_ = 1000;
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(options, &cache));
+
+  std::unique_ptr<tc::InferenceResponse> response;
+  reset_response(&response, request0);
+  ASSERT_FALSE(cache->Lookup(response.get(), request0).IsOk());
+  ASSERT_EQ(cache->NumRemoteTimeouts(), 1u);
+
+  // Completing the lookup after the deadline is harmless
+  ASSERT_EQ(remote->pending_.size(), 1u);
+  remote->pending_[0](tc::Status::Success, true, std::string("late"));
+  ASSERT_EQ(cache->NumEntries(), 0u);
+}
+
+// Test restoring the entries and LRU order of a cache from its snapshot
+TEST_F(RequestResponseCacheTest, TestSnapshot)
+{
+  const std::string path = ::testing::TempDir() + "response_cache_snapshot";
+  std::remove(path.c_str());
+  tc::RequestResponseCache::Options options(1024);
+  options.snapshot_path_ = path;
+
+  // Insert two entries and hit the first so the second is evicted first
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(options, &cache));
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  check_status(cache->Insert(*response0, request0));
+  check_status(cache->Insert(*response0, request1));
+  std::unique_ptr<tc::InferenceResponse> response;
+  reset_response(&response, request0);
+  check_status(cache->Lookup(response.get(), request0));
+  // The snapshot is written when the cache is destroyed
+  cache.reset();
+
+  // The restored cache keeps the LRU order, evicting the least recently
+  // used entry leaves the entry that was hit before the snapshot
+  check_status(tc::RequestResponseCache::Create(options, &cache));
+  ASSERT_EQ(cache->NumEntries(), 2u);
+  check_status(cache->Evict());
+  reset_response(&response, request1);
+  ASSERT_FALSE(cache->Lookup(response.get(), request1).IsOk());
+  reset_response(&response, request0);
+  check_status(cache->Lookup(response.get(), request0));
+  ASSERT_EQ(response->Outputs().size(), 1u);
+  const void* response_buffer = nullptr;
+  size_t response_byte_size = 0;
+  TRITONSERVER_MemoryType response_memory_type;
+  int64_t response_memory_type_id;
+  void* userp;
+  check_status(response->Outputs()[0].DataBuffer(
+      &response_buffer, &response_byte_size, &response_memory_type,
+      &response_memory_type_id, &userp));
+  ASSERT_EQ(response_byte_size, output0_size);
+  int* cache_output = (int*)response_buffer;
+  for (size_t i = 0; i < response_byte_size / sizeof(int); i++) {
+    ASSERT_EQ(cache_output[i], data0[i]);
+  }
+  cache.reset();
+
+  // A malformed snapshot is ignored
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "not a snapshot";
+  }
+  check_status(tc::RequestResponseCache::Create(options, &cache));
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  cache.reset();
+  std::remove(path.c_str());
+}
+
+// Test the per-model quota and admission policy
+TEST_F(RequestResponseCacheTest, TestModelPolicy)
+{
+  std::unique_ptr<tc::RequestResponseCache> cache;
+  check_status(tc::RequestResponseCache::Create(4096, &cache));
+  const std::string model_name = request0->ModelName();
+
+  // Responses larger than the entry limit are not admitted
+  tc::RequestResponseCache::ModelPolicy policy;
+  policy.max_entry_byte_size_ = output0_size;
+  cache->SetModelPolicy(model_name, policy);
+  auto status = cache->Insert(*response_400bytes, request0);
+  ASSERT_EQ(status.StatusCode(), tc::Status::Code::UNAVAILABLE);
+  ASSERT_EQ(cache->NumEntries(), 0u);
+  ASSERT_EQ(cache->ModelNumRejections(model_name), 1u);
+
+  // The quota limits the bytes held by the model, a response over the
+  // quota evicts the least recently used entry of the model
+  policy.max_entry_byte_size_ = 0;
+  policy.byte_quota_ = 2 * output0_size;
+  cache->SetModelPolicy(model_name, policy);
+  check_status(cache->Insert(*response0, random_requests[0]));
+  check_status(cache->Insert(*response0, random_requests[1]));
+  ASSERT_EQ(cache->ModelAllocatedBytes(model_name), 2 * output0_size);
+  std::unique_ptr<tc::InferenceResponse> response;
+  reset_response(&response, random_requests[0]);
+  check_status(cache->Lookup(response.get(), random_requests[0]));
+  check_status(cache->Insert(*response0, random_requests[2]));
+  ASSERT_EQ(cache->NumEntries(), 2u);
+  ASSERT_EQ(cache->NumEvictions(), 1u);
+  ASSERT_EQ(cache->ModelAllocatedBytes(model_name), 2 * output0_size);
+  reset_response(&response, random_requests[1]);
+  status = cache->Lookup(response.get(), random_requests[1]);
+  ASSERT_FALSE(status.IsOk());
+  reset_response(&response, random_requests[0]);
+  check_status(cache->Lookup(response.get(), random_requests[0]));
+
+  // Responses larger than the quota are not admitted
+  policy.byte_quota_ = output0_size - 1;
+  cache->SetModelPolicy(model_name, policy);
+  status = cache->Insert(*response0, random_requests[3]);
+  ASSERT_EQ(status.StatusCode(), tc::Status::Code::UNAVAILABLE);
+  ASSERT_EQ(cache->NumEntries(), 2u);
+
+  // A model that rarely hits only admits a sample of its responses
+  policy.byte_quota_ = 0;
+  policy.min_hit_rate_ = 0.5;
+  policy.min_lookups_ = 1;
+  cache->SetModelPolicy(model_name, policy);
+  size_t admitted = 0;
+  for (size_t idx = 4; idx < thread_count; idx++) {
+    if (cache->Insert(*response0, random_requests[idx]).IsOk()) {
+      admitted++;
+    }
+  }
+  ASSERT_LE(admitted, 1u);
+}
+
 }  // namespace
 
 int
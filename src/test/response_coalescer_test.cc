@@ -0,0 +1,195 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "infer_response.h"
+#include "response_coalescer.h"
+
+namespace tc = triton::core;
+
+namespace triton { namespace core {
+
+// The responses of the test are never sent, so only a null response is
+// needed instead of linking the complete response implementation.
+InferenceResponse::InferenceResponse(
+    TRITONSERVER_InferenceResponseCompleteFn_t response_fn,
+    void* response_userp)
+    : parameters_(ParameterDeque::allocator_type(&arena_)),
+      outputs_(OutputDeque::allocator_type(&arena_)),
+      response_fn_(response_fn), response_userp_(response_userp),
+      null_response_(true)
+{
+}
+
+InferenceResponse::Output::~Output() {}
+
+}}  // namespace triton::core
+
+namespace {
+
+// The batches delivered to the batch response callback.
+struct Delivered {
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<uint32_t> batch_sizes_;
+  std::vector<uint32_t> batch_flags_;
+  size_t response_count_ = 0;
+  // Set to enqueue one more response from within the first callback.
+  std::shared_ptr<tc::ResponseCoalescer> reenter_;
+};
+
+void
+BatchComplete(
+    TRITONSERVER_InferenceResponse** responses, const uint32_t response_count,
+    const uint32_t flags, void* userp)
+{
+  auto delivered = reinterpret_cast<Delivered*>(userp);
+  for (uint32_t idx = 0; idx < response_count; ++idx) {
+    delete reinterpret_cast<tc::InferenceResponse*>(responses[idx]);
+  }
+  std::shared_ptr<tc::ResponseCoalescer> reenter;
+  {
+    std::lock_guard<std::mutex> lk(delivered->mu_);
+    delivered->batch_sizes_.push_back(response_count);
+    delivered->batch_flags_.push_back(flags);
+    delivered->response_count_ += response_count;
+    reenter.swap(delivered->reenter_);
+  }
+  delivered->cv_.notify_all();
+  if (reenter != nullptr) {
+    reenter->Enqueue(
+        std::unique_ptr<tc::InferenceResponse>(
+            new tc::InferenceResponse(nullptr, nullptr)),
+        TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+  }
+}
+
+std::unique_ptr<tc::InferenceResponse>
+NullResponse()
+{
+  return std::unique_ptr<tc::InferenceResponse>(
+      new tc::InferenceResponse(nullptr, nullptr));
+}
+
+TEST(ResponseCoalescerTest, FlushAfterDelay)
+{
+  Delivered delivered;
+  std::shared_ptr<tc::ResponseCoalescer> coalescer;
+  ASSERT_TRUE(tc::ResponseCoalescer::Create(
+                  BatchComplete, &delivered, 8 /* max_response_count */,
+                  1000 /* max_delay_us */, &coalescer)
+                  .IsOk());
+
+  coalescer->Enqueue(NullResponse(), 0 /* flags */);
+  coalescer->Enqueue(NullResponse(), 0 /* flags */);
+  {
+    std::unique_lock<std::mutex> lk(delivered.mu_);
+    ASSERT_TRUE(delivered.cv_.wait_for(lk, std::chrono::seconds(10), [&] {
+      return delivered.response_count_ == 2;
+    })) << "Expect the responses to be flushed after the delay";
+    EXPECT_EQ(delivered.batch_sizes_, std::vector<uint32_t>({2}));
+    EXPECT_EQ(delivered.batch_flags_, std::vector<uint32_t>({0}));
+  }
+}
+
+TEST(ResponseCoalescerTest, EnqueueFromCallback)
+{
+  // The callback is not invoked with the coalescer locked, so it may send
+  // the next response itself.
+  Delivered delivered;
+  std::shared_ptr<tc::ResponseCoalescer> coalescer;
+  ASSERT_TRUE(tc::ResponseCoalescer::Create(
+                  BatchComplete, &delivered, 1 /* max_response_count */,
+                  0 /* max_delay_us */, &coalescer)
+                  .IsOk());
+  delivered.reenter_ = coalescer;
+
+  coalescer->Enqueue(NullResponse(), 0 /* flags */);
+  std::lock_guard<std::mutex> lk(delivered.mu_);
+  EXPECT_EQ(delivered.batch_sizes_, std::vector<uint32_t>({1, 1}));
+  EXPECT_EQ(
+      delivered.batch_flags_,
+      std::vector<uint32_t>({0, TRITONSERVER_RESPONSE_COMPLETE_FINAL}));
+}
+
+TEST(ResponseCoalescerTest, ConcurrentFlush)
+{
+  // The responses are sent from several threads while the flush timer
+  // delivers the batches whose delay expired.
+  const size_t thread_count = 4;
+  const size_t responses_per_thread = 2000;
+  const uint32_t max_response_count = 16;
+  Delivered delivered;
+  std::shared_ptr<tc::ResponseCoalescer> coalescer;
+  ASSERT_TRUE(tc::ResponseCoalescer::Create(
+                  BatchComplete, &delivered, max_response_count,
+                  20 /* max_delay_us */, &coalescer)
+                  .IsOk());
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&coalescer, responses_per_thread]() {
+      for (size_t idx = 0; idx < responses_per_thread; ++idx) {
+        coalescer->Enqueue(NullResponse(), 0 /* flags */);
+        if ((idx % 64) == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  coalescer->Enqueue(nullptr, TRITONSERVER_RESPONSE_COMPLETE_FINAL);
+
+  std::lock_guard<std::mutex> lk(delivered.mu_);
+  EXPECT_EQ(delivered.response_count_, thread_count * responses_per_thread);
+  ASSERT_FALSE(delivered.batch_flags_.empty());
+  for (size_t idx = 0; idx < delivered.batch_sizes_.size(); ++idx) {
+    EXPECT_LE(delivered.batch_sizes_[idx], max_response_count);
+    EXPECT_EQ(
+        delivered.batch_flags_[idx],
+        (idx + 1 == delivered.batch_flags_.size())
+            ? TRITONSERVER_RESPONSE_COMPLETE_FINAL
+            : 0)
+        << "Expect only the last batch to be final, batch " << idx;
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+#include "sequence_stats.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(SequenceStatsTrackerTest, SlotsAndBacklog)
+{
+  tc::SequenceStatsTracker tracker;
+  tracker.SetBatcherCount(2);
+
+  tracker.SequenceSlotAssigned(0, 0);
+  tracker.SequenceSlotAssigned(1, 0);
+  tracker.SequenceSlotAssigned(1, 0);
+  tracker.SequenceBacklogged();
+  tracker.SequenceBacklogged();
+
+  auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.active_count_, 3u);
+  EXPECT_EQ(stats.backlog_count_, 2u);
+  ASSERT_EQ(stats.slots_occupied_.size(), 2u);
+  EXPECT_EQ(stats.slots_occupied_[0], 1u);
+  EXPECT_EQ(stats.slots_occupied_[1], 2u);
+
+  // A backlogged sequence takes the slot of an ended sequence
+  tracker.SequenceUnbacklogged();
+  tracker.SequenceSlotReleased(1);
+  tracker.SequenceSlotAssigned(1, 500);
+  tracker.SequenceSlotReleased(0);
+
+  stats = tracker.GetStats();
+  EXPECT_EQ(stats.active_count_, 2u);
+  EXPECT_EQ(stats.backlog_count_, 1u);
+  EXPECT_EQ(stats.slot_count_, 4u);
+  EXPECT_EQ(stats.slot_wait_duration_ns_, 500u);
+  EXPECT_EQ(stats.slots_occupied_[0], 0u);
+  EXPECT_EQ(stats.slots_occupied_[1], 2u);
+}
+
+TEST(SequenceStatsTrackerTest, EvictedAndRejected)
+{
+  tc::SequenceStatsTracker tracker;
+  tracker.SetBatcherCount(1);
+
+  tracker.SequenceEvicted();
+  tracker.SequenceRejected();
+  tracker.SequenceRejected();
+
+  const auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.evicted_count_, 1u);
+  EXPECT_EQ(stats.rejected_count_, 2u);
+  EXPECT_EQ(stats.active_count_, 0u);
+
+  // An unknown batcher is not accounted in the slot occupancy
+  tracker.SequenceSlotAssigned(5, 0);
+  EXPECT_EQ(tracker.GetStats().active_count_, 1u);
+  EXPECT_EQ(tracker.GetStats().slots_occupied_[0], 0u);
+}
+
+TEST(SequenceStatsTrackerTest, ConcurrentUpdates)
+{
+  tc::SequenceStatsTracker tracker;
+  tracker.SetBatcherCount(4);
+
+  const size_t thread_cnt = 4;
+  const size_t iteration_cnt = 10000;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_cnt; ++t) {
+    threads.emplace_back([&tracker, t, iteration_cnt]() {
+      for (size_t i = 0; i < iteration_cnt; ++i) {
+        tracker.SequenceSlotAssigned(t, 1);
+        if ((i % 2) == 0) {
+          tracker.SequenceSlotReleased(t);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const auto stats = tracker.GetStats();
+  EXPECT_EQ(stats.slot_count_, thread_cnt * iteration_cnt);
+  EXPECT_EQ(stats.slot_wait_duration_ns_, thread_cnt * iteration_cnt);
+  EXPECT_EQ(stats.active_count_, thread_cnt * iteration_cnt / 2);
+  for (size_t t = 0; t < thread_cnt; ++t) {
+    EXPECT_EQ(stats.slots_occupied_[t], iteration_cnt / 2);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,231 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <cuda_runtime_api.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "infer_request.h"
+#include "shape_bucket_key.h"
+
+namespace tc = triton::core;
+
+/* Mock classes for Unit Testing */
+namespace triton { namespace core {
+
+//
+// InferenceRequest
+//
+InferenceRequest::Input::Input(
+    const std::string& name, const inference::DataType datatype,
+    const int64_t* shape, const uint64_t dim_count)
+    : name_(name), datatype_(datatype),
+      original_shape_(shape, shape + dim_count), is_shape_tensor_(false),
+      data_(new MemoryReference), has_host_policy_specific_data_(false)
+{
+}
+
+Status
+InferenceRequest::PrepareForInference()
+{
+  ClearInferenceInputs();
+  for (auto& pr : original_inputs_) {
+    inputs_.Emplace(std::addressof(pr.second), pr.second.ConfigIndex());
+  }
+  return Status::Success;
+}
+
+void
+InferenceRequest::ClearInferenceInputs()
+{
+  inputs_ = InputMap(InputMap::allocator_type(&arena_));
+  override_inputs_ =
+      OverrideInputMap(OverrideInputMap::allocator_type(&arena_));
+  arena_.Reset();
+}
+
+void
+InferenceRequest::SetPriority(unsigned int)
+{
+}
+
+Status
+InferenceRequest::AddOriginalInput(
+    const std::string& name, const inference::DataType datatype,
+    const int64_t* shape, const uint64_t dim_count,
+    InferenceRequest::Input** input)
+{
+  const auto& pr = original_inputs_.emplace(
+      std::piecewise_construct, std::forward_as_tuple(name),
+      std::forward_as_tuple(name, datatype, shape, dim_count));
+  if (!pr.second) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "input '" + name + "' already exists in request");
+  }
+
+  if (input != nullptr) {
+    *input = std::addressof(pr.first->second);
+  }
+
+  needs_normalization_ = true;
+  return Status::Success;
+}
+
+Status
+InferenceRequest::AddOriginalInput(
+    const std::string& name, const inference::DataType datatype,
+    const std::vector<int64_t>& shape, InferenceRequest::Input** input)
+{
+  return AddOriginalInput(name, datatype, &shape[0], shape.size(), input);
+}
+
+Status
+InferenceRequest::Input::AppendData(
+    const void* base, size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  if (byte_size > 0) {
+    std::static_pointer_cast<MemoryReference>(data_)->AddBuffer(
+        static_cast<const char*>(base), byte_size, memory_type, memory_type_id);
+  }
+
+  return Status::Success;
+}
+
+}}  // namespace triton::core
+
+namespace {
+
+class ShapeBucketKeyTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    auto cuerr = cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking);
+    ASSERT_TRUE(cuerr == cudaSuccess)
+        << "Failed to create stream: " << cudaGetErrorString(cuerr);
+  }
+
+  void TearDown() override
+  {
+    for (void* buffer : device_buffers_) {
+      cudaFree(buffer);
+    }
+    cudaStreamDestroy(stream_);
+  }
+
+  // Return a request with the data input "INPUT" and the shape tensor
+  // "SHAPE" holding 'shape_values' in 'memory_type' memory.
+  std::unique_ptr<tc::InferenceRequest> MakeRequest(
+      const std::vector<int32_t>& shape_values,
+      const TRITONSERVER_MemoryType memory_type)
+  {
+    std::unique_ptr<tc::InferenceRequest> request(
+        new tc::InferenceRequest(nullptr /* model */, 1 /* version */));
+    tc::InferenceRequest::Input* input = nullptr;
+    EXPECT_TRUE(request
+                    ->AddOriginalInput(
+                        "INPUT", inference::DataType::TYPE_FP32,
+                        std::vector<int64_t>{1, 4}, &input)
+                    .IsOk());
+    input->AppendData(
+        input_data_.data(), input_data_.size() * sizeof(float),
+        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */);
+
+    const size_t byte_size = shape_values.size() * sizeof(int32_t);
+    const void* shape_buffer = shape_values.data();
+    if (memory_type == TRITONSERVER_MEMORY_GPU) {
+      void* device_buffer = nullptr;
+      auto cuerr = cudaMalloc(&device_buffer, byte_size);
+      EXPECT_TRUE(cuerr == cudaSuccess)
+          << "Failed to allocate device buffer: " << cudaGetErrorString(cuerr);
+      device_buffers_.push_back(device_buffer);
+      cuerr = cudaMemcpy(
+          device_buffer, shape_values.data(), byte_size,
+          cudaMemcpyHostToDevice);
+      EXPECT_TRUE(cuerr == cudaSuccess)
+          << "Failed to write device buffer: " << cudaGetErrorString(cuerr);
+      shape_buffer = device_buffer;
+    }
+    EXPECT_TRUE(request
+                    ->AddOriginalInput(
+                        "SHAPE", inference::DataType::TYPE_INT32,
+                        std::vector<int64_t>{
+                            1, static_cast<int64_t>(shape_values.size())},
+                        &input)
+                    .IsOk());
+    input->AppendData(shape_buffer, byte_size, memory_type, 0);
+    EXPECT_TRUE(request->PrepareForInference().IsOk());
+    return request;
+  }
+
+  uint64_t Key(const tc::InferenceRequest& request)
+  {
+    return tc::ShapeBucketKey(
+        request, enforce_equal_shape_tensors_, false /* has_optional_input */,
+        stream_);
+  }
+
+  const std::unordered_map<std::string, bool> enforce_equal_shape_tensors_{
+      {"INPUT", false}, {"SHAPE", true}};
+  const std::vector<float> input_data_{1, 2, 3, 4};
+  std::vector<void*> device_buffers_;
+  cudaStream_t stream_ = nullptr;
+};
+
+TEST_F(ShapeBucketKeyTest, IdenticalGpuShapeTensorsShareBucket)
+{
+  // The batcher dispatches the requests of a bucket together, so equal
+  // keys mean the requests are batched together.
+  auto request0 = MakeRequest({2, 8}, TRITONSERVER_MEMORY_GPU);
+  auto request1 = MakeRequest({2, 8}, TRITONSERVER_MEMORY_GPU);
+  EXPECT_EQ(Key(*request0), Key(*request1));
+}
+
+TEST_F(ShapeBucketKeyTest, DifferentGpuShapeTensorsSplit)
+{
+  auto request0 = MakeRequest({2, 8}, TRITONSERVER_MEMORY_GPU);
+  auto request1 = MakeRequest({2, 16}, TRITONSERVER_MEMORY_GPU);
+  EXPECT_NE(Key(*request0), Key(*request1));
+}
+
+TEST_F(ShapeBucketKeyTest, GpuAndCpuShapeTensorsShareBucket)
+{
+  auto request0 = MakeRequest({2, 8}, TRITONSERVER_MEMORY_GPU);
+  auto request1 = MakeRequest({2, 8}, TRITONSERVER_MEMORY_CPU);
+  EXPECT_EQ(Key(*request0), Key(*request1));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
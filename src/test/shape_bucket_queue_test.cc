@@ -0,0 +1,134 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "shape_bucket_queue.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kUs = 1000;
+
+TEST(ShapeBucketIndexTest, BucketsByKey)
+{
+  tc::ShapeBucketIndex index;
+  EXPECT_TRUE(index.Empty());
+  index.Add(16, 1, 0);
+  index.Add(32, 1, 1 * kUs);
+  index.Add(16, 1, 2 * kUs);
+  EXPECT_EQ(index.Size(), 3);
+  EXPECT_EQ(index.BucketCount(), 2);
+  EXPECT_EQ(index.Count(16), 2);
+
+  // Neither bucket is full or waited for the delay
+  uint64_t key;
+  EXPECT_EQ(index.NextReady(10 * kUs, 4, 100 * kUs, &key), 90 * kUs);
+
+  // The bucket of the oldest request is dispatched first
+  EXPECT_EQ(index.NextReady(100 * kUs, 4, 100 * kUs, &key), 0);
+  EXPECT_EQ(key, 16);
+  index.Remove(16, 1, 0);
+  index.Remove(16, 1, 2 * kUs);
+  EXPECT_EQ(index.Count(16), 0);
+  EXPECT_EQ(index.BucketCount(), 1);
+  EXPECT_EQ(index.NextReady(100 * kUs, 4, 100 * kUs, &key), 1 * kUs);
+}
+
+TEST(ShapeBucketIndexTest, FullBucket)
+{
+  tc::ShapeBucketIndex index;
+  index.Add(16, 1, 0);
+  index.Add(32, 3, 1 * kUs);
+  index.Add(32, 3, 2 * kUs);
+
+  // The full bucket is ready even though the other one is older
+  uint64_t key;
+  EXPECT_EQ(index.NextReady(10 * kUs, 4, 100 * kUs, &key), 0);
+  EXPECT_EQ(key, 32);
+
+  // Once a request leaves, the bucket waits for the delay again
+  index.Remove(32, 3, 1 * kUs);
+  EXPECT_EQ(index.NextReady(10 * kUs, 4, 100 * kUs, &key), 90 * kUs);
+
+  // A zero delay makes every bucket ready
+  EXPECT_EQ(index.NextReady(10 * kUs, 4, 0, &key), 0);
+  EXPECT_EQ(key, 16);
+}
+
+TEST(ShapeBucketIndexTest, RemoveOldest)
+{
+  tc::ShapeBucketIndex index;
+  index.Add(16, 1, 5 * kUs);
+  index.Add(16, 1, 1 * kUs);
+  index.Add(16, 1, 5 * kUs);
+
+  // Removing the oldest request, e.g. on timeout, moves the age of the
+  // bucket to the next oldest one
+  index.Remove(16, 1, 1 * kUs);
+  uint64_t key;
+  EXPECT_EQ(index.NextReady(10 * kUs, 4, 10 * kUs, &key), 5 * kUs);
+
+  // Removing a request that is not in the index is ignored
+  index.Remove(16, 1, 3 * kUs);
+  index.Remove(32, 1, 5 * kUs);
+  EXPECT_EQ(index.Size(), 2);
+  index.Remove(16, 1, 5 * kUs);
+  index.Remove(16, 1, 5 * kUs);
+  EXPECT_TRUE(index.Empty());
+  EXPECT_EQ(index.BucketCount(), 0);
+}
+
+TEST(ShapeBucketIndexTest, BucketDim)
+{
+  EXPECT_EQ(tc::BucketDim(1, 16), 16);
+  EXPECT_EQ(tc::BucketDim(16, 16), 16);
+  EXPECT_EQ(tc::BucketDim(17, 16), 32);
+  EXPECT_EQ(tc::BucketDim(17, 0), 17);
+  EXPECT_EQ(tc::BucketDim(-1, 16), -1);
+}
+
+TEST(ShapeBucketIndexTest, PadTensor)
+{
+  const int32_t src[] = {1, 2, 3, 4, 5, 6};
+  int32_t dst[12];
+  tc::PadTensor(
+      reinterpret_cast<const char*>(src), {2, 3}, {3, 4}, sizeof(int32_t),
+      reinterpret_cast<char*>(dst));
+  const int32_t expected[] = {1, 2, 3, 0, 4, 5, 6, 0, 0, 0, 0, 0};
+  for (size_t idx = 0; idx < 12; ++idx) {
+    EXPECT_EQ(dst[idx], expected[idx]) << "at " << idx;
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
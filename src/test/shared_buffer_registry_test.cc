@@ -0,0 +1,175 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <future>
+#include <thread>
+
+#include "shared_buffer_registry.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr uint64_t kByteSize = 64;
+
+// Holders of the buffers
+const int kFirst = 0;
+const int kSecond = 1;
+
+struct Acquired {
+  tc::Status status_;
+  void* buffer_ = nullptr;
+  bool initialize_ = false;
+};
+
+Acquired
+Acquire(tc::SharedBufferRegistry* registry, const void* holder)
+{
+  Acquired acquired;
+  acquired.status_ = registry->Acquire(
+      holder, "weights", TRITONSERVER_MEMORY_CPU, 0, kByteSize,
+      &acquired.buffer_, &acquired.initialize_);
+  return acquired;
+}
+
+// Acquire in another thread and check that it waits
+std::future<Acquired>
+AcquireAsync(tc::SharedBufferRegistry* registry, const void* holder)
+{
+  auto acquired = std::async(std::launch::async, Acquire, registry, holder);
+  EXPECT_EQ(
+      acquired.wait_for(std::chrono::milliseconds(50)),
+      std::future_status::timeout)
+      << "Expect the acquisition waits for the initialization";
+  return acquired;
+}
+
+class SharedBufferRegistryTest : public ::testing::Test {
+ protected:
+  SharedBufferRegistryTest() : registry_("model", nullptr, 60 * 1000) {}
+
+  tc::SharedBufferRegistry registry_;
+};
+
+TEST_F(SharedBufferRegistryTest, InitializeOnce)
+{
+  auto first = Acquire(&registry_, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+  EXPECT_TRUE(first.initialize_);
+  ASSERT_NE(first.buffer_, nullptr);
+
+  auto second = AcquireAsync(&registry_, &kSecond);
+  auto status = registry_.SetInitialized(
+      &kFirst, "first", "weights", TRITONSERVER_MEMORY_CPU, 0, true);
+  ASSERT_TRUE(status.IsOk()) << status.AsString();
+  auto acquired = second.get();
+  ASSERT_TRUE(acquired.status_.IsOk()) << acquired.status_.AsString();
+  EXPECT_FALSE(acquired.initialize_);
+  EXPECT_EQ(acquired.buffer_, first.buffer_) << "Expect the buffer is shared";
+
+  registry_.Release(&kFirst, "first");
+  registry_.Release(&kSecond, "second");
+}
+
+TEST_F(SharedBufferRegistryTest, SizeMismatch)
+{
+  auto first = Acquire(&registry_, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+  void* buffer;
+  bool initialize;
+  auto status = registry_.Acquire(
+      &kSecond, "weights", TRITONSERVER_MEMORY_CPU, 0, kByteSize * 2, &buffer,
+      &initialize);
+  EXPECT_EQ(status.StatusCode(), tc::Status::Code::INVALID_ARG);
+  registry_.Release(&kFirst, "first");
+}
+
+TEST_F(SharedBufferRegistryTest, FailedInitialization)
+{
+  auto first = Acquire(&registry_, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+
+  auto second = AcquireAsync(&registry_, &kSecond);
+  auto status = registry_.SetInitialized(
+      &kFirst, "first", "weights", TRITONSERVER_MEMORY_CPU, 0, false);
+  ASSERT_TRUE(status.IsOk()) << status.AsString();
+  auto acquired = second.get();
+  ASSERT_TRUE(acquired.status_.IsOk()) << acquired.status_.AsString();
+  EXPECT_TRUE(acquired.initialize_)
+      << "Expect the next holder initializes a new buffer";
+  registry_.Release(&kSecond, "second");
+}
+
+TEST_F(SharedBufferRegistryTest, ReleaseUninitialized)
+{
+  auto first = Acquire(&registry_, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+
+  auto second = AcquireAsync(&registry_, &kSecond);
+  registry_.Release(&kFirst, "first");
+  auto acquired = second.get();
+  ASSERT_TRUE(acquired.status_.IsOk()) << acquired.status_.AsString();
+  EXPECT_TRUE(acquired.initialize_)
+      << "Expect the next holder initializes a new buffer";
+  registry_.Release(&kSecond, "second");
+}
+
+TEST_F(SharedBufferRegistryTest, WaitTimeout)
+{
+  tc::SharedBufferRegistry registry("model", nullptr, 100 /* ms */);
+  auto first = Acquire(&registry, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+
+  // The initializer never reports the initialization
+  auto second = AcquireAsync(&registry, &kSecond);
+  ASSERT_EQ(
+      second.wait_for(std::chrono::seconds(10)), std::future_status::ready)
+      << "Expect the acquisition times out";
+  auto acquired = second.get();
+  EXPECT_EQ(acquired.status_.StatusCode(), tc::Status::Code::UNAVAILABLE)
+      << acquired.status_.AsString();
+  registry.Release(&kFirst, "first");
+}
+
+TEST_F(SharedBufferRegistryTest, StopReleasesWaiters)
+{
+  auto first = Acquire(&registry_, &kFirst);
+  ASSERT_TRUE(first.status_.IsOk()) << first.status_.AsString();
+
+  auto second = AcquireAsync(&registry_, &kSecond);
+  registry_.Stop();
+  auto acquired = second.get();
+  EXPECT_EQ(acquired.status_.StatusCode(), tc::Status::Code::UNAVAILABLE)
+      << acquired.status_.AsString();
+
+  auto third = Acquire(&registry_, &kSecond);
+  EXPECT_FALSE(third.status_.IsOk())
+      << "Expect no acquisition once the registry is stopped";
+  registry_.Release(&kFirst, "first");
+}
+
+}  // namespace
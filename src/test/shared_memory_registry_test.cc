@@ -0,0 +1,169 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "shared_memory_registry.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+constexpr size_t kObjectByteSize = 64 * 1024;
+
+// Creates a POSIX shared memory object and maps it as the consumer
+// process would.
+class SharedMemoryRegistryTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    key_ = "/triton_shm_registry_test_" + std::to_string(getpid());
+    const int fd = shm_open(key_.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    ASSERT_NE(fd, -1) << "failed to create shared memory object";
+    ASSERT_EQ(ftruncate(fd, kObjectByteSize), 0);
+    consumer_ = reinterpret_cast<char*>(mmap(
+        nullptr, kObjectByteSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+        0));
+    close(fd);
+    ASSERT_NE(consumer_, MAP_FAILED);
+  }
+
+  void TearDown() override
+  {
+    munmap(consumer_, kObjectByteSize);
+    shm_unlink(key_.c_str());
+  }
+
+  std::string key_;
+  char* consumer_;
+};
+
+TEST_F(SharedMemoryRegistryTest, Register)
+{
+  ASSERT_TRUE(tc::SharedMemoryRegistry::RegisterSystemRegion(
+                  "region", key_, 0, kObjectByteSize)
+                  .IsOk());
+  EXPECT_EQ(
+      tc::SharedMemoryRegistry::RegisterSystemRegion(
+          "region", key_, 0, kObjectByteSize)
+          .StatusCode(),
+      tc::Status::Code::ALREADY_EXISTS);
+
+  std::shared_ptr<tc::SharedMemoryRegion> region;
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Find("region", &region).IsOk());
+  EXPECT_EQ(region->MemoryType(), TRITONSERVER_MEMORY_CPU);
+  EXPECT_EQ(region->ByteSize(), kObjectByteSize);
+  EXPECT_EQ(region->CudaIpcHandle(), nullptr);
+
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Unregister("region").IsOk());
+  EXPECT_EQ(
+      tc::SharedMemoryRegistry::Find("region", &region).StatusCode(),
+      tc::Status::Code::NOT_FOUND);
+  EXPECT_EQ(
+      tc::SharedMemoryRegistry::Unregister("region").StatusCode(),
+      tc::Status::Code::NOT_FOUND);
+}
+
+TEST_F(SharedMemoryRegistryTest, RegisterInvalid)
+{
+  EXPECT_FALSE(tc::SharedMemoryRegistry::RegisterSystemRegion(
+                   "region", key_, 1024, kObjectByteSize)
+                   .IsOk());
+  EXPECT_FALSE(tc::SharedMemoryRegistry::RegisterSystemRegion(
+                   "region", key_ + "_missing", 0, 1024)
+                   .IsOk());
+  EXPECT_FALSE(
+      tc::SharedMemoryRegistry::RegisterSystemRegion("region", key_, 0, 0)
+          .IsOk());
+}
+
+TEST_F(SharedMemoryRegistryTest, ZeroCopy)
+{
+  // The region starts at an offset that is not page-aligned
+  constexpr size_t kOffset = 1000;
+  ASSERT_TRUE(tc::SharedMemoryRegistry::RegisterSystemRegion(
+                  "region", key_, kOffset, kObjectByteSize - kOffset)
+                  .IsOk());
+  std::shared_ptr<tc::SharedMemoryRegion> region;
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Find("region", &region).IsOk());
+
+  void* buffer;
+  size_t offset;
+  ASSERT_TRUE(region->Allocate(100, &buffer, &offset));
+  EXPECT_EQ(offset, 0);
+  memcpy(buffer, "output", 7);
+  EXPECT_STREQ(consumer_ + kOffset + offset, "output");
+
+  // Buffers are aligned from the start of the region
+  void* next_buffer;
+  size_t next_offset;
+  ASSERT_TRUE(region->Allocate(100, &next_buffer, &next_offset));
+  EXPECT_EQ(next_offset, 256);
+  EXPECT_EQ(reinterpret_cast<char*>(next_buffer), (char*)buffer + 256);
+
+  region->Release(offset);
+  region->Release(next_offset);
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Unregister("region").IsOk());
+}
+
+TEST_F(SharedMemoryRegistryTest, Reuse)
+{
+  ASSERT_TRUE(tc::SharedMemoryRegistry::RegisterSystemRegion(
+                  "region", key_, 0, 4096)
+                  .IsOk());
+  std::shared_ptr<tc::SharedMemoryRegion> region;
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Find("region", &region).IsOk());
+
+  void* buffer;
+  size_t offsets[3];
+  ASSERT_TRUE(region->Allocate(1024, &buffer, &offsets[0]));
+  ASSERT_TRUE(region->Allocate(1024, &buffer, &offsets[1]));
+  ASSERT_TRUE(region->Allocate(2048, &buffer, &offsets[2]));
+  size_t offset;
+  EXPECT_FALSE(region->Allocate(1, &buffer, &offset));
+
+  // The released ranges are merged to fit a larger buffer
+  region->Release(offsets[0]);
+  EXPECT_FALSE(region->Allocate(2048, &buffer, &offset));
+  region->Release(offsets[1]);
+  ASSERT_TRUE(region->Allocate(2048, &buffer, &offset));
+  EXPECT_EQ(offset, 0);
+
+  region->Release(offset);
+  region->Release(offsets[2]);
+  ASSERT_TRUE(region->Allocate(4096, &buffer, &offset));
+  region->Release(offset);
+  ASSERT_TRUE(tc::SharedMemoryRegistry::Unregister("region").IsOk());
+}
+
+}  // namespace
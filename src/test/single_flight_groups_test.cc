@@ -0,0 +1,132 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <vector>
+
+#include "single_flight_groups.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+using Groups = tc::SingleFlightGroups<int>;
+
+std::unique_ptr<int>
+Item(const int value)
+{
+  return std::unique_ptr<int>(new int(value));
+}
+
+TEST(SingleFlightGroupsTest, LeaderAndWaiters)
+{
+  Groups groups;
+  auto leader = Item(0);
+  EXPECT_TRUE(groups.Join(1, leader));
+  ASSERT_NE(leader, nullptr) << "Expect the leader is not taken";
+
+  for (int i = 1; i <= 3; ++i) {
+    auto waiter = Item(i);
+    EXPECT_FALSE(groups.Join(1, waiter));
+    EXPECT_EQ(waiter, nullptr) << "Expect the waiter is taken";
+  }
+  auto other = Item(4);
+  EXPECT_TRUE(groups.Join(2, other)) << "Expect a group per key";
+
+  auto waiters = groups.Release(1, leader.get());
+  ASSERT_EQ(waiters.size(), (size_t)3);
+  for (size_t i = 0; i < waiters.size(); ++i) {
+    EXPECT_EQ(*waiters[i], (int)i + 1) << "Expect waiters in join order";
+  }
+  EXPECT_TRUE(groups.Release(1, leader.get()).empty())
+      << "Expect a group is released once";
+}
+
+TEST(SingleFlightGroupsTest, ReleaseByNonLeader)
+{
+  Groups groups;
+  auto leader = Item(0);
+  auto waiter = Item(1);
+  ASSERT_TRUE(groups.Join(1, leader));
+  ASSERT_FALSE(groups.Join(1, waiter));
+
+  auto stranger = Item(2);
+  EXPECT_TRUE(groups.Release(1, stranger.get()).empty())
+      << "Expect only the leader releases the group";
+  EXPECT_EQ(groups.Release(1, leader.get()).size(), (size_t)1);
+}
+
+TEST(SingleFlightGroupsTest, StaleLeader)
+{
+  Groups groups;
+  auto first_leader = Item(0);
+  ASSERT_TRUE(groups.Join(1, first_leader));
+  ASSERT_TRUE(groups.Release(1, first_leader.get()).empty());
+
+  // A newer leader of the same key must keep its waiters when the first
+  // leader releases again, e.g. once it is destroyed
+  auto second_leader = Item(1);
+  auto waiter = Item(2);
+  ASSERT_TRUE(groups.Join(1, second_leader));
+  ASSERT_FALSE(groups.Join(1, waiter));
+  EXPECT_TRUE(groups.Release(1, first_leader.get()).empty());
+
+  auto waiters = groups.Release(1, second_leader.get());
+  ASSERT_EQ(waiters.size(), (size_t)1);
+  EXPECT_EQ(*waiters[0], 2);
+}
+
+TEST(SingleFlightGroupsTest, ElectNewLeader)
+{
+  Groups groups;
+  auto leader = Item(0);
+  ASSERT_TRUE(groups.Join(1, leader));
+  for (int i = 1; i <= 3; ++i) {
+    auto waiter = Item(i);
+    ASSERT_FALSE(groups.Join(1, waiter));
+  }
+
+  // The leader failed, the released waiters rejoin so that only the first
+  // of them executes
+  auto waiters = groups.Release(1, leader.get());
+  ASSERT_EQ(waiters.size(), (size_t)3);
+  std::vector<std::unique_ptr<int>> leaders;
+  for (auto& waiter : waiters) {
+    if (groups.Join(1, waiter)) {
+      leaders.emplace_back(std::move(waiter));
+    }
+  }
+  ASSERT_EQ(leaders.size(), (size_t)1) << "Expect a single new leader";
+  EXPECT_EQ(*leaders[0], 1);
+
+  auto remaining = groups.Release(1, leaders[0].get());
+  ASSERT_EQ(remaining.size(), (size_t)2);
+  EXPECT_EQ(*remaining[0], 2);
+  EXPECT_EQ(*remaining[1], 3);
+}
+
+}  // namespace
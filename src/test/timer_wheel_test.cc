@@ -0,0 +1,150 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+#include "timer_wheel.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(TimerWheelTest, ExpireInOrder)
+{
+  tc::TimerWheel wheel(10, 1000);
+  wheel.Schedule(1055, 1);
+  wheel.Schedule(1015, 2);
+  wheel.Schedule(900, 3);
+  EXPECT_EQ(wheel.Size(), 3u);
+
+  std::vector<uint64_t> expired;
+  wheel.Advance(1000, &expired);
+  EXPECT_EQ(expired, std::vector<uint64_t>({3}))
+      << "Expect deadline in the past to expire immediately";
+
+  expired.clear();
+  wheel.Advance(1019, &expired);
+  EXPECT_TRUE(expired.empty()) << "Expect timer to expire after its tick";
+  wheel.Advance(1020, &expired);
+  EXPECT_EQ(expired, std::vector<uint64_t>({2}));
+
+  expired.clear();
+  wheel.Advance(2000, &expired);
+  EXPECT_EQ(expired, std::vector<uint64_t>({1}));
+  EXPECT_EQ(wheel.Size(), 0u);
+}
+
+TEST(TimerWheelTest, PastDeadline)
+{
+  // A timer scheduled in the past counts as pending until it is expired
+  // by the next advance, even if the wheel holds no other timer.
+  tc::TimerWheel wheel(10, 1000);
+  wheel.Schedule(500, 1);
+  EXPECT_EQ(wheel.Size(), 1u);
+
+  std::vector<uint64_t> expired;
+  wheel.Advance(1000, &expired);
+  EXPECT_EQ(expired, std::vector<uint64_t>({1}));
+  EXPECT_EQ(wheel.Size(), 0u);
+
+  wheel.Schedule(2000, 2);
+  wheel.Schedule(900, 3);
+  EXPECT_EQ(wheel.Size(), 2u);
+  expired.clear();
+  wheel.Advance(1005, &expired);
+  EXPECT_EQ(expired, std::vector<uint64_t>({3}));
+  EXPECT_EQ(wheel.Size(), 1u);
+}
+
+TEST(TimerWheelTest, LongTimeouts)
+{
+  // Deadlines spread over all levels and beyond the range of the wheel
+  tc::TimerWheel wheel(1, 0);
+  const std::vector<uint64_t> deadlines{
+      10, 100, 5000, 300000, 20000000, 1ULL << 30, 1ULL << 40};
+  for (size_t idx = 0; idx < deadlines.size(); ++idx) {
+    wheel.Schedule(deadlines[idx], idx);
+  }
+
+  for (size_t idx = 0; idx < deadlines.size(); ++idx) {
+    std::vector<uint64_t> expired;
+    wheel.Advance(deadlines[idx], &expired);
+    EXPECT_TRUE(expired.empty()) << "Expect timer " << idx << " not expired";
+    wheel.Advance(deadlines[idx] + 1, &expired);
+    EXPECT_EQ(expired, std::vector<uint64_t>({idx}));
+  }
+  EXPECT_EQ(wheel.Size(), 0u);
+}
+
+TEST(TimerWheelTest, Random)
+{
+  // Compare against the expected expiration of each timer while
+  // scheduling and advancing in random steps
+  const uint64_t tick_ns = 7;
+  tc::TimerWheel wheel(tick_ns, 0);
+  std::mt19937_64 rng(0);
+  std::multimap<uint64_t, uint64_t> pending;
+
+  uint64_t now = 0;
+  uint64_t next_id = 0;
+  for (size_t step = 0; step < 20000; ++step) {
+    const size_t schedule_count = rng() % 4;
+    for (size_t i = 0; i < schedule_count; ++i) {
+      const uint64_t deadline = now + (rng() % (1 << (rng() % 24)));
+      wheel.Schedule(deadline, next_id);
+      pending.emplace(deadline, next_id);
+      ++next_id;
+    }
+    // Mostly small steps with the occasional long idle period
+    now += ((rng() % 100) == 0) ? (rng() % (1 << 26)) : (rng() % 200);
+
+    std::vector<uint64_t> expired;
+    wheel.Advance(now, &expired);
+    std::vector<uint64_t> expected;
+    const uint64_t now_tick = now / tick_ns;
+    while (!pending.empty() &&
+           ((pending.begin()->first / tick_ns) < now_tick)) {
+      expected.push_back(pending.begin()->second);
+      pending.erase(pending.begin());
+    }
+    std::sort(expired.begin(), expired.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(expired, expected) << "at step " << step;
+  }
+  EXPECT_EQ(wheel.Size(), pending.size());
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,161 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+// Helpers of the tools driving an in-process server through the public
+// API: error handling, a CPU response allocator and a model repository
+// generated in a temporary directory.
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "triton/core/tritonserver.h"
+
+#define FAIL(MSG)                                 \
+  do {                                            \
+    std::cerr << "error: " << (MSG) << std::endl; \
+    exit(1);                                      \
+  } while (false)
+
+#define FAIL_IF_ERR(X, MSG)                                       \
+  do {                                                            \
+    TRITONSERVER_Error* err__ = (X);                              \
+    if (err__ != nullptr) {                                       \
+      std::cerr << "error: " << (MSG) << ": "                     \
+                << TRITONSERVER_ErrorCodeString(err__) << " - "   \
+                << TRITONSERVER_ErrorMessage(err__) << std::endl; \
+      TRITONSERVER_ErrorDelete(err__);                            \
+      exit(1);                                                    \
+    }                                                             \
+  } while (false)
+
+namespace triton { namespace core { namespace test {
+
+inline uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Response allocator callbacks placing all the outputs in CPU memory.
+inline TRITONSERVER_Error*
+ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_MemoryType preferred_memory_type,
+    int64_t preferred_memory_type_id, void* userp, void** buffer,
+    void** buffer_userp, TRITONSERVER_MemoryType* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *buffer = (byte_size == 0) ? nullptr : malloc(byte_size);
+  *buffer_userp = nullptr;
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  return nullptr;  // Success
+}
+
+inline TRITONSERVER_Error*
+ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer, void* buffer_userp,
+    size_t byte_size, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  free(buffer);
+  return nullptr;  // Success
+}
+
+// Write the model configuration parameter 'key' of 'value' to 'config'.
+template <typename T>
+void
+WriteParameter(std::ostream* config, const char* key, const T& value)
+{
+  *config << "parameters { key: \"" << key << "\" value: { string_value: \""
+          << value << "\" } }\n";
+}
+
+// A model repository generated in a temporary directory named after
+// 'prefix', removed on destruction.
+class GeneratedRepository {
+ public:
+  explicit GeneratedRepository(const std::string& prefix)
+  {
+    std::string root = "/tmp/" + prefix + "_XXXXXX";
+    if (mkdtemp(&root[0]) == nullptr) {
+      FAIL("failed to create model repository directory");
+    }
+    root_ = root;
+  }
+
+  ~GeneratedRepository()
+  {
+    for (const auto& file : files_) {
+      std::remove(file.c_str());
+    }
+    for (auto it = dirs_.rbegin(); it != dirs_.rend(); ++it) {
+      rmdir(it->c_str());
+    }
+    rmdir(root_.c_str());
+  }
+
+  const std::string& Path() const { return root_; }
+
+  // Add version 1 of the model 'name' with the configuration 'config'.
+  void AddModel(const std::string& name, const std::string& config)
+  {
+    const std::string model_dir = root_ + "/" + name;
+    const std::string version_dir = model_dir + "/1";
+    const std::string config_path = model_dir + "/config.pbtxt";
+    if ((mkdir(model_dir.c_str(), S_IRWXU) != 0) ||
+        (mkdir(version_dir.c_str(), S_IRWXU) != 0)) {
+      FAIL("failed to create directory of model '" + name + "'");
+    }
+    dirs_.push_back(model_dir);
+    dirs_.push_back(version_dir);
+    files_.push_back(config_path);
+
+    std::ofstream out(config_path);
+    out << config;
+    if (!out.good()) {
+      FAIL("failed to write configuration of model '" + name + "'");
+    }
+  }
+
+ private:
+  std::string root_;
+  std::vector<std::string> dirs_;
+  std::vector<std::string> files_;
+};
+
+}}}  // namespace triton::core::test
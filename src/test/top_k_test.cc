@@ -0,0 +1,130 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "top_k.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(TopKTest, Select)
+{
+  // Spans several blocks with the largest values in different blocks
+  std::vector<float> values(100);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<float>((i * 37) % 100);
+  }
+  std::vector<uint32_t> indices(5);
+  std::vector<float> top_values(5);
+  ASSERT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 5, indices.data(), top_values.data()),
+      5);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(top_values[i], 99.0f - i);
+    EXPECT_EQ(values[indices[i]], top_values[i]);
+  }
+}
+
+TEST(TopKTest, Ties)
+{
+  // Equal values are ordered by index
+  std::vector<float> values{1.0f, 3.0f, 2.0f, 3.0f, 3.0f, 0.0f};
+  std::vector<uint32_t> indices(3);
+  std::vector<float> top_values(3);
+  ASSERT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 3, indices.data(), top_values.data()),
+      3);
+  EXPECT_EQ(indices, (std::vector<uint32_t>{1, 3, 4}));
+}
+
+TEST(TopKTest, Bounds)
+{
+  std::vector<float> values{-1.0f, -3.0f, -2.0f};
+  std::vector<uint32_t> indices(8);
+  std::vector<float> top_values(8);
+  EXPECT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 0, indices.data(), top_values.data()),
+      0);
+
+  // Fewer values than requested
+  ASSERT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 8, indices.data(), top_values.data()),
+      3);
+  EXPECT_EQ(indices[0], 0);
+  EXPECT_EQ(indices[1], 2);
+  EXPECT_EQ(indices[2], 1);
+}
+
+TEST(TopKTest, NaN)
+{
+  // NaN values are ranked last
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> values(40, 0.0f);
+  values[0] = nan;
+  values[17] = 5.0f;
+  values[30] = nan;
+  std::vector<uint32_t> indices(40);
+  std::vector<float> top_values(40);
+  ASSERT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 2, indices.data(), top_values.data()),
+      2);
+  EXPECT_EQ(indices[0], 17);
+  EXPECT_EQ(indices[1], 1);
+
+  ASSERT_EQ(
+      tc::TopK(
+          values.data(), values.size(), 40, indices.data(), top_values.data()),
+      40);
+  EXPECT_EQ(indices[38], 0);
+  EXPECT_EQ(indices[39], 30);
+  EXPECT_TRUE(std::isnan(top_values[39]));
+}
+
+TEST(TopKTest, HalfToFloat)
+{
+  // 1.0, -2.0, 65504 (largest), 2^-24 (smallest subnormal), 0, infinity
+  const std::vector<uint16_t> halfs{0x3c00, 0xc000, 0x7bff,
+                                    0x0001, 0x0000, 0x7c00};
+  std::vector<float> floats(halfs.size());
+  tc::HalfToFloat(halfs.data(), halfs.size(), floats.data());
+  EXPECT_EQ(floats[0], 1.0f);
+  EXPECT_EQ(floats[1], -2.0f);
+  EXPECT_EQ(floats[2], 65504.0f);
+  EXPECT_EQ(floats[3], std::ldexp(1.0f, -24));
+  EXPECT_EQ(floats[4], 0.0f);
+  EXPECT_TRUE(std::isinf(floats[5]));
+}
+
+}  // namespace
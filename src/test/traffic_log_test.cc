@@ -0,0 +1,163 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <string>
+#include "traffic_log.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+tc::TrafficRecord
+MakeRecord()
+{
+  tc::TrafficRecord record;
+  record.arrival_ns_ = 123456789;
+  record.model_name_ = "model";
+  record.model_version_ = -1;
+  record.priority_ = 2;
+  record.timeout_us_ = 5000;
+  record.flags_ = 1;
+  record.correlation_id_ = 0;
+  record.correlation_id_string_ = "sequence";
+  record.inputs_.resize(2);
+  record.inputs_[0].name_ = "INPUT0";
+  record.inputs_[0].datatype_ = 11;
+  record.inputs_[0].shape_ = {4, 16};
+  record.inputs_[0].byte_size_ = 256;
+  record.inputs_[1].name_ = "INPUT1";
+  record.inputs_[1].datatype_ = 13;
+  record.inputs_[1].byte_size_ = 7;
+  return record;
+}
+
+void
+ExpectEqual(const tc::TrafficRecord& lhs, const tc::TrafficRecord& rhs)
+{
+  EXPECT_EQ(lhs.arrival_ns_, rhs.arrival_ns_);
+  EXPECT_EQ(lhs.model_name_, rhs.model_name_);
+  EXPECT_EQ(lhs.model_version_, rhs.model_version_);
+  EXPECT_EQ(lhs.priority_, rhs.priority_);
+  EXPECT_EQ(lhs.timeout_us_, rhs.timeout_us_);
+  EXPECT_EQ(lhs.flags_, rhs.flags_);
+  EXPECT_EQ(lhs.correlation_id_, rhs.correlation_id_);
+  EXPECT_EQ(lhs.correlation_id_string_, rhs.correlation_id_string_);
+  ASSERT_EQ(lhs.inputs_.size(), rhs.inputs_.size());
+  for (size_t idx = 0; idx < lhs.inputs_.size(); ++idx) {
+    EXPECT_EQ(lhs.inputs_[idx].name_, rhs.inputs_[idx].name_);
+    EXPECT_EQ(lhs.inputs_[idx].datatype_, rhs.inputs_[idx].datatype_);
+    EXPECT_EQ(lhs.inputs_[idx].shape_, rhs.inputs_[idx].shape_);
+    EXPECT_EQ(lhs.inputs_[idx].byte_size_, rhs.inputs_[idx].byte_size_);
+  }
+}
+
+TEST(TrafficLogTest, RoundTrip)
+{
+  std::string log;
+  tc::AppendTrafficLogHeader(42, &log);
+  const tc::TrafficRecord record = MakeRecord();
+  tc::TrafficRecord second = MakeRecord();
+  second.arrival_ns_ += 1000;
+  second.correlation_id_ = 7;
+  second.correlation_id_string_.clear();
+  second.inputs_.clear();
+  tc::AppendTrafficRecord(record, &log);
+  tc::AppendTrafficRecord(second, &log);
+
+  uint64_t start_time_ns = 0;
+  size_t offset = 0;
+  size_t consumed = 0;
+  ASSERT_TRUE(tc::ParseTrafficLogHeader(
+      log.data(), log.size(), &start_time_ns, &consumed));
+  EXPECT_EQ(start_time_ns, 42);
+  offset += consumed;
+
+  tc::TrafficRecord parsed;
+  ASSERT_TRUE(tc::ParseTrafficRecord(
+      log.data() + offset, log.size() - offset, &parsed, &consumed));
+  ExpectEqual(parsed, record);
+  offset += consumed;
+  ASSERT_TRUE(tc::ParseTrafficRecord(
+      log.data() + offset, log.size() - offset, &parsed, &consumed));
+  ExpectEqual(parsed, second);
+  offset += consumed;
+  EXPECT_EQ(offset, log.size());
+}
+
+TEST(TrafficLogTest, InvalidHeader)
+{
+  std::string log;
+  tc::AppendTrafficLogHeader(42, &log);
+  uint64_t start_time_ns;
+  size_t consumed;
+  EXPECT_FALSE(tc::ParseTrafficLogHeader(
+      log.data(), log.size() - 1, &start_time_ns, &consumed));
+  log[0] = 'X';
+  EXPECT_FALSE(tc::ParseTrafficLogHeader(
+      log.data(), log.size(), &start_time_ns, &consumed));
+}
+
+TEST(TrafficLogTest, Truncated)
+{
+  // A record cut short, e.g. by a crash while it was written, is invalid
+  std::string log;
+  tc::AppendTrafficRecord(MakeRecord(), &log);
+  tc::TrafficRecord parsed;
+  size_t consumed;
+  for (size_t size = 0; size < log.size(); ++size) {
+    EXPECT_FALSE(tc::ParseTrafficRecord(log.data(), size, &parsed, &consumed))
+        << "size " << size;
+  }
+  EXPECT_TRUE(
+      tc::ParseTrafficRecord(log.data(), log.size(), &parsed, &consumed));
+}
+
+TEST(TrafficLogTest, TrailingFields)
+{
+  // The fields added by later versions are skipped
+  std::string log;
+  tc::AppendTrafficRecord(MakeRecord(), &log);
+  log.append("later", 5);
+  uint32_t size;
+  memcpy(&size, log.data(), sizeof(size));
+  size += 5;
+  memcpy(&log[0], &size, sizeof(size));
+  tc::AppendTrafficRecord(MakeRecord(), &log);
+
+  tc::TrafficRecord parsed;
+  size_t consumed;
+  ASSERT_TRUE(
+      tc::ParseTrafficRecord(log.data(), log.size(), &parsed, &consumed));
+  EXPECT_EQ(consumed, size);
+  ExpectEqual(parsed, MakeRecord());
+  ASSERT_TRUE(tc::ParseTrafficRecord(
+      log.data() + consumed, log.size() - consumed, &parsed, &consumed));
+  ExpectEqual(parsed, MakeRecord());
+}
+
+}  // namespace
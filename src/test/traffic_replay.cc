@@ -0,0 +1,741 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Replays a request traffic captured by the server, see
+// TRITONSERVER_ServerOptionsSetTrafficCapture, against an in-process
+// server through the TRITONSERVER_ServerInferAsync API. The requests are
+// issued at their captured arrival times, optionally sped up, with
+// inputs of the captured shapes and byte sizes holding zeros. Unless a
+// model repository is given, a repository holding one model served by
+// the null backend per captured model is generated from the captured
+// inputs and the command line options, so that scheduling parameters
+// can be evaluated against the traffic with a modeled execution time.
+// The end-to-end, queue and compute latency distributions are reported
+// per model at the end of the run, the queue and compute latencies
+// require the server to be built with tracing.
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tool_utils.h"
+#include "traffic_log.h"
+#include "triton/core/tritonserver.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+using tc::test::NowNs;
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " -f <path> [options]" << std::endl;
+  std::cerr << "\t-f <path> Traffic capture to replay." << std::endl;
+  std::cerr << "\t-r <path> Model repository to use instead of generating one."
+            << std::endl;
+  std::cerr << "\t-b <path> Backend directory. Default \"./backends\"."
+            << std::endl;
+  std::cerr << "\t-x <factor> Speed of the replay relative to the capture, "
+               "2 issues the requests twice as fast. Default 1."
+            << std::endl;
+  std::cerr << "Options of the generated models:" << std::endl;
+  std::cerr << "\t-B <size> Max batch size, raised to the largest captured "
+               "batch. 0 disables batching, otherwise the first dimension "
+               "of the captured inputs is the batch dimension. Default 8."
+            << std::endl;
+  std::cerr << "\t-d <us> Max queue delay of the dynamic batcher. Default 100."
+            << std::endl;
+  std::cerr << "\t-P <sizes> Comma separated preferred batch sizes of the "
+               "dynamic batcher. Default none."
+            << std::endl;
+  std::cerr << "\t-i <count> Model instances. Default 1." << std::endl;
+  std::cerr << "\t-e <us> Execution time of a batch. Default 0." << std::endl;
+  std::cerr << "\t-p <us> Execution time added per batch item. Default 0."
+            << std::endl;
+  std::cerr << "\t-S Spin instead of sleeping for the execution time."
+            << std::endl;
+
+  exit(1);
+}
+
+struct ModelOptions {
+  int max_batch_size_ = 8;
+  int max_queue_delay_us_ = 100;
+  std::string preferred_batch_sizes_;
+  int instance_count_ = 1;
+  int exec_time_us_ = 0;
+  int exec_time_per_item_us_ = 0;
+  bool busy_wait_ = false;
+};
+
+// Return the model configuration datatype of 'datatype'.
+std::string
+ConfigDataType(const uint32_t datatype)
+{
+  const auto dtype = static_cast<TRITONSERVER_DataType>(datatype);
+  if (dtype == TRITONSERVER_TYPE_BYTES) {
+    return "TYPE_STRING";
+  }
+  return std::string("TYPE_") + TRITONSERVER_DataTypeString(dtype);
+}
+
+// Add the model 'name' generated from its captured 'records' to
+// 'repository'. The model takes its inputs from its first captured
+// request.
+void
+AddModel(
+    tc::test::GeneratedRepository* repository, const std::string& name,
+    const std::vector<const tc::TrafficRecord*>& records,
+    const ModelOptions& options)
+{
+  if (name.empty() || (name.find('/') != std::string::npos) ||
+      (name[0] == '.')) {
+    FAIL("can't generate a model named '" + name + "'");
+  }
+  const tc::TrafficRecord& first = *records.front();
+  if (first.inputs_.empty()) {
+    FAIL("can't generate model '" + name + "' without inputs");
+  }
+
+  // The batch dimension is the first dimension of all the inputs
+  bool batching = (options.max_batch_size_ > 0);
+  int64_t max_batch_size = options.max_batch_size_;
+  bool sequence = false;
+  uint32_t max_priority = 0;
+  bool timeout = false;
+  for (const auto* record : records) {
+    for (const auto& input : record->inputs_) {
+      if (input.shape_.empty()) {
+        batching = false;
+      } else {
+        max_batch_size = std::max(max_batch_size, input.shape_[0]);
+      }
+    }
+    sequence |= (record->correlation_id_ != 0) ||
+                !record->correlation_id_string_.empty();
+    max_priority = std::max(max_priority, record->priority_);
+    timeout |= (record->timeout_us_ != 0);
+  }
+
+  std::ostringstream config;
+  config << "name: \"" << name << "\"\n";
+  config << "backend: \"null\"\n";
+  config << "max_batch_size: " << (batching ? max_batch_size : 0) << "\n";
+  config << "input [\n";
+  for (size_t idx = 0; idx < first.inputs_.size(); ++idx) {
+    const auto& input = first.inputs_[idx];
+    const size_t rank = input.shape_.size() - (batching ? 1 : 0);
+    config << "  { name: \"" << input.name_
+           << "\" data_type: " << ConfigDataType(input.datatype_);
+    if (rank == 0) {
+      config << " dims: [ 1 ] reshape: { shape: [ ] }";
+    } else {
+      config << " dims: [ -1";
+      for (size_t dim = 1; dim < rank; ++dim) {
+        config << ", -1";
+      }
+      config << " ]";
+    }
+    config << " }" << ((idx + 1 < first.inputs_.size()) ? "," : "") << "\n";
+  }
+  config << "]\n";
+  config << "output [ { name: \"OUTPUT0\" data_type: "
+         << ConfigDataType(first.inputs_.front().datatype_)
+         << " dims: [ -1 ] } ]\n";
+  if (sequence) {
+    config << "sequence_batching { max_sequence_idle_microseconds: "
+              "60000000 }\n";
+  } else if (batching) {
+    config << "dynamic_batching {\n";
+    config << "  max_queue_delay_microseconds: "
+           << options.max_queue_delay_us_ << "\n";
+    if (!options.preferred_batch_sizes_.empty()) {
+      config << "  preferred_batch_size: [ "
+             << options.preferred_batch_sizes_ << " ]\n";
+    }
+    if (max_priority > 0) {
+      config << "  priority_levels: " << max_priority << "\n";
+      config << "  default_priority_level: " << max_priority << "\n";
+    }
+    if (timeout) {
+      config << "  default_queue_policy { allow_timeout_override: true }\n";
+    }
+    config << "}\n";
+  }
+  config << "instance_group [ { kind: KIND_CPU count: "
+         << options.instance_count_ << " } ]\n";
+  tc::test::WriteParameter(&config, "exec_time_us", options.exec_time_us_);
+  tc::test::WriteParameter(
+      &config, "exec_time_per_item_us", options.exec_time_per_item_us_);
+  tc::test::WriteParameter(
+      &config, "busy_wait", options.busy_wait_ ? "true" : "false");
+  repository->AddModel(name, config.str());
+}
+
+// Generate in 'repository' a model per model of the captured 'records'.
+void
+AddModels(
+    tc::test::GeneratedRepository* repository,
+    const std::vector<tc::TrafficRecord>& records, const ModelOptions& options)
+{
+  std::map<std::string, std::vector<const tc::TrafficRecord*>> models;
+  for (const auto& record : records) {
+    models[record.model_name_].push_back(&record);
+  }
+  for (const auto& model : models) {
+    AddModel(repository, model.first, model.second, options);
+  }
+}
+
+// Read the records of the capture at 'path' in arrival order.
+void
+ReadCapture(const std::string& path, std::vector<tc::TrafficRecord>* records)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    FAIL("failed to open traffic capture '" + path + "'");
+  }
+  const std::string log(
+      (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  uint64_t start_time_ns;
+  size_t offset = 0;
+  if (!tc::ParseTrafficLogHeader(
+          log.data(), log.size(), &start_time_ns, &offset)) {
+    FAIL("'" + path + "' is not a traffic capture");
+  }
+  while (offset < log.size()) {
+    tc::TrafficRecord record;
+    size_t consumed;
+    if (!tc::ParseTrafficRecord(
+            log.data() + offset, log.size() - offset, &record, &consumed)) {
+      // The capture may end with a partially written record
+      std::cerr << "warning: ignoring the truncated end of the capture"
+                << std::endl;
+      break;
+    }
+    records->emplace_back(std::move(record));
+    offset += consumed;
+  }
+  std::stable_sort(
+      records->begin(), records->end(),
+      [](const tc::TrafficRecord& lhs, const tc::TrafficRecord& rhs) {
+        return lhs.arrival_ns_ < rhs.arrival_ns_;
+      });
+}
+
+struct ReplayContext;
+
+// The state of a replayed request, the timestamps are 0 if unknown.
+struct RequestState {
+  ReplayContext* ctx_ = nullptr;
+  const tc::TrafficRecord* record_ = nullptr;
+  uint64_t scheduled_ns_ = 0;
+  uint64_t issue_ns_ = 0;
+  uint64_t complete_ns_ = 0;
+  uint64_t queue_start_ns_ = 0;
+  uint64_t compute_start_ns_ = 0;
+  uint64_t compute_end_ns_ = 0;
+  bool failed_ = false;
+  // The data of the BYTES inputs, the other inputs share 'zeros_'
+  std::vector<std::string> bytes_inputs_;
+};
+
+//
+// ReplayContext
+//
+// The state of a replay shared by all the requests.
+//
+struct ReplayContext {
+  TRITONSERVER_Server* server_;
+  TRITONSERVER_ResponseAllocator* allocator_;
+  bool generated_;
+  bool tracing_;
+  std::vector<char> zeros_;
+  std::vector<RequestState> requests_;
+
+  std::atomic<size_t> pending_count_{0};
+  std::atomic<size_t> error_count_{0};
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
+// Account the completion of a response or a trace of the replay.
+void
+CompletePending(ReplayContext* ctx)
+{
+  if (--ctx->pending_count_ == 0) {
+    std::lock_guard<std::mutex> lk(ctx->mu_);
+    ctx->cv_.notify_all();
+  }
+}
+
+void
+InferRequestComplete(
+    TRITONSERVER_InferenceRequest* request, const uint32_t flags, void* userp)
+{
+  TRITONSERVER_InferenceRequestDelete(request);
+}
+
+void
+InferResponseComplete(
+    TRITONSERVER_InferenceResponse* response, const uint32_t flags, void* userp)
+{
+  RequestState* state = reinterpret_cast<RequestState*>(userp);
+  ReplayContext* ctx = state->ctx_;
+  if (response != nullptr) {
+    TRITONSERVER_Error* err = TRITONSERVER_InferenceResponseError(response);
+    if (err != nullptr) {
+      state->failed_ = true;
+      if (ctx->error_count_++ == 0) {
+        std::cerr << "error: inference failed: "
+                  << TRITONSERVER_ErrorMessage(err) << std::endl;
+      }
+      TRITONSERVER_ErrorDelete(err);
+    }
+    TRITONSERVER_InferenceResponseDelete(response);
+  }
+  if ((flags & TRITONSERVER_RESPONSE_COMPLETE_FINAL) != 0) {
+    state->complete_ns_ = NowNs();
+    CompletePending(ctx);
+  }
+}
+
+void
+TraceActivity(
+    TRITONSERVER_InferenceTrace* trace,
+    TRITONSERVER_InferenceTraceActivity activity, uint64_t timestamp_ns,
+    void* userp)
+{
+  RequestState* state = reinterpret_cast<RequestState*>(userp);
+  switch (activity) {
+    case TRITONSERVER_TRACE_QUEUE_START:
+      state->queue_start_ns_ = timestamp_ns;
+      break;
+    case TRITONSERVER_TRACE_COMPUTE_START:
+      state->compute_start_ns_ = timestamp_ns;
+      break;
+    case TRITONSERVER_TRACE_COMPUTE_END:
+      state->compute_end_ns_ = timestamp_ns;
+      break;
+    default:
+      break;
+  }
+}
+
+void
+TraceRelease(TRITONSERVER_InferenceTrace* trace, void* userp)
+{
+  RequestState* state = reinterpret_cast<RequestState*>(userp);
+  TRITONSERVER_InferenceTraceDelete(trace);
+  CompletePending(state->ctx_);
+}
+
+// Return the data of a BYTES input of 'element_count' elements and
+// 'byte_size' bytes, the first element holding all the bytes.
+std::string
+BytesInput(const int64_t element_count, const uint64_t byte_size)
+{
+  const uint64_t prefix_size = element_count * sizeof(uint32_t);
+  std::string data(std::max(byte_size, prefix_size), '\0');
+  if (element_count > 0) {
+    const uint32_t first_size = data.size() - prefix_size;
+    memcpy(&data[0], &first_size, sizeof(first_size));
+  }
+  return data;
+}
+
+TRITONSERVER_Error*
+Issue(RequestState* state)
+{
+  ReplayContext* ctx = state->ctx_;
+  const tc::TrafficRecord& record = *state->record_;
+  TRITONSERVER_InferenceRequest* irequest = nullptr;
+  TRITONSERVER_Error* err = TRITONSERVER_InferenceRequestNew(
+      &irequest, ctx->server_, record.model_name_.c_str(),
+      ctx->generated_ ? -1 : record.model_version_);
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetPriority(irequest, record.priority_);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
+        irequest, record.timeout_us_);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetFlags(irequest, record.flags_);
+  }
+  // The data of the BYTES inputs must not move once it is appended
+  state->bytes_inputs_.reserve(record.inputs_.size());
+  if ((err == nullptr) && !record.correlation_id_string_.empty()) {
+    err = TRITONSERVER_InferenceRequestSetCorrelationIdString(
+        irequest, record.correlation_id_string_.c_str());
+  } else if ((err == nullptr) && (record.correlation_id_ != 0)) {
+    err = TRITONSERVER_InferenceRequestSetCorrelationId(
+        irequest, record.correlation_id_);
+  }
+  for (const auto& input : record.inputs_) {
+    if (err != nullptr) {
+      break;
+    }
+    const auto datatype = static_cast<TRITONSERVER_DataType>(input.datatype_);
+    err = TRITONSERVER_InferenceRequestAddInput(
+        irequest, input.name_.c_str(), datatype, input.shape_.data(),
+        input.shape_.size());
+    if (err != nullptr) {
+      break;
+    }
+    const void* base = ctx->zeros_.data();
+    uint64_t byte_size = input.byte_size_;
+    if (datatype == TRITONSERVER_TYPE_BYTES) {
+      int64_t element_count = 1;
+      for (const auto dim : input.shape_) {
+        element_count *= dim;
+      }
+      state->bytes_inputs_.emplace_back(
+          BytesInput(element_count, input.byte_size_));
+      base = state->bytes_inputs_.back().data();
+      byte_size = state->bytes_inputs_.back().size();
+    }
+    err = TRITONSERVER_InferenceRequestAppendInputData(
+        irequest, input.name_.c_str(), base, byte_size,
+        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetReleaseCallback(
+        irequest, InferRequestComplete, nullptr /* request_release_userp */);
+  }
+  if (err == nullptr) {
+    err = TRITONSERVER_InferenceRequestSetResponseCallback(
+        irequest, ctx->allocator_, nullptr /* response_allocator_userp */,
+        InferResponseComplete, state);
+  }
+
+  TRITONSERVER_InferenceTrace* trace = nullptr;
+  if ((err == nullptr) && ctx->tracing_) {
+    TRITONSERVER_Error* trace_err = TRITONSERVER_InferenceTraceNew(
+        &trace, TRITONSERVER_TRACE_LEVEL_TIMESTAMPS, 0 /* parent_id */,
+        TraceActivity, TraceRelease, state);
+    if (trace_err != nullptr) {
+      // The queue and compute latencies are not reported without
+      // tracing.
+      std::cerr << "warning: tracing is not available: "
+                << TRITONSERVER_ErrorMessage(trace_err) << std::endl;
+      TRITONSERVER_ErrorDelete(trace_err);
+      ctx->tracing_ = false;
+      trace = nullptr;
+    }
+  }
+  if (err == nullptr) {
+    ctx->pending_count_ += (trace != nullptr) ? 2 : 1;
+    state->issue_ns_ = NowNs();
+    err = TRITONSERVER_ServerInferAsync(ctx->server_, irequest, trace);
+    if (err != nullptr) {
+      ctx->pending_count_ -= (trace != nullptr) ? 2 : 1;
+    }
+  }
+  if (err != nullptr) {
+    if (trace != nullptr) {
+      TRITONSERVER_InferenceTraceDelete(trace);
+    }
+    if (irequest != nullptr) {
+      TRITONSERVER_InferenceRequestDelete(irequest);
+    }
+  }
+  return err;
+}
+
+// Print the distribution of 'values_ns' in microseconds.
+void
+PrintDistribution(const std::string& name, std::vector<uint64_t>* values_ns)
+{
+  if (values_ns->empty()) {
+    return;
+  }
+  std::vector<uint64_t>& values = *values_ns;
+  const size_t count = values.size();
+  std::sort(values.begin(), values.end());
+  uint64_t sum_ns = 0;
+  for (const auto value_ns : values) {
+    sum_ns += value_ns;
+  }
+  std::cout << "  " << name << " (us): avg " << (sum_ns / count / 1000);
+  for (const double q : {0.5, 0.9, 0.95, 0.99, 0.999}) {
+    const size_t idx = std::min(count - 1, static_cast<size_t>(q * count));
+    std::cout << ", p" << (q * 100) << " " << (values[idx] / 1000);
+  }
+  std::cout << ", max " << (values.back() / 1000) << std::endl;
+}
+
+void
+Report(ReplayContext* ctx)
+{
+  struct Latencies {
+    size_t count_ = 0;
+    size_t failed_count_ = 0;
+    std::vector<uint64_t> lag_ns_;
+    std::vector<uint64_t> latency_ns_;
+    std::vector<uint64_t> queue_ns_;
+    std::vector<uint64_t> compute_ns_;
+  };
+  std::map<std::string, Latencies> models;
+  uint64_t first_issue_ns = 0;
+  uint64_t last_complete_ns = 0;
+  for (const auto& state : ctx->requests_) {
+    if (state.issue_ns_ == 0) {
+      continue;
+    }
+    Latencies& latencies = models[state.record_->model_name_];
+    ++latencies.count_;
+    if (state.failed_) {
+      ++latencies.failed_count_;
+      continue;
+    }
+    first_issue_ns = (first_issue_ns == 0)
+                         ? state.issue_ns_
+                         : std::min(first_issue_ns, state.issue_ns_);
+    last_complete_ns = std::max(last_complete_ns, state.complete_ns_);
+    latencies.lag_ns_.push_back(state.issue_ns_ - state.scheduled_ns_);
+    latencies.latency_ns_.push_back(state.complete_ns_ - state.issue_ns_);
+    if ((state.queue_start_ns_ != 0) && (state.compute_start_ns_ != 0) &&
+        (state.compute_end_ns_ != 0)) {
+      latencies.queue_ns_.push_back(
+          state.compute_start_ns_ - state.queue_start_ns_);
+      latencies.compute_ns_.push_back(
+          state.compute_end_ns_ - state.compute_start_ns_);
+    }
+  }
+
+  std::cout << "Requests: " << ctx->requests_.size()
+            << ", errors: " << ctx->error_count_ << std::endl;
+  if (last_complete_ns > first_issue_ns) {
+    std::cout << "Duration: " << ((last_complete_ns - first_issue_ns) / 1e9)
+              << " sec" << std::endl;
+  }
+  for (auto& model : models) {
+    Latencies& latencies = model.second;
+    std::cout << "Model '" << model.first << "': " << latencies.count_
+              << " requests, " << latencies.failed_count_ << " failed"
+              << std::endl;
+    // How late the requests were issued relative to the capture
+    PrintDistribution("Issue lag", &latencies.lag_ns_);
+    PrintDistribution("Latency", &latencies.latency_ns_);
+    PrintDistribution("Queue", &latencies.queue_ns_);
+    PrintDistribution("Compute", &latencies.compute_ns_);
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string capture_path;
+  std::string repository_path;
+  std::string backend_dir("./backends");
+  double speed = 1;
+  ModelOptions model_options;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "f:r:b:x:B:d:P:i:e:p:S")) != -1) {
+    switch (opt) {
+      case 'f':
+        capture_path = optarg;
+        break;
+      case 'r':
+        repository_path = optarg;
+        break;
+      case 'b':
+        backend_dir = optarg;
+        break;
+      case 'x':
+        speed = std::atof(optarg);
+        break;
+      case 'B':
+        model_options.max_batch_size_ = std::atoi(optarg);
+        break;
+      case 'd':
+        model_options.max_queue_delay_us_ = std::atoi(optarg);
+        break;
+      case 'P':
+        model_options.preferred_batch_sizes_ = optarg;
+        break;
+      case 'i':
+        model_options.instance_count_ = std::atoi(optarg);
+        break;
+      case 'e':
+        model_options.exec_time_us_ = std::atoi(optarg);
+        break;
+      case 'p':
+        model_options.exec_time_per_item_us_ = std::atoi(optarg);
+        break;
+      case 'S':
+        model_options.busy_wait_ = true;
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+  if (capture_path.empty()) {
+    Usage(argv, "-f must be specified");
+  }
+  if ((speed <= 0) || (model_options.max_batch_size_ < 0) ||
+      (model_options.instance_count_ <= 0)) {
+    Usage(argv, "-x and -i must be positive and -B not negative");
+  }
+
+  std::vector<tc::TrafficRecord> records;
+  ReadCapture(capture_path, &records);
+  if (records.empty()) {
+    FAIL("traffic capture '" + capture_path + "' has no requests");
+  }
+
+  std::unique_ptr<tc::test::GeneratedRepository> generated;
+  if (repository_path.empty()) {
+    generated.reset(new tc::test::GeneratedRepository("replay_repository"));
+    AddModels(generated.get(), records, model_options);
+    repository_path = generated->Path();
+  }
+
+  TRITONSERVER_ServerOptions* server_options = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsNew(&server_options),
+      "creating server options");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetModelRepositoryPath(
+          server_options, repository_path.c_str()),
+      "setting model repository path");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetBackendDirectory(
+          server_options, backend_dir.c_str()),
+      "setting backend directory");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsSetStrictModelConfig(server_options, true),
+      "setting strict model configuration");
+  TRITONSERVER_Server* server = nullptr;
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerNew(&server, server_options), "creating server");
+  FAIL_IF_ERR(
+      TRITONSERVER_ServerOptionsDelete(server_options),
+      "deleting server options");
+
+  std::map<std::string, int64_t> models;
+  for (const auto& record : records) {
+    models.emplace(record.model_name_, generated ? -1 : record.model_version_);
+  }
+  for (const auto& model : models) {
+    bool ready = false;
+    for (size_t health_iters = 0; !ready; ++health_iters) {
+      FAIL_IF_ERR(
+          TRITONSERVER_ServerModelIsReady(
+              server, model.first.c_str(), model.second, &ready),
+          "unable to get model readiness");
+      if (!ready) {
+        if (health_iters >= 10) {
+          FAIL("model '" + model.first + "' is not ready");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      }
+    }
+  }
+
+  ReplayContext ctx;
+  ctx.server_ = server;
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorNew(
+          &ctx.allocator_, tc::test::ResponseAlloc, tc::test::ResponseRelease,
+          nullptr /* start_fn */),
+      "creating response allocator");
+  ctx.generated_ = (generated != nullptr);
+  ctx.tracing_ = true;
+  uint64_t max_byte_size = 0;
+  for (const auto& record : records) {
+    for (const auto& input : record.inputs_) {
+      max_byte_size = std::max(max_byte_size, input.byte_size_);
+    }
+  }
+  ctx.zeros_.assign(std::max<uint64_t>(max_byte_size, 1), 0);
+  ctx.requests_.resize(records.size());
+
+  // The requests are issued from this thread at their arrival time
+  // relative to the first request, scaled by the speed of the replay.
+  ctx.pending_count_ = 1;
+  const uint64_t first_arrival_ns = records.front().arrival_ns_;
+  const uint64_t start_ns = NowNs();
+  for (size_t idx = 0; idx < records.size(); ++idx) {
+    RequestState& state = ctx.requests_[idx];
+    state.ctx_ = &ctx;
+    state.record_ = &records[idx];
+    state.scheduled_ns_ =
+        start_ns + static_cast<uint64_t>(
+                       (records[idx].arrival_ns_ - first_arrival_ns) / speed);
+    const uint64_t now_ns = NowNs();
+    if (state.scheduled_ns_ > now_ns) {
+      std::this_thread::sleep_for(
+          std::chrono::nanoseconds(state.scheduled_ns_ - now_ns));
+    }
+    TRITONSERVER_Error* err = Issue(&state);
+    if (err != nullptr) {
+      state.issue_ns_ = 0;
+      if (ctx.error_count_++ == 0) {
+        std::cerr << "error: failed to issue request: "
+                  << TRITONSERVER_ErrorMessage(err) << std::endl;
+      }
+      TRITONSERVER_ErrorDelete(err);
+    }
+  }
+  CompletePending(&ctx);
+  {
+    std::unique_lock<std::mutex> lk(ctx.mu_);
+    ctx.cv_.wait(lk, [&ctx] { return ctx.pending_count_ == 0; });
+  }
+
+  Report(&ctx);
+
+  FAIL_IF_ERR(
+      TRITONSERVER_ResponseAllocatorDelete(ctx.allocator_),
+      "deleting response allocator");
+  FAIL_IF_ERR(TRITONSERVER_ServerDelete(server), "deleting server");
+  return (ctx.error_count_ == 0) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "work_stealing_pool.h"
+
+namespace tc = triton::core;
+
+namespace {
+
+TEST(WorkStealingThreadPoolTest, Size)
+{
+  tc::WorkStealingThreadPool empty_pool(0);
+  EXPECT_EQ(empty_pool.Size(), 1u) << "Expect at least one worker";
+
+  tc::WorkStealingThreadPool pool(4);
+  EXPECT_EQ(pool.Size(), 4u);
+}
+
+TEST(WorkStealingThreadPoolTest, ExecuteAll)
+{
+  constexpr size_t kTaskCount = 10000;
+  std::atomic<size_t> executed(0);
+  {
+    tc::WorkStealingThreadPool pool(4);
+    for (size_t i = 0; i < kTaskCount; ++i) {
+      pool.Enqueue([&executed]() { executed++; });
+    }
+  }
+  EXPECT_EQ(executed.load(), kTaskCount)
+      << "Expect the remaining tasks to be executed on destruction";
+}
+
+TEST(WorkStealingThreadPoolTest, EnqueueFromTask)
+{
+  constexpr size_t kChainLength = 1000;
+  std::atomic<size_t> executed(0);
+  std::function<void()> task;
+  {
+    tc::WorkStealingThreadPool pool(2);
+    task = [&pool, &executed, &task]() {
+      if (++executed < kChainLength) {
+        std::function<void()> next = task;
+        pool.Enqueue(std::move(next));
+      }
+    };
+    std::function<void()> first = task;
+    pool.Enqueue(std::move(first));
+    while (executed.load() < kChainLength) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  EXPECT_EQ(executed.load(), kChainLength);
+}
+
+TEST(WorkStealingThreadPoolTest, StealFromBlockedWorker)
+{
+  // Tasks enqueued from a task go to the queue of its worker, the other
+  // worker must steal them while the first one is blocked.
+  std::atomic<bool> release(false);
+  std::atomic<size_t> executed(0);
+  {
+    tc::WorkStealingThreadPool pool(2);
+    pool.Enqueue([&pool, &release, &executed]() {
+      for (size_t i = 0; i < 10; ++i) {
+        pool.Enqueue([&executed]() { executed++; });
+      }
+      while (!release.load()) {
+        std::this_thread::yield();
+      }
+    });
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((executed.load() < 10) &&
+           (std::chrono::steady_clock::now() < deadline)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(executed.load(), 10u)
+        << "Expect the tasks to be stolen by the idle worker";
+    release = true;
+  }
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
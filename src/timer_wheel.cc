@@ -0,0 +1,151 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace triton { namespace core {
+
+constexpr size_t TimerWheel::kLevelBits;
+constexpr size_t TimerWheel::kSlotCount;
+constexpr size_t TimerWheel::kLevelCount;
+
+TimerWheel::TimerWheel(const uint64_t tick_ns, const uint64_t start_ns)
+    : tick_ns_(std::max(tick_ns, (uint64_t)1)),
+      current_tick_(start_ns / tick_ns_), size_(0)
+{
+  level_sizes_.fill(0);
+}
+
+void
+TimerWheel::Schedule(const uint64_t deadline_ns, const uint64_t id)
+{
+  const uint64_t tick = deadline_ns / tick_ns_;
+  if (tick < current_tick_) {
+    ready_.push_back(id);
+  } else {
+    Insert(Timer{tick, id});
+  }
+  size_++;
+}
+
+void
+TimerWheel::Insert(const Timer& timer)
+{
+  // Place the timer in the lowest level whose range covers it, the slot
+  // of a level 'l' spans 64^l ticks.
+  const uint64_t delta = timer.tick_ - current_tick_;
+  for (size_t level = 0; level < kLevelCount; ++level) {
+    if (delta < ((uint64_t)1 << (kLevelBits * (level + 1)))) {
+      const size_t slot =
+          (timer.tick_ >> (kLevelBits * level)) & (kSlotCount - 1);
+      levels_[level][slot].push_back(timer);
+      level_sizes_[level]++;
+      return;
+    }
+  }
+  overflow_.push_back(timer);
+}
+
+void
+TimerWheel::Cascade()
+{
+  // Called when 'current_tick_' enters a new level 0 rotation. Move the
+  // timers of the level 1 slot that starts now to lower levels, and so
+  // on for the higher levels that also start a new rotation.
+  size_t level = 1;
+  for (; level < kLevelCount; ++level) {
+    const size_t slot =
+        (current_tick_ >> (kLevelBits * level)) & (kSlotCount - 1);
+    Slot timers;
+    timers.swap(levels_[level][slot]);
+    level_sizes_[level] -= timers.size();
+    for (const auto& timer : timers) {
+      Insert(timer);
+    }
+    if (slot != 0) {
+      break;
+    }
+  }
+  if (level == kLevelCount) {
+    Slot timers;
+    timers.swap(overflow_);
+    for (const auto& timer : timers) {
+      Insert(timer);
+    }
+  }
+}
+
+void
+TimerWheel::Advance(const uint64_t now_ns, std::vector<uint64_t>* expired)
+{
+  expired->insert(expired->end(), ready_.begin(), ready_.end());
+  size_ -= ready_.size();
+  ready_.clear();
+
+  const uint64_t target_tick = now_ns / tick_ns_;
+
+  // A tick is expired once 'now_ns' is past its end
+  while (current_tick_ < target_tick) {
+    if (size_ == 0) {
+      current_tick_ = target_tick;
+      break;
+    }
+
+    // Skip to the next rotation of the lowest non-empty level, there is
+    // nothing to expire or cascade until then.
+    size_t level = 0;
+    while ((level < kLevelCount) && (level_sizes_[level] == 0)) {
+      ++level;
+    }
+    if (level > 0) {
+      const uint64_t span = (uint64_t)1 << (kLevelBits * level);
+      const uint64_t next_tick = ((current_tick_ / span) + 1) * span;
+      if (next_tick > target_tick) {
+        current_tick_ = target_tick;
+        break;
+      }
+      current_tick_ = next_tick;
+      Cascade();
+      continue;
+    }
+
+    auto& slot = levels_[0][current_tick_ & (kSlotCount - 1)];
+    for (const auto& timer : slot) {
+      expired->push_back(timer.id_);
+    }
+    level_sizes_[0] -= slot.size();
+    size_ -= slot.size();
+    slot.clear();
+
+    ++current_tick_;
+    if ((current_tick_ & (kSlotCount - 1)) == 0) {
+      Cascade();
+    }
+  }
+}
+
+}}  // namespace triton::core
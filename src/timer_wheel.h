@@ -0,0 +1,87 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// Hierarchical timer wheel tracking deadlines of opaque timer ids.
+// Deadlines are rounded to 'tick_ns' so a timer expires at most one tick
+// after its deadline. Scheduling and expiring timers are O(1) amortized.
+// Timers can't be cancelled, the owner is expected to ignore expired ids
+// that are no longer relevant.
+//
+// The timer wheel is not thread-safe.
+//
+class TimerWheel {
+ public:
+  // Create a timer wheel with 'tick_ns' resolution starting at
+  // 'start_ns'.
+  TimerWheel(const uint64_t tick_ns, const uint64_t start_ns);
+
+  // Schedule timer 'id' to expire at 'deadline_ns'.
+  void Schedule(const uint64_t deadline_ns, const uint64_t id);
+
+  // Advance the wheel to 'now_ns' and append the ids of the timers that
+  // expired to 'expired'.
+  void Advance(const uint64_t now_ns, std::vector<uint64_t>* expired);
+
+  // Return the number of timers that haven't expired.
+  size_t Size() const { return size_; }
+
+ private:
+  static constexpr size_t kLevelBits = 6;
+  static constexpr size_t kSlotCount = 1 << kLevelBits;
+  static constexpr size_t kLevelCount = 4;
+
+  struct Timer {
+    uint64_t tick_;
+    uint64_t id_;
+  };
+  using Slot = std::vector<Timer>;
+
+  void Insert(const Timer& timer);
+  void Cascade();
+
+  const uint64_t tick_ns_;
+  // The tick that is expired next
+  uint64_t current_tick_;
+  size_t size_;
+
+  // Timers whose deadline has passed when scheduled.
+  std::vector<uint64_t> ready_;
+  std::array<std::array<Slot, kSlotCount>, kLevelCount> levels_;
+  std::array<size_t, kLevelCount> level_sizes_;
+  // Timers beyond the range of the wheel.
+  Slot overflow_;
+};
+
+}}  // namespace triton::core
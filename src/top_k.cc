@@ -0,0 +1,151 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "top_k.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace triton { namespace core {
+
+namespace {
+
+// The number of values whose maximum is computed at once, the loop is
+// branch free so that the compiler vectorizes it.
+constexpr size_t kTopKBlockSize = 16;
+
+using RankedValue = std::pair<float, uint32_t>;
+
+// Whether 'lhs' is ranked before 'rhs', that is, it has a larger value
+// or an equal value with a smaller index.
+bool
+RanksBefore(const RankedValue& lhs, const RankedValue& rhs)
+{
+  return (lhs.first > rhs.first) ||
+         ((lhs.first == rhs.first) && (lhs.second < rhs.second));
+}
+
+float
+HalfToFloat(const uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    // Infinity or NaN
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // Subnormal half values are normal single precision values
+    exponent = 127 - 15 + 1;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+void
+HalfToFloat(const uint16_t* src, const size_t count, float* dst)
+{
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = HalfToFloat(src[i]);
+  }
+}
+
+size_t
+TopK(
+    const float* values, const size_t count, const size_t k,
+    uint32_t* indices, float* top_values)
+{
+  if (k == 0) {
+    return 0;
+  }
+
+  // Heap of the selected values whose front is the one ranked last
+  std::vector<RankedValue> heap;
+  heap.reserve(std::min(k, count));
+  size_t idx = 0;
+  for (; (idx < count) && (heap.size() < k); ++idx) {
+    if (values[idx] == values[idx]) {
+      heap.emplace_back(values[idx], idx);
+      std::push_heap(heap.begin(), heap.end(), RanksBefore);
+    }
+  }
+
+  while (idx < count) {
+    const size_t block_end = std::min(idx + kTopKBlockSize, count);
+    const float threshold = heap.front().first;
+    float block_max = threshold;
+    for (size_t i = idx; i < block_end; ++i) {
+      block_max = (values[i] > block_max) ? values[i] : block_max;
+    }
+
+    // A value equal to the threshold has a larger index than the
+    // selected one so only larger values replace it
+    if (block_max > threshold) {
+      for (size_t i = idx; i < block_end; ++i) {
+        if (values[i] > heap.front().first) {
+          std::pop_heap(heap.begin(), heap.end(), RanksBefore);
+          heap.back() = RankedValue(values[i], i);
+          std::push_heap(heap.begin(), heap.end(), RanksBefore);
+        }
+      }
+    }
+    idx = block_end;
+  }
+
+  std::sort_heap(heap.begin(), heap.end(), RanksBefore);
+  for (size_t i = 0; i < heap.size(); ++i) {
+    top_values[i] = heap[i].first;
+    indices[i] = heap[i].second;
+  }
+
+  // Only NaN values are left out of a selection smaller than 'k'
+  size_t selected = heap.size();
+  for (idx = 0; (idx < count) && (selected < k); ++idx) {
+    if (values[idx] != values[idx]) {
+      top_values[selected] = values[idx];
+      indices[selected] = idx;
+      selected++;
+    }
+  }
+  return selected;
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,186 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "traffic_capture.h"
+
+#include <chrono>
+#include "infer_request.h"
+#include "model_config_utils.h"
+#include "traffic_log.h"
+#include "triton/common/logging.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+// The writer thread is woken up once this many bytes are buffered, and
+// at least every kFlushInterval otherwise.
+constexpr size_t kFlushByteSize = 1 << 20;
+constexpr std::chrono::milliseconds kFlushInterval(500);
+
+uint64_t
+SteadyNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+Status
+TrafficCapture::Create(
+    const std::string& path, const uint64_t max_byte_size,
+    std::unique_ptr<TrafficCapture>* capture)
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to open traffic capture file '" + path + "'");
+  }
+  capture->reset(new TrafficCapture(path, max_byte_size, std::move(out)));
+  LOG_INFO << "Capturing the request traffic to '" << path << "'";
+  return Status::Success;
+}
+
+TrafficCapture::TrafficCapture(
+    const std::string& path, const uint64_t max_byte_size,
+    std::ofstream&& out)
+    : path_(path), max_byte_size_(max_byte_size), start_ns_(SteadyNowNs()),
+      out_(std::move(out)), full_(false), byte_size_(0), exiting_(false)
+{
+  const uint64_t start_time_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  AppendTrafficLogHeader(start_time_ns, &buffer_);
+  byte_size_ = buffer_.size();
+  writer_ = std::thread([this]() { WriterThread(); });
+}
+
+TrafficCapture::~TrafficCapture()
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    exiting_ = true;
+  }
+  cv_.notify_one();
+  writer_.join();
+}
+
+void
+TrafficCapture::Record(const InferenceRequest& request)
+{
+  if (full_) {
+    return;
+  }
+
+  // The record is reused by the requests of the thread to avoid
+  // allocating on the request path
+  thread_local TrafficRecord record;
+  record.arrival_ns_ = SteadyNowNs() - start_ns_;
+  record.model_name_ = request.ModelName();
+  record.model_version_ = request.RequestedModelVersion();
+  record.priority_ = request.Priority();
+  record.timeout_us_ = request.TimeoutMicroseconds();
+  record.flags_ = request.Flags();
+  const auto& correlation_id = request.CorrelationId();
+  if (correlation_id.Type() == InferenceRequest::SequenceId::DataType::STRING) {
+    record.correlation_id_ = 0;
+    record.correlation_id_string_ = correlation_id.StringValue();
+  } else {
+    record.correlation_id_ = correlation_id.UnsignedIntValue();
+    record.correlation_id_string_.clear();
+  }
+  const auto& inputs = request.OriginalInputs();
+  record.inputs_.resize(inputs.size());
+  size_t idx = 0;
+  for (const auto& pr : inputs) {
+    const InferenceRequest::Input& input = pr.second;
+    TrafficRecord::Input& recorded = record.inputs_[idx++];
+    recorded.name_ = input.Name();
+    recorded.datatype_ = DataTypeToTriton(input.DType());
+    recorded.shape_ = input.OriginalShape();
+    recorded.byte_size_ = input.Data()->TotalByteSize();
+  }
+
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (full_) {
+      return;
+    }
+    const size_t buffered = buffer_.size();
+    AppendTrafficRecord(record, &buffer_);
+    const size_t record_size = buffer_.size() - buffered;
+    if ((max_byte_size_ != 0) &&
+        ((byte_size_ + record_size) > max_byte_size_)) {
+      buffer_.resize(buffered);
+      full_ = true;
+      LOG_INFO << "Traffic capture to '" << path_ << "' reached "
+               << max_byte_size_ << " bytes, the later requests are not "
+               << "captured";
+    } else {
+      byte_size_ += record_size;
+    }
+    notify = (buffer_.size() >= kFlushByteSize);
+  }
+  if (notify) {
+    cv_.notify_one();
+  }
+}
+
+void
+TrafficCapture::WriterThread()
+{
+  std::string records;
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    cv_.wait_for(lock, kFlushInterval, [this] {
+      return exiting_ || (buffer_.size() >= kFlushByteSize);
+    });
+    records.swap(buffer_);
+    const bool exiting = exiting_;
+    lock.unlock();
+
+    if (!records.empty() && out_) {
+      out_.write(records.data(), records.size());
+      out_.flush();
+      if (!out_) {
+        LOG_ERROR << "failed to write traffic capture file '" << path_
+                  << "', the capture is stopped";
+        full_ = true;
+      }
+    }
+    records.clear();
+    if (exiting) {
+      break;
+    }
+    lock.lock();
+  }
+}
+
+}}  // namespace triton::core
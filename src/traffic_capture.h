@@ -0,0 +1,89 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "status.h"
+
+namespace triton { namespace core {
+
+class InferenceRequest;
+
+//
+// Records the arrival of the inference requests in a binary log, see
+// traffic_log.h, so that the traffic can be replayed against different
+// scheduling configurations. The records are appended to an in-memory
+// buffer that a writer thread flushes to the file, the payload of the
+// requests is not recorded.
+//
+class TrafficCapture {
+ public:
+  // Create a capture writing to the file at 'path', which is truncated.
+  // The capture stops once the log reaches 'max_byte_size' bytes, 0 for
+  // no limit.
+  static Status Create(
+      const std::string& path, const uint64_t max_byte_size,
+      std::unique_ptr<TrafficCapture>* capture);
+
+  // Flush the buffered records to the file.
+  ~TrafficCapture();
+
+  // Record the arrival of 'request'.
+  void Record(const InferenceRequest& request);
+
+ private:
+  TrafficCapture(
+      const std::string& path, const uint64_t max_byte_size,
+      std::ofstream&& out);
+
+  void WriterThread();
+
+  const std::string path_;
+  const uint64_t max_byte_size_;
+  const uint64_t start_ns_;
+  std::ofstream out_;
+
+  // Set once the log reaches 'max_byte_size_', the later requests are
+  // not recorded.
+  std::atomic<bool> full_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // The records not written to the file yet
+  std::string buffer_;
+  // The byte size of the log including the buffered records
+  uint64_t byte_size_;
+  bool exiting_;
+  std::thread writer_;
+};
+
+}}  // namespace triton::core
@@ -0,0 +1,199 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "traffic_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace triton { namespace core {
+
+namespace {
+
+constexpr size_t kMagicSize = sizeof(kTrafficLogMagic) - 1;
+
+template <typename T>
+void
+Put(const T value, std::string* log)
+{
+  log->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Strings are prefixed by their 16-bit size and truncated to it.
+void
+PutString(const std::string& value, std::string* log)
+{
+  const uint16_t size = static_cast<uint16_t>(
+      std::min<size_t>(value.size(), std::numeric_limits<uint16_t>::max()));
+  Put(size, log);
+  log->append(value.data(), size);
+}
+
+// Reads the fields of a record, every read fails once one is out of
+// bounds.
+class Reader {
+ public:
+  Reader(const char* data, const size_t size)
+      : data_(data), size_(size), offset_(0), ok_(true)
+  {
+  }
+
+  template <typename T>
+  bool Get(T* value)
+  {
+    if (!ok_ || ((size_ - offset_) < sizeof(T))) {
+      ok_ = false;
+      return false;
+    }
+    memcpy(value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool GetString(std::string* value)
+  {
+    uint16_t size;
+    if (!Get(&size) || ((size_ - offset_) < size)) {
+      ok_ = false;
+      return false;
+    }
+    value->assign(data_ + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  bool Ok() const { return ok_; }
+
+ private:
+  const char* data_;
+  const size_t size_;
+  size_t offset_;
+  bool ok_;
+};
+
+}  // namespace
+
+void
+AppendTrafficLogHeader(const uint64_t start_time_ns, std::string* log)
+{
+  log->append(kTrafficLogMagic, kMagicSize);
+  Put(kTrafficLogVersion, log);
+  Put(start_time_ns, log);
+}
+
+void
+AppendTrafficRecord(const TrafficRecord& record, std::string* log)
+{
+  // The size prefix is filled once the record is appended
+  const size_t begin = log->size();
+  Put(uint32_t(0), log);
+  Put(record.arrival_ns_, log);
+  PutString(record.model_name_, log);
+  Put(record.model_version_, log);
+  Put(record.priority_, log);
+  Put(record.timeout_us_, log);
+  Put(record.flags_, log);
+  Put(record.correlation_id_, log);
+  PutString(record.correlation_id_string_, log);
+  Put(static_cast<uint16_t>(record.inputs_.size()), log);
+  for (const auto& input : record.inputs_) {
+    PutString(input.name_, log);
+    Put(input.datatype_, log);
+    Put(static_cast<uint16_t>(input.shape_.size()), log);
+    for (const auto dim : input.shape_) {
+      Put(dim, log);
+    }
+    Put(input.byte_size_, log);
+  }
+  const uint32_t size = static_cast<uint32_t>(log->size() - begin);
+  memcpy(&(*log)[begin], &size, sizeof(size));
+}
+
+bool
+ParseTrafficLogHeader(
+    const char* data, const size_t size, uint64_t* start_time_ns,
+    size_t* consumed)
+{
+  if ((size < kMagicSize) || (memcmp(data, kTrafficLogMagic, kMagicSize) != 0)) {
+    return false;
+  }
+  Reader reader(data + kMagicSize, size - kMagicSize);
+  uint32_t version;
+  if (!reader.Get(&version) || (version == 0) ||
+      (version > kTrafficLogVersion) || !reader.Get(start_time_ns)) {
+    return false;
+  }
+  *consumed = kMagicSize + sizeof(version) + sizeof(*start_time_ns);
+  return true;
+}
+
+bool
+ParseTrafficRecord(
+    const char* data, const size_t size, TrafficRecord* record,
+    size_t* consumed)
+{
+  Reader reader(data, size);
+  uint32_t record_size;
+  if (!reader.Get(&record_size) || (record_size < sizeof(record_size)) ||
+      (record_size > size)) {
+    return false;
+  }
+
+  // The fields after the ones of this version are skipped
+  Reader fields(
+      data + sizeof(record_size), record_size - sizeof(record_size));
+  uint16_t input_count = 0;
+  fields.Get(&record->arrival_ns_);
+  fields.GetString(&record->model_name_);
+  fields.Get(&record->model_version_);
+  fields.Get(&record->priority_);
+  fields.Get(&record->timeout_us_);
+  fields.Get(&record->flags_);
+  fields.Get(&record->correlation_id_);
+  fields.GetString(&record->correlation_id_string_);
+  fields.Get(&input_count);
+  record->inputs_.clear();
+  for (uint16_t idx = 0; fields.Ok() && (idx < input_count); ++idx) {
+    record->inputs_.emplace_back();
+    auto& input = record->inputs_.back();
+    uint16_t dims_count = 0;
+    fields.GetString(&input.name_);
+    fields.Get(&input.datatype_);
+    fields.Get(&dims_count);
+    input.shape_.resize(fields.Ok() ? dims_count : 0);
+    for (auto& dim : input.shape_) {
+      fields.Get(&dim);
+    }
+    fields.Get(&input.byte_size_);
+  }
+  if (!fields.Ok()) {
+    return false;
+  }
+  *consumed = record_size;
+  return true;
+}
+
+}}  // namespace triton::core
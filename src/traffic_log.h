@@ -0,0 +1,91 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// The binary log of the request arrivals written by TrafficCapture and
+// read back by the traffic replay tool. The log starts with a header
+// holding the magic, the version of the log and the wall clock time the
+// capture started, followed by one record per request. Each record is
+// prefixed by its byte size so that a reader can skip the fields added
+// by later versions. Integers are stored in host byte order.
+//
+struct TrafficRecord {
+  struct Input {
+    std::string name_;
+    // The TRITONSERVER_DataType of the input
+    uint32_t datatype_;
+    std::vector<int64_t> shape_;
+    uint64_t byte_size_;
+  };
+
+  // The arrival time of the request relative to the capture start
+  uint64_t arrival_ns_;
+  std::string model_name_;
+  int64_t model_version_;
+  uint32_t priority_;
+  uint64_t timeout_us_;
+  // The TRITONSERVER_RequestFlag of the request
+  uint32_t flags_;
+  // The correlation ID of the sequence of the request, which is either
+  // 'correlation_id_string_' if not empty or 'correlation_id_'. Both are
+  // empty if the request doesn't belong to a sequence.
+  uint64_t correlation_id_;
+  std::string correlation_id_string_;
+  std::vector<Input> inputs_;
+};
+
+constexpr char kTrafficLogMagic[] = "TRTTRAFF";
+constexpr uint32_t kTrafficLogVersion = 1;
+
+// Append the header of a log whose capture started at 'start_time_ns'
+// since the epoch to 'log'.
+void AppendTrafficLogHeader(const uint64_t start_time_ns, std::string* log);
+
+// Append 'record' to 'log'.
+void AppendTrafficRecord(const TrafficRecord& record, std::string* log);
+
+// Parse the header at the start of the 'size' bytes at 'data', return
+// its byte size in 'consumed'. Return false if the header is invalid.
+bool ParseTrafficLogHeader(
+    const char* data, const size_t size, uint64_t* start_time_ns,
+    size_t* consumed);
+
+// Parse the record at the start of the 'size' bytes at 'data', return
+// its byte size in 'consumed'. Return false if the record is truncated
+// or invalid.
+bool ParseTrafficRecord(
+    const char* data, const size_t size, TrafficRecord* record,
+    size_t* consumed);
+
+}}  // namespace triton::core
@@ -24,6 +24,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <set>
 #include <string>
 #include <vector>
 #include "buffer_attributes.h"
@@ -37,10 +38,13 @@
 #include "model.h"
 #include "model_config_utils.h"
 #include "model_repository_manager.h"
+#include "pooled_response_allocator.h"
 #include "rate_limiter.h"
 #include "response_allocator.h"
 #include "server.h"
 #include "server_message.h"
+#include "shared_memory_registry.h"
+#include "shared_memory_response_allocator.h"
 #include "status.h"
 #include "triton/common/logging.h"
 #include "triton/common/model_config.h"
@@ -88,6 +92,10 @@ RateLimitModeToString(const tc::RateLimitMode rate_limit_mode)
       rl_mode_str = "OFF";
       break;
     }
+    case tc::RateLimitMode::RL_DEADLINE: {
+      rl_mode_str = "DEADLINE";
+      break;
+    }
   }
   return rl_mode_str;
 }
@@ -165,9 +173,17 @@ TritonServerError::Create(const tc::Status& status)
 class TritonServerMetrics {
  public:
   TritonServerMetrics() = default;
+  TritonServerMetrics(
+      std::set<std::string>&& family_names, std::set<std::string>&& model_names)
+      : family_names_(std::move(family_names)),
+        model_names_(std::move(model_names))
+  {
+  }
   TRITONSERVER_Error* Serialize(const char** base, size_t* byte_size);
 
  private:
+  std::set<std::string> family_names_;
+  std::set<std::string> model_names_;
   std::string serialized_;
 };
 
@@ -175,7 +191,7 @@ TRITONSERVER_Error*
 TritonServerMetrics::Serialize(const char** base, size_t* byte_size)
 {
 #ifdef TRITON_ENABLE_METRICS
-  serialized_ = tc::Metrics::SerializedMetrics();
+  serialized_ = tc::Metrics::SerializedMetrics(family_names_, model_names_);
   *base = serialized_.c_str();
   *byte_size = serialized_.size();
   return nullptr;  // Success
@@ -232,10 +248,71 @@ class TritonServerOptions {
 
   uint64_t PinnedMemoryPoolByteSize() const { return pinned_memory_pool_size_; }
   void SetPinnedMemoryPoolByteSize(uint64_t s) { pinned_memory_pool_size_ = s; }
+  uint64_t PinnedMemoryPoolMaxByteSize() const
+  {
+    return pinned_memory_pool_max_size_;
+  }
+  void SetPinnedMemoryPoolMaxByteSize(uint64_t s)
+  {
+    pinned_memory_pool_max_size_ = s;
+  }
+
+  uint64_t HostHugePageThreshold() const { return host_huge_page_threshold_; }
+  void SetHostHugePageThreshold(uint64_t s) { host_huge_page_threshold_ = s; }
 
   uint64_t ResponseCacheByteSize() const { return response_cache_byte_size_; }
   void SetResponseCacheByteSize(uint64_t s) { response_cache_byte_size_ = s; }
 
+  uint32_t ResponseCacheShardCount() const
+  {
+    return response_cache_shard_count_;
+  }
+  void SetResponseCacheShardCount(uint32_t c)
+  {
+    response_cache_shard_count_ = c;
+  }
+
+  bool ResponseCacheCollisionSafe() const
+  {
+    return response_cache_collision_safe_;
+  }
+  void SetResponseCacheCollisionSafe(bool e)
+  {
+    response_cache_collision_safe_ = e;
+  }
+
+  tc::CacheEvictionPolicy::Kind ResponseCacheEvictionPolicy() const
+  {
+    return response_cache_eviction_policy_;
+  }
+  void SetResponseCacheEvictionPolicy(tc::CacheEvictionPolicy::Kind p)
+  {
+    response_cache_eviction_policy_ = p;
+  }
+
+  TRITONSERVER_MemoryType ResponseCacheMemoryType() const
+  {
+    return response_cache_memory_type_;
+  }
+  int64_t ResponseCacheMemoryTypeId() const
+  {
+    return response_cache_memory_type_id_;
+  }
+  void SetResponseCacheMemoryType(TRITONSERVER_MemoryType t, int64_t id)
+  {
+    response_cache_memory_type_ = t;
+    response_cache_memory_type_id_ = id;
+  }
+
+  const std::string& ResponseCacheSnapshotPath() const
+  {
+    return response_cache_snapshot_path_;
+  }
+  void SetResponseCacheSnapshotPath(const std::string& p)
+  {
+    response_cache_snapshot_path_ = p;
+  }
+
   const std::map<int, uint64_t>& CudaMemoryPoolByteSize() const
   {
     return cuda_memory_pool_size_;
@@ -244,6 +321,14 @@ class TritonServerOptions {
   {
     cuda_memory_pool_size_[id] = s;
   }
+  bool CudaMemoryPoolStreamOrdered() const
+  {
+    return cuda_memory_pool_stream_ordered_;
+  }
+  void SetCudaMemoryPoolStreamOrdered(bool s)
+  {
+    cuda_memory_pool_stream_ordered_ = s;
+  }
 
   double MinSupportedComputeCapability() const
   {
@@ -260,6 +345,35 @@ class TritonServerOptions {
   unsigned int ExitTimeout() const { return exit_timeout_; }
   void SetExitTimeout(unsigned int t) { exit_timeout_ = t; }
 
+  bool ModelLoadOnDemand() const { return model_load_on_demand_; }
+  void SetModelLoadOnDemand(bool b) { model_load_on_demand_ = b; }
+
+  unsigned int ModelIdleUnloadTimeout() const
+  {
+    return model_idle_unload_timeout_;
+  }
+  void SetModelIdleUnloadTimeout(unsigned int t)
+  {
+    model_idle_unload_timeout_ = t;
+  }
+
+  uint64_t ModelGpuMemoryBudget() const { return model_gpu_memory_budget_; }
+  void SetModelGpuMemoryBudget(uint64_t s) { model_gpu_memory_budget_ = s; }
+
+  const std::string& TrafficCapturePath() const
+  {
+    return traffic_capture_path_;
+  }
+  uint64_t TrafficCaptureMaxByteSize() const
+  {
+    return traffic_capture_max_byte_size_;
+  }
+  void SetTrafficCapture(const std::string& p, uint64_t s)
+  {
+    traffic_capture_path_ = p;
+    traffic_capture_max_byte_size_ = s;
+  }
+
   unsigned int BufferManagerThreadCount() const
   {
     return buffer_manager_thread_count_;
@@ -281,9 +395,27 @@ class TritonServerOptions {
   uint64_t MetricsInterval() const { return metrics_interval_; }
   void SetMetricsInterval(uint64_t m) { metrics_interval_ = m; }
 
+  bool MetricsLatencyHistograms() const { return metrics_latency_histograms_; }
+  const std::vector<double>& MetricsLatencyBuckets() const
+  {
+    return metrics_latency_buckets_;
+  }
+  void SetMetricsLatencyHistograms(
+      bool b, const std::vector<double>& buckets_us)
+  {
+    metrics_latency_histograms_ = b;
+    metrics_latency_buckets_ = buckets_us;
+  }
+
   const std::string& BackendDir() const { return backend_dir_; }
   void SetBackendDir(const std::string& bd) { backend_dir_ = bd; }
 
+  const std::set<std::string>& PreloadBackends() const
+  {
+    return preload_backends_;
+  }
+  void SetPreloadBackend(const char* b) { preload_backends_.insert(b); }
+
   const std::string& RepoAgentDir() const { return repoagent_dir_; }
   void SetRepoAgentDir(const std::string& rad) { repoagent_dir_ = rad; }
 
@@ -321,14 +453,31 @@ class TritonServerOptions {
   bool metrics_;
   bool gpu_metrics_;
   uint64_t metrics_interval_;
+  bool metrics_latency_histograms_;
+  std::vector<double> metrics_latency_buckets_;
   unsigned int exit_timeout_;
+  bool model_load_on_demand_;
+  unsigned int model_idle_unload_timeout_;
+  uint64_t model_gpu_memory_budget_;
+  std::string traffic_capture_path_;
+  uint64_t traffic_capture_max_byte_size_;
   uint64_t pinned_memory_pool_size_;
+  uint64_t pinned_memory_pool_max_size_;
+  uint64_t host_huge_page_threshold_;
   uint64_t response_cache_byte_size_;
+  uint32_t response_cache_shard_count_;
+  bool response_cache_collision_safe_;
+  tc::CacheEvictionPolicy::Kind response_cache_eviction_policy_;
+  TRITONSERVER_MemoryType response_cache_memory_type_;
+  int64_t response_cache_memory_type_id_;
+  std::string response_cache_snapshot_path_;
   unsigned int buffer_manager_thread_count_;
   unsigned int model_load_thread_count_;
   std::map<int, uint64_t> cuda_memory_pool_size_;
+  bool cuda_memory_pool_stream_ordered_;
   double min_compute_capability_;
   std::string backend_dir_;
+  std::set<std::string> preload_backends_;
   std::string repoagent_dir_;
   triton::common::BackendCmdlineConfigMap backend_cmdline_config_map_;
   triton::common::HostPolicyCmdlineConfigMap host_policy_map_;
@@ -339,11 +488,21 @@ TritonServerOptions::TritonServerOptions()
       model_control_mode_(tc::ModelControlMode::MODE_POLL),
       exit_on_error_(true), strict_model_config_(true), strict_readiness_(true),
       rate_limit_mode_(tc::RateLimitMode::RL_OFF), metrics_(true),
-      gpu_metrics_(true), metrics_interval_(2000), exit_timeout_(30),
-      pinned_memory_pool_size_(1 << 28), response_cache_byte_size_(0),
+      gpu_metrics_(true), metrics_interval_(2000),
+      metrics_latency_histograms_(false), exit_timeout_(30),
+      model_load_on_demand_(false), model_idle_unload_timeout_(0),
+      model_gpu_memory_budget_(0), traffic_capture_max_byte_size_(0),
+      pinned_memory_pool_size_(1 << 28),
+      pinned_memory_pool_max_size_(0), host_huge_page_threshold_(0),
+      response_cache_byte_size_(0),
+      response_cache_shard_count_(1), response_cache_collision_safe_(false),
+      response_cache_eviction_policy_(tc::CacheEvictionPolicy::Kind::LRU),
+      response_cache_memory_type_(TRITONSERVER_MEMORY_CPU),
+      response_cache_memory_type_id_(0),
       buffer_manager_thread_count_(0),
       model_load_thread_count_(
           std::max(2u, 2 * std::thread::hardware_concurrency())),
+      cuda_memory_pool_stream_ordered_(false),
 #ifdef TRITON_ENABLE_GPU
       min_compute_capability_(TRITON_MIN_COMPUTE_CAPABILITY),
 #else
@@ -722,6 +881,33 @@ TRITONSERVER_ResponseAllocatorNew(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorNewPooled(
+    TRITONSERVER_ResponseAllocator** allocator)
+{
+  *allocator = reinterpret_cast<TRITONSERVER_ResponseAllocator*>(
+      tc::PooledResponseAllocator::Create());
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorNewSharedMemory(
+    TRITONSERVER_ResponseAllocator** allocator)
+{
+  *allocator = reinterpret_cast<TRITONSERVER_ResponseAllocator*>(
+      tc::SharedMemoryResponseAllocator::Create());
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSharedMemoryLocation(
+    void* buffer_userp, const char** region_name, size_t* offset)
+{
+  RETURN_IF_STATUS_ERROR(tc::SharedMemoryResponseAllocator::Location(
+      buffer_userp, region_name, offset));
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_ResponseAllocatorSetQueryFunction(
     TRITONSERVER_ResponseAllocator* allocator,
@@ -742,6 +928,25 @@ TRITONSERVER_ResponseAllocatorSetBufferAttributesFunction(
   return nullptr;  // success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSetBatchAllocFunction(
+    TRITONSERVER_ResponseAllocator* allocator,
+    TRITONSERVER_ResponseAllocatorBatchAllocFn_t batch_alloc_fn)
+{
+  reinterpret_cast<tc::ResponseAllocator*>(allocator)->SetBatchAllocFunction(
+      batch_alloc_fn);
+  return nullptr;  // success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ResponseAllocatorSetBorrowedBuffersAccepted(
+    TRITONSERVER_ResponseAllocator* allocator, bool accepted)
+{
+  reinterpret_cast<tc::ResponseAllocator*>(allocator)
+      ->SetBorrowedBuffersAccepted(accepted);
+  return nullptr;  // success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ResponseAllocatorDelete(TRITONSERVER_ResponseAllocator* allocator)
 {
@@ -751,6 +956,35 @@ TRITONSERVER_ResponseAllocatorDelete(TRITONSERVER_ResponseAllocator* allocator)
   return nullptr;  // Success
 }
 
+//
+// TRITONSERVER_SharedMemory
+//
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_SharedMemoryRegisterSystem(
+    const char* name, const char* shm_key, size_t offset, size_t byte_size)
+{
+  RETURN_IF_STATUS_ERROR(tc::SharedMemoryRegistry::RegisterSystemRegion(
+      name, shm_key, offset, byte_size));
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_SharedMemoryRegisterCuda(
+    const char* name, const void* cuda_ipc_handle, size_t byte_size,
+    int64_t device_id)
+{
+  RETURN_IF_STATUS_ERROR(tc::SharedMemoryRegistry::RegisterCudaRegion(
+      name, cuda_ipc_handle, byte_size, device_id));
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_SharedMemoryUnregister(const char* name)
+{
+  RETURN_IF_STATUS_ERROR(tc::SharedMemoryRegistry::Unregister(name));
+  return nullptr;  // Success
+}
+
 //
 // TRITONSERVER_Message
 //
@@ -864,6 +1098,14 @@ TRITONSERVER_InferenceTraceActivityString(
       return "TENSOR_BACKEND_INPUT";
     case TRITONSERVER_TRACE_TENSOR_BACKEND_OUTPUT:
       return "TENSOR_BACKEND_OUTPUT";
+    case TRITONSERVER_TRACE_BATCH_FORMED:
+      return "BATCH_FORMED";
+    case TRITONSERVER_TRACE_RATE_LIMITER_ENQUEUE:
+      return "RATE_LIMITER_ENQUEUE";
+    case TRITONSERVER_TRACE_INSTANCE_ALLOCATED:
+      return "INSTANCE_ALLOCATED";
+    case TRITONSERVER_TRACE_BACKEND_DEQUEUE:
+      return "BACKEND_DEQUEUE";
   }
 
   return "<unknown>";
@@ -927,6 +1169,35 @@ TRITONSERVER_InferenceTraceTensorNew(
 #endif  // TRITON_ENABLE_TRACING
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceTraceBufferedNew(
+    TRITONSERVER_InferenceTrace** trace, TRITONSERVER_InferenceTraceLevel level,
+    uint64_t parent_id, TRITONSERVER_InferenceTraceActivityFn_t activity_fn,
+    TRITONSERVER_InferenceTraceReleaseFn_t release_fn, void* trace_userp)
+{
+#ifdef TRITON_ENABLE_TRACING
+  if ((level & TRITONSERVER_TRACE_LEVEL_MIN) > 0) {
+    level = static_cast<TRITONSERVER_InferenceTraceLevel>(
+        (level ^ TRITONSERVER_TRACE_LEVEL_MIN) |
+        TRITONSERVER_TRACE_LEVEL_TIMESTAMPS);
+  }
+  if ((level & TRITONSERVER_TRACE_LEVEL_MAX) > 0) {
+    level = static_cast<TRITONSERVER_InferenceTraceLevel>(
+        (level ^ TRITONSERVER_TRACE_LEVEL_MAX) |
+        TRITONSERVER_TRACE_LEVEL_TIMESTAMPS);
+  }
+  tc::InferenceTrace* ltrace = new tc::InferenceTrace(
+      level, parent_id, activity_fn, nullptr, release_fn, trace_userp,
+      true /* buffered */);
+  *trace = reinterpret_cast<TRITONSERVER_InferenceTrace*>(ltrace);
+  return nullptr;  // Success
+#else
+  *trace = nullptr;
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "inference tracing not supported");
+#endif  // TRITON_ENABLE_TRACING
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_InferenceTraceDelete(TRITONSERVER_InferenceTrace* trace)
 {
@@ -995,6 +1266,20 @@ TRITONSERVER_InferenceTraceModelVersion(
 #endif  // TRITON_ENABLE_TRACING
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceTraceBatchSize(
+    TRITONSERVER_InferenceTrace* trace, uint64_t* batch_size)
+{
+#ifdef TRITON_ENABLE_TRACING
+  tc::InferenceTrace* ltrace = reinterpret_cast<tc::InferenceTrace*>(trace);
+  *batch_size = ltrace->BatchSize();
+  return nullptr;  // Success
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "inference tracing not supported");
+#endif  // TRITON_ENABLE_TRACING
+}
+
 //
 // TRITONSERVER_ServerOptions
 //
@@ -1114,6 +1399,10 @@ TRITONSERVER_ServerOptionsSetRateLimiterMode(
       loptions->SetRateLimiterMode(tc::RateLimitMode::RL_OFF);
       break;
     }
+    case TRITONSERVER_RATE_LIMIT_DEADLINE: {
+      loptions->SetRateLimiterMode(tc::RateLimitMode::RL_DEADLINE);
+      break;
+    }
     default: {
       return TRITONSERVER_ErrorNew(
           TRITONSERVER_ERROR_INVALID_ARG,
@@ -1145,6 +1434,26 @@ TRITONSERVER_ServerOptionsSetPinnedMemoryPoolByteSize(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetPinnedMemoryPoolMaxByteSize(
+    TRITONSERVER_ServerOptions* options, uint64_t size)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetPinnedMemoryPoolMaxByteSize(size);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetHostHugePageThreshold(
+    TRITONSERVER_ServerOptions* options, uint64_t size)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetHostHugePageThreshold(size);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetCudaMemoryPoolByteSize(
     TRITONSERVER_ServerOptions* options, int gpu_device, uint64_t size)
@@ -1155,6 +1464,16 @@ TRITONSERVER_ServerOptionsSetCudaMemoryPoolByteSize(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetCudaMemoryPoolStreamOrdered(
+    TRITONSERVER_ServerOptions* options, bool stream_ordered)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetCudaMemoryPoolStreamOrdered(stream_ordered);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetResponseCacheByteSize(
     TRITONSERVER_ServerOptions* options, uint64_t size)
@@ -1165,6 +1484,102 @@ TRITONSERVER_ServerOptionsSetResponseCacheByteSize(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheShardCount(
+    TRITONSERVER_ServerOptions* options, uint32_t shard_count)
+{
+  if (shard_count == 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "response cache shard count must be greater than 0");
+  }
+
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetResponseCacheShardCount(shard_count);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheCollisionSafe(
+    TRITONSERVER_ServerOptions* options, bool enable)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetResponseCacheCollisionSafe(enable);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheEvictionPolicy(
+    TRITONSERVER_ServerOptions* options,
+    TRITONSERVER_ResponseCacheEvictionPolicy policy)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+
+  // convert policy from TRITONSERVER_ to triton::core
+  switch (policy) {
+    case TRITONSERVER_RESPONSE_CACHE_EVICTION_LRU: {
+      loptions->SetResponseCacheEvictionPolicy(
+          tc::CacheEvictionPolicy::Kind::LRU);
+      break;
+    }
+    case TRITONSERVER_RESPONSE_CACHE_EVICTION_TINY_LFU: {
+      loptions->SetResponseCacheEvictionPolicy(
+          tc::CacheEvictionPolicy::Kind::TINY_LFU);
+      break;
+    }
+    case TRITONSERVER_RESPONSE_CACHE_EVICTION_SIZE_AWARE: {
+      loptions->SetResponseCacheEvictionPolicy(
+          tc::CacheEvictionPolicy::Kind::SIZE_AWARE);
+      break;
+    }
+    default: {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          std::string(
+              "unknown response cache eviction policy '" +
+              std::to_string(policy) + "'")
+              .c_str());
+    }
+  }
+
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheMemoryType(
+    TRITONSERVER_ServerOptions* options, TRITONSERVER_MemoryType memory_type,
+    int64_t memory_type_id)
+{
+  if ((memory_type != TRITONSERVER_MEMORY_CPU) &&
+      (memory_type != TRITONSERVER_MEMORY_GPU)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        (std::string("response cache can't be stored in ") +
+         TRITONSERVER_MemoryTypeString(memory_type) + " memory")
+            .c_str());
+  }
+
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetResponseCacheMemoryType(
+      memory_type,
+      (memory_type == TRITONSERVER_MEMORY_GPU) ? memory_type_id : 0);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetResponseCacheSnapshotPath(
+    TRITONSERVER_ServerOptions* options, const char* path)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetResponseCacheSnapshotPath(path);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetMinSupportedComputeCapability(
     TRITONSERVER_ServerOptions* options, double cc)
@@ -1195,6 +1610,51 @@ TRITONSERVER_ServerOptionsSetExitTimeout(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelLoadOnDemand(
+    TRITONSERVER_ServerOptions* options, bool enable)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetModelLoadOnDemand(enable);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelIdleUnloadTimeout(
+    TRITONSERVER_ServerOptions* options, unsigned int timeout)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetModelIdleUnloadTimeout(timeout);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetModelGpuMemoryBudget(
+    TRITONSERVER_ServerOptions* options, uint64_t byte_size)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetModelGpuMemoryBudget(byte_size);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetTrafficCapture(
+    TRITONSERVER_ServerOptions* options, const char* path,
+    uint64_t max_byte_size)
+{
+  if (path == nullptr) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG, "traffic capture path must be set");
+  }
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetTrafficCapture(path, max_byte_size);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetBufferManagerThreadCount(
     TRITONSERVER_ServerOptions* options, unsigned int thread_count)
@@ -1340,6 +1800,37 @@ TRITONSERVER_ServerOptionsSetMetricsInterval(
 #endif  // TRITON_ENABLE_METRICS
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetMetricsLatencyHistograms(
+    TRITONSERVER_ServerOptions* options, bool enable,
+    const double* bucket_bounds_us, uint64_t bucket_count)
+{
+#ifdef TRITON_ENABLE_METRICS
+  if ((bucket_count > 0) && (bucket_bounds_us == nullptr)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "latency histogram bucket bounds must be provided when the bucket "
+        "count is not 0");
+  }
+  std::vector<double> buckets_us;
+  for (uint64_t idx = 0; idx < bucket_count; ++idx) {
+    if (bucket_bounds_us[idx] <= 0) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "latency histogram bucket bounds must be positive");
+    }
+    buckets_us.push_back(bucket_bounds_us[idx]);
+  }
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetMetricsLatencyHistograms(enable, buckets_us);
+  return nullptr;  // Success
+#else
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "metrics not supported");
+#endif  // TRITON_ENABLE_METRICS
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetBackendDirectory(
     TRITONSERVER_ServerOptions* options, const char* backend_dir)
@@ -1350,6 +1841,16 @@ TRITONSERVER_ServerOptionsSetBackendDirectory(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetBackendPreload(
+    TRITONSERVER_ServerOptions* options, const char* backend_name)
+{
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetPreloadBackend(backend_name);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetRepoAgentDirectory(
     TRITONSERVER_ServerOptions* options, const char* repoagent_dir)
@@ -1395,7 +1896,7 @@ TRITONSERVER_InferenceRequestNew(
   RETURN_IF_STATUS_ERROR(lserver->GetModel(model_name, model_version, &model));
 
   *inference_request = reinterpret_cast<TRITONSERVER_InferenceRequest*>(
-      new tc::InferenceRequest(model, model_version));
+      tc::InferenceRequest::Create(model, model_version));
 
   return nullptr;  // Success
 }
@@ -1406,7 +1907,17 @@ TRITONSERVER_InferenceRequestDelete(
 {
   tc::InferenceRequest* lrequest =
       reinterpret_cast<tc::InferenceRequest*>(inference_request);
-  delete lrequest;
+  tc::InferenceRequest::Delete(lrequest);
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestReset(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  tc::InferenceRequest* lrequest =
+      reinterpret_cast<tc::InferenceRequest*>(inference_request);
+  RETURN_IF_STATUS_ERROR(lrequest->Reset());
   return nullptr;  // Success
 }
 
@@ -1552,6 +2063,32 @@ TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  tc::InferenceRequest* lrequest =
+      reinterpret_cast<tc::InferenceRequest*>(inference_request);
+  lrequest->Cancel();
+  return nullptr;  // Success
+}
+
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetStringParameter(
+    TRITONSERVER_InferenceRequest* inference_request, const char* key,
+    const char* value)
+{
+  if ((key == nullptr) || (value == nullptr)) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "request parameter key and value must not be null");
+  }
+  tc::InferenceRequest* lrequest =
+      reinterpret_cast<tc::InferenceRequest*>(inference_request);
+  lrequest->SetStringParameter(key, value);
+  return nullptr;  // Success
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestAddInput(
     TRITONSERVER_InferenceRequest* inference_request, const char* name,
@@ -1721,6 +2258,21 @@ TRITONSERVER_InferenceRequestSetResponseCallback(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetResponseCoalescing(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_InferenceResponseBatchCompleteFn_t batch_response_fn,
+    void* batch_response_userp, const uint32_t max_response_count,
+    const uint64_t max_delay_us)
+{
+  tc::InferenceRequest* lrequest =
+      reinterpret_cast<tc::InferenceRequest*>(inference_request);
+  RETURN_IF_STATUS_ERROR(lrequest->SetResponseCoalescing(
+      batch_response_fn, batch_response_userp, max_response_count,
+      max_delay_us));
+  return nullptr;  // Success
+}
+
 //
 // TRITONSERVER_InferenceResponse
 //
@@ -1880,6 +2432,28 @@ TRITONSERVER_InferenceResponseOutputClassificationLabel(
   return nullptr;  // Success
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_InferenceResponseOutputClassification(
+    TRITONSERVER_InferenceResponse* inference_response, const uint32_t index,
+    const uint32_t class_count, uint32_t* batch_size, uint32_t* count,
+    const uint32_t** class_indices, const float** values,
+    const char* const** labels)
+{
+  tc::InferenceResponse* lresponse =
+      reinterpret_cast<tc::InferenceResponse*>(inference_response);
+
+  const tc::InferenceResponse::Classification* classification;
+  RETURN_IF_STATUS_ERROR(
+      lresponse->Classify(index, class_count, &classification));
+
+  *batch_size = classification->batch_size_;
+  *count = classification->count_;
+  *class_indices = classification->class_indices_.data();
+  *values = classification->values_.data();
+  *labels = classification->labels_.data();
+  return nullptr;  // Success
+}
+
 //
 // TRITONSERVER_BufferAttributes
 //
@@ -2013,6 +2587,9 @@ TRITONSERVER_ServerNew(
   if (loptions->Metrics()) {
     tc::Metrics::EnableMetrics();
     tc::Metrics::SetMetricsInterval(loptions->MetricsInterval());
+    if (loptions->MetricsLatencyHistograms()) {
+      tc::Metrics::EnableLatencyHistograms(loptions->MetricsLatencyBuckets());
+    }
   }
 #endif  // TRITON_ENABLE_METRICS
 
@@ -2025,12 +2602,32 @@ TRITONSERVER_ServerNew(
   lserver->SetRateLimiterMode(loptions->RateLimiterMode());
   lserver->SetRateLimiterResources(loptions->RateLimiterResources());
   lserver->SetPinnedMemoryPoolByteSize(loptions->PinnedMemoryPoolByteSize());
+  lserver->SetPinnedMemoryPoolMaxByteSize(
+      loptions->PinnedMemoryPoolMaxByteSize());
+  lserver->SetHostHugePageThreshold(loptions->HostHugePageThreshold());
   lserver->SetResponseCacheByteSize(loptions->ResponseCacheByteSize());
+  lserver->SetResponseCacheShardCount(loptions->ResponseCacheShardCount());
+  lserver->SetResponseCacheCollisionSafe(
+      loptions->ResponseCacheCollisionSafe());
+  lserver->SetResponseCacheEvictionPolicy(
+      loptions->ResponseCacheEvictionPolicy());
+  lserver->SetResponseCacheMemoryType(
+      loptions->ResponseCacheMemoryType(),
+      loptions->ResponseCacheMemoryTypeId());
+  lserver->SetResponseCacheSnapshotPath(
+      loptions->ResponseCacheSnapshotPath());
   lserver->SetCudaMemoryPoolByteSize(loptions->CudaMemoryPoolByteSize());
+  lserver->SetCudaMemoryPoolStreamOrdered(
+      loptions->CudaMemoryPoolStreamOrdered());
   double min_compute_capability = loptions->MinSupportedComputeCapability();
   lserver->SetMinSupportedComputeCapability(min_compute_capability);
   lserver->SetStrictReadinessEnabled(loptions->StrictReadiness());
   lserver->SetExitTimeoutSeconds(loptions->ExitTimeout());
+  lserver->SetModelLoadOnDemand(
+      loptions->ModelLoadOnDemand(), loptions->ModelIdleUnloadTimeout(),
+      loptions->ModelGpuMemoryBudget());
+  lserver->SetTrafficCapture(
+      loptions->TrafficCapturePath(), loptions->TrafficCaptureMaxByteSize());
   lserver->SetHostPolicyCmdlineConfig(loptions->HostPolicyCmdlineConfigMap());
   lserver->SetRepoAgentDir(loptions->RepoAgentDir());
   lserver->SetBufferManagerThreadCount(loptions->BufferManagerThreadCount());
@@ -2049,6 +2646,7 @@ TRITONSERVER_ServerNew(
   loptions->AddBackendConfig(
       std::string(), "backend-directory", loptions->BackendDir());
   lserver->SetBackendCmdlineConfig(loptions->BackendCmdlineConfigMap());
+  lserver->SetPreloadBackends(loptions->PreloadBackends());
 
   // Initialize server
   tc::Status status = lserver->Init();
@@ -2066,8 +2664,22 @@ TRITONSERVER_ServerNew(
   }
 #endif  // TRITON_ENABLE_METRICS_GPU
 
+  // The pinned memory metrics only exist with a pinned memory pool, without
+  // one every host allocation is non-pinned by configuration.
+#ifdef TRITON_ENABLE_GPU
+  const bool pinned_memory_metrics =
+      loptions->Metrics() && ((loptions->PinnedMemoryPoolByteSize() > 0) ||
+                              (loptions->PinnedMemoryPoolMaxByteSize() > 0));
+#else
+  const bool pinned_memory_metrics = false;
+#endif  // TRITON_ENABLE_GPU
+  if (pinned_memory_metrics) {
+    tc::Metrics::EnablePinnedMemoryMetrics();
+  }
+
   if (loptions->Metrics() &&
-      (lserver->ResponseCacheEnabled() || loptions->GpuMetrics())) {
+      (lserver->ResponseCacheEnabled() || loptions->GpuMetrics() ||
+       pinned_memory_metrics)) {
     // Start thread to poll enabled metrics periodically
     tc::Metrics::StartPollingThreadSingleton(lserver->GetResponseCache());
   }
@@ -2151,15 +2763,41 @@ TRITONSERVER_ServerNew(
   options_table.InsertRow(std::vector<std::string>{
       "pinned_memory_pool_byte_size",
       std::to_string(lserver->PinnedMemoryPoolByteSize())});
+  options_table.InsertRow(std::vector<std::string>{
+      "pinned_memory_pool_max_byte_size",
+      std::to_string(lserver->PinnedMemoryPoolMaxByteSize())});
+  options_table.InsertRow(std::vector<std::string>{
+      "host_huge_page_threshold",
+      std::to_string(lserver->HostHugePageThreshold())});
   for (const auto& cuda_memory_pool : lserver->CudaMemoryPoolByteSize()) {
     options_table.InsertRow(std::vector<std::string>{
         "cuda_memory_pool_byte_size{" + std::to_string(cuda_memory_pool.first) +
             "}",
         std::to_string(cuda_memory_pool.second)});
   }
+  options_table.InsertRow(std::vector<std::string>{
+      "cuda_memory_pool_stream_ordered",
+      std::to_string(lserver->CudaMemoryPoolStreamOrdered())});
   options_table.InsertRow(std::vector<std::string>{
       "response_cache_byte_size",
       std::to_string(lserver->ResponseCacheByteSize())});
+  options_table.InsertRow(std::vector<std::string>{
+      "response_cache_shard_count",
+      std::to_string(lserver->ResponseCacheShardCount())});
+  options_table.InsertRow(std::vector<std::string>{
+      "response_cache_collision_safe",
+      std::to_string(lserver->ResponseCacheCollisionSafe())});
+  options_table.InsertRow(std::vector<std::string>{
+      "response_cache_eviction_policy",
+      tc::CacheEvictionPolicyKindString(
+          lserver->ResponseCacheEvictionPolicy())});
+  options_table.InsertRow(std::vector<std::string>{
+      "response_cache_memory_type",
+      std::string(TRITONSERVER_MemoryTypeString(
+          lserver->ResponseCacheMemoryType())) +
+          ":" + std::to_string(lserver->ResponseCacheMemoryTypeId())});
+  options_table.InsertRow(std::vector<std::string>{
+      "response_cache_snapshot_path", lserver->ResponseCacheSnapshotPath()});
 
   std::stringstream compute_capability_ss;
   compute_capability_ss.setf(std::ios::fixed);
@@ -2171,6 +2809,24 @@ TRITONSERVER_ServerNew(
       "strict_readiness", std::to_string(lserver->StrictReadinessEnabled())});
   options_table.InsertRow(std::vector<std::string>{
       "exit_timeout", std::to_string(lserver->ExitTimeoutSeconds())});
+  if (!lserver->TrafficCapturePath().empty()) {
+    options_table.InsertRow(std::vector<std::string>{
+        "traffic_capture", lserver->TrafficCapturePath()});
+  }
+  i = 0;
+  for (const auto& preload_backend : lserver->PreloadBackends()) {
+    options_table.InsertRow(std::vector<std::string>{
+        "preload_backends_" + std::to_string(i), preload_backend});
+    ++i;
+  }
+  if (lserver->ModelLoadOnDemand()) {
+    options_table.InsertRow(std::vector<std::string>{
+        "model_idle_unload_timeout",
+        std::to_string(lserver->ModelIdleUnloadTimeoutSeconds())});
+    options_table.InsertRow(std::vector<std::string>{
+        "model_gpu_memory_budget",
+        std::to_string(lserver->ModelGpuMemoryBudget())});
+  }
 
   std::string options_table_string = options_table.PrintTable();
   LOG_INFO << options_table_string;
@@ -2546,9 +3202,10 @@ TRITONSERVER_ServerModelStatistics(
     for (const auto& version : mv_pair.second) {
       std::shared_ptr<tc::Model> model;
       RETURN_IF_STATUS_ERROR(lserver->GetModel(mv_pair.first, version, &model));
-      const auto& infer_stats = model->StatsAggregator().ImmutableInferStats();
-      const auto& infer_batch_stats =
-          model->StatsAggregator().ImmutableInferBatchStats();
+      const auto infer_stats = model->StatsAggregator().InferStatsSnapshot();
+      std::map<size_t, tc::InferenceStatsAggregator::InferBatchStats>
+          infer_batch_stats;
+      model->StatsAggregator().InferBatchStatsSnapshot(&infer_batch_stats);
 
       triton::common::TritonJson::Value inference_stats(
           metadata, triton::common::TritonJson::ValueType::OBJECT);
@@ -2603,6 +3260,67 @@ TRITONSERVER_ServerModelStatistics(
         RETURN_IF_STATUS_ERROR(batch_stats.Append(std::move(batch_stat)));
       }
 
+      // The memory allocated through the model memory manager
+      triton::common::TritonJson::Value memory_usage(
+          metadata, triton::common::TritonJson::ValueType::ARRAY);
+      const TRITONSERVER_MemoryType memory_types[] = {
+          TRITONSERVER_MEMORY_CPU, TRITONSERVER_MEMORY_CPU_PINNED,
+          TRITONSERVER_MEMORY_GPU};
+      for (const auto memory_type : memory_types) {
+        const auto usage_stats = model->MemoryUsage().GetStats(memory_type);
+        triton::common::TritonJson::Value usage_stat(
+            metadata, triton::common::TritonJson::ValueType::OBJECT);
+        RETURN_IF_STATUS_ERROR(usage_stat.AddStringRef(
+            "memory_type", TRITONSERVER_MemoryTypeString(memory_type)));
+        RETURN_IF_STATUS_ERROR(
+            usage_stat.AddUInt("byte_size", usage_stats.byte_size_));
+        RETURN_IF_STATUS_ERROR(
+            usage_stat.AddUInt("peak_byte_size", usage_stats.peak_byte_size_));
+        RETURN_IF_STATUS_ERROR(usage_stat.AddUInt(
+            "allocation_count", usage_stats.allocation_count_));
+        RETURN_IF_STATUS_ERROR(memory_usage.Append(std::move(usage_stat)));
+      }
+
+      // The sequences handled by the sequence batcher, all zero for a
+      // model not using the sequence batcher.
+      const auto seq_stats = model->SequenceStats().GetStats();
+      triton::common::TritonJson::Value sequence_stats(
+          metadata, triton::common::TritonJson::ValueType::OBJECT);
+      RETURN_IF_STATUS_ERROR(
+          sequence_stats.AddUInt("active_count", seq_stats.active_count_));
+      RETURN_IF_STATUS_ERROR(
+          sequence_stats.AddUInt("backlog_count", seq_stats.backlog_count_));
+      SetDurationStat(
+          metadata, sequence_stats, "slot_wait", seq_stats.slot_count_,
+          seq_stats.slot_wait_duration_ns_);
+      RETURN_IF_STATUS_ERROR(
+          sequence_stats.AddUInt("evicted_count", seq_stats.evicted_count_));
+      RETURN_IF_STATUS_ERROR(
+          sequence_stats.AddUInt("rejected_count", seq_stats.rejected_count_));
+      triton::common::TritonJson::Value slots_occupied(
+          metadata, triton::common::TritonJson::ValueType::ARRAY);
+      for (const auto occupied : seq_stats.slots_occupied_) {
+        RETURN_IF_STATUS_ERROR(slots_occupied.AppendUInt(occupied));
+      }
+      RETURN_IF_STATUS_ERROR(
+          sequence_stats.Add("slots_occupied", std::move(slots_occupied)));
+
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+      // The CPU time spent by the core in each stage of the request path
+      tc::InferenceStatsAggregator::CpuStageStats
+          infer_cpu_stage_stats[tc::kCpuStageCount];
+      model->StatsAggregator().CpuStageStatsSnapshot(infer_cpu_stage_stats);
+      triton::common::TritonJson::Value cpu_stage_stats(
+          metadata, triton::common::TritonJson::ValueType::OBJECT);
+      for (size_t idx = 0; idx < tc::kCpuStageCount; ++idx) {
+        SetDurationStat(
+            metadata, cpu_stage_stats,
+            tc::CpuStageString(static_cast<tc::CpuStage>(idx)),
+            infer_cpu_stage_stats[idx].count_,
+            infer_cpu_stage_stats[idx].cpu_ns_);
+      }
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
+
       triton::common::TritonJson::Value model_stat(
           metadata, triton::common::TritonJson::ValueType::OBJECT);
       RETURN_IF_STATUS_ERROR(
@@ -2621,6 +3339,14 @@ TRITONSERVER_ServerModelStatistics(
           model_stat.Add("inference_stats", std::move(inference_stats)));
       RETURN_IF_STATUS_ERROR(
           model_stat.Add("batch_stats", std::move(batch_stats)));
+      RETURN_IF_STATUS_ERROR(
+          model_stat.Add("memory_usage", std::move(memory_usage)));
+      RETURN_IF_STATUS_ERROR(
+          model_stat.Add("sequence_stats", std::move(sequence_stats)));
+#ifdef TRITON_ENABLE_CPU_STAGE_STATS
+      RETURN_IF_STATUS_ERROR(
+          model_stat.Add("cpu_stage_stats", std::move(cpu_stage_stats)));
+#endif  // TRITON_ENABLE_CPU_STAGE_STATS
       RETURN_IF_STATUS_ERROR(model_stats_json.Append(std::move(model_stat)));
     }
   }
@@ -2779,6 +3505,32 @@ TRITONSERVER_ServerMetrics(
 #endif  // TRITON_ENABLE_METRICS
 }
 
+TRITONAPI_DECLSPEC TRITONSERVER_Error*
+TRITONSERVER_ServerMetricsFiltered(
+    TRITONSERVER_Server* server, const char* const* family_names,
+    const uint32_t family_count, const char* const* model_names,
+    const uint32_t model_count, TRITONSERVER_Metrics** metrics)
+{
+#ifdef TRITON_ENABLE_METRICS
+  std::set<std::string> families;
+  for (uint32_t idx = 0; idx < family_count; ++idx) {
+    families.emplace(family_names[idx]);
+  }
+  std::set<std::string> models;
+  for (uint32_t idx = 0; idx < model_count; ++idx) {
+    models.emplace(model_names[idx]);
+  }
+  TritonServerMetrics* lmetrics =
+      new TritonServerMetrics(std::move(families), std::move(models));
+  *metrics = reinterpret_cast<TRITONSERVER_Metrics*>(lmetrics);
+  return nullptr;  // Success
+#else
+  *metrics = nullptr;
+  return TRITONSERVER_ErrorNew(
+      TRITONSERVER_ERROR_UNSUPPORTED, "metrics not supported");
+#endif  // TRITON_ENABLE_METRICS
+}
+
 TRITONAPI_DECLSPEC TRITONSERVER_Error*
 TRITONSERVER_ServerInferAsync(
     TRITONSERVER_Server* server,
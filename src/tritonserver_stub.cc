@@ -106,6 +106,18 @@ TRITONSERVER_ResponseAllocatorNew()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ResponseAllocatorNewPooled()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ResponseAllocatorNewSharedMemory()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ResponseAllocatorSharedMemoryLocation()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ResponseAllocatorSetQueryFunction()
 {
 }
@@ -114,10 +126,30 @@ TRITONSERVER_ResponseAllocatorSetBufferAttributesFunction()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ResponseAllocatorSetBorrowedBuffersAccepted()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ResponseAllocatorSetBatchAllocFunction()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ResponseAllocatorDelete()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_SharedMemoryRegisterSystem()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_SharedMemoryRegisterCuda()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_SharedMemoryUnregister()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_MessageNewFromSerializedJson()
 {
 }
@@ -154,6 +186,10 @@ TRITONSERVER_InferenceTraceTensorNew()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceTraceBufferedNew()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_InferenceTraceDelete()
 {
 }
@@ -174,6 +210,10 @@ TRITONSERVER_InferenceTraceModelVersion()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceTraceBatchSize()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_InferenceRequestNew()
 {
 }
@@ -182,6 +222,10 @@ TRITONSERVER_InferenceRequestDelete()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceRequestReset()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_InferenceRequestId()
 {
 }
@@ -230,6 +274,14 @@ TRITONSERVER_InferenceRequestSetTimeoutMicroseconds()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceRequestCancel()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceRequestSetStringParameter()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_InferenceRequestAddInput()
 {
 }
@@ -278,6 +330,10 @@ TRITONSERVER_InferenceRequestSetResponseCallback()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceRequestSetResponseCoalescing()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_InferenceResponseDelete()
 {
 }
@@ -314,6 +370,10 @@ TRITONSERVER_InferenceResponseOutputClassificationLabel()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_InferenceResponseOutputClassification()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsNew()
 {
 }
@@ -338,6 +398,10 @@ TRITONSERVER_ServerOptionsSetStartupModel()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetBackendPreload()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetStrictModelConfig()
 {
 }
@@ -354,14 +418,46 @@ TRITONSERVER_ServerOptionsSetPinnedMemoryPoolByteSize()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetPinnedMemoryPoolMaxByteSize()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetHostHugePageThreshold()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetCudaMemoryPoolByteSize()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetCudaMemoryPoolStreamOrdered()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetResponseCacheByteSize()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetResponseCacheShardCount()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetResponseCacheCollisionSafe()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetResponseCacheEvictionPolicy()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetResponseCacheMemoryType()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetResponseCacheSnapshotPath()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetMinSupportedComputeCapability()
 {
 }
@@ -378,6 +474,22 @@ TRITONSERVER_ServerOptionsSetExitTimeout()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetModelLoadOnDemand()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetModelIdleUnloadTimeout()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetModelGpuMemoryBudget()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetTrafficCapture()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetBufferManagerThreadCount()
 {
 }
@@ -418,6 +530,10 @@ TRITONSERVER_ServerOptionsSetMetricsInterval()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerOptionsSetMetricsLatencyHistograms()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerOptionsSetBackendDirectory()
 {
 }
@@ -562,6 +678,10 @@ TRITONSERVER_ServerMetrics()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONSERVER_ServerMetricsFiltered()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONSERVER_ServerInferAsync()
 {
 }
@@ -578,6 +698,14 @@ TRITONBACKEND_MemoryManagerFree()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_MemoryManagerAllocateAsync()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_MemoryManagerFreeAsync()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_InputProperties()
 {
 }
@@ -598,10 +726,22 @@ TRITONBACKEND_InputBufferAttributes()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_InputStringOffsets()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_OutputBuffer()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_OutputBuffers()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_OutputSetStringOffsets()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_OutputBufferAttributes()
 {
 }
@@ -622,6 +762,10 @@ TRITONBACKEND_RequestFlags()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_RequestIsCancelled()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_RequestInputCount()
 {
 }
@@ -638,6 +782,18 @@ TRITONBACKEND_RequestInputByIndex()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_RequestCollatedInput()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_RequestCollatedInputOffsets()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_RequestCollatedInputDatatype()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_RequestOutputCount()
 {
 }
@@ -738,6 +894,10 @@ TRITONBACKEND_BackendMemoryManager()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelMemoryManager()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_BackendState()
 {
 }
@@ -758,6 +918,22 @@ TRITONBACKEND_ModelRepository()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelMapFile()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelUnmapFile()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelSharedBufferAcquire()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelSharedBufferInitialized()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_ModelConfig()
 {
 }
@@ -822,6 +998,18 @@ TRITONBACKEND_ModelInstanceSecondaryDeviceProperties()
 {
 }
 TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelInstancePriorityCudaStream()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelInstanceReportCudaGraph()
+{
+}
+TRITONAPI_DECLSPEC void
+TRITONBACKEND_ModelInstanceHasCudaGraph()
+{
+}
+TRITONAPI_DECLSPEC void
 TRITONBACKEND_ModelInstanceModel()
 {
 }
@@ -865,6 +1053,11 @@ TRITONREPOAGENT_ModelRepositoryUpdate()
 {
 }
 
+TRITONAPI_DECLSPEC void
+TRITONREPOAGENT_ModelSetResultCacheable()
+{
+}
+
 TRITONAPI_DECLSPEC void
 TRITONREPOAGENT_ModelParameterCount()
 {
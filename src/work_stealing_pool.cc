@@ -0,0 +1,137 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "work_stealing_pool.h"
+
+namespace triton { namespace core {
+
+namespace {
+
+// The pool and the index of the worker running on the current thread.
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local size_t current_worker_idx = 0;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const size_t thread_count)
+    : next_worker_(0), pending_count_(0), exit_(false)
+{
+  const size_t count = (thread_count == 0) ? 1 : thread_count;
+  for (size_t idx = 0; idx < count; ++idx) {
+    workers_.emplace_back(new Worker());
+  }
+  for (size_t idx = 0; idx < count; ++idx) {
+    threads_.emplace_back([this, idx]() { WorkerThread(idx); });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    exit_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void
+WorkStealingThreadPool::Enqueue(std::function<void()>&& task)
+{
+  const size_t worker_idx =
+      (current_pool == this)
+          ? current_worker_idx
+          : (next_worker_.fetch_add(1, std::memory_order_relaxed) %
+             workers_.size());
+  {
+    Worker* worker = workers_[worker_idx].get();
+    std::lock_guard<std::mutex> lk(worker->mu_);
+    worker->tasks_.emplace_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    pending_count_++;
+  }
+  cv_.notify_one();
+}
+
+void
+WorkStealingThreadPool::WorkerThread(const size_t worker_idx)
+{
+  current_pool = this;
+  current_worker_idx = worker_idx;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [this]() { return exit_ || (pending_count_ > 0); });
+      if (pending_count_ == 0) {
+        break;
+      }
+      pending_count_--;
+    }
+
+    std::function<void()> task;
+    PopTask(worker_idx, &task);
+    task();
+  }
+
+  current_pool = nullptr;
+}
+
+void
+WorkStealingThreadPool::PopTask(
+    const size_t worker_idx, std::function<void()>* task)
+{
+  // A task is pushed before it is counted as pending and each worker
+  // claims one pending task before popping, so there is always a task
+  // for the worker although another worker may take it first while
+  // scanning the queues.
+  while (true) {
+    for (size_t offset = 0; offset < workers_.size(); ++offset) {
+      Worker* worker = workers_[(worker_idx + offset) % workers_.size()].get();
+      std::lock_guard<std::mutex> lk(worker->mu_);
+      if (worker->tasks_.empty()) {
+        continue;
+      }
+      if (offset == 0) {
+        *task = std::move(worker->tasks_.front());
+        worker->tasks_.pop_front();
+      } else {
+        *task = std::move(worker->tasks_.back());
+        worker->tasks_.pop_back();
+      }
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+}}  // namespace triton::core
@@ -0,0 +1,82 @@
+// Copyright 2022, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace triton { namespace core {
+
+//
+// Fixed size thread pool where each worker owns a task queue. A task
+// enqueued from a worker is placed in the queue of that worker, other
+// tasks are distributed round-robin. An idle worker takes the oldest task
+// of its own queue first and steals the newest task of another worker
+// otherwise, so tasks are executed roughly in the order they are enqueued
+// while a long running task doesn't hold up the tasks queued behind it.
+//
+class WorkStealingThreadPool {
+ public:
+  // Create a pool of 'thread_count' workers, at least one.
+  explicit WorkStealingThreadPool(const size_t thread_count);
+
+  // Execute the remaining tasks and join the workers.
+  ~WorkStealingThreadPool();
+
+  // Enqueue 'task' to be executed by one of the workers.
+  void Enqueue(std::function<void()>&& task);
+
+  // Return the number of workers.
+  size_t Size() const { return threads_.size(); }
+
+ private:
+  struct Worker {
+    std::mutex mu_;
+    std::deque<std::function<void()>> tasks_;
+  };
+
+  void WorkerThread(const size_t worker_idx);
+  void PopTask(const size_t worker_idx, std::function<void()>* task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_worker_;
+
+  // The number of enqueued tasks not yet claimed by a worker.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t pending_count_;
+  bool exit_;
+};
+
+}}  // namespace triton::core